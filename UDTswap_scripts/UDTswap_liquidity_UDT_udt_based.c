@@ -3,6 +3,9 @@
 #include "ckb_syscalls.h"
 #include "udtswap_common.h"
 
+#define UDTSWAP_PROFILE_NAME "liquidity"
+#include "udtswap_profile.h"
+
 /*
  * @dev check UDTswap liquidity udt owner mode
  *
@@ -67,7 +70,7 @@ int check_owner_mode_transfer(uint128_t input_amount, uint128_t output_amount) {
   if (ret!=CKB_SUCCESS) {
     return UDTSWAP_SYSCALL_ERROR - UDTSWAP_LIQUIDITY_UDT_ERROR_IDX - ret;
   }
-  if(len!=UDTSWAP_DATA_SIZE) {
+  if(len!=UDTSWAP_DATA_SIZE && len!=UDTSWAP_EXTENDED_DATA_SIZE) {
     return UDTSWAP_DATA_SIZE_NOT_CORRECT_ERROR - UDTSWAP_LIQUIDITY_UDT_ERROR_IDX;
   }
 
@@ -78,7 +81,7 @@ int check_owner_mode_transfer(uint128_t input_amount, uint128_t output_amount) {
   if (ret!=CKB_SUCCESS) {
     return UDTSWAP_SYSCALL_ERROR - UDTSWAP_LIQUIDITY_UDT_ERROR_IDX - ret;
   }
-  if(len!=UDTSWAP_DATA_SIZE) {
+  if(len!=UDTSWAP_DATA_SIZE && len!=UDTSWAP_EXTENDED_DATA_SIZE) {
     return UDTSWAP_DATA_SIZE_NOT_CORRECT_ERROR - UDTSWAP_LIQUIDITY_UDT_ERROR_IDX;
   }
 
@@ -101,7 +104,8 @@ int check_owner_mode_transfer(uint128_t input_amount, uint128_t output_amount) {
  * check UDTswap liquidity udt output amount
  */
 
-int main() {
+int main(int argc, char* argv[]) {
+  PROFILE_PHASE("script");
   unsigned char script[SCRIPT_SIZE];
   uint64_t len = SCRIPT_SIZE;
   int ret = ckb_load_script(script, &len, 0);
@@ -140,6 +144,7 @@ int main() {
   }
   // owner mode checked (udtswap lock hash)
 
+  PROFILE_PHASE("input");
   uint128_t input_amount = 0;
   size_t i = 0;
   while (1) {
@@ -166,6 +171,7 @@ int main() {
   }
   //sum input amount
 
+  PROFILE_PHASE("output");
   uint128_t output_amount = 0;
   i = 0;
   while (1) {
@@ -192,6 +198,7 @@ int main() {
   }
   //sum output amount
 
+  PROFILE_PHASE("transfer");
   if (owner_mode) {
     return check_owner_mode_transfer(input_amount, output_amount);
   }
@@ -2,6 +2,9 @@
 #include "ckb_syscalls.h"
 #include "udtswap_common.h"
 
+#define UDTSWAP_PROFILE_NAME "lock"
+#include "udtswap_profile.h"
+
 /*
  * @dev check UDTswap type script
  * check UDTswap type script code hash
@@ -59,6 +62,7 @@ int check_udtswap_type(size_t index, uint8_t current_script_hash_buf[]) {
  */
 
 int main(int argc, char* argv[]) {
+  PROFILE_PHASE("group");
   uint64_t len = 0;
   uint8_t script_buf[SCRIPT_HASH_SIZE];
   size_t group_cnt = 1;
@@ -68,6 +72,7 @@ int main(int argc, char* argv[]) {
     if(ret == CKB_SUCCESS) {
       i = 6;
       while(1) {
+        len = 0;
         ret = ckb_load_cell_by_field(NULL, &len, 0, i, CKB_SOURCE_GROUP_INPUT, CKB_CELL_FIELD_LOCK_HASH);
         if (ret == INDEX_OUT_OF_BOUND_ERROR) {
           break;
@@ -90,6 +95,7 @@ int main(int argc, char* argv[]) {
   }
   //only 3n (same pair, different pools) input with current lock checked
 
+  PROFILE_PHASE("type");
   i = 0;
   while(1) {
     ret = check_udtswap_type(i, script_buf);
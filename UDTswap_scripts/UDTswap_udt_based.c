@@ -3,27 +3,25 @@
 #include "protocol.h"
 #include "bn.h"
 #include "udtswap_common.h"
+#include "udtswap_bn.h"
+#include "udtswap_formula.h"
 
-void uint128_t_to_bignum(uint128_t temp, struct bn *ret) {
-  struct bn temp1, temp2;
+#define UDTSWAP_PROFILE_NAME "type"
+#include "udtswap_profile.h"
 
-  bignum_init(&temp1);
-  bignum_init(&temp2);
+void bytes_to_bignum(uint8_t buf[], size_t size, struct bn *ret) {
+  size_t i;
   bignum_init(ret);
-  bignum_from_uint64_t(&temp1, temp & 0xffffffffffffffff);
-  bignum_from_uint64_t(&temp2, (temp >> 64) & 0xffffffffffffffff);
-  _lshift_word(&temp2, 2);
-
-  bignum_add(&temp1, &temp2, ret);
+  for (i = 0; i < size; i++) {
+    ret->array[i / 4] |= (DTYPE)buf[i] << (8 * (i % 4));
+  }
 }
 
-uint128_t bignum_to_uint128_t(struct bn *temp) {
-  uint128_t ret = 0;
-  ret += temp->array[0];
-  ret += (uint128_t)temp->array[1] << 32;
-  ret += (uint128_t)temp->array[2] << 64;
-  ret += (uint128_t)temp->array[3] << 96;
-  return ret;
+void bignum_to_bytes(struct bn *temp, uint8_t buf[], size_t size) {
+  size_t i;
+  for (i = 0; i < size; i++) {
+    buf[i] = (temp->array[i / 4] >> (8 * (i % 4))) & 0xff;
+  }
 }
 
 /*
@@ -49,47 +47,25 @@ int add_liquidity(
   struct bn
     temp2,
     temp3,
-    udt1_reserve,
-    udt2_reserve,
-    udt1_amount,
     udt2_amount,
-    user_liquidity,
-    total_liquidity,
-    one
+    user_liquidity
   ;
 
-  bignum_init(&temp2);
-  bignum_init(&temp3);
-  bignum_init(&udt1_reserve);
-  bignum_init(&udt2_reserve);
-  bignum_init(&udt1_amount);
   bignum_init(&udt2_amount);
   bignum_init(&user_liquidity);
-  bignum_init(&total_liquidity);
-  bignum_init(&one);
 
-  uint128_t_to_bignum(u_r1, &udt1_reserve);
-  uint128_t_to_bignum(u_r2, &udt2_reserve);
-  uint128_t_to_bignum(u_r_a1 - u_r1, &udt1_amount);
   uint128_t_to_bignum(u_r_a2 - u_r2, &udt2_amount);
   uint128_t_to_bignum(t_l_a - t_l, &user_liquidity);
-  uint128_t_to_bignum(t_l, &total_liquidity);
-
-  bignum_from_uint64_t(&one, 0x0000000000000001);
 
-  bignum_mul(&udt2_reserve, &udt1_amount, &temp2);
-  if (bignum_is_zero(&udt1_reserve) == 1) {
-    return DIVIDE_ZERO_ERROR;
+  int ret = udtswap_add_liquidity_amounts(u_r1, u_r2, t_l, u_r_a1 - u_r1, &temp2, &temp3);
+  if (ret != CKB_SUCCESS) {
+    return ret;
   }
-  bignum_div(&temp2, &udt1_reserve, &temp3);
-  bignum_add(&temp3, &one, &temp2);
   if (bignum_cmp(&temp2, &udt2_amount) != EQUAL) {
     return ADD_LIQUIDITY_NOT_CORRECT_ERROR;
   }
   //udt amount to add liquidity
 
-  bignum_mul(&total_liquidity, &udt1_amount, &temp2);
-  bignum_div(&temp2, &udt1_reserve, &temp3); //already checked above
   if (bignum_cmp(&temp3, &user_liquidity) != EQUAL) {
     return LIQUIDITY_NOT_CORRECT_ERROR;
   }
@@ -120,129 +96,349 @@ int remove_liquidity(
   struct bn
     temp2,
     temp3,
-    udt1_reserve,
-    udt2_reserve,
     udt1_amount,
-    udt2_amount,
-    user_liquidity,
-    total_liquidity
+    udt2_amount
   ;
 
-  bignum_init(&temp2);
-  bignum_init(&temp3);
-  bignum_init(&udt1_reserve);
-  bignum_init(&udt2_reserve);
   bignum_init(&udt1_amount);
   bignum_init(&udt2_amount);
-  bignum_init(&user_liquidity);
-  bignum_init(&total_liquidity);
 
-  uint128_t_to_bignum(u_r1, &udt1_reserve);
-  uint128_t_to_bignum(u_r2, &udt2_reserve);
   uint128_t_to_bignum(u_r1 - u_r_a1, &udt1_amount);
   uint128_t_to_bignum(u_r2 - u_r_a2, &udt2_amount);
-  uint128_t_to_bignum(t_l - t_l_a, &user_liquidity);
-  uint128_t_to_bignum(t_l, &total_liquidity);
 
-  bignum_mul(&user_liquidity, &udt2_reserve, &temp2);
-  if (bignum_is_zero(&total_liquidity) == 1) {
-    return DIVIDE_ZERO_ERROR;
+  int ret = udtswap_remove_liquidity_amounts(u_r1, u_r2, t_l, t_l - t_l_a, &temp2, &temp3);
+  if (ret != CKB_SUCCESS) {
+    return ret;
   }
-  bignum_div(&temp2, &total_liquidity, &temp3);
   if (bignum_cmp(&temp3, &udt2_amount) != EQUAL) {
     return REMOVE_LIQUIDITY_NOT_CORRECT_ERROR;
   }
   //udt amount to receive
 
-  bignum_mul(&user_liquidity, &udt1_reserve, &temp2);
-  bignum_div(&temp2, &total_liquidity, &temp3); //already checked above
-  if (bignum_cmp(&temp3, &udt1_amount) != EQUAL) {
+  if (bignum_cmp(&temp2, &udt1_amount) != EQUAL) {
     return REMOVE_LIQUIDITY_NOT_CORRECT_ERROR;
   }
   //ckb amount to receive
   return CKB_SUCCESS;
 }
+/*
+ * @dev check input amount calculated by output amount
+ * input amount = input reserve * output amount * 1000 / (output reserve - output amount) * 997 + 1
+ *
+ * @param i_r input udt reserve before swapping
+ * @param o_r output udt reserve before swapping
+ * @param i_r_a input udt reserve after swapping
+ * @param o_r_a output udt reserve after swapping
+ */
+int swap_input_by_output(
+  uint128_t i_r,
+  uint128_t o_r,
+  uint128_t i_r_a,
+  uint128_t o_r_a
+) {
+  struct bn
+    temp2,
+    input_amount
+  ;
+
+  bignum_init(&input_amount);
+  uint128_t_to_bignum(i_r_a - i_r, &input_amount);
+
+  int ret = udtswap_swap_input_amount(i_r, o_r, o_r - o_r_a, &temp2);
+  if (ret != CKB_SUCCESS) {
+    return ret;
+  }
+  if (bignum_cmp(&temp2, &input_amount) != EQUAL) {
+    return SWAP_NOT_CORRECT_ERROR;
+  }
+  return CKB_SUCCESS;
+}
+
+/*
+ * @dev check output amount calculated by input amount
+ * output amount = input amount * 997 * output reserve / (input reserve * 1000 + input amount * 997)
+ *
+ * @param i_r input udt reserve before swapping
+ * @param o_r output udt reserve before swapping
+ * @param i_r_a input udt reserve after swapping
+ * @param o_r_a output udt reserve after swapping
+ */
+int swap_output_by_input(
+  uint128_t i_r,
+  uint128_t o_r,
+  uint128_t i_r_a,
+  uint128_t o_r_a
+) {
+  struct bn
+    temp2,
+    output_amount
+  ;
+
+  bignum_init(&output_amount);
+  uint128_t_to_bignum(o_r - o_r_a, &output_amount);
+
+  int ret = udtswap_swap_output_amount(i_r, o_r, i_r_a - i_r, &temp2);
+  if (ret != CKB_SUCCESS) {
+    return ret;
+  }
+  if (bignum_cmp(&temp2, &output_amount) != EQUAL) {
+    return SWAP_NOT_CORRECT_ERROR;
+  }
+  return CKB_SUCCESS;
+}
+
 /*
  * @dev check swapping
- * check input amount calculated by output amount
- * check output amount calculated by input amount
- * if more than one of above are correct, success
+ * exact input mode, check output amount calculated by input amount
+ * exact output mode, check input amount calculated by output amount
+ * if hinted formula is not correct or no hint, check the other formula too
+ * if one of formulas is correct, success
  *
  * @param i_r input udt reserve before swapping
  * @param o_r output udt reserve before swapping
  * @param i_r_a input udt reserve after swapping
  * @param o_r_a output udt reserve after swapping
+ * @param mode swap mode hint from UDTswap cell witness
  */
 int swap(
   uint128_t i_r,
   uint128_t o_r,
   uint128_t i_r_a,
-  uint128_t o_r_a
+  uint128_t o_r_a,
+  int mode
+) {
+  int ret;
+  if (mode == SWAP_MODE_EXACT_INPUT) {
+    ret = swap_output_by_input(i_r, o_r, i_r_a, o_r_a);
+    if (ret != SWAP_NOT_CORRECT_ERROR) {
+      return ret;
+    }
+    return swap_input_by_output(i_r, o_r, i_r_a, o_r_a);
+  }
+  //output amount by input amount, input amount by output amount as fallback
+
+  ret = swap_input_by_output(i_r, o_r, i_r_a, o_r_a);
+  if (ret != SWAP_NOT_CORRECT_ERROR) {
+    return ret;
+  }
+  return swap_output_by_input(i_r, o_r, i_r_a, o_r_a);
+  //input amount by output amount, output amount by input amount as fallback
+}
+
+/*
+ * @dev load swap mode hint
+ * first byte of UDTswap cell input's witness input_type
+ * no witness, no input_type, unknown mode, return auto mode
+ *
+ * @param index UDTswap cell index
+ */
+int load_swap_mode(size_t index) {
+  uint8_t witness_buf[SWAP_MODE_WITNESS_SIZE];
+  uint64_t len = SWAP_MODE_WITNESS_SIZE;
+  int ret = ckb_load_witness(witness_buf, &len, 0, index, CKB_SOURCE_INPUT);
+  if (ret != CKB_SUCCESS || len > SWAP_MODE_WITNESS_SIZE) {
+    return SWAP_MODE_AUTO;
+  }
+
+  mol_seg_t witness_seg;
+  witness_seg.ptr = witness_buf;
+  witness_seg.size = len;
+  if (MolReader_WitnessArgs_verify(&witness_seg, false) != MOL_OK) {
+    return SWAP_MODE_AUTO;
+  }
+
+  mol_seg_t input_type_seg = MolReader_WitnessArgs_get_input_type(&witness_seg);
+  if (MolReader_BytesOpt_is_none(&input_type_seg)) {
+    return SWAP_MODE_AUTO;
+  }
+  mol_seg_t input_type_bytes_seg = MolReader_Bytes_raw_bytes(&input_type_seg);
+  if (input_type_bytes_seg.size != 1) {
+    return SWAP_MODE_AUTO;
+  }
+
+  if (
+    input_type_bytes_seg.ptr[0] == SWAP_MODE_EXACT_INPUT ||
+    input_type_bytes_seg.ptr[0] == SWAP_MODE_EXACT_OUTPUT
+  ) {
+    return input_type_bytes_seg.ptr[0];
+  }
+  return SWAP_MODE_AUTO;
+}
+
+/*
+ * @dev add time weighted price to price cumulative
+ * price cumulative = price cumulative + (o_r << 64) / i_r * elapsed, mod 2^256
+ *
+ * @param i_r udt reserve of price base
+ * @param o_r udt reserve of price quote
+ * @param elapsed blocks since last update
+ * @param price_cumulative_buf price cumulative before, updated in place
+ */
+void update_price_cumulative(
+  uint128_t i_r,
+  uint128_t o_r,
+  uint64_t elapsed,
+  uint8_t price_cumulative_buf[]
 ) {
-  int flag = 0;
   struct bn
     temp2,
     temp3,
-    temp4,
-    temp5,
-    input_amount,
-    output_amount,
     input_reserve,
     output_reserve,
-    thousand,
-    except_fee,
-    one
+    blocks,
+    price_cumulative
   ;
 
   bignum_init(&temp2);
   bignum_init(&temp3);
-  bignum_init(&temp4);
-  bignum_init(&temp5);
-  bignum_init(&input_amount);
   bignum_init(&input_reserve);
-  bignum_init(&output_amount);
   bignum_init(&output_reserve);
-  bignum_init(&thousand);
-  bignum_init(&except_fee);
-  bignum_init(&one);
+  bignum_init(&blocks);
+  bignum_init(&price_cumulative);
 
-  uint128_t_to_bignum(i_r_a - i_r, &input_amount);
   uint128_t_to_bignum(i_r, &input_reserve);
-  uint128_t_to_bignum(o_r - o_r_a, &output_amount);
   uint128_t_to_bignum(o_r, &output_reserve);
+  bignum_from_uint64_t(&blocks, elapsed);
+  bytes_to_bignum(price_cumulative_buf, PRICE_CUMULATIVE_SIZE, &price_cumulative);
+
+  _lshift_word(&output_reserve, PRICE_RESOLUTION_WORDS);
+  bignum_div(&output_reserve, &input_reserve, &temp2);
+  bignum_mul(&temp2, &blocks, &temp3);
+  bignum_add(&price_cumulative, &temp3, &temp2);
+  bignum_to_bytes(&temp2, price_cumulative_buf, PRICE_CUMULATIVE_SIZE);
+}
+
+/*
+ * @dev load block number of header
+ * header dep, or header of block of input cell which should be in header deps
+ *
+ * @param index header dep or cell index
+ * @param source CKB_SOURCE_HEADER_DEP or CKB_SOURCE_INPUT
+ * @param block_number block number of header
+ */
+int load_header_block_number(size_t index, size_t source, uint64_t *block_number) {
+  uint8_t header_buf[HEADER_SIZE];
+  uint64_t len = HEADER_SIZE;
+  int ret = ckb_load_header(header_buf, &len, 0, index, source);
+  if (ret != CKB_SUCCESS) {
+    return UDTSWAP_SYSCALL_ERROR - ret;
+  }
+  mol_seg_t header_seg;
+  header_seg.ptr = header_buf;
+  header_seg.size = len;
+  if (MolReader_Header_verify(&header_seg, false) != MOL_OK) {
+    return ERROR_ENCODING;
+  }
 
-  bignum_from_uint64_t(&thousand, 0x00000000000003e8);
-  bignum_from_uint64_t(&except_fee, LIQUIDITY_POOL_EXCEPT_FEE);
-  bignum_from_uint64_t(&one, 0x0000000000000001);
+  mol_seg_t raw_seg = MolReader_Header_get_raw(&header_seg);
+  mol_seg_t number_seg = MolReader_RawHeader_get_number(&raw_seg);
+  uint64_t number = 0;
+  int i;
+  for (i = 0; i < BLOCK_NUMBER_SIZE; i++) {
+    number += (uint64_t)number_seg.ptr[i] << (8 * i);
+  }
+  *block_number = number;
+  return CKB_SUCCESS;
+}
 
-  bignum_mul(&input_reserve, &thousand, &temp2);
-  bignum_mul(&temp2, &output_amount, &temp3);
-  if (bignum_cmp(&output_reserve, &output_amount) == SMALLER) {
-    return SUBTRACT_ERROR;
+/*
+ * @dev check price cumulative of extended UDTswap data
+ * legacy data output, input should be legacy data
+ * legacy data input, output price cumulative should be empty
+ * extended data input, output price cumulative updated with input reserves
+ * output last update should be header dep block number
+ * header dep should not be before block of UDTswap input cell
+ *
+ * @param index UDTswap cell index
+ * @param udt1_reserve first udt reserve before, except default reserve
+ * @param udt2_reserve second udt reserve before, except default reserve
+ */
+int check_price_cumulative(size_t index, uint128_t udt1_reserve, uint128_t udt2_reserve) {
+  uint8_t output_extension_buf[UDTSWAP_DATA_EXTENSION_SIZE];
+  uint64_t len = UDTSWAP_DATA_EXTENSION_SIZE;
+  int ret = ckb_load_cell_data(output_extension_buf, &len, UDTSWAP_DATA_SIZE, index, CKB_SOURCE_OUTPUT);
+  if (ret != CKB_SUCCESS) {
+    return UDTSWAP_SYSCALL_ERROR - ret;
   }
-  bignum_sub(&output_reserve, &output_amount, &temp4);
-  bignum_mul(&temp4, &except_fee, &temp5);
-  if (bignum_is_zero(&temp5) == 1) {
-    return DIVIDE_ZERO_ERROR;
+  uint64_t output_extension_len = len;
+
+  uint8_t input_extension_buf[UDTSWAP_DATA_EXTENSION_SIZE];
+  len = UDTSWAP_DATA_EXTENSION_SIZE;
+  ret = ckb_load_cell_data(input_extension_buf, &len, UDTSWAP_DATA_SIZE, index, CKB_SOURCE_INPUT);
+  if (ret != CKB_SUCCESS) {
+    return UDTSWAP_SYSCALL_ERROR - ret;
   }
-  bignum_div(&temp3, &temp5, &temp4);
-  bignum_add(&temp4, &one, &temp5);
-  if (bignum_cmp(&temp5, &input_amount) != EQUAL) {
-    flag = 1;
+
+  if (output_extension_len == 0) {
+    if (len != 0) {
+      return UDTSWAP_DATA_SIZE_NOT_CORRECT_ERROR;
+    }
+    return CKB_SUCCESS;
   }
-  //input amount by output amount
+  //legacy data checked
 
-  bignum_mul(&input_amount, &except_fee, &temp3);
-  bignum_mul(&temp3, &output_reserve, &temp4);
-  bignum_add(&temp2, &temp3, &temp5);
-  if (bignum_is_zero(&temp5) == 1) {
-    return DIVIDE_ZERO_ERROR;
+  if (output_extension_len != UDTSWAP_DATA_EXTENSION_SIZE) {
+    return UDTSWAP_DATA_SIZE_NOT_CORRECT_ERROR;
   }
-  bignum_div(&temp4, &temp5, &temp2);
-  if (bignum_cmp(&temp2, &output_amount) != EQUAL && flag==1) {
-    return SWAP_NOT_CORRECT_ERROR;
+
+  uint64_t block_number = 0;
+  ret = load_header_block_number(UDTSWAP_HEADER_DEP_INDEX, CKB_SOURCE_HEADER_DEP, &block_number);
+  if (ret != CKB_SUCCESS) {
+    return ret;
   }
-  //output amount by input amount
+
+  uint64_t input_block_number = 0;
+  ret = load_header_block_number(index, CKB_SOURCE_INPUT, &input_block_number);
+  if (ret != CKB_SUCCESS) {
+    return ret;
+  }
+  if (block_number < input_block_number) {
+    return LAST_UPDATE_NOT_CORRECT_ERROR;
+  }
+  //header dep checked with block of input
+
+  uint8_t *output_last_update_buf = &output_extension_buf[UDTSWAP_DATA_LAST_UPDATE_START - UDTSWAP_DATA_SIZE];
+  if (memcmp(output_last_update_buf, &block_number, BLOCK_NUMBER_SIZE) != 0) {
+    return LAST_UPDATE_NOT_CORRECT_ERROR;
+  }
+  //last update checked
+
+  if (len == 0) {
+    memset(input_extension_buf, 0, UDTSWAP_DATA_EXTENSION_SIZE);
+  } else if (len == UDTSWAP_DATA_EXTENSION_SIZE) {
+    uint64_t last_update = 0;
+    memcpy(&last_update, &input_extension_buf[UDTSWAP_DATA_LAST_UPDATE_START - UDTSWAP_DATA_SIZE], BLOCK_NUMBER_SIZE);
+    if (last_update > block_number) {
+      return LAST_UPDATE_NOT_CORRECT_ERROR;
+    }
+
+    if (udt1_reserve != 0 && udt2_reserve != 0) {
+      update_price_cumulative(
+        udt1_reserve,
+        udt2_reserve,
+        block_number - last_update,
+        &input_extension_buf[UDTSWAP_DATA_PRICE1_CUMULATIVE_START - UDTSWAP_DATA_SIZE]
+      );
+      update_price_cumulative(
+        udt2_reserve,
+        udt1_reserve,
+        block_number - last_update,
+        &input_extension_buf[UDTSWAP_DATA_PRICE2_CUMULATIVE_START - UDTSWAP_DATA_SIZE]
+      );
+    }
+  } else {
+    return UDTSWAP_DATA_SIZE_NOT_CORRECT_ERROR;
+  }
+
+  if (memcmp(
+    &input_extension_buf[UDTSWAP_DATA_PRICE1_CUMULATIVE_START - UDTSWAP_DATA_SIZE],
+    &output_extension_buf[UDTSWAP_DATA_PRICE1_CUMULATIVE_START - UDTSWAP_DATA_SIZE],
+    PRICE_CUMULATIVE_SIZE * 2
+  ) != 0) {
+    return PRICE_CUMULATIVE_NOT_CORRECT_ERROR;
+  }
+  //price cumulative checked
+
   return CKB_SUCCESS;
 }
 
@@ -321,77 +517,447 @@ int check_fee(size_t index, size_t cnt) {
   return CKB_SUCCESS;
 }
 
-int check_script_hash(uint8_t compare_script_hash_buf[], size_t index, size_t source, size_t field) {
-  uint64_t len = SCRIPT_HASH_SIZE;
-  uint8_t script_hash_buf[SCRIPT_HASH_SIZE];
-  int ret = ckb_load_cell_by_field(script_hash_buf, &len, 0, index, source, field);
-  if (ret != CKB_SUCCESS) {
-    return UDTSWAP_SYSCALL_ERROR - ret;
+int check_script_hash(uint8_t compare_script_hash_buf[], size_t index, size_t source, size_t field) {
+  uint64_t len = SCRIPT_HASH_SIZE;
+  uint8_t script_hash_buf[SCRIPT_HASH_SIZE];
+  int ret = ckb_load_cell_by_field(script_hash_buf, &len, 0, index, source, field);
+  if (ret != CKB_SUCCESS) {
+    return UDTSWAP_SYSCALL_ERROR - ret;
+  }
+  if (len != SCRIPT_HASH_SIZE) {
+    return SCRIPT_HASH_SIZE_NOT_CORRECT_ERROR;
+  }
+  if(memcmp(compare_script_hash_buf, script_hash_buf, SCRIPT_HASH_SIZE) != 0) {
+    return SCRIPT_NOT_MATCH_ERROR;
+  }
+  return CKB_SUCCESS;
+}
+
+/*
+ * @dev pair kind of UDTswap lock args, CKB is zero type hash
+ * UDTswap_pair_kind is selected once per pool, checks of pool udt cells are specialized by it
+ *
+ * @param udt1_type_script_hash_buf first udt type hash of lock args
+ * @param udt2_type_script_hash_buf second udt type hash of lock args
+ */
+int udtswap_pair_kind(uint8_t udt1_type_script_hash_buf[], uint8_t udt2_type_script_hash_buf[]) {
+  int is_ckb1 = memcmp(udt1_type_script_hash_buf, udt_type_ckb_script_hash_buf, SCRIPT_HASH_SIZE) == 0;
+  int is_ckb2 = memcmp(udt2_type_script_hash_buf, udt_type_ckb_script_hash_buf, SCRIPT_HASH_SIZE) == 0;
+  if (is_ckb1 && is_ckb2) {
+    return UDTSWAP_PAIR_CKB_CKB;
+  }
+  return is_ckb1 ? UDTSWAP_PAIR_CKB_UDT : is_ckb2 ? UDTSWAP_PAIR_UDT_CKB : UDTSWAP_PAIR_UDT_UDT;
+}
+
+/*
+ * @dev check udt cell type, is_ckb should be constant so each pair kind is straight-line code
+ * CKB cell has no type script, udt cell type hash is udt type hash of lock args
+ *
+ * @param is_ckb udt is CKB or not
+ * @param udt_type_script_hash_buf udt type hash of lock args
+ * @param index udt cell index
+ * @param source udt cell source
+ */
+static inline __attribute__((always_inline)) int check_udt_cell_type(
+  const int is_ckb,
+  uint8_t udt_type_script_hash_buf[],
+  size_t index,
+  size_t source
+) {
+  if (is_ckb) {
+    uint64_t len = 0;
+    int ret = ckb_load_cell_by_field(NULL, &len, 0, index, source, CKB_CELL_FIELD_TYPE_HASH);
+    if (ret != ITEM_MISSING_ERROR) {
+      return SCRIPT_NOT_MATCH_ERROR;
+    }
+    return CKB_SUCCESS;
+  }
+  return check_script_hash(udt_type_script_hash_buf, index, source, CKB_CELL_FIELD_TYPE_HASH);
+}
+
+/*
+ * @dev load udt cell amount, is_ckb should be constant
+ * CKB amount is capacity, udt amount is first 16 bytes of data
+ *
+ * @param is_ckb udt is CKB or not
+ * @param index udt cell index
+ * @param source udt cell source
+ * @param amount udt cell amount
+ */
+static inline __attribute__((always_inline)) int load_udt_cell_amount(
+  const int is_ckb,
+  size_t index,
+  size_t source,
+  uint128_t *amount
+) {
+  uint64_t len;
+  int ret;
+  if (is_ckb) {
+    uint64_t ckb_amount_64;
+    len = 8;
+    ret = ckb_load_cell_by_field((uint8_t *)&ckb_amount_64, &len, 0, index, source, CKB_CELL_FIELD_CAPACITY);
+    if (ret != CKB_SUCCESS) {
+      return UDTSWAP_SYSCALL_ERROR - ret;
+    }
+    *amount = (uint128_t)ckb_amount_64;
+    return CKB_SUCCESS;
+  }
+  uint8_t udt_amount_buf[UDT_AMOUNT_SIZE];
+  len = UDT_AMOUNT_SIZE;
+  ret = ckb_load_cell_data(udt_amount_buf, &len, 0, index, source);
+  if (ret != CKB_SUCCESS) {
+    return UDTSWAP_SYSCALL_ERROR - ret;
+  }
+  *amount = get_uint128_t(0, udt_amount_buf);
+  return CKB_SUCCESS;
+}
+
+/*
+ * @dev check udt cells of pool, specialized for each pair kind by constant is_ckb1, is_ckb2
+ * check udt type hash of input, output
+ * check udtswap udts reserve and udts locked amount same
+ *
+ * @param is_ckb1 first udt is CKB or not
+ * @param is_ckb2 second udt is CKB or not
+ * @param index UDTswap cell index
+ * @param udt1_type_script_hash_buf first udt type hash of lock args
+ * @param udt2_type_script_hash_buf second udt type hash of lock args
+ * @param reserves first udt before, after, second udt before, after reserve of UDTswap data
+ */
+static inline __attribute__((always_inline)) int check_pool_udt_cells(
+  const int is_ckb1,
+  const int is_ckb2,
+  size_t index,
+  uint8_t udt1_type_script_hash_buf[],
+  uint8_t udt2_type_script_hash_buf[],
+  uint128_t reserves[4]
+) {
+  uint128_t amount = 0;
+  int ret = check_udt_cell_type(is_ckb1, udt1_type_script_hash_buf, index + 1, CKB_SOURCE_INPUT);
+  if (ret != CKB_SUCCESS) {
+    return ret;
+  }
+  ret = check_udt_cell_type(is_ckb1, udt1_type_script_hash_buf, index + 1, CKB_SOURCE_OUTPUT);
+  if (ret != CKB_SUCCESS) {
+    return ret;
+  }
+  ret = check_udt_cell_type(is_ckb2, udt2_type_script_hash_buf, index + 2, CKB_SOURCE_INPUT);
+  if (ret != CKB_SUCCESS) {
+    return ret;
+  }
+  ret = check_udt_cell_type(is_ckb2, udt2_type_script_hash_buf, index + 2, CKB_SOURCE_OUTPUT);
+  if (ret != CKB_SUCCESS) {
+    return ret;
+  }
+
+  //udt type hash checked
+
+  ret = load_udt_cell_amount(is_ckb1, index + 1, CKB_SOURCE_INPUT, &amount);
+  if (ret != CKB_SUCCESS) {
+    return ret;
+  }
+  if (amount != reserves[0]) {
+    return UDTSWAP_TYPE_UDTSWAP_UDT_LOCK_AMOUNT_NOT_MATCH_ERROR;
+  }
+  ret = load_udt_cell_amount(is_ckb1, index + 1, CKB_SOURCE_OUTPUT, &amount);
+  if (ret != CKB_SUCCESS) {
+    return ret;
+  }
+  if (amount != reserves[1]) {
+    return UDTSWAP_TYPE_UDTSWAP_UDT_LOCK_AMOUNT_NOT_MATCH_ERROR;
+  }
+  ret = load_udt_cell_amount(is_ckb2, index + 2, CKB_SOURCE_INPUT, &amount);
+  if (ret != CKB_SUCCESS) {
+    return ret;
+  }
+  if (amount != reserves[2]) {
+    return UDTSWAP_TYPE_UDTSWAP_UDT_LOCK_AMOUNT_NOT_MATCH_ERROR;
+  }
+  ret = load_udt_cell_amount(is_ckb2, index + 2, CKB_SOURCE_OUTPUT, &amount);
+  if (ret != CKB_SUCCESS) {
+    return ret;
+  }
+  if (amount != reserves[3]) {
+    return UDTSWAP_TYPE_UDTSWAP_UDT_LOCK_AMOUNT_NOT_MATCH_ERROR;
+  }
+
+  //udtswap udts reserve and udts locked amount same checked
+
+  return CKB_SUCCESS;
+}
+
+/*
+ * @dev check udt cells of new pool, specialized for each pair kind by constant is_ckb1, is_ckb2
+ * check udt type hash
+ * check udt amount is empty reserve (CKB_RESERVE_DEFAULT or UDT_RESERVE_DEFAULT)
+ *
+ * @param is_ckb1 first udt is CKB or not
+ * @param is_ckb2 second udt is CKB or not
+ * @param udt1_type_script_hash_buf first udt type hash of lock args
+ * @param udt2_type_script_hash_buf second udt type hash of lock args
+ * @param udt1_amount first udt amount
+ * @param udt2_amount second udt amount
+ */
+static inline __attribute__((always_inline)) int check_new_pool_udt_cells(
+  const int is_ckb1,
+  const int is_ckb2,
+  uint8_t udt1_type_script_hash_buf[],
+  uint8_t udt2_type_script_hash_buf[],
+  uint128_t *udt1_amount,
+  uint128_t *udt2_amount
+) {
+  int ret = check_udt_cell_type(is_ckb1, udt1_type_script_hash_buf, UDTSWAP_UDT_LOCK_CELL_INDEX_1, CKB_SOURCE_OUTPUT);
+  if (ret != CKB_SUCCESS) {
+    return ret;
+  }
+  ret = check_udt_cell_type(is_ckb2, udt2_type_script_hash_buf, UDTSWAP_UDT_LOCK_CELL_INDEX_2, CKB_SOURCE_OUTPUT);
+  if (ret != CKB_SUCCESS) {
+    return ret;
+  }
+
+  //udt type hash checked
+
+  ret = load_udt_cell_amount(is_ckb1, UDTSWAP_UDT_LOCK_CELL_INDEX_1, CKB_SOURCE_OUTPUT, udt1_amount);
+  if (ret != CKB_SUCCESS) {
+    return ret;
+  }
+  ret = load_udt_cell_amount(is_ckb2, UDTSWAP_UDT_LOCK_CELL_INDEX_2, CKB_SOURCE_OUTPUT, udt2_amount);
+  if (ret != CKB_SUCCESS) {
+    return ret;
+  }
+  if (
+    *udt1_amount != (is_ckb1 ? CKB_RESERVE_DEFAULT : UDT_RESERVE_DEFAULT) ||
+    *udt2_amount != (is_ckb2 ? CKB_RESERVE_DEFAULT : UDT_RESERVE_DEFAULT)
+  ) {
+    return RESULT_NOT_CORRECT_ERROR;
+  }
+
+  //ckb reserve default checked
+  //udt reserve default checked
+
+  return CKB_SUCCESS;
+}
+
+/*
+ * @dev load UDTswap pool, first stage of UDTswap checks
+ * check lock script size, lock code hash and pair kind
+ * check data size of input, output
+ * check type hash of input is current script hash or not
+ * only small cells are loaded, lock hashes and udt cells are checked by udtswap_default_check
+ *
+ * @param index UDTswap cell index
+ * @param current_script_hash_buf current script hash
+ * @param lock_script_buf UDTswap lock script of input
+ * @param pair_kind pair kind of lock args
+ * @param type_script_hash_buf type hash of input
+ * @param is_current type script of input is current script or not
+ * @param reserves first udt before, after, second udt before, after reserve
+ * @param total_liquidity_before total liquidity input
+ * @param total_liquidity_after total liquidity output
+ */
+int udtswap_pool_load(
+  size_t index,
+  uint8_t current_script_hash_buf[],
+  uint8_t lock_script_buf[],
+  int *pair_kind,
+  uint8_t type_script_hash_buf[],
+  int *is_current,
+  uint128_t reserves[4],
+  uint128_t *total_liquidity_before,
+  uint128_t *total_liquidity_after
+) {
+  uint64_t len = UDTSWAP_LOCK_SCRIPT_SIZE;
+  int ret = ckb_load_cell_by_field(lock_script_buf, &len, 0, index, CKB_SOURCE_INPUT, CKB_CELL_FIELD_LOCK);
+  if (ret != CKB_SUCCESS) {
+      return UDTSWAP_SYSCALL_ERROR - ret;
+  }
+  if (len != UDTSWAP_LOCK_SCRIPT_SIZE) {
+    return UDTSWAP_LOCK_SCRIPT_SIZE_NOT_CORRECT_ERROR;
+  }
+  if(memcmp(&lock_script_buf[CODE_HASH_START], udtswap_lock_code_hash_buf, CODE_HASH_SIZE) != 0) {
+    return CODE_HASH_NOT_MATCH_ERROR;
+  }
+
+  *pair_kind = udtswap_pair_kind(
+    &lock_script_buf[UDTSWAP_LOCK_ARGS_UDT1_SCRIPT_HASH_START],
+    &lock_script_buf[UDTSWAP_LOCK_ARGS_UDT2_SCRIPT_HASH_START]
+  );
+  if (*pair_kind == UDTSWAP_PAIR_CKB_CKB) {
+    return SAME_UDT_OR_ORDER_ERROR;
+  }
+  //CKB, CKB pair is never created
+
+  uint8_t udtswap_input_data_buf[UDTSWAP_DATA_SIZE];
+  len = UDTSWAP_DATA_SIZE;
+  ret = ckb_load_cell_data(udtswap_input_data_buf, &len, 0, index, CKB_SOURCE_INPUT);
+  if (ret != CKB_SUCCESS) {
+    return UDTSWAP_SYSCALL_ERROR - ret;
+  }
+  if (len != UDTSWAP_DATA_SIZE && len != UDTSWAP_EXTENDED_DATA_SIZE) {
+    return UDTSWAP_DATA_SIZE_NOT_CORRECT_ERROR;
+  }
+
+  uint8_t udtswap_output_data_buf[UDTSWAP_DATA_SIZE];
+  len = UDTSWAP_DATA_SIZE;
+  ret = ckb_load_cell_data(udtswap_output_data_buf, &len, 0, index, CKB_SOURCE_OUTPUT);
+  if (ret != CKB_SUCCESS) {
+    return UDTSWAP_SYSCALL_ERROR - ret;
+  }
+  if (len != UDTSWAP_DATA_SIZE && len != UDTSWAP_EXTENDED_DATA_SIZE) {
+    return UDTSWAP_DATA_SIZE_NOT_CORRECT_ERROR;
+  }
+
+  reserves[0] = get_uint128_t(UDTSWAP_DATA_UDT1_RESERVE_START, udtswap_input_data_buf);
+  reserves[1] = get_uint128_t(UDTSWAP_DATA_UDT1_RESERVE_START, udtswap_output_data_buf);
+  reserves[2] = get_uint128_t(UDTSWAP_DATA_UDT2_RESERVE_START, udtswap_input_data_buf);
+  reserves[3] = get_uint128_t(UDTSWAP_DATA_UDT2_RESERVE_START, udtswap_output_data_buf);
+  *total_liquidity_before = get_uint128_t(UDTSWAP_DATA_TOTAL_LIQUIDITY_START, udtswap_input_data_buf);
+  *total_liquidity_after = get_uint128_t(UDTSWAP_DATA_TOTAL_LIQUIDITY_START, udtswap_output_data_buf);
+
+  len = SCRIPT_HASH_SIZE;
+  ret = ckb_load_cell_by_field(type_script_hash_buf, &len, 0, index, CKB_SOURCE_INPUT, CKB_CELL_FIELD_TYPE_HASH);
+  if(ret!=CKB_SUCCESS) {
+    return UDTSWAP_SYSCALL_ERROR - ret;
+  }
+  *is_current = memcmp(current_script_hash_buf, type_script_hash_buf, SCRIPT_HASH_SIZE) == 0;
+
+  return CKB_SUCCESS;
+}
+
+/*
+ * @dev check reserves of current pool before loading other cells, arithmetic only
+ * check reserve minimum, actual reserves are reserves except empty pool reserve
+ * check direction of swap, add liquidity, remove liquidity
+ * check add liquidity minimum and initial total liquidity
+ * only for pool of current script, a failed pool of other script ends swap loop instead of failing
+ *
+ * @param index UDTswap cell index
+ * @param is_ckb1 first udt is CKB or not
+ * @param is_ckb2 second udt is CKB or not
+ * @param reserves first udt before, after, second udt before, after reserve of UDTswap data
+ * @param total_liquidity_before total liquidity input
+ * @param total_liquidity_after total liquidity output
+ * @param actual_reserves first udt before, after, second udt before, after actual reserve
+ */
+int udtswap_reserve_check(
+  size_t index,
+  int is_ckb1,
+  int is_ckb2,
+  uint128_t reserves[4],
+  uint128_t total_liquidity_before,
+  uint128_t total_liquidity_after,
+  uint128_t actual_reserves[4]
+) {
+  uint128_t udt1_default = (is_ckb1 ? CKB_RESERVE_DEFAULT : UDT_RESERVE_DEFAULT);
+  uint128_t udt2_default = (is_ckb2 ? CKB_RESERVE_DEFAULT : UDT_RESERVE_DEFAULT);
+  if(
+    reserves[0] < udt1_default ||
+    reserves[1] <= udt1_default ||
+    reserves[2] < udt2_default ||
+    reserves[3] <= udt2_default
+  ) {
+    return RESERVE_BELOW_MINIMUM_ERROR;
+  }
+  uint128_t udt1_reserve_before = reserves[0] - udt1_default;
+  uint128_t udt1_reserve_after = reserves[1] - udt1_default;
+  uint128_t udt2_reserve_before = reserves[2] - udt2_default;
+  uint128_t udt2_reserve_after = reserves[3] - udt2_default;
+  actual_reserves[0] = udt1_reserve_before;
+  actual_reserves[1] = udt1_reserve_after;
+  actual_reserves[2] = udt2_reserve_before;
+  actual_reserves[3] = udt2_reserve_after;
+
+  if(total_liquidity_before == total_liquidity_after) { //swap
+    if(
+      udt1_reserve_before == 0 ||
+      udt2_reserve_before == 0
+    ) {
+      return RESERVE_BELOW_MINIMUM_ERROR;
+    }
+    if (total_liquidity_before == 0) {
+      return LIQUIDITY_EMPTY_ERROR;
+    }
+    if(
+      !(udt1_reserve_before < udt1_reserve_after && udt2_reserve_before > udt2_reserve_after) &&
+      !(udt1_reserve_before > udt1_reserve_after && udt2_reserve_before < udt2_reserve_after)
+    ) {
+      return RESULT_NOT_CORRECT_ERROR;
+    }
+    return CKB_SUCCESS;
+  }
+
+  if(index!=0) {
+    return UDTSWAP_NOT_MATCH_ERROR; //only first udtswap can add or remove liquidity
+  }
+  if(total_liquidity_before < total_liquidity_after) { //add liquidity
+    if(
+      udt1_reserve_after <= udt1_reserve_before ||
+      udt2_reserve_after <= udt2_reserve_before
+    ) {
+      return RESULT_NOT_CORRECT_ERROR;
+    }
+    if (total_liquidity_before == 0) {
+      if(udt1_reserve_after < ADD_LIQUIDITY_MINIMUM) {
+        return ADD_LIQUIDITY_TOO_LOW_ERROR;
+      }
+      if(total_liquidity_after != udt1_reserve_after) {
+        return LIQUIDITY_NOT_CORRECT_ERROR;
+      }
+      //total liquidity initial = udt1 reserve initial
+    } else if(udt1_reserve_after - udt1_reserve_before < ADD_LIQUIDITY_MINIMUM) {
+      return ADD_LIQUIDITY_TOO_LOW_ERROR;
+    }
+    return CKB_SUCCESS;
+  }
+
+  //remove liquidity
+  if(
+    udt1_reserve_before == 0 ||
+    udt2_reserve_before == 0
+  ) {
+    return RESERVE_BELOW_MINIMUM_ERROR;
   }
-  if (len != SCRIPT_HASH_SIZE) {
-    return SCRIPT_HASH_SIZE_NOT_CORRECT_ERROR;
+  if (total_liquidity_before == 0) {
+    return LIQUIDITY_EMPTY_ERROR;
   }
-  if(memcmp(compare_script_hash_buf, script_hash_buf, SCRIPT_HASH_SIZE) != 0) {
-    return SCRIPT_NOT_MATCH_ERROR;
+  if(
+    udt1_reserve_after >= udt1_reserve_before ||
+    udt2_reserve_after >= udt2_reserve_before
+  ) {
+    return RESULT_NOT_CORRECT_ERROR;
   }
   return CKB_SUCCESS;
 }
 
 /*
- * @dev check UDTswap defaults
- * check lock code hash, lock hash all same
+ * @dev check UDTswap defaults, after udtswap_pool_load
+ * check lock hash all same
  * check udt type hash
  * check udtswap udts reserve and udts locked amount same
  * check udtswap script hash input, output same
  * check type hash, type code hash
  *
  * @param index UDTswap cell index
- * @param is_ckb1 first udt is CKB or not
- * @param is_ckb2 second udt is CKB or not
- * @param udt1_reserve_before first udt reserve input
- * @param udt1_reserve_after first udt reserve output
- * @param udt2_reserve_before second udt reserve input
- * @param udt2_reserve_after second udt reserve output
- * @param total_liquidity_before total liquidity input
- * @param total_liquidity_after total liquidity output
+ * @param lock_script_buf UDTswap lock script of input
+ * @param pair_kind pair kind of lock args
+ * @param type_script_hash_buf type hash of input
+ * @param is_current type script of input is current script or not
+ * @param reserves first udt before, after, second udt before, after reserve of UDTswap data
  */
 int udtswap_default_check(
   size_t index,
-  int *is_ckb1,
-  int *is_ckb2,
-  uint128_t *udt1_reserve_before,
-  uint128_t *udt1_reserve_after,
-  uint128_t *udt2_reserve_before,
-  uint128_t *udt2_reserve_after,
-  uint128_t *total_liquidity_before,
-  uint128_t *total_liquidity_after
+  uint8_t lock_script_buf[],
+  int pair_kind,
+  uint8_t type_script_hash_buf[],
+  int is_current,
+  uint128_t reserves[4]
 ) {
-  uint8_t script_buf[UDTSWAP_LOCK_SCRIPT_SIZE];
-
-  uint8_t *lock_code_hash_buf;
-  uint8_t *udt1_type_script_hash_buf;
-  uint8_t *udt2_type_script_hash_buf;
-
-  uint64_t len = UDTSWAP_LOCK_SCRIPT_SIZE;
-  int ret = ckb_load_cell_by_field(script_buf, &len, 0, index, CKB_SOURCE_INPUT, CKB_CELL_FIELD_LOCK);
-  if (ret != CKB_SUCCESS) {
-      return UDTSWAP_SYSCALL_ERROR - ret;
-  }
-  if (len != UDTSWAP_LOCK_SCRIPT_SIZE) {
-    return UDTSWAP_LOCK_SCRIPT_SIZE_NOT_CORRECT_ERROR;
-  }
-
-  lock_code_hash_buf = &script_buf[CODE_HASH_START];
-  udt1_type_script_hash_buf = &script_buf[UDTSWAP_LOCK_ARGS_UDT1_SCRIPT_HASH_START];
-  udt2_type_script_hash_buf = &script_buf[UDTSWAP_LOCK_ARGS_UDT2_SCRIPT_HASH_START];
-
-  if(memcmp(lock_code_hash_buf, udtswap_lock_code_hash_buf, CODE_HASH_SIZE) != 0) {
-    return CODE_HASH_NOT_MATCH_ERROR;
-  }
+  uint8_t *udt1_type_script_hash_buf = &lock_script_buf[UDTSWAP_LOCK_ARGS_UDT1_SCRIPT_HASH_START];
+  uint8_t *udt2_type_script_hash_buf = &lock_script_buf[UDTSWAP_LOCK_ARGS_UDT2_SCRIPT_HASH_START];
 
   uint8_t current_lock_script_hash_buf[SCRIPT_HASH_SIZE];
-  len = SCRIPT_HASH_SIZE;
-  ret = ckb_load_cell_by_field(current_lock_script_hash_buf, &len, 0, index, CKB_SOURCE_INPUT, CKB_CELL_FIELD_LOCK_HASH);
+  uint64_t len = SCRIPT_HASH_SIZE;
+  int ret = ckb_load_cell_by_field(current_lock_script_hash_buf, &len, 0, index, CKB_SOURCE_INPUT, CKB_CELL_FIELD_LOCK_HASH);
   if (ret != CKB_SUCCESS) {
     return UDTSWAP_SYSCALL_ERROR - ret;
   }
@@ -423,188 +989,21 @@ int udtswap_default_check(
 
   // lock code hash, lock hash all same checked
 
-  uint8_t udtswap_input_data_buf[UDTSWAP_DATA_SIZE];
-  len = UDTSWAP_DATA_SIZE;
-  ret = ckb_load_cell_data(udtswap_input_data_buf, &len, 0, index, CKB_SOURCE_INPUT);
-  if (ret != CKB_SUCCESS) {
-    return UDTSWAP_SYSCALL_ERROR - ret;
-  }
-  if (len != UDTSWAP_DATA_SIZE) {
-    return UDTSWAP_DATA_SIZE_NOT_CORRECT_ERROR;
+  switch (pair_kind) {
+    case UDTSWAP_PAIR_CKB_UDT:
+      ret = check_pool_udt_cells(1, 0, index, udt1_type_script_hash_buf, udt2_type_script_hash_buf, reserves);
+      break;
+    case UDTSWAP_PAIR_UDT_CKB:
+      ret = check_pool_udt_cells(0, 1, index, udt1_type_script_hash_buf, udt2_type_script_hash_buf, reserves);
+      break;
+    default:
+      ret = check_pool_udt_cells(0, 0, index, udt1_type_script_hash_buf, udt2_type_script_hash_buf, reserves);
+      break;
   }
-
-  uint8_t udtswap_output_data_buf[UDTSWAP_DATA_SIZE];
-  len = UDTSWAP_DATA_SIZE;
-  ret = ckb_load_cell_data(udtswap_output_data_buf, &len, 0, index, CKB_SOURCE_OUTPUT);
   if (ret != CKB_SUCCESS) {
-    return UDTSWAP_SYSCALL_ERROR - ret;
-  }
-  if (len != UDTSWAP_DATA_SIZE) {
-    return UDTSWAP_DATA_SIZE_NOT_CORRECT_ERROR;
-  }
-
-  int isCKB1 = 0;
-  if(memcmp(udt1_type_script_hash_buf, udt_type_ckb_script_hash_buf, SCRIPT_HASH_SIZE)==0) {
-    isCKB1 = 1;
-  }
-  int isCKB2 = 0;
-  if(memcmp(udt2_type_script_hash_buf, udt_type_ckb_script_hash_buf, SCRIPT_HASH_SIZE)==0) {
-    isCKB2 = 1;
-  }
-
-  if(isCKB1) {
-    len = 0;
-    ret = ckb_load_cell_by_field(NULL, &len, 0, index+1, CKB_SOURCE_INPUT, CKB_CELL_FIELD_TYPE_HASH);
-    if (ret != ITEM_MISSING_ERROR) {
-      return SCRIPT_NOT_MATCH_ERROR;
-    }
-
-    len = 0;
-    ret = ckb_load_cell_by_field(NULL, &len, 0, index+1, CKB_SOURCE_OUTPUT, CKB_CELL_FIELD_TYPE_HASH);
-    if (ret != ITEM_MISSING_ERROR) {
-      return SCRIPT_NOT_MATCH_ERROR;
-    }
-  } else {
-    ret = check_script_hash(udt1_type_script_hash_buf, index+1, CKB_SOURCE_INPUT, CKB_CELL_FIELD_TYPE_HASH);
-    if(ret!=CKB_SUCCESS) {
-      return ret;
-    }
-
-    ret = check_script_hash(udt1_type_script_hash_buf, index+1, CKB_SOURCE_OUTPUT, CKB_CELL_FIELD_TYPE_HASH);
-    if(ret!=CKB_SUCCESS) {
-      return ret;
-    }
-  }
-
-  if(isCKB2) {
-    len = 0;
-    ret = ckb_load_cell_by_field(NULL, &len, 0, index+2, CKB_SOURCE_INPUT, CKB_CELL_FIELD_TYPE_HASH);
-    if (ret != ITEM_MISSING_ERROR) {
-      return SCRIPT_NOT_MATCH_ERROR;
-    }
-
-    len = 0;
-    ret = ckb_load_cell_by_field(NULL, &len, 0, index+2, CKB_SOURCE_OUTPUT, CKB_CELL_FIELD_TYPE_HASH);
-    if (ret != ITEM_MISSING_ERROR) {
-      return SCRIPT_NOT_MATCH_ERROR;
-    }
-  } else {
-    ret = check_script_hash(udt2_type_script_hash_buf, index+2, CKB_SOURCE_INPUT, CKB_CELL_FIELD_TYPE_HASH);
-    if(ret!=CKB_SUCCESS) {
-      return ret;
-    }
-
-    ret = check_script_hash(udt2_type_script_hash_buf, index+2, CKB_SOURCE_OUTPUT, CKB_CELL_FIELD_TYPE_HASH);
-    if(ret!=CKB_SUCCESS) {
-      return ret;
-    }
-  }
-
-  //udt type hash checked
-
-  uint128_t udtswap_udt1_amount_before = get_uint128_t(UDTSWAP_DATA_UDT1_RESERVE_START, udtswap_input_data_buf);
-  uint128_t udtswap_udt1_amount_after = get_uint128_t(UDTSWAP_DATA_UDT1_RESERVE_START, udtswap_output_data_buf);
-  uint128_t udtswap_udt2_amount_before = get_uint128_t(UDTSWAP_DATA_UDT2_RESERVE_START, udtswap_input_data_buf);
-  uint128_t udtswap_udt2_amount_after = get_uint128_t(UDTSWAP_DATA_UDT2_RESERVE_START, udtswap_output_data_buf);
-
-  if(isCKB1) {
-    uint64_t ckb_reserve_64;
-    uint128_t ckb_reserve;
-    len = 8;
-    ret = ckb_load_cell_by_field((uint8_t *)&ckb_reserve_64, &len, 0, index+1, CKB_SOURCE_INPUT, CKB_CELL_FIELD_CAPACITY);
-    if(ret!=CKB_SUCCESS) {
-      return UDTSWAP_SYSCALL_ERROR - ret;
-    }
-    ckb_reserve = (uint128_t)ckb_reserve_64;
-    if(udtswap_udt1_amount_before!=ckb_reserve) {
-      return UDTSWAP_TYPE_UDTSWAP_UDT_LOCK_AMOUNT_NOT_MATCH_ERROR;
-    }
-
-    len = 8;
-    ret = ckb_load_cell_by_field((uint8_t *)&ckb_reserve_64, &len, 0, index+1, CKB_SOURCE_OUTPUT, CKB_CELL_FIELD_CAPACITY);
-    if(ret!=CKB_SUCCESS) {
-      return UDTSWAP_SYSCALL_ERROR - ret;
-    }
-    ckb_reserve = (uint128_t)ckb_reserve_64;
-    if(udtswap_udt1_amount_after!=ckb_reserve) {
-      return UDTSWAP_TYPE_UDTSWAP_UDT_LOCK_AMOUNT_NOT_MATCH_ERROR;
-    }
-  } else {
-    uint8_t udt1_amount_before_buf[UDT_AMOUNT_SIZE];
-    len = UDT_AMOUNT_SIZE;
-    ret = ckb_load_cell_data(udt1_amount_before_buf, &len, 0, index + 1, CKB_SOURCE_INPUT);
-    if(ret != CKB_SUCCESS) {
-      return UDTSWAP_SYSCALL_ERROR - ret;
-    }
-    uint128_t udt1_amount_before = get_uint128_t(0, udt1_amount_before_buf);
-
-    if (udtswap_udt1_amount_before != udt1_amount_before) {
-      return UDTSWAP_TYPE_UDTSWAP_UDT_LOCK_AMOUNT_NOT_MATCH_ERROR;
-    }
-
-    uint8_t udt1_amount_after_buf[UDT_AMOUNT_SIZE];
-    len = UDT_AMOUNT_SIZE;
-    ret = ckb_load_cell_data(udt1_amount_after_buf, &len, 0, index + 1, CKB_SOURCE_OUTPUT);
-    if(ret != CKB_SUCCESS) {
-      return UDTSWAP_SYSCALL_ERROR - ret;
-    }
-    uint128_t udt1_amount_after = get_uint128_t(0, udt1_amount_after_buf);
-
-    if (udtswap_udt1_amount_after != udt1_amount_after) {
-      return UDTSWAP_TYPE_UDTSWAP_UDT_LOCK_AMOUNT_NOT_MATCH_ERROR;
-    }
-  }
-
-  if(isCKB2) {
-    uint64_t ckb_reserve_64;
-    uint128_t ckb_reserve;
-    len = 8;
-    ret = ckb_load_cell_by_field((uint8_t *)&ckb_reserve_64, &len, 0, index+2, CKB_SOURCE_INPUT, CKB_CELL_FIELD_CAPACITY);
-    if(ret!=CKB_SUCCESS) {
-      return UDTSWAP_SYSCALL_ERROR - ret;
-    }
-    ckb_reserve = (uint128_t)ckb_reserve_64;
-    if(udtswap_udt2_amount_before!=ckb_reserve) {
-      return UDTSWAP_TYPE_UDTSWAP_UDT_LOCK_AMOUNT_NOT_MATCH_ERROR;
-    }
-
-    len = 8;
-    ret = ckb_load_cell_by_field((uint8_t *)&ckb_reserve_64, &len, 0, index+2, CKB_SOURCE_OUTPUT, CKB_CELL_FIELD_CAPACITY);
-    if(ret!=CKB_SUCCESS) {
-      return UDTSWAP_SYSCALL_ERROR - ret;
-    }
-    ckb_reserve = (uint128_t)ckb_reserve_64;
-    if(udtswap_udt2_amount_after!=ckb_reserve) {
-      return UDTSWAP_TYPE_UDTSWAP_UDT_LOCK_AMOUNT_NOT_MATCH_ERROR;
-    }
-  } else {
-    uint8_t udt2_amount_before_buf[UDT_AMOUNT_SIZE];
-    len = UDT_AMOUNT_SIZE;
-    ret = ckb_load_cell_data(udt2_amount_before_buf, &len, 0, index + 2, CKB_SOURCE_INPUT);
-    if(ret != CKB_SUCCESS) {
-      return UDTSWAP_SYSCALL_ERROR - ret;
-    }
-    uint128_t udt2_amount_before = get_uint128_t(0, udt2_amount_before_buf);
-
-    if (udtswap_udt2_amount_before != udt2_amount_before) {
-      return UDTSWAP_TYPE_UDTSWAP_UDT_LOCK_AMOUNT_NOT_MATCH_ERROR;
-    }
-
-    uint8_t udt2_amount_after_buf[UDT_AMOUNT_SIZE];
-    len = UDT_AMOUNT_SIZE;
-    ret = ckb_load_cell_data(udt2_amount_after_buf, &len, 0, index + 2, CKB_SOURCE_OUTPUT);
-    if(ret != CKB_SUCCESS) {
-      return UDTSWAP_SYSCALL_ERROR - ret;
-    }
-    uint128_t udt2_amount_after = get_uint128_t(0, udt2_amount_after_buf);
-
-    if (udtswap_udt2_amount_after != udt2_amount_after) {
-      return UDTSWAP_TYPE_UDTSWAP_UDT_LOCK_AMOUNT_NOT_MATCH_ERROR;
-    }
+    return ret;
   }
 
-  //udtswap udts reserve and udts locked amount same checked
-
   uint8_t type_script_buf[UDTSWAP_TYPE_SCRIPT_SIZE];
   uint8_t *type_code_hash_buf;
 
@@ -623,42 +1022,19 @@ int udtswap_default_check(
   }
   //udtswap type script code hash check
 
-  uint8_t script_hash_buf1[SCRIPT_HASH_SIZE];
-  len = SCRIPT_HASH_SIZE;
-  ret = ckb_load_cell_by_field(script_hash_buf1, &len, 0, index, CKB_SOURCE_INPUT, CKB_CELL_FIELD_TYPE_HASH);
-  if(ret!=CKB_SUCCESS) {
-    return UDTSWAP_SYSCALL_ERROR - ret;
-  }
-
   uint8_t script_hash_buf2[SCRIPT_HASH_SIZE];
   len = SCRIPT_HASH_SIZE;
   ret = ckb_load_cell_by_field(script_hash_buf2, &len, 0, index, CKB_SOURCE_OUTPUT, CKB_CELL_FIELD_TYPE_HASH);
   if(ret!=CKB_SUCCESS) {
     return UDTSWAP_SYSCALL_ERROR - ret;
   }
-  if(memcmp(script_hash_buf1, script_hash_buf2, SCRIPT_HASH_SIZE)!=0) {
+  if(memcmp(type_script_hash_buf, script_hash_buf2, SCRIPT_HASH_SIZE)!=0) {
     return SCRIPT_NOT_MATCH_ERROR;
   }
 
   //udtswap script hash input, output same checked
 
-  *udt1_reserve_before = udtswap_udt1_amount_before;
-  *udt1_reserve_after = udtswap_udt1_amount_after;
-  *udt2_reserve_before = udtswap_udt2_amount_before;
-  *udt2_reserve_after = udtswap_udt2_amount_after;
-  *total_liquidity_before = get_uint128_t(UDTSWAP_DATA_TOTAL_LIQUIDITY_START, udtswap_input_data_buf);
-  *total_liquidity_after = get_uint128_t(UDTSWAP_DATA_TOTAL_LIQUIDITY_START, udtswap_output_data_buf);
-  *is_ckb1 = isCKB1;
-  *is_ckb2 = isCKB2;
-
-  uint8_t current_script_hash_buf[SCRIPT_HASH_SIZE];
-  len = SCRIPT_HASH_SIZE;
-  ret = ckb_load_script_hash(current_script_hash_buf, &len, 0);
-  if (ret!=CKB_SUCCESS) {
-    return UDTSWAP_SYSCALL_ERROR - ret;
-  }
-
-  if(memcmp(current_script_hash_buf, script_hash_buf1, SCRIPT_HASH_SIZE)!=0) {
+  if(!is_current) {
     return ONLY_TYPE_SCRIPT_NOT_MATCH_ERROR; //all checked but only type script hash is different (udtswap, but not current script)
   }
 
@@ -693,11 +1069,13 @@ int create_udtswap_check() {
     return TOO_MANY_GROUP_CELL_ERROR;
   }
 
+  len = 0;
   ret = ckb_load_cell_by_field(NULL, &len, 0, 0, CKB_SOURCE_GROUP_OUTPUT, CKB_CELL_FIELD_TYPE_HASH);
   if (ret != CKB_SUCCESS) {
     return NOT_ENOUGH_GROUP_CELL_ERROR;
   }
 
+  len = 0;
   ret = ckb_load_cell_by_field(NULL, &len, 0, 1, CKB_SOURCE_GROUP_OUTPUT, CKB_CELL_FIELD_TYPE_HASH);
   if (ret != INDEX_OUT_OF_BOUND_ERROR) {
     return TOO_MANY_GROUP_CELL_ERROR;
@@ -766,97 +1144,66 @@ int create_udtswap_check() {
   }
 
   //udtswap lock hash checked
-  int isCKB1 = 0;
-  if(memcmp(udt1_type_script_hash_buf, udt_type_ckb_script_hash_buf, SCRIPT_HASH_SIZE)==0) {
-    isCKB1 = 1;
-    len = 0;
-    ret = ckb_load_cell_by_field(NULL, &len, 0, UDTSWAP_UDT_LOCK_CELL_INDEX_1, CKB_SOURCE_OUTPUT, CKB_CELL_FIELD_TYPE_HASH);
-    if (ret!=ITEM_MISSING_ERROR) {
-        return SCRIPT_NOT_MATCH_ERROR;
-    }
-  } else {
-    ret = check_script_hash(udt1_type_script_hash_buf, UDTSWAP_UDT_LOCK_CELL_INDEX_1, CKB_SOURCE_OUTPUT, CKB_CELL_FIELD_TYPE_HASH);
-    if(ret!=CKB_SUCCESS) {
-      return ret;
-    }
-  }
 
-  int isCKB2 = 0;
-  if(memcmp(udt2_type_script_hash_buf, udt_type_ckb_script_hash_buf, SCRIPT_HASH_SIZE)==0) {
-    isCKB2 = 1;
-    len = 0;
-    ret = ckb_load_cell_by_field(NULL, &len, 0, UDTSWAP_UDT_LOCK_CELL_INDEX_2, CKB_SOURCE_OUTPUT, CKB_CELL_FIELD_TYPE_HASH);
-    if (ret!=ITEM_MISSING_ERROR) {
-        return SCRIPT_NOT_MATCH_ERROR;
-    }
+  uint128_t udt1_amount = 0, udt2_amount = 0;
+  int pair_kind = udtswap_pair_kind(udt1_type_script_hash_buf, udt2_type_script_hash_buf);
+  if (pair_kind == UDTSWAP_PAIR_CKB_UDT) {
+    ret = check_new_pool_udt_cells(1, 0, udt1_type_script_hash_buf, udt2_type_script_hash_buf, &udt1_amount, &udt2_amount);
   } else {
-    ret = check_script_hash(udt2_type_script_hash_buf, UDTSWAP_UDT_LOCK_CELL_INDEX_2, CKB_SOURCE_OUTPUT, CKB_CELL_FIELD_TYPE_HASH);
-    if(ret!=CKB_SUCCESS) {
-      return ret;
-    }
+    ret = check_new_pool_udt_cells(0, 0, udt1_type_script_hash_buf, udt2_type_script_hash_buf, &udt1_amount, &udt2_amount);
+  }
+  if (ret != CKB_SUCCESS) {
+    return ret;
   }
+  //order of udts, second udt is not CKB
 
-  //udt type hash checked
 
-  uint8_t udtswap_data_buf[UDTSWAP_DATA_SIZE];
-  len = UDTSWAP_DATA_SIZE;
+  uint8_t udtswap_data_buf[UDTSWAP_EXTENDED_DATA_SIZE];
+  len = UDTSWAP_EXTENDED_DATA_SIZE;
   ret = ckb_load_cell_data(udtswap_data_buf, &len, 0, UDTSWAP_TYPE_CELL_INDEX, CKB_SOURCE_OUTPUT);
   if (ret!=CKB_SUCCESS) {
     return UDTSWAP_SYSCALL_ERROR - ret;
   }
-  if(len!=UDTSWAP_DATA_SIZE) {
+  if(len!=UDTSWAP_DATA_SIZE && len!=UDTSWAP_EXTENDED_DATA_SIZE) {
     return UDTSWAP_DATA_SIZE_NOT_CORRECT_ERROR;
   }
-  uint128_t udtswap_udt1_reserve = get_uint128_t(UDTSWAP_DATA_UDT1_RESERVE_START, udtswap_data_buf);
-  uint128_t udtswap_udt2_reserve = get_uint128_t(UDTSWAP_DATA_UDT2_RESERVE_START, udtswap_data_buf);
-  uint128_t udtswap_total_liquidity = get_uint128_t(UDTSWAP_DATA_TOTAL_LIQUIDITY_START, udtswap_data_buf);
-
-  uint64_t udt_amount_64;
-  uint128_t udt1_amount = 0;
-  uint8_t udt_data_buf[UDT_AMOUNT_SIZE];
-  if(isCKB1) {
-    len = 8;
-    ret = ckb_load_cell_by_field((uint8_t *)&udt_amount_64, &len, 0, UDTSWAP_UDT_LOCK_CELL_INDEX_1, CKB_SOURCE_OUTPUT, CKB_CELL_FIELD_CAPACITY);
-    if(ret!=CKB_SUCCESS) {
-      return UDTSWAP_SYSCALL_ERROR - ret;
+  if(len==UDTSWAP_EXTENDED_DATA_SIZE) {
+    uint64_t block_number = 0;
+    ret = load_header_block_number(UDTSWAP_HEADER_DEP_INDEX, CKB_SOURCE_HEADER_DEP, &block_number);
+    if (ret!=CKB_SUCCESS) {
+      return ret;
     }
-    udt1_amount = (uint128_t)udt_amount_64;
-  } else {
-    ret = ckb_load_cell_data(udt_data_buf, &len, 0, UDTSWAP_UDT_LOCK_CELL_INDEX_1, CKB_SOURCE_OUTPUT);
-    if(ret!=CKB_SUCCESS) {
-      return UDTSWAP_SYSCALL_ERROR - ret;
+    uint64_t input_block_number = 0;
+    ret = load_header_block_number(0, CKB_SOURCE_INPUT, &input_block_number);
+    if (ret!=CKB_SUCCESS) {
+      return ret;
     }
-    udt1_amount = get_uint128_t(0, udt_data_buf);
-  }
-
-  uint128_t udt2_amount = 0;
-  if(isCKB2) {
-    len = 8;
-    ret = ckb_load_cell_by_field((uint8_t *)&udt_amount_64, &len, 0, UDTSWAP_UDT_LOCK_CELL_INDEX_2, CKB_SOURCE_OUTPUT, CKB_CELL_FIELD_CAPACITY);
-    if(ret!=CKB_SUCCESS) {
-      return UDTSWAP_SYSCALL_ERROR - ret;
+    if(block_number < input_block_number) {
+      return LAST_UPDATE_NOT_CORRECT_ERROR;
     }
-    udt2_amount = (uint128_t)udt_amount_64;
-  } else {
-    ret = ckb_load_cell_data(udt_data_buf, &len, 0, UDTSWAP_UDT_LOCK_CELL_INDEX_2, CKB_SOURCE_OUTPUT);
-    if(ret!=CKB_SUCCESS) {
-      return UDTSWAP_SYSCALL_ERROR - ret;
+    if(memcmp(&udtswap_data_buf[UDTSWAP_DATA_LAST_UPDATE_START], &block_number, BLOCK_NUMBER_SIZE)!=0) {
+      return LAST_UPDATE_NOT_CORRECT_ERROR;
+    }
+    size_t j;
+    for(j=UDTSWAP_DATA_PRICE1_CUMULATIVE_START; j<UDTSWAP_DATA_LAST_UPDATE_START; j++) {
+      if(udtswap_data_buf[j]!=0) {
+        return PRICE_CUMULATIVE_NOT_CORRECT_ERROR;
+      }
     }
-    udt2_amount = get_uint128_t(0, udt_data_buf);
   }
+  //extended data price cumulative empty, last update checked
+  uint128_t udtswap_udt1_reserve = get_uint128_t(UDTSWAP_DATA_UDT1_RESERVE_START, udtswap_data_buf);
+  uint128_t udtswap_udt2_reserve = get_uint128_t(UDTSWAP_DATA_UDT2_RESERVE_START, udtswap_data_buf);
+  uint128_t udtswap_total_liquidity = get_uint128_t(UDTSWAP_DATA_TOTAL_LIQUIDITY_START, udtswap_data_buf);
 
   if(
     udtswap_udt1_reserve != udt1_amount ||
     udtswap_udt2_reserve != udt2_amount ||
-    udt1_amount != (isCKB1 ? CKB_RESERVE_DEFAULT : UDT_RESERVE_DEFAULT) ||
-    udt2_amount != (isCKB2 ? CKB_RESERVE_DEFAULT : UDT_RESERVE_DEFAULT) ||
     udtswap_total_liquidity != 0
   ) {
     return RESULT_NOT_CORRECT_ERROR;
   }
   //udtswap udts reserve, udts amount same checked
-  //ckb reserve default checked
-  //udt reserve default checked
   //total liquidity default checked
 
   return CKB_SUCCESS;
@@ -933,18 +1280,23 @@ int check_liquidity_udt_script(size_t index, size_t source) {
  * @dev check UDTswap
  * check pool creation
  * check group
- * check UDTswap default for all UDTswap type scripts
- * check swap, add liquidity, remove liquidity
+ * check UDTswap for all UDTswap type scripts, cheap checks first
+ *   load pool lock script and data (udtswap_pool_load)
+ *   check reserves of current pool (udtswap_reserve_check)
+ *   check UDTswap default (udtswap_default_check)
+ *   check price cumulative, swap, add liquidity, remove liquidity
  * check fee
  */
 
 int main(int argc, char* argv[]) {
+  PROFILE_PHASE("create");
   int ret = create_udtswap_check();
   if (ret==CKB_SUCCESS) {
     return ret;
   }
   //udtswap creation checked
 
+  PROFILE_PHASE("group");
   uint64_t len = 0;
   ret = ckb_load_cell_by_field(NULL, &len, 0, 0, CKB_SOURCE_GROUP_INPUT, CKB_CELL_FIELD_TYPE_HASH);
   if (ret != CKB_SUCCESS) {
@@ -970,22 +1322,59 @@ int main(int argc, char* argv[]) {
   }
   //udtswap group should be 1 input and 1 output
 
+  uint8_t current_script_hash_buf[SCRIPT_HASH_SIZE];
+  len = SCRIPT_HASH_SIZE;
+  ret = ckb_load_script_hash(current_script_hash_buf, &len, 0);
+  if (ret!=CKB_SUCCESS) {
+    return UDTSWAP_SYSCALL_ERROR - ret;
+  }
+
   int is_success = 0;
-  int is_ckb1=0, is_ckb2=0;
-  uint128_t udt1_reserve_before, udt1_reserve_after, udt2_reserve_before, udt2_reserve_after, total_liquidity_before, total_liquidity_after;
+  int pair_kind = 0, is_current = 0;
+  uint8_t lock_script_buf[UDTSWAP_LOCK_SCRIPT_SIZE];
+  uint8_t type_script_hash_buf[SCRIPT_HASH_SIZE];
+  uint128_t reserves[4], actual_reserves[4], total_liquidity_before, total_liquidity_after;
   size_t i=0;
   while(1) {
-    ret = udtswap_default_check(
+    PROFILE_PHASE("load");
+    ret = udtswap_pool_load(
       i,
-      &is_ckb1,
-      &is_ckb2,
-      &udt1_reserve_before,
-      &udt1_reserve_after,
-      &udt2_reserve_before,
-      &udt2_reserve_after,
+      current_script_hash_buf,
+      lock_script_buf,
+      &pair_kind,
+      type_script_hash_buf,
+      &is_current,
+      reserves,
       &total_liquidity_before,
       &total_liquidity_after
     );
+    if(ret!=CKB_SUCCESS) {
+      if(is_success) {
+        break;
+      }
+      return ret;
+    }
+
+    if(is_current) {
+      PROFILE_PHASE("reserve");
+      ret = udtswap_reserve_check(
+        i,
+        pair_kind == UDTSWAP_PAIR_CKB_UDT,
+        pair_kind == UDTSWAP_PAIR_UDT_CKB,
+        reserves,
+        total_liquidity_before,
+        total_liquidity_after,
+        actual_reserves
+      );
+      if(ret!=CKB_SUCCESS) {
+        return ret;
+      }
+    }
+    //group has 1 input, so is_success is 0 until pool of current script and its failure fails the script
+    //reserves of current pool are checked before lock hashes and udt cells are loaded
+
+    PROFILE_PHASE("default");
+    ret = udtswap_default_check(i, lock_script_buf, pair_kind, type_script_hash_buf, is_current, reserves);
     if(ret==ONLY_TYPE_SCRIPT_NOT_MATCH_ERROR) {
       i += 3;
       continue;
@@ -996,94 +1385,55 @@ int main(int argc, char* argv[]) {
       }
       return ret;
     }
-    uint128_t udt1_default = (is_ckb1 ? CKB_RESERVE_DEFAULT : UDT_RESERVE_DEFAULT);
-    uint128_t udt2_default = (is_ckb2 ? CKB_RESERVE_DEFAULT : UDT_RESERVE_DEFAULT);
-    if(
-      udt1_reserve_before < udt1_default ||
-      udt1_reserve_after <= udt1_default ||
-      udt2_reserve_before < udt2_default ||
-      udt2_reserve_after <= udt2_default
-    ) {
-      return RESERVE_BELOW_MINIMUM_ERROR;
+    uint128_t udt1_reserve_before = actual_reserves[0];
+    uint128_t udt1_reserve_after = actual_reserves[1];
+    uint128_t udt2_reserve_before = actual_reserves[2];
+    uint128_t udt2_reserve_after = actual_reserves[3];
+
+    PROFILE_PHASE("price");
+    ret = check_price_cumulative(i, udt1_reserve_before, udt2_reserve_before);
+    if(ret!=CKB_SUCCESS) {
+      return ret;
     }
-    udt1_reserve_before -= udt1_default;
-    udt1_reserve_after -= udt1_default;
-    udt2_reserve_before -= udt2_default;
-    udt2_reserve_after -= udt2_default;
+    //price cumulative checked
 
     if(total_liquidity_before == total_liquidity_after) { //swap
-      if(
-        udt1_reserve_before == 0 ||
-        udt2_reserve_before == 0
-      ) {
-        return RESERVE_BELOW_MINIMUM_ERROR;
-      }
-      if (total_liquidity_before == 0) {
-        return LIQUIDITY_EMPTY_ERROR;
-      }
-
-      if(
-        udt1_reserve_before < udt1_reserve_after &&
-        udt2_reserve_before > udt2_reserve_after
-      ) {
+      PROFILE_PHASE("swap");
+      int swap_mode = load_swap_mode(i);
+      if(udt1_reserve_before < udt1_reserve_after) {
         ret = swap(
           udt1_reserve_before,
           udt2_reserve_before,
           udt1_reserve_after,
-          udt2_reserve_after
+          udt2_reserve_after,
+          swap_mode
         );
-        if(ret!=CKB_SUCCESS) {
-          return ret;
-        }
-      } else if (
-        udt1_reserve_before > udt1_reserve_after &&
-        udt2_reserve_before < udt2_reserve_after
-      ) {
+      } else {
         ret = swap(
           udt2_reserve_before,
           udt1_reserve_before,
           udt2_reserve_after,
-          udt1_reserve_after
+          udt1_reserve_after,
+          swap_mode
         );
-        if(ret!=CKB_SUCCESS) {
-          return ret;
-        }
-      } else {
-        return RESULT_NOT_CORRECT_ERROR;
       }
+      if(ret!=CKB_SUCCESS) {
+        return ret;
+      }
+      //direction checked by udtswap_reserve_check
 
       is_success = 1; //pass
 
     } else {
-      if(i!=0) {
-        return UDTSWAP_NOT_MATCH_ERROR; //only first udtswap can add or remove liquidity
-      }
       if(total_liquidity_before < total_liquidity_after) { //add liquidity
-        if(
-          udt1_reserve_after <= udt1_reserve_before ||
-          udt2_reserve_after <= udt2_reserve_before
-        ) {
-          return RESULT_NOT_CORRECT_ERROR;
-        }
-
+        PROFILE_PHASE("add");
         ret = check_liquidity_udt_script(ADD_LIQUIDITY_CELL_INDEX, CKB_SOURCE_OUTPUT);
         if(ret != CKB_SUCCESS) {
           return ret;
         }
         //udtswap liquidity udt script checked
 
-        if (total_liquidity_before == 0) {
-          if(udt1_reserve_after < ADD_LIQUIDITY_MINIMUM) {
-            return ADD_LIQUIDITY_TOO_LOW_ERROR;
-          }
-          if(total_liquidity_after != udt1_reserve_after) {
-            return LIQUIDITY_NOT_CORRECT_ERROR;
-          }
-          //total liquidity initial = udt1 reserve initial
-        } else {
-          if(udt1_reserve_after - udt1_reserve_before < ADD_LIQUIDITY_MINIMUM) {
-            return ADD_LIQUIDITY_TOO_LOW_ERROR;
-          }
+        if (total_liquidity_before != 0) {
           ret = add_liquidity(
             udt1_reserve_before,
             udt2_reserve_before,
@@ -1093,23 +1443,9 @@ int main(int argc, char* argv[]) {
             total_liquidity_after
           );
         }
+        //initial total liquidity checked by udtswap_reserve_check
       } else { //remove liquidity
-        if(
-          udt1_reserve_before == 0 ||
-          udt2_reserve_before == 0
-        ) {
-          return RESERVE_BELOW_MINIMUM_ERROR;
-        }
-        if (total_liquidity_before == 0) {
-          return LIQUIDITY_EMPTY_ERROR;
-        }
-        if(
-          udt1_reserve_after >= udt1_reserve_before ||
-          udt2_reserve_after >= udt2_reserve_before
-        ) {
-          return RESULT_NOT_CORRECT_ERROR;
-        }
-
+        PROFILE_PHASE("remove");
         ret = check_liquidity_udt_script(REMOVE_LIQUIDITY_CELL_START_INDEX, CKB_SOURCE_INPUT);
         if(ret != CKB_SUCCESS) {
           return ret;
@@ -1134,6 +1470,7 @@ int main(int argc, char* argv[]) {
     i += 3;
   }
 
+  PROFILE_PHASE("fee");
   ret = check_fee(i, i / 3);
   if(ret!=CKB_SUCCESS) {
     return ret;
@@ -1141,4 +1478,4 @@ int main(int argc, char* argv[]) {
   //fee checked
 
   return CKB_SUCCESS;
-}
\ No newline at end of file
+}
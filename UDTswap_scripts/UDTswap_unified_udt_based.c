@@ -0,0 +1,58 @@
+/*
+ * @dev UDTswap type script, lock script and liquidity udt script in one binary
+ *
+ * one code cell dep for all UDTswap scripts, syscall, molecule and bn code is shared
+ * deploy with all 3 lines of hash.txt set to the code hash of this binary
+ * role is dispatched by size of the running script
+ * scripts check each other by code hash and script size, so with one code hash
+ * a script of one role is never taken as a script of another role
+ */
+
+#ifdef UDTSWAP_PROFILE
+#error "UDTSWAP_PROFILE is not supported by unified script, profile the separate scripts"
+#endif
+
+#pragma push_macro("main")
+#undef main
+
+#define main udtswap_role_type_main
+#include "UDTswap_udt_based.c"
+#undef main
+#undef UDTSWAP_PROFILE_NAME
+
+#define main udtswap_role_lock_main
+#include "UDTswap_lock_udt_based.c"
+#undef main
+#undef UDTSWAP_PROFILE_NAME
+
+#define main udtswap_role_liquidity_main
+#include "UDTswap_liquidity_UDT_udt_based.c"
+#undef main
+#undef UDTSWAP_PROFILE_NAME
+
+#pragma pop_macro("main")
+
+/*
+ * @dev dispatch UDTswap role
+ * UDTswap type script args is tx input, script size UDTSWAP_TYPE_SCRIPT_SIZE
+ * UDTswap lock script args is 2 udt type script hashes, script size UDTSWAP_LOCK_SCRIPT_SIZE
+ * UDTswap liquidity udt script args is lock hash and tx input, script size UDTSWAP_LIQUIDITY_UDT_TYPE_SCRIPT_SIZE
+ * only length of script is loaded
+ */
+
+int main(int argc, char* argv[]) {
+  uint64_t len = 0;
+  int ret = ckb_load_script(NULL, &len, 0);
+  if (ret != CKB_SUCCESS) {
+    return UDTSWAP_SYSCALL_ERROR - ret;
+  }
+  switch (len) {
+    case UDTSWAP_TYPE_SCRIPT_SIZE:
+      return udtswap_role_type_main(argc, argv);
+    case UDTSWAP_LOCK_SCRIPT_SIZE:
+      return udtswap_role_lock_main(argc, argv);
+    case UDTSWAP_LIQUIDITY_UDT_TYPE_SCRIPT_SIZE:
+      return udtswap_role_liquidity_main(argc, argv);
+  }
+  return UDTSWAP_ROLE_NOT_MATCH_ERROR;
+}
@@ -0,0 +1,31 @@
+#include "bn_lib.h"
+
+/*
+ * @dev entry of bn library cell
+ * fields are stored one by one by pc relative addresses of hidden functions,
+ * a constant table would need relocations
+ *
+ * @param lib function table of script
+ * @param size size of function table of script
+ */
+
+#define BN_LIB_SET(field, function) \
+  if (offsetof(udtswap_bn_lib_t, field) + sizeof(lib->field) <= size) { \
+    lib->field = function; \
+  }
+
+int udtswap_bn_lib_init(udtswap_bn_lib_t *lib, size_t size) {
+  BN_LIB_SET(init, bignum_init);
+  BN_LIB_SET(from_uint64_t, bignum_from_uint64_t);
+  BN_LIB_SET(to_uint64_t, bignum_to_uint64_t);
+  BN_LIB_SET(add, bignum_add);
+  BN_LIB_SET(sub, bignum_sub);
+  BN_LIB_SET(mul, bignum_mul);
+  BN_LIB_SET(div, bignum_div);
+  BN_LIB_SET(or, bignum_or);
+  BN_LIB_SET(cmp, bignum_cmp);
+  BN_LIB_SET(is_zero, bignum_is_zero);
+  BN_LIB_SET(assign, bignum_assign);
+  BN_LIB_SET(lshift_word, _lshift_word);
+  return UDTSWAP_BN_LIB_VERSION;
+}
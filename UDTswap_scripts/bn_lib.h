@@ -0,0 +1,35 @@
+#ifndef UDTSWAP_BN_LIB_H_
+#define UDTSWAP_BN_LIB_H_
+
+#include <stddef.h>
+#include "bn.h"
+
+/*
+ * @dev ABI of bn library cell (bn_lib)
+ *
+ * library is a position independent ELF without relocations, entry is udtswap_bn_lib_init
+ * entry fills the function table up to size and returns version of library
+ * fields are only appended, a library of higher version serves scripts of lower version
+ */
+#define UDTSWAP_BN_LIB_VERSION 2
+
+typedef struct {
+  void (*init)(struct bn* n);
+  void (*from_uint64_t)(struct bn* n, DTYPE_TMP i);
+  uint64_t (*to_uint64_t)(struct bn* n);
+  void (*add)(struct bn* a, struct bn* b, struct bn* c);
+  void (*sub)(struct bn* a, struct bn* b, struct bn* c);
+  void (*mul)(struct bn* a, struct bn* b, struct bn* c);
+  void (*div)(struct bn* a, struct bn* b, struct bn* c);
+  void (*or)(struct bn* a, struct bn* b, struct bn* c);
+  int (*cmp)(struct bn* a, struct bn* b);
+  int (*is_zero)(struct bn* n);
+  void (*assign)(struct bn* dst, struct bn* src);
+  void (*lshift_word)(struct bn* a, int nwords); /* version 2 */
+} udtswap_bn_lib_t;
+
+typedef int (*udtswap_bn_lib_entry)(udtswap_bn_lib_t *lib, size_t size);
+
+int udtswap_bn_lib_init(udtswap_bn_lib_t *lib, size_t size);
+
+#endif /* UDTSWAP_BN_LIB_H_ */
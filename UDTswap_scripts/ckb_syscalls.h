@@ -6,6 +6,22 @@
 
 #include "ckb_consts.h"
 
+#ifdef CKB_SYSCALLS_MOCK
+/* host native build, syscalls are served by mock transaction of UDTswap_tools */
+#define memory_barrier() asm volatile("" ::: "memory")
+
+__attribute__((visibility("default"))) long ckb_mock_syscall(long n, long a0, long a1, long a2,
+                                                             long a3, long a4, long a5);
+/* id of current run, statics which CKB-VM starts with on every run are reset when it changes */
+__attribute__((visibility("default"))) uint64_t ckb_mock_run_id(void);
+
+static inline long __internal_syscall(long n, long _a0, long _a1, long _a2,
+                                      long _a3, long _a4, long _a5) {
+  long ret = ckb_mock_syscall(n, _a0, _a1, _a2, _a3, _a4, _a5);
+  memory_barrier();
+  return ret;
+}
+#else
 #define memory_barrier() asm volatile("fence" ::: "memory")
 
 static inline long __internal_syscall(long n, long _a0, long _a1, long _a2,
@@ -34,6 +50,7 @@ static inline long __internal_syscall(long n, long _a0, long _a1, long _a2,
 
   return a0;
 }
+#endif /* CKB_SYSCALLS_MOCK */
 
 #define syscall(n, a, b, c, d, e, f)                                           \
   __internal_syscall(n, (long)(a), (long)(b), (long)(c), (long)(d), (long)(e), \
@@ -145,6 +162,10 @@ int ckb_debug(const char* s) {
   return syscall(SYS_ckb_debug, s, 0, 0, 0, 0, 0);
 }
 
+uint64_t ckb_current_cycles() {
+  return syscall(SYS_ckb_current_cycles, 0, 0, 0, 0, 0, 0);
+}
+
 /* load the actual witness for the current type verify group.
    use this instead of ckb_load_witness if type contract needs args to verify input/output.
  */
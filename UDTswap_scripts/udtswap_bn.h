@@ -0,0 +1,276 @@
+#ifndef UDTSWAP_BN_H_
+#define UDTSWAP_BN_H_
+
+/*
+ * @dev bn of dynamic build (-DUDTSWAP_BN_DYNAMIC)
+ *
+ * bn functions are called through the table of bn library cell instead of static libbn
+ * library is a cell dep of type hash udtswap_bn_lib_code_hash_buf (5th line of hash.txt)
+ * library is loaded by first bn call, script exits with the load error
+ * native build of UDTswap_tools loads a host bn_lib cell dep the same way
+ * include after udtswap_common.h
+ * static build has no library code
+ */
+#ifdef UDTSWAP_BN_DYNAMIC
+
+#include "bn_lib.h"
+
+#define BN_LIB_PAGE_SIZE 4096
+#define BN_LIB_CODE_SIZE (64 * 1024)
+#define BN_LIB_MAX_SEGMENTS 8
+
+#define BN_LIB_ELF_HEADER_SIZE 64
+#define BN_LIB_ELF_PROGRAM_HEADER_SIZE 56
+#define BN_LIB_ELF_TYPE_DYN 3
+#if defined(__x86_64__)
+#define BN_LIB_ELF_MACHINE 62
+#elif defined(__aarch64__)
+#define BN_LIB_ELF_MACHINE 183
+#else
+#define BN_LIB_ELF_MACHINE 243
+#endif
+//riscv in CKB-VM, host machine in native build
+#define BN_LIB_PT_LOAD 1
+#define BN_LIB_PT_DYNAMIC 2
+#define BN_LIB_PF_X 1
+#define BN_LIB_PF_W 2
+#define BN_LIB_DT_NULL 0
+#define BN_LIB_DT_PLTRELSZ 2
+#define BN_LIB_DT_RELASZ 8
+#define BN_LIB_DT_RELSZ 18
+
+typedef struct {
+  uint8_t ident[16];
+  uint16_t type;
+  uint16_t machine;
+  uint32_t version;
+  uint64_t entry;
+  uint64_t phoff;
+  uint64_t shoff;
+  uint32_t flags;
+  uint16_t ehsize;
+  uint16_t phentsize;
+  uint16_t phnum;
+  uint16_t shentsize;
+  uint16_t shnum;
+  uint16_t shstrndx;
+} bn_lib_elf_header_t;
+
+typedef struct {
+  uint32_t type;
+  uint32_t flags;
+  uint64_t offset;
+  uint64_t vaddr;
+  uint64_t paddr;
+  uint64_t filesz;
+  uint64_t memsz;
+  uint64_t align;
+} bn_lib_elf_program_header_t;
+
+static udtswap_bn_lib_t udtswap_bn_lib;
+static uint64_t udtswap_bn_lib_loaded = 0;
+
+#ifdef CKB_SYSCALLS_MOCK
+#define BN_LIB_LOAD_ID ckb_mock_run_id()
+#else
+#define BN_LIB_LOAD_ID 1
+#endif
+//native build runs scripts many times in one process, library is loaded again in every run
+
+static uint8_t bn_lib_code[BN_LIB_CODE_SIZE] __attribute__((aligned(BN_LIB_PAGE_SIZE)));
+
+/*
+ * @dev find bn library cell dep by type hash
+ *
+ * @param index bn library cell dep index
+ */
+
+static int find_bn_lib(size_t *index) {
+  uint8_t type_hash_buf[SCRIPT_HASH_SIZE];
+  uint64_t len;
+  size_t i = 0;
+  while (1) {
+    len = SCRIPT_HASH_SIZE;
+    int ret = ckb_load_cell_by_field(type_hash_buf, &len, 0, i, CKB_SOURCE_CELL_DEP, CKB_CELL_FIELD_TYPE_HASH);
+    if (ret == INDEX_OUT_OF_BOUND_ERROR) {
+      return BN_LIB_NOT_FOUND_ERROR;
+    }
+    if (ret == CKB_SUCCESS && len == SCRIPT_HASH_SIZE
+      && memcmp(type_hash_buf, udtswap_bn_lib_code_hash_buf, SCRIPT_HASH_SIZE) == 0) {
+      *index = i;
+      return CKB_SUCCESS;
+    }
+    if (ret != CKB_SUCCESS && ret != ITEM_MISSING_ERROR) {
+      return UDTSWAP_SYSCALL_ERROR - ret;
+    }
+    i++;
+  }
+}
+
+/*
+ * @dev check dynamic section of bn library has no relocations
+ */
+
+static int check_bn_lib_dynamic(const bn_lib_elf_program_header_t *ph) {
+  if (ph->filesz > BN_LIB_CODE_SIZE || ph->vaddr > BN_LIB_CODE_SIZE - ph->filesz || ph->vaddr % 8 != 0) {
+    return BN_LIB_FORMAT_ERROR;
+  }
+  uint64_t *entry = (uint64_t *)&bn_lib_code[ph->vaddr];
+  size_t i;
+  for (i = 0; i + 1 < ph->filesz / 8; i += 2) {
+    if (entry[i] == BN_LIB_DT_NULL) {
+      return CKB_SUCCESS;
+    }
+    if ((entry[i] == BN_LIB_DT_RELASZ || entry[i] == BN_LIB_DT_RELSZ || entry[i] == BN_LIB_DT_PLTRELSZ) && entry[i + 1] != 0) {
+      return BN_LIB_FORMAT_ERROR;
+    }
+  }
+  return CKB_SUCCESS;
+}
+
+/*
+ * @dev load bn library cell into bn_lib_code
+ * executable segments by load_cell_data_as_code, others by load_cell_data
+ * segments should be page aligned and in BN_LIB_CODE_SIZE
+ */
+
+static int load_bn_lib_segments(size_t index, udtswap_bn_lib_entry *entry) {
+  bn_lib_elf_header_t header;
+  bn_lib_elf_program_header_t program_headers[BN_LIB_MAX_SEGMENTS];
+  uint64_t len = BN_LIB_ELF_HEADER_SIZE;
+  size_t i;
+  int ret = ckb_load_cell_data((uint8_t *)&header, &len, 0, index, CKB_SOURCE_CELL_DEP);
+  if (ret != CKB_SUCCESS) {
+    return UDTSWAP_SYSCALL_ERROR - ret;
+  }
+  if (len < BN_LIB_ELF_HEADER_SIZE
+    || memcmp(header.ident, "\x7f" "ELF", 4) != 0
+    || header.ident[4] != 2
+    || header.type != BN_LIB_ELF_TYPE_DYN
+    || header.machine != BN_LIB_ELF_MACHINE
+    || header.phentsize != BN_LIB_ELF_PROGRAM_HEADER_SIZE
+    || header.phnum > BN_LIB_MAX_SEGMENTS
+    || header.entry >= BN_LIB_CODE_SIZE) {
+    return BN_LIB_FORMAT_ERROR;
+  }
+  //64 bit shared object of script machine
+
+  len = header.phnum * BN_LIB_ELF_PROGRAM_HEADER_SIZE;
+  ret = ckb_load_cell_data((uint8_t *)program_headers, &len, header.phoff, index, CKB_SOURCE_CELL_DEP);
+  if (ret != CKB_SUCCESS) {
+    return UDTSWAP_SYSCALL_ERROR - ret;
+  }
+  if (len < header.phnum * BN_LIB_ELF_PROGRAM_HEADER_SIZE) {
+    return BN_LIB_FORMAT_ERROR;
+  }
+
+  for (i = 0; i < header.phnum; i++) {
+    bn_lib_elf_program_header_t *ph = &program_headers[i];
+    if (ph->type != BN_LIB_PT_LOAD || ph->memsz == 0) {
+      continue;
+    }
+    if (ph->filesz > ph->memsz
+      || ph->memsz > BN_LIB_CODE_SIZE
+      || ph->vaddr > BN_LIB_CODE_SIZE - ph->memsz
+      || ph->offset % BN_LIB_PAGE_SIZE != ph->vaddr % BN_LIB_PAGE_SIZE) {
+      return BN_LIB_FORMAT_ERROR;
+    }
+    if (ph->flags & BN_LIB_PF_X) {
+      if (ph->flags & BN_LIB_PF_W) {
+        return BN_LIB_FORMAT_ERROR;
+      }
+      uint64_t page_offset = ph->vaddr % BN_LIB_PAGE_SIZE;
+      uint64_t memory_size = (page_offset + ph->memsz + BN_LIB_PAGE_SIZE - 1) / BN_LIB_PAGE_SIZE * BN_LIB_PAGE_SIZE;
+      ret = ckb_load_cell_code(
+        &bn_lib_code[ph->vaddr - page_offset],
+        memory_size,
+        ph->offset - page_offset,
+        ph->filesz + page_offset,
+        index,
+        CKB_SOURCE_CELL_DEP
+      );
+      if (ret != CKB_SUCCESS) {
+        return UDTSWAP_SYSCALL_ERROR - ret;
+      }
+    } else {
+      len = ph->filesz;
+      ret = ckb_load_cell_data(&bn_lib_code[ph->vaddr], &len, ph->offset, index, CKB_SOURCE_CELL_DEP);
+      if (ret != CKB_SUCCESS) {
+        return UDTSWAP_SYSCALL_ERROR - ret;
+      }
+      if (len < ph->filesz) {
+        return BN_LIB_FORMAT_ERROR;
+      }
+    }
+  }
+  //bss of segments is zero in bn_lib_code
+
+  for (i = 0; i < header.phnum; i++) {
+    if (program_headers[i].type == BN_LIB_PT_DYNAMIC) {
+      ret = check_bn_lib_dynamic(&program_headers[i]);
+      if (ret != CKB_SUCCESS) {
+        return ret;
+      }
+    }
+  }
+  //library is not relocated
+
+  *entry = (udtswap_bn_lib_entry)&bn_lib_code[header.entry];
+  return CKB_SUCCESS;
+}
+
+/*
+ * @dev load bn library and its function table
+ * native build of UDTswap_tools also links bn_lib statically,
+ * its entry is called when transaction has no bn library cell dep
+ */
+
+static int load_bn_lib() {
+  udtswap_bn_lib_entry entry;
+  size_t index = 0;
+  int ret = find_bn_lib(&index);
+  if (ret == CKB_SUCCESS) {
+    ret = load_bn_lib_segments(index, &entry);
+  }
+#ifdef CKB_SYSCALLS_MOCK
+  else if (ret == BN_LIB_NOT_FOUND_ERROR) {
+    entry = udtswap_bn_lib_init;
+    ret = CKB_SUCCESS;
+  }
+#endif
+  if (ret != CKB_SUCCESS) {
+    return ret;
+  }
+  if (entry(&udtswap_bn_lib, sizeof(udtswap_bn_lib)) < UDTSWAP_BN_LIB_VERSION) {
+    return BN_LIB_VERSION_ERROR;
+  }
+  return CKB_SUCCESS;
+}
+
+static inline udtswap_bn_lib_t *udtswap_bn() {
+  if (udtswap_bn_lib_loaded != BN_LIB_LOAD_ID) {
+    int ret = load_bn_lib();
+    if (ret != CKB_SUCCESS) {
+      ckb_exit(ret);
+    }
+    udtswap_bn_lib_loaded = BN_LIB_LOAD_ID;
+  }
+  return &udtswap_bn_lib;
+}
+
+#define bignum_init(n) (udtswap_bn()->init(n))
+#define bignum_from_uint64_t(n, i) (udtswap_bn()->from_uint64_t(n, i))
+#define bignum_to_uint64_t(n) (udtswap_bn()->to_uint64_t(n))
+#define bignum_add(a, b, c) (udtswap_bn()->add(a, b, c))
+#define bignum_sub(a, b, c) (udtswap_bn()->sub(a, b, c))
+#define bignum_mul(a, b, c) (udtswap_bn()->mul(a, b, c))
+#define bignum_div(a, b, c) (udtswap_bn()->div(a, b, c))
+#define bignum_or(a, b, c) (udtswap_bn()->or(a, b, c))
+#define bignum_cmp(a, b) (udtswap_bn()->cmp(a, b))
+#define bignum_is_zero(n) (udtswap_bn()->is_zero(n))
+#define bignum_assign(dst, src) (udtswap_bn()->assign(dst, src))
+#define _lshift_word(a, nwords) (udtswap_bn()->lshift_word(a, nwords))
+
+#endif /* UDTSWAP_BN_DYNAMIC */
+
+#endif /* UDTSWAP_BN_H_ */
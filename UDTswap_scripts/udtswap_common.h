@@ -1,3 +1,6 @@
+#ifndef UDTSWAP_COMMON_H_
+#define UDTSWAP_COMMON_H_
+
 #define SCRIPT_SIZE 32768
 #define INPUT_SIZE 128
 
@@ -21,6 +24,16 @@
 #define UDTSWAP_DATA_UDT1_RESERVE_START 0
 #define UDTSWAP_DATA_UDT2_RESERVE_START 16
 #define UDTSWAP_DATA_TOTAL_LIQUIDITY_START 32
+#define UDTSWAP_EXTENDED_DATA_SIZE 120
+#define UDTSWAP_DATA_EXTENSION_SIZE 72
+#define UDTSWAP_DATA_PRICE1_CUMULATIVE_START 48
+#define UDTSWAP_DATA_PRICE2_CUMULATIVE_START 80
+#define UDTSWAP_DATA_LAST_UPDATE_START 112
+#define PRICE_CUMULATIVE_SIZE 32
+#define PRICE_RESOLUTION_WORDS 2
+#define BLOCK_NUMBER_SIZE 8
+#define HEADER_SIZE 208
+#define UDTSWAP_HEADER_DEP_INDEX 0
 #define CODE_HASH_START 16
 #define ARGS_START 53
 #define UDTSWAP_LOCK_ARGS_UDT1_SCRIPT_HASH_START 53
@@ -28,6 +41,14 @@
 #define ADD_LIQUIDITY_CELL_INDEX 4
 #define REMOVE_LIQUIDITY_CELL_START_INDEX 3
 #define TX_INPUT_SIZE 44
+#define SWAP_MODE_AUTO 0
+#define SWAP_MODE_EXACT_INPUT 1
+#define SWAP_MODE_EXACT_OUTPUT 2
+#define SWAP_MODE_WITNESS_SIZE 64
+#define UDTSWAP_PAIR_UDT_UDT 0
+#define UDTSWAP_PAIR_CKB_UDT 1
+#define UDTSWAP_PAIR_UDT_CKB 2
+#define UDTSWAP_PAIR_CKB_CKB 3
 
 #define UDTSWAP_NOT_MATCH_ERROR -70
 #define LIQUIDITY_TRANSFER_NOT_CORRECT_ERROR -71
@@ -62,11 +83,17 @@
 #define TX_INPUT_NOT_MATCH_ERROR -100
 #define ADD_LIQUIDITY_TOO_LOW_ERROR -101
 #define SAME_UDT_OR_ORDER_ERROR -102
+#define PRICE_CUMULATIVE_NOT_CORRECT_ERROR -103
+#define LAST_UPDATE_NOT_CORRECT_ERROR -104
 #define CANNOT_UNLOCK_ERROR -105
 #define UDTSWAP_LIQUIDITY_UDT_ZERO_AMOUNT_ERROR -106
 #define OVERFLOW_ERROR -107
 #define UDTSWAP_LIQUIDITY_UDT_INPUT_OUTPUT_NOT_MATCH_ERROR -108
 #define UDTSWAP_SYSCALL_ERROR -109
+#define UDTSWAP_ROLE_NOT_MATCH_ERROR -110
+#define BN_LIB_NOT_FOUND_ERROR -111
+#define BN_LIB_FORMAT_ERROR -112
+#define BN_LIB_VERSION_ERROR -113
 
 #define UDTSWAP_LIQUIDITY_UDT_ERROR_IDX 50
 #define UDTSWAP_LOCK_ERROR_IDX 100
@@ -77,17 +104,20 @@
 
 typedef unsigned __int128 uint128_t;
 
-const uint8_t udtswap_type_script_code_hash_buf[CODE_HASH_SIZE] = {213, 74, 170, 34, 165, 219, 212, 78, 219, 55, 145, 1, 8, 30, 95, 70, 201, 189, 142, 245, 196, 17, 212, 128, 237, 137, 224, 14, 85, 13, 177, 206}; //udtswap type script code hash
-const uint8_t udtswap_lock_code_hash_buf[CODE_HASH_SIZE] = {132, 146, 227, 69, 240, 102, 105, 229, 197, 113, 211, 113, 94, 225, 64, 215, 115, 184, 211, 131, 38, 148, 117, 6, 244, 25, 223, 49, 159, 161, 127, 103};
-const uint8_t udtswap_liquidity_udt_code_hash_buf[CODE_HASH_SIZE] = {90, 162, 157, 161, 164, 73, 172, 223, 105, 52, 27, 169, 162, 12, 156, 82, 121, 27, 36, 241, 4, 153, 154, 186, 75, 98, 160, 69, 221, 190, 10, 135};
-const uint8_t fee_lock_hash[SCRIPT_HASH_SIZE] = {226, 95, 206, 237, 187, 115, 204, 92, 253, 92, 45, 123, 9, 230, 209, 27, 63, 57, 251, 188, 95, 116, 36, 162, 221, 246, 233, 126, 185, 23, 95, 137}; //state fee lock hash
-const uint8_t udt_type_ckb_script_hash_buf[SCRIPT_HASH_SIZE] = {0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0}; //ckb type script hash
+static const uint8_t udtswap_type_script_code_hash_buf[CODE_HASH_SIZE] = {213, 74, 170, 34, 165, 219, 212, 78, 219, 55, 145, 1, 8, 30, 95, 70, 201, 189, 142, 245, 196, 17, 212, 128, 237, 137, 224, 14, 85, 13, 177, 206}; //udtswap type script code hash
+static const uint8_t udtswap_lock_code_hash_buf[CODE_HASH_SIZE] = {132, 146, 227, 69, 240, 102, 105, 229, 197, 113, 211, 113, 94, 225, 64, 215, 115, 184, 211, 131, 38, 148, 117, 6, 244, 25, 223, 49, 159, 161, 127, 103};
+static const uint8_t udtswap_liquidity_udt_code_hash_buf[CODE_HASH_SIZE] = {90, 162, 157, 161, 164, 73, 172, 223, 105, 52, 27, 169, 162, 12, 156, 82, 121, 27, 36, 241, 4, 153, 154, 186, 75, 98, 160, 69, 221, 190, 10, 135};
+static const uint8_t udtswap_bn_lib_code_hash_buf[SCRIPT_HASH_SIZE] = {0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0};
+static const uint8_t fee_lock_hash[SCRIPT_HASH_SIZE] = {226, 95, 206, 237, 187, 115, 204, 92, 253, 92, 45, 123, 9, 230, 209, 27, 63, 57, 251, 188, 95, 116, 36, 162, 221, 246, 233, 126, 185, 23, 95, 137}; //state fee lock hash
+static const uint8_t udt_type_ckb_script_hash_buf[SCRIPT_HASH_SIZE] = {0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0}; //ckb type script hash
 
-uint128_t get_uint128_t(int from, uint8_t arr[]) {
+static inline uint128_t get_uint128_t(int from, uint8_t arr[]) {
   uint128_t ret=0;
   int i=0;
   for (i=0; i<UDT_AMOUNT_SIZE; i++) {
     ret += (uint128_t)arr[from+i] << (8*i);
   }
   return ret;
-}
\ No newline at end of file
+}
+
+#endif /* UDTSWAP_COMMON_H_ */
@@ -0,0 +1,262 @@
+#ifndef UDTSWAP_FORMULA_H_
+#define UDTSWAP_FORMULA_H_
+
+/*
+ * @dev UDTswap formulas of swap, add liquidity and remove liquidity
+ *
+ * type script checks amounts of transaction by these formulas,
+ * quote library of UDTswap_tools computes amounts for transaction builders by same formulas
+ * reserves are actual reserves (except empty pool reserve), results are bn of full precision
+ * include after udtswap_common.h and udtswap_bn.h
+ */
+
+static inline void uint128_t_to_bignum(uint128_t temp, struct bn *ret) {
+  struct bn temp1, temp2;
+
+  bignum_init(&temp1);
+  bignum_init(&temp2);
+  bignum_init(ret);
+  bignum_from_uint64_t(&temp1, temp & 0xffffffffffffffff);
+  bignum_from_uint64_t(&temp2, (temp >> 64) & 0xffffffffffffffff);
+  _lshift_word(&temp2, 2);
+
+  bignum_add(&temp1, &temp2, ret);
+}
+
+static inline uint128_t bignum_to_uint128_t(struct bn *temp) {
+  uint128_t ret = 0;
+  ret += temp->array[0];
+  ret += (uint128_t)temp->array[1] << 32;
+  ret += (uint128_t)temp->array[2] << 64;
+  ret += (uint128_t)temp->array[3] << 96;
+  return ret;
+}
+
+/*
+ * @dev second udt amount and liquidity of adding liquidity
+ * second udt amount = second udt reserve * first udt amount / first udt reserve + 1
+ * liquidity = total liquidity * first udt amount / first udt reserve
+ *
+ * @param u_r1 first udt reserve before adding liquidity
+ * @param u_r2 second udt reserve before adding liquidity
+ * @param t_l total liquidity before adding liquidity
+ * @param u_a1 first udt amount to add
+ * @param udt2_amount second udt amount to add
+ * @param user_liquidity liquidity to receive
+ */
+static inline int udtswap_add_liquidity_amounts(
+  uint128_t u_r1,
+  uint128_t u_r2,
+  uint128_t t_l,
+  uint128_t u_a1,
+  struct bn *udt2_amount,
+  struct bn *user_liquidity
+) {
+  struct bn
+    temp2,
+    temp3,
+    udt1_reserve,
+    udt2_reserve,
+    udt1_amount,
+    total_liquidity,
+    one
+  ;
+
+  bignum_init(&temp2);
+  bignum_init(&temp3);
+  bignum_init(&udt1_reserve);
+  bignum_init(&udt2_reserve);
+  bignum_init(&udt1_amount);
+  bignum_init(&total_liquidity);
+  bignum_init(&one);
+
+  uint128_t_to_bignum(u_r1, &udt1_reserve);
+  uint128_t_to_bignum(u_r2, &udt2_reserve);
+  uint128_t_to_bignum(u_a1, &udt1_amount);
+  uint128_t_to_bignum(t_l, &total_liquidity);
+
+  bignum_from_uint64_t(&one, 0x0000000000000001);
+
+  bignum_mul(&udt2_reserve, &udt1_amount, &temp2);
+  if (bignum_is_zero(&udt1_reserve) == 1) {
+    return DIVIDE_ZERO_ERROR;
+  }
+  bignum_div(&temp2, &udt1_reserve, &temp3);
+  bignum_add(&temp3, &one, udt2_amount);
+  //udt amount to add liquidity
+
+  bignum_mul(&total_liquidity, &udt1_amount, &temp2);
+  bignum_div(&temp2, &udt1_reserve, user_liquidity); //already checked above
+  //user's liquidity amount
+  return CKB_SUCCESS;
+}
+
+/*
+ * @dev udt amounts of removing liquidity
+ * udt amount = liquidity * udt reserve / total liquidity
+ *
+ * @param u_r1 first udt reserve before removing liquidity
+ * @param u_r2 second udt reserve before removing liquidity
+ * @param t_l total liquidity before removing liquidity
+ * @param l liquidity to remove
+ * @param udt1_amount first udt amount to receive
+ * @param udt2_amount second udt amount to receive
+ */
+static inline int udtswap_remove_liquidity_amounts(
+  uint128_t u_r1,
+  uint128_t u_r2,
+  uint128_t t_l,
+  uint128_t l,
+  struct bn *udt1_amount,
+  struct bn *udt2_amount
+) {
+  struct bn
+    temp2,
+    udt1_reserve,
+    udt2_reserve,
+    user_liquidity,
+    total_liquidity
+  ;
+
+  bignum_init(&temp2);
+  bignum_init(&udt1_reserve);
+  bignum_init(&udt2_reserve);
+  bignum_init(&user_liquidity);
+  bignum_init(&total_liquidity);
+
+  uint128_t_to_bignum(u_r1, &udt1_reserve);
+  uint128_t_to_bignum(u_r2, &udt2_reserve);
+  uint128_t_to_bignum(l, &user_liquidity);
+  uint128_t_to_bignum(t_l, &total_liquidity);
+
+  bignum_mul(&user_liquidity, &udt2_reserve, &temp2);
+  if (bignum_is_zero(&total_liquidity) == 1) {
+    return DIVIDE_ZERO_ERROR;
+  }
+  bignum_div(&temp2, &total_liquidity, udt2_amount);
+  //udt amount to receive
+
+  bignum_mul(&user_liquidity, &udt1_reserve, &temp2);
+  bignum_div(&temp2, &total_liquidity, udt1_amount); //already checked above
+  //ckb amount to receive
+  return CKB_SUCCESS;
+}
+
+/*
+ * @dev input amount of swapping by output amount
+ * input amount = input reserve * output amount * 1000 / (output reserve - output amount) * 997 + 1
+ *
+ * @param i_r input udt reserve before swapping
+ * @param o_r output udt reserve before swapping
+ * @param o_a output amount
+ * @param input_amount input amount
+ */
+static inline int udtswap_swap_input_amount(
+  uint128_t i_r,
+  uint128_t o_r,
+  uint128_t o_a,
+  struct bn *input_amount
+) {
+  struct bn
+    temp2,
+    temp3,
+    temp4,
+    temp5,
+    output_amount,
+    input_reserve,
+    output_reserve,
+    thousand,
+    except_fee,
+    one
+  ;
+
+  bignum_init(&temp2);
+  bignum_init(&temp3);
+  bignum_init(&temp4);
+  bignum_init(&temp5);
+  bignum_init(&input_reserve);
+  bignum_init(&output_amount);
+  bignum_init(&output_reserve);
+  bignum_init(&thousand);
+  bignum_init(&except_fee);
+  bignum_init(&one);
+
+  uint128_t_to_bignum(i_r, &input_reserve);
+  uint128_t_to_bignum(o_a, &output_amount);
+  uint128_t_to_bignum(o_r, &output_reserve);
+
+  bignum_from_uint64_t(&thousand, 0x00000000000003e8);
+  bignum_from_uint64_t(&except_fee, LIQUIDITY_POOL_EXCEPT_FEE);
+  bignum_from_uint64_t(&one, 0x0000000000000001);
+
+  bignum_mul(&input_reserve, &thousand, &temp2);
+  bignum_mul(&temp2, &output_amount, &temp3);
+  if (bignum_cmp(&output_reserve, &output_amount) == SMALLER) {
+    return SUBTRACT_ERROR;
+  }
+  bignum_sub(&output_reserve, &output_amount, &temp4);
+  bignum_mul(&temp4, &except_fee, &temp5);
+  if (bignum_is_zero(&temp5) == 1) {
+    return DIVIDE_ZERO_ERROR;
+  }
+  bignum_div(&temp3, &temp5, &temp4);
+  bignum_add(&temp4, &one, input_amount);
+  return CKB_SUCCESS;
+}
+
+/*
+ * @dev output amount of swapping by input amount
+ * output amount = input amount * 997 * output reserve / (input reserve * 1000 + input amount * 997)
+ *
+ * @param i_r input udt reserve before swapping
+ * @param o_r output udt reserve before swapping
+ * @param i_a input amount
+ * @param output_amount output amount
+ */
+static inline int udtswap_swap_output_amount(
+  uint128_t i_r,
+  uint128_t o_r,
+  uint128_t i_a,
+  struct bn *output_amount
+) {
+  struct bn
+    temp2,
+    temp3,
+    temp4,
+    temp5,
+    input_amount,
+    input_reserve,
+    output_reserve,
+    thousand,
+    except_fee
+  ;
+
+  bignum_init(&temp2);
+  bignum_init(&temp3);
+  bignum_init(&temp4);
+  bignum_init(&temp5);
+  bignum_init(&input_amount);
+  bignum_init(&input_reserve);
+  bignum_init(&output_reserve);
+  bignum_init(&thousand);
+  bignum_init(&except_fee);
+
+  uint128_t_to_bignum(i_a, &input_amount);
+  uint128_t_to_bignum(i_r, &input_reserve);
+  uint128_t_to_bignum(o_r, &output_reserve);
+
+  bignum_from_uint64_t(&thousand, 0x00000000000003e8);
+  bignum_from_uint64_t(&except_fee, LIQUIDITY_POOL_EXCEPT_FEE);
+
+  bignum_mul(&input_reserve, &thousand, &temp2);
+  bignum_mul(&input_amount, &except_fee, &temp3);
+  bignum_mul(&temp3, &output_reserve, &temp4);
+  bignum_add(&temp2, &temp3, &temp5);
+  if (bignum_is_zero(&temp5) == 1) {
+    return DIVIDE_ZERO_ERROR;
+  }
+  bignum_div(&temp4, &temp5, output_amount);
+  return CKB_SUCCESS;
+}
+
+#endif /* UDTSWAP_FORMULA_H_ */
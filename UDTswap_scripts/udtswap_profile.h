@@ -0,0 +1,118 @@
+#ifndef UDTSWAP_PROFILE_H_
+#define UDTSWAP_PROFILE_H_
+
+/*
+ * @dev per-phase cycles of instrumentation build (-DUDTSWAP_PROFILE)
+ *
+ * PROFILE_PHASE(name) starts a phase, cycles until the next phase are added to it
+ * breakdown is written by ckb_debug when main returns
+ * udtswap-profile <script> result=<ret> total=<cycles> <phase>=<cycles>/<count> ...
+ * include after ckb_syscalls.h with UDTSWAP_PROFILE_NAME defined
+ * release build has no profile code
+ */
+#ifdef UDTSWAP_PROFILE
+
+#ifdef main
+#error "UDTSWAP_PROFILE build should not rename main"
+#endif
+
+#define PROFILE_PHASE_MAX 16
+#define PROFILE_LINE_SIZE 512
+
+static const char *profile_names[PROFILE_PHASE_MAX];
+static uint64_t profile_cycles[PROFILE_PHASE_MAX];
+static uint32_t profile_counts[PROFILE_PHASE_MAX];
+static size_t profile_phase_cnt = 0;
+static int profile_current = -1;
+static uint64_t profile_phase_start = 0;
+
+static void profile_phase(const char *name) {
+  uint64_t now = ckb_current_cycles();
+  size_t i;
+  if (profile_current >= 0) {
+    profile_cycles[profile_current] += now - profile_phase_start;
+  }
+  profile_current = -1;
+  profile_phase_start = now;
+  if (name == NULL) {
+    return;
+  }
+  for (i = 0; i < profile_phase_cnt; i++) {
+    if (strcmp(profile_names[i], name) == 0) {
+      break;
+    }
+  }
+  if (i == profile_phase_cnt) {
+    if (profile_phase_cnt == PROFILE_PHASE_MAX) {
+      return;
+    }
+    profile_names[profile_phase_cnt++] = name;
+  }
+  profile_counts[i] += 1;
+  profile_current = (int)i;
+}
+
+static size_t profile_append(char *line, size_t pos, const char *s) {
+  while (*s != '\0' && pos + 1 < PROFILE_LINE_SIZE) {
+    line[pos++] = *s++;
+  }
+  line[pos] = '\0';
+  return pos;
+}
+
+static size_t profile_append_number(char *line, size_t pos, int64_t v) {
+  char buf[24];
+  size_t len = 0;
+  uint64_t u = v < 0 ? (uint64_t)(-v) : (uint64_t)v;
+  do {
+    buf[len++] = '0' + (u % 10);
+    u /= 10;
+  } while (u > 0);
+  if (v < 0) {
+    buf[len++] = '-';
+  }
+  while (len > 0 && pos + 1 < PROFILE_LINE_SIZE) {
+    line[pos++] = buf[--len];
+  }
+  line[pos] = '\0';
+  return pos;
+}
+
+static void profile_report(int ret, uint64_t total) {
+  char line[PROFILE_LINE_SIZE];
+  size_t i, pos = 0;
+  pos = profile_append(line, pos, "udtswap-profile " UDTSWAP_PROFILE_NAME " result=");
+  pos = profile_append_number(line, pos, ret);
+  pos = profile_append(line, pos, " total=");
+  pos = profile_append_number(line, pos, (int64_t)total);
+  for (i = 0; i < profile_phase_cnt; i++) {
+    pos = profile_append(line, pos, " ");
+    pos = profile_append(line, pos, profile_names[i]);
+    pos = profile_append(line, pos, "=");
+    pos = profile_append_number(line, pos, (int64_t)profile_cycles[i]);
+    pos = profile_append(line, pos, "/");
+    pos = profile_append_number(line, pos, profile_counts[i]);
+  }
+  ckb_debug(line);
+}
+
+int udtswap_profiled_main(int argc, char* argv[]);
+
+int main(int argc, char* argv[]) {
+  uint64_t start = ckb_current_cycles();
+  int ret = udtswap_profiled_main(argc, argv);
+  profile_phase(NULL);
+  profile_report(ret, ckb_current_cycles() - start);
+  return ret;
+}
+
+#define main udtswap_profiled_main
+#define PROFILE_PHASE(name) profile_phase(name)
+
+#else
+
+#define PROFILE_PHASE(name)
+
+#endif /* UDTSWAP_PROFILE */
+
+#endif /* UDTSWAP_PROFILE_H_ */
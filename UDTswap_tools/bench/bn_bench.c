@@ -0,0 +1,242 @@
+/*
+ * bn.c primitive benchmark
+ * host build prints ns/op as json lines, BN_BENCH_VM build runs one primitive
+ * for ckb-debugger and bn_vm.sh takes cycles/op from the iteration difference
+ */
+#include <stdint.h>
+#include <string.h>
+#include "../../UDTswap_scripts/bn.h"
+
+typedef unsigned __int128 uint128_t;
+
+#define BN_BENCH_OPERANDS 64
+
+#define BN_BENCH_OP_ADD 0
+#define BN_BENCH_OP_SUB 1
+#define BN_BENCH_OP_MUL 2
+#define BN_BENCH_OP_DIV 3
+#define BN_BENCH_OP_CMP 4
+#define BN_BENCH_OP_FROM_U128 5
+#define BN_BENCH_OP_TO_U128 6
+#define BN_BENCH_OP_CNT 7
+
+#define BN_BENCH_DIST_CAPACITY 0
+#define BN_BENCH_DIST_AMOUNT 1
+#define BN_BENCH_DIST_NEAR_OVERFLOW 2
+#define BN_BENCH_DIST_CNT 3
+
+static const char *op_names[BN_BENCH_OP_CNT] = {"add", "sub", "mul", "div", "cmp", "from_u128", "to_u128"};
+static const char *dist_names[BN_BENCH_DIST_CNT] = {"capacity64", "amount128", "near_overflow"};
+
+static struct bn operand_a[BN_BENCH_OPERANDS];
+static struct bn operand_b[BN_BENCH_OPERANDS];
+static uint128_t operand_u128[BN_BENCH_OPERANDS];
+static volatile uint32_t sink;
+
+/*
+ * same conversions as UDTswap_udt_based.c
+ */
+static void uint128_t_to_bignum(uint128_t temp, struct bn *ret) {
+  struct bn temp1, temp2;
+
+  bignum_init(&temp1);
+  bignum_init(&temp2);
+  bignum_init(ret);
+  bignum_from_uint64_t(&temp1, temp & 0xffffffffffffffff);
+  bignum_from_uint64_t(&temp2, (temp >> 64) & 0xffffffffffffffff);
+  _lshift_word(&temp2, 2);
+
+  bignum_add(&temp1, &temp2, ret);
+}
+
+static uint128_t bignum_to_uint128_t(struct bn *temp) {
+  uint128_t ret = 0;
+  ret += temp->array[0];
+  ret += (uint128_t)temp->array[1] << 32;
+  ret += (uint128_t)temp->array[2] << 64;
+  ret += (uint128_t)temp->array[3] << 96;
+  return ret;
+}
+
+static uint64_t xorshift(uint64_t *state) {
+  uint64_t x = *state;
+  x ^= x << 13;
+  x ^= x >> 7;
+  x ^= x << 17;
+  *state = x;
+  return x;
+}
+
+/*
+ * capacity64 : 61 ~ 2^63 shannons, CKB reserves
+ * amount128 : full 128 bits, UDT reserves and amounts
+ * near_overflow : within 2^32 of 2^128, largest values of UDT amount
+ */
+static uint128_t random_value(int dist, uint64_t *state) {
+  switch (dist) {
+    case BN_BENCH_DIST_CAPACITY:
+      return (uint128_t)(6100000000ULL + (xorshift(state) >> 1));
+    case BN_BENCH_DIST_AMOUNT:
+      return ((uint128_t)xorshift(state) << 64) | xorshift(state);
+    default:
+      return ~(uint128_t)0 - (xorshift(state) >> 32);
+  }
+}
+
+/*
+ * operands of an operation, div divides product of two values as swap formula
+ */
+static void prepare(int op, int dist) {
+  uint64_t state = 0x9e3779b97f4a7c15ULL + (uint64_t)dist;
+  int i;
+  for (i = 0; i < BN_BENCH_OPERANDS; i++) {
+    uint128_t a = random_value(dist, &state);
+    uint128_t b = random_value(dist, &state);
+    if (op == BN_BENCH_OP_SUB && a < b) {
+      uint128_t temp = a;
+      a = b;
+      b = temp;
+    }
+    operand_u128[i] = a;
+    uint128_t_to_bignum(a, &operand_a[i]);
+    uint128_t_to_bignum(b, &operand_b[i]);
+    if (op == BN_BENCH_OP_DIV) {
+      struct bn product, c;
+      uint128_t_to_bignum(random_value(dist, &state) | 1, &c);
+      bignum_mul(&operand_a[i], &operand_b[i], &product);
+      bignum_assign(&operand_a[i], &product);
+      bignum_assign(&operand_b[i], &c);
+    }
+  }
+}
+
+static void run(int op, long iterations) {
+  struct bn result;
+  uint32_t acc = 0;
+  long i;
+  int j = 0;
+  for (i = 0; i < iterations; i++) {
+    switch (op) {
+      case BN_BENCH_OP_ADD:
+        bignum_add(&operand_a[j], &operand_b[j], &result);
+        break;
+      case BN_BENCH_OP_SUB:
+        bignum_sub(&operand_a[j], &operand_b[j], &result);
+        break;
+      case BN_BENCH_OP_MUL:
+        bignum_mul(&operand_a[j], &operand_b[j], &result);
+        break;
+      case BN_BENCH_OP_DIV:
+        bignum_div(&operand_a[j], &operand_b[j], &result);
+        break;
+      case BN_BENCH_OP_CMP:
+        result.array[0] = (DTYPE)bignum_cmp(&operand_a[j], &operand_b[j]);
+        break;
+      case BN_BENCH_OP_FROM_U128:
+        uint128_t_to_bignum(operand_u128[j], &result);
+        break;
+      default:
+        result.array[0] = (DTYPE)bignum_to_uint128_t(&operand_a[j]);
+        break;
+    }
+    acc += result.array[0];
+    j = (j + 1) % BN_BENCH_OPERANDS;
+  }
+  sink = acc;
+}
+
+#ifdef BN_BENCH_VM
+
+static int find_name(const char *names[], int cnt, const char *name) {
+  int i;
+  for (i = 0; i < cnt; i++) {
+    if (strcmp(names[i], name) == 0) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+static long parse_long(const char *s) {
+  long ret = 0;
+  while (*s >= '0' && *s <= '9') {
+    ret = ret * 10 + (*s - '0');
+    s++;
+  }
+  return ret;
+}
+
+/*
+ * bn_bench <op> <dist> <iterations>, operand preparation is same for any iterations
+ */
+int main(int argc, char *argv[]) {
+  if (argc < 4) {
+    return 1;
+  }
+  int op = find_name(op_names, BN_BENCH_OP_CNT, argv[1]);
+  int dist = find_name(dist_names, BN_BENCH_DIST_CNT, argv[2]);
+  if (op < 0 || dist < 0) {
+    return 2;
+  }
+  prepare(op, dist);
+  run(op, parse_long(argv[3]));
+  return 0;
+}
+
+#else
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define BN_BENCH_MIN_NS 200000000.0
+
+static double now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+/*
+ * iterations are doubled until a run takes BN_BENCH_MIN_NS
+ */
+static double measure(int op, long *iterations) {
+  long n = 1024;
+  while (1) {
+    double start = now_ns();
+    run(op, n);
+    double elapsed = now_ns() - start;
+    if (elapsed >= BN_BENCH_MIN_NS || n >= (1L << 40)) {
+      *iterations = n;
+      return elapsed / n;
+    }
+    n *= 2;
+  }
+}
+
+int main(int argc, char *argv[]) {
+  const char *op_filter = argc > 1 ? argv[1] : NULL;
+  const char *dist_filter = argc > 2 ? argv[2] : NULL;
+  int op, dist;
+  for (op = 0; op < BN_BENCH_OP_CNT; op++) {
+    if (op_filter != NULL && strcmp(op_filter, "all") != 0 && strcmp(op_filter, op_names[op]) != 0) {
+      continue;
+    }
+    for (dist = 0; dist < BN_BENCH_DIST_CNT; dist++) {
+      if (dist_filter != NULL && strcmp(dist_filter, dist_names[dist]) != 0) {
+        continue;
+      }
+      long iterations;
+      prepare(op, dist);
+      double ns = measure(op, &iterations);
+      printf(
+        "{\"mode\":\"native\",\"op\":\"%s\",\"dist\":\"%s\",\"iterations\":%ld,\"ns_per_op\":%.2f}\n",
+        op_names[op], dist_names[dist], iterations, ns
+      );
+      fflush(stdout);
+    }
+  }
+  return 0;
+}
+
+#endif /* BN_BENCH_VM */
@@ -0,0 +1,36 @@
+#!/bin/sh
+# Run bn primitive benchmark in ckb-debugger, cycles/op as json lines.
+# cycles of N iterations minus cycles of 0 iteration, divided by N
+# usage: bn_vm.sh <riscv bn_bench binary>
+
+BIN=${1:-./build/bench/bin/bn_bench}
+CKB_DEBUGGER=${CKB_DEBUGGER:-ckb-debugger}
+ITERATIONS=${BN_BENCH_ITERATIONS:-1000}
+OPS=${BN_BENCH_OPS:-"add sub mul div cmp from_u128 to_u128"}
+DISTS="capacity64 amount128 near_overflow"
+
+if ! command -v "$CKB_DEBUGGER" > /dev/null 2>&1; then
+  echo "ckb-debugger not found, set CKB_DEBUGGER" >&2
+  exit 1
+fi
+
+# cycles <op> <dist> <iterations>
+cycles() {
+  output=`"$CKB_DEBUGGER" --bin "$BIN" "$1" "$2" "$3" 2>&1`
+  result=`echo "$output" | sed -n 's/^Run result: *\(-\{0,1\}[0-9]*\).*/\1/p' | head -n 1`
+  if [ "$result" != "0" ]; then
+    echo "$1 $2 failed: $output" >&2
+    exit 1
+  fi
+  echo "$output" | sed -n 's/^\(Total cycles consumed\|All cycles\): *\([0-9,]*\).*/\2/p' | head -n 1 | tr -d ','
+}
+
+for op in $OPS; do
+  for dist in $DISTS; do
+    base=`cycles $op $dist 0` || exit 1
+    total=`cycles $op $dist $ITERATIONS` || exit 1
+    awk -v op=$op -v dist=$dist -v n=$ITERATIONS -v base=$base -v total=$total 'BEGIN {
+      printf "{\"mode\":\"vm\",\"op\":\"%s\",\"dist\":\"%s\",\"iterations\":%d,\"cycles_per_op\":%.2f}\n", op, dist, n, (total - base) / n
+    }'
+  done
+done
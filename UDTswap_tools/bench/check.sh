@@ -0,0 +1,71 @@
+#!/bin/sh
+# Compare cycles of cycles.sh and script binary sizes with baseline.
+# usage: check.sh <cycles.tsv> <script dir> <release dir> <baseline> [update]
+# sizes are of the plain scripts of bench and of the stripped Os release build which is deployed
+# fails when an entry is more than CHECK_THRESHOLD percent (default 1) above baseline,
+# when the baseline has no entries, or when an entry is only in the results or only in the baseline
+
+RESULT=${1:-./build/bench/cycles.tsv}
+BIN_DIR=${2:-./build/bench/bin}
+RELEASE_DIR=${3:-./build/variants/Os/bin}
+BASELINE=${4:-./bench/baseline.tsv}
+THRESHOLD=${CHECK_THRESHOLD:-1}
+SCRIPTS="UDTswap_udt_based UDTswap_lock_udt_based UDTswap_liquidity_UDT_udt_based"
+
+if [ ! -f "$RESULT" ]; then
+  echo "$RESULT not found, run cycles.sh" >&2
+  exit 1
+fi
+
+CURRENT=`mktemp`
+trap 'rm -f "$CURRENT"' EXIT
+
+# cycles of each script group, binary size of each script of both builds
+awk -F '\t' 'NR > 1 { printf "cycles\t%s/%s/%s\t%s\n", $1, $2, $4, $6 }' "$RESULT" > "$CURRENT"
+for build in "plain:$BIN_DIR" "Os:$RELEASE_DIR"; do
+  dir=${build#*:}
+  for script in $SCRIPTS; do
+    if [ ! -f "$dir/$script" ]; then
+      echo "$dir/$script not found" >&2
+      exit 1
+    fi
+    printf "size\t%s/%s\t%s\n" "${build%%:*}" "$script" `wc -c < "$dir/$script"` >> "$CURRENT"
+  done
+done
+
+if [ "$5" = "update" ]; then
+  head -n 2 "$BASELINE" > "$BASELINE.new"
+  cat "$CURRENT" >> "$BASELINE.new"
+  mv "$BASELINE.new" "$BASELINE"
+  echo "`wc -l < "$CURRENT"` entries written to $BASELINE"
+  exit 0
+fi
+
+if ! grep -qv '^#' "$BASELINE" 2>/dev/null; then
+  echo "$BASELINE has no entries, run make check-update and commit it" >&2
+  exit 1
+fi
+
+awk -F '\t' -v threshold="$THRESHOLD" '
+  FNR == NR { if ($0 !~ /^#/) base[$1 "\t" $2] = $3; next }
+  {
+    key = $1 "\t" $2
+    if (!(key in base)) { missing += 1; next }
+    seen[key] = 1
+    ratio = base[key] > 0 ? 100 * ($3 - base[key]) / base[key] : ($3 > 0 ? 100 : 0)
+    if (ratio > threshold) {
+      printf "REGRESSED %-6s %-48s %14d -> %14d (%+.2f%%)\n", $1, $2, base[key], $3, ratio
+      regressed += 1
+    } else if (ratio < -threshold) {
+      printf "improved  %-6s %-48s %14d -> %14d (%+.2f%%)\n", $1, $2, base[key], $3, ratio
+      improved += 1
+    }
+    checked += 1
+  }
+  END {
+    for (key in base) if (!(key in seen)) removed += 1
+    printf "%d checked, %d regressed, %d improved, %d not in baseline, %d only in baseline (threshold %s%%)\n", checked, regressed, improved, missing, removed, threshold
+    if (missing > 0 || removed > 0 || improved > 0) print "run make check-update to record the current results as baseline"
+    exit regressed > 0 || missing > 0 || removed > 0 ? 1 : 0
+  }
+' "$BASELINE" "$CURRENT"
@@ -0,0 +1,82 @@
+#!/bin/sh
+# Run every UDTswap transaction shape through ckb-debugger and print consumed cycles.
+# usage: cycles.sh <fixture tool> <script dir> <output dir>
+# FIXTURE_ARGS are added to every transaction, -u for unified script
+
+FIXTURE=${1:-./build/udtswap_fixture}
+BIN_DIR=${2:-./build/bench/bin}
+OUT_DIR=${3:-./build/bench}
+CKB_DEBUGGER=${CKB_DEBUGGER:-ckb-debugger}
+MAX_CYCLES=${MAX_CYCLES:-3500000000}
+SWAP_POOLS=${SWAP_POOLS:-"1 2 3 4 5 6 7 8 9 10 11 12 13 14 15 16"}
+
+if ! command -v "$CKB_DEBUGGER" > /dev/null 2>&1; then
+  echo "ckb-debugger not found, set CKB_DEBUGGER" >&2
+  exit 1
+fi
+
+mkdir -p "$OUT_DIR/tx"
+RESULT="$OUT_DIR/cycles.tsv"
+LOG="$OUT_DIR/debugger.log"
+printf "shape\tscript\tgroup\tcell\tresult\tcycles\n" > "$RESULT"
+: > "$LOG"
+failed=0
+
+# run_script <shape> <tx file> <name> <group type> <cell type> <cell index>
+run_script() {
+  output=`"$CKB_DEBUGGER" --tx-file "$2" --script-group-type "$4" --cell-type "$5" --cell-index "$6" 2>&1`
+  printf "== %s %s %s:%s\n%s\n" "$1" "$3" "$5" "$6" "$output" >> "$LOG"
+  result=`echo "$output" | sed -n 's/^Run result: *\(-\{0,1\}[0-9]*\).*/\1/p' | head -n 1`
+  cycles=`echo "$output" | sed -n 's/^\(Total cycles consumed\|All cycles\): *\([0-9,]*\).*/\2/p' | head -n 1 | tr -d ','`
+  [ -z "$result" ] && result="error"
+  [ -z "$cycles" ] && cycles=0
+  [ "$result" != "0" ] && failed=1
+  printf "%s\t%s\t%s\t%s\t%s\t%s\n" "$1" "$3" "$4" "$5:$6" "$result" "$cycles" >> "$RESULT"
+}
+
+# run_shape <shape name> <fixture arguments>
+run_shape() {
+  name=$1
+  shift
+  tx="$OUT_DIR/tx/$name.json"
+  "$FIXTURE" "$@" $FIXTURE_ARGS -b "$BIN_DIR" -o "$tx" || { failed=1; return; }
+  pools=1
+  [ "$1" = "swap" ] && pools=`echo "$@" | sed -n 's/.*-n \([0-9]*\).*/\1/p'`
+  "$FIXTURE" groups "$1" -n "${pools:-1}" | while read script group cell index; do
+    run_script "$name" "$tx" "$script" "$group" "$cell" "$index"
+  done
+}
+
+for pair in ckb-udt udt-udt; do
+  for data in legacy extended; do
+    ext=""
+    [ "$data" = "extended" ] && ext="-x"
+    run_shape "create-$pair-$data" create -p $pair $ext
+    run_shape "add-$pair-$data" add -p $pair $ext
+    run_shape "remove-$pair-$data" remove -p $pair $ext
+    for n in $SWAP_POOLS; do
+      run_shape "swap$n-$pair-$data" swap -p $pair -n $n $ext
+    done
+  done
+done
+
+awk -F '\t' -v max="$MAX_CYCLES" '
+  NR == 1 { next }
+  {
+    printf "%-28s %-10s %-12s %8s %14s\n", $1, $2, $4, $5, $6
+    total[$1] += $6
+    if (!($1 in seen)) { seen[$1] = 1; order[++n] = $1 }
+  }
+  END {
+    print ""
+    printf "%-28s %14s %10s\n", "transaction", "cycles", "of limit"
+    for (i = 1; i <= n; i++) {
+      printf "%-28s %14d %9.4f%%\n", order[i], total[order[i]], 100 * total[order[i]] / max
+    }
+  }
+' "$RESULT"
+
+if grep -q "	error	\|	-[0-9]*	" "$RESULT"; then
+  failed=1
+fi
+exit $failed
@@ -0,0 +1,522 @@
+/*
+ * worst case cost search of UDTswap transactions
+ * pool reserves, amounts, directions, swap mode and pool count are mutated from the most costly case
+ * every script group should return 0 in native build, cost is min ns of native runs or cycles of ckb-debugger
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "../../UDTswap_scripts/ckb_consts.h"
+#include "../native.h"
+#include "../../UDTswap_scripts/udtswap_common.h"
+
+#define FUZZ_SHAPE_CNT (FIXTURE_SHAPE_SWAP + 1)
+#define FUZZ_SCRIPT_CNT (FIXTURE_SCRIPT_LIQUIDITY + 1)
+#define FUZZ_FRESH_RATIO 4
+#define FUZZ_COMMAND_SIZE 1024
+#define FUZZ_MAX_CYCLES 3500000000ULL
+
+typedef struct {
+  int shape;
+  int kind;
+  int extended;
+  int swap_mode;
+  size_t pool_cnt;
+  fixture_pool_t pools[FIXTURE_MAX_POOLS];
+  fixture_u128 amounts[FIXTURE_MAX_POOLS];
+  int directions[FIXTURE_MAX_POOLS];
+} fuzz_case_t;
+
+typedef struct {
+  int valid;
+  uint64_t total;
+  uint64_t scripts[FUZZ_SCRIPT_CNT];
+} fuzz_cost_t;
+
+typedef struct {
+  fuzz_case_t c;
+  uint64_t cost;
+  int found;
+} fuzz_worst_t;
+
+static const char *shape_names[FUZZ_SHAPE_CNT] = {"create", "add", "remove", "swap"};
+static const char *mode_names[] = {"auto", "input", "output"};
+
+static uint64_t rng_state = 0x853c49e6748fea9bULL;
+static fixture_context_t ctx;
+static const char *bin_dir = NULL;
+static const char *debugger = NULL;
+static const char *out_dir = NULL;
+static int runs = 3;
+static size_t max_pools = 8;
+
+static uint64_t next_random(void) {
+  rng_state ^= rng_state >> 12;
+  rng_state ^= rng_state << 25;
+  rng_state ^= rng_state >> 27;
+  return rng_state * 0x2545f4914f6cdd1dULL;
+}
+
+/*
+ * log uniform, powers of two and all ones are picked more
+ */
+static fixture_u128 random_amount(unsigned max_bits) {
+  unsigned bits = 1 + (unsigned)(next_random() % max_bits);
+  fixture_u128 top = (fixture_u128)1 << (bits - 1);
+  fixture_u128 v = ((fixture_u128)next_random() << 64) | next_random();
+  switch (next_random() % 8) {
+    case 0:
+      return top;
+    case 1:
+      return top | (top - 1);
+  }
+  return top | (v & (top - 1));
+}
+
+static fixture_u128 random_below(fixture_u128 limit) {
+  fixture_u128 v = ((fixture_u128)next_random() << 64) | next_random();
+  return limit == 0 ? 0 : v % limit;
+}
+
+static unsigned udt1_bits(int kind) {
+  return kind == FIXTURE_PAIR_CKB_UDT ? 63 : 128;
+}
+//ckb reserve is capacity of pool cell, with CKB_RESERVE_DEFAULT
+
+static void random_pool(fuzz_case_t *c, size_t i) {
+  fixture_pool_t *pool = &c->pools[i];
+  fixture_pool_init(pool, c->kind, (uint32_t)i);
+  pool->udt1_reserve = random_amount(udt1_bits(c->kind));
+  pool->udt2_reserve = random_amount(127);
+  pool->total_liquidity = random_amount(127);
+  pool->extended = c->extended;
+  if (c->extended) {
+    pool->last_update = next_random() % (ctx.block_number + 1);
+    fixture_update_price_cumulative(pool->udt1_reserve, pool->udt2_reserve, pool->last_update, pool->price1_cumulative);
+    fixture_update_price_cumulative(pool->udt2_reserve, pool->udt1_reserve, pool->last_update, pool->price2_cumulative);
+  }
+}
+
+static void random_amount_of(fuzz_case_t *c, size_t i) {
+  const fixture_pool_t *pool = &c->pools[i];
+  switch (c->shape) {
+    case FIXTURE_SHAPE_ADD:
+      c->amounts[i] = random_amount(udt1_bits(c->kind));
+      break;
+    case FIXTURE_SHAPE_REMOVE:
+      c->amounts[i] = 1 + random_below(pool->total_liquidity);
+      break;
+    default:
+      c->amounts[i] = random_amount(127);
+  }
+  c->directions[i] = (int)(next_random() % 2);
+}
+
+static void random_case(fuzz_case_t *c, int shape) {
+  size_t i;
+  memset(c, 0, sizeof(fuzz_case_t));
+  c->shape = shape;
+  c->kind = (int)(next_random() % 2);
+  c->extended = (int)(next_random() % 2);
+  c->swap_mode = (int)(next_random() % 3);
+  c->pool_cnt = shape == FIXTURE_SHAPE_SWAP ? 1 + next_random() % max_pools : 1;
+  for (i = 0; i < c->pool_cnt; i++) {
+    random_pool(c, i);
+    random_amount_of(c, i);
+  }
+}
+
+static fixture_u128 mutate_value(fixture_u128 v, unsigned max_bits) {
+  unsigned bit = (unsigned)(next_random() % max_bits);
+  switch (next_random() % 4) {
+    case 0:
+      return v ^ ((fixture_u128)1 << bit);
+    case 1:
+      return next_random() % 2 ? v >> 1 : v << 1;
+    case 2:
+      return v + ((fixture_u128)1 << bit);
+  }
+  return random_amount(max_bits);
+}
+
+/*
+ * one field of case is changed
+ */
+static void mutate_case(fuzz_case_t *c) {
+  size_t i = next_random() % c->pool_cnt;
+  fixture_pool_t *pool = &c->pools[i];
+  switch (next_random() % 8) {
+    case 0:
+      pool->udt1_reserve = mutate_value(pool->udt1_reserve, udt1_bits(c->kind));
+      break;
+    case 1:
+      pool->udt2_reserve = mutate_value(pool->udt2_reserve, 127);
+      break;
+    case 2:
+      pool->total_liquidity = mutate_value(pool->total_liquidity, 127);
+      break;
+    case 3:
+      c->amounts[i] = mutate_value(c->amounts[i], 127);
+      break;
+    case 4:
+      c->directions[i] ^= 1;
+      break;
+    case 5:
+      c->swap_mode = (int)(next_random() % 3);
+      break;
+    case 6:
+      if (c->shape == FIXTURE_SHAPE_SWAP && c->pool_cnt < max_pools) {
+        c->pools[c->pool_cnt] = c->pools[i];
+        c->pools[c->pool_cnt].pool_id = (uint32_t)c->pool_cnt;
+        c->amounts[c->pool_cnt] = c->amounts[i];
+        c->directions[c->pool_cnt] = c->directions[i];
+        c->pool_cnt += 1;
+      }
+      break;
+    default:
+      random_pool(c, i);
+      random_amount_of(c, i);
+  }
+}
+
+static int build_tx(const fuzz_case_t *c, fixture_tx_t *tx, fixture_context_t *case_ctx) {
+  *case_ctx = ctx;
+  case_ctx->swap_mode = c->swap_mode;
+  fixture_tx_init(tx);
+  if (bin_dir != NULL && fixture_add_code_deps(tx, case_ctx, bin_dir) != 0) {
+    return FIXTURE_ERROR_IO;
+  }
+  switch (c->shape) {
+    case FIXTURE_SHAPE_CREATE:
+      return fixture_create(tx, case_ctx, c->kind, c->extended);
+    case FIXTURE_SHAPE_ADD:
+      return fixture_add_liquidity(tx, case_ctx, &c->pools[0], c->amounts[0]);
+    case FIXTURE_SHAPE_REMOVE:
+      return fixture_remove_liquidity(tx, case_ctx, &c->pools[0], c->amounts[0]);
+  }
+  return fixture_swap(tx, case_ctx, c->pools, c->pool_cnt, c->amounts, c->directions);
+}
+
+static uint64_t now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/*
+ * min ns of native runs, 0 when script group fails
+ */
+static uint64_t native_cost(const fixture_tx_t *tx, const fixture_group_t *group) {
+  uint64_t best = UINT64_MAX;
+  int i;
+  for (i = 0; i < runs; i++) {
+    if (ckb_mock_init(tx, group->group_type, group->is_output ? CKB_SOURCE_OUTPUT : CKB_SOURCE_INPUT, group->index) != 0) {
+      return 0;
+    }
+    uint64_t start = now_ns();
+    int ret = ckb_mock_run(native_entry(group->script));
+    uint64_t elapsed = now_ns() - start;
+    if (ret != 0) {
+      return 0;
+    }
+    best = elapsed < best ? elapsed : best;
+  }
+  return best > 0 ? best : 1;
+}
+
+/*
+ * cycles of ckb-debugger, 0 when script group fails
+ */
+static uint64_t vm_cost(const char *tx_file, const fixture_group_t *group) {
+  char command[FUZZ_COMMAND_SIZE], line[256];
+  unsigned long long cycles = 0;
+  long result = -1;
+  snprintf(
+    command, sizeof(command), "%s --tx-file %s --script-group-type %s --cell-type %s --cell-index %zu 2>&1",
+    debugger, tx_file,
+    group->group_type == FIXTURE_GROUP_LOCK ? "lock" : "type",
+    group->is_output ? "output" : "input",
+    group->index
+  );
+  FILE *fp = popen(command, "r");
+  if (fp == NULL) {
+    return 0;
+  }
+  while (fgets(line, sizeof(line), fp) != NULL) {
+    char *p;
+    if (sscanf(line, "Run result: %ld", &result) == 1) {
+      continue;
+    }
+    if (strncmp(line, "Total cycles consumed:", 22) == 0 || strncmp(line, "All cycles:", 11) == 0) {
+      cycles = 0;
+      for (p = strchr(line, ':') + 1; *p != '\0' && *p != '('; p++) {
+        if (*p >= '0' && *p <= '9') {
+          cycles = cycles * 10 + (unsigned long long)(*p - '0');
+        }
+      }
+      //digits with separators, before "(" of other units
+    }
+  }
+  pclose(fp);
+  return result == 0 ? cycles : 0;
+}
+
+static int write_tx(const fixture_tx_t *tx, const char *path) {
+  FILE *fp = fopen(path, "w");
+  if (fp == NULL) {
+    return FIXTURE_ERROR_IO;
+  }
+  int ret = fixture_write_json(tx, fp);
+  fclose(fp);
+  return ret;
+}
+
+static void evaluate(const fuzz_case_t *c, fuzz_cost_t *cost) {
+  fixture_group_t groups[FIXTURE_MAX_POOLS + 2];
+  fixture_context_t case_ctx;
+  char tx_file[] = "/tmp/udtswap_fuzz_XXXXXX";
+  size_t i, cnt;
+
+  memset(cost, 0, sizeof(fuzz_cost_t));
+  fixture_tx_t *tx = malloc(sizeof(fixture_tx_t));
+  if (tx == NULL) {
+    return;
+  }
+  if (build_tx(c, tx, &case_ctx) != 0) {
+    fixture_tx_free(tx);
+    free(tx);
+    return;
+  }
+  cnt = fixture_shape_groups(c->shape, c->pool_cnt, groups);
+  if (debugger != NULL) {
+    int fd = mkstemp(tx_file);
+    if (fd < 0) {
+      fixture_tx_free(tx);
+      free(tx);
+      return;
+    }
+    close(fd);
+    write_tx(tx, tx_file);
+  }
+  cost->valid = 1;
+  for (i = 0; i < cnt && cost->valid; i++) {
+    uint64_t v = native_cost(tx, &groups[i]);
+    if (v > 0 && debugger != NULL) {
+      v = vm_cost(tx_file, &groups[i]);
+    }
+    //only valid transactions of native build are run in vm
+    if (v == 0) {
+      cost->valid = 0;
+      break;
+    }
+    cost->total += v;
+    if (v > cost->scripts[groups[i].script]) {
+      cost->scripts[groups[i].script] = v;
+    }
+  }
+  if (debugger != NULL) {
+    unlink(tx_file);
+  }
+  fixture_tx_free(tx);
+  free(tx);
+}
+
+static void print_u128(FILE *fp, fixture_u128 v) {
+  char buf[48];
+  size_t len = 0;
+  do {
+    buf[len++] = (char)('0' + (int)(v % 10));
+    v /= 10;
+  } while (v > 0);
+  while (len > 0) {
+    fputc(buf[--len], fp);
+  }
+}
+
+static void print_case(FILE *fp, const fuzz_case_t *c) {
+  size_t i;
+  fprintf(
+    fp, "%s %s %s mode=%s pools=%zu\n",
+    shape_names[c->shape],
+    c->kind == FIXTURE_PAIR_CKB_UDT ? "ckb-udt" : "udt-udt",
+    c->extended ? "extended" : "legacy",
+    mode_names[c->swap_mode],
+    c->pool_cnt
+  );
+  for (i = 0; i < c->pool_cnt && c->shape != FIXTURE_SHAPE_CREATE; i++) {
+    fprintf(fp, "  pool %zu reserve1=", i);
+    print_u128(fp, c->pools[i].udt1_reserve);
+    fprintf(fp, " reserve2=");
+    print_u128(fp, c->pools[i].udt2_reserve);
+    fprintf(fp, " liquidity=");
+    print_u128(fp, c->pools[i].total_liquidity);
+    fprintf(fp, " amount=");
+    print_u128(fp, c->amounts[i]);
+    fprintf(fp, c->shape == FIXTURE_SHAPE_SWAP ? " input=udt%d\n" : "\n", c->directions[i] + 1);
+  }
+}
+
+static void save_case(const fuzz_case_t *c, const char *name) {
+  char path[FUZZ_COMMAND_SIZE];
+  fixture_context_t case_ctx;
+  if (out_dir == NULL) {
+    return;
+  }
+  fixture_tx_t *tx = malloc(sizeof(fixture_tx_t));
+  if (tx == NULL) {
+    return;
+  }
+  if (build_tx(c, tx, &case_ctx) == 0) {
+    snprintf(path, sizeof(path), "%s/worst-%s.json", out_dir, name);
+    write_tx(tx, path);
+  }
+  fixture_tx_free(tx);
+  free(tx);
+}
+
+static void usage(void) {
+  fprintf(stderr,
+    "usage: udtswap_fuzz [options]\n"
+    "  -s shape            create|add|remove|swap|all (default all)\n"
+    "  -i iterations       cases per shape (default 500)\n"
+    "  -n pools            max pool count of swap (default 8)\n"
+    "  -r runs             native runs per script group, min is taken (default 3)\n"
+    "  -S seed             random seed\n"
+    "  -V ckb-debugger     cost is cycles of ckb-debugger instead of native ns\n"
+    "  -b dir              directory of compiled scripts, needed with -V\n"
+    "  -B budget           fails when a valid transaction costs more (default 3500000000 with -V)\n"
+    "  -o dir              worst cases are written as mock transaction json\n");
+}
+
+static int parse_shape(const char *name) {
+  int shape;
+  for (shape = 0; shape < FUZZ_SHAPE_CNT; shape++) {
+    if (strcmp(shape_names[shape], name) == 0) {
+      return shape;
+    }
+  }
+  return strcmp(name, "all") == 0 ? FUZZ_SHAPE_CNT : -1;
+}
+
+int main(int argc, char *argv[]) {
+  fuzz_worst_t worst_tx[FUZZ_SHAPE_CNT], worst_script[FUZZ_SCRIPT_CNT];
+  uint64_t budget = 0, valid_cnt = 0, case_cnt = 0;
+  long iterations = 500, i;
+  int only_shape = FUZZ_SHAPE_CNT, shape, script, opt, over_budget = 0;
+
+  while ((opt = getopt(argc, argv, "s:i:n:r:S:V:b:B:o:")) != -1) {
+    switch (opt) {
+      case 's':
+        only_shape = parse_shape(optarg);
+        if (only_shape < 0) {
+          usage();
+          return 1;
+        }
+        break;
+      case 'i':
+        iterations = atol(optarg);
+        break;
+      case 'n':
+        max_pools = (size_t)atol(optarg);
+        if (max_pools < 1 || max_pools > FIXTURE_MAX_POOLS) {
+          fprintf(stderr, "pool count should be 1 ~ %d\n", FIXTURE_MAX_POOLS);
+          return 1;
+        }
+        break;
+      case 'r':
+        runs = atoi(optarg) > 0 ? atoi(optarg) : 1;
+        break;
+      case 'S':
+        rng_state = strtoull(optarg, NULL, 0) | 1;
+        break;
+      case 'V':
+        debugger = optarg;
+        break;
+      case 'b':
+        bin_dir = optarg;
+        break;
+      case 'B':
+        budget = strtoull(optarg, NULL, 0);
+        break;
+      case 'o':
+        out_dir = optarg;
+        break;
+      default:
+        usage();
+        return 1;
+    }
+  }
+  if (debugger != NULL && bin_dir == NULL) {
+    fprintf(stderr, "-V needs compiled scripts of fixture code hashes, -b\n");
+    return 1;
+  }
+  if (debugger != NULL && budget == 0) {
+    budget = FUZZ_MAX_CYCLES;
+  }
+  fixture_context_init(&ctx);
+  memset(worst_tx, 0, sizeof(worst_tx));
+  memset(worst_script, 0, sizeof(worst_script));
+
+  for (shape = 0; shape < FUZZ_SHAPE_CNT; shape++) {
+    if (only_shape != FUZZ_SHAPE_CNT && only_shape != shape) {
+      continue;
+    }
+    for (i = 0; i < iterations; i++) {
+      fuzz_case_t c;
+      fuzz_cost_t cost;
+      if (!worst_tx[shape].found || next_random() % FUZZ_FRESH_RATIO == 0) {
+        random_case(&c, shape);
+      } else {
+        c = worst_tx[shape].c;
+        mutate_case(&c);
+      }
+      //hill climbing from most costly case, with fresh random cases
+      evaluate(&c, &cost);
+      case_cnt += 1;
+      if (!cost.valid) {
+        continue;
+      }
+      valid_cnt += 1;
+      if (budget > 0 && cost.total > budget) {
+        over_budget = 1;
+      }
+      if (cost.total > worst_tx[shape].cost) {
+        worst_tx[shape].c = c;
+        worst_tx[shape].cost = cost.total;
+        worst_tx[shape].found = 1;
+      }
+      for (script = 0; script < FUZZ_SCRIPT_CNT; script++) {
+        if (cost.scripts[script] > worst_script[script].cost) {
+          worst_script[script].c = c;
+          worst_script[script].cost = cost.scripts[script];
+          worst_script[script].found = 1;
+        }
+      }
+    }
+  }
+
+  const char *unit = debugger != NULL ? "cycles" : "ns";
+  printf("%llu cases, %llu valid\n\n", (unsigned long long)case_cnt, (unsigned long long)valid_cnt);
+  for (shape = 0; shape < FUZZ_SHAPE_CNT; shape++) {
+    if (!worst_tx[shape].found) {
+      continue;
+    }
+    printf("worst %s transaction: %llu %s\n", shape_names[shape], (unsigned long long)worst_tx[shape].cost, unit);
+    print_case(stdout, &worst_tx[shape].c);
+    save_case(&worst_tx[shape].c, shape_names[shape]);
+  }
+  for (script = 0; script < FUZZ_SCRIPT_CNT; script++) {
+    if (!worst_script[script].found) {
+      continue;
+    }
+    printf("worst %s script group: %llu %s\n", fixture_script_name(script), (unsigned long long)worst_script[script].cost, unit);
+    print_case(stdout, &worst_script[script].c);
+    save_case(&worst_script[script].c, fixture_script_name(script));
+  }
+  if (budget > 0) {
+    printf("budget %llu %s: %s\n", (unsigned long long)budget, unit, over_budget ? "exceeded" : "ok");
+  }
+  return over_budget ? 1 : 0;
+}
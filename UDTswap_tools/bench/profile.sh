@@ -0,0 +1,49 @@
+#!/bin/sh
+# Aggregate per-phase cycles of UDTSWAP_PROFILE build from debugger log of cycles.sh.
+# usage: profile.sh <debugger log>
+
+LOG=${1:-./build/profile/debugger.log}
+
+if [ ! -f "$LOG" ]; then
+  echo "$LOG not found, run cycles.sh with UDTSWAP_PROFILE scripts" >&2
+  exit 1
+fi
+
+# "== <shape> <script> <cell>" header is followed by output of the script group,
+# "udtswap-profile <script> result=<ret> total=<cycles> <phase>=<cycles>/<count> ..." is written by the script
+awk '
+  BEGIN { printf "%-28s %-10s %-10s %-10s %14s %8s %8s\n", "shape", "script", "cell", "phase", "cycles", "count", "of total" }
+  /^== / { shape = $2; cell = $4; next }
+  {
+    p = index($0, "udtswap-profile ")
+    if (p == 0) next
+    split(substr($0, p), f, " ")
+    script = f[2]
+    total = 0
+    for (i = 3; i in f; i++) {
+      split(f[i], kv, "=")
+      if (kv[1] == "total") total = kv[2]
+    }
+    printf "%-28s %-10s %-10s %-10s %14s %8s %8s\n", shape, script, cell, "total", total, 1, "100.00%"
+    for (i = 3; i in f; i++) {
+      split(f[i], kv, "=")
+      if (kv[1] == "result" || kv[1] == "total") continue
+      split(kv[2], cc, "/")
+      ratio = total > 0 ? 100 * cc[1] / total : 0
+      printf "%-28s %-10s %-10s %-10s %14s %8s %7.2f%%\n", shape, script, cell, kv[1], cc[1], cc[2], ratio
+      sum[script, kv[1]] += cc[1]
+      cnt[script, kv[1]] += cc[2]
+      if (!((script, kv[1]) in seen)) { seen[script, kv[1]] = 1; order[++n] = script SUBSEP kv[1] }
+    }
+    all[script] += total
+  }
+  END {
+    print ""
+    printf "%-10s %-10s %14s %8s %8s\n", "script", "phase", "cycles", "count", "of script"
+    for (i = 1; i <= n; i++) {
+      split(order[i], k, SUBSEP)
+      ratio = all[k[1]] > 0 ? 100 * sum[order[i]] / all[k[1]] : 0
+      printf "%-10s %-10s %14d %8d %7.2f%%\n", k[1], k[2], sum[order[i]], cnt[order[i]], ratio
+    }
+  }
+' "$LOG"
@@ -0,0 +1,572 @@
+/*
+ * quote library benchmark, ns per exact input quote as json lines
+ * bn : swap formula of the type script, quote : udtswap_quote_exact_input, pools : batch quote of pool table
+ *        by each SIMD level of the CPU, "simd" of the line
+ * route : ns per route of 3 hops and split of 4 pools, graph of QUOTE_BENCH_POOLS pools of QUOTE_BENCH_UDTS udts
+ * snapshot : ns to map a snapshot of QUOTE_BENCH_SNAPSHOT_POOLS pools and add them to a route graph
+ * ingest : MB/s and blocks/s of block file ingestion by decode thread count, blocks of udtswap_fixture blocks
+ * tx : ns to build, balance and serialize a swap transaction of QUOTE_BENCH_TX_POOLS pools, without and with its hash
+ * history : rows/s of history built by ingestion of the same blocks, bytes per row, rows/s of stats of every pool and of one pool
+ * sign : transactions/s of batch signing of QUOTE_BENCH_SIGN_TXS transactions of tx mode by thread count,
+ *        messages only unless built with SECP256K1=1
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "../../UDTswap_scripts/ckb_consts.h"
+#include "../../UDTswap_scripts/bn.h"
+#include "../../UDTswap_scripts/udtswap_common.h"
+#include "../../UDTswap_scripts/udtswap_formula.h"
+#include "../quote/udtswap_quote.h"
+#include "../quote/udtswap_route.h"
+#include "../quote/udtswap_snapshot.h"
+#include "../quote/udtswap_ingest.h"
+#include "../quote/udtswap_history.h"
+#include "../quote/udtswap_tx.h"
+#include "../quote/udtswap_sign.h"
+
+#define QUOTE_BENCH_POOLS 4096
+#define QUOTE_BENCH_MIN_NS 200000000.0
+#define QUOTE_BENCH_UDTS 64
+#define QUOTE_BENCH_ROUTES 1024
+#define QUOTE_BENCH_SNAPSHOT_POOLS 100000
+#define QUOTE_BENCH_SNAPSHOT_LOADS 20
+#define QUOTE_BENCH_SNAPSHOT_PATH "build/quote/snapshot_bench.bin"
+#define QUOTE_BENCH_BLOCKS_PATH "build/quote/blocks.bin"
+#define QUOTE_BENCH_HASHES_PATH "build/hash.txt"
+#define QUOTE_BENCH_HISTORY_PATH "build/quote/history_bench.bin"
+#define QUOTE_BENCH_HISTORY_SCANS 20
+#define QUOTE_BENCH_TX_POOLS 3
+#define QUOTE_BENCH_TX_ARENA_SIZE (16 << 10)
+#define QUOTE_BENCH_SIGN_TXS 1024
+#define QUOTE_BENCH_SIGN_BATCHES 10
+
+#define QUOTE_BENCH_MODE_BN 0
+#define QUOTE_BENCH_MODE_QUOTE 1
+#define QUOTE_BENCH_MODE_POOLS 2
+#define QUOTE_BENCH_MODE_CNT 3
+
+#define QUOTE_BENCH_DIST_CAPACITY 0
+#define QUOTE_BENCH_DIST_AMOUNT 1
+#define QUOTE_BENCH_DIST_AMOUNT128 2
+#define QUOTE_BENCH_DIST_CNT 3
+
+static const char *mode_names[QUOTE_BENCH_MODE_CNT] = {"bn", "quote", "pools"};
+static const char *dist_names[QUOTE_BENCH_DIST_CNT] = {"capacity64", "amount64", "amount128"};
+static const char *simd_names[] = {"none", "avx2", "avx512"};
+
+static udtswap_quote_u128 udt1_reserve[QUOTE_BENCH_POOLS];
+static udtswap_quote_u128 udt2_reserve[QUOTE_BENCH_POOLS];
+static udtswap_quote_u128 total_liquidity[QUOTE_BENCH_POOLS];
+static uint8_t kind[QUOTE_BENCH_POOLS];
+static udtswap_quote_u128 results[QUOTE_BENCH_POOLS];
+static int rets[QUOTE_BENCH_POOLS];
+static udtswap_quote_u128 input_amount;
+static volatile uint64_t sink;
+
+static uint64_t xorshift(uint64_t *state) {
+  uint64_t x = *state;
+  x ^= x << 13;
+  x ^= x >> 7;
+  x ^= x << 17;
+  *state = x;
+  return x;
+}
+
+/*
+ * capacity64 : CKB reserves up to 2^62 shannons
+ * amount64 : UDT reserves of 64 bits
+ * amount128 : UDT reserves of 2^96 ~ 2^127, quotes of bn formula
+ */
+static udtswap_quote_u128 random_reserve(int dist, uint64_t *state) {
+  switch (dist) {
+    case QUOTE_BENCH_DIST_CAPACITY:
+      return (udtswap_quote_u128)(6100000000ULL + (xorshift(state) >> 2));
+    case QUOTE_BENCH_DIST_AMOUNT:
+      return (udtswap_quote_u128)(1 + xorshift(state));
+    default:
+      return (((udtswap_quote_u128)xorshift(state) << 64) | xorshift(state)) >> 1 | (udtswap_quote_u128)1 << 96;
+  }
+}
+
+static void prepare(int dist) {
+  uint64_t state = 0x9e3779b97f4a7c15ULL + (uint64_t)dist;
+  int i;
+  for (i = 0; i < QUOTE_BENCH_POOLS; i++) {
+    udt1_reserve[i] = random_reserve(dist, &state);
+    udt2_reserve[i] = random_reserve(dist, &state);
+    total_liquidity[i] = udt1_reserve[i];
+    kind[i] = dist == QUOTE_BENCH_DIST_CAPACITY ? UDTSWAP_QUOTE_PAIR_CKB_UDT : UDTSWAP_QUOTE_PAIR_UDT_UDT;
+  }
+  input_amount = udt1_reserve[0] / 1000 + 1;
+}
+
+/*
+ * one input amount against every pool, UDTSWAP_QUOTE_UDT1_INPUT
+ */
+static void run(int mode) {
+  udtswap_quote_pools_t pools = {QUOTE_BENCH_POOLS, udt1_reserve, udt2_reserve, total_liquidity, kind};
+  struct bn amount;
+  uint64_t acc = 0;
+  int i;
+  switch (mode) {
+    case QUOTE_BENCH_MODE_BN:
+      for (i = 0; i < QUOTE_BENCH_POOLS; i++) {
+        udtswap_swap_output_amount(udt1_reserve[i], udt2_reserve[i], input_amount, &amount);
+        acc += amount.array[0];
+      }
+      break;
+    case QUOTE_BENCH_MODE_QUOTE:
+      for (i = 0; i < QUOTE_BENCH_POOLS; i++) {
+        udtswap_quote_exact_input(udt1_reserve[i], udt2_reserve[i], input_amount, &results[i]);
+        acc += (uint64_t)results[i];
+      }
+      break;
+    default:
+      udtswap_quote_exact_input_pools(&pools, UDTSWAP_QUOTE_UDT1_INPUT, input_amount, results, rets);
+      acc += (uint64_t)results[QUOTE_BENCH_POOLS - 1];
+  }
+  sink = acc;
+}
+
+static double now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+/*
+ * runs over pool table are doubled until they take QUOTE_BENCH_MIN_NS
+ */
+static double measure(int mode, long *quotes) {
+  long n = 1, i;
+  while (1) {
+    double start = now_ns();
+    for (i = 0; i < n; i++) {
+      run(mode);
+    }
+    double elapsed = now_ns() - start;
+    if (elapsed >= QUOTE_BENCH_MIN_NS || n >= (1L << 30)) {
+      *quotes = n * QUOTE_BENCH_POOLS;
+      return elapsed / *quotes;
+    }
+    n *= 2;
+  }
+}
+
+/*
+ * pools of random pairs, a quarter of pools are parallel pools of udt 1 and udt 2
+ */
+static udtswap_route_graph_t *route_graph(void) {
+  uint8_t lock_args[UDTSWAP_ROUTE_LOCK_ARGS_SIZE], data[UDTSWAP_DATA_SIZE];
+  uint64_t state = 0x9e3779b97f4a7c15ULL;
+  udtswap_route_graph_t *graph = udtswap_route_graph_new();
+  uint32_t pool;
+  int i, j;
+  for (i = 0; i < QUOTE_BENCH_POOLS && graph != NULL; i++) {
+    int udt1 = i % 4 == 0 ? 1 : (int)(xorshift(&state) % QUOTE_BENCH_UDTS);
+    int udt2 = i % 4 == 0 ? 2 : (int)(xorshift(&state) % QUOTE_BENCH_UDTS);
+    memset(lock_args, udt1, UDTSWAP_ROUTE_HASH_SIZE);
+    memset(lock_args + UDTSWAP_ROUTE_HASH_SIZE, udt2, UDTSWAP_ROUTE_HASH_SIZE);
+    memset(data, 0, sizeof(data));
+    for (j = 0; j < 6; j++) {
+      data[UDTSWAP_DATA_UDT1_RESERVE_START + j] = (uint8_t)xorshift(&state);
+      data[UDTSWAP_DATA_UDT2_RESERVE_START + j] = (uint8_t)xorshift(&state);
+    }
+    data[UDTSWAP_DATA_UDT1_RESERVE_START + 6] = 1;
+    data[UDTSWAP_DATA_UDT2_RESERVE_START + 6] = 1;
+    data[UDTSWAP_DATA_TOTAL_LIQUIDITY_START] = 1;
+    udtswap_route_graph_add_pool(graph, lock_args, data, sizeof(data), &pool);
+  }
+  return graph;
+}
+//CKB is udt 0, reserves are 2^48 ~ 2^49
+
+static void route_bench(void) {
+  static const udtswap_route_options_t options = {3, 4, 0};
+  uint8_t from[UDTSWAP_ROUTE_HASH_SIZE], to[UDTSWAP_ROUTE_HASH_SIZE];
+  uint64_t state = 0x2545f4914f6cdd1dULL, paths = 0;
+  udtswap_route_graph_t *graph = route_graph();
+  udtswap_route_t route;
+  long routes = 0;
+  int i;
+  if (graph == NULL) {
+    return;
+  }
+  double start = now_ns();
+  for (i = 0; i < QUOTE_BENCH_ROUTES; i++) {
+    memset(from, i % 2 == 0 ? 1 : (int)(xorshift(&state) % QUOTE_BENCH_UDTS), sizeof(from));
+    memset(to, i % 2 == 0 ? 2 : (int)(xorshift(&state) % QUOTE_BENCH_UDTS), sizeof(to));
+    if (udtswap_route_best(graph, from, to, 1000000000ULL + xorshift(&state) % 1000000000000ULL, &options, &route) == 0) {
+      paths += route.paths;
+    }
+    routes += 1;
+  }
+  double elapsed = now_ns() - start;
+  printf(
+    "{\"mode\":\"route\",\"pools\":%d,\"udts\":%d,\"routes\":%ld,\"paths_per_route\":%.1f,\"ns_per_route\":%.2f}\n",
+    QUOTE_BENCH_POOLS, QUOTE_BENCH_UDTS, routes, (double)paths / routes, elapsed / routes
+  );
+  udtswap_route_graph_free(graph);
+}
+
+/*
+ * pools of random pairs of QUOTE_BENCH_UDTS udts, as route_graph
+ */
+static void snapshot_bench(void) {
+  udtswap_snapshot_record_t *records = calloc(QUOTE_BENCH_SNAPSHOT_POOLS, sizeof(udtswap_snapshot_record_t));
+  uint8_t tip_hash[UDTSWAP_ROUTE_HASH_SIZE] = {0};
+  uint64_t state = 0x9e3779b97f4a7c15ULL;
+  udtswap_snapshot_t snapshot;
+  uint32_t first;
+  size_t pools = 0;
+  int i, j;
+  if (records == NULL) {
+    return;
+  }
+  for (i = 0; i < QUOTE_BENCH_SNAPSHOT_POOLS; i++) {
+    udtswap_snapshot_record_t *record = &records[i];
+    memset(record->lock_args, (int)(xorshift(&state) % QUOTE_BENCH_UDTS), UDTSWAP_ROUTE_HASH_SIZE);
+    memset(record->lock_args + UDTSWAP_ROUTE_HASH_SIZE, (int)(xorshift(&state) % QUOTE_BENCH_UDTS), UDTSWAP_ROUTE_HASH_SIZE);
+    memcpy(record->type_hash, &i, sizeof(i));
+    for (j = 0; j < 6; j++) {
+      record->data[UDTSWAP_DATA_UDT1_RESERVE_START + j] = (uint8_t)xorshift(&state);
+      record->data[UDTSWAP_DATA_UDT2_RESERVE_START + j] = (uint8_t)xorshift(&state);
+    }
+    record->data[UDTSWAP_DATA_UDT1_RESERVE_START + 6] = 1;
+    record->data[UDTSWAP_DATA_UDT2_RESERVE_START + 6] = 1;
+    record->data[UDTSWAP_DATA_TOTAL_LIQUIDITY_START] = 1;
+  }
+  if (udtswap_snapshot_write(QUOTE_BENCH_SNAPSHOT_PATH, 1, tip_hash, records, QUOTE_BENCH_SNAPSHOT_POOLS) != 0) {
+    free(records);
+    return;
+  }
+  free(records);
+  double start = now_ns();
+  for (i = 0; i < QUOTE_BENCH_SNAPSHOT_LOADS; i++) {
+    udtswap_route_graph_t *graph = udtswap_route_graph_new();
+    if (graph != NULL && udtswap_snapshot_open(QUOTE_BENCH_SNAPSHOT_PATH, &snapshot) == 0) {
+      udtswap_snapshot_add_pools(&snapshot, graph, &first);
+      pools += udtswap_route_graph_pool_count(graph);
+      udtswap_snapshot_close(&snapshot);
+    }
+    udtswap_route_graph_free(graph);
+  }
+  double elapsed = now_ns() - start;
+  printf(
+    "{\"mode\":\"snapshot\",\"pools\":%d,\"loads\":%d,\"ns_per_load\":%.2f,\"ns_per_pool\":%.2f}\n",
+    QUOTE_BENCH_SNAPSHOT_POOLS, QUOTE_BENCH_SNAPSHOT_LOADS, elapsed / QUOTE_BENCH_SNAPSHOT_LOADS, pools == 0 ? 0 : elapsed / pools
+  );
+  unlink(QUOTE_BENCH_SNAPSHOT_PATH);
+}
+
+/*
+ * code hashes of fixture blocks, first 2 lines of hash.txt
+ */
+static int read_hashes(uint8_t type_code_hash[UDTSWAP_ROUTE_HASH_SIZE], uint8_t lock_code_hash[UDTSWAP_ROUTE_HASH_SIZE]) {
+  uint8_t *hashes[2] = {type_code_hash, lock_code_hash};
+  FILE *fp = fopen(QUOTE_BENCH_HASHES_PATH, "r");
+  int h, i;
+  if (fp == NULL) {
+    return -1;
+  }
+  for (h = 0; h < 2; h++) {
+    for (i = 0; i < UDTSWAP_ROUTE_HASH_SIZE; i++) {
+      unsigned int v;
+      if (fscanf(fp, i == 0 ? " %u" : " ,%u", &v) != 1) {
+        fclose(fp);
+        return -1;
+      }
+      hashes[h][i] = (uint8_t)v;
+    }
+  }
+  fclose(fp);
+  return 0;
+}
+
+static void ingest_bench(void) {
+  uint8_t type_code_hash[UDTSWAP_ROUTE_HASH_SIZE], lock_code_hash[UDTSWAP_ROUTE_HASH_SIZE];
+  FILE *fp = fopen(QUOTE_BENCH_BLOCKS_PATH, "rb");
+  long cores = sysconf(_SC_NPROCESSORS_ONLN);
+  int threads;
+  if (fp == NULL || read_hashes(type_code_hash, lock_code_hash) != 0) {
+    if (fp != NULL) {
+      fclose(fp);
+    }
+    fprintf(stderr, "ingest needs %s and %s\n", QUOTE_BENCH_BLOCKS_PATH, QUOTE_BENCH_HASHES_PATH);
+    return;
+  }
+  fseek(fp, 0, SEEK_END);
+  double mb = ftell(fp) / 1e6;
+  fclose(fp);
+  for (threads = 1; threads <= (cores > 0 ? cores : 1); threads *= 2) {
+    udtswap_ingest_options_t options = {threads, 0, NULL, NULL};
+    udtswap_ingest_t *ingest = udtswap_ingest_new();
+    if (ingest == NULL) {
+      return;
+    }
+    udtswap_ingest_set_code_hashes(ingest, type_code_hash, lock_code_hash);
+    double start = now_ns();
+    int ret = udtswap_ingest_file(ingest, QUOTE_BENCH_BLOCKS_PATH, &options);
+    double seconds = (now_ns() - start) / 1e9;
+    printf(
+      "{\"mode\":\"ingest\",\"threads\":%d,\"ret\":%d,\"blocks\":%llu,\"pools\":%zu,\"mb_per_s\":%.1f,\"blocks_per_s\":%.0f}\n",
+      threads, ret, (unsigned long long)udtswap_ingest_block_count(ingest), udtswap_ingest_pool_count(ingest),
+      mb / seconds, udtswap_ingest_block_count(ingest) / seconds
+    );
+    fflush(stdout);
+    udtswap_ingest_free(ingest);
+  }
+}
+//file pages are cached after first pass, passes measure decode and apply, not disk
+
+/*
+ * swap of pools of a UDT/UDT pair : pool cells, fee cell, 2 result cells of each pool, change, lock witness
+ */
+static uint32_t tx_build(udtswap_tx_t *tx, uint8_t *arena, uint8_t *out, uint8_t hash[UDTSWAP_ROUTE_HASH_SIZE], int hashed) {
+  static const uint8_t code_hash[UDTSWAP_ROUTE_HASH_SIZE] = {1}, lock_args[UDTSWAP_ROUTE_LOCK_ARGS_SIZE] = {2};
+  static const uint8_t pkh[20] = {3}, data[UDTSWAP_DATA_SIZE] = {4}, amount[UDT_AMOUNT_SIZE] = {5};
+  static const uint8_t swap_witness[] = {0x15, 0, 0, 0, 0x10, 0, 0, 0, 0x10, 0, 0, 0, 0x15, 0, 0, 0, 0x01, 0, 0, 0, 0x01};
+  udtswap_tx_script_t udt = {code_hash, UDTSWAP_TX_HASH_TYPE_TYPE, code_hash, UDTSWAP_ROUTE_HASH_SIZE};
+  udtswap_tx_script_t lock = {code_hash, UDTSWAP_TX_HASH_TYPE_TYPE, pkh, sizeof(pkh)};
+  udtswap_tx_pool_t pool = {
+    code_hash, 0, code_hash, code_hash, lock_args, code_hash, UDTSWAP_ROUTE_HASH_SIZE, 30000000000ULL, data, sizeof(data),
+    {15800000000ULL, 15800000000ULL}, {&udt, &udt}, {amount, amount}, {sizeof(amount), sizeof(amount)}
+  };
+  int i, change = 0;
+  udtswap_tx_init(tx, arena, QUOTE_BENCH_TX_ARENA_SIZE);
+  for (i = 0; i < 5; i++) {
+    udtswap_tx_add_cell_dep(tx, code_hash, (uint32_t)i, UDTSWAP_TX_DEP_CODE);
+  }
+  for (i = 0; i < QUOTE_BENCH_TX_POOLS; i++) {
+    pool.live_index = (uint32_t)i * 3;
+    udtswap_tx_add_pool(tx, &pool);
+  }
+  udtswap_tx_add_input(tx, code_hash, 9, 0);
+  udtswap_tx_add_input(tx, code_hash, 10, 0);
+  udtswap_tx_add_output(tx, STATE_USE_FEE, &lock, NULL, NULL, 0);
+  for (i = 0; i < QUOTE_BENCH_TX_POOLS * 2; i++) {
+    udtswap_tx_add_output(tx, 11000000000ULL, &lock, &udt, amount, sizeof(amount));
+  }
+  change = udtswap_tx_add_output(tx, 0, &lock, NULL, NULL, 0);
+  for (i = 0; i < QUOTE_BENCH_TX_POOLS * 3; i++) {
+    udtswap_tx_add_witness(tx, i % 3 == 0 ? swap_witness : NULL, i % 3 == 0 ? sizeof(swap_witness) : 0);
+  }
+  udtswap_tx_add_lock_witness(tx);
+  udtswap_tx_balance(tx, (size_t)change, 1000000000000ULL, 1000, NULL);
+  if (hashed) {
+    udtswap_tx_hash(tx, hash);
+  }
+  udtswap_tx_serialize(tx, out, QUOTE_BENCH_TX_ARENA_SIZE);
+  return udtswap_tx_size(tx);
+}
+
+static void tx_bench(void) {
+  static udtswap_tx_t tx;
+  static uint8_t arena[QUOTE_BENCH_TX_ARENA_SIZE], out[QUOTE_BENCH_TX_ARENA_SIZE];
+  uint8_t hash[UDTSWAP_ROUTE_HASH_SIZE] = {0};
+  uint32_t size = 0;
+  int hashed;
+  for (hashed = 0; hashed <= 1; hashed++) {
+    long n = 1, i;
+    while (1) {
+      double start = now_ns();
+      for (i = 0; i < n; i++) {
+        size = tx_build(&tx, arena, out, hash, hashed);
+        sink += hash[0];
+      }
+      double elapsed = now_ns() - start;
+      if (elapsed >= QUOTE_BENCH_MIN_NS || n >= (1L << 30)) {
+        printf(
+          "{\"mode\":\"tx\",\"pools\":%d,\"hashed\":%d,\"size\":%u,\"txs\":%ld,\"ns_per_tx\":%.2f}\n",
+          QUOTE_BENCH_TX_POOLS, hashed, size, n, elapsed / n
+        );
+        fflush(stdout);
+        break;
+      }
+      n *= 2;
+    }
+  }
+}
+//hash of raw transaction is most of the time of a hashed build
+
+/*
+ * history of the blocks of ingest mode, built once, then reopened and scanned
+ * a report of volumes and fees is a stats call, instead of a replay of blocks
+ */
+static void history_bench(void) {
+  uint8_t type_code_hash[UDTSWAP_ROUTE_HASH_SIZE], lock_code_hash[UDTSWAP_ROUTE_HASH_SIZE];
+  udtswap_history_range_t range = {UDTSWAP_HISTORY_ALL_POOLS, 0, UINT64_MAX, 0, UINT64_MAX};
+  udtswap_history_stats_t stats;
+  udtswap_history_t *history;
+  int i, ret;
+  if (read_hashes(type_code_hash, lock_code_hash) != 0) {
+    fprintf(stderr, "history needs %s and %s\n", QUOTE_BENCH_BLOCKS_PATH, QUOTE_BENCH_HASHES_PATH);
+    return;
+  }
+  unlink(QUOTE_BENCH_HISTORY_PATH);
+  udtswap_ingest_t *ingest = udtswap_ingest_new();
+  if (ingest == NULL || udtswap_history_open(QUOTE_BENCH_HISTORY_PATH, &history) != 0) {
+    udtswap_ingest_free(ingest);
+    return;
+  }
+  udtswap_ingest_options_t options = {0, 0, udtswap_history_apply, history};
+  udtswap_ingest_set_code_hashes(ingest, type_code_hash, lock_code_hash);
+  double start = now_ns();
+  ret = udtswap_ingest_file(ingest, QUOTE_BENCH_BLOCKS_PATH, &options);
+  if (ret == 0) {
+    ret = udtswap_history_error(history);
+  }
+  if (ret == 0) {
+    ret = udtswap_history_close(history);
+  } else {
+    udtswap_history_close(history);
+  }
+  double build = (now_ns() - start) / 1e9;
+  udtswap_ingest_free(ingest);
+  if (ret != 0 || udtswap_history_open(QUOTE_BENCH_HISTORY_PATH, &history) != 0) {
+    fprintf(stderr, "history of %s failed: %d\n", QUOTE_BENCH_BLOCKS_PATH, ret);
+    return;
+  }
+
+  uint64_t rows = udtswap_history_row_count(history), pool_rows = 0;
+  start = now_ns();
+  for (i = 0; i < QUOTE_BENCH_HISTORY_SCANS; i++) {
+    udtswap_history_stats(history, &range, &stats);
+    sink += stats.swap_cnt;
+  }
+  double scan = (now_ns() - start) / 1e9 / QUOTE_BENCH_HISTORY_SCANS;
+  range.pool = 0;
+  start = now_ns();
+  for (i = 0; i < QUOTE_BENCH_HISTORY_SCANS; i++) {
+    udtswap_history_stats(history, &range, &stats);
+    pool_rows = stats.row_cnt;
+  }
+  double pool_scan = (now_ns() - start) / 1e9 / QUOTE_BENCH_HISTORY_SCANS;
+  printf(
+    "{\"mode\":\"history\",\"rows\":%llu,\"pools\":%zu,\"build_rows_per_s\":%.0f,\"bytes_per_row\":%.2f,"
+    "\"scan_rows_per_s\":%.0f,\"scan_ms\":%.3f,\"pool_rows\":%llu,\"pool_scan_ms\":%.3f}\n",
+    (unsigned long long)rows, udtswap_history_pool_count(history), rows / build,
+    rows > 0 ? (double)udtswap_history_size(history) / rows : 0.0, rows / scan, scan * 1e3,
+    (unsigned long long)pool_rows, pool_scan * 1e3
+  );
+  fflush(stdout);
+  udtswap_history_close(history);
+}
+//build includes ingestion of blocks, the replay a history replaces
+
+/*
+ * lock group of the user of each transaction, last witness of tx mode transaction
+ */
+static void sign_bench(void) {
+  static const uint8_t key[UDTSWAP_SIGN_KEY_SIZE] = {1};
+  static uint8_t out[QUOTE_BENCH_TX_ARENA_SIZE];
+  uint8_t hash[UDTSWAP_ROUTE_HASH_SIZE];
+  uint8_t *arenas = malloc((size_t)QUOTE_BENCH_SIGN_TXS * QUOTE_BENCH_TX_ARENA_SIZE);
+  udtswap_tx_t *txs = malloc(QUOTE_BENCH_SIGN_TXS * sizeof(udtswap_tx_t));
+  udtswap_sign_job_t *jobs = calloc(QUOTE_BENCH_SIGN_TXS, sizeof(udtswap_sign_job_t));
+  udtswap_sign_fn sign = NULL;
+  void *ctx = NULL;
+  long cores = sysconf(_SC_NPROCESSORS_ONLN);
+  int i, threads, ret = 0;
+  if (arenas == NULL || txs == NULL || jobs == NULL) {
+    goto done;
+  }
+#ifdef UDTSWAP_SIGN_SECP256K1
+  ctx = udtswap_secp256k1_new();
+  sign = udtswap_secp256k1_sign;
+  if (ctx == NULL) {
+    goto done;
+  }
+#endif
+  for (i = 0; i < QUOTE_BENCH_SIGN_TXS; i++) {
+    tx_build(&txs[i], arenas + (size_t)i * QUOTE_BENCH_TX_ARENA_SIZE, out, hash, 0);
+    jobs[i].tx = &txs[i];
+    jobs[i].group_start = txs[i].witness_cnt - 1;
+    jobs[i].group_cnt = 1;
+    jobs[i].key = key;
+  }
+  for (threads = 1; threads <= (cores > 0 ? cores : 1); threads *= 2) {
+    udtswap_signer_t *signer = udtswap_signer_new(threads, sign, ctx);
+    if (signer == NULL) {
+      break;
+    }
+    double start = now_ns();
+    for (i = 0; i < QUOTE_BENCH_SIGN_BATCHES && ret == 0; i++) {
+      ret = udtswap_signer_run(signer, jobs, QUOTE_BENCH_SIGN_TXS);
+    }
+    double seconds = (now_ns() - start) / 1e9;
+    printf(
+      "{\"mode\":\"sign\",\"threads\":%d,\"signed\":%d,\"ret\":%d,\"txs\":%d,\"txs_per_s\":%.0f}\n",
+      threads, sign != NULL, ret, QUOTE_BENCH_SIGN_TXS, (double)QUOTE_BENCH_SIGN_TXS * QUOTE_BENCH_SIGN_BATCHES / seconds
+    );
+    fflush(stdout);
+    udtswap_signer_free(signer);
+  }
+done:
+#ifdef UDTSWAP_SIGN_SECP256K1
+  udtswap_secp256k1_free(ctx);
+#endif
+  free(arenas);
+  free(txs);
+  free(jobs);
+}
+//message of a group hashes the raw transaction again, so messages only is about the hashed tx build of tx mode
+
+int main(int argc, char *argv[]) {
+  const char *mode_filter = argc > 1 ? argv[1] : NULL;
+  const char *dist_filter = argc > 2 ? argv[2] : NULL;
+  int mode, dist;
+  for (dist = 0; dist < QUOTE_BENCH_DIST_CNT; dist++) {
+    if (dist_filter != NULL && strcmp(dist_filter, dist_names[dist]) != 0) {
+      continue;
+    }
+    prepare(dist);
+    for (mode = 0; mode < QUOTE_BENCH_MODE_CNT; mode++) {
+      if (mode_filter != NULL && strcmp(mode_filter, "all") != 0 && strcmp(mode_filter, mode_names[mode]) != 0) {
+        continue;
+      }
+      long quotes;
+      if (mode == QUOTE_BENCH_MODE_POOLS) {
+        int level;
+        for (level = UDTSWAP_QUOTE_SIMD_NONE; level <= UDTSWAP_QUOTE_SIMD_AVX512 && udtswap_quote_simd(level) == level; level++) {
+          double ns = measure(mode, &quotes);
+          printf(
+            "{\"mode\":\"%s\",\"dist\":\"%s\",\"simd\":\"%s\",\"quotes\":%ld,\"ns_per_quote\":%.2f}\n",
+            mode_names[mode], dist_names[dist], simd_names[level], quotes, ns
+          );
+          fflush(stdout);
+        }
+        udtswap_quote_simd(UDTSWAP_QUOTE_SIMD_AVX512);
+        continue;
+      }
+      double ns = measure(mode, &quotes);
+      printf(
+        "{\"mode\":\"%s\",\"dist\":\"%s\",\"quotes\":%ld,\"ns_per_quote\":%.2f}\n",
+        mode_names[mode], dist_names[dist], quotes, ns
+      );
+      fflush(stdout);
+    }
+  }
+  if (mode_filter == NULL || strcmp(mode_filter, "all") == 0 || strcmp(mode_filter, "route") == 0) {
+    route_bench();
+  }
+  if (mode_filter == NULL || strcmp(mode_filter, "all") == 0 || strcmp(mode_filter, "snapshot") == 0) {
+    snapshot_bench();
+  }
+  if (mode_filter == NULL || strcmp(mode_filter, "all") == 0 || strcmp(mode_filter, "ingest") == 0) {
+    ingest_bench();
+  }
+  if (mode_filter == NULL || strcmp(mode_filter, "all") == 0 || strcmp(mode_filter, "tx") == 0) {
+    tx_bench();
+  }
+  if (mode_filter == NULL || strcmp(mode_filter, "all") == 0 || strcmp(mode_filter, "history") == 0) {
+    history_bench();
+  }
+  if (mode_filter == NULL || strcmp(mode_filter, "all") == 0 || strcmp(mode_filter, "sign") == 0) {
+    sign_bench();
+  }
+  return 0;
+}
@@ -0,0 +1,73 @@
+#!/bin/sh
+# Syscall accounting of traces written by udtswap_native --trace.
+# usage: syscalls.sh <udtswap_native> <trace files>
+# call sites are resolved to script functions with addr2line, native build has debug info
+
+NATIVE=$1
+shift
+ADDR2LINE=${ADDR2LINE:-addr2line}
+
+if [ -z "$NATIVE" ] || [ $# -eq 0 ]; then
+  echo "usage: syscalls.sh <udtswap_native> <trace files>" >&2
+  exit 1
+fi
+
+SITES=`mktemp`
+trap 'rm -f "$SITES"' EXIT
+
+# site -> first function of inline chain which is not a syscall wrapper of ckb_syscalls.h
+if command -v "$ADDR2LINE" > /dev/null 2>&1; then
+  awk -F '\t' '!/^#/ && $12 != "-" { n = split($12, s, ","); for (i = 1; i <= n; i++) print s[i] }' "$@" | sort -u |
+    xargs "$ADDR2LINE" -f -i -a -e "$NATIVE" |
+    awk '
+      /^0x/ { site = $0; sub(/^0x0*/, "", site); fn = 1; next }
+      fn { fn = 0; if (!(site in done) && $0 !~ /^(__internal_syscall|ckb_|\?\?)/) { sub(/^udtswap_[a-z]*_main$/, "main"); print site "\t" $0; done[site] = 1 }; next }
+      { fn = 1 }
+    ' > "$SITES"
+fi
+
+# loads with same syscall, index, source, field and offset in one script group are redundant
+awk -F '\t' -v sites="$SITES" '
+  BEGIN { while ((getline line < sites) > 0) { split(line, kv, "\t"); fn_of[kv[1]] = kv[2] } }
+  FNR == 1 {
+    split(FILENAME, path, "/")
+    group = path[length(path)]
+    sub(/\.trace$/, "", group)
+    delete seen
+    groups += 1
+    next
+  }
+  /^#/ { next }
+  {
+    fn = "?"
+    n = split($12, s, ",")
+    for (i = 1; i <= n; i++) if (s[i] in fn_of) { fn = fn_of[s[i]]; break }
+    bytes = $13 == "-" ? 0 : length($13) / 2
+    calls[$1] += 1; call_bytes[$1] += bytes; call_cycles[$1] += $10
+    fn_calls[fn] += 1; fn_cycles[fn] += $10
+    total_calls += 1; total_cycles += $10
+    if ($1 ~ /^load_/) {
+      key = $1 SUBSEP $3 SUBSEP $4 SUBSEP $5 SUBSEP $6
+      if (key in seen) {
+        redundant += 1; redundant_cycles += $10
+        fn_redundant[fn] += 1
+        dup = $1 " " $3 " " $4 " " $5 " @" fn " (first @" seen[key] ")"
+        dup_cnt[dup] += 1; dup_cycles[dup] += $10
+      } else {
+        seen[key] = fn
+      }
+    }
+  }
+  END {
+    printf "%d script groups, %d syscalls, %d estimated cycles, %d redundant loads (%d cycles)\n\n", groups, total_calls, total_cycles, redundant, redundant_cycles
+    printf "%-24s %8s %10s %12s\n", "syscall", "count", "bytes", "cycles"
+    for (k in calls) printf "%-24s %8d %10d %12d\n", k, calls[k], call_bytes[k], call_cycles[k] | "sort -k4 -n -r"
+    close("sort -k4 -n -r")
+    printf "\n%-32s %8s %10s %12s\n", "function", "count", "redundant", "cycles"
+    for (k in fn_calls) printf "%-32s %8d %10d %12d\n", k, fn_calls[k], fn_redundant[k], fn_cycles[k] | "sort -k4 -n -r"
+    close("sort -k4 -n -r")
+    printf "\n%8s %12s  %s\n", "count", "cycles", "redundant load (syscall index source field @function)"
+    for (k in dup_cnt) printf "%8d %12d  %s\n", dup_cnt[k], dup_cycles[k], k | "sort -k2 -n -r"
+    close("sort -k2 -n -r")
+  }
+' "$@"
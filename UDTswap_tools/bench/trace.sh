@@ -0,0 +1,43 @@
+#!/bin/sh
+# Record syscalls of every UDTswap script group of every transaction shape with the native build.
+# usage: trace.sh <fixture tool> <udtswap_native> <output dir>
+
+FIXTURE=${1:-./build/udtswap_fixture}
+NATIVE=${2:-./build/native/udtswap_native}
+OUT_DIR=${3:-./build/trace}
+SWAP_POOLS=${SWAP_POOLS:-"1 2 4"}
+
+mkdir -p "$OUT_DIR/tx"
+rm -f "$OUT_DIR"/*.trace
+failed=0
+
+# trace_shape <shape name> <fixture arguments>
+trace_shape() {
+  name=$1
+  shift
+  tx="$OUT_DIR/tx/$name.json"
+  "$FIXTURE" "$@" -o "$tx" || { failed=1; return; }
+  pools=1
+  [ "$1" = "swap" ] && pools=`echo "$@" | sed -n 's/.*-n \([0-9]*\).*/\1/p'`
+  "$FIXTURE" groups "$1" -n "${pools:-1}" > "$OUT_DIR/groups"
+  while read script group cell index; do
+    trace="$OUT_DIR/$name-$script-$cell$index.trace"
+    "$NATIVE" --tx-file "$tx" --script-group-type "$group" --cell-type "$cell" --cell-index "$index" --trace "$trace" > /dev/null || failed=1
+  done < "$OUT_DIR/groups"
+  rm -f "$OUT_DIR/groups"
+}
+
+for pair in ckb-udt udt-udt; do
+  for data in legacy extended; do
+    ext=""
+    [ "$data" = "extended" ] && ext="-x"
+    trace_shape "create-$pair-$data" create -p $pair $ext
+    trace_shape "add-$pair-$data" add -p $pair $ext
+    trace_shape "remove-$pair-$data" remove -p $pair $ext
+    for n in $SWAP_POOLS; do
+      trace_shape "swap$n-$pair-$data" swap -p $pair -n $n $ext
+    done
+  done
+done
+
+exit $failed
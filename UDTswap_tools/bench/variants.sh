@@ -0,0 +1,52 @@
+#!/bin/sh
+# Compare script sizes and cycles of builds, first build is the reference.
+# usage: variants.sh <build dir> <build dir> ...
+# each build dir has bin/ of scripts and cycles.tsv of cycles.sh
+
+SCRIPTS="UDTswap_udt_based UDTswap_lock_udt_based UDTswap_liquidity_UDT_udt_based"
+
+if [ $# -lt 2 ]; then
+  echo "usage: variants.sh <reference build dir> <build dir> ..." >&2
+  exit 1
+fi
+
+TABLE=`mktemp`
+trap 'rm -f "$TABLE"' EXIT
+
+# <build> size <script> <bytes> and <build> cycles <transaction> <cycles>
+for dir in "$@"; do
+  name=`basename "$dir"`
+  for script in $SCRIPTS; do
+    printf "%s\tsize\t%s\t%s\n" "$name" "$script" `wc -c < "$dir/bin/$script"` >> "$TABLE"
+  done
+  awk -F '\t' -v name="$name" '
+    NR > 1 { total[$1] += $6; if (!($1 in seen)) { seen[$1] = 1; order[++n] = $1 } }
+    END { for (i = 1; i <= n; i++) printf "%s\tcycles\t%s\t%d\n", name, order[i], total[order[i]] }
+  ' "$dir/cycles.tsv" >> "$TABLE"
+done
+
+awk -F '\t' '
+  !($1 in build_seen) { build_seen[$1] = 1; builds[++b] = $1 }
+  !(($2, $3) in row_seen) { row_seen[$2, $3] = 1; rows[++r] = $2 SUBSEP $3 }
+  { v[$1, $2, $3] = $4 }
+  END {
+    kind = ""
+    for (i = 1; i <= r; i++) {
+      split(rows[i], k, SUBSEP)
+      if (k[1] != kind) {
+        kind = k[1]
+        printf "\n%-34s", kind == "size" ? "script bytes" : "transaction cycles"
+        for (j = 1; j <= b; j++) printf " %14s%s", builds[j], j == 1 ? "" : "         "
+        printf "\n"
+      }
+      printf "%-34s", k[2]
+      base = v[builds[1], k[1], k[2]]
+      for (j = 1; j <= b; j++) {
+        cur = v[builds[j], k[1], k[2]]
+        if (j == 1) printf " %14d", cur
+        else printf " %14d %+7.2f%%", cur, (base > 0 ? 100 * (cur - base) / base : 0)
+      }
+      printf "\n"
+    }
+  }
+' "$TABLE"
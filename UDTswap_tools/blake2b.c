@@ -0,0 +1,145 @@
+#include <string.h>
+#include "blake2b.h"
+
+static const uint64_t blake2b_iv[8] = {
+  0x6a09e667f3bcc908ULL, 0xbb67ae8584caa73bULL,
+  0x3c6ef372fe94f82bULL, 0xa54ff53a5f1d36f1ULL,
+  0x510e527fade682d1ULL, 0x9b05688c2b3e6c1fULL,
+  0x1f83d9abfb41bd6bULL, 0x5be0cd19137e2179ULL
+};
+
+static const uint8_t blake2b_sigma[12][16] = {
+  { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15},
+  {14, 10, 4, 8, 9, 15, 13, 6, 1, 12, 0, 2, 11, 7, 5, 3},
+  {11, 8, 12, 0, 5, 2, 15, 13, 10, 14, 3, 6, 7, 1, 9, 4},
+  { 7, 9, 3, 1, 13, 12, 11, 14, 2, 6, 5, 10, 4, 0, 15, 8},
+  { 9, 0, 5, 7, 2, 4, 10, 15, 14, 1, 11, 12, 6, 8, 3, 13},
+  { 2, 12, 6, 10, 0, 11, 8, 3, 4, 13, 7, 5, 15, 14, 1, 9},
+  {12, 5, 1, 15, 14, 13, 4, 10, 0, 7, 6, 3, 9, 2, 8, 11},
+  {13, 11, 7, 14, 12, 1, 3, 9, 5, 0, 15, 4, 8, 6, 2, 10},
+  { 6, 15, 14, 9, 11, 3, 0, 8, 12, 2, 13, 7, 1, 4, 10, 5},
+  {10, 2, 8, 4, 7, 6, 1, 5, 15, 11, 9, 14, 3, 12, 13, 0},
+  { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15},
+  {14, 10, 4, 8, 9, 15, 13, 6, 1, 12, 0, 2, 11, 7, 5, 3}
+};
+
+static const uint8_t ckb_personal[16] = "ckb-default-hash";
+
+static uint64_t load64(const uint8_t *p) {
+  uint64_t ret = 0;
+  int i;
+  for (i = 0; i < 8; i++) {
+    ret |= (uint64_t)p[i] << (8 * i);
+  }
+  return ret;
+}
+
+static uint64_t rotr64(uint64_t x, int n) {
+  return (x >> n) | (x << (64 - n));
+}
+
+#define G(r, i, a, b, c, d)                   \
+  do {                                        \
+    a = a + b + m[blake2b_sigma[r][2 * i]];   \
+    d = rotr64(d ^ a, 32);                    \
+    c = c + d;                                \
+    b = rotr64(b ^ c, 24);                    \
+    a = a + b + m[blake2b_sigma[r][2 * i + 1]]; \
+    d = rotr64(d ^ a, 16);                    \
+    c = c + d;                                \
+    b = rotr64(b ^ c, 63);                    \
+  } while (0)
+
+static void blake2b_compress(blake2b_state *s, const uint8_t block[BLAKE2B_BLOCK_SIZE], int last) {
+  uint64_t m[16];
+  uint64_t v[16];
+  int i, r;
+
+  for (i = 0; i < 16; i++) {
+    m[i] = load64(block + 8 * i);
+  }
+  for (i = 0; i < 8; i++) {
+    v[i] = s->h[i];
+    v[i + 8] = blake2b_iv[i];
+  }
+  v[12] ^= s->t[0];
+  v[13] ^= s->t[1];
+  if (last) {
+    v[14] = ~v[14];
+  }
+
+  for (r = 0; r < 12; r++) {
+    G(r, 0, v[0], v[4], v[8], v[12]);
+    G(r, 1, v[1], v[5], v[9], v[13]);
+    G(r, 2, v[2], v[6], v[10], v[14]);
+    G(r, 3, v[3], v[7], v[11], v[15]);
+    G(r, 4, v[0], v[5], v[10], v[15]);
+    G(r, 5, v[1], v[6], v[11], v[12]);
+    G(r, 6, v[2], v[7], v[8], v[13]);
+    G(r, 7, v[3], v[4], v[9], v[14]);
+  }
+
+  for (i = 0; i < 8; i++) {
+    s->h[i] ^= v[i] ^ v[i + 8];
+  }
+}
+
+static void blake2b_increment(blake2b_state *s, uint64_t inc) {
+  s->t[0] += inc;
+  if (s->t[0] < inc) {
+    s->t[1] += 1;
+  }
+}
+
+void blake2b_init(blake2b_state *s) {
+  uint8_t param[64];
+  int i;
+
+  memset(param, 0, sizeof(param));
+  param[0] = BLAKE2B_HASH_SIZE; /* digest length */
+  param[2] = 1;                 /* fanout */
+  param[3] = 1;                 /* depth */
+  memcpy(&param[48], ckb_personal, sizeof(ckb_personal));
+
+  memset(s, 0, sizeof(*s));
+  for (i = 0; i < 8; i++) {
+    s->h[i] = blake2b_iv[i] ^ load64(param + 8 * i);
+  }
+}
+
+void blake2b_update(blake2b_state *s, const void *in, size_t in_len) {
+  const uint8_t *p = (const uint8_t *)in;
+  while (in_len > 0) {
+    if (s->buf_len == BLAKE2B_BLOCK_SIZE) {
+      /* only compress full buffer when more input follows, last block is compressed in final */
+      blake2b_increment(s, BLAKE2B_BLOCK_SIZE);
+      blake2b_compress(s, s->buf, 0);
+      s->buf_len = 0;
+    }
+    size_t fill = BLAKE2B_BLOCK_SIZE - s->buf_len;
+    if (fill > in_len) {
+      fill = in_len;
+    }
+    memcpy(s->buf + s->buf_len, p, fill);
+    s->buf_len += fill;
+    p += fill;
+    in_len -= fill;
+  }
+}
+
+void blake2b_final(blake2b_state *s, uint8_t out[BLAKE2B_HASH_SIZE]) {
+  int i;
+  blake2b_increment(s, s->buf_len);
+  memset(s->buf + s->buf_len, 0, BLAKE2B_BLOCK_SIZE - s->buf_len);
+  blake2b_compress(s, s->buf, 1);
+  for (i = 0; i < BLAKE2B_HASH_SIZE; i++) {
+    out[i] = (s->h[i / 8] >> (8 * (i % 8))) & 0xff;
+  }
+}
+
+void blake2b_hash(const void *in, size_t in_len, uint8_t out[BLAKE2B_HASH_SIZE]) {
+  blake2b_state s;
+  blake2b_init(&s);
+  blake2b_update(&s, in, in_len);
+  blake2b_final(&s, out);
+}
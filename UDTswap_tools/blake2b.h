@@ -0,0 +1,23 @@
+#ifndef UDTSWAP_BLAKE2B_H_
+#define UDTSWAP_BLAKE2B_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define BLAKE2B_BLOCK_SIZE 128
+#define BLAKE2B_HASH_SIZE 32
+
+/* blake2b-256 with CKB personalization "ckb-default-hash" */
+typedef struct {
+  uint64_t h[8];
+  uint64_t t[2];
+  uint8_t buf[BLAKE2B_BLOCK_SIZE];
+  size_t buf_len;
+} blake2b_state;
+
+void blake2b_init(blake2b_state *s);
+void blake2b_update(blake2b_state *s, const void *in, size_t in_len);
+void blake2b_final(blake2b_state *s, uint8_t out[BLAKE2B_HASH_SIZE]);
+void blake2b_hash(const void *in, size_t in_len, uint8_t out[BLAKE2B_HASH_SIZE]);
+
+#endif /* UDTSWAP_BLAKE2B_H_ */
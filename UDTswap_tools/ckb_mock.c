@@ -0,0 +1,568 @@
+#define _GNU_SOURCE
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include "../UDTswap_scripts/ckb_consts.h"
+#include "blake2b.h"
+#include "ckb_mock.h"
+
+typedef struct {
+  const fixture_tx_t *tx;
+  fixture_script_t script;
+  uint8_t script_hash[FIXTURE_HASH_SIZE];
+  size_t group_inputs[FIXTURE_MAX_CELLS];
+  size_t group_input_cnt;
+  size_t group_outputs[FIXTURE_MAX_CELLS];
+  size_t group_output_cnt;
+  jmp_buf exit_buf;
+  int running;
+  int exit_code;
+  uint64_t syscall_cnt;
+  FILE *trace_fp;
+  const trace_t *replay;
+  size_t replay_pos;
+} ckb_mock_state;
+
+static ckb_mock_state mock;
+static uint64_t mock_run_id;
+
+static int same_script(const fixture_script_t *a, const fixture_script_t *b) {
+  return (
+    memcmp(a->code_hash, b->code_hash, FIXTURE_HASH_SIZE) == 0 &&
+    a->hash_type == b->hash_type &&
+    a->args_len == b->args_len &&
+    memcmp(a->args, b->args, a->args_len) == 0
+  );
+}
+
+static int in_group(const fixture_cell_t *cell, int group_type) {
+  if (group_type == CKB_MOCK_GROUP_LOCK) {
+    return same_script(&cell->lock, &mock.script);
+  }
+  return cell->has_type && same_script(&cell->type, &mock.script);
+}
+
+int ckb_mock_init(const fixture_tx_t *tx, int group_type, size_t source, size_t index) {
+  const fixture_cell_t *cell;
+  size_t i;
+  memset(&mock, 0, sizeof(mock));
+  mock.tx = tx;
+  if (source == CKB_SOURCE_INPUT && index < tx->input_cnt) {
+    cell = &tx->inputs[index];
+  } else if (source == CKB_SOURCE_OUTPUT && index < tx->output_cnt && group_type == CKB_MOCK_GROUP_TYPE) {
+    cell = &tx->outputs[index];
+  } else {
+    return CKB_MOCK_ERROR_INVALID_SOURCE;
+  }
+  if (group_type == CKB_MOCK_GROUP_LOCK) {
+    mock.script = cell->lock;
+  } else if (cell->has_type) {
+    mock.script = cell->type;
+  } else {
+    return CKB_MOCK_ERROR_NO_SCRIPT;
+  }
+  fixture_script_hash(&mock.script, mock.script_hash);
+
+  for (i = 0; i < tx->input_cnt; i++) {
+    if (in_group(&tx->inputs[i], group_type)) {
+      mock.group_inputs[mock.group_input_cnt++] = i;
+    }
+  }
+  if (group_type == CKB_MOCK_GROUP_TYPE) {
+    for (i = 0; i < tx->output_cnt; i++) {
+      if (in_group(&tx->outputs[i], group_type)) {
+        mock.group_outputs[mock.group_output_cnt++] = i;
+      }
+    }
+  }
+  return 0;
+}
+
+const fixture_script_t *ckb_mock_script(void) {
+  return &mock.script;
+}
+
+uint64_t ckb_mock_syscall_count(void) {
+  return mock.syscall_cnt;
+}
+
+int ckb_mock_init_replay(const trace_t *trace) {
+  memset(&mock, 0, sizeof(mock));
+  mock.replay = trace;
+  return 0;
+}
+
+void ckb_mock_trace(FILE *fp) {
+  mock.trace_fp = fp;
+}
+
+int ckb_mock_run(ckb_mock_entry entry) {
+  int ret;
+  mock.syscall_cnt = 0;
+  mock.replay_pos = 0;
+  mock_run_id += 1;
+  if (setjmp(mock.exit_buf) != 0) {
+    mock.running = 0;
+    return mock.exit_code;
+  }
+  mock.running = 1;
+  ret = entry(0, NULL);
+  mock.running = 0;
+  return (int8_t)ret;
+  //exit code of CKB-VM is int8
+}
+
+uint64_t ckb_mock_run_id(void) {
+  return mock_run_id;
+}
+
+/*
+ * same as CKB-VM, partial loading from offset, len is set to full length from offset
+ */
+static int store_data(long addr, long len_addr, long offset, const uint8_t *data, size_t data_len) {
+  uint64_t *len = (uint64_t *)len_addr;
+  size_t full_len = (size_t)offset < data_len ? data_len - (size_t)offset : 0;
+  size_t copy_len = *len < full_len ? *len : full_len;
+  if (copy_len > 0) {
+    memcpy((void *)addr, data + offset, copy_len);
+  }
+  *len = full_len;
+  return CKB_SUCCESS;
+}
+
+static const fixture_cell_t *cell_at(size_t source, size_t index) {
+  const fixture_tx_t *tx = mock.tx;
+  switch (source) {
+    case CKB_SOURCE_INPUT:
+      return index < tx->input_cnt ? &tx->inputs[index] : NULL;
+    case CKB_SOURCE_OUTPUT:
+      return index < tx->output_cnt ? &tx->outputs[index] : NULL;
+    case CKB_SOURCE_CELL_DEP:
+      return index < tx->dep_cnt ? &tx->deps[index] : NULL;
+    case CKB_SOURCE_GROUP_INPUT:
+      return index < mock.group_input_cnt ? &tx->inputs[mock.group_inputs[index]] : NULL;
+    case CKB_SOURCE_GROUP_OUTPUT:
+      return index < mock.group_output_cnt ? &tx->outputs[mock.group_outputs[index]] : NULL;
+  }
+  return NULL;
+}
+
+/*
+ * same as CKB-VM, content is copied to page aligned memory and the rest of memory is zeroed,
+ * memory is executable and not writable until code is loaded there again
+ */
+static int load_cell_code(long addr, long memory_size, long offset, long content_size, size_t index, size_t source) {
+  const fixture_cell_t *cell = cell_at(source, index);
+  if (cell == NULL) {
+    return CKB_INDEX_OUT_OF_BOUND;
+  }
+  if (
+    addr % CKB_MOCK_PAGE_SIZE != 0 || memory_size % CKB_MOCK_PAGE_SIZE != 0 ||
+    content_size > memory_size || (size_t)offset > cell->data_len || (size_t)content_size > cell->data_len - offset
+  ) {
+    return CKB_MOCK_ERROR_CODE_MEMORY;
+  }
+  if (mprotect((void *)addr, memory_size, PROT_READ | PROT_WRITE) != 0) {
+    return CKB_MOCK_ERROR_CODE_MEMORY;
+  }
+  memcpy((void *)addr, cell->data + offset, content_size);
+  memset((uint8_t *)addr + content_size, 0, memory_size - content_size);
+  __builtin___clear_cache((char *)addr, (char *)addr + memory_size);
+  if (mprotect((void *)addr, memory_size, PROT_READ | PROT_EXEC) != 0) {
+    return CKB_MOCK_ERROR_CODE_MEMORY;
+  }
+  return CKB_SUCCESS;
+}
+
+static int is_input_source(size_t source) {
+  return source == CKB_SOURCE_INPUT || source == CKB_SOURCE_GROUP_INPUT;
+}
+
+static void put_u64(uint8_t *p, uint64_t v) {
+  int i;
+  for (i = 0; i < 8; i++) {
+    p[i] = (v >> (8 * i)) & 0xff;
+  }
+}
+
+static uint64_t get_u64(const uint8_t *p) {
+  uint64_t ret = 0;
+  int i;
+  for (i = 0; i < 8; i++) {
+    ret |= (uint64_t)p[i] << (8 * i);
+  }
+  return ret;
+}
+
+static int load_cell_by_field(long addr, long len, long offset, size_t index, size_t source, size_t field) {
+  const fixture_cell_t *cell = cell_at(source, index);
+  uint8_t buf[64 + 2 * (64 + FIXTURE_MAX_ARGS)];
+  uint8_t hash[FIXTURE_HASH_SIZE];
+  uint32_t buf_len;
+  if (cell == NULL) {
+    return CKB_INDEX_OUT_OF_BOUND;
+  }
+  switch (field) {
+    case CKB_CELL_FIELD_CAPACITY:
+      put_u64(buf, cell->capacity);
+      return store_data(addr, len, offset, buf, 8);
+    case CKB_CELL_FIELD_DATA_HASH:
+      fixture_data_hash(cell, hash);
+      return store_data(addr, len, offset, hash, FIXTURE_HASH_SIZE);
+    case CKB_CELL_FIELD_LOCK:
+      buf_len = fixture_script_serialize(&cell->lock, buf);
+      return store_data(addr, len, offset, buf, buf_len);
+    case CKB_CELL_FIELD_LOCK_HASH:
+      fixture_script_hash(&cell->lock, hash);
+      return store_data(addr, len, offset, hash, FIXTURE_HASH_SIZE);
+    case CKB_CELL_FIELD_TYPE:
+      if (!cell->has_type) {
+        return CKB_ITEM_MISSING;
+      }
+      buf_len = fixture_script_serialize(&cell->type, buf);
+      return store_data(addr, len, offset, buf, buf_len);
+    case CKB_CELL_FIELD_TYPE_HASH:
+      if (!cell->has_type) {
+        return CKB_ITEM_MISSING;
+      }
+      fixture_script_hash(&cell->type, hash);
+      return store_data(addr, len, offset, hash, FIXTURE_HASH_SIZE);
+    case CKB_CELL_FIELD_OCCUPIED_CAPACITY: {
+      uint64_t occupied = 8 + cell->data_len + FIXTURE_HASH_SIZE + 1 + cell->lock.args_len;
+      if (cell->has_type) {
+        occupied += FIXTURE_HASH_SIZE + 1 + cell->type.args_len;
+      }
+      put_u64(buf, occupied * 100000000ULL);
+      return store_data(addr, len, offset, buf, 8);
+    }
+  }
+  return CKB_ITEM_MISSING;
+}
+
+static int load_input_by_field(long addr, long len, long offset, size_t index, size_t source, size_t field) {
+  const fixture_cell_t *cell;
+  uint8_t buf[FIXTURE_INPUT_SIZE];
+  if (!is_input_source(source) || (cell = cell_at(source, index)) == NULL) {
+    return CKB_INDEX_OUT_OF_BOUND;
+  }
+  fixture_cell_input_serialize(cell, buf);
+  if (field == CKB_INPUT_FIELD_OUT_POINT) {
+    return store_data(addr, len, offset, buf + 8, FIXTURE_HASH_SIZE + 4);
+  }
+  if (field == CKB_INPUT_FIELD_SINCE) {
+    return store_data(addr, len, offset, buf, 8);
+  }
+  return CKB_ITEM_MISSING;
+}
+
+static const fixture_header_t *header_at(size_t source, size_t index, int *ret) {
+  *ret = CKB_SUCCESS;
+  if (source != CKB_SOURCE_HEADER_DEP) {
+    const fixture_cell_t *cell = cell_at(source, index);
+    if (cell == NULL || !cell->has_header) {
+      *ret = cell == NULL ? CKB_INDEX_OUT_OF_BOUND : CKB_ITEM_MISSING;
+      return NULL;
+    }
+    return &mock.tx->headers[cell->header_index];
+  }
+  //block of cell is a header dep, or no block
+  if (index >= mock.tx->header_cnt) {
+    *ret = CKB_INDEX_OUT_OF_BOUND;
+    return NULL;
+  }
+  return &mock.tx->headers[index];
+}
+
+static int load_header_by_field(long addr, long len, long offset, size_t index, size_t source, size_t field) {
+  int ret;
+  uint8_t buf[8];
+  const fixture_header_t *header = header_at(source, index, &ret);
+  if (header == NULL) {
+    return ret;
+  }
+  uint64_t epoch = get_u64(header->raw + 24);
+  switch (field) {
+    case CKB_HEADER_FIELD_EPOCH_NUMBER:
+      put_u64(buf, epoch & 0xffffff);
+      break;
+    case CKB_HEADER_FIELD_EPOCH_START_BLOCK_NUMBER:
+      put_u64(buf, header->number - ((epoch >> 24) & 0xffff));
+      break;
+    case CKB_HEADER_FIELD_EPOCH_LENGTH:
+      put_u64(buf, (epoch >> 40) & 0xffff);
+      break;
+    default:
+      return CKB_ITEM_MISSING;
+  }
+  return store_data(addr, len, offset, buf, 8);
+}
+
+static int load_witness(long addr, long len, long offset, size_t index, size_t source) {
+  size_t witness_index;
+  switch (source) {
+    case CKB_SOURCE_INPUT:
+    case CKB_SOURCE_OUTPUT:
+      witness_index = index;
+      break;
+    case CKB_SOURCE_GROUP_INPUT:
+      if (index >= mock.group_input_cnt) {
+        return CKB_INDEX_OUT_OF_BOUND;
+      }
+      witness_index = mock.group_inputs[index];
+      break;
+    case CKB_SOURCE_GROUP_OUTPUT:
+      if (index >= mock.group_output_cnt) {
+        return CKB_INDEX_OUT_OF_BOUND;
+      }
+      witness_index = mock.group_outputs[index];
+      break;
+    default:
+      return CKB_INDEX_OUT_OF_BOUND;
+  }
+  if (witness_index >= mock.tx->witness_cnt) {
+    return CKB_INDEX_OUT_OF_BOUND;
+  }
+  return store_data(addr, len, offset, mock.tx->witnesses[witness_index], mock.tx->witness_len[witness_index]);
+}
+
+static long dispatch_syscall(long n, long a0, long a1, long a2, long a3, long a4, long a5) {
+  const fixture_cell_t *cell;
+  uint8_t buf[64 + 2 * (64 + FIXTURE_MAX_ARGS)];
+  uint32_t buf_len;
+  int ret;
+
+  switch (n) {
+    case SYS_exit:
+      if (!mock.running) {
+        fprintf(stderr, "ckb_exit outside of ckb_mock_run\n");
+        return CKB_INDEX_OUT_OF_BOUND;
+      }
+      mock.exit_code = (int8_t)a0;
+      longjmp(mock.exit_buf, 1);
+    case SYS_ckb_load_script:
+      buf_len = fixture_script_serialize(&mock.script, buf);
+      return store_data(a0, a1, a2, buf, buf_len);
+    case SYS_ckb_load_tx_hash:
+      //transaction hash is not computed by mock, scripts of UDTswap do not use it
+      memset(buf, 0, FIXTURE_HASH_SIZE);
+      return store_data(a0, a1, a2, buf, FIXTURE_HASH_SIZE);
+    case SYS_ckb_load_script_hash:
+      return store_data(a0, a1, a2, mock.script_hash, FIXTURE_HASH_SIZE);
+    case SYS_ckb_load_cell:
+      if ((cell = cell_at(a4, a3)) == NULL) {
+        return CKB_INDEX_OUT_OF_BOUND;
+      }
+      buf_len = fixture_cell_output_serialize(cell, buf);
+      return store_data(a0, a1, a2, buf, buf_len);
+    case SYS_ckb_load_header: {
+      const fixture_header_t *header = header_at(a4, a3, &ret);
+      if (header == NULL) {
+        return ret;
+      }
+      return store_data(a0, a1, a2, header->raw, FIXTURE_HEADER_SIZE);
+    }
+    case SYS_ckb_load_input:
+      if (!is_input_source(a4) || (cell = cell_at(a4, a3)) == NULL) {
+        return CKB_INDEX_OUT_OF_BOUND;
+      }
+      fixture_cell_input_serialize(cell, buf);
+      return store_data(a0, a1, a2, buf, FIXTURE_INPUT_SIZE);
+    case SYS_ckb_load_witness:
+      return load_witness(a0, a1, a2, a3, a4);
+    case SYS_ckb_load_cell_by_field:
+      return load_cell_by_field(a0, a1, a2, a3, a4, a5);
+    case SYS_ckb_load_header_by_field:
+      return load_header_by_field(a0, a1, a2, a3, a4, a5);
+    case SYS_ckb_load_input_by_field:
+      return load_input_by_field(a0, a1, a2, a3, a4, a5);
+    case SYS_ckb_load_cell_data:
+      if ((cell = cell_at(a4, a3)) == NULL) {
+        return CKB_INDEX_OUT_OF_BOUND;
+      }
+      return store_data(a0, a1, a2, cell->data, cell->data_len);
+    case SYS_ckb_load_cell_data_as_code:
+      return load_cell_code(a0, a1, a2, a3, a4, a5);
+    case SYS_ckb_debug:
+      fprintf(stderr, "[debug] %s\n", (const char *)a0);
+      return CKB_SUCCESS;
+    case SYS_ckb_current_cycles: {
+      //no cycles in native build, monotonic nanoseconds instead
+      struct timespec ts;
+      clock_gettime(CLOCK_MONOTONIC, &ts);
+      return (long)ts.tv_sec * 1000000000L + ts.tv_nsec;
+    }
+  }
+  fprintf(stderr, "unknown syscall %ld\n", n);
+  return CKB_INDEX_OUT_OF_BOUND;
+}
+
+static int is_load(long n) {
+  switch (n) {
+    case SYS_ckb_load_script:
+    case SYS_ckb_load_tx_hash:
+    case SYS_ckb_load_script_hash:
+    case SYS_ckb_load_cell:
+    case SYS_ckb_load_header:
+    case SYS_ckb_load_input:
+    case SYS_ckb_load_witness:
+    case SYS_ckb_load_cell_by_field:
+    case SYS_ckb_load_header_by_field:
+    case SYS_ckb_load_input_by_field:
+    case SYS_ckb_load_cell_data:
+      return 1;
+  }
+  return 0;
+}
+
+/*
+ * syscall arguments of trace record, loads are (addr, len, offset, index, source, field)
+ */
+static void record_args(trace_record_t *record, long n, long a1, long a2, long a3, long a4, long a5) {
+  memset(record, 0, sizeof(trace_record_t));
+  record->number = n;
+  record->index = TRACE_NONE;
+  record->source = TRACE_NONE;
+  record->field = TRACE_NONE;
+  record->offset = TRACE_NONE;
+  record->requested_len = TRACE_NONE;
+  record->returned_len = TRACE_NONE;
+  if (is_load(n)) {
+    record->offset = a2;
+    record->requested_len = (long)*(uint64_t *)a1;
+  }
+  switch (n) {
+    case SYS_ckb_load_cell_by_field:
+    case SYS_ckb_load_header_by_field:
+    case SYS_ckb_load_input_by_field:
+      record->field = a5;
+      //fall through
+    case SYS_ckb_load_cell:
+    case SYS_ckb_load_header:
+    case SYS_ckb_load_input:
+    case SYS_ckb_load_witness:
+    case SYS_ckb_load_cell_data:
+      record->index = a3;
+      record->source = a4;
+      break;
+    case SYS_ckb_load_cell_data_as_code:
+      record->index = a4;
+      record->source = a5;
+      break;
+  }
+}
+
+static uint64_t now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static long trace_syscall(void **frames, int frame_cnt, long n, long a0, long a1, long a2, long a3, long a4, long a5) {
+  trace_record_t record;
+  Dl_info info;
+  int i;
+
+  record_args(&record, n, a1, a2, a3, a4, a5);
+  for (i = 0; i < frame_cnt && i < TRACE_MAX_SITES; i++) {
+    if (dladdr(frames[i], &info) == 0) {
+      break;
+    }
+    record.sites[i] = (uintptr_t)frames[i] - (uintptr_t)info.dli_fbase - 1;
+    //return address to call address
+  }
+  if (n == SYS_exit) {
+    record.ret = (int8_t)a0;
+    record.cycles = trace_syscall_cycles(0);
+    trace_write_record(mock.trace_fp, &record);
+    return dispatch_syscall(n, a0, a1, a2, a3, a4, a5);
+  }
+
+  uint64_t start = now_ns();
+  record.ret = dispatch_syscall(n, a0, a1, a2, a3, a4, a5);
+  record.ns = now_ns() - start;
+  if (is_load(n)) {
+    record.returned_len = (long)*(uint64_t *)a1;
+    if (record.ret == CKB_SUCCESS && a0 != 0) {
+      record.data = (uint8_t *)a0;
+      record.data_len = (uint32_t)(record.requested_len < record.returned_len ? record.requested_len : record.returned_len);
+    }
+  } else if (n == SYS_ckb_debug) {
+    record.data = (uint8_t *)a0;
+    record.data_len = (uint32_t)strlen((const char *)a0);
+  }
+  record.cycles = trace_syscall_cycles(n == SYS_ckb_debug ? 0 : record.data_len);
+  trace_write_record(mock.trace_fp, &record);
+  return record.ret;
+}
+
+static long replay_diverged(size_t pos, long n) {
+  fprintf(stderr, "replay diverged at syscall %zu: %s\n", pos, trace_syscall_name(n));
+  mock.exit_code = CKB_MOCK_ERROR_REPLAY;
+  if (mock.running) {
+    longjmp(mock.exit_buf, 1);
+  }
+  return CKB_MOCK_ERROR_REPLAY;
+}
+
+/*
+ * syscalls are served by trace records in order, arguments should be same as recorded
+ */
+static long replay_syscall(long n, long a0, long a1, long a2, long a3, long a4, long a5) {
+  const trace_t *trace = mock.replay;
+  const trace_record_t *record;
+  trace_record_t args;
+  size_t pos = mock.replay_pos++;
+
+  record_args(&args, n, a1, a2, a3, a4, a5);
+  if (pos >= trace->record_cnt) {
+    return replay_diverged(pos, n);
+  }
+  record = &trace->records[pos];
+  if (
+    record->number != n ||
+    record->index != args.index ||
+    record->source != args.source ||
+    record->field != args.field ||
+    record->offset != args.offset
+  ) {
+    return replay_diverged(pos, n);
+  }
+  switch (n) {
+    case SYS_exit:
+    case SYS_ckb_debug:
+      return dispatch_syscall(n, a0, a1, a2, a3, a4, a5);
+  }
+  if (is_load(n)) {
+    uint64_t *len = (uint64_t *)a1;
+    if (record->ret == CKB_SUCCESS && a0 != 0) {
+      uint64_t copy_len = *len < (uint64_t)record->returned_len ? *len : (uint64_t)record->returned_len;
+      if (copy_len > record->data_len) {
+        return replay_diverged(pos, n);
+      }
+      //more bytes are requested than recorded
+      if (copy_len > 0) {
+        memcpy((void *)a0, record->data, copy_len);
+      }
+    }
+    *len = (uint64_t)record->returned_len;
+  }
+  return record->ret;
+}
+
+long ckb_mock_syscall(long n, long a0, long a1, long a2, long a3, long a4, long a5) {
+  mock.syscall_cnt += 1;
+  if (mock.replay != NULL) {
+    return replay_syscall(n, a0, a1, a2, a3, a4, a5);
+  }
+  if (mock.trace_fp != NULL) {
+    void *frames[TRACE_MAX_SITES + 1];
+    int frame_cnt = backtrace(frames, TRACE_MAX_SITES + 1);
+    //first frame is ckb_mock_syscall
+    return trace_syscall(frames + 1, frame_cnt - 1, n, a0, a1, a2, a3, a4, a5);
+  }
+  return dispatch_syscall(n, a0, a1, a2, a3, a4, a5);
+}
@@ -0,0 +1,47 @@
+#ifndef UDTSWAP_CKB_MOCK_H_
+#define UDTSWAP_CKB_MOCK_H_
+
+#include <stdio.h>
+#include "fixture.h"
+#include "trace.h"
+
+#define CKB_MOCK_GROUP_LOCK FIXTURE_GROUP_LOCK
+#define CKB_MOCK_GROUP_TYPE FIXTURE_GROUP_TYPE
+
+#define CKB_MOCK_ERROR_NO_SCRIPT -5
+#define CKB_MOCK_ERROR_INVALID_SOURCE -6
+#define CKB_MOCK_ERROR_CODE_MEMORY -7
+#define CKB_MOCK_ERROR_REPLAY -128
+
+/* load_cell_data_as_code memory should be aligned to pages of CKB-VM and host */
+#define CKB_MOCK_PAGE_SIZE 4096
+
+typedef int (*ckb_mock_entry)(int argc, char* argv[]);
+
+/*
+ * syscall backend of scripts compiled with CKB_SYSCALLS_MOCK
+ * script group is the lock or type script of cell at index of source, as ckb-debugger
+ * tx should not be changed while mock is running
+ */
+int ckb_mock_init(const fixture_tx_t *tx, int group_type, size_t source, size_t index);
+const fixture_script_t *ckb_mock_script(void);
+
+/*
+ * script group of trace, syscalls are served by records of trace instead of tx
+ * run returns CKB_MOCK_ERROR_REPLAY when script makes syscalls different from trace
+ */
+int ckb_mock_init_replay(const trace_t *trace);
+
+/* every syscall of following runs is written to fp, NULL or init stops */
+void ckb_mock_trace(FILE *fp);
+
+/* run script main, ckb_exit returns here */
+int ckb_mock_run(ckb_mock_entry entry);
+
+/* id of the last run, scripts load code cells again when it changes */
+uint64_t ckb_mock_run_id(void);
+
+/* syscall count of the last run */
+uint64_t ckb_mock_syscall_count(void);
+
+#endif /* UDTSWAP_CKB_MOCK_H_ */
@@ -0,0 +1,270 @@
+/*
+ * differential test of UDTswap type script against the type script of git revision DIFF_REF
+ * transactions of benchmark shapes and small pools are mutated, every type script group is run by both scripts
+ * accept/reject of both scripts should be same, error codes may differ when the order of checks is changed
+ * a case is reproduced by -s <seed> -n 1
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "../UDTswap_scripts/ckb_consts.h"
+#include "native.h"
+#include "../UDTswap_scripts/udtswap_common.h"
+
+#define DIFF_CASES 20000
+#define DIFF_MAX_MUTATIONS 3
+#define DIFF_MAX_REPORTS 10
+
+static uint64_t rng_state;
+static fixture_context_t ctx;
+
+typedef struct {
+  uint64_t groups;
+  uint64_t accepted;
+  uint64_t rejected;
+  uint64_t code_changed;
+  uint64_t mismatched;
+} diff_stats_t;
+
+static uint64_t next_random(void) {
+  rng_state ^= rng_state >> 12;
+  rng_state ^= rng_state << 25;
+  rng_state ^= rng_state >> 27;
+  return rng_state * 0x2545f4914f6cdd1dULL;
+}
+
+static fixture_u128 get_u128(const uint8_t *p) {
+  fixture_u128 v = 0;
+  int i;
+  for (i = 0; i < 16; i++) {
+    v |= (fixture_u128)p[i] << (8 * i);
+  }
+  return v;
+}
+
+static void set_u128(uint8_t *p, fixture_u128 v) {
+  int i;
+  for (i = 0; i < 16; i++) {
+    p[i] = (v >> (8 * i)) & 0xff;
+  }
+}
+
+/*
+ * small deltas and values around empty pool reserve are picked more, they decide reserve checks
+ */
+static fixture_u128 mutate_value(fixture_u128 v) {
+  switch (next_random() % 6) {
+    case 0:
+      return v + 1;
+    case 1:
+      return v - 1;
+    case 2:
+      return next_random() % 2 ? UDT_RESERVE_DEFAULT : CKB_RESERVE_DEFAULT;
+    case 3:
+      return (next_random() % 2 ? UDT_RESERVE_DEFAULT : CKB_RESERVE_DEFAULT) + 1;
+    case 4:
+      return v ^ ((fixture_u128)1 << (next_random() % 128));
+  }
+  return next_random() % 4;
+}
+
+/*
+ * UDTswap cells of pool p, inputs or outputs
+ */
+static fixture_cell_t *pool_cell(fixture_tx_t *tx, size_t p, size_t offset, int is_output) {
+  size_t index = 3 * p + offset;
+  if (is_output) {
+    return index < tx->output_cnt ? &tx->outputs[index] : NULL;
+  }
+  return index < tx->input_cnt ? &tx->inputs[index] : NULL;
+}
+
+static void mutate_amount(fixture_cell_t *cell, fixture_u128 delta) {
+  if (cell->data_len >= UDT_AMOUNT_SIZE && cell->has_type) {
+    set_u128(cell->data, get_u128(cell->data) + delta);
+  } else {
+    cell->capacity += (uint64_t)delta;
+  }
+}
+
+/*
+ * one field of a pool of transaction is changed
+ */
+static void mutate_tx(fixture_tx_t *tx, size_t pool_cnt) {
+  size_t p = next_random() % pool_cnt;
+  int is_output = (int)(next_random() % 2);
+  size_t udt = 1 + next_random() % 2;
+  fixture_cell_t *cell = pool_cell(tx, p, 0, is_output);
+  fixture_cell_t *udt_cell = pool_cell(tx, p, udt, is_output);
+  if (cell == NULL || udt_cell == NULL || cell->data_len < UDTSWAP_DATA_SIZE) {
+    return;
+  }
+  uint8_t *field = cell->data + 16 * (next_random() % 3);
+  switch (next_random() % 10) {
+    case 0:
+    case 1:
+      set_u128(field, mutate_value(get_u128(field)));
+      break;
+    case 2:
+    case 3: {
+      fixture_u128 delta = mutate_value(0);
+      delta = next_random() % 2 ? delta : -delta;
+      set_u128(cell->data + 16 * (udt - 1), get_u128(cell->data + 16 * (udt - 1)) + delta);
+      mutate_amount(udt_cell, delta);
+      break;
+    }
+    //reserve and locked amount are changed together, so only reserve checks fail
+    case 4:
+      mutate_amount(udt_cell, next_random() % 2 ? 1 : -1);
+      break;
+    case 5:
+      cell->data[next_random() % cell->data_len] ^= (uint8_t)(1 << (next_random() % 8));
+      break;
+    case 6: {
+      uint8_t data[UDTSWAP_DATA_SIZE + 1] = {0};
+      memcpy(data, cell->data, UDTSWAP_DATA_SIZE);
+      fixture_cell_set_data(cell, data, UDTSWAP_DATA_SIZE - 1 + (uint32_t)(next_random() % 2) * 2);
+      break;
+    }
+    case 7:
+      cell->lock.args[next_random() % cell->lock.args_len] ^= 1;
+      break;
+    case 8:
+      if (next_random() % 2) {
+        udt_cell->has_type = !udt_cell->has_type;
+      } else {
+        udt_cell->lock.args[next_random() % udt_cell->lock.args_len] ^= 1;
+      }
+      break;
+    default:
+      if (cell->has_type) {
+        cell->type.args[next_random() % cell->type.args_len] ^= 1;
+      }
+  }
+}
+
+/*
+ * transaction of benchmark shape, or of small pool with reserves near empty pool reserve
+ */
+static int random_tx(fixture_tx_t *tx, int *shape, size_t *pool_cnt) {
+  fixture_pool_t pools[3];
+  fixture_u128 amounts[3];
+  int directions[3];
+  int kind = (int)(next_random() % 2);
+  int extended = (int)(next_random() % 2);
+  size_t i;
+
+  *shape = (int)(next_random() % (FIXTURE_SHAPE_SWAP + 1));
+  *pool_cnt = *shape == FIXTURE_SHAPE_SWAP ? 1 + next_random() % 3 : 1;
+  ctx.swap_mode = (int)(next_random() % 3);
+  fixture_tx_init(tx);
+  if (*shape == FIXTURE_SHAPE_CREATE || next_random() % 2) {
+    return fixture_bench_tx(tx, &ctx, *shape, kind, *pool_cnt, extended, (int)(next_random() % 2));
+  }
+  for (i = 0; i < *pool_cnt; i++) {
+    fixture_bench_pool(&pools[i], &ctx, kind, (uint32_t)i, extended);
+    pools[i].udt1_reserve = 1 + next_random() % 4000;
+    pools[i].udt2_reserve = 1 + next_random() % 4000;
+    pools[i].total_liquidity = 1 + next_random() % 4000;
+    amounts[i] = 1 + next_random() % 4000;
+    directions[i] = (int)(next_random() % 2);
+  }
+  switch (*shape) {
+    case FIXTURE_SHAPE_ADD:
+      return fixture_add_liquidity(tx, &ctx, &pools[0], amounts[0] + ADD_LIQUIDITY_MINIMUM);
+    case FIXTURE_SHAPE_REMOVE:
+      return fixture_remove_liquidity(tx, &ctx, &pools[0], 1 + amounts[0] % pools[0].total_liquidity);
+  }
+  return fixture_swap(tx, &ctx, pools, *pool_cnt, amounts, directions);
+}
+
+static int run(const fixture_tx_t *tx, const fixture_group_t *group, ckb_mock_entry entry, int *ret) {
+  if (ckb_mock_init(tx, group->group_type, group->is_output ? CKB_SOURCE_OUTPUT : CKB_SOURCE_INPUT, group->index) != 0) {
+    return 0;
+  }
+  *ret = ckb_mock_run(entry);
+  return 1;
+}
+
+static void run_case(uint64_t seed, int strict, diff_stats_t *stats) {
+  fixture_group_t groups[FIXTURE_MAX_POOLS + 2];
+  int shape, ret, reference_ret;
+  size_t pool_cnt, cnt, g, m;
+
+  rng_state = seed * 0x9e3779b97f4a7c15ULL + 1;
+  fixture_tx_t *tx = malloc(sizeof(fixture_tx_t));
+  if (tx == NULL) {
+    exit(1);
+  }
+  if (random_tx(tx, &shape, &pool_cnt) == 0) {
+    size_t mutation_cnt = next_random() % (DIFF_MAX_MUTATIONS + 1);
+    for (m = 0; m < mutation_cnt; m++) {
+      mutate_tx(tx, pool_cnt);
+    }
+    cnt = fixture_shape_groups(shape, pool_cnt, groups);
+    for (g = 0; g < cnt; g++) {
+      if (groups[g].script != FIXTURE_SCRIPT_TYPE) {
+        continue;
+      }
+      if (!run(tx, &groups[g], udtswap_type_main, &ret) || !run(tx, &groups[g], udtswap_reference_main, &reference_ret)) {
+        continue;
+      }
+      stats->groups += 1;
+      stats->accepted += ret == 0;
+      stats->rejected += ret != 0;
+      if ((ret == 0) != (reference_ret == 0) || (strict && ret != reference_ret)) {
+        if (stats->mismatched++ < DIFF_MAX_REPORTS) {
+          printf(
+            "MISMATCH seed %llu shape %d pools %zu group %zu: %d, reference %d\n",
+            (unsigned long long)seed, shape, pool_cnt, groups[g].index, ret, reference_ret
+          );
+        }
+      } else if (ret != reference_ret) {
+        stats->code_changed += 1;
+      }
+    }
+  }
+  fixture_tx_free(tx);
+  free(tx);
+}
+
+static void usage(void) {
+  fprintf(stderr, "usage: diff_test [-n cases] [-s seed] [-c]\n");
+  fprintf(stderr, "  -c  error codes should be same too\n");
+}
+
+int main(int argc, char *argv[]) {
+  uint64_t cases = DIFF_CASES, seed = 1, i;
+  int strict = 0, opt;
+  diff_stats_t stats;
+
+  while ((opt = getopt(argc, argv, "n:s:c")) != -1) {
+    switch (opt) {
+      case 'n':
+        cases = strtoull(optarg, NULL, 10);
+        break;
+      case 's':
+        seed = strtoull(optarg, NULL, 10);
+        break;
+      case 'c':
+        strict = 1;
+        break;
+      default:
+        usage();
+        return 1;
+    }
+  }
+
+  fixture_context_init(&ctx);
+  memset(&stats, 0, sizeof(stats));
+  for (i = 0; i < cases; i++) {
+    run_case(seed + i, strict, &stats);
+  }
+  printf(
+    "%llu groups, %llu accepted, %llu rejected, %llu error codes changed, %llu mismatched\n",
+    (unsigned long long)stats.groups, (unsigned long long)stats.accepted, (unsigned long long)stats.rejected,
+    (unsigned long long)stats.code_changed, (unsigned long long)stats.mismatched
+  );
+  return stats.mismatched == 0 ? 0 : 1;
+}
@@ -0,0 +1,1514 @@
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "../UDTswap_scripts/bn.h"
+#include "../UDTswap_scripts/udtswap_common.h"
+#include "blake2b.h"
+#include "fixture.h"
+
+static const uint8_t type_id_code_hash[FIXTURE_HASH_SIZE] = {
+  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0x54,0x59,0x50,0x45,0x5f,0x49,0x44
+}; //"TYPE_ID"
+static const uint8_t secp256k1_code_hash[FIXTURE_HASH_SIZE] = {
+  155, 215, 224, 111, 62, 207, 75, 224, 242, 252, 210, 24, 139, 35, 241, 185,
+  252, 200, 142, 93, 75, 101, 168, 99, 123, 23, 114, 59, 189, 163, 204, 232
+}; //nervos default lock code hash
+static const uint8_t fee_pkh[20] = {
+  163, 248, 28, 227, 134, 32, 107, 175, 102, 115, 33, 122, 77, 220, 112, 224, 123, 38, 218, 20
+}; //UDTswap's protection fee pkh
+
+#define FIXTURE_POOL_CELL_CAPACITY 30000000000ULL
+#define FIXTURE_UDT_CELL_CAPACITY 15800000000ULL
+#define FIXTURE_USER_CELL_CAPACITY 1000000000000ULL
+#define FIXTURE_LIQUIDITY_CELL_CAPACITY 19000000000ULL
+#define FIXTURE_USER_LOCK_WITNESS_SIZE 65
+
+/*
+ * molecule helpers
+ */
+
+static void put_u32(uint8_t *p, uint32_t v) {
+  int i;
+  for (i = 0; i < 4; i++) {
+    p[i] = (v >> (8 * i)) & 0xff;
+  }
+}
+
+static void put_u64(uint8_t *p, uint64_t v) {
+  int i;
+  for (i = 0; i < 8; i++) {
+    p[i] = (v >> (8 * i)) & 0xff;
+  }
+}
+
+static void put_u128(uint8_t *p, fixture_u128 v) {
+  int i;
+  for (i = 0; i < 16; i++) {
+    p[i] = (v >> (8 * i)) & 0xff;
+  }
+}
+
+uint32_t fixture_script_serialize(const fixture_script_t *script, uint8_t *out) {
+  uint32_t header = 4 * 4;
+  uint32_t total = header + FIXTURE_HASH_SIZE + 1 + 4 + script->args_len;
+  put_u32(out, total);
+  put_u32(out + 4, header);
+  put_u32(out + 8, header + FIXTURE_HASH_SIZE);
+  put_u32(out + 12, header + FIXTURE_HASH_SIZE + 1);
+  memcpy(out + header, script->code_hash, FIXTURE_HASH_SIZE);
+  out[header + FIXTURE_HASH_SIZE] = script->hash_type;
+  put_u32(out + header + FIXTURE_HASH_SIZE + 1, script->args_len);
+  memcpy(out + header + FIXTURE_HASH_SIZE + 5, script->args, script->args_len);
+  return total;
+}
+
+void fixture_script_hash(const fixture_script_t *script, uint8_t out[FIXTURE_HASH_SIZE]) {
+  uint8_t buf[64 + FIXTURE_MAX_ARGS];
+  uint32_t len = fixture_script_serialize(script, buf);
+  blake2b_hash(buf, len, out);
+}
+
+uint32_t fixture_cell_output_serialize(const fixture_cell_t *cell, uint8_t *out) {
+  uint32_t header = 4 * 4;
+  uint32_t lock_len = fixture_script_serialize(&cell->lock, out + header + 8);
+  uint32_t type_len = 0;
+  if (cell->has_type) {
+    type_len = fixture_script_serialize(&cell->type, out + header + 8 + lock_len);
+  }
+  uint32_t total = header + 8 + lock_len + type_len;
+  put_u32(out, total);
+  put_u32(out + 4, header);
+  put_u32(out + 8, header + 8);
+  put_u32(out + 12, header + 8 + lock_len);
+  put_u64(out + header, cell->capacity);
+  return total;
+}
+
+void fixture_cell_input_serialize(const fixture_cell_t *cell, uint8_t out[FIXTURE_INPUT_SIZE]) {
+  put_u64(out, cell->since);
+  memcpy(out + 8, cell->tx_hash, FIXTURE_HASH_SIZE);
+  put_u32(out + 8 + FIXTURE_HASH_SIZE, cell->index);
+}
+
+void fixture_data_hash(const fixture_cell_t *cell, uint8_t out[FIXTURE_HASH_SIZE]) {
+  blake2b_hash(cell->data, cell->data_len, out);
+}
+
+static uint32_t witness_args_serialize(
+  const uint8_t *lock,
+  uint32_t lock_len,
+  const uint8_t *input_type,
+  uint32_t input_type_len,
+  uint8_t *out
+) {
+  uint32_t header = 4 * 4;
+  uint32_t offset = header;
+  put_u32(out + 4, offset);
+  if (lock != NULL) {
+    put_u32(out + offset, lock_len);
+    memcpy(out + offset + 4, lock, lock_len);
+    offset += 4 + lock_len;
+  }
+  put_u32(out + 8, offset);
+  if (input_type != NULL) {
+    put_u32(out + offset, input_type_len);
+    memcpy(out + offset + 4, input_type, input_type_len);
+    offset += 4 + input_type_len;
+  }
+  put_u32(out + 12, offset);
+  put_u32(out, offset);
+  return offset;
+}
+
+/*
+ * transaction
+ */
+
+void fixture_tx_init(fixture_tx_t *tx) {
+  memset(tx, 0, sizeof(*tx));
+}
+
+void fixture_tx_free(fixture_tx_t *tx) {
+  size_t i;
+  for (i = 0; i < tx->input_cnt; i++) {
+    free(tx->inputs[i].data);
+  }
+  for (i = 0; i < tx->output_cnt; i++) {
+    free(tx->outputs[i].data);
+  }
+  for (i = 0; i < tx->dep_cnt; i++) {
+    free(tx->deps[i].data);
+  }
+  for (i = 0; i < tx->witness_cnt; i++) {
+    free(tx->witnesses[i]);
+  }
+  memset(tx, 0, sizeof(*tx));
+}
+
+static void next_out_point(fixture_tx_t *tx, fixture_cell_t *cell) {
+  uint8_t seed[8];
+  put_u32(seed, 0x75647473); //"udts"
+  put_u32(seed + 4, tx->out_point_seed);
+  blake2b_hash(seed, sizeof(seed), cell->tx_hash);
+  cell->index = tx->out_point_seed % 4;
+  tx->out_point_seed += 1;
+}
+
+fixture_cell_t *fixture_tx_add_input(fixture_tx_t *tx) {
+  if (tx->input_cnt >= FIXTURE_MAX_CELLS) {
+    return NULL;
+  }
+  fixture_cell_t *cell = &tx->inputs[tx->input_cnt++];
+  memset(cell, 0, sizeof(*cell));
+  next_out_point(tx, cell);
+  return cell;
+}
+
+fixture_cell_t *fixture_tx_add_output(fixture_tx_t *tx) {
+  if (tx->output_cnt >= FIXTURE_MAX_CELLS) {
+    return NULL;
+  }
+  fixture_cell_t *cell = &tx->outputs[tx->output_cnt++];
+  memset(cell, 0, sizeof(*cell));
+  return cell;
+}
+
+fixture_cell_t *fixture_tx_add_dep(fixture_tx_t *tx) {
+  if (tx->dep_cnt >= FIXTURE_MAX_CELLS) {
+    return NULL;
+  }
+  fixture_cell_t *cell = &tx->deps[tx->dep_cnt++];
+  memset(cell, 0, sizeof(*cell));
+  next_out_point(tx, cell);
+  return cell;
+}
+
+static void header_raw(uint64_t number, uint8_t raw[FIXTURE_HEADER_SIZE]) {
+  memset(raw, 0, FIXTURE_HEADER_SIZE);
+  put_u64(raw + 8, number * 8000);                               //timestamp
+  put_u64(raw + 16, number);                                     //number
+  put_u64(raw + 24, (number / 1000) | ((number % 1000) << 24) | (1000ULL << 40)); //epoch
+}
+
+fixture_header_t *fixture_tx_add_header(fixture_tx_t *tx, uint64_t number) {
+  if (tx->header_cnt >= FIXTURE_MAX_HEADERS) {
+    return NULL;
+  }
+  fixture_header_t *header = &tx->headers[tx->header_cnt++];
+  memset(header, 0, sizeof(*header));
+  header->number = number;
+  header_raw(number, header->raw);
+  blake2b_hash(header->raw, FIXTURE_HEADER_SIZE, header->hash);
+  return header;
+}
+
+int fixture_cell_set_header(fixture_tx_t *tx, fixture_cell_t *cell, uint64_t number) {
+  size_t i;
+  for (i = 0; i < tx->header_cnt && tx->headers[i].number != number; i++) {
+  }
+  if (i == tx->header_cnt && fixture_tx_add_header(tx, number) == NULL) {
+    return FIXTURE_ERROR_TOO_MANY_CELLS;
+  }
+  cell->has_header = 1;
+  cell->header_index = (uint32_t)i;
+  return 0;
+}
+
+int fixture_tx_set_witness(fixture_tx_t *tx, size_t index, const uint8_t *witness, uint32_t len) {
+  if (index >= FIXTURE_MAX_CELLS) {
+    return FIXTURE_ERROR_TOO_MANY_CELLS;
+  }
+  while (tx->witness_cnt <= index) {
+    tx->witnesses[tx->witness_cnt] = NULL;
+    tx->witness_len[tx->witness_cnt] = 0;
+    tx->witness_cnt += 1;
+  }
+  free(tx->witnesses[index]);
+  tx->witnesses[index] = malloc(len > 0 ? len : 1);
+  if (len > 0) {
+    memcpy(tx->witnesses[index], witness, len);
+  }
+  tx->witness_len[index] = len;
+  return 0;
+}
+
+void fixture_cell_set_data(fixture_cell_t *cell, const uint8_t *data, uint32_t len) {
+  free(cell->data);
+  cell->data = malloc(len > 0 ? len : 1);
+  if (len > 0) {
+    memcpy(cell->data, data, len);
+  }
+  cell->data_len = len;
+}
+
+int fixture_cell_load_data(fixture_cell_t *cell, const char *path) {
+  FILE *fp = fopen(path, "rb");
+  if (fp == NULL) {
+    return FIXTURE_ERROR_IO;
+  }
+  fseek(fp, 0, SEEK_END);
+  long size = ftell(fp);
+  fseek(fp, 0, SEEK_SET);
+  if (size < 0) {
+    fclose(fp);
+    return FIXTURE_ERROR_IO;
+  }
+  free(cell->data);
+  cell->data = malloc(size > 0 ? size : 1);
+  cell->data_len = (uint32_t)size;
+  if (fread(cell->data, 1, size, fp) != (size_t)size) {
+    fclose(fp);
+    return FIXTURE_ERROR_IO;
+  }
+  fclose(fp);
+  return 0;
+}
+
+/*
+ * molecule Transaction of tx, as in blocks of a node
+ * cell deps are code deps of out point of deps, header deps are hashes of headers
+ */
+
+static uint32_t script_size(const fixture_script_t *script) {
+  return 4 * 4 + FIXTURE_HASH_SIZE + 1 + 4 + script->args_len;
+}
+
+static uint32_t dynvec_header(uint8_t *out, const uint32_t lens[], size_t cnt) {
+  uint32_t offset = 4 * (uint32_t)(cnt + 1);
+  size_t i;
+  for (i = 0; i < cnt; i++) {
+    put_u32(out + 4 * (i + 1), offset);
+    offset += lens[i];
+  }
+  put_u32(out, offset);
+  return offset;
+}
+//header of table or dynvec, items are written after it in order
+
+uint32_t fixture_tx_size(const fixture_tx_t *tx) {
+  uint32_t size = 4 * 3 + 4 * 7 + 4;
+  size_t i;
+  size += 4 + 37 * (uint32_t)tx->dep_cnt;
+  size += 4 + FIXTURE_HASH_SIZE * (uint32_t)tx->header_cnt;
+  size += 4 + FIXTURE_INPUT_SIZE * (uint32_t)tx->input_cnt;
+  size += 4 * 2 * (1 + (uint32_t)tx->output_cnt);
+  for (i = 0; i < tx->output_cnt; i++) {
+    const fixture_cell_t *cell = &tx->outputs[i];
+    size += 4 * 4 + 8 + script_size(&cell->lock) + (cell->has_type ? script_size(&cell->type) : 0);
+    size += 4 + cell->data_len;
+  }
+  size += 4 * (1 + (uint32_t)tx->witness_cnt);
+  for (i = 0; i < tx->witness_cnt; i++) {
+    size += 4 + tx->witness_len[i];
+  }
+  return size;
+}
+
+static uint32_t raw_tx_serialize(const fixture_tx_t *tx, uint8_t *out) {
+  uint32_t lens[6], item_lens[FIXTURE_MAX_CELLS];
+  uint8_t *p = out + 4 * 7, *items;
+  size_t i;
+
+  put_u32(p, 0);
+  lens[0] = 4;
+  p += 4;
+  //version
+
+  put_u32(p, (uint32_t)tx->dep_cnt);
+  for (i = 0; i < tx->dep_cnt; i++) {
+    memcpy(p + 4 + 37 * i, tx->deps[i].tx_hash, FIXTURE_HASH_SIZE);
+    put_u32(p + 4 + 37 * i + FIXTURE_HASH_SIZE, tx->deps[i].index);
+    p[4 + 37 * i + FIXTURE_HASH_SIZE + 4] = 0;
+  }
+  lens[1] = 4 + 37 * (uint32_t)tx->dep_cnt;
+  p += lens[1];
+  //cell deps of dep type code
+
+  put_u32(p, (uint32_t)tx->header_cnt);
+  for (i = 0; i < tx->header_cnt; i++) {
+    memcpy(p + 4 + FIXTURE_HASH_SIZE * i, tx->headers[i].hash, FIXTURE_HASH_SIZE);
+  }
+  lens[2] = 4 + FIXTURE_HASH_SIZE * (uint32_t)tx->header_cnt;
+  p += lens[2];
+
+  put_u32(p, (uint32_t)tx->input_cnt);
+  for (i = 0; i < tx->input_cnt; i++) {
+    fixture_cell_input_serialize(&tx->inputs[i], p + 4 + FIXTURE_INPUT_SIZE * i);
+  }
+  lens[3] = 4 + FIXTURE_INPUT_SIZE * (uint32_t)tx->input_cnt;
+  p += lens[3];
+
+  items = p + 4 * (1 + tx->output_cnt);
+  for (i = 0; i < tx->output_cnt; i++) {
+    item_lens[i] = fixture_cell_output_serialize(&tx->outputs[i], items);
+    items += item_lens[i];
+  }
+  lens[4] = dynvec_header(p, item_lens, tx->output_cnt);
+  p += lens[4];
+
+  items = p + 4 * (1 + tx->output_cnt);
+  for (i = 0; i < tx->output_cnt; i++) {
+    put_u32(items, tx->outputs[i].data_len);
+    memcpy(items + 4, tx->outputs[i].data, tx->outputs[i].data_len);
+    item_lens[i] = 4 + tx->outputs[i].data_len;
+    items += item_lens[i];
+  }
+  lens[5] = dynvec_header(p, item_lens, tx->output_cnt);
+  return dynvec_header(out, lens, 6);
+}
+
+uint32_t fixture_tx_serialize(const fixture_tx_t *tx, uint8_t *out) {
+  uint32_t lens[2], item_lens[FIXTURE_MAX_CELLS];
+  uint8_t *p = out + 4 * 3, *items;
+  size_t i;
+
+  lens[0] = raw_tx_serialize(tx, p);
+  p += lens[0];
+  items = p + 4 * (1 + tx->witness_cnt);
+  for (i = 0; i < tx->witness_cnt; i++) {
+    put_u32(items, tx->witness_len[i]);
+    memcpy(items + 4, tx->witnesses[i], tx->witness_len[i]);
+    item_lens[i] = 4 + tx->witness_len[i];
+    items += item_lens[i];
+  }
+  lens[1] = dynvec_header(p, item_lens, tx->witness_cnt);
+  return dynvec_header(out, lens, 2);
+}
+
+void fixture_tx_hash(const fixture_tx_t *tx, uint8_t out[FIXTURE_HASH_SIZE]) {
+  uint8_t *buf = malloc(fixture_tx_size(tx));
+  uint32_t len = raw_tx_serialize(tx, buf);
+  blake2b_hash(buf, len, out);
+  free(buf);
+}
+
+/*
+ * UDTswap formulas, same bignum arithmetic as UDTswap type script
+ */
+
+static void u128_to_bignum(fixture_u128 v, struct bn *ret) {
+  int i;
+  bignum_init(ret);
+  for (i = 0; i < 4; i++) {
+    ret->array[i] = (DTYPE)(v >> (32 * i));
+  }
+}
+
+static fixture_u128 bignum_to_u128(struct bn *v) {
+  fixture_u128 ret = 0;
+  int i;
+  for (i = 0; i < 4; i++) {
+    ret |= (fixture_u128)v->array[i] << (32 * i);
+  }
+  return ret;
+}
+
+static int bignum_fits_u128(struct bn *v) {
+  int i;
+  for (i = 4; i < BN_ARRAY_SIZE; i++) {
+    if (v->array[i] != 0) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+fixture_u128 fixture_swap_output(fixture_u128 i_r, fixture_u128 o_r, fixture_u128 input_amount) {
+  struct bn input_reserve, output_reserve, amount, thousand, except_fee, temp1, temp2, temp3, temp4;
+  u128_to_bignum(i_r, &input_reserve);
+  u128_to_bignum(o_r, &output_reserve);
+  u128_to_bignum(input_amount, &amount);
+  bignum_from_uint64_t(&thousand, 1000);
+  bignum_from_uint64_t(&except_fee, LIQUIDITY_POOL_EXCEPT_FEE);
+
+  bignum_mul(&input_reserve, &thousand, &temp1);
+  bignum_mul(&amount, &except_fee, &temp2);
+  bignum_mul(&temp2, &output_reserve, &temp3);
+  bignum_add(&temp1, &temp2, &temp4);
+  if (bignum_is_zero(&temp4)) {
+    return 0;
+  }
+  bignum_div(&temp3, &temp4, &temp1);
+  return bignum_to_u128(&temp1);
+}
+
+int fixture_add_liquidity_amounts(
+  const fixture_pool_t *pool,
+  fixture_u128 udt1_amount,
+  fixture_u128 *udt2_amount,
+  fixture_u128 *liquidity
+) {
+  if (pool->total_liquidity == 0) {
+    *udt2_amount = udt1_amount;
+    *liquidity = udt1_amount;
+    return 0;
+  }
+  if (pool->udt1_reserve == 0) {
+    return FIXTURE_ERROR_AMOUNT;
+  }
+  struct bn udt1_reserve, udt2_reserve, total_liquidity, amount, temp1, temp2;
+  u128_to_bignum(pool->udt1_reserve, &udt1_reserve);
+  u128_to_bignum(pool->udt2_reserve, &udt2_reserve);
+  u128_to_bignum(pool->total_liquidity, &total_liquidity);
+  u128_to_bignum(udt1_amount, &amount);
+
+  bignum_mul(&udt2_reserve, &amount, &temp1);
+  bignum_div(&temp1, &udt1_reserve, &temp2);
+  if (!bignum_fits_u128(&temp2)) {
+    return FIXTURE_ERROR_AMOUNT;
+  }
+  *udt2_amount = bignum_to_u128(&temp2) + 1;
+
+  bignum_mul(&total_liquidity, &amount, &temp1);
+  bignum_div(&temp1, &udt1_reserve, &temp2);
+  if (!bignum_fits_u128(&temp2)) {
+    return FIXTURE_ERROR_AMOUNT;
+  }
+  *liquidity = bignum_to_u128(&temp2);
+  return 0;
+}
+
+void fixture_remove_liquidity_amounts(
+  const fixture_pool_t *pool,
+  fixture_u128 liquidity,
+  fixture_u128 *udt1_amount,
+  fixture_u128 *udt2_amount
+) {
+  struct bn udt1_reserve, udt2_reserve, total_liquidity, amount, temp1, temp2;
+  u128_to_bignum(pool->udt1_reserve, &udt1_reserve);
+  u128_to_bignum(pool->udt2_reserve, &udt2_reserve);
+  u128_to_bignum(pool->total_liquidity, &total_liquidity);
+  u128_to_bignum(liquidity, &amount);
+
+  bignum_mul(&amount, &udt1_reserve, &temp1);
+  bignum_div(&temp1, &total_liquidity, &temp2);
+  *udt1_amount = bignum_to_u128(&temp2);
+
+  bignum_mul(&amount, &udt2_reserve, &temp1);
+  bignum_div(&temp1, &total_liquidity, &temp2);
+  *udt2_amount = bignum_to_u128(&temp2);
+}
+
+void fixture_update_price_cumulative(fixture_u128 i_r, fixture_u128 o_r, uint64_t elapsed, uint8_t price_cumulative[32]) {
+  struct bn input_reserve, output_reserve, blocks, cumulative, temp1, temp2;
+  int i;
+  u128_to_bignum(i_r, &input_reserve);
+  u128_to_bignum(o_r, &output_reserve);
+  bignum_from_uint64_t(&blocks, elapsed);
+  bignum_init(&cumulative);
+  for (i = 0; i < 32; i++) {
+    cumulative.array[i / 4] |= (DTYPE)price_cumulative[i] << (8 * (i % 4));
+  }
+
+  _lshift_word(&output_reserve, PRICE_RESOLUTION_WORDS);
+  bignum_div(&output_reserve, &input_reserve, &temp1);
+  bignum_mul(&temp1, &blocks, &temp2);
+  bignum_add(&cumulative, &temp2, &temp1);
+  for (i = 0; i < 32; i++) {
+    price_cumulative[i] = (temp1.array[i / 4] >> (8 * (i % 4))) & 0xff;
+  }
+}
+
+/*
+ * UDTswap shapes
+ */
+
+static void script_from_label(fixture_script_t *script, const uint8_t code_hash[FIXTURE_HASH_SIZE], const char *label) {
+  memset(script, 0, sizeof(*script));
+  memcpy(script->code_hash, code_hash, FIXTURE_HASH_SIZE);
+  script->hash_type = FIXTURE_HASH_TYPE_TYPE;
+  blake2b_hash(label, strlen(label), script->args);
+  script->args_len = FIXTURE_HASH_SIZE;
+}
+
+int fixture_context_init(fixture_context_t *ctx) {
+  uint8_t hash1[FIXTURE_HASH_SIZE], hash2[FIXTURE_HASH_SIZE], udt_code_hash[FIXTURE_HASH_SIZE];
+  memset(ctx, 0, sizeof(*ctx));
+
+  script_from_label(&ctx->type_code_dep, type_id_code_hash, "udtswap type script");
+  script_from_label(&ctx->lock_code_dep, type_id_code_hash, "udtswap lock script");
+  script_from_label(&ctx->liquidity_code_dep, type_id_code_hash, "udtswap liquidity udt script");
+  fixture_script_hash(&ctx->type_code_dep, ctx->type_code_hash);
+  fixture_script_hash(&ctx->lock_code_dep, ctx->lock_code_hash);
+  fixture_script_hash(&ctx->liquidity_code_dep, ctx->liquidity_code_hash);
+  script_from_label(&ctx->bn_lib_code_dep, type_id_code_hash, "udtswap bn library");
+  fixture_script_hash(&ctx->bn_lib_code_dep, ctx->bn_lib_code_hash);
+
+  blake2b_hash("test udt", 8, udt_code_hash);
+  script_from_label(&ctx->udt1_type, udt_code_hash, "udt1");
+  script_from_label(&ctx->udt2_type, udt_code_hash, "udt2");
+  fixture_script_hash(&ctx->udt1_type, hash1);
+  fixture_script_hash(&ctx->udt2_type, hash2);
+  if (memcmp(hash1, hash2, FIXTURE_HASH_SIZE) > 0) {
+    fixture_script_t temp = ctx->udt1_type;
+    ctx->udt1_type = ctx->udt2_type;
+    ctx->udt2_type = temp;
+  }
+  //UDT pair order is by type script hash
+
+  memset(&ctx->user_lock, 0, sizeof(ctx->user_lock));
+  memcpy(ctx->user_lock.code_hash, secp256k1_code_hash, FIXTURE_HASH_SIZE);
+  ctx->user_lock.hash_type = FIXTURE_HASH_TYPE_TYPE;
+  memset(ctx->user_lock.args, 0x11, 20);
+  ctx->user_lock.args_len = 20;
+
+  memset(&ctx->fee_lock, 0, sizeof(ctx->fee_lock));
+  memcpy(ctx->fee_lock.code_hash, secp256k1_code_hash, FIXTURE_HASH_SIZE);
+  ctx->fee_lock.hash_type = FIXTURE_HASH_TYPE_TYPE;
+  memcpy(ctx->fee_lock.args, fee_pkh, sizeof(fee_pkh));
+  ctx->fee_lock.args_len = sizeof(fee_pkh);
+
+  ctx->block_number = 1000;
+  ctx->swap_mode = SWAP_MODE_EXACT_INPUT;
+  return 0;
+}
+
+/*
+ * code cell deps of initialized context are replaced by unified script
+ */
+void fixture_context_unify(fixture_context_t *ctx) {
+  ctx->unified = 1;
+  script_from_label(&ctx->type_code_dep, type_id_code_hash, "udtswap unified script");
+  ctx->lock_code_dep = ctx->type_code_dep;
+  ctx->liquidity_code_dep = ctx->type_code_dep;
+  fixture_script_hash(&ctx->type_code_dep, ctx->type_code_hash);
+  memcpy(ctx->lock_code_hash, ctx->type_code_hash, FIXTURE_HASH_SIZE);
+  memcpy(ctx->liquidity_code_hash, ctx->type_code_hash, FIXTURE_HASH_SIZE);
+}
+
+int fixture_add_code_deps(fixture_tx_t *tx, const fixture_context_t *ctx, const char *bin_dir) {
+  const fixture_script_t *dep_types[4] = {&ctx->type_code_dep, &ctx->lock_code_dep, &ctx->liquidity_code_dep, &ctx->bn_lib_code_dep};
+  const char *names[4] = {"UDTswap_udt_based", "UDTswap_lock_udt_based", "UDTswap_liquidity_UDT_udt_based", "bn_lib"};
+  char path[4096];
+  int i;
+  if (ctx->unified) {
+    names[0] = "UDTswap_unified_udt_based";
+  }
+  for (i = 0; i < 4; i++) {
+    if (ctx->unified && (i == 1 || i == 2)) {
+      continue;
+    }
+    if (bin_dir != NULL) {
+      snprintf(path, sizeof(path), "%s/%s", bin_dir, names[i]);
+    }
+    if (i == 3 && (bin_dir == NULL || access(path, R_OK) != 0)) {
+      continue;
+    }
+    //bn library of BN=dynamic build
+    fixture_cell_t *dep = fixture_tx_add_dep(tx);
+    if (dep == NULL) {
+      return FIXTURE_ERROR_TOO_MANY_CELLS;
+    }
+    dep->lock = ctx->user_lock;
+    dep->has_type = 1;
+    dep->type = *dep_types[i];
+    if (bin_dir != NULL) {
+      int ret = fixture_cell_load_data(dep, path);
+      if (ret != 0) {
+        return ret;
+      }
+    } else {
+      fixture_cell_set_data(dep, NULL, 0);
+    }
+    dep->capacity = ((uint64_t)dep->data_len + 200) * 100000000ULL;
+  }
+  return 0;
+}
+
+void fixture_pool_init(fixture_pool_t *pool, int kind, uint32_t pool_id) {
+  memset(pool, 0, sizeof(*pool));
+  pool->kind = kind;
+  pool->pool_id = pool_id;
+}
+
+static const fixture_script_t *pool_udt_type(const fixture_context_t *ctx, int kind, int udt) {
+  if (kind == FIXTURE_PAIR_CKB_UDT) {
+    return udt == 1 ? NULL : &ctx->udt1_type;
+  }
+  return udt == 1 ? &ctx->udt1_type : &ctx->udt2_type;
+}
+
+static void udt_type_hash(const fixture_script_t *type, uint8_t out[FIXTURE_HASH_SIZE]) {
+  if (type == NULL) {
+    memset(out, 0, FIXTURE_HASH_SIZE);
+  } else {
+    fixture_script_hash(type, out);
+  }
+}
+
+static void pool_lock_script(const fixture_context_t *ctx, int kind, fixture_script_t *lock) {
+  memset(lock, 0, sizeof(*lock));
+  memcpy(lock->code_hash, ctx->lock_code_hash, FIXTURE_HASH_SIZE);
+  lock->hash_type = FIXTURE_HASH_TYPE_TYPE;
+  udt_type_hash(pool_udt_type(ctx, kind, 1), lock->args);
+  udt_type_hash(pool_udt_type(ctx, kind, 2), lock->args + FIXTURE_HASH_SIZE);
+  lock->args_len = 2 * FIXTURE_HASH_SIZE;
+}
+
+static void pool_identifier(uint32_t pool_id, uint8_t out[FIXTURE_INPUT_SIZE]) {
+  fixture_cell_t creation_input;
+  uint8_t seed[8];
+  memset(&creation_input, 0, sizeof(creation_input));
+  put_u32(seed, 0x6c6f6f70); //"pool"
+  put_u32(seed + 4, pool_id);
+  blake2b_hash(seed, sizeof(seed), creation_input.tx_hash);
+  fixture_cell_input_serialize(&creation_input, out);
+}
+
+static void pool_type_script(const fixture_context_t *ctx, const uint8_t identifier[FIXTURE_INPUT_SIZE], fixture_script_t *type) {
+  memset(type, 0, sizeof(*type));
+  memcpy(type->code_hash, ctx->type_code_hash, FIXTURE_HASH_SIZE);
+  type->hash_type = FIXTURE_HASH_TYPE_TYPE;
+  memcpy(type->args, identifier, FIXTURE_INPUT_SIZE);
+  type->args_len = FIXTURE_INPUT_SIZE;
+}
+
+static void liquidity_type_script(const fixture_context_t *ctx, const fixture_pool_t *pool, fixture_script_t *type) {
+  fixture_script_t lock;
+  pool_lock_script(ctx, pool->kind, &lock);
+  memset(type, 0, sizeof(*type));
+  memcpy(type->code_hash, ctx->liquidity_code_hash, FIXTURE_HASH_SIZE);
+  type->hash_type = FIXTURE_HASH_TYPE_TYPE;
+  fixture_script_hash(&lock, type->args);
+  pool_identifier(pool->pool_id, type->args + FIXTURE_HASH_SIZE);
+  type->args_len = FIXTURE_HASH_SIZE + FIXTURE_INPUT_SIZE;
+}
+
+static fixture_u128 reserve_default(const fixture_context_t *ctx, int kind, int udt) {
+  return pool_udt_type(ctx, kind, udt) == NULL ? CKB_RESERVE_DEFAULT : UDT_RESERVE_DEFAULT;
+}
+
+static int set_udt_cell(fixture_cell_t *cell, const fixture_script_t *type, fixture_u128 amount, uint64_t capacity) {
+  if (type == NULL) {
+    if (amount > (fixture_u128)UINT64_MAX) {
+      return FIXTURE_ERROR_AMOUNT;
+    }
+    cell->capacity = (uint64_t)amount;
+    cell->has_type = 0;
+    fixture_cell_set_data(cell, NULL, 0);
+  } else {
+    uint8_t data[UDT_AMOUNT_SIZE];
+    put_u128(data, amount);
+    cell->capacity = capacity;
+    cell->has_type = 1;
+    cell->type = *type;
+    fixture_cell_set_data(cell, data, UDT_AMOUNT_SIZE);
+  }
+  return 0;
+}
+
+static uint64_t pool_udt_cell_capacity(const fixture_context_t *ctx, int kind, int udt) {
+  const fixture_script_t *type = pool_udt_type(ctx, kind, udt);
+  return FIXTURE_UDT_CELL_CAPACITY + (type == NULL ? 0 : (uint64_t)type->args_len * 100000000ULL);
+}
+//udt cells of pool have lock args of two type hashes, capacity as udt cells of cellBuilder.js
+
+static int ensure_header(fixture_tx_t *tx, const fixture_context_t *ctx) {
+  if (tx->header_cnt == 0 && fixture_tx_add_header(tx, ctx->block_number) == NULL) {
+    return FIXTURE_ERROR_TOO_MANY_CELLS;
+  }
+  return 0;
+}
+
+/*
+ * pool cell, first udt cell, second udt cell with pool state
+ */
+static int add_pool_cells(
+  fixture_tx_t *tx,
+  const fixture_context_t *ctx,
+  const fixture_pool_t *pool,
+  int is_output,
+  const uint8_t identifier[FIXTURE_INPUT_SIZE]
+) {
+  fixture_cell_t *cells[3];
+  int i, ret;
+  for (i = 0; i < 3; i++) {
+    cells[i] = is_output ? fixture_tx_add_output(tx) : fixture_tx_add_input(tx);
+    if (cells[i] == NULL) {
+      return FIXTURE_ERROR_TOO_MANY_CELLS;
+    }
+    pool_lock_script(ctx, pool->kind, &cells[i]->lock);
+  }
+
+  fixture_u128 udt1_reserve = pool->udt1_reserve + reserve_default(ctx, pool->kind, 1);
+  fixture_u128 udt2_reserve = pool->udt2_reserve + reserve_default(ctx, pool->kind, 2);
+
+  uint8_t data[UDTSWAP_EXTENDED_DATA_SIZE];
+  memset(data, 0, sizeof(data));
+  put_u128(data + UDTSWAP_DATA_UDT1_RESERVE_START, udt1_reserve);
+  put_u128(data + UDTSWAP_DATA_UDT2_RESERVE_START, udt2_reserve);
+  put_u128(data + UDTSWAP_DATA_TOTAL_LIQUIDITY_START, pool->total_liquidity);
+  if (pool->extended) {
+    memcpy(data + UDTSWAP_DATA_PRICE1_CUMULATIVE_START, pool->price1_cumulative, PRICE_CUMULATIVE_SIZE);
+    memcpy(data + UDTSWAP_DATA_PRICE2_CUMULATIVE_START, pool->price2_cumulative, PRICE_CUMULATIVE_SIZE);
+    put_u64(data + UDTSWAP_DATA_LAST_UPDATE_START, pool->last_update);
+  }
+  if (!is_output && pool->extended) {
+    ret = ensure_header(tx, ctx);
+    if (ret == 0) ret = fixture_cell_set_header(tx, cells[0], pool->last_update);
+    if (ret != 0) {
+      return ret;
+    }
+  }
+  //input pool cell is committed in block of its last update, first header dep is current block
+  cells[0]->capacity = FIXTURE_POOL_CELL_CAPACITY;
+  cells[0]->has_type = 1;
+  pool_type_script(ctx, identifier, &cells[0]->type);
+  fixture_cell_set_data(cells[0], data, pool->extended ? UDTSWAP_EXTENDED_DATA_SIZE : UDTSWAP_DATA_SIZE);
+
+  ret = set_udt_cell(cells[1], pool_udt_type(ctx, pool->kind, 1), udt1_reserve, pool_udt_cell_capacity(ctx, pool->kind, 1));
+  if (ret != 0) {
+    return ret;
+  }
+  return set_udt_cell(cells[2], pool_udt_type(ctx, pool->kind, 2), udt2_reserve, pool_udt_cell_capacity(ctx, pool->kind, 2));
+}
+
+/*
+ * pool state after transaction, price cumulative updated with reserves before
+ */
+static int next_pool_state(
+  fixture_tx_t *tx,
+  const fixture_context_t *ctx,
+  const fixture_pool_t *before,
+  fixture_pool_t *after
+) {
+  if (!before->extended) {
+    return 0;
+  }
+  if (before->last_update > ctx->block_number) {
+    return FIXTURE_ERROR_AMOUNT;
+  }
+  if (before->udt1_reserve != 0 && before->udt2_reserve != 0) {
+    uint64_t elapsed = ctx->block_number - before->last_update;
+    fixture_update_price_cumulative(before->udt1_reserve, before->udt2_reserve, elapsed, after->price1_cumulative);
+    fixture_update_price_cumulative(before->udt2_reserve, before->udt1_reserve, elapsed, after->price2_cumulative);
+  }
+  after->last_update = ctx->block_number;
+  return ensure_header(tx, ctx);
+}
+
+static int add_user_cell(fixture_tx_t *tx, const fixture_context_t *ctx, int is_output, const fixture_script_t *type, fixture_u128 amount) {
+  fixture_cell_t *cell = is_output ? fixture_tx_add_output(tx) : fixture_tx_add_input(tx);
+  if (cell == NULL) {
+    return FIXTURE_ERROR_TOO_MANY_CELLS;
+  }
+  cell->lock = ctx->user_lock;
+  if (type == NULL && amount == 0) {
+    cell->capacity = FIXTURE_USER_CELL_CAPACITY;
+    fixture_cell_set_data(cell, NULL, 0);
+    return 0;
+  }
+  return set_udt_cell(cell, type, amount, FIXTURE_UDT_CELL_CAPACITY);
+}
+
+static int add_fee_cell(fixture_tx_t *tx, const fixture_context_t *ctx, size_t pool_cnt) {
+  fixture_cell_t *cell = fixture_tx_add_output(tx);
+  if (cell == NULL) {
+    return FIXTURE_ERROR_TOO_MANY_CELLS;
+  }
+  cell->lock = ctx->fee_lock;
+  cell->capacity = STATE_USE_FEE * pool_cnt;
+  fixture_cell_set_data(cell, NULL, 0);
+  return 0;
+}
+
+static int set_user_witness(fixture_tx_t *tx, size_t index) {
+  uint8_t signature[FIXTURE_USER_LOCK_WITNESS_SIZE];
+  uint8_t witness[64 + FIXTURE_USER_LOCK_WITNESS_SIZE];
+  memset(signature, 0, sizeof(signature));
+  uint32_t len = witness_args_serialize(signature, sizeof(signature), NULL, 0, witness);
+  return fixture_tx_set_witness(tx, index, witness, len);
+}
+
+static int set_pool_witnesses(fixture_tx_t *tx, size_t index, int swap_mode) {
+  uint8_t witness[64];
+  uint8_t mode = (uint8_t)swap_mode;
+  uint32_t len;
+  int i, ret;
+  for (i = 0; i < 3; i++) {
+    if (i == 0 && swap_mode != SWAP_MODE_AUTO) {
+      len = witness_args_serialize(NULL, 0, &mode, 1, witness);
+    } else {
+      len = witness_args_serialize(NULL, 0, NULL, 0, witness);
+    }
+    ret = fixture_tx_set_witness(tx, index + i, witness, len);
+    if (ret != 0) {
+      return ret;
+    }
+  }
+  return 0;
+}
+
+int fixture_create(fixture_tx_t *tx, const fixture_context_t *ctx, int kind, int extended) {
+  uint8_t identifier[FIXTURE_INPUT_SIZE];
+  fixture_pool_t pool;
+  int ret;
+
+  ret = add_user_cell(tx, ctx, 0, NULL, 0);
+  if (ret != 0) {
+    return ret;
+  }
+  fixture_cell_input_serialize(&tx->inputs[tx->input_cnt - 1], identifier);
+  //pool identifier is serialized first input
+
+  fixture_pool_init(&pool, kind, 0);
+  pool.extended = extended;
+  if (extended) {
+    pool.last_update = ctx->block_number;
+    ret = ensure_header(tx, ctx);
+    if (ret == 0) ret = fixture_cell_set_header(tx, &tx->inputs[tx->input_cnt - 1], ctx->block_number);
+    if (ret != 0) {
+      return ret;
+    }
+  }
+  ret = add_pool_cells(tx, ctx, &pool, 1, identifier);
+  if (ret != 0) {
+    return ret;
+  }
+  ret = add_user_cell(tx, ctx, 1, NULL, 0);
+  if (ret != 0) {
+    return ret;
+  }
+  return set_user_witness(tx, 0);
+}
+
+int fixture_add_liquidity(fixture_tx_t *tx, const fixture_context_t *ctx, const fixture_pool_t *pool, fixture_u128 udt1_amount) {
+  uint8_t identifier[FIXTURE_INPUT_SIZE];
+  fixture_u128 udt2_amount, liquidity;
+  fixture_pool_t after;
+  int ret;
+
+  ret = fixture_add_liquidity_amounts(pool, udt1_amount, &udt2_amount, &liquidity);
+  if (ret != 0) {
+    return ret;
+  }
+  if (udt1_amount < ADD_LIQUIDITY_MINIMUM || liquidity == 0) {
+    return FIXTURE_ERROR_AMOUNT;
+  }
+  after = *pool;
+  after.udt1_reserve += udt1_amount;
+  after.udt2_reserve += udt2_amount;
+  after.total_liquidity += liquidity;
+  if (after.udt1_reserve < pool->udt1_reserve || after.udt2_reserve < pool->udt2_reserve || after.total_liquidity < pool->total_liquidity) {
+    return FIXTURE_ERROR_AMOUNT;
+  }
+  ret = next_pool_state(tx, ctx, pool, &after);
+  if (ret != 0) {
+    return ret;
+  }
+
+  pool_identifier(pool->pool_id, identifier);
+  ret = add_pool_cells(tx, ctx, pool, 0, identifier);
+  if (ret == 0) ret = add_pool_cells(tx, ctx, &after, 1, identifier);
+  if (ret == 0) ret = add_fee_cell(tx, ctx, 1);
+  //pool cells, fee cell
+
+  fixture_cell_t *liquidity_cell = fixture_tx_add_output(tx);
+  if (liquidity_cell == NULL) {
+    return FIXTURE_ERROR_TOO_MANY_CELLS;
+  }
+  fixture_script_t liquidity_type;
+  liquidity_type_script(ctx, pool, &liquidity_type);
+  liquidity_cell->lock = ctx->user_lock;
+  if (ret == 0) ret = set_udt_cell(liquidity_cell, &liquidity_type, liquidity, FIXTURE_LIQUIDITY_CELL_CAPACITY);
+  //liquidity udt cell right after fee cell
+
+  const fixture_script_t *udt1_type = pool_udt_type(ctx, pool->kind, 1);
+  const fixture_script_t *udt2_type = pool_udt_type(ctx, pool->kind, 2);
+  if (ret == 0) ret = add_user_cell(tx, ctx, 0, NULL, 0);
+  if (ret == 0 && udt1_type != NULL) ret = add_user_cell(tx, ctx, 0, udt1_type, udt1_amount);
+  if (ret == 0 && udt2_type != NULL) ret = add_user_cell(tx, ctx, 0, udt2_type, udt2_amount);
+  if (ret == 0) ret = add_user_cell(tx, ctx, 1, NULL, 0);
+  //user cells
+
+  if (ret == 0) ret = set_pool_witnesses(tx, 0, SWAP_MODE_AUTO);
+  if (ret == 0) ret = set_user_witness(tx, 3);
+  return ret;
+}
+
+int fixture_remove_liquidity(fixture_tx_t *tx, const fixture_context_t *ctx, const fixture_pool_t *pool, fixture_u128 liquidity) {
+  uint8_t identifier[FIXTURE_INPUT_SIZE];
+  fixture_u128 udt1_amount, udt2_amount;
+  fixture_pool_t after;
+  int ret;
+
+  if (liquidity == 0 || liquidity > pool->total_liquidity) {
+    return FIXTURE_ERROR_AMOUNT;
+  }
+  fixture_remove_liquidity_amounts(pool, liquidity, &udt1_amount, &udt2_amount);
+  if (
+    udt1_amount == 0 || udt2_amount == 0 ||
+    udt1_amount >= pool->udt1_reserve || udt2_amount >= pool->udt2_reserve
+  ) {
+    return FIXTURE_ERROR_AMOUNT;
+  }
+  after = *pool;
+  after.udt1_reserve -= udt1_amount;
+  after.udt2_reserve -= udt2_amount;
+  after.total_liquidity -= liquidity;
+  ret = next_pool_state(tx, ctx, pool, &after);
+  if (ret != 0) {
+    return ret;
+  }
+
+  pool_identifier(pool->pool_id, identifier);
+  ret = add_pool_cells(tx, ctx, pool, 0, identifier);
+  if (ret == 0) ret = add_pool_cells(tx, ctx, &after, 1, identifier);
+  if (ret == 0) ret = add_fee_cell(tx, ctx, 1);
+  //pool cells, fee cell
+
+  fixture_script_t liquidity_type;
+  liquidity_type_script(ctx, pool, &liquidity_type);
+  fixture_cell_t *liquidity_cell = fixture_tx_add_input(tx);
+  if (liquidity_cell == NULL) {
+    return FIXTURE_ERROR_TOO_MANY_CELLS;
+  }
+  liquidity_cell->lock = ctx->user_lock;
+  if (ret == 0) ret = set_udt_cell(liquidity_cell, &liquidity_type, pool->total_liquidity, FIXTURE_LIQUIDITY_CELL_CAPACITY);
+  //liquidity udt cell right after pool cells
+
+  if (ret == 0) ret = add_user_cell(tx, ctx, 0, NULL, 0);
+  if (ret == 0) ret = add_user_cell(tx, ctx, 1, pool_udt_type(ctx, pool->kind, 1), udt1_amount);
+  if (ret == 0) ret = add_user_cell(tx, ctx, 1, pool_udt_type(ctx, pool->kind, 2), udt2_amount);
+  if (ret == 0 && pool->total_liquidity > liquidity) {
+    fixture_cell_t *change_cell = fixture_tx_add_output(tx);
+    if (change_cell == NULL) {
+      return FIXTURE_ERROR_TOO_MANY_CELLS;
+    }
+    change_cell->lock = ctx->user_lock;
+    ret = set_udt_cell(change_cell, &liquidity_type, pool->total_liquidity - liquidity, FIXTURE_LIQUIDITY_CELL_CAPACITY);
+  }
+  if (ret == 0) ret = add_user_cell(tx, ctx, 1, NULL, 0);
+  //user cells
+
+  if (ret == 0) ret = set_pool_witnesses(tx, 0, SWAP_MODE_AUTO);
+  if (ret == 0) ret = set_user_witness(tx, 3);
+  return ret;
+}
+
+int fixture_swap(
+  fixture_tx_t *tx,
+  const fixture_context_t *ctx,
+  const fixture_pool_t pools[],
+  size_t pool_cnt,
+  const fixture_u128 input_amounts[],
+  const int directions[]
+) {
+  uint8_t identifier[FIXTURE_INPUT_SIZE];
+  fixture_pool_t after[FIXTURE_MAX_POOLS];
+  fixture_u128 output_amounts[FIXTURE_MAX_POOLS];
+  size_t i;
+  int ret = 0;
+
+  if (pool_cnt == 0 || pool_cnt > FIXTURE_MAX_POOLS) {
+    return FIXTURE_ERROR_TOO_MANY_CELLS;
+  }
+  for (i = 0; i < pool_cnt; i++) {
+    const fixture_pool_t *pool = &pools[i];
+    int rev = directions[i] == FIXTURE_SWAP_UDT2_INPUT;
+    fixture_u128 i_r = rev ? pool->udt2_reserve : pool->udt1_reserve;
+    fixture_u128 o_r = rev ? pool->udt1_reserve : pool->udt2_reserve;
+    if (i_r == 0 || o_r == 0 || pool->total_liquidity == 0 || input_amounts[i] == 0) {
+      return FIXTURE_ERROR_AMOUNT;
+    }
+    if (i_r + input_amounts[i] < i_r) {
+      return FIXTURE_ERROR_AMOUNT;
+    }
+    output_amounts[i] = fixture_swap_output(i_r, o_r, input_amounts[i]);
+    if (output_amounts[i] == 0 || output_amounts[i] >= o_r) {
+      return FIXTURE_ERROR_AMOUNT;
+    }
+    after[i] = *pool;
+    if (rev) {
+      after[i].udt2_reserve += input_amounts[i];
+      after[i].udt1_reserve -= output_amounts[i];
+    } else {
+      after[i].udt1_reserve += input_amounts[i];
+      after[i].udt2_reserve -= output_amounts[i];
+    }
+    ret = next_pool_state(tx, ctx, pool, &after[i]);
+    if (ret != 0) {
+      return ret;
+    }
+  }
+
+  for (i = 0; i < pool_cnt; i++) {
+    pool_identifier(pools[i].pool_id, identifier);
+    ret = add_pool_cells(tx, ctx, &pools[i], 0, identifier);
+    if (ret == 0) ret = add_pool_cells(tx, ctx, &after[i], 1, identifier);
+    if (ret == 0) ret = set_pool_witnesses(tx, 3 * i, ctx->swap_mode);
+    if (ret != 0) {
+      return ret;
+    }
+  }
+  //pool cells in order of three
+
+  ret = add_fee_cell(tx, ctx, pool_cnt);
+  if (ret == 0) ret = set_user_witness(tx, 3 * pool_cnt);
+  if (ret == 0) ret = add_user_cell(tx, ctx, 0, NULL, 0);
+  for (i = 0; i < pool_cnt && ret == 0; i++) {
+    int rev = directions[i] == FIXTURE_SWAP_UDT2_INPUT;
+    const fixture_script_t *input_type = pool_udt_type(ctx, pools[i].kind, rev ? 2 : 1);
+    const fixture_script_t *output_type = pool_udt_type(ctx, pools[i].kind, rev ? 1 : 2);
+    if (input_type != NULL) {
+      ret = add_user_cell(tx, ctx, 0, input_type, input_amounts[i]);
+    }
+    if (ret == 0) ret = add_user_cell(tx, ctx, 1, output_type, output_amounts[i]);
+  }
+  if (ret == 0) ret = add_user_cell(tx, ctx, 1, NULL, 0);
+  //user cells
+  return ret;
+}
+
+/*
+ * benchmark shapes
+ */
+
+#define FIXTURE_BENCH_UDT1_RESERVE 100000000000ULL
+#define FIXTURE_BENCH_UDT2_RESERVE 1000000000000ULL
+#define FIXTURE_BENCH_TOTAL_LIQUIDITY 100000000000ULL
+#define FIXTURE_BENCH_LAST_UPDATE_GAP 100
+#define FIXTURE_BENCH_ADD_UDT1_AMOUNT 10000000000ULL
+#define FIXTURE_BENCH_SWAP_INPUT_AMOUNT 1000000000ULL
+
+void fixture_bench_pool(fixture_pool_t *pool, const fixture_context_t *ctx, int kind, uint32_t pool_id, int extended) {
+  fixture_pool_init(pool, kind, pool_id);
+  pool->udt1_reserve = FIXTURE_BENCH_UDT1_RESERVE;
+  pool->udt2_reserve = FIXTURE_BENCH_UDT2_RESERVE;
+  pool->total_liquidity = FIXTURE_BENCH_TOTAL_LIQUIDITY;
+  pool->extended = extended;
+  if (extended) {
+    pool->last_update = ctx->block_number - FIXTURE_BENCH_LAST_UPDATE_GAP;
+    fixture_update_price_cumulative(pool->udt1_reserve, pool->udt2_reserve, pool->last_update, pool->price1_cumulative);
+    fixture_update_price_cumulative(pool->udt2_reserve, pool->udt1_reserve, pool->last_update, pool->price2_cumulative);
+  }
+}
+
+int fixture_bench_tx(fixture_tx_t *tx, const fixture_context_t *ctx, int shape, int kind, size_t pool_cnt, int extended, int direction) {
+  fixture_pool_t pools[FIXTURE_MAX_POOLS];
+  fixture_u128 amounts[FIXTURE_MAX_POOLS];
+  int directions[FIXTURE_MAX_POOLS];
+  size_t i;
+
+  if (pool_cnt == 0 || pool_cnt > FIXTURE_MAX_POOLS) {
+    return FIXTURE_ERROR_TOO_MANY_CELLS;
+  }
+  for (i = 0; i < pool_cnt; i++) {
+    fixture_bench_pool(&pools[i], ctx, kind, (uint32_t)i, extended);
+    amounts[i] = FIXTURE_BENCH_SWAP_INPUT_AMOUNT;
+    directions[i] = direction;
+  }
+  switch (shape) {
+    case FIXTURE_SHAPE_CREATE:
+      return fixture_create(tx, ctx, kind, extended);
+    case FIXTURE_SHAPE_ADD:
+      return fixture_add_liquidity(tx, ctx, &pools[0], FIXTURE_BENCH_ADD_UDT1_AMOUNT);
+    case FIXTURE_SHAPE_REMOVE:
+      return fixture_remove_liquidity(tx, ctx, &pools[0], pools[0].total_liquidity / 10);
+    case FIXTURE_SHAPE_SWAP:
+      return fixture_swap(tx, ctx, pools, pool_cnt, amounts, directions);
+  }
+  return FIXTURE_ERROR_AMOUNT;
+}
+
+int fixture_balance_capacity(fixture_tx_t *tx, const fixture_context_t *ctx) {
+  uint8_t user_lock_hash[FIXTURE_HASH_SIZE], lock_hash[FIXTURE_HASH_SIZE];
+  fixture_u128 inputs = 0, outputs = 0;
+  size_t i;
+  for (i = 0; i < tx->input_cnt; i++) {
+    inputs += tx->inputs[i].capacity;
+  }
+  for (i = 0; i < tx->output_cnt; i++) {
+    outputs += tx->outputs[i].capacity;
+  }
+  if (outputs <= inputs) {
+    return 0;
+  }
+  fixture_script_hash(&ctx->user_lock, user_lock_hash);
+  for (i = tx->output_cnt; i-- > 0;) {
+    fixture_cell_t *cell = &tx->outputs[i];
+    if (cell->has_type || cell->data_len != 0 || cell->capacity != FIXTURE_USER_CELL_CAPACITY) {
+      continue;
+    }
+    fixture_script_hash(&cell->lock, lock_hash);
+    if (memcmp(lock_hash, user_lock_hash, FIXTURE_HASH_SIZE) == 0) {
+      cell->capacity -= (uint64_t)(outputs - inputs);
+      return 0;
+    }
+  }
+  return FIXTURE_ERROR_AMOUNT;
+}
+//scripts do not check the change cell, so capacity of pools and fee cell is paid from it
+
+/*
+ * chain of blocks, transactions of a block are udt transfers and swaps of chain pools
+ * pool states of chain are states after the swaps of its blocks
+ */
+
+#define FIXTURE_CHAIN_SWAP_PERCENT 25
+
+static uint64_t chain_random(fixture_chain_t *chain) {
+  uint64_t z = (chain->seed += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+void fixture_chain_init(fixture_chain_t *chain, const fixture_context_t *ctx, size_t pool_cnt, uint64_t seed) {
+  size_t i;
+  memset(chain, 0, sizeof(*chain));
+  chain->pool_cnt = pool_cnt > FIXTURE_MAX_POOLS ? FIXTURE_MAX_POOLS : pool_cnt;
+  for (i = 0; i < chain->pool_cnt; i++) {
+    fixture_bench_pool(&chain->pools[i], ctx, FIXTURE_PAIR_UDT_UDT, (uint32_t)i, 0);
+  }
+  chain->seed = seed;
+}
+
+void fixture_pool_type_hash(const fixture_context_t *ctx, const fixture_pool_t *pool, uint8_t out[FIXTURE_HASH_SIZE]) {
+  uint8_t identifier[FIXTURE_INPUT_SIZE];
+  fixture_script_t type;
+  pool_identifier(pool->pool_id, identifier);
+  pool_type_script(ctx, identifier, &type);
+  fixture_script_hash(&type, out);
+}
+
+static int chain_tx(fixture_chain_t *chain, const fixture_context_t *ctx, fixture_tx_t *tx) {
+  int ret;
+  tx->out_point_seed = chain->out_point_seed;
+  if (chain->pool_cnt > 0 && chain_random(chain) % 100 < FIXTURE_CHAIN_SWAP_PERCENT) {
+    fixture_pool_t *pool = &chain->pools[chain_random(chain) % chain->pool_cnt];
+    int direction = chain_random(chain) % 2 == 0 ? FIXTURE_SWAP_UDT1_INPUT : FIXTURE_SWAP_UDT2_INPUT;
+    int rev = direction == FIXTURE_SWAP_UDT2_INPUT;
+    fixture_u128 i_r = rev ? pool->udt2_reserve : pool->udt1_reserve;
+    fixture_u128 o_r = rev ? pool->udt1_reserve : pool->udt2_reserve;
+    fixture_u128 amount = i_r / 1000 + chain_random(chain) % 1000 + 1;
+    ret = fixture_add_code_deps(tx, ctx, NULL);
+    if (ret == 0) ret = fixture_swap(tx, ctx, pool, 1, &amount, &direction);
+    if (ret != 0) {
+      return ret;
+    }
+    fixture_u128 output = fixture_swap_output(i_r, o_r, amount);
+    if (rev) {
+      pool->udt2_reserve += amount;
+      pool->udt1_reserve -= output;
+    } else {
+      pool->udt1_reserve += amount;
+      pool->udt2_reserve -= output;
+    }
+  } else {
+    fixture_u128 amount = chain_random(chain) % 1000000000 + 1;
+    ret = add_user_cell(tx, ctx, 0, NULL, 0);
+    if (ret == 0) ret = add_user_cell(tx, ctx, 0, &ctx->udt1_type, amount);
+    if (ret == 0) ret = add_user_cell(tx, ctx, 1, &ctx->udt1_type, amount);
+    if (ret == 0) ret = add_user_cell(tx, ctx, 1, NULL, 0);
+    if (ret == 0) ret = set_user_witness(tx, 0);
+    if (ret != 0) {
+      return ret;
+    }
+  }
+  chain->out_point_seed = tx->out_point_seed;
+  return 0;
+}
+//out points of every transaction are new, so transaction hashes differ
+
+uint32_t fixture_chain_block(fixture_chain_t *chain, const fixture_context_t *ctx, size_t tx_cnt, uint8_t *out, size_t cap) {
+  size_t header_size = 4 * 5 + FIXTURE_HEADER_SIZE + 4;
+  size_t txs_header = 4 * (tx_cnt + 1);
+  uint32_t lens[4];
+  uint8_t *p = out + header_size + txs_header;
+  size_t i;
+  int ret = 0;
+
+  if (cap < header_size + txs_header + 4) {
+    return 0;
+  }
+  fixture_tx_t *tx = malloc(sizeof(fixture_tx_t));
+  uint32_t *tx_lens = malloc((tx_cnt > 0 ? tx_cnt : 1) * sizeof(uint32_t));
+  if (tx == NULL || tx_lens == NULL) {
+    free(tx);
+    free(tx_lens);
+    return 0;
+  }
+  for (i = 0; i < tx_cnt && ret == 0; i++) {
+    fixture_tx_init(tx);
+    ret = chain_tx(chain, ctx, tx);
+    if (ret == 0 && (size_t)(p - out) + fixture_tx_size(tx) + 4 > cap) {
+      ret = FIXTURE_ERROR_TOO_MANY_CELLS;
+    }
+    if (ret == 0) {
+      tx_lens[i] = fixture_tx_serialize(tx, p);
+      p += tx_lens[i];
+    }
+    fixture_tx_free(tx);
+  }
+  free(tx);
+  if (ret != 0) {
+    free(tx_lens);
+    return 0;
+  }
+
+  uint8_t *header = out + 4 * 5;
+  header_raw(chain->number, header);
+  memcpy(header + 32, chain->tip_hash, FIXTURE_HASH_SIZE);
+  blake2b_hash(header, FIXTURE_HEADER_SIZE, chain->tip_hash);
+  lens[0] = FIXTURE_HEADER_SIZE;
+  put_u32(header + FIXTURE_HEADER_SIZE, 4);
+  lens[1] = 4;
+  //no uncles
+  lens[2] = dynvec_header(out + header_size, tx_lens, tx_cnt);
+  put_u32(p, 0);
+  lens[3] = 4;
+  //no proposals
+  free(tx_lens);
+  chain->number += 1;
+  return dynvec_header(out, lens, 4);
+}
+//header hash is blake2b of header, as block hash of a node
+
+static size_t add_group(fixture_group_t groups[], size_t cnt, int script, int group_type, int is_output, size_t index) {
+  groups[cnt].script = script;
+  groups[cnt].group_type = group_type;
+  groups[cnt].is_output = is_output;
+  groups[cnt].index = index;
+  return cnt + 1;
+}
+
+size_t fixture_shape_groups(int shape, size_t pool_cnt, fixture_group_t groups[]) {
+  size_t i, cnt = 0;
+  switch (shape) {
+    case FIXTURE_SHAPE_CREATE:
+      cnt = add_group(groups, cnt, FIXTURE_SCRIPT_TYPE, FIXTURE_GROUP_TYPE, 1, 0);
+      break;
+    case FIXTURE_SHAPE_ADD:
+      cnt = add_group(groups, cnt, FIXTURE_SCRIPT_TYPE, FIXTURE_GROUP_TYPE, 0, 0);
+      cnt = add_group(groups, cnt, FIXTURE_SCRIPT_LOCK, FIXTURE_GROUP_LOCK, 0, 0);
+      cnt = add_group(groups, cnt, FIXTURE_SCRIPT_LIQUIDITY, FIXTURE_GROUP_TYPE, 1, ADD_LIQUIDITY_CELL_INDEX);
+      break;
+    case FIXTURE_SHAPE_REMOVE:
+      cnt = add_group(groups, cnt, FIXTURE_SCRIPT_TYPE, FIXTURE_GROUP_TYPE, 0, 0);
+      cnt = add_group(groups, cnt, FIXTURE_SCRIPT_LOCK, FIXTURE_GROUP_LOCK, 0, 0);
+      cnt = add_group(groups, cnt, FIXTURE_SCRIPT_LIQUIDITY, FIXTURE_GROUP_TYPE, 0, REMOVE_LIQUIDITY_CELL_START_INDEX);
+      break;
+    case FIXTURE_SHAPE_SWAP:
+      for (i = 0; i < pool_cnt; i++) {
+        cnt = add_group(groups, cnt, FIXTURE_SCRIPT_TYPE, FIXTURE_GROUP_TYPE, 0, 3 * i);
+      }
+      cnt = add_group(groups, cnt, FIXTURE_SCRIPT_LOCK, FIXTURE_GROUP_LOCK, 0, 0);
+      //pools of benchmark have same pair, one lock group
+      break;
+  }
+  return cnt;
+}
+
+const char *fixture_script_name(int script) {
+  switch (script) {
+    case FIXTURE_SCRIPT_TYPE:
+      return "type";
+    case FIXTURE_SCRIPT_LOCK:
+      return "lock";
+    case FIXTURE_SCRIPT_LIQUIDITY:
+      return "liquidity";
+  }
+  return "unknown";
+}
+
+/*
+ * UDTswap script of code hash, -1 for other scripts
+ * unified script is dispatched by args size as UDTswap_unified_udt_based does
+ */
+int fixture_script_of(const fixture_context_t *ctx, const fixture_script_t *script) {
+  if (script->hash_type != FIXTURE_HASH_TYPE_TYPE) {
+    return -1;
+  }
+  if (ctx->unified) {
+    if (memcmp(script->code_hash, ctx->type_code_hash, FIXTURE_HASH_SIZE) != 0) {
+      return -1;
+    }
+    switch (script->args_len) {
+      case FIXTURE_INPUT_SIZE:
+        return FIXTURE_SCRIPT_TYPE;
+      case 2 * FIXTURE_HASH_SIZE:
+        return FIXTURE_SCRIPT_LOCK;
+      case FIXTURE_HASH_SIZE + FIXTURE_INPUT_SIZE:
+        return FIXTURE_SCRIPT_LIQUIDITY;
+    }
+    return -1;
+  }
+  if (memcmp(script->code_hash, ctx->type_code_hash, FIXTURE_HASH_SIZE) == 0) {
+    return FIXTURE_SCRIPT_TYPE;
+  }
+  if (memcmp(script->code_hash, ctx->lock_code_hash, FIXTURE_HASH_SIZE) == 0) {
+    return FIXTURE_SCRIPT_LOCK;
+  }
+  if (memcmp(script->code_hash, ctx->liquidity_code_hash, FIXTURE_HASH_SIZE) == 0) {
+    return FIXTURE_SCRIPT_LIQUIDITY;
+  }
+  return -1;
+}
+
+/*
+ * ckb-debugger mock transaction
+ */
+
+static void write_hex(FILE *fp, const uint8_t *buf, size_t len) {
+  size_t i;
+  fputs("\"0x", fp);
+  for (i = 0; i < len; i++) {
+    fprintf(fp, "%02x", buf[i]);
+  }
+  fputc('"', fp);
+}
+
+static void write_number(FILE *fp, uint64_t v) {
+  fprintf(fp, "\"0x%llx\"", (unsigned long long)v);
+}
+
+static void write_script(FILE *fp, const fixture_script_t *script) {
+  fputs("{\"code_hash\":", fp);
+  write_hex(fp, script->code_hash, FIXTURE_HASH_SIZE);
+  fprintf(fp, ",\"hash_type\":\"%s\",\"args\":", script->hash_type == FIXTURE_HASH_TYPE_TYPE ? "type" : "data");
+  write_hex(fp, script->args, script->args_len);
+  fputc('}', fp);
+}
+
+static void write_output(FILE *fp, const fixture_cell_t *cell) {
+  fputs("{\"capacity\":", fp);
+  write_number(fp, cell->capacity);
+  fputs(",\"lock\":", fp);
+  write_script(fp, &cell->lock);
+  fputs(",\"type\":", fp);
+  if (cell->has_type) {
+    write_script(fp, &cell->type);
+  } else {
+    fputs("null", fp);
+  }
+  fputc('}', fp);
+}
+
+static void write_out_point(FILE *fp, const fixture_cell_t *cell) {
+  fputs("{\"tx_hash\":", fp);
+  write_hex(fp, cell->tx_hash, FIXTURE_HASH_SIZE);
+  fputs(",\"index\":", fp);
+  write_number(fp, cell->index);
+  fputc('}', fp);
+}
+
+static void write_input(FILE *fp, const fixture_cell_t *cell) {
+  fputs("{\"previous_output\":", fp);
+  write_out_point(fp, cell);
+  fputs(",\"since\":", fp);
+  write_number(fp, cell->since);
+  fputc('}', fp);
+}
+
+static void write_cell_dep(FILE *fp, const fixture_cell_t *cell) {
+  fputs("{\"out_point\":", fp);
+  write_out_point(fp, cell);
+  fputs(",\"dep_type\":\"code\"}", fp);
+}
+
+static uint64_t get_u64(const uint8_t *p) {
+  uint64_t ret = 0;
+  int i;
+  for (i = 0; i < 8; i++) {
+    ret |= (uint64_t)p[i] << (8 * i);
+  }
+  return ret;
+}
+
+static void write_header(FILE *fp, const fixture_header_t *header) {
+  const uint8_t *raw = header->raw;
+  fputs("{\"compact_target\":", fp);
+  write_number(fp, raw[4] | (raw[5] << 8) | (raw[6] << 16) | ((uint32_t)raw[7] << 24));
+  fputs(",\"dao\":", fp);
+  write_hex(fp, raw + 160, 32);
+  fputs(",\"epoch\":", fp);
+  write_number(fp, get_u64(raw + 24));
+  fputs(",\"extra_hash\":", fp);
+  write_hex(fp, raw + 128, 32);
+  fputs(",\"hash\":", fp);
+  write_hex(fp, header->hash, FIXTURE_HASH_SIZE);
+  fputs(",\"nonce\":\"0x0\",\"number\":", fp);
+  write_number(fp, header->number);
+  fputs(",\"parent_hash\":", fp);
+  write_hex(fp, raw + 32, 32);
+  fputs(",\"proposals_hash\":", fp);
+  write_hex(fp, raw + 96, 32);
+  fputs(",\"timestamp\":", fp);
+  write_number(fp, get_u64(raw + 8));
+  fputs(",\"transactions_root\":", fp);
+  write_hex(fp, raw + 64, 32);
+  fputs(",\"version\":\"0x0\"}", fp);
+}
+
+static void write_cell_header(FILE *fp, const fixture_tx_t *tx, const fixture_cell_t *cell) {
+  fputs(",\"header\":", fp);
+  if (cell->has_header) {
+    write_hex(fp, tx->headers[cell->header_index].hash, FIXTURE_HASH_SIZE);
+  } else {
+    fputs("null", fp);
+  }
+  fputs("}", fp);
+}
+
+int fixture_write_json(const fixture_tx_t *tx, FILE *fp) {
+  size_t i;
+
+  fputs("{\"mock_info\":{\"inputs\":[", fp);
+  for (i = 0; i < tx->input_cnt; i++) {
+    fputs(i == 0 ? "\n{\"input\":" : ",\n{\"input\":", fp);
+    write_input(fp, &tx->inputs[i]);
+    fputs(",\"output\":", fp);
+    write_output(fp, &tx->inputs[i]);
+    fputs(",\"data\":", fp);
+    write_hex(fp, tx->inputs[i].data, tx->inputs[i].data_len);
+    write_cell_header(fp, tx, &tx->inputs[i]);
+  }
+  fputs("],\"cell_deps\":[", fp);
+  for (i = 0; i < tx->dep_cnt; i++) {
+    fputs(i == 0 ? "\n{\"cell_dep\":" : ",\n{\"cell_dep\":", fp);
+    write_cell_dep(fp, &tx->deps[i]);
+    fputs(",\"output\":", fp);
+    write_output(fp, &tx->deps[i]);
+    fputs(",\"data\":", fp);
+    write_hex(fp, tx->deps[i].data, tx->deps[i].data_len);
+    write_cell_header(fp, tx, &tx->deps[i]);
+  }
+  fputs("],\"header_deps\":[", fp);
+  for (i = 0; i < tx->header_cnt; i++) {
+    fputs(i == 0 ? "\n" : ",\n", fp);
+    write_header(fp, &tx->headers[i]);
+  }
+  fputs("]},\n\"tx\":{\"version\":\"0x0\",\"cell_deps\":[", fp);
+  for (i = 0; i < tx->dep_cnt; i++) {
+    fputs(i == 0 ? "" : ",", fp);
+    write_cell_dep(fp, &tx->deps[i]);
+  }
+  fputs("],\"header_deps\":[", fp);
+  for (i = 0; i < tx->header_cnt; i++) {
+    fputs(i == 0 ? "" : ",", fp);
+    write_hex(fp, tx->headers[i].hash, FIXTURE_HASH_SIZE);
+  }
+  fputs("],\"inputs\":[", fp);
+  for (i = 0; i < tx->input_cnt; i++) {
+    fputs(i == 0 ? "" : ",", fp);
+    write_input(fp, &tx->inputs[i]);
+  }
+  fputs("],\"outputs\":[", fp);
+  for (i = 0; i < tx->output_cnt; i++) {
+    fputs(i == 0 ? "\n" : ",\n", fp);
+    write_output(fp, &tx->outputs[i]);
+  }
+  fputs("],\"outputs_data\":[", fp);
+  for (i = 0; i < tx->output_cnt; i++) {
+    fputs(i == 0 ? "" : ",", fp);
+    write_hex(fp, tx->outputs[i].data, tx->outputs[i].data_len);
+  }
+  fputs("],\"witnesses\":[", fp);
+  for (i = 0; i < tx->witness_cnt; i++) {
+    fputs(i == 0 ? "" : ",", fp);
+    write_hex(fp, tx->witnesses[i], tx->witness_len[i]);
+  }
+  fputs("]}}\n", fp);
+  return ferror(fp) ? FIXTURE_ERROR_IO : 0;
+}
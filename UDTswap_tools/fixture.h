@@ -0,0 +1,213 @@
+#ifndef UDTSWAP_FIXTURE_H_
+#define UDTSWAP_FIXTURE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define FIXTURE_MAX_CELLS 128
+#define FIXTURE_MAX_HEADERS 16
+#define FIXTURE_MAX_ARGS 128
+#define FIXTURE_MAX_POOLS 16
+#define FIXTURE_HASH_SIZE 32
+#define FIXTURE_HEADER_SIZE 208
+#define FIXTURE_INPUT_SIZE 44
+
+#define FIXTURE_HASH_TYPE_DATA 0
+#define FIXTURE_HASH_TYPE_TYPE 1
+
+#define FIXTURE_PAIR_CKB_UDT 0
+#define FIXTURE_PAIR_UDT_UDT 1
+
+#define FIXTURE_SWAP_UDT1_INPUT 0
+#define FIXTURE_SWAP_UDT2_INPUT 1
+
+#define FIXTURE_SHAPE_CREATE 0
+#define FIXTURE_SHAPE_ADD 1
+#define FIXTURE_SHAPE_REMOVE 2
+#define FIXTURE_SHAPE_SWAP 3
+
+#define FIXTURE_GROUP_LOCK 0
+#define FIXTURE_GROUP_TYPE 1
+
+#define FIXTURE_SCRIPT_TYPE 0
+#define FIXTURE_SCRIPT_LOCK 1
+#define FIXTURE_SCRIPT_LIQUIDITY 2
+
+#define FIXTURE_ERROR_TOO_MANY_CELLS -1
+#define FIXTURE_ERROR_AMOUNT -2
+#define FIXTURE_ERROR_IO -3
+
+typedef unsigned __int128 fixture_u128;
+
+typedef struct {
+  uint8_t code_hash[FIXTURE_HASH_SIZE];
+  uint8_t hash_type;
+  uint8_t args[FIXTURE_MAX_ARGS];
+  uint32_t args_len;
+} fixture_script_t;
+
+typedef struct {
+  uint8_t tx_hash[FIXTURE_HASH_SIZE];
+  uint32_t index;
+  uint64_t since;
+  uint64_t capacity;
+  fixture_script_t lock;
+  int has_type;
+  fixture_script_t type;
+  uint8_t *data;
+  uint32_t data_len;
+  int has_header;
+  uint32_t header_index; //header dep of block of cell
+} fixture_cell_t;
+
+typedef struct {
+  uint64_t number;
+  uint8_t hash[FIXTURE_HASH_SIZE];
+  uint8_t raw[FIXTURE_HEADER_SIZE];
+} fixture_header_t;
+
+typedef struct {
+  fixture_cell_t inputs[FIXTURE_MAX_CELLS];
+  size_t input_cnt;
+  fixture_cell_t outputs[FIXTURE_MAX_CELLS];
+  size_t output_cnt;
+  fixture_cell_t deps[FIXTURE_MAX_CELLS];
+  size_t dep_cnt;
+  fixture_header_t headers[FIXTURE_MAX_HEADERS];
+  size_t header_cnt;
+  uint8_t *witnesses[FIXTURE_MAX_CELLS];
+  uint32_t witness_len[FIXTURE_MAX_CELLS];
+  size_t witness_cnt;
+  uint32_t out_point_seed;
+} fixture_tx_t;
+
+/*
+ * UDTswap pool state
+ * reserves are actual reserves, except empty pool reserve (300 ckb or 1 UDT)
+ */
+typedef struct {
+  int kind;
+  uint32_t pool_id;
+  fixture_u128 udt1_reserve;
+  fixture_u128 udt2_reserve;
+  fixture_u128 total_liquidity;
+  int extended;
+  uint64_t last_update;
+  uint8_t price1_cumulative[32];
+  uint8_t price2_cumulative[32];
+} fixture_pool_t;
+
+/*
+ * script code hashes and UDT type scripts shared by fixtures
+ * code hashes are type hashes of the code cell deps
+ * unified context has one code cell dep of UDTswap_unified_udt_based for all 3 scripts
+ * bn library cell dep is added when bn_lib is in script directory (BN=dynamic build)
+ */
+typedef struct {
+  int unified;
+  fixture_script_t type_code_dep;
+  fixture_script_t lock_code_dep;
+  fixture_script_t liquidity_code_dep;
+  uint8_t type_code_hash[FIXTURE_HASH_SIZE];
+  uint8_t lock_code_hash[FIXTURE_HASH_SIZE];
+  uint8_t liquidity_code_hash[FIXTURE_HASH_SIZE];
+  fixture_script_t bn_lib_code_dep;
+  uint8_t bn_lib_code_hash[FIXTURE_HASH_SIZE];
+  fixture_script_t udt1_type;
+  fixture_script_t udt2_type;
+  fixture_script_t user_lock;
+  fixture_script_t fee_lock;
+  uint64_t block_number;
+  int swap_mode;
+} fixture_context_t;
+
+/*
+ * chain of fixture blocks, number and hash of next block parent
+ * pools are UDT pair pools, states after swaps of blocks
+ */
+typedef struct {
+  uint64_t number;
+  uint8_t tip_hash[FIXTURE_HASH_SIZE];
+  fixture_pool_t pools[FIXTURE_MAX_POOLS];
+  size_t pool_cnt;
+  uint64_t seed;
+  uint32_t out_point_seed;
+} fixture_chain_t;
+
+/*
+ * UDTswap script group of a transaction shape
+ */
+typedef struct {
+  int script;
+  int group_type;
+  int is_output;
+  size_t index;
+} fixture_group_t;
+
+/* molecule serialization and hashes */
+uint32_t fixture_script_serialize(const fixture_script_t *script, uint8_t *out);
+void fixture_script_hash(const fixture_script_t *script, uint8_t out[FIXTURE_HASH_SIZE]);
+uint32_t fixture_cell_output_serialize(const fixture_cell_t *cell, uint8_t *out);
+void fixture_cell_input_serialize(const fixture_cell_t *cell, uint8_t out[FIXTURE_INPUT_SIZE]);
+void fixture_data_hash(const fixture_cell_t *cell, uint8_t out[FIXTURE_HASH_SIZE]);
+
+/* transaction */
+void fixture_tx_init(fixture_tx_t *tx);
+void fixture_tx_free(fixture_tx_t *tx);
+fixture_cell_t *fixture_tx_add_input(fixture_tx_t *tx);
+fixture_cell_t *fixture_tx_add_output(fixture_tx_t *tx);
+fixture_cell_t *fixture_tx_add_dep(fixture_tx_t *tx);
+fixture_header_t *fixture_tx_add_header(fixture_tx_t *tx, uint64_t number);
+/* cell committed in block of number, header dep of same number is shared */
+int fixture_cell_set_header(fixture_tx_t *tx, fixture_cell_t *cell, uint64_t number);
+int fixture_tx_set_witness(fixture_tx_t *tx, size_t index, const uint8_t *witness, uint32_t len);
+void fixture_cell_set_data(fixture_cell_t *cell, const uint8_t *data, uint32_t len);
+int fixture_cell_load_data(fixture_cell_t *cell, const char *path);
+
+/* molecule Transaction of tx, out has fixture_tx_size bytes, hash is hash of RawTransaction */
+uint32_t fixture_tx_size(const fixture_tx_t *tx);
+uint32_t fixture_tx_serialize(const fixture_tx_t *tx, uint8_t *out);
+void fixture_tx_hash(const fixture_tx_t *tx, uint8_t out[FIXTURE_HASH_SIZE]);
+
+/* UDTswap shapes */
+int fixture_context_init(fixture_context_t *ctx);
+void fixture_context_unify(fixture_context_t *ctx);
+int fixture_add_code_deps(fixture_tx_t *tx, const fixture_context_t *ctx, const char *bin_dir);
+void fixture_pool_init(fixture_pool_t *pool, int kind, uint32_t pool_id);
+int fixture_create(fixture_tx_t *tx, const fixture_context_t *ctx, int kind, int extended);
+int fixture_add_liquidity(fixture_tx_t *tx, const fixture_context_t *ctx, const fixture_pool_t *pool, fixture_u128 udt1_amount);
+int fixture_remove_liquidity(fixture_tx_t *tx, const fixture_context_t *ctx, const fixture_pool_t *pool, fixture_u128 liquidity);
+int fixture_swap(
+  fixture_tx_t *tx,
+  const fixture_context_t *ctx,
+  const fixture_pool_t pools[],
+  size_t pool_cnt,
+  const fixture_u128 input_amounts[],
+  const int directions[]
+);
+
+/* transaction shapes of benchmark, pools with same reserves */
+void fixture_bench_pool(fixture_pool_t *pool, const fixture_context_t *ctx, int kind, uint32_t pool_id, int extended);
+int fixture_bench_tx(fixture_tx_t *tx, const fixture_context_t *ctx, int shape, int kind, size_t pool_cnt, int extended, int direction);
+/* capacity of outputs not above capacity of inputs, by the user change cell of the transaction */
+int fixture_balance_capacity(fixture_tx_t *tx, const fixture_context_t *ctx);
+size_t fixture_shape_groups(int shape, size_t pool_cnt, fixture_group_t groups[]);
+const char *fixture_script_name(int script);
+int fixture_script_of(const fixture_context_t *ctx, const fixture_script_t *script);
+
+/* chain of molecule Blocks, size of next block or 0 when it does not fit cap */
+void fixture_chain_init(fixture_chain_t *chain, const fixture_context_t *ctx, size_t pool_cnt, uint64_t seed);
+uint32_t fixture_chain_block(fixture_chain_t *chain, const fixture_context_t *ctx, size_t tx_cnt, uint8_t *out, size_t cap);
+void fixture_pool_type_hash(const fixture_context_t *ctx, const fixture_pool_t *pool, uint8_t out[FIXTURE_HASH_SIZE]);
+
+/* UDTswap formulas */
+fixture_u128 fixture_swap_output(fixture_u128 i_r, fixture_u128 o_r, fixture_u128 input_amount);
+int fixture_add_liquidity_amounts(const fixture_pool_t *pool, fixture_u128 udt1_amount, fixture_u128 *udt2_amount, fixture_u128 *liquidity);
+void fixture_remove_liquidity_amounts(const fixture_pool_t *pool, fixture_u128 liquidity, fixture_u128 *udt1_amount, fixture_u128 *udt2_amount);
+void fixture_update_price_cumulative(fixture_u128 i_r, fixture_u128 o_r, uint64_t elapsed, uint8_t price_cumulative[32]);
+
+/* ckb-debugger mock transaction */
+int fixture_write_json(const fixture_tx_t *tx, FILE *fp);
+
+#endif /* UDTSWAP_FIXTURE_H_ */
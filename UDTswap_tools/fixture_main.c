@@ -0,0 +1,252 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "fixture.h"
+
+static void usage(void) {
+  fprintf(stderr,
+    "usage: udtswap_fixture hashes [-u]\n"
+    "       udtswap_fixture groups <create|add|remove|swap> [-n pools]\n"
+    "       udtswap_fixture blocks [-n blocks] [-t txs] [-p pools] [-s seed] [-o file]\n"
+    "       udtswap_fixture <create|add|remove|swap> [options]\n"
+    "  -p ckb-udt|udt-udt  pool pair kind (default ckb-udt)\n"
+    "  -n pools            pool count of swap (default 1)\n"
+    "  -x                  extended pool data with price accumulators\n"
+    "  -d 1|2              swap input udt (default 1)\n"
+    "  -m auto|input|output swap mode witness hint (default input)\n"
+    "  -u                  one code cell dep of UDTswap_unified_udt_based for all scripts\n"
+    "  -b dir              directory of compiled scripts for code cell deps\n"
+    "  -o file             output file (default stdout)\n");
+}
+
+static int parse_shape(const char *name) {
+  if (strcmp(name, "create") == 0) return FIXTURE_SHAPE_CREATE;
+  if (strcmp(name, "add") == 0) return FIXTURE_SHAPE_ADD;
+  if (strcmp(name, "remove") == 0) return FIXTURE_SHAPE_REMOVE;
+  if (strcmp(name, "swap") == 0) return FIXTURE_SHAPE_SWAP;
+  return -1;
+}
+
+static void print_hash(const uint8_t hash[FIXTURE_HASH_SIZE]) {
+  int i;
+  for (i = 0; i < FIXTURE_HASH_SIZE; i++) {
+    printf(i == 0 ? "%d" : ",%d", hash[i]);
+  }
+  printf("\n");
+}
+
+/*
+ * code hashes in hash.txt format, input of hash.sh
+ * test udt and bn library are 4th and 5th lines as written by deploy
+ */
+static int print_hashes(const fixture_context_t *ctx) {
+  print_hash(ctx->type_code_hash);
+  print_hash(ctx->lock_code_hash);
+  print_hash(ctx->liquidity_code_hash);
+  print_hash(ctx->udt1_type.code_hash);
+  print_hash(ctx->bn_lib_code_hash);
+  return 0;
+}
+
+/*
+ * script groups of shape, one line of name, script group type, cell type, cell index
+ */
+static int print_groups(int shape, int pool_cnt) {
+  fixture_group_t groups[FIXTURE_MAX_POOLS + 2];
+  size_t i, cnt = fixture_shape_groups(shape, (size_t)pool_cnt, groups);
+  for (i = 0; i < cnt; i++) {
+    printf(
+      "%s %s %s %zu\n",
+      fixture_script_name(groups[i].script),
+      groups[i].group_type == FIXTURE_GROUP_LOCK ? "lock" : "type",
+      groups[i].is_output ? "output" : "input",
+      groups[i].index
+    );
+  }
+  return 0;
+}
+
+#define FIXTURE_BLOCK_TX_SIZE 8192
+
+/*
+ * chain of molecule Blocks, concatenated in block order
+ * transactions are udt transfers and swaps of UDT pair pools
+ */
+static int write_blocks(const fixture_context_t *ctx, int argc, char *argv[]) {
+  long block_cnt = 1000, tx_cnt = 16, pool_cnt = FIXTURE_MAX_POOLS, seed = 1, i;
+  const char *out_path = NULL;
+  fixture_chain_t chain;
+  int opt;
+
+  optind = 2;
+  while ((opt = getopt(argc, argv, "n:t:p:s:o:")) != -1) {
+    switch (opt) {
+      case 'n':
+        block_cnt = atol(optarg);
+        break;
+      case 't':
+        tx_cnt = atol(optarg);
+        break;
+      case 'p':
+        pool_cnt = atol(optarg);
+        break;
+      case 's':
+        seed = atol(optarg);
+        break;
+      case 'o':
+        out_path = optarg;
+        break;
+      default:
+        usage();
+        return 1;
+    }
+  }
+  if (block_cnt < 0 || tx_cnt < 0 || pool_cnt < 0 || pool_cnt > FIXTURE_MAX_POOLS) {
+    fprintf(stderr, "pool count should be 0 ~ %d\n", FIXTURE_MAX_POOLS);
+    return 1;
+  }
+  size_t cap = FIXTURE_BLOCK_TX_SIZE * ((size_t)tx_cnt + 1);
+  uint8_t *block = malloc(cap);
+  FILE *fp = out_path == NULL ? stdout : fopen(out_path, "wb");
+  if (block == NULL || fp == NULL) {
+    fprintf(stderr, "cannot open %s\n", out_path);
+    free(block);
+    return 1;
+  }
+  fixture_chain_init(&chain, ctx, (size_t)pool_cnt, (uint64_t)seed);
+  for (i = 0; i < block_cnt; i++) {
+    uint32_t len = fixture_chain_block(&chain, ctx, (size_t)tx_cnt, block, cap);
+    if (len == 0 || fwrite(block, 1, len, fp) != len) {
+      fprintf(stderr, "cannot write block %ld\n", i);
+      break;
+    }
+  }
+  if (fp != stdout) {
+    fclose(fp);
+  }
+  free(block);
+  return i == block_cnt ? 0 : 1;
+}
+
+int main(int argc, char *argv[]) {
+  fixture_context_t ctx;
+  int kind = FIXTURE_PAIR_CKB_UDT, pool_cnt = 1, extended = 0, direction = FIXTURE_SWAP_UDT1_INPUT;
+  const char *bin_dir = NULL, *out_path = NULL;
+  int shape, opt, ret;
+
+  if (argc < 2) {
+    usage();
+    return 1;
+  }
+  fixture_context_init(&ctx);
+  if (strcmp(argv[1], "hashes") == 0) {
+    if (argc > 2 && strcmp(argv[2], "-u") == 0) {
+      fixture_context_unify(&ctx);
+    }
+    return print_hashes(&ctx);
+  }
+  if (strcmp(argv[1], "blocks") == 0) {
+    return write_blocks(&ctx, argc, argv);
+  }
+  int groups = strcmp(argv[1], "groups") == 0;
+  if (groups) {
+    argv++;
+    argc--;
+    if (argc < 2) {
+      usage();
+      return 1;
+    }
+  }
+  shape = parse_shape(argv[1]);
+  if (shape < 0) {
+    usage();
+    return 1;
+  }
+
+  optind = 2;
+  while ((opt = getopt(argc, argv, "p:n:xd:m:ub:o:")) != -1) {
+    switch (opt) {
+      case 'p':
+        if (strcmp(optarg, "ckb-udt") == 0) {
+          kind = FIXTURE_PAIR_CKB_UDT;
+        } else if (strcmp(optarg, "udt-udt") == 0) {
+          kind = FIXTURE_PAIR_UDT_UDT;
+        } else {
+          usage();
+          return 1;
+        }
+        break;
+      case 'n':
+        pool_cnt = atoi(optarg);
+        if (pool_cnt < 1 || pool_cnt > FIXTURE_MAX_POOLS) {
+          fprintf(stderr, "pool count should be 1 ~ %d\n", FIXTURE_MAX_POOLS);
+          return 1;
+        }
+        break;
+      case 'x':
+        extended = 1;
+        break;
+      case 'd':
+        direction = atoi(optarg) == 2 ? FIXTURE_SWAP_UDT2_INPUT : FIXTURE_SWAP_UDT1_INPUT;
+        break;
+      case 'm':
+        if (strcmp(optarg, "auto") == 0) {
+          ctx.swap_mode = 0;
+        } else if (strcmp(optarg, "input") == 0) {
+          ctx.swap_mode = 1;
+        } else if (strcmp(optarg, "output") == 0) {
+          ctx.swap_mode = 2;
+        } else {
+          usage();
+          return 1;
+        }
+        break;
+      case 'u':
+        fixture_context_unify(&ctx);
+        break;
+      case 'b':
+        bin_dir = optarg;
+        break;
+      case 'o':
+        out_path = optarg;
+        break;
+      default:
+        usage();
+        return 1;
+    }
+  }
+  if (groups) {
+    return print_groups(shape, pool_cnt);
+  }
+
+  fixture_tx_t *tx = malloc(sizeof(fixture_tx_t));
+  if (tx == NULL) {
+    return 1;
+  }
+  fixture_tx_init(tx);
+  ret = fixture_add_code_deps(tx, &ctx, bin_dir);
+  if (ret != 0) {
+    fprintf(stderr, "cannot load scripts from %s\n", bin_dir);
+    return 1;
+  }
+
+  ret = fixture_bench_tx(tx, &ctx, shape, kind, (size_t)pool_cnt, extended, direction);
+  if (ret != 0) {
+    fprintf(stderr, "cannot build transaction: %d\n", ret);
+    return 1;
+  }
+
+  FILE *fp = out_path == NULL ? stdout : fopen(out_path, "w");
+  if (fp == NULL) {
+    fprintf(stderr, "cannot open %s\n", out_path);
+    return 1;
+  }
+  ret = fixture_write_json(tx, fp);
+  if (fp != stdout) {
+    fclose(fp);
+  }
+  fixture_tx_free(tx);
+  free(tx);
+  return ret == 0 ? 0 : 1;
+}
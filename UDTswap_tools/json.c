@@ -0,0 +1,247 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "json.h"
+
+typedef struct {
+  const char *p;
+} json_parser;
+
+static json_value *parse_value(json_parser *ps);
+
+static void skip_space(json_parser *ps) {
+  while (*ps->p == ' ' || *ps->p == '\t' || *ps->p == '\n' || *ps->p == '\r') {
+    ps->p++;
+  }
+}
+
+static json_value *new_value(int kind) {
+  json_value *value = calloc(1, sizeof(json_value));
+  if (value != NULL) {
+    value->kind = kind;
+  }
+  return value;
+}
+
+static char *parse_string_text(json_parser *ps) {
+  const char *start;
+  size_t len = 0;
+  char *out;
+  if (*ps->p != '"') {
+    return NULL;
+  }
+  start = ++ps->p;
+  while (*ps->p != '"') {
+    if (*ps->p == '\0') {
+      return NULL;
+    }
+    if (*ps->p == '\\' && ps->p[1] != '\0') {
+      ps->p++;
+    }
+    ps->p++;
+  }
+  out = malloc(ps->p - start + 1);
+  if (out == NULL) {
+    return NULL;
+  }
+  while (start < ps->p) {
+    if (*start == '\\') {
+      start++;
+    }
+    out[len++] = *start++;
+  }
+  out[len] = '\0';
+  ps->p++;
+  return out;
+}
+
+static json_value *parse_members(json_parser *ps, int kind, char close) {
+  json_value *value = new_value(kind);
+  json_value **tail;
+  if (value == NULL) {
+    return NULL;
+  }
+  tail = &value->child;
+  ps->p++;
+  skip_space(ps);
+  if (*ps->p == close) {
+    ps->p++;
+    return value;
+  }
+  while (1) {
+    char *key = NULL;
+    skip_space(ps);
+    if (kind == JSON_OBJECT) {
+      key = parse_string_text(ps);
+      skip_space(ps);
+      if (key == NULL || *ps->p != ':') {
+        free(key);
+        json_free(value);
+        return NULL;
+      }
+      ps->p++;
+    }
+    json_value *member = parse_value(ps);
+    if (member == NULL) {
+      free(key);
+      json_free(value);
+      return NULL;
+    }
+    member->key = key;
+    *tail = member;
+    tail = &member->next;
+    skip_space(ps);
+    if (*ps->p == ',') {
+      ps->p++;
+    } else if (*ps->p == close) {
+      ps->p++;
+      return value;
+    } else {
+      json_free(value);
+      return NULL;
+    }
+  }
+}
+
+static json_value *parse_literal(json_parser *ps, int kind) {
+  const char *start = ps->p;
+  json_value *value;
+  while (*ps->p != '\0' && strchr(",]} \t\r\n", *ps->p) == NULL) {
+    ps->p++;
+  }
+  if (ps->p == start) {
+    return NULL;
+  }
+  value = new_value(kind);
+  if (value == NULL) {
+    return NULL;
+  }
+  value->text = malloc(ps->p - start + 1);
+  if (value->text == NULL) {
+    free(value);
+    return NULL;
+  }
+  memcpy(value->text, start, ps->p - start);
+  value->text[ps->p - start] = '\0';
+  if (kind == JSON_NULL && strcmp(value->text, "null") != 0) {
+    json_free(value);
+    return NULL;
+  }
+  return value;
+}
+
+static json_value *parse_value(json_parser *ps) {
+  skip_space(ps);
+  switch (*ps->p) {
+    case '{':
+      return parse_members(ps, JSON_OBJECT, '}');
+    case '[':
+      return parse_members(ps, JSON_ARRAY, ']');
+    case '"': {
+      json_value *value = new_value(JSON_STRING);
+      if (value == NULL) {
+        return NULL;
+      }
+      value->text = parse_string_text(ps);
+      if (value->text == NULL) {
+        free(value);
+        return NULL;
+      }
+      return value;
+    }
+    case 't':
+    case 'f':
+      return parse_literal(ps, JSON_BOOL);
+    case 'n':
+      return parse_literal(ps, JSON_NULL);
+    default:
+      return parse_literal(ps, JSON_NUMBER);
+  }
+}
+
+json_value *json_parse(const char *text) {
+  json_parser ps;
+  ps.p = text;
+  json_value *value = parse_value(&ps);
+  if (value == NULL) {
+    return NULL;
+  }
+  skip_space(&ps);
+  if (*ps.p != '\0') {
+    json_free(value);
+    return NULL;
+  }
+  return value;
+}
+
+json_value *json_parse_file(const char *path) {
+  FILE *fp = fopen(path, "rb");
+  if (fp == NULL) {
+    return NULL;
+  }
+  fseek(fp, 0, SEEK_END);
+  long size = ftell(fp);
+  fseek(fp, 0, SEEK_SET);
+  if (size < 0) {
+    fclose(fp);
+    return NULL;
+  }
+  char *text = malloc(size + 1);
+  if (text == NULL || fread(text, 1, size, fp) != (size_t)size) {
+    free(text);
+    fclose(fp);
+    return NULL;
+  }
+  fclose(fp);
+  text[size] = '\0';
+  json_value *value = json_parse(text);
+  free(text);
+  return value;
+}
+
+void json_free(json_value *value) {
+  while (value != NULL) {
+    json_value *next = value->next;
+    json_free(value->child);
+    free(value->text);
+    free(value->key);
+    free(value);
+    value = next;
+  }
+}
+
+json_value *json_get(const json_value *object, const char *key) {
+  json_value *member;
+  if (object == NULL || object->kind != JSON_OBJECT) {
+    return NULL;
+  }
+  for (member = object->child; member != NULL; member = member->next) {
+    if (strcmp(member->key, key) == 0) {
+      return member;
+    }
+  }
+  return NULL;
+}
+
+json_value *json_at(const json_value *array, size_t index) {
+  json_value *element;
+  if (array == NULL || array->kind != JSON_ARRAY) {
+    return NULL;
+  }
+  for (element = array->child; element != NULL && index > 0; element = element->next) {
+    index--;
+  }
+  return element;
+}
+
+size_t json_len(const json_value *array) {
+  json_value *element;
+  size_t len = 0;
+  if (array == NULL || array->kind != JSON_ARRAY) {
+    return 0;
+  }
+  for (element = array->child; element != NULL; element = element->next) {
+    len++;
+  }
+  return len;
+}
@@ -0,0 +1,33 @@
+#ifndef UDTSWAP_JSON_H_
+#define UDTSWAP_JSON_H_
+
+#include <stddef.h>
+
+#define JSON_NULL 0
+#define JSON_BOOL 1
+#define JSON_NUMBER 2
+#define JSON_STRING 3
+#define JSON_ARRAY 4
+#define JSON_OBJECT 5
+
+/*
+ * minimal json reader for mock transaction files
+ * numbers are kept as text, strings are not unescaped except \" and \\
+ */
+typedef struct json_value {
+  int kind;
+  char *text;                /* string, number, bool */
+  char *key;                 /* member name in object */
+  struct json_value *child;  /* first element of array, object */
+  struct json_value *next;
+} json_value;
+
+json_value *json_parse(const char *text);
+json_value *json_parse_file(const char *path);
+void json_free(json_value *value);
+
+json_value *json_get(const json_value *object, const char *key);
+json_value *json_at(const json_value *array, size_t index);
+size_t json_len(const json_value *array);
+
+#endif /* UDTSWAP_JSON_H_ */
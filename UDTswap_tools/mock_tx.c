@@ -0,0 +1,270 @@
+#include <stdlib.h>
+#include <string.h>
+#include "json.h"
+#include "mock_tx.h"
+
+static int hex_value(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+
+/*
+ * 0x prefixed bytes, returns byte length or -1
+ */
+static long read_bytes(const json_value *value, uint8_t *out, size_t max_len) {
+  size_t i, len;
+  if (value == NULL || value->kind != JSON_STRING || strncmp(value->text, "0x", 2) != 0) {
+    return -1;
+  }
+  const char *hex = value->text + 2;
+  if (strlen(hex) % 2 != 0) {
+    return -1;
+  }
+  len = strlen(hex) / 2;
+  if (len > max_len) {
+    return -1;
+  }
+  for (i = 0; i < len; i++) {
+    int hi = hex_value(hex[2 * i]), lo = hex_value(hex[2 * i + 1]);
+    if (hi < 0 || lo < 0) {
+      return -1;
+    }
+    out[i] = (uint8_t)(hi * 16 + lo);
+  }
+  return (long)len;
+}
+
+static int read_number(const json_value *value, uint64_t *out) {
+  if (value == NULL || value->kind != JSON_STRING || strncmp(value->text, "0x", 2) != 0) {
+    return MOCK_TX_ERROR_FORMAT;
+  }
+  char *end;
+  *out = strtoull(value->text + 2, &end, 16);
+  return *end == '\0' && end != value->text + 2 ? 0 : MOCK_TX_ERROR_FORMAT;
+}
+
+static int read_hash(const json_value *value, uint8_t out[FIXTURE_HASH_SIZE]) {
+  return read_bytes(value, out, FIXTURE_HASH_SIZE) == FIXTURE_HASH_SIZE ? 0 : MOCK_TX_ERROR_FORMAT;
+}
+
+static int read_data(const json_value *value, fixture_cell_t *cell) {
+  if (value == NULL || value->kind != JSON_STRING) {
+    return MOCK_TX_ERROR_FORMAT;
+  }
+  size_t max_len = strlen(value->text) / 2;
+  uint8_t *buf = malloc(max_len > 0 ? max_len : 1);
+  long len = read_bytes(value, buf, max_len);
+  if (len < 0) {
+    free(buf);
+    return MOCK_TX_ERROR_FORMAT;
+  }
+  free(cell->data);
+  cell->data = buf;
+  cell->data_len = (uint32_t)len;
+  return 0;
+}
+
+static int read_script(const json_value *value, fixture_script_t *script) {
+  const json_value *hash_type = json_get(value, "hash_type");
+  memset(script, 0, sizeof(*script));
+  if (read_hash(json_get(value, "code_hash"), script->code_hash) != 0 || hash_type == NULL || hash_type->text == NULL) {
+    return MOCK_TX_ERROR_FORMAT;
+  }
+  if (strcmp(hash_type->text, "type") == 0) {
+    script->hash_type = FIXTURE_HASH_TYPE_TYPE;
+  } else if (strcmp(hash_type->text, "data") == 0) {
+    script->hash_type = FIXTURE_HASH_TYPE_DATA;
+  } else {
+    return MOCK_TX_ERROR_FORMAT;
+  }
+  long len = read_bytes(json_get(value, "args"), script->args, FIXTURE_MAX_ARGS);
+  if (len < 0) {
+    return MOCK_TX_ERROR_FORMAT;
+  }
+  script->args_len = (uint32_t)len;
+  return 0;
+}
+
+static int read_output(const json_value *value, fixture_cell_t *cell) {
+  const json_value *type = json_get(value, "type");
+  if (read_number(json_get(value, "capacity"), &cell->capacity) != 0) {
+    return MOCK_TX_ERROR_FORMAT;
+  }
+  if (read_script(json_get(value, "lock"), &cell->lock) != 0) {
+    return MOCK_TX_ERROR_FORMAT;
+  }
+  cell->has_type = type != NULL && type->kind == JSON_OBJECT;
+  if (cell->has_type && read_script(type, &cell->type) != 0) {
+    return MOCK_TX_ERROR_FORMAT;
+  }
+  return 0;
+}
+
+static int read_out_point(const json_value *value, fixture_cell_t *cell) {
+  uint64_t index;
+  if (read_hash(json_get(value, "tx_hash"), cell->tx_hash) != 0 || read_number(json_get(value, "index"), &index) != 0) {
+    return MOCK_TX_ERROR_FORMAT;
+  }
+  cell->index = (uint32_t)index;
+  return 0;
+}
+
+static void put_u64(uint8_t *p, uint64_t v) {
+  int i;
+  for (i = 0; i < 8; i++) {
+    p[i] = (v >> (8 * i)) & 0xff;
+  }
+}
+
+static int read_header(const json_value *value, fixture_header_t *header) {
+  uint64_t version, compact_target, timestamp, epoch, nonce;
+  uint8_t *raw = header->raw;
+  memset(header, 0, sizeof(*header));
+  if (
+    read_number(json_get(value, "version"), &version) != 0 ||
+    read_number(json_get(value, "compact_target"), &compact_target) != 0 ||
+    read_number(json_get(value, "timestamp"), &timestamp) != 0 ||
+    read_number(json_get(value, "number"), &header->number) != 0 ||
+    read_number(json_get(value, "epoch"), &epoch) != 0 ||
+    read_hash(json_get(value, "parent_hash"), raw + 32) != 0 ||
+    read_hash(json_get(value, "transactions_root"), raw + 64) != 0 ||
+    read_hash(json_get(value, "proposals_hash"), raw + 96) != 0 ||
+    read_hash(json_get(value, "dao"), raw + 160) != 0 ||
+    read_hash(json_get(value, "hash"), header->hash) != 0 ||
+    read_number(json_get(value, "nonce"), &nonce) != 0
+  ) {
+    return MOCK_TX_ERROR_FORMAT;
+  }
+  const json_value *extra_hash = json_get(value, "extra_hash");
+  if (extra_hash == NULL) {
+    extra_hash = json_get(value, "uncles_hash");
+  }
+  if (read_hash(extra_hash, raw + 128) != 0) {
+    return MOCK_TX_ERROR_FORMAT;
+  }
+  raw[0] = version & 0xff;
+  raw[1] = (version >> 8) & 0xff;
+  raw[2] = (version >> 16) & 0xff;
+  raw[3] = (version >> 24) & 0xff;
+  raw[4] = compact_target & 0xff;
+  raw[5] = (compact_target >> 8) & 0xff;
+  raw[6] = (compact_target >> 16) & 0xff;
+  raw[7] = (compact_target >> 24) & 0xff;
+  put_u64(raw + 8, timestamp);
+  put_u64(raw + 16, header->number);
+  put_u64(raw + 24, epoch);
+  put_u64(raw + 192, nonce);
+  //nonce above 64 bits is not used by UDTswap
+  return 0;
+}
+
+/*
+ * block hash of cell, null or one of header deps
+ */
+static int read_cell_header(const json_value *value, const fixture_tx_t *tx, fixture_cell_t *cell) {
+  uint8_t hash[FIXTURE_HASH_SIZE];
+  size_t i;
+  if (value == NULL || value->kind == JSON_NULL) {
+    return 0;
+  }
+  if (read_hash(value, hash) != 0) {
+    return MOCK_TX_ERROR_FORMAT;
+  }
+  for (i = 0; i < tx->header_cnt; i++) {
+    if (memcmp(tx->headers[i].hash, hash, FIXTURE_HASH_SIZE) == 0) {
+      cell->has_header = 1;
+      cell->header_index = (uint32_t)i;
+      return 0;
+    }
+  }
+  return MOCK_TX_ERROR_FORMAT;
+}
+
+static int load(const json_value *root, fixture_tx_t *tx) {
+  const json_value *mock_info = json_get(root, "mock_info");
+  const json_value *raw_tx = json_get(root, "tx");
+  const json_value *inputs = json_get(mock_info, "inputs");
+  const json_value *deps = json_get(mock_info, "cell_deps");
+  const json_value *headers = json_get(mock_info, "header_deps");
+  const json_value *outputs = json_get(raw_tx, "outputs");
+  const json_value *outputs_data = json_get(raw_tx, "outputs_data");
+  const json_value *witnesses = json_get(raw_tx, "witnesses");
+  size_t i;
+
+  if (
+    json_len(inputs) > FIXTURE_MAX_CELLS || json_len(deps) > FIXTURE_MAX_CELLS ||
+    json_len(outputs) > FIXTURE_MAX_CELLS || json_len(witnesses) > FIXTURE_MAX_CELLS ||
+    json_len(headers) > FIXTURE_MAX_HEADERS || json_len(outputs) != json_len(outputs_data)
+  ) {
+    return FIXTURE_ERROR_TOO_MANY_CELLS;
+  }
+  for (i = 0; i < json_len(inputs); i++) {
+    const json_value *input = json_at(inputs, i);
+    const json_value *cell_input = json_get(input, "input");
+    fixture_cell_t *cell = fixture_tx_add_input(tx);
+    if (
+      read_out_point(json_get(cell_input, "previous_output"), cell) != 0 ||
+      read_number(json_get(cell_input, "since"), &cell->since) != 0 ||
+      read_output(json_get(input, "output"), cell) != 0 ||
+      read_data(json_get(input, "data"), cell) != 0
+    ) {
+      return MOCK_TX_ERROR_FORMAT;
+    }
+  }
+  for (i = 0; i < json_len(deps); i++) {
+    const json_value *dep = json_at(deps, i);
+    fixture_cell_t *cell = fixture_tx_add_dep(tx);
+    if (
+      read_out_point(json_get(json_get(dep, "cell_dep"), "out_point"), cell) != 0 ||
+      read_output(json_get(dep, "output"), cell) != 0 ||
+      read_data(json_get(dep, "data"), cell) != 0
+    ) {
+      return MOCK_TX_ERROR_FORMAT;
+    }
+  }
+  for (i = 0; i < json_len(headers); i++) {
+    fixture_header_t *header = &tx->headers[tx->header_cnt++];
+    if (read_header(json_at(headers, i), header) != 0) {
+      return MOCK_TX_ERROR_FORMAT;
+    }
+  }
+  for (i = 0; i < json_len(inputs); i++) {
+    if (read_cell_header(json_get(json_at(inputs, i), "header"), tx, &tx->inputs[i]) != 0) {
+      return MOCK_TX_ERROR_FORMAT;
+    }
+  }
+  for (i = 0; i < json_len(deps); i++) {
+    if (read_cell_header(json_get(json_at(deps, i), "header"), tx, &tx->deps[i]) != 0) {
+      return MOCK_TX_ERROR_FORMAT;
+    }
+  }
+  for (i = 0; i < json_len(outputs); i++) {
+    fixture_cell_t *cell = fixture_tx_add_output(tx);
+    if (read_output(json_at(outputs, i), cell) != 0 || read_data(json_at(outputs_data, i), cell) != 0) {
+      return MOCK_TX_ERROR_FORMAT;
+    }
+  }
+  for (i = 0; i < json_len(witnesses); i++) {
+    fixture_cell_t temp;
+    memset(&temp, 0, sizeof(temp));
+    if (read_data(json_at(witnesses, i), &temp) != 0) {
+      return MOCK_TX_ERROR_FORMAT;
+    }
+    fixture_tx_set_witness(tx, i, temp.data, temp.data_len);
+    free(temp.data);
+  }
+  return 0;
+}
+
+int mock_tx_load(const char *path, fixture_tx_t *tx) {
+  json_value *root = json_parse_file(path);
+  if (root == NULL) {
+    return MOCK_TX_ERROR_FORMAT;
+  }
+  fixture_tx_init(tx);
+  int ret = load(root, tx);
+  json_free(root);
+  return ret;
+}
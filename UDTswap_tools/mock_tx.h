@@ -0,0 +1,11 @@
+#ifndef UDTSWAP_MOCK_TX_H_
+#define UDTSWAP_MOCK_TX_H_
+
+#include "fixture.h"
+
+#define MOCK_TX_ERROR_FORMAT -4
+
+/* load ckb-debugger mock transaction json written by fixture_write_json or ckb-cli */
+int mock_tx_load(const char *path, fixture_tx_t *tx);
+
+#endif /* UDTSWAP_MOCK_TX_H_ */
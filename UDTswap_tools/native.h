@@ -0,0 +1,33 @@
+#ifndef UDTSWAP_NATIVE_H_
+#define UDTSWAP_NATIVE_H_
+
+#include "ckb_mock.h"
+#include "fixture.h"
+#include "native_entry.h"
+
+/*
+ * entry of UDTswap script, NULL for other scripts
+ */
+static inline ckb_mock_entry native_entry(int script) {
+  switch (script) {
+    case FIXTURE_SCRIPT_TYPE:
+      return udtswap_type_main;
+    case FIXTURE_SCRIPT_LOCK:
+      return udtswap_lock_main;
+    case FIXTURE_SCRIPT_LIQUIDITY:
+      return udtswap_liquidity_main;
+  }
+  return NULL;
+}
+
+/*
+ * entry of UDTswap script in context, unified script runs every role
+ */
+static inline ckb_mock_entry native_context_entry(const fixture_context_t *ctx, int script) {
+  if (ctx->unified && script >= 0) {
+    return udtswap_unified_main;
+  }
+  return native_entry(script);
+}
+
+#endif /* UDTSWAP_NATIVE_H_ */
@@ -0,0 +1,15 @@
+#ifndef UDTSWAP_NATIVE_ENTRY_H_
+#define UDTSWAP_NATIVE_ENTRY_H_
+
+/*
+ * main of scripts in host native build, each script is compiled with -Dmain=<entry>
+ * other symbols of scripts are hidden, so scripts and bn can be linked together
+ * udtswap_reference_main is type script of DIFF_REF, only linked in diff_test
+ */
+__attribute__((visibility("default"))) int udtswap_type_main(int argc, char* argv[]);
+__attribute__((visibility("default"))) int udtswap_lock_main(int argc, char* argv[]);
+__attribute__((visibility("default"))) int udtswap_liquidity_main(int argc, char* argv[]);
+__attribute__((visibility("default"))) int udtswap_unified_main(int argc, char* argv[]);
+__attribute__((visibility("default"))) int udtswap_reference_main(int argc, char* argv[]);
+
+#endif /* UDTSWAP_NATIVE_ENTRY_H_ */
@@ -0,0 +1,160 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../UDTswap_scripts/ckb_consts.h"
+#include "mock_tx.h"
+#include "native.h"
+
+#define NATIVE_UNIFIED_NAME "unified"
+
+static void usage(void) {
+  fprintf(stderr,
+    "usage: udtswap_native --tx-file <file> --script-group-type <lock|type> --cell-type <input|output> --cell-index <index> [--repeat <count>] [--trace <file>]\n"
+    "       udtswap_native --replay <trace file> [--repeat <count>]\n"
+    "  --trace <file>  write every syscall of first run to file\n"
+    "  --replay <file> run script group of trace with recorded syscalls, tx is not needed\n");
+}
+
+static double now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static int script_by_name(const char *name) {
+  int script;
+  for (script = FIXTURE_SCRIPT_TYPE; script <= FIXTURE_SCRIPT_LIQUIDITY; script++) {
+    if (strcmp(fixture_script_name(script), name) == 0) {
+      return script;
+    }
+  }
+  return -1;
+}
+
+/*
+ * replay of trace, same result and syscalls as the traced run
+ */
+static int replay(const char *trace_file, long repeat) {
+  trace_t trace;
+  long i;
+  int ret = trace_load(trace_file, &trace);
+  if (ret != 0) {
+    fprintf(stderr, "cannot load %s: %d\n", trace_file, ret);
+    return 1;
+  }
+  ckb_mock_entry entry = strcmp(trace.script, NATIVE_UNIFIED_NAME) == 0 ? udtswap_unified_main : native_entry(script_by_name(trace.script));
+  if (entry == NULL) {
+    fprintf(stderr, "script of trace is not UDTswap script compiled in native build\n");
+    trace_free(&trace);
+    return 1;
+  }
+  ckb_mock_init_replay(&trace);
+
+  double start = now_ns();
+  for (i = 0; i < repeat; i++) {
+    ret = ckb_mock_run(entry);
+  }
+  double elapsed = now_ns() - start;
+
+  printf("Run result: %d\n", ret);
+  printf("Syscalls: %llu of %zu\n", (unsigned long long)ckb_mock_syscall_count(), trace.record_cnt);
+  if (repeat > 1) {
+    printf("Runs: %ld, %.0f ns/run\n", repeat, elapsed / repeat);
+  }
+  trace_free(&trace);
+  return ret == 0 ? 0 : 1;
+}
+
+int main(int argc, char *argv[]) {
+  const char *tx_file = NULL, *trace_file = NULL, *replay_file = NULL;
+  int group_type = -1;
+  size_t source = 0, index = 0;
+  long repeat = 1, i;
+  int ret;
+
+  for (i = 1; i + 1 < argc; i += 2) {
+    if (strcmp(argv[i], "--tx-file") == 0) {
+      tx_file = argv[i + 1];
+    } else if (strcmp(argv[i], "--script-group-type") == 0) {
+      group_type = strcmp(argv[i + 1], "lock") == 0 ? CKB_MOCK_GROUP_LOCK : strcmp(argv[i + 1], "type") == 0 ? CKB_MOCK_GROUP_TYPE : -1;
+    } else if (strcmp(argv[i], "--cell-type") == 0) {
+      source = strcmp(argv[i + 1], "input") == 0 ? CKB_SOURCE_INPUT : strcmp(argv[i + 1], "output") == 0 ? CKB_SOURCE_OUTPUT : 0;
+    } else if (strcmp(argv[i], "--cell-index") == 0) {
+      index = (size_t)strtoul(argv[i + 1], NULL, 10);
+    } else if (strcmp(argv[i], "--repeat") == 0) {
+      repeat = atol(argv[i + 1]);
+    } else if (strcmp(argv[i], "--trace") == 0) {
+      trace_file = argv[i + 1];
+    } else if (strcmp(argv[i], "--replay") == 0) {
+      replay_file = argv[i + 1];
+    } else {
+      usage();
+      return 1;
+    }
+  }
+  if (i == argc && replay_file != NULL && repeat >= 1) {
+    return replay(replay_file, repeat);
+  }
+  if (i != argc || tx_file == NULL || group_type < 0 || source == 0 || repeat < 1) {
+    usage();
+    return 1;
+  }
+
+  fixture_context_t ctx;
+  fixture_context_init(&ctx);
+  fixture_tx_t *tx = malloc(sizeof(fixture_tx_t));
+  if (tx == NULL) {
+    return 1;
+  }
+  ret = mock_tx_load(tx_file, tx);
+  if (ret != 0) {
+    fprintf(stderr, "cannot load %s: %d\n", tx_file, ret);
+    return 1;
+  }
+  ret = ckb_mock_init(tx, group_type, source, index);
+  if (ret != 0) {
+    fprintf(stderr, "no script group of cell: %d\n", ret);
+    return 1;
+  }
+  if (fixture_script_of(&ctx, ckb_mock_script()) < 0) {
+    fixture_context_unify(&ctx);
+  }
+  //code cell dep of unified script
+  ckb_mock_entry entry = native_context_entry(&ctx, fixture_script_of(&ctx, ckb_mock_script()));
+  if (entry == NULL) {
+    fprintf(stderr, "script of cell is not UDTswap script compiled in native build\n");
+    return 1;
+  }
+
+  FILE *trace_fp = NULL;
+  if (trace_file != NULL) {
+    trace_fp = fopen(trace_file, "w");
+    if (trace_fp == NULL) {
+      fprintf(stderr, "cannot open %s\n", trace_file);
+      return 1;
+    }
+    const char *name = ctx.unified ? NATIVE_UNIFIED_NAME : fixture_script_name(fixture_script_of(&ctx, ckb_mock_script()));
+    trace_write_header(trace_fp, name, group_type, source, index);
+    ckb_mock_trace(trace_fp);
+  }
+
+  double start = now_ns();
+  for (i = 0; i < repeat; i++) {
+    ret = ckb_mock_run(entry);
+    ckb_mock_trace(NULL);
+  }
+  double elapsed = now_ns() - start;
+  if (trace_fp != NULL) {
+    fclose(trace_fp);
+  }
+
+  printf("Run result: %d\n", ret);
+  printf("Syscalls: %llu\n", (unsigned long long)ckb_mock_syscall_count());
+  if (repeat > 1) {
+    printf("Runs: %ld, %.0f ns/run\n", repeat, elapsed / repeat);
+  }
+  fixture_tx_free(tx);
+  free(tx);
+  return ret == 0 ? 0 : 1;
+}
@@ -0,0 +1,1895 @@
+#include <dirent.h>
+#include <elf.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include "../UDTswap_scripts/ckb_consts.h"
+#include "native.h"
+#include "sim_verify.h"
+#include "../UDTswap_scripts/udtswap_common.h"
+#include "../UDTswap_scripts/bn.h"
+#include "../UDTswap_scripts/udtswap_formula.h"
+#include "quote/udtswap_quote.h"
+#include "quote/udtswap_route.h"
+#include "quote/udtswap_snapshot.h"
+#include "quote/udtswap_ingest.h"
+#include "quote/udtswap_history.h"
+#include "quote/udtswap_tx.h"
+#include "quote/udtswap_sign.h"
+#include "blake2b.h"
+
+#define NATIVE_TEST_THROUGHPUT_RUNS 10000
+#define NATIVE_TEST_QUOTE_RUNS 200
+#define NATIVE_TEST_QUOTE_BATCH 4096
+#define NATIVE_TEST_ROUTE_UDTS 6
+#define NATIVE_TEST_ROUTE_POOLS 40
+#define NATIVE_TEST_ROUTE_RUNS 200
+#define NATIVE_TEST_SHARD_POOLS 8
+#define NATIVE_TEST_SHARD_KEYS 64
+#define NATIVE_TEST_SNAPSHOT_POOLS 300
+#define NATIVE_TEST_SNAPSHOT_PATH "build/native/snapshot_test.bin"
+#define NATIVE_TEST_INGEST_BLOCKS 200
+#define NATIVE_TEST_INGEST_TXS 8
+#define NATIVE_TEST_INGEST_POOLS 6
+#define NATIVE_TEST_INGEST_SIZE (8 << 20)
+#define NATIVE_TEST_INGEST_PATH "build/native/ingest_test.bin"
+#define NATIVE_TEST_HISTORY_ROWS 10000
+#define NATIVE_TEST_HISTORY_MORE_ROWS 3000
+#define NATIVE_TEST_HISTORY_POOLS 24
+#define NATIVE_TEST_HISTORY_PATH "build/native/history_test.bin"
+#define NATIVE_TEST_TX_ARENA_SIZE (64 << 10)
+#define NATIVE_TEST_SIGN_TXS 64
+#define NATIVE_TEST_SIGN_ARENA_SIZE 1024
+#define NATIVE_TEST_SIGN_THREADS 4
+
+static int failed = 0;
+static int passed = 0;
+static uint64_t rng_state = 1;
+
+static int run_group(const fixture_context_t *ctx, const fixture_tx_t *tx, const fixture_group_t *group) {
+  int ret = ckb_mock_init(tx, group->group_type, group->is_output ? CKB_SOURCE_OUTPUT : CKB_SOURCE_INPUT, group->index);
+  if (ret != 0) {
+    return ret;
+  }
+  if (fixture_script_of(ctx, ckb_mock_script()) != group->script) {
+    return CKB_MOCK_ERROR_NO_SCRIPT;
+  }
+  return ckb_mock_run(native_context_entry(ctx, group->script));
+}
+
+static void expect(const char *name, int ret, int expected) {
+  if (ret == expected) {
+    passed += 1;
+    return;
+  }
+  failed += 1;
+  printf("FAIL %s: expected %d, got %d\n", name, expected, ret);
+}
+
+static fixture_tx_t *new_tx(void) {
+  fixture_tx_t *tx = malloc(sizeof(fixture_tx_t));
+  if (tx == NULL) {
+    exit(1);
+  }
+  fixture_tx_init(tx);
+  return tx;
+}
+
+static void free_tx(fixture_tx_t *tx) {
+  fixture_tx_free(tx);
+  free(tx);
+}
+
+static uint64_t next_random(void) {
+  rng_state ^= rng_state >> 12;
+  rng_state ^= rng_state << 25;
+  rng_state ^= rng_state >> 27;
+  return rng_state * 0x2545f4914f6cdd1dULL;
+}
+
+static void add_u128(uint8_t *p, int64_t delta) {
+  fixture_u128 v = 0;
+  int i;
+  for (i = 0; i < 16; i++) {
+    v |= (fixture_u128)p[i] << (8 * i);
+  }
+  v += delta;
+  for (i = 0; i < 16; i++) {
+    p[i] = (v >> (8 * i)) & 0xff;
+  }
+}
+
+/*
+ * every script group of every benchmark shape should pass
+ */
+static void test_shapes(const fixture_context_t *ctx) {
+  static const size_t pool_cnts[] = {1, 3, FIXTURE_MAX_POOLS};
+  fixture_group_t groups[FIXTURE_MAX_POOLS + 2];
+  char name[128];
+  int shape, kind, extended, direction;
+  size_t p, g;
+
+  for (shape = FIXTURE_SHAPE_CREATE; shape <= FIXTURE_SHAPE_SWAP; shape++) {
+    for (kind = FIXTURE_PAIR_CKB_UDT; kind <= FIXTURE_PAIR_UDT_UDT; kind++) {
+      for (extended = 0; extended <= 1; extended++) {
+        for (direction = FIXTURE_SWAP_UDT1_INPUT; direction <= FIXTURE_SWAP_UDT2_INPUT; direction++) {
+          for (p = 0; p < sizeof(pool_cnts) / sizeof(pool_cnts[0]); p++) {
+            if (shape != FIXTURE_SHAPE_SWAP && (direction != FIXTURE_SWAP_UDT1_INPUT || p != 0)) {
+              continue;
+            }
+            fixture_tx_t *tx = new_tx();
+            int ret = fixture_bench_tx(tx, ctx, shape, kind, pool_cnts[p], extended, direction);
+            size_t cnt = fixture_shape_groups(shape, pool_cnts[p], groups);
+            for (g = 0; g < cnt; g++) {
+              snprintf(
+                name, sizeof(name), "%sshape %d kind %d extended %d direction %d pools %zu %s %zu",
+                ctx->unified ? "unified " : "", shape, kind, extended, direction, pool_cnts[p],
+                fixture_script_name(groups[g].script), groups[g].index
+              );
+              expect(name, ret == 0 ? run_group(ctx, tx, &groups[g]) : ret, 0);
+            }
+            free_tx(tx);
+          }
+        }
+      }
+    }
+  }
+}
+
+static int run_swap_tampered(const fixture_context_t *ctx, int kind, int extended, void (*tamper)(fixture_tx_t *)) {
+  fixture_group_t group = {FIXTURE_SCRIPT_TYPE, FIXTURE_GROUP_TYPE, 0, 0};
+  fixture_tx_t *tx = new_tx();
+  int ret = fixture_bench_tx(tx, ctx, FIXTURE_SHAPE_SWAP, kind, 1, extended, FIXTURE_SWAP_UDT1_INPUT);
+  if (ret == 0) {
+    tamper(tx);
+    ret = run_group(ctx, tx, &group);
+  }
+  free_tx(tx);
+  return ret;
+}
+
+static void tamper_swap_output(fixture_tx_t *tx) {
+  add_u128(tx->outputs[0].data + 16, -1);
+  add_u128(tx->outputs[2].data, -1);
+}
+
+static void tamper_udt_amount(fixture_tx_t *tx) {
+  add_u128(tx->outputs[1].data, 1);
+}
+
+static void tamper_ckb_amount(fixture_tx_t *tx) {
+  tx->outputs[1].capacity += 1;
+}
+
+static void tamper_reserve_and_lock(fixture_tx_t *tx) {
+  memset(tx->outputs[0].data, 0, UDT_AMOUNT_SIZE);
+  tx->outputs[0].data[0] = UDT_RESERVE_DEFAULT;
+  memcpy(tx->outputs[1].data, tx->outputs[0].data, UDT_AMOUNT_SIZE);
+  tx->outputs[2].lock.args[0] ^= 1;
+}
+//output udt1 reserve is empty pool reserve and udt2 cell lock is changed
+
+static void tamper_fee(fixture_tx_t *tx) {
+  tx->outputs[3].capacity -= 1;
+}
+
+static void tamper_last_update(fixture_tx_t *tx) {
+  tx->outputs[0].data[112] -= 1;
+}
+
+static void tamper_price_cumulative(fixture_tx_t *tx) {
+  tx->outputs[0].data[48] ^= 1;
+}
+
+static void tamper_input_same_block(fixture_tx_t *tx) {
+  fixture_cell_set_header(tx, &tx->inputs[0], tx->headers[0].number);
+}
+
+static void tamper_input_after_header(fixture_tx_t *tx) {
+  fixture_cell_set_header(tx, &tx->inputs[0], tx->headers[0].number + 1);
+}
+//first header dep is stale, output is same as with that header dep
+
+static void tamper_input_no_block(fixture_tx_t *tx) {
+  tx->inputs[0].has_header = 0;
+}
+
+static void tamper_backdated_header(fixture_tx_t *tx) {
+  uint64_t last_update;
+  memcpy(&last_update, tx->inputs[0].data + 112, sizeof(last_update));
+  last_update -= 1;
+  tx->headers[0] = *fixture_tx_add_header(tx, last_update);
+  tx->header_cnt -= 1;
+  memcpy(tx->outputs[0].data + 112, &last_update, sizeof(last_update));
+}
+//first header dep is before last update of input
+
+/*
+ * pool cell changes rejected by type script
+ */
+static void test_rejects(const fixture_context_t *ctx) {
+  expect("swap output above formula", run_swap_tampered(ctx, FIXTURE_PAIR_UDT_UDT, 0, tamper_swap_output), SWAP_NOT_CORRECT_ERROR);
+  expect("swap fee capacity", run_swap_tampered(ctx, FIXTURE_PAIR_UDT_UDT, 0, tamper_fee), STATE_USE_FEE_NOT_CORRECT_ERROR);
+  expect("swap last update", run_swap_tampered(ctx, FIXTURE_PAIR_UDT_UDT, 1, tamper_last_update), LAST_UPDATE_NOT_CORRECT_ERROR);
+  expect("swap price cumulative", run_swap_tampered(ctx, FIXTURE_PAIR_UDT_UDT, 1, tamper_price_cumulative), PRICE_CUMULATIVE_NOT_CORRECT_ERROR);
+  expect("swap input of header dep block", run_swap_tampered(ctx, FIXTURE_PAIR_UDT_UDT, 1, tamper_input_same_block), 0);
+  expect("swap stale header dep", run_swap_tampered(ctx, FIXTURE_PAIR_UDT_UDT, 1, tamper_input_after_header), LAST_UPDATE_NOT_CORRECT_ERROR);
+  expect("swap backdated header dep", run_swap_tampered(ctx, FIXTURE_PAIR_UDT_UDT, 1, tamper_backdated_header), LAST_UPDATE_NOT_CORRECT_ERROR);
+  expect("swap input without block", run_swap_tampered(ctx, FIXTURE_PAIR_UDT_UDT, 1, tamper_input_no_block), UDTSWAP_SYSCALL_ERROR - ITEM_MISSING_ERROR);
+  expect("swap udt lock amount", run_swap_tampered(ctx, FIXTURE_PAIR_UDT_UDT, 0, tamper_udt_amount), UDTSWAP_TYPE_UDTSWAP_UDT_LOCK_AMOUNT_NOT_MATCH_ERROR);
+  expect("swap ckb lock capacity", run_swap_tampered(ctx, FIXTURE_PAIR_CKB_UDT, 0, tamper_ckb_amount), UDTSWAP_TYPE_UDTSWAP_UDT_LOCK_AMOUNT_NOT_MATCH_ERROR);
+  expect("swap reserve checked before lock", run_swap_tampered(ctx, FIXTURE_PAIR_UDT_UDT, 0, tamper_reserve_and_lock), RESERVE_BELOW_MINIMUM_ERROR);
+}
+
+/*
+ * extended pool creation with first header dep before block of first input is rejected
+ */
+static void test_create_stale_header(const fixture_context_t *ctx) {
+  fixture_group_t group;
+  fixture_shape_groups(FIXTURE_SHAPE_CREATE, 1, &group);
+  fixture_tx_t *tx = new_tx();
+  int ret = fixture_bench_tx(tx, ctx, FIXTURE_SHAPE_CREATE, FIXTURE_PAIR_UDT_UDT, 1, 1, FIXTURE_SWAP_UDT1_INPUT);
+  expect("create extended", ret == 0 ? run_group(ctx, tx, &group) : ret, 0);
+  if (ret == 0) {
+    tamper_input_after_header(tx);
+    expect("create stale header dep", run_group(ctx, tx, &group), NOT_ENOUGH_GROUP_CELL_ERROR);
+  }
+  //rejected creation is checked as transition, which has no group input
+  free_tx(tx);
+}
+
+/*
+ * UDT cell data longer than amount, only first 16 bytes are amount
+ */
+static void test_create_long_udt_data(const fixture_context_t *ctx) {
+  fixture_group_t group = {FIXTURE_SCRIPT_TYPE, FIXTURE_GROUP_TYPE, 1, 0};
+  uint8_t data[UDTSWAP_EXTENDED_DATA_SIZE + 16];
+  fixture_tx_t *tx = new_tx();
+  int ret = fixture_create(tx, ctx, FIXTURE_PAIR_UDT_UDT, 0);
+  if (ret == 0) {
+    memset(data, 0xff, sizeof(data));
+    memcpy(data, tx->outputs[1].data, UDT_AMOUNT_SIZE);
+    fixture_cell_set_data(&tx->outputs[1], data, sizeof(data));
+    ret = run_group(ctx, tx, &group);
+  }
+  expect("create with long UDT data", ret, 0);
+  free_tx(tx);
+}
+
+/*
+ * traced run is replayed with same result and syscalls, replay by another script diverges
+ */
+static void test_trace_replay(const fixture_context_t *ctx) {
+  char path[] = "/tmp/udtswap_trace_XXXXXX";
+  uint64_t syscall_cnt = 0;
+  trace_t trace;
+  int fd = mkstemp(path);
+  FILE *fp = fd < 0 ? NULL : fdopen(fd, "w");
+  fixture_tx_t *tx = new_tx();
+  int ret = fixture_bench_tx(tx, ctx, FIXTURE_SHAPE_SWAP, FIXTURE_PAIR_CKB_UDT, 2, 1, FIXTURE_SWAP_UDT1_INPUT);
+  if (ret == 0 && fp != NULL) {
+    ckb_mock_init(tx, FIXTURE_GROUP_TYPE, CKB_SOURCE_INPUT, 0);
+    trace_write_header(fp, fixture_script_name(FIXTURE_SCRIPT_TYPE), FIXTURE_GROUP_TYPE, CKB_SOURCE_INPUT, 0);
+    ckb_mock_trace(fp);
+    ret = ckb_mock_run(native_entry(FIXTURE_SCRIPT_TYPE));
+    syscall_cnt = ckb_mock_syscall_count();
+    ckb_mock_trace(NULL);
+  }
+  if (fp != NULL) {
+    fclose(fp);
+  }
+  free_tx(tx);
+  expect("trace swap", fp != NULL ? ret : -1, 0);
+
+  ret = trace_load(path, &trace);
+  expect("trace load", ret, 0);
+  if (ret == 0) {
+    ckb_mock_init_replay(&trace);
+    expect("replay swap", ckb_mock_run(native_entry(FIXTURE_SCRIPT_TYPE)), 0);
+    expect("replay syscalls", ckb_mock_syscall_count() == syscall_cnt && syscall_cnt == trace.record_cnt, 1);
+    ckb_mock_init_replay(&trace);
+    expect("replay by lock script", ckb_mock_run(native_entry(FIXTURE_SCRIPT_LOCK)), CKB_MOCK_ERROR_REPLAY);
+    trace_free(&trace);
+  }
+  remove(path);
+}
+
+/*
+ * unified script runs every role with one code cell dep, same results as separate scripts
+ * script size of no role is rejected
+ */
+static void test_unified(const fixture_context_t *ctx) {
+  fixture_context_t unified = *ctx;
+  fixture_context_unify(&unified);
+  test_shapes(&unified);
+  test_rejects(&unified);
+
+  fixture_tx_t *tx = new_tx();
+  int ret = fixture_bench_tx(tx, &unified, FIXTURE_SHAPE_SWAP, FIXTURE_PAIR_UDT_UDT, 1, 0, FIXTURE_SWAP_UDT1_INPUT);
+  if (ret == 0) {
+    tx->inputs[0].type.args_len += 1;
+    ret = ckb_mock_init(tx, FIXTURE_GROUP_TYPE, CKB_SOURCE_INPUT, 0);
+  }
+  expect("unified script of no role", ret == 0 ? ckb_mock_run(udtswap_unified_main) : ret, UDTSWAP_ROLE_NOT_MATCH_ERROR);
+  free_tx(tx);
+}
+
+/*
+ * quotes of random pools are accepted by type script, one less input of exact output is checked by both formulas
+ * add and remove quotes are same as fixture amounts
+ */
+static int run_type(const fixture_context_t *ctx, const fixture_tx_t *tx) {
+  fixture_group_t group = {FIXTURE_SCRIPT_TYPE, FIXTURE_GROUP_TYPE, 0, 0};
+  return run_group(ctx, tx, &group);
+}
+
+static void random_pool(fixture_pool_t *pool, const fixture_context_t *ctx) {
+  fixture_bench_pool(pool, ctx, (int)(next_random() % 2), 0, 0);
+  pool->udt1_reserve = 1000000 + next_random() % 1000000000000000ULL;
+  pool->udt2_reserve = 1000000 + next_random() % 1000000000000000ULL;
+  pool->total_liquidity = 1000000 + next_random() % 1000000000000000ULL;
+}
+
+static void test_quote_swap(const fixture_context_t *ctx, const fixture_pool_t *pool) {
+  fixture_context_t exact_output = *ctx;
+  fixture_u128 input_amount = 1 + next_random() % (uint64_t)(pool->udt1_reserve / 10), output_amount, quoted;
+  int direction = FIXTURE_SWAP_UDT1_INPUT;
+
+  expect("quote exact input", udtswap_quote_exact_input(pool->udt1_reserve, pool->udt2_reserve, input_amount, &quoted), 0);
+  output_amount = fixture_swap_output(pool->udt1_reserve, pool->udt2_reserve, input_amount);
+  expect("quote exact input amount", quoted == output_amount, 1);
+  fixture_tx_t *tx = new_tx();
+  int ret = fixture_swap(tx, ctx, pool, 1, &input_amount, &direction);
+  expect("quote exact input swap", ret == 0 ? run_type(ctx, tx) : ret, 0);
+  free_tx(tx);
+
+  expect("quote exact output", udtswap_quote_exact_output(pool->udt1_reserve, pool->udt2_reserve, output_amount, &quoted), 0);
+  expect("quote exact output amount", quoted <= input_amount, 1);
+  exact_output.swap_mode = SWAP_MODE_EXACT_OUTPUT;
+  tx = new_tx();
+  ret = fixture_swap(tx, &exact_output, pool, 1, &quoted, &direction);
+  if (ret == 0 && pool->kind == FIXTURE_PAIR_UDT_UDT) {
+    int64_t delta = (int64_t)(fixture_swap_output(pool->udt1_reserve, pool->udt2_reserve, quoted) - output_amount);
+    add_u128(tx->outputs[0].data + 16, delta);
+    add_u128(tx->outputs[2].data, delta);
+    expect("quote exact output swap", run_type(&exact_output, tx), 0);
+    add_u128(tx->outputs[0].data, -1);
+    add_u128(tx->outputs[1].data, -1);
+    expect(
+      "quote exact output swap one less input",
+      run_type(&exact_output, tx),
+      fixture_swap_output(pool->udt1_reserve, pool->udt2_reserve, quoted - 1) == output_amount ? 0 : SWAP_NOT_CORRECT_ERROR
+    );
+  } else {
+    expect("quote exact output swap", ret, 0);
+  }
+  //output udt cell keeps what is above quoted output amount
+  free_tx(tx);
+}
+
+static void test_quote_liquidity(const fixture_context_t *ctx, const fixture_pool_t *pool) {
+  fixture_u128 udt1_amount = ADD_LIQUIDITY_MINIMUM + next_random() % (uint64_t)(pool->udt1_reserve / 10);
+  fixture_u128 liquidity = 1 + next_random() % (uint64_t)(pool->total_liquidity / 2);
+  fixture_u128 amount1, amount2, quoted1, quoted2;
+
+  expect("quote add liquidity", udtswap_quote_add_liquidity(pool->udt1_reserve, pool->udt2_reserve, pool->total_liquidity, udt1_amount, &quoted1, &quoted2), 0);
+  expect("quote add liquidity fixture", fixture_add_liquidity_amounts(pool, udt1_amount, &amount1, &amount2), 0);
+  expect("quote add liquidity amounts", quoted1 == amount1 && quoted2 == amount2, 1);
+  fixture_tx_t *tx = new_tx();
+  int ret = fixture_add_liquidity(tx, ctx, pool, udt1_amount);
+  expect("quote add liquidity tx", ret == 0 ? run_type(ctx, tx) : ret, 0);
+  free_tx(tx);
+
+  expect("quote remove liquidity", udtswap_quote_remove_liquidity(pool->udt1_reserve, pool->udt2_reserve, pool->total_liquidity, liquidity, &quoted1, &quoted2), 0);
+  fixture_remove_liquidity_amounts(pool, liquidity, &amount1, &amount2);
+  expect("quote remove liquidity amounts", quoted1 == amount1 && quoted2 == amount2, 1);
+  tx = new_tx();
+  ret = fixture_remove_liquidity(tx, ctx, pool, liquidity);
+  expect("quote remove liquidity tx", ret == 0 ? run_type(ctx, tx) : ret, 0);
+  free_tx(tx);
+}
+
+/*
+ * exact output hint of a swap only matching output by input formula is accepted by fallback
+ * input by output formula of 4 output is 4029 input, output by input formula of 5000 input is 4 output
+ */
+static void test_quote_hint_fallback(const fixture_context_t *ctx) {
+  fixture_context_t exact_output = *ctx;
+  fixture_pool_t pool;
+  fixture_u128 input_amount = 5000;
+  int direction = FIXTURE_SWAP_UDT1_INPUT;
+
+  fixture_bench_pool(&pool, ctx, FIXTURE_PAIR_UDT_UDT, 0, 0);
+  pool.udt1_reserve = 1000000;
+  pool.udt2_reserve = 1000;
+  expect("quote hint fallback output", fixture_swap_output(pool.udt1_reserve, pool.udt2_reserve, input_amount) == 4, 1);
+  exact_output.swap_mode = SWAP_MODE_EXACT_OUTPUT;
+  fixture_tx_t *tx = new_tx();
+  int ret = fixture_swap(tx, &exact_output, &pool, 1, &input_amount, &direction);
+  expect("quote hint fallback exact output", ret == 0 ? run_type(&exact_output, tx) : ret, 0);
+  free_tx(tx);
+}
+
+static void test_quote(const fixture_context_t *ctx) {
+  fixture_u128 amount1, amount2;
+  fixture_pool_t pool;
+  int i;
+
+  for (i = 0; i < NATIVE_TEST_QUOTE_RUNS; i++) {
+    random_pool(&pool, ctx);
+    test_quote_swap(ctx, &pool);
+    test_quote_liquidity(ctx, &pool);
+  }
+  test_quote_hint_fallback(ctx);
+  expect("quote exact input empty reserve", udtswap_quote_exact_input(0, 1, 1, &amount1), RESERVE_BELOW_MINIMUM_ERROR);
+  expect("quote exact input zero output", udtswap_quote_exact_input(1000000, 1, 1, &amount1), RESULT_NOT_CORRECT_ERROR);
+  expect("quote exact output whole reserve", udtswap_quote_exact_output(1, 1000, 1000, &amount1), RESERVE_BELOW_MINIMUM_ERROR);
+  expect("quote exact input overflow", udtswap_quote_exact_input(~(fixture_u128)0, 1, 1, &amount1), OVERFLOW_ERROR);
+  expect("quote add liquidity empty pool", udtswap_quote_add_liquidity(1, 1, 0, ADD_LIQUIDITY_MINIMUM, &amount1, &amount2), LIQUIDITY_EMPTY_ERROR);
+  expect("quote add liquidity too low", udtswap_quote_add_liquidity(1, 1, 1, ADD_LIQUIDITY_MINIMUM - 1, &amount1, &amount2), ADD_LIQUIDITY_TOO_LOW_ERROR);
+  expect("quote remove all liquidity", udtswap_quote_remove_liquidity(10, 10, 10, 10, &amount1, &amount2), RESERVE_BELOW_MINIMUM_ERROR);
+  expect("quote remove above total liquidity", udtswap_quote_remove_liquidity(10, 10, 10, 11, &amount1, &amount2), LIQUIDITY_NOT_CORRECT_ERROR);
+}
+
+/*
+ * reserves and amounts of random bit length, uint128_t quotes of short values and bn quotes of long values
+ */
+static fixture_u128 random_bits(void) {
+  int bits = (int)(next_random() % 129);
+  fixture_u128 v = ((fixture_u128)next_random() << 64) | next_random();
+  return bits == 0 ? 0 : v >> (128 - bits);
+}
+
+static int bn_exact_input(fixture_u128 i_r, fixture_u128 o_r, fixture_u128 i_a, fixture_u128 *o_a) {
+  struct bn amount;
+  if (i_r == 0 || o_r == 0) {
+    return RESERVE_BELOW_MINIMUM_ERROR;
+  }
+  if (i_a == 0) {
+    return RESULT_NOT_CORRECT_ERROR;
+  }
+  if (i_r + i_a < i_r) {
+    return OVERFLOW_ERROR;
+  }
+  int ret = udtswap_swap_output_amount(i_r, o_r, i_a, &amount);
+  *o_a = bignum_to_uint128_t(&amount);
+  return ret != CKB_SUCCESS ? ret : *o_a == 0 ? RESULT_NOT_CORRECT_ERROR : CKB_SUCCESS;
+}
+
+static int bn_exact_output(fixture_u128 i_r, fixture_u128 o_r, fixture_u128 o_a, fixture_u128 *i_a) {
+  struct bn amount;
+  int i;
+  if (i_r == 0 || o_r == 0 || o_a >= o_r) {
+    return RESERVE_BELOW_MINIMUM_ERROR;
+  }
+  if (o_a == 0) {
+    return RESULT_NOT_CORRECT_ERROR;
+  }
+  int ret = udtswap_swap_input_amount(i_r, o_r, o_a, &amount);
+  for (i = 4; i < BN_ARRAY_SIZE && ret == CKB_SUCCESS; i++) {
+    ret = amount.array[i] != 0 ? OVERFLOW_ERROR : ret;
+  }
+  *i_a = bignum_to_uint128_t(&amount);
+  return ret != CKB_SUCCESS ? ret : i_r + *i_a < i_r ? OVERFLOW_ERROR : CKB_SUCCESS;
+}
+
+/*
+ * expected batch quote, checks of pool cell and capacity added to quote
+ */
+static int expected_pool_quote(const udtswap_quote_pools_t *pools, size_t i, int direction, int exact_output, fixture_u128 amount, fixture_u128 *ret_amount) {
+  int rev = direction == UDTSWAP_QUOTE_UDT2_INPUT;
+  int kind = pools->kind[i];
+  int is_ckb = rev ? kind >= UDTSWAP_PAIR_UDT_CKB : kind == UDTSWAP_PAIR_CKB_UDT || kind == UDTSWAP_PAIR_CKB_CKB;
+  fixture_u128 i_r = rev ? pools->udt2_reserve[i] : pools->udt1_reserve[i];
+  fixture_u128 o_r = rev ? pools->udt1_reserve[i] : pools->udt2_reserve[i];
+  fixture_u128 limit = is_ckb ? (fixture_u128)(0xffffffffffffffffULL - CKB_RESERVE_DEFAULT) : ~(fixture_u128)0 - UDT_RESERVE_DEFAULT;
+  int ret;
+  *ret_amount = 0;
+  if (i_r == 0 || o_r == 0) {
+    return RESERVE_BELOW_MINIMUM_ERROR;
+  }
+  if (pools->total_liquidity[i] == 0) {
+    return LIQUIDITY_EMPTY_ERROR;
+  }
+  ret = exact_output ? udtswap_quote_exact_output(i_r, o_r, amount, ret_amount) : udtswap_quote_exact_input(i_r, o_r, amount, ret_amount);
+  if (ret == 0 && (i_r > limit || (exact_output ? *ret_amount : amount) > limit - i_r)) {
+    ret = OVERFLOW_ERROR;
+  }
+  if (ret != 0) {
+    *ret_amount = 0;
+  }
+  return ret;
+}
+
+/*
+ * batch quotes of every direction and both pool and amount batches against expected_pool_quote
+ */
+static int quote_batch_same(const udtswap_quote_pools_t *pools, const fixture_u128 amounts[], fixture_u128 results[], int rets[]) {
+  fixture_u128 expected;
+  int direction, exact_output, ret, ok = 1;
+  size_t i;
+  for (direction = UDTSWAP_QUOTE_UDT1_INPUT; direction <= UDTSWAP_QUOTE_UDT2_INPUT; direction++) {
+    for (exact_output = 0; exact_output <= 1; exact_output++) {
+      if (exact_output) {
+        udtswap_quote_exact_output_pools(pools, direction, amounts[0], results, rets);
+      } else {
+        udtswap_quote_exact_input_pools(pools, direction, amounts[0], results, rets);
+      }
+      for (i = 0; i < pools->cnt; i++) {
+        ret = expected_pool_quote(pools, i, direction, exact_output, amounts[0], &expected);
+        ok &= rets[i] == ret && results[i] == expected;
+      }
+      if (exact_output) {
+        udtswap_quote_exact_output_amounts(pools, 1, direction, amounts, pools->cnt, results, rets);
+      } else {
+        udtswap_quote_exact_input_amounts(pools, 1, direction, amounts, pools->cnt, results, rets);
+      }
+      for (i = 0; i < pools->cnt; i++) {
+        ret = expected_pool_quote(pools, 1, direction, exact_output, amounts[i], &expected);
+        ok &= rets[i] == ret && results[i] == expected;
+      }
+    }
+  }
+  return ok;
+}
+
+/*
+ * below 2^64 of random bit length, lanes of batch quotes near the bounds of 64 bits
+ */
+static fixture_u128 random_bits64(void) {
+  int bits = (int)(next_random() % 65);
+  return bits == 0 ? 0 : next_random() >> (64 - bits);
+}
+
+static void test_quote_batch(void) {
+  static fixture_u128 udt1_reserve[NATIVE_TEST_QUOTE_BATCH], udt2_reserve[NATIVE_TEST_QUOTE_BATCH], total_liquidity[NATIVE_TEST_QUOTE_BATCH];
+  static fixture_u128 amounts[NATIVE_TEST_QUOTE_BATCH], results[NATIVE_TEST_QUOTE_BATCH];
+  static uint8_t kind[NATIVE_TEST_QUOTE_BATCH];
+  static int rets[NATIVE_TEST_QUOTE_BATCH];
+  udtswap_quote_pools_t pools = {NATIVE_TEST_QUOTE_BATCH, udt1_reserve, udt2_reserve, total_liquidity, kind};
+  fixture_u128 expected, quoted;
+  int level, ret, scalar_ok = 1, batch_ok = 1, wide_ok = 1;
+  size_t i;
+
+  for (i = 0; i < NATIVE_TEST_QUOTE_BATCH; i++) {
+    fixture_u128 i_r = random_bits(), o_r = random_bits(), amount = random_bits();
+    ret = udtswap_quote_exact_input(i_r, o_r, amount, &quoted);
+    scalar_ok &= ret == bn_exact_input(i_r, o_r, amount, &expected) && (ret != 0 || quoted == expected);
+    ret = udtswap_quote_exact_output(i_r, o_r, amount % (o_r + 1), &quoted);
+    scalar_ok &= ret == bn_exact_output(i_r, o_r, amount % (o_r + 1), &expected) && (ret != 0 || quoted == expected);
+  }
+  expect("quote same as bn formula", scalar_ok, 1);
+
+  for (i = 0; i < NATIVE_TEST_QUOTE_BATCH; i++) {
+    kind[i] = (uint8_t)(next_random() % 4);
+    udt1_reserve[i] = next_random() % 8 == 0 ? random_bits() : 1 + next_random() % 1000000000000000ULL;
+    udt2_reserve[i] = next_random() % 8 == 0 ? random_bits() : 1 + next_random() % 1000000000000000ULL;
+    total_liquidity[i] = next_random() % 16;
+    amounts[i] = next_random() % 8 == 0 ? random_bits() : next_random() % 1000000000000ULL;
+  }
+  for (level = UDTSWAP_QUOTE_SIMD_NONE; level <= UDTSWAP_QUOTE_SIMD_AVX512; level++) {
+    udtswap_quote_simd(level);
+    batch_ok &= quote_batch_same(&pools, amounts, results, rets);
+  }
+  expect("batch quote same as quote", batch_ok, 1);
+
+  //exact output amounts near output reserve of pool 1 give quotients above 2^64
+  for (i = 0; i < NATIVE_TEST_QUOTE_BATCH; i++) {
+    udt1_reserve[i] = random_bits64();
+    udt2_reserve[i] = random_bits64();
+    total_liquidity[i] = 1 + next_random() % 16;
+    amounts[i] = next_random() % 4 == 0 ? udt2_reserve[1] - next_random() % 4 : random_bits64();
+  }
+  for (level = UDTSWAP_QUOTE_SIMD_NONE; level <= UDTSWAP_QUOTE_SIMD_AVX512; level++) {
+    udtswap_quote_simd(level);
+    wide_ok &= quote_batch_same(&pools, amounts, results, rets);
+  }
+  udtswap_quote_simd(UDTSWAP_QUOTE_SIMD_AVX512);
+  expect("batch quote of 64 bit pools same as quote", wide_ok, 1);
+}
+
+/*
+ * graph of random pools, udt 0 is CKB, reserves are below 2^63
+ * routes of 1 and 2 hops without split are same as every path, split routes are exact quotes of distinct pools
+ */
+typedef struct {
+  uint32_t udt1;
+  uint32_t udt2;
+  fixture_u128 udt1_reserve;
+  fixture_u128 udt2_reserve;
+} route_test_pool_t;
+
+static void route_test_udt(uint32_t udt, uint8_t hash[UDTSWAP_ROUTE_HASH_SIZE]) {
+  memset(hash, udt == 0 ? 0 : (int)udt, UDTSWAP_ROUTE_HASH_SIZE);
+}
+
+static void route_test_data(const route_test_pool_t *pool, uint8_t data[UDTSWAP_DATA_SIZE]) {
+  fixture_u128 udt1_default = pool->udt1 == 0 ? CKB_RESERVE_DEFAULT : UDT_RESERVE_DEFAULT;
+  fixture_u128 udt2_default = pool->udt2 == 0 ? CKB_RESERVE_DEFAULT : UDT_RESERVE_DEFAULT;
+  memset(data, 0, UDTSWAP_DATA_SIZE);
+  add_u128(data + UDTSWAP_DATA_UDT1_RESERVE_START, (int64_t)(pool->udt1_reserve + udt1_default));
+  add_u128(data + UDTSWAP_DATA_UDT2_RESERVE_START, (int64_t)(pool->udt2_reserve + udt2_default));
+  data[UDTSWAP_DATA_TOTAL_LIQUIDITY_START] = 1;
+}
+
+static fixture_u128 route_test_quote(const route_test_pool_t *pool, uint32_t from, fixture_u128 amount) {
+  fixture_u128 output;
+  int rev = from == pool->udt2;
+  int ret = udtswap_quote_exact_input(rev ? pool->udt2_reserve : pool->udt1_reserve, rev ? pool->udt1_reserve : pool->udt2_reserve, amount, &output);
+  return ret == 0 ? output : 0;
+}
+
+/*
+ * best output of paths of 1 or 2 hops, one pool of each hop
+ */
+static fixture_u128 route_test_paths(const route_test_pool_t pools[], uint32_t from, uint32_t to, fixture_u128 amount, int max_hops) {
+  fixture_u128 best = 0, output;
+  size_t p, q;
+  for (p = 0; p < NATIVE_TEST_ROUTE_POOLS; p++) {
+    uint32_t mid = pools[p].udt1 == from ? pools[p].udt2 : pools[p].udt2 == from ? pools[p].udt1 : from;
+    if (mid == from || (output = route_test_quote(&pools[p], from, amount)) == 0) {
+      continue;
+    }
+    if (mid == to) {
+      best = output > best ? output : best;
+      continue;
+    }
+    for (q = 0; q < NATIVE_TEST_ROUTE_POOLS && max_hops > 1; q++) {
+      if ((pools[q].udt1 == mid && pools[q].udt2 == to) || (pools[q].udt2 == mid && pools[q].udt1 == to)) {
+        fixture_u128 last = route_test_quote(&pools[q], mid, output);
+        best = last > best ? last : best;
+      }
+    }
+  }
+  return best;
+}
+
+/*
+ * hops chain from input amount, leg outputs are quotes and pools are distinct
+ */
+static int route_test_consistent(const route_test_pool_t pools[], const udtswap_route_t *route, uint32_t from) {
+  uint8_t used[NATIVE_TEST_ROUTE_POOLS] = {0};
+  fixture_u128 amount = route->input_amount;
+  int hop, leg;
+  for (hop = 0; hop < route->hop_cnt; hop++) {
+    fixture_u128 input = 0, output = 0;
+    uint32_t next = from;
+    for (leg = 0; leg < route->leg_cnt[hop]; leg++) {
+      const udtswap_route_leg_t *l = &route->legs[hop][leg];
+      const route_test_pool_t *pool = &pools[l->pool];
+      uint32_t in = l->direction == UDTSWAP_QUOTE_UDT1_INPUT ? pool->udt1 : pool->udt2;
+      if (used[l->pool] || in != from || route_test_quote(pool, in, l->input_amount) != l->output_amount) {
+        return 0;
+      }
+      used[l->pool] = 1;
+      next = l->direction == UDTSWAP_QUOTE_UDT1_INPUT ? pool->udt2 : pool->udt1;
+      input += l->input_amount;
+      output += l->output_amount;
+    }
+    if (input != amount) {
+      return 0;
+    }
+    amount = output;
+    from = next;
+  }
+  return amount == route->output_amount;
+}
+
+/*
+ * split route of one pair is a transaction of same pools accepted by type script
+ */
+static int route_test_split_tx(const fixture_context_t *ctx, const route_test_pool_t pools[], const udtswap_route_t *route) {
+  fixture_pool_t fixture_pools[UDTSWAP_ROUTE_MAX_SPLIT];
+  fixture_u128 amounts[UDTSWAP_ROUTE_MAX_SPLIT];
+  int directions[UDTSWAP_ROUTE_MAX_SPLIT];
+  fixture_group_t group = {FIXTURE_SCRIPT_TYPE, FIXTURE_GROUP_TYPE, 0, 0};
+  int i, ret;
+  for (i = 0; i < route->leg_cnt[0]; i++) {
+    const route_test_pool_t *pool = &pools[route->legs[0][i].pool];
+    fixture_bench_pool(&fixture_pools[i], ctx, FIXTURE_PAIR_UDT_UDT, (uint32_t)i, 0);
+    fixture_pools[i].udt1_reserve = pool->udt1_reserve;
+    fixture_pools[i].udt2_reserve = pool->udt2_reserve;
+    amounts[i] = route->legs[0][i].input_amount;
+    directions[i] = route->legs[0][i].direction;
+  }
+  fixture_tx_t *tx = new_tx();
+  ret = fixture_swap(tx, ctx, fixture_pools, (size_t)route->leg_cnt[0], amounts, directions);
+  for (i = 0; i < route->leg_cnt[0] && ret == 0; i++) {
+    group.index = 3 * (size_t)i;
+    ret = run_group(ctx, tx, &group);
+  }
+  free_tx(tx);
+  return ret;
+}
+
+static void test_route(const fixture_context_t *ctx) {
+  static const udtswap_route_options_t direct = {1, 1, 0}, two_hops = {2, 1, 0}, split = {3, 8, 0}, split_direct = {1, 8, 0};
+  route_test_pool_t pools[NATIVE_TEST_ROUTE_POOLS];
+  uint8_t lock_args[UDTSWAP_ROUTE_LOCK_ARGS_SIZE], data[UDTSWAP_DATA_SIZE], from_hash[32], to_hash[32];
+  udtswap_route_t route, split_route;
+  udtswap_route_graph_t *graph = udtswap_route_graph_new();
+  int direct_ok = 1, two_hops_ok = 1, split_ok = 1, split_more = 0, split_tx_ok = 1, ret;
+  uint32_t id, p, i;
+
+  for (p = 0; p < NATIVE_TEST_ROUTE_POOLS; p++) {
+    pools[p].udt1 = p < 12 ? 1 : (uint32_t)(next_random() % NATIVE_TEST_ROUTE_UDTS);
+    pools[p].udt2 = p < 12 ? 2 : (uint32_t)(next_random() % NATIVE_TEST_ROUTE_UDTS);
+    pools[p].udt1_reserve = 1000000 + next_random() % 1000000000000ULL;
+    pools[p].udt2_reserve = 1000000 + next_random() % 1000000000000ULL;
+    route_test_udt(pools[p].udt1, lock_args);
+    route_test_udt(pools[p].udt2, lock_args + UDTSWAP_ROUTE_HASH_SIZE);
+    route_test_data(&pools[p], data);
+    expect("route add pool", udtswap_route_graph_add_pool(graph, lock_args, data, sizeof(data), &id) == 0 && id == p, 1);
+  }
+  //first pools are parallel pools of udt 1 and udt 2
+
+  for (i = 0; i < NATIVE_TEST_ROUTE_RUNS; i++) {
+    uint32_t from = (uint32_t)(next_random() % NATIVE_TEST_ROUTE_UDTS), to = (uint32_t)(next_random() % NATIVE_TEST_ROUTE_UDTS);
+    fixture_u128 amount = 1 + next_random() % 10000000000ULL;
+    if (i % 4 == 0) {
+      from = 1;
+      to = 2;
+    }
+    if (from == to) {
+      continue;
+    }
+    route_test_udt(from, from_hash);
+    route_test_udt(to, to_hash);
+    ret = udtswap_route_best(graph, from_hash, to_hash, amount, &direct, &route);
+    direct_ok &= (ret == 0 ? route.output_amount : 0) == route_test_paths(pools, from, to, amount, 1);
+    ret = udtswap_route_best(graph, from_hash, to_hash, amount, &two_hops, &route);
+    two_hops_ok &= (ret == 0 ? route.output_amount : 0) == route_test_paths(pools, from, to, amount, 2);
+    if (ret == 0) {
+      two_hops_ok &= route_test_consistent(pools, &route, from);
+    }
+    ret = udtswap_route_best(graph, from_hash, to_hash, amount, &split, &split_route);
+    if (ret == 0) {
+      split_ok &= split_route.output_amount >= route.output_amount && route_test_consistent(pools, &split_route, from);
+      split_more += split_route.output_amount > route.output_amount;
+    }
+    if (i % 4 == 0 && udtswap_route_best(graph, from_hash, to_hash, amount * 1000, &split_direct, &split_route) == 0) {
+      split_ok &= route_test_consistent(pools, &split_route, from);
+      split_tx_ok &= split_route.leg_cnt[0] > 1 && route_test_split_tx(ctx, pools, &split_route) == 0;
+    }
+  }
+  expect("route of 1 hop is best pool", direct_ok, 1);
+  expect("route of 2 hops is best path", two_hops_ok, 1);
+  expect("split route is exact quotes", split_ok, 1);
+  expect("split route has more output", split_more > 0, 1);
+  expect("split route transaction", split_tx_ok, 1);
+
+  route_test_udt(1, from_hash);
+  route_test_udt(2, to_hash);
+  pools[0].udt2_reserve *= 1000;
+  route_test_data(&pools[0], data);
+  udtswap_route_graph_update_pool(graph, 0, data, sizeof(data));
+  ret = udtswap_route_best(graph, from_hash, to_hash, 1000000, &direct, &route);
+  expect("route of updated pool", ret == 0 && route.legs[0][0].pool == 0 && route.output_amount == route_test_quote(&pools[0], 1, 1000000), 1);
+  route_test_udt(NATIVE_TEST_ROUTE_UDTS, to_hash);
+  expect("route to unknown udt", udtswap_route_best(graph, from_hash, to_hash, 1000000, &split, &route), UDTSWAP_ROUTE_ERROR_NO_ROUTE);
+  udtswap_route_graph_free(graph);
+}
+
+/*
+ * shard pools of one pair, reserves within 0.1%
+ * large orders are the split of best route, small orders spread over shards within tolerance
+ */
+static void test_route_shard(const fixture_context_t *ctx) {
+  static const udtswap_route_options_t split = {1, UDTSWAP_ROUTE_MAX_SPLIT, 0};
+  static const udtswap_route_shard_options_t exact = {UDTSWAP_ROUTE_MAX_SPLIT, 0}, spread = {UDTSWAP_ROUTE_MAX_SPLIT, 30};
+  route_test_pool_t pools[NATIVE_TEST_SHARD_POOLS];
+  uint8_t lock_args[UDTSWAP_ROUTE_LOCK_ARGS_SIZE], data[UDTSWAP_DATA_SIZE], from_hash[32], to_hash[32], key[32];
+  uint8_t chosen[NATIVE_TEST_SHARD_POOLS] = {0};
+  udtswap_route_t route, shard_route;
+  udtswap_route_graph_t *graph = udtswap_route_graph_new();
+  int small_ok = 1, same_key_ok = 1, shard_cnt = 0, ret;
+  uint32_t id, p, i;
+
+  for (p = 0; p < NATIVE_TEST_SHARD_POOLS; p++) {
+    pools[p].udt1 = 1;
+    pools[p].udt2 = 2;
+    pools[p].udt1_reserve = 1000000000000ULL + next_random() % 1000000000ULL;
+    pools[p].udt2_reserve = 2000000000000ULL + next_random() % 2000000000ULL;
+    route_test_udt(1, lock_args);
+    route_test_udt(2, lock_args + UDTSWAP_ROUTE_HASH_SIZE);
+    route_test_data(&pools[p], data);
+    udtswap_route_graph_add_pool(graph, lock_args, data, sizeof(data), &id);
+  }
+  route_test_udt(1, from_hash);
+  route_test_udt(2, to_hash);
+
+  udtswap_route_best(graph, from_hash, to_hash, 100000000000ULL, &split, &route);
+  memset(key, 7, sizeof(key));
+  ret = udtswap_route_shard(graph, from_hash, to_hash, 100000000000ULL, key, &spread, &shard_route);
+  expect(
+    "shard route of large order is split",
+    ret == 0 && shard_route.leg_cnt[0] == NATIVE_TEST_SHARD_POOLS && shard_route.output_amount == route.output_amount &&
+      route_test_consistent(pools, &shard_route, 1),
+    1
+  );
+  expect("shard route split transaction", route_test_split_tx(ctx, pools, &shard_route), 0);
+
+  udtswap_route_best(graph, from_hash, to_hash, 1000000, &split, &route);
+  ret = udtswap_route_shard(graph, from_hash, to_hash, 1000000, key, &exact, &shard_route);
+  expect("shard route without tolerance is best", ret == 0 && shard_route.output_amount == route.output_amount, 1);
+  for (i = 0; i < NATIVE_TEST_SHARD_KEYS; i++) {
+    uint32_t pool;
+    memset(key, 0, sizeof(key));
+    memcpy(key, &i, sizeof(i));
+    ret = udtswap_route_shard(graph, from_hash, to_hash, 1000000, key, &spread, &shard_route);
+    small_ok &= ret == 0 && shard_route.leg_cnt[0] == 1 && route_test_consistent(pools, &shard_route, 1) &&
+      shard_route.output_amount >= route.output_amount - route.output_amount * 30 / 10000;
+    pool = shard_route.legs[0][0].pool;
+    shard_cnt += !chosen[pool];
+    chosen[pool] = 1;
+    ret = udtswap_route_shard(graph, from_hash, to_hash, 1000000, key, &spread, &shard_route);
+    same_key_ok &= ret == 0 && shard_route.legs[0][0].pool == pool;
+  }
+  expect("shard route of small order within tolerance", small_ok, 1);
+  expect("shard route of same key", same_key_ok, 1);
+  expect("shard routes spread over shards", shard_cnt >= NATIVE_TEST_SHARD_POOLS / 2, 1);
+  udtswap_route_graph_free(graph);
+}
+
+/*
+ * temporary files of snapshot writes left in its directory
+ */
+static int snapshot_temporary_files(void) {
+  const char *name = strrchr(NATIVE_TEST_SNAPSHOT_PATH, '/') + 1;
+  struct dirent *entry;
+  int cnt = 0;
+  DIR *dir = opendir("build/native");
+  if (dir == NULL) {
+    return -1;
+  }
+  while ((entry = readdir(dir)) != NULL) {
+    if (strncmp(entry->d_name, name, strlen(name)) == 0 && entry->d_name[strlen(name)] == '.') {
+      cnt += 1;
+    }
+  }
+  closedir(dir);
+  return cnt;
+}
+
+/*
+ * snapshot of random pools, records of pairs are found and graph of snapshot routes as graph of pools
+ * truncated, foreign and newer version files are rejected, republished file is stale
+ */
+static void test_snapshot(void) {
+  static const udtswap_route_options_t options = {3, 4, 0};
+  udtswap_snapshot_record_t records[NATIVE_TEST_SNAPSHOT_POOLS];
+  route_test_pool_t pools[NATIVE_TEST_SNAPSHOT_POOLS];
+  uint8_t tip_hash[32], from_hash[32], to_hash[32];
+  udtswap_route_graph_t *graph = udtswap_route_graph_new(), *loaded = udtswap_route_graph_new();
+  udtswap_route_t route, loaded_route;
+  udtswap_snapshot_t snapshot;
+  int found_ok = 1, route_ok = 1;
+  uint32_t p, i, first_pool;
+  size_t first, cnt, r;
+
+  for (p = 0; p < NATIVE_TEST_SNAPSHOT_POOLS; p++) {
+    pools[p].udt1 = (uint32_t)(next_random() % NATIVE_TEST_ROUTE_UDTS);
+    pools[p].udt2 = (uint32_t)(next_random() % NATIVE_TEST_ROUTE_UDTS);
+    pools[p].udt1_reserve = 1000000 + next_random() % 1000000000000ULL;
+    pools[p].udt2_reserve = 1000000 + next_random() % 1000000000000ULL;
+    memset(&records[p], 0, sizeof(records[p]));
+    route_test_udt(pools[p].udt1, records[p].lock_args);
+    route_test_udt(pools[p].udt2, records[p].lock_args + UDTSWAP_ROUTE_HASH_SIZE);
+    memcpy(records[p].type_hash, &p, sizeof(p));
+    memset(records[p].tx_hash, (int)(p % 256), sizeof(records[p].tx_hash));
+    records[p].index[0] = (uint8_t)(p * 3);
+    route_test_data(&pools[p], records[p].data);
+    udtswap_route_graph_add_pool(graph, records[p].lock_args, records[p].data, UDTSWAP_SNAPSHOT_DATA_SIZE, &i);
+  }
+  memset(tip_hash, 0xab, sizeof(tip_hash));
+  expect("snapshot write", udtswap_snapshot_write(NATIVE_TEST_SNAPSHOT_PATH, 1234, tip_hash, records, NATIVE_TEST_SNAPSHOT_POOLS), 0);
+  expect("snapshot open", udtswap_snapshot_open(NATIVE_TEST_SNAPSHOT_PATH, &snapshot), 0);
+  expect(
+    "snapshot header",
+    snapshot.pool_cnt == NATIVE_TEST_SNAPSHOT_POOLS && snapshot.tip_number == 1234 && memcmp(snapshot.tip_hash, tip_hash, 32) == 0,
+    1
+  );
+
+  for (p = 0; p < NATIVE_TEST_SNAPSHOT_POOLS; p++) {
+    int hit = 0;
+    uint8_t lock_args[UDTSWAP_ROUTE_LOCK_ARGS_SIZE], data[UDTSWAP_DATA_SIZE];
+    route_test_data(&pools[p], data);
+    route_test_udt(pools[p].udt1, lock_args);
+    route_test_udt(pools[p].udt2, lock_args + UDTSWAP_ROUTE_HASH_SIZE);
+    cnt = udtswap_snapshot_find_pair(&snapshot, lock_args, &first);
+    for (r = first; r < first + cnt; r++) {
+      const udtswap_snapshot_record_t *record = udtswap_snapshot_record(&snapshot, r);
+      found_ok &= memcmp(record->lock_args, lock_args, sizeof(lock_args)) == 0;
+      if (memcmp(record->type_hash, &p, sizeof(p)) == 0) {
+        hit = udtswap_snapshot_index(record) == (uint8_t)(p * 3) && record->tx_hash[0] == p % 256 &&
+          memcmp(record->data, data, sizeof(data)) == 0;
+      }
+    }
+    found_ok &= hit;
+  }
+  expect("snapshot pools of pair", found_ok, 1);
+
+  expect("snapshot pools to graph", udtswap_snapshot_add_pools(&snapshot, loaded, &first_pool) == 0 && first_pool == 0, 1);
+  for (i = 0; i < NATIVE_TEST_ROUTE_RUNS; i++) {
+    uint32_t from = (uint32_t)(next_random() % NATIVE_TEST_ROUTE_UDTS), to = (uint32_t)(next_random() % NATIVE_TEST_ROUTE_UDTS);
+    fixture_u128 amount = 1 + next_random() % 10000000000ULL;
+    route_test_udt(from, from_hash);
+    route_test_udt(to, to_hash);
+    int ret = udtswap_route_best(graph, from_hash, to_hash, amount, &options, &route);
+    int loaded_ret = udtswap_route_best(loaded, from_hash, to_hash, amount, &options, &loaded_route);
+    route_ok &= ret == loaded_ret && route.output_amount == loaded_route.output_amount;
+  }
+  expect("snapshot graph routes", route_ok, 1);
+
+  expect("snapshot not stale", udtswap_snapshot_stale(&snapshot, NATIVE_TEST_SNAPSHOT_PATH), 0);
+  udtswap_snapshot_write(NATIVE_TEST_SNAPSHOT_PATH, 1235, tip_hash, records, NATIVE_TEST_SNAPSHOT_POOLS - 1);
+  expect("snapshot stale after publish", udtswap_snapshot_stale(&snapshot, NATIVE_TEST_SNAPSHOT_PATH), 1);
+  expect(
+    "snapshot mapping kept after publish",
+    memcmp(udtswap_snapshot_record(&snapshot, NATIVE_TEST_SNAPSHOT_POOLS - 1), &records[NATIVE_TEST_SNAPSHOT_POOLS - 1], UDTSWAP_SNAPSHOT_RECORD_SIZE),
+    0
+  );
+  udtswap_snapshot_close(&snapshot);
+
+  expect("snapshot republished", udtswap_snapshot_open(NATIVE_TEST_SNAPSHOT_PATH, &snapshot) == 0 && snapshot.tip_number == 1235, 1);
+  udtswap_snapshot_close(&snapshot);
+  mkdir(NATIVE_TEST_SNAPSHOT_PATH ".tmp", 0755);
+  expect("snapshot write beside old temporary path", udtswap_snapshot_write(NATIVE_TEST_SNAPSHOT_PATH, 1235, tip_hash, records, 1), 0);
+  rmdir(NATIVE_TEST_SNAPSHOT_PATH ".tmp");
+  expect("snapshot write missing directory", udtswap_snapshot_write("build/native/missing/snapshot.bin", 1, tip_hash, records, 1), UDTSWAP_SNAPSHOT_ERROR_IO);
+  expect("snapshot temporary files removed", snapshot_temporary_files(), 0);
+  FILE *fp = fopen(NATIVE_TEST_SNAPSHOT_PATH, "r+b");
+  if (fp != NULL) {
+    ftruncate(fileno(fp), UDTSWAP_SNAPSHOT_HEADER_SIZE + UDTSWAP_SNAPSHOT_RECORD_SIZE - 1);
+    fclose(fp);
+  }
+  expect("snapshot truncated", udtswap_snapshot_open(NATIVE_TEST_SNAPSHOT_PATH, &snapshot), UDTSWAP_SNAPSHOT_ERROR_FORMAT);
+  udtswap_snapshot_write(NATIVE_TEST_SNAPSHOT_PATH, 1235, tip_hash, records, 1);
+  if ((fp = fopen(NATIVE_TEST_SNAPSHOT_PATH, "r+b")) != NULL) {
+    fseek(fp, 8, SEEK_SET);
+    fputc(UDTSWAP_SNAPSHOT_VERSION + 1, fp);
+    fclose(fp);
+  }
+  expect("snapshot newer version", udtswap_snapshot_open(NATIVE_TEST_SNAPSHOT_PATH, &snapshot), UDTSWAP_SNAPSHOT_ERROR_VERSION);
+  expect("snapshot foreign file", udtswap_snapshot_open("native_test.c", &snapshot), UDTSWAP_SNAPSHOT_ERROR_FORMAT);
+  unlink(NATIVE_TEST_SNAPSHOT_PATH);
+  udtswap_route_graph_free(graph);
+  udtswap_route_graph_free(loaded);
+}
+
+typedef struct {
+  size_t deltas;
+  size_t new_pools;
+  uint64_t last_number;
+  int ordered;
+} ingest_test_apply_t;
+
+static void ingest_test_apply(void *ctx, const udtswap_ingest_delta_t *delta) {
+  ingest_test_apply_t *apply = ctx;
+  apply->ordered &= delta->block_number >= apply->last_number;
+  apply->ordered &= delta->is_new || memcmp(delta->prev_data, delta->data, UDTSWAP_DATA_SIZE) != 0;
+  apply->last_number = delta->block_number;
+  apply->deltas += 1;
+  apply->new_pools += delta->is_new;
+}
+
+static const udtswap_snapshot_record_t *ingest_test_pool(const udtswap_ingest_t *ingest, const uint8_t type_hash[32]) {
+  size_t i;
+  for (i = 0; i < udtswap_ingest_pool_count(ingest); i++) {
+    if (memcmp(udtswap_ingest_pools(ingest)[i].type_hash, type_hash, 32) == 0) {
+      return &udtswap_ingest_pools(ingest)[i];
+    }
+  }
+  return NULL;
+}
+
+/* pools of ingest are pools of chain, data of records are reserves and liquidity of chain pools */
+static int ingest_test_pools(const fixture_context_t *ctx, const fixture_chain_t *chain, const udtswap_ingest_t *ingest) {
+  uint8_t type_hash[32], data[UDTSWAP_DATA_SIZE];
+  size_t p;
+  int i;
+  if (udtswap_ingest_pool_count(ingest) != chain->pool_cnt) {
+    return 0;
+  }
+  for (p = 0; p < chain->pool_cnt; p++) {
+    const fixture_pool_t *pool = &chain->pools[p];
+    fixture_pool_type_hash(ctx, pool, type_hash);
+    const udtswap_snapshot_record_t *record = ingest_test_pool(ingest, type_hash);
+    for (i = 0; i < 16; i++) {
+      data[UDTSWAP_DATA_UDT1_RESERVE_START + i] = (uint8_t)((pool->udt1_reserve + UDT_RESERVE_DEFAULT) >> (8 * i));
+      data[UDTSWAP_DATA_UDT2_RESERVE_START + i] = (uint8_t)((pool->udt2_reserve + UDT_RESERVE_DEFAULT) >> (8 * i));
+      data[UDTSWAP_DATA_TOTAL_LIQUIDITY_START + i] = (uint8_t)(pool->total_liquidity >> (8 * i));
+    }
+    if (record == NULL || memcmp(record->data, data, sizeof(data)) != 0 || memcmp(record->lock_args + 32, record->lock_args, 32) <= 0) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+static void test_ingest(const fixture_context_t *ctx) {
+  const uint8_t *blocks[NATIVE_TEST_INGEST_BLOCKS];
+  size_t lens[NATIVE_TEST_INGEST_BLOCKS], offset = 0, b;
+  uint8_t *buf = malloc(NATIVE_TEST_INGEST_SIZE), tip_hash[32];
+  uint64_t tip_number = 0;
+  fixture_chain_t chain;
+  ingest_test_apply_t apply = {0, 0, 0, 1};
+  udtswap_ingest_options_t options = {4, 8, ingest_test_apply, &apply};
+  udtswap_ingest_options_t serial = {1, 1, NULL, NULL};
+  udtswap_snapshot_t snapshot;
+  int generated = buf != NULL;
+
+  fixture_chain_init(&chain, ctx, NATIVE_TEST_INGEST_POOLS, 7);
+  for (b = 0; b < NATIVE_TEST_INGEST_BLOCKS && generated; b++) {
+    uint32_t len = fixture_chain_block(&chain, ctx, NATIVE_TEST_INGEST_TXS, buf + offset, NATIVE_TEST_INGEST_SIZE - offset);
+    blocks[b] = buf + offset;
+    lens[b] = len;
+    offset += len;
+    generated = len > 0;
+  }
+  expect("ingest blocks generated", generated, 1);
+  if (!generated) {
+    free(buf);
+    return;
+  }
+
+  udtswap_ingest_t *ingest = udtswap_ingest_new();
+  udtswap_ingest_set_code_hashes(ingest, ctx->type_code_hash, ctx->lock_code_hash);
+  expect("ingest parallel", udtswap_ingest_blocks(ingest, blocks, lens, NATIVE_TEST_INGEST_BLOCKS, &options), 0);
+  expect("ingest pools", ingest_test_pools(ctx, &chain, ingest), 1);
+  expect("ingest deltas in block order", apply.ordered && apply.new_pools == NATIVE_TEST_INGEST_POOLS && apply.deltas > NATIVE_TEST_INGEST_BLOCKS, 1);
+  expect(
+    "ingest tip",
+    udtswap_ingest_tip(ingest, &tip_number, tip_hash) && tip_number == NATIVE_TEST_INGEST_BLOCKS - 1 &&
+      memcmp(tip_hash, chain.tip_hash, 32) == 0 && udtswap_ingest_block_count(ingest) == NATIVE_TEST_INGEST_BLOCKS,
+    1
+  );
+  expect("ingest block not child of tip", udtswap_ingest_blocks(ingest, blocks, lens, 1, &options), UDTSWAP_INGEST_ERROR_CHAIN);
+  expect("ingest write snapshot", udtswap_ingest_write_snapshot(ingest, NATIVE_TEST_SNAPSHOT_PATH), 0);
+  udtswap_ingest_free(ingest);
+
+  ingest = udtswap_ingest_new();
+  udtswap_ingest_set_code_hashes(ingest, ctx->type_code_hash, ctx->lock_code_hash);
+  expect("ingest serial", udtswap_ingest_blocks(ingest, blocks, lens, NATIVE_TEST_INGEST_BLOCKS, &serial), 0);
+  expect("ingest serial pools", ingest_test_pools(ctx, &chain, ingest), 1);
+  udtswap_ingest_free(ingest);
+
+  ingest = udtswap_ingest_new();
+  udtswap_ingest_set_code_hashes(ingest, ctx->type_code_hash, ctx->lock_code_hash);
+  expect("ingest first half", udtswap_ingest_blocks(ingest, blocks, lens, NATIVE_TEST_INGEST_BLOCKS / 2, NULL), 0);
+  expect(
+    "ingest second half",
+    udtswap_ingest_blocks(ingest, blocks + NATIVE_TEST_INGEST_BLOCKS / 2, lens + NATIVE_TEST_INGEST_BLOCKS / 2, NATIVE_TEST_INGEST_BLOCKS / 2, NULL),
+    0
+  );
+  expect("ingest halves pools", ingest_test_pools(ctx, &chain, ingest), 1);
+  udtswap_ingest_free(ingest);
+
+  ingest = udtswap_ingest_new();
+  udtswap_ingest_set_code_hashes(ingest, ctx->type_code_hash, ctx->lock_code_hash);
+  expect("ingest open snapshot", udtswap_snapshot_open(NATIVE_TEST_SNAPSHOT_PATH, &snapshot), 0);
+  expect("ingest load snapshot", udtswap_ingest_load_snapshot(ingest, &snapshot), 0);
+  udtswap_snapshot_close(&snapshot);
+  expect("ingest snapshot pools", ingest_test_pools(ctx, &chain, ingest), 1);
+  expect("ingest after snapshot tip", udtswap_ingest_blocks(ingest, blocks, lens, 1, NULL), UDTSWAP_INGEST_ERROR_CHAIN);
+  udtswap_ingest_free(ingest);
+  unlink(NATIVE_TEST_SNAPSHOT_PATH);
+
+  ingest = udtswap_ingest_new();
+  udtswap_ingest_set_code_hashes(ingest, ctx->type_code_hash, ctx->lock_code_hash);
+  FILE *fp = fopen(NATIVE_TEST_INGEST_PATH, "wb");
+  if (fp != NULL) {
+    fwrite(buf, 1, offset, fp);
+    fclose(fp);
+  }
+  expect("ingest file", udtswap_ingest_file(ingest, NATIVE_TEST_INGEST_PATH, NULL), 0);
+  expect("ingest file pools", ingest_test_pools(ctx, &chain, ingest) && udtswap_ingest_block_count(ingest) == NATIVE_TEST_INGEST_BLOCKS, 1);
+  udtswap_ingest_free(ingest);
+
+  ingest = udtswap_ingest_new();
+  udtswap_ingest_set_code_hashes(ingest, ctx->type_code_hash, ctx->lock_code_hash);
+  if ((fp = fopen(NATIVE_TEST_INGEST_PATH, "wb")) != NULL) {
+    fwrite(buf, 1, offset - 1, fp);
+    fclose(fp);
+  }
+  expect("ingest truncated file", udtswap_ingest_file(ingest, NATIVE_TEST_INGEST_PATH, NULL), UDTSWAP_INGEST_ERROR_FORMAT);
+  unlink(NATIVE_TEST_INGEST_PATH);
+  buf[(uint8_t *)blocks[3] - buf + 4] += 1;
+  expect("ingest malformed block", udtswap_ingest_blocks(ingest, blocks, lens, NATIVE_TEST_INGEST_BLOCKS, &options), UDTSWAP_INGEST_ERROR_FORMAT);
+  expect("ingest blocks before malformed block", udtswap_ingest_block_count(ingest), 3);
+  udtswap_ingest_free(ingest);
+
+  ingest = udtswap_ingest_new();
+  expect("ingest code hashes of deployment", udtswap_ingest_blocks(ingest, blocks, lens, 3, NULL) == 0 && udtswap_ingest_pool_count(ingest) == 0, 1);
+  udtswap_ingest_free(ingest);
+  free(buf);
+}
+
+static void history_test_data(uint8_t data[UDTSWAP_DATA_SIZE], const fixture_u128 values[3]) {
+  int k, i;
+  for (k = 0; k < 3; k++) {
+    for (i = 0; i < 16; i++) {
+      data[16 * k + i] = (uint8_t)(values[k] >> (8 * i));
+    }
+  }
+}
+
+static fixture_u128 history_test_u128(const uint8_t *p) {
+  fixture_u128 v = 0;
+  int i;
+  for (i = 15; i >= 0; i--) {
+    v = (v << 8) | p[i];
+  }
+  return v;
+}
+
+static int history_test_same(const udtswap_history_row_t *a, const udtswap_history_row_t *b) {
+  return a->block_number == b->block_number && a->timestamp == b->timestamp && a->pool == b->pool && a->kind == b->kind &&
+    a->udt1_reserve == b->udt1_reserve && a->udt2_reserve == b->udt2_reserve && a->total_liquidity == b->total_liquidity &&
+    a->udt1_delta == b->udt1_delta && a->udt2_delta == b->udt2_delta && a->liquidity_delta == b->liquidity_delta;
+}
+
+static int history_test_in(const udtswap_history_row_t *row, const udtswap_history_range_t *range) {
+  return (range->pool == UDTSWAP_HISTORY_ALL_POOLS || range->pool == row->pool) &&
+    row->block_number >= range->from_block && row->block_number <= range->to_block &&
+    row->timestamp >= range->from_time && row->timestamp <= range->to_time;
+}
+
+typedef struct {
+  const udtswap_history_row_t *rows;
+  size_t cnt;
+  size_t next;
+  const udtswap_history_range_t *range;
+  int same;
+} history_test_scan_t;
+
+static int history_test_visit(void *ctx, const udtswap_history_row_t *rows, size_t cnt) {
+  history_test_scan_t *scan = ctx;
+  size_t i;
+  for (i = 0; i < cnt; i++) {
+    while (scan->next < scan->cnt && !history_test_in(&scan->rows[scan->next], scan->range)) {
+      scan->next += 1;
+    }
+    if (scan->next == scan->cnt || !history_test_same(&scan->rows[scan->next], &rows[i])) {
+      scan->same = 0;
+      return 1;
+    }
+    scan->next += 1;
+  }
+  return 0;
+}
+
+/* scan of range is rows of range, of rows appended to history */
+static int history_test_scan(udtswap_history_t *history, const udtswap_history_row_t *rows, size_t cnt, const udtswap_history_range_t *range) {
+  history_test_scan_t scan = {rows, cnt, 0, range, 1};
+  int ret = udtswap_history_scan(history, range, history_test_visit, &scan);
+  while (scan.next < cnt && !history_test_in(&rows[scan.next], range)) {
+    scan.next += 1;
+  }
+  return ret == 0 && scan.same && scan.next == cnt;
+}
+
+static int history_test_ranges(udtswap_history_t *history, const udtswap_history_row_t *rows, size_t cnt) {
+  uint64_t last = rows[cnt - 1].block_number;
+  udtswap_history_range_t ranges[] = {
+    {UDTSWAP_HISTORY_ALL_POOLS, 0, UINT64_MAX, 0, UINT64_MAX},
+    {3, 0, UINT64_MAX, 0, UINT64_MAX},
+    {UDTSWAP_HISTORY_ALL_POOLS, last / 3, last / 2, 0, UINT64_MAX},
+    {5, last / 4, last, (last / 3) * 8000, (last / 2) * 8000},
+    {UDTSWAP_HISTORY_ALL_POOLS, last + 1, UINT64_MAX, 0, UINT64_MAX},
+  };
+  size_t i;
+  for (i = 0; i < sizeof(ranges) / sizeof(ranges[0]); i++) {
+    if (!history_test_scan(history, rows, cnt, &ranges[i])) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+/* random transitions of NATIVE_TEST_HISTORY_POOLS pools, rows expected of history */
+static size_t history_test_append(udtswap_history_t *history, udtswap_history_row_t *rows, size_t cnt, fixture_u128 state[][3], uint64_t *block) {
+  uint8_t type_hash[32] = {0}, data[UDTSWAP_DATA_SIZE], prev_data[UDTSWAP_DATA_SIZE];
+  size_t i;
+  for (i = 0; i < cnt; i++) {
+    uint32_t pool = (uint32_t)(next_random() % NATIVE_TEST_HISTORY_POOLS);
+    udtswap_history_row_t *row = &rows[i];
+    fixture_u128 before[3], amount = 1 + next_random() % 1000000000000ULL;
+    int k, kind = state[pool][2] == 0 ? UDTSWAP_HISTORY_CREATE : 1 + (int)(next_random() % 5);
+    *block += next_random() % 3;
+    memcpy(before, state[pool], sizeof(before));
+    switch (kind) {
+      case UDTSWAP_HISTORY_CREATE:
+        state[pool][0] = amount * 1000 + UDT_RESERVE_DEFAULT;
+        state[pool][1] = ((fixture_u128)next_random() << 40) + CKB_RESERVE_DEFAULT;
+        state[pool][2] = amount * 7000 + 1000000;
+        break;
+      case UDTSWAP_HISTORY_SWAP_UDT1_INPUT:
+        state[pool][0] += amount;
+        state[pool][1] -= state[pool][1] / 1000;
+        break;
+      case UDTSWAP_HISTORY_SWAP_UDT2_INPUT:
+        state[pool][0] -= state[pool][0] / 1000;
+        state[pool][1] += amount;
+        break;
+      case UDTSWAP_HISTORY_ADD:
+        state[pool][0] += amount;
+        state[pool][1] += amount * 3;
+        state[pool][2] += amount;
+        break;
+      case UDTSWAP_HISTORY_REMOVE:
+        state[pool][0] -= state[pool][0] / 100;
+        state[pool][1] -= state[pool][1] / 100;
+        state[pool][2] -= state[pool][2] / 100;
+        break;
+      default:
+        before[0] += amount;
+        //transition not following previous state of the pool
+        state[pool][0] += amount * 2;
+        state[pool][1] -= state[pool][1] / 1000;
+        kind = UDTSWAP_HISTORY_SWAP_UDT1_INPUT;
+        break;
+    }
+    type_hash[0] = (uint8_t)pool;
+    history_test_data(prev_data, before);
+    history_test_data(data, state[pool]);
+    row->block_number = *block;
+    row->timestamp = *block * 8000 + next_random() % 5000;
+    row->pool = pool;
+    row->kind = kind;
+    row->udt1_reserve = state[pool][0];
+    row->udt2_reserve = state[pool][1];
+    row->total_liquidity = state[pool][2];
+    row->udt1_delta = (udtswap_history_i128)(state[pool][0] - before[0]);
+    row->udt2_delta = (udtswap_history_i128)(state[pool][1] - before[1]);
+    row->liquidity_delta = (udtswap_history_i128)(state[pool][2] - before[2]);
+    k = udtswap_history_append(history, row->block_number, row->timestamp, type_hash, kind == UDTSWAP_HISTORY_CREATE ? NULL : prev_data, data);
+    if (k != 0) {
+      return i;
+    }
+  }
+  return cnt;
+}
+//pool ids are order of first rows, pool of type hash first byte p is not always p
+
+static void history_test_pool_ids(udtswap_history_t *history, udtswap_history_row_t *rows, size_t cnt) {
+  uint8_t type_hash[32] = {0};
+  uint32_t ids[NATIVE_TEST_HISTORY_POOLS];
+  size_t i;
+  for (i = 0; i < NATIVE_TEST_HISTORY_POOLS; i++) {
+    type_hash[0] = (uint8_t)i;
+    ids[i] = UDTSWAP_HISTORY_ALL_POOLS;
+    udtswap_history_pool(history, type_hash, &ids[i]);
+  }
+  for (i = 0; i < cnt; i++) {
+    rows[i].pool = ids[rows[i].pool];
+  }
+}
+
+static void test_history(const fixture_context_t *ctx) {
+  size_t cnt = NATIVE_TEST_HISTORY_ROWS + NATIVE_TEST_HISTORY_MORE_ROWS, appended, p;
+  udtswap_history_row_t *rows = malloc(cnt * sizeof(udtswap_history_row_t));
+  fixture_u128 state[NATIVE_TEST_HISTORY_POOLS][3];
+  uint8_t type_hash[32] = {0}, data[UDTSWAP_DATA_SIZE] = {0};
+  udtswap_history_range_t range = {UDTSWAP_HISTORY_ALL_POOLS, 0, UINT64_MAX, 0, UINT64_MAX};
+  udtswap_history_stats_t stats;
+  udtswap_history_t *history;
+  uint64_t block = 0, size;
+  if (rows == NULL) {
+    expect("history rows", 0, 1);
+    return;
+  }
+  memset(state, 0, sizeof(state));
+  unlink(NATIVE_TEST_HISTORY_PATH);
+
+  expect("history open", udtswap_history_open(NATIVE_TEST_HISTORY_PATH, &history), 0);
+  appended = history_test_append(history, rows, NATIVE_TEST_HISTORY_ROWS, state, &block);
+  expect("history append", appended == NATIVE_TEST_HISTORY_ROWS && udtswap_history_row_count(history) == NATIVE_TEST_HISTORY_ROWS, 1);
+  history_test_pool_ids(history, rows, appended);
+  expect("history pools", udtswap_history_pool_count(history), NATIVE_TEST_HISTORY_POOLS);
+  expect("history block before last block", udtswap_history_append(history, block - 3, 0, type_hash, data, data), UDTSWAP_HISTORY_ERROR_ORDER);
+  expect("history sealed and open rows", history_test_ranges(history, rows, appended), 1);
+  range.pool = NATIVE_TEST_HISTORY_POOLS;
+  expect("history unknown pool", udtswap_history_scan(history, &range, history_test_visit, NULL), UDTSWAP_HISTORY_ERROR_POOL);
+  range.pool = UDTSWAP_HISTORY_ALL_POOLS;
+  expect("history close", udtswap_history_close(history), 0);
+
+  expect("history reopen", udtswap_history_open(NATIVE_TEST_HISTORY_PATH, &history), 0);
+  expect("history reopen rows", udtswap_history_row_count(history) == appended && history_test_ranges(history, rows, appended), 1);
+  p = history_test_append(history, rows + appended, NATIVE_TEST_HISTORY_MORE_ROWS, state, &block);
+  history_test_pool_ids(history, rows + appended, p);
+  appended += p;
+  expect("history append after reopen", appended == cnt && history_test_ranges(history, rows, appended), 1);
+  expect("history flush", udtswap_history_flush(history), 0);
+  size = udtswap_history_size(history);
+  expect("history compressed", size < appended * 48, 1);
+  expect("history close after reopen", udtswap_history_close(history), 0);
+
+  FILE *fp = fopen(NATIVE_TEST_HISTORY_PATH, "r+b");
+  uint8_t head[200];
+  if (fp != NULL) {
+    fread(head, 1, sizeof(head), fp);
+    fseek(fp, 0, SEEK_END);
+    fwrite(head, 1, sizeof(head), fp);
+    fclose(fp);
+  }
+  expect("history torn tail", udtswap_history_open(NATIVE_TEST_HISTORY_PATH, &history), 0);
+  expect(
+    "history torn tail cut off",
+    udtswap_history_size(history) == size && udtswap_history_row_count(history) == appended && history_test_ranges(history, rows, appended),
+    1
+  );
+
+  uint32_t pool = rows[0].pool;
+  udtswap_history_stats_t expected;
+  memset(&expected, 0, sizeof(expected));
+  for (p = 0; p < appended; p++) {
+    const udtswap_history_row_t *row = &rows[p];
+    if (row->pool != pool) {
+      continue;
+    }
+    expected.row_cnt += 1;
+    expected.swap_cnt += row->kind == UDTSWAP_HISTORY_SWAP_UDT1_INPUT || row->kind == UDTSWAP_HISTORY_SWAP_UDT2_INPUT;
+    expected.add_cnt += row->kind == UDTSWAP_HISTORY_ADD;
+    if (row->kind == UDTSWAP_HISTORY_SWAP_UDT1_INPUT) {
+      expected.udt1_volume += (fixture_u128)row->udt1_delta;
+      expected.udt1_fee += (fixture_u128)row->udt1_delta - (fixture_u128)row->udt1_delta * LIQUIDITY_POOL_EXCEPT_FEE / 1000;
+    }
+    expected.udt2_reserve = row->udt2_reserve;
+  }
+  range.pool = pool;
+  expect("history stats", udtswap_history_stats(history, &range, &stats), 0);
+  expect(
+    "history stats of pool",
+    stats.row_cnt == expected.row_cnt && stats.swap_cnt == expected.swap_cnt && stats.add_cnt == expected.add_cnt &&
+      stats.udt1_volume == expected.udt1_volume && stats.udt1_fee == expected.udt1_fee && stats.udt2_reserve == expected.udt2_reserve,
+    1
+  );
+  udtswap_history_close(history);
+
+  if ((fp = fopen(NATIVE_TEST_HISTORY_PATH, "r+b")) != NULL) {
+    fputc('X', fp);
+    fclose(fp);
+  }
+  expect("history foreign file", udtswap_history_open(NATIVE_TEST_HISTORY_PATH, &history), UDTSWAP_HISTORY_ERROR_FORMAT);
+  unlink(NATIVE_TEST_HISTORY_PATH);
+  free(rows);
+
+  const uint8_t *blocks[NATIVE_TEST_INGEST_BLOCKS];
+  size_t lens[NATIVE_TEST_INGEST_BLOCKS], offset = 0, b;
+  uint8_t *buf = malloc(NATIVE_TEST_INGEST_SIZE);
+  fixture_chain_t chain;
+  int generated = buf != NULL, same = 1;
+  fixture_chain_init(&chain, ctx, NATIVE_TEST_INGEST_POOLS, 11);
+  for (b = 0; b < NATIVE_TEST_INGEST_BLOCKS && generated; b++) {
+    uint32_t len = fixture_chain_block(&chain, ctx, NATIVE_TEST_INGEST_TXS, buf + offset, NATIVE_TEST_INGEST_SIZE - offset);
+    blocks[b] = buf + offset;
+    lens[b] = len;
+    offset += len;
+    generated = len > 0;
+  }
+  udtswap_ingest_t *ingest = udtswap_ingest_new();
+  udtswap_ingest_options_t options = {2, 8, udtswap_history_apply, NULL};
+  udtswap_history_open(NULL, &history);
+  options.ctx = history;
+  udtswap_ingest_set_code_hashes(ingest, ctx->type_code_hash, ctx->lock_code_hash);
+  expect(
+    "history of ingest",
+    generated && udtswap_ingest_blocks(ingest, blocks, lens, NATIVE_TEST_INGEST_BLOCKS, &options) == 0 && udtswap_history_error(history) == 0,
+    1
+  );
+  for (p = 0; p < udtswap_ingest_pool_count(ingest); p++) {
+    const udtswap_snapshot_record_t *record = &udtswap_ingest_pools(ingest)[p];
+    same &= udtswap_history_pool(history, record->type_hash, &range.pool) == 0 &&
+      udtswap_history_stats(history, &range, &stats) == 0 &&
+      stats.swap_cnt == stats.row_cnt - 1 &&
+      stats.udt1_reserve == history_test_u128(record->data + UDTSWAP_DATA_UDT1_RESERVE_START) &&
+      stats.udt2_reserve == history_test_u128(record->data + UDTSWAP_DATA_UDT2_RESERVE_START) &&
+      stats.total_liquidity == history_test_u128(record->data + UDTSWAP_DATA_TOTAL_LIQUIDITY_START);
+  }
+  expect("history of ingest pools", same && udtswap_history_pool_count(history) == NATIVE_TEST_INGEST_POOLS, 1);
+  udtswap_history_close(history);
+  udtswap_ingest_free(ingest);
+  free(buf);
+}
+
+static void tx_test_script(const fixture_script_t *script, udtswap_tx_script_t *out) {
+  out->code_hash = script->code_hash;
+  out->hash_type = script->hash_type;
+  out->args = script->args;
+  out->args_len = script->args_len;
+}
+
+/* builder of fixture tx, cells of its pools by udtswap_tx_add_pool */
+static int tx_test_build(udtswap_tx_t *tx, const fixture_tx_t *fixture, size_t pool_cnt) {
+  udtswap_tx_script_t lock, type, udt_types[2];
+  size_t i;
+  int k, ret = 0;
+  for (i = 0; i < fixture->dep_cnt && ret == 0; i++) {
+    ret = udtswap_tx_add_cell_dep(tx, fixture->deps[i].tx_hash, fixture->deps[i].index, UDTSWAP_TX_DEP_CODE);
+  }
+  for (i = 0; i < fixture->header_cnt && ret == 0; i++) {
+    ret = udtswap_tx_add_header_dep(tx, fixture->headers[i].hash);
+  }
+  for (i = 0; i < fixture->input_cnt && ret == 0; i++) {
+    ret = udtswap_tx_add_input(tx, fixture->inputs[i].tx_hash, fixture->inputs[i].index, fixture->inputs[i].since);
+  }
+  for (i = 0; i < pool_cnt && ret == 0; i++) {
+    const fixture_cell_t *cells = &fixture->outputs[3 * i];
+    udtswap_tx_pool_t pool = {
+      NULL, 0, cells[0].type.code_hash, cells[0].lock.code_hash, cells[0].lock.args, cells[0].type.args, cells[0].type.args_len,
+      cells[0].capacity, cells[0].data, cells[0].data_len, {cells[1].capacity, cells[2].capacity}, {NULL, NULL},
+      {cells[1].data, cells[2].data}, {cells[1].data_len, cells[2].data_len}
+    };
+    for (k = 0; k < 2; k++) {
+      if (cells[1 + k].has_type) {
+        tx_test_script(&cells[1 + k].type, &udt_types[k]);
+        pool.udt_type[k] = &udt_types[k];
+      }
+    }
+    ret = udtswap_tx_add_pool(tx, &pool);
+  }
+  for (i = 3 * pool_cnt; i < fixture->output_cnt && ret >= 0; i++) {
+    const fixture_cell_t *cell = &fixture->outputs[i];
+    tx_test_script(&cell->lock, &lock);
+    tx_test_script(&cell->type, &type);
+    ret = udtswap_tx_add_output(tx, cell->capacity, &lock, cell->has_type ? &type : NULL, cell->data, cell->data_len);
+  }
+  for (i = 0; i < fixture->witness_cnt && ret >= 0; i++) {
+    ret = udtswap_tx_add_witness(tx, fixture->witnesses[i], fixture->witness_len[i]);
+  }
+  return ret < 0 ? ret : 0;
+}
+
+/* builder of fixture tx has same size, serialization and hash as fixture serialization */
+static int tx_test_same(const fixture_tx_t *fixture, size_t pool_cnt, uint8_t *arena, size_t arena_cap) {
+  uint32_t size = fixture_tx_size(fixture);
+  uint8_t *expected = malloc(size), *serialized = malloc(size);
+  uint8_t hash[32], expected_hash[32];
+  udtswap_tx_t *tx = malloc(sizeof(udtswap_tx_t));
+  int same = 0;
+  if (expected != NULL && serialized != NULL && tx != NULL) {
+    udtswap_tx_init(tx, arena, arena_cap);
+    fixture_tx_serialize(fixture, expected);
+    fixture_tx_hash(fixture, expected_hash);
+    if (
+      tx_test_build(tx, fixture, pool_cnt) == 0 && udtswap_tx_size(tx) == size &&
+      udtswap_tx_serialize(tx, serialized, size) == 0 && memcmp(serialized, expected, size) == 0
+    ) {
+      udtswap_tx_hash(tx, hash);
+      same = memcmp(hash, expected_hash, 32) == 0;
+    }
+  }
+  free(expected);
+  free(serialized);
+  free(tx);
+  return same;
+}
+
+static void test_tx(const fixture_context_t *ctx) {
+  static const size_t pool_cnts[] = {1, 3};
+  uint8_t *arena = malloc(NATIVE_TEST_TX_ARENA_SIZE), out[4096], signature[UDTSWAP_TX_SIGNATURE_SIZE];
+  udtswap_tx_t *tx = malloc(sizeof(udtswap_tx_t));
+  udtswap_tx_script_t lock;
+  char name[128];
+  int shape, kind;
+  size_t p;
+  uint64_t fee;
+  uint32_t len;
+  if (arena == NULL || tx == NULL) {
+    expect("tx arena", 0, 1);
+    free(arena);
+    free(tx);
+    return;
+  }
+
+  for (shape = FIXTURE_SHAPE_CREATE; shape <= FIXTURE_SHAPE_SWAP; shape++) {
+    for (kind = FIXTURE_PAIR_CKB_UDT; kind <= FIXTURE_PAIR_UDT_UDT; kind++) {
+      for (p = 0; p < sizeof(pool_cnts) / sizeof(pool_cnts[0]); p++) {
+        if (shape != FIXTURE_SHAPE_SWAP && p != 0) {
+          continue;
+        }
+        fixture_tx_t *fixture = new_tx();
+        int ret = fixture_bench_tx(fixture, ctx, shape, kind, pool_cnts[p], 0, FIXTURE_SWAP_UDT1_INPUT);
+        snprintf(name, sizeof(name), "tx builder shape %d kind %d pools %zu", shape, kind, pool_cnts[p]);
+        expect(name, ret == 0 && tx_test_same(fixture, pool_cnts[p], arena, NATIVE_TEST_TX_ARENA_SIZE), 1);
+        free_tx(fixture);
+      }
+    }
+  }
+
+  fixture_tx_t *fixture = new_tx();
+  fixture_bench_tx(fixture, ctx, FIXTURE_SHAPE_SWAP, FIXTURE_PAIR_CKB_UDT, 1, 0, FIXTURE_SWAP_UDT1_INPUT);
+  udtswap_tx_init(tx, arena, 256);
+  expect("tx builder arena full", tx_test_build(tx, fixture, 1), UDTSWAP_TX_ERROR_SPACE);
+  free_tx(fixture);
+
+  udtswap_tx_init(tx, arena, NATIVE_TEST_TX_ARENA_SIZE);
+  tx_test_script(&ctx->user_lock, &lock);
+  udtswap_tx_add_input(tx, ctx->type_code_hash, 0, 0);
+  expect("tx builder output", udtswap_tx_add_output(tx, 10000000000ULL, &lock, NULL, NULL, 0), 0);
+  expect("tx builder change output", udtswap_tx_add_output(tx, 0, &lock, NULL, NULL, 0), 1);
+  expect("tx builder lock witness", udtswap_tx_add_lock_witness(tx), 0);
+  len = udtswap_tx_size(tx);
+  expect("tx builder balance", udtswap_tx_balance(tx, 1, 20000000000ULL, 1000, &fee), 0);
+  expect("tx builder fee", fee == len + 4 && tx->capacity == 20000000000ULL - fee && udtswap_tx_size(tx) == len, 1);
+  expect("tx builder balance short", udtswap_tx_balance(tx, 1, 10000000000ULL, 1000, &fee), UDTSWAP_TX_ERROR_CAPACITY);
+  expect("tx builder balance of unknown output", udtswap_tx_balance(tx, 2, 20000000000ULL, 1000, &fee), UDTSWAP_TX_ERROR_INDEX);
+
+  uint8_t *witness = udtswap_tx_witness(tx, 0, &len);
+  memset(signature, 0x5a, sizeof(signature));
+  memcpy(witness + 20, signature, sizeof(signature));
+  expect("tx builder serialize", udtswap_tx_serialize(tx, out, sizeof(out)), 0);
+  expect(
+    "tx builder lock witness signed in place",
+    len == UDTSWAP_TX_LOCK_WITNESS_SIZE && memcmp(out + udtswap_tx_size(tx) - UDTSWAP_TX_SIGNATURE_SIZE, signature, sizeof(signature)) == 0,
+    1
+  );
+  expect("tx builder serialize short", udtswap_tx_serialize(tx, out, udtswap_tx_size(tx) - 1), UDTSWAP_TX_ERROR_SPACE);
+  free(arena);
+  free(tx);
+}
+
+/* signature of mock signer, blake2b of message and key, then message and first byte of key, fails for key of 0xff */
+static int sign_test_signer(void *ctx, const uint8_t message[32], const uint8_t key[32], uint8_t signature[UDTSWAP_TX_SIGNATURE_SIZE]) {
+  blake2b_state state;
+  (void)ctx;
+  if (key[0] == 0xff) {
+    return -1;
+  }
+  blake2b_init(&state);
+  blake2b_update(&state, message, 32);
+  blake2b_update(&state, key, 32);
+  blake2b_final(&state, signature);
+  memcpy(signature + 32, message, 32);
+  signature[64] = key[0];
+  return 0;
+}
+
+static void sign_test_hash_witness(blake2b_state *state, const uint8_t *witness, uint32_t len) {
+  uint8_t len_bytes[8] = {(uint8_t)len, (uint8_t)(len >> 8), (uint8_t)(len >> 16), (uint8_t)(len >> 24), 0, 0, 0, 0};
+  blake2b_update(state, len_bytes, sizeof(len_bytes));
+  blake2b_update(state, witness, len);
+}
+
+/*
+ * transaction of 3 inputs, lock groups of witnesses 0 ... 1 and witness 2, witness 3 without input
+ * expected messages of both groups are hashed from the witnesses before signing
+ */
+static int sign_test_build(udtswap_tx_t *tx, uint8_t *arena, const fixture_context_t *ctx, uint32_t n, uint8_t messages[2][32]) {
+  udtswap_tx_script_t lock;
+  uint8_t hash[32], tx_hash[32], extra[24];
+  uint8_t *witness;
+  uint32_t len, i;
+  blake2b_state state;
+  int ret = 0;
+
+  udtswap_tx_init(tx, arena, NATIVE_TEST_SIGN_ARENA_SIZE);
+  tx_test_script(&ctx->user_lock, &lock);
+  memset(hash, 0, sizeof(hash));
+  memcpy(hash, &n, sizeof(n));
+  for (i = 0; i < 3 && ret >= 0; i++) {
+    ret = udtswap_tx_add_input(tx, hash, i, 0);
+  }
+  if (ret >= 0) {
+    ret = udtswap_tx_add_output(tx, 10000000000ULL + n, &lock, NULL, NULL, 0);
+  }
+  for (i = 0; i < sizeof(extra); i++) {
+    extra[i] = (uint8_t)next_random();
+  }
+  if (ret >= 0) {
+    ret = udtswap_tx_add_lock_witness(tx);
+  }
+  if (ret >= 0) {
+    ret = udtswap_tx_add_witness(tx, extra, n % 8);
+  }
+  if (ret >= 0) {
+    ret = udtswap_tx_add_lock_witness(tx);
+  }
+  if (ret >= 0) {
+    ret = udtswap_tx_add_witness(tx, extra, sizeof(extra));
+  }
+  if (ret < 0) {
+    return ret;
+  }
+
+  udtswap_tx_hash(tx, tx_hash);
+  blake2b_init(&state);
+  blake2b_update(&state, tx_hash, 32);
+  for (i = 0; i < 4; i++) {
+    if (i != 2) {
+      witness = udtswap_tx_witness(tx, i, &len);
+      sign_test_hash_witness(&state, witness, len);
+    }
+  }
+  blake2b_final(&state, messages[0]);
+  blake2b_init(&state);
+  blake2b_update(&state, tx_hash, 32);
+  for (i = 2; i < 4; i++) {
+    witness = udtswap_tx_witness(tx, i, &len);
+    sign_test_hash_witness(&state, witness, len);
+  }
+  blake2b_final(&state, messages[1]);
+  return 0;
+}
+
+static void test_sign(const fixture_context_t *ctx) {
+  uint8_t *arena = malloc(NATIVE_TEST_SIGN_TXS * NATIVE_TEST_SIGN_ARENA_SIZE);
+  udtswap_tx_t *txs = malloc(NATIVE_TEST_SIGN_TXS * sizeof(udtswap_tx_t));
+  udtswap_sign_job_t *jobs = calloc(2 * NATIVE_TEST_SIGN_TXS, sizeof(udtswap_sign_job_t));
+  uint8_t (*messages)[2][32] = malloc(NATIVE_TEST_SIGN_TXS * sizeof(*messages));
+  uint8_t keys[2][32], signature[UDTSWAP_TX_SIGNATURE_SIZE], message[32], *witness;
+  udtswap_signer_t *signer = udtswap_signer_new(NATIVE_TEST_SIGN_THREADS, sign_test_signer, NULL);
+  udtswap_signer_t *hasher = udtswap_signer_new(1, NULL, NULL);
+  int built = 1, same = 1, signed_ok = 1, ret;
+  uint32_t n, len, size;
+  size_t i;
+  if (arena == NULL || txs == NULL || jobs == NULL || messages == NULL || signer == NULL || hasher == NULL) {
+    expect("sign alloc", 0, 1);
+    goto done;
+  }
+  memset(keys[0], 0x11, 32);
+  memset(keys[1], 0x22, 32);
+
+  for (n = 0; n < NATIVE_TEST_SIGN_TXS; n++) {
+    built &= sign_test_build(&txs[n], arena + n * NATIVE_TEST_SIGN_ARENA_SIZE, ctx, n, messages[n]) == 0;
+    for (i = 0; i < 2; i++) {
+      udtswap_sign_job_t job = {&txs[n], i == 0 ? 0 : 2, i == 0 ? 2 : 1, keys[i], {0}, 0};
+      jobs[2 * n + i] = job;
+    }
+  }
+  expect("sign build", built, 1);
+  size = udtswap_tx_size(&txs[0]);
+
+  expect("sign messages only", udtswap_signer_run(hasher, jobs, 2 * NATIVE_TEST_SIGN_TXS), 0);
+  for (n = 0; n < NATIVE_TEST_SIGN_TXS; n++) {
+    for (i = 0; i < 2; i++) {
+      same &= memcmp(jobs[2 * n + i].message, messages[n][i], 32) == 0;
+      witness = udtswap_tx_witness(&txs[n], 2 * i, &len);
+      memset(signature, 0, sizeof(signature));
+      same &= memcmp(witness + 20, signature, sizeof(signature)) == 0;
+    }
+  }
+  expect("sign messages of sighash all", same, 1);
+
+  expect("sign batch", udtswap_signer_run(signer, jobs, 2 * NATIVE_TEST_SIGN_TXS), 0);
+  expect("sign batch again", udtswap_signer_run(signer, jobs, 2 * NATIVE_TEST_SIGN_TXS), 0);
+  for (n = 0; n < NATIVE_TEST_SIGN_TXS; n++) {
+    for (i = 0; i < 2; i++) {
+      sign_test_signer(NULL, messages[n][i], keys[i], signature);
+      witness = udtswap_tx_witness(&txs[n], 2 * i, &len);
+      signed_ok &= memcmp(jobs[2 * n + i].message, messages[n][i], 32) == 0;
+      signed_ok &= len == UDTSWAP_TX_LOCK_WITNESS_SIZE && memcmp(witness + 20, signature, sizeof(signature)) == 0;
+      signed_ok &= udtswap_sighash(&txs[n], 2 * i, i == 0 ? 2 : 1, message) == 0 && memcmp(message, messages[n][i], 32) == 0;
+    }
+  }
+  expect("sign signatures in lock witnesses", signed_ok, 1);
+  expect("sign size of signed transaction", udtswap_tx_size(&txs[0]) == size, 1);
+
+  expect("sign group beyond witnesses", udtswap_sighash(&txs[0], 2, 3, message), UDTSWAP_SIGN_ERROR_WITNESS);
+  expect("sign empty group", udtswap_sighash(&txs[0], 0, 0, message), UDTSWAP_SIGN_ERROR_WITNESS);
+  expect("sign group without lock witness", udtswap_sighash(&txs[0], 1, 1, message), UDTSWAP_SIGN_ERROR_WITNESS);
+  jobs[5].group_start = 3;
+  memset(keys[1], 0xff, 32);
+  ret = udtswap_signer_run(signer, jobs, 2 * NATIVE_TEST_SIGN_TXS);
+  expect("sign batch error", ret, UDTSWAP_SIGN_ERROR_SIGNER);
+  expect("sign job errors", jobs[5].ret == UDTSWAP_SIGN_ERROR_WITNESS && jobs[1].ret == UDTSWAP_SIGN_ERROR_SIGNER && jobs[0].ret == 0, 1);
+  expect("sign empty batch", udtswap_signer_run(signer, jobs, 0), 0);
+
+done:
+  udtswap_signer_free(signer);
+  udtswap_signer_free(hasher);
+  free(arena);
+  free(txs);
+  free(jobs);
+  free(messages);
+}
+
+static int sim_test_udtswap_groups(const fixture_context_t *ctx, const fixture_tx_t *tx) {
+  fixture_group_t groups[SIM_VERIFY_MAX_GROUPS];
+  size_t i, cnt = sim_verify_groups(ctx, tx, groups);
+  int udtswap = 0;
+  for (i = 0; i < cnt; i++) {
+    udtswap += groups[i].script >= 0;
+  }
+  return udtswap;
+}
+
+/*
+ * transactions of every shape with code cell deps are accepted by simulated chain verification,
+ * with the script groups of the shape, and rejected transactions report their group
+ */
+static void test_sim_verify(const fixture_context_t *ctx) {
+  static const size_t pool_cnts[] = {1, 3};
+  fixture_group_t groups[FIXTURE_MAX_POOLS + 2];
+  sim_reject_t reject;
+  char name[128];
+  int shape, kind, ret;
+  size_t p;
+
+  for (shape = FIXTURE_SHAPE_CREATE; shape <= FIXTURE_SHAPE_SWAP; shape++) {
+    for (kind = FIXTURE_PAIR_CKB_UDT; kind <= FIXTURE_PAIR_UDT_UDT; kind++) {
+      for (p = 0; p < sizeof(pool_cnts) / sizeof(pool_cnts[0]); p++) {
+        if (shape != FIXTURE_SHAPE_SWAP && p != 0) {
+          continue;
+        }
+        fixture_tx_t *tx = new_tx();
+        ret = fixture_bench_tx(tx, ctx, shape, kind, pool_cnts[p], 0, FIXTURE_SWAP_UDT1_INPUT);
+        if (ret == 0) {
+          ret = fixture_add_code_deps(tx, ctx, NULL);
+        }
+        if (ret == 0) {
+          ret = fixture_balance_capacity(tx, ctx);
+        }
+        snprintf(name, sizeof(name), "sim verify shape %d kind %d pools %zu", shape, kind, pool_cnts[p]);
+        expect(name, ret == 0 ? sim_verify(ctx, tx, NULL, &reject) : ret, 0);
+        snprintf(name, sizeof(name), "sim verify groups shape %d kind %d pools %zu", shape, kind, pool_cnts[p]);
+        expect(name, sim_test_udtswap_groups(ctx, tx), (int)fixture_shape_groups(shape, pool_cnts[p], groups));
+        free_tx(tx);
+      }
+    }
+  }
+
+  fixture_tx_t *tx = new_tx();
+  fixture_bench_tx(tx, ctx, FIXTURE_SHAPE_SWAP, FIXTURE_PAIR_UDT_UDT, 1, 0, FIXTURE_SWAP_UDT1_INPUT);
+  fixture_balance_capacity(tx, ctx);
+  expect("sim verify without code deps", sim_verify(ctx, tx, NULL, &reject), SIM_VERIFY_ERROR_CODE_DEP);
+  fixture_add_code_deps(tx, ctx, NULL);
+  tamper_swap_output(tx);
+  expect("sim verify swap output above formula", sim_verify(ctx, tx, NULL, &reject), SIM_VERIFY_ERROR_SCRIPT);
+  expect(
+    "sim verify rejected group",
+    reject.code == SWAP_NOT_CORRECT_ERROR && reject.group.script == FIXTURE_SCRIPT_TYPE && reject.group.group_type == FIXTURE_GROUP_TYPE,
+    1
+  );
+  tamper_swap_output(tx);
+  tx->outputs[tx->output_cnt - 1].capacity = 1;
+  expect("sim verify occupied capacity", sim_verify(ctx, tx, NULL, &reject), SIM_VERIFY_ERROR_OCCUPIED);
+  tx->outputs[tx->output_cnt - 1].capacity = UINT64_MAX;
+  expect("sim verify capacity of outputs", sim_verify(ctx, tx, NULL, &reject), SIM_VERIFY_ERROR_CAPACITY);
+  free_tx(tx);
+}
+
+static void throughput(const fixture_context_t *ctx) {
+  fixture_group_t group = {FIXTURE_SCRIPT_TYPE, FIXTURE_GROUP_TYPE, 0, 0};
+  struct timespec start, end;
+  fixture_tx_t *tx = new_tx();
+  int i, ret = fixture_bench_tx(tx, ctx, FIXTURE_SHAPE_SWAP, FIXTURE_PAIR_CKB_UDT, 1, 0, FIXTURE_SWAP_UDT1_INPUT);
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (i = 0; i < NATIVE_TEST_THROUGHPUT_RUNS && ret == 0; i++) {
+    ret = run_group(ctx, tx, &group);
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+  expect("throughput swap", ret, 0);
+  printf("swap type script: %.0f verifications/s\n", NATIVE_TEST_THROUGHPUT_RUNS / seconds);
+  free_tx(tx);
+}
+
+#ifdef NATIVE_BN_LIB_DIR
+/*
+ * bn library cell dep of host build (BN_DYNAMIC=1), loaded by load_bn_lib_segments as in CKB-VM
+ * every script group of every shape passes with it, scripts without the dep call the linked library
+ */
+static int add_bn_lib_dep(const fixture_context_t *ctx, fixture_tx_t *tx, const char *name) {
+  char path[4096];
+  fixture_cell_t *dep = fixture_tx_add_dep(tx);
+  if (dep == NULL) {
+    return FIXTURE_ERROR_TOO_MANY_CELLS;
+  }
+  dep->lock = ctx->user_lock;
+  dep->has_type = 1;
+  dep->type = ctx->bn_lib_code_dep;
+  snprintf(path, sizeof(path), "%s/%s", NATIVE_BN_LIB_DIR, name);
+  return fixture_cell_load_data(dep, path);
+}
+
+static void bn_lib_relocated(fixture_cell_t *dep) {
+  Elf64_Ehdr *header = (Elf64_Ehdr *)dep->data;
+  Elf64_Phdr *program_headers = (Elf64_Phdr *)(dep->data + header->e_phoff);
+  int i;
+  for (i = 0; i < header->e_phnum; i++) {
+    if (program_headers[i].p_type == PT_DYNAMIC) {
+      Elf64_Dyn *dyn = (Elf64_Dyn *)(dep->data + program_headers[i].p_offset);
+      dyn->d_tag = DT_RELASZ;
+      dyn->d_un.d_val = sizeof(Elf64_Rela);
+    }
+  }
+}
+
+/*
+ * swap of one pool with bn library cell dep changed by tamper, type script result
+ */
+static int run_swap_bn_lib(const fixture_context_t *ctx, const char *name, void (*tamper)(fixture_cell_t *dep)) {
+  fixture_tx_t *tx = new_tx();
+  int ret = fixture_bench_tx(tx, ctx, FIXTURE_SHAPE_SWAP, FIXTURE_PAIR_UDT_UDT, 1, 0, FIXTURE_SWAP_UDT1_INPUT);
+  if (ret == 0) {
+    ret = add_bn_lib_dep(ctx, tx, name);
+  }
+  if (ret == 0) {
+    if (tamper != NULL) {
+      tamper(&tx->deps[tx->dep_cnt - 1]);
+    }
+    ret = run_type(ctx, tx);
+  }
+  free_tx(tx);
+  return ret;
+}
+
+static void bn_lib_other_machine(fixture_cell_t *dep) {
+  ((Elf64_Ehdr *)dep->data)->e_machine = EM_RISCV;
+}
+
+static void bn_lib_truncated(fixture_cell_t *dep) {
+  dep->data_len = sizeof(Elf64_Ehdr) + 8;
+}
+
+static void test_bn_lib_cell(const fixture_context_t *ctx) {
+  static const size_t pool_cnts[] = {1, 3, FIXTURE_MAX_POOLS};
+  fixture_group_t groups[FIXTURE_MAX_POOLS + 2];
+  char name[128];
+  int shape, kind;
+  size_t p, g;
+
+  for (shape = FIXTURE_SHAPE_CREATE; shape <= FIXTURE_SHAPE_SWAP; shape++) {
+    for (kind = FIXTURE_PAIR_CKB_UDT; kind <= FIXTURE_PAIR_UDT_UDT; kind++) {
+      for (p = 0; p < sizeof(pool_cnts) / sizeof(pool_cnts[0]); p++) {
+        if (shape != FIXTURE_SHAPE_SWAP && p != 0) {
+          continue;
+        }
+        fixture_tx_t *tx = new_tx();
+        int ret = fixture_bench_tx(tx, ctx, shape, kind, pool_cnts[p], 1, FIXTURE_SWAP_UDT1_INPUT);
+        if (ret == 0) {
+          ret = add_bn_lib_dep(ctx, tx, "bn_lib");
+        }
+        size_t cnt = fixture_shape_groups(shape, pool_cnts[p], groups);
+        for (g = 0; g < cnt; g++) {
+          snprintf(
+            name, sizeof(name), "bn_lib cell shape %d kind %d pools %zu %s %zu",
+            shape, kind, pool_cnts[p], fixture_script_name(groups[g].script), groups[g].index
+          );
+          expect(name, ret == 0 ? run_group(ctx, tx, &groups[g]) : ret, 0);
+        }
+        free_tx(tx);
+      }
+    }
+  }
+
+  expect("bn_lib cell swap", run_swap_bn_lib(ctx, "bn_lib", NULL), 0);
+  expect("bn_lib cell of other machine", run_swap_bn_lib(ctx, "bn_lib", bn_lib_other_machine), BN_LIB_FORMAT_ERROR);
+  expect("bn_lib cell truncated", run_swap_bn_lib(ctx, "bn_lib", bn_lib_truncated), BN_LIB_FORMAT_ERROR);
+  expect("bn_lib cell with relocations", run_swap_bn_lib(ctx, "bn_lib", bn_lib_relocated), BN_LIB_FORMAT_ERROR);
+  expect("bn_lib cell of version 1", run_swap_bn_lib(ctx, "bn_lib_v1", NULL), BN_LIB_VERSION_ERROR);
+  expect("bn_lib cell swap after rejected cells", run_swap_bn_lib(ctx, "bn_lib", NULL), 0);
+}
+#endif /* NATIVE_BN_LIB_DIR */
+
+int main(void) {
+  fixture_context_t ctx;
+  fixture_context_init(&ctx);
+  test_shapes(&ctx);
+  test_rejects(&ctx);
+  test_create_stale_header(&ctx);
+  test_create_long_udt_data(&ctx);
+  test_trace_replay(&ctx);
+  test_unified(&ctx);
+  test_quote(&ctx);
+  test_quote_batch();
+  test_route(&ctx);
+  test_route_shard(&ctx);
+  test_snapshot();
+  test_ingest(&ctx);
+  test_history(&ctx);
+  test_tx(&ctx);
+  test_sign(&ctx);
+  test_sim_verify(&ctx);
+#ifdef NATIVE_BN_LIB_DIR
+  test_bn_lib_cell(&ctx);
+#endif
+  throughput(&ctx);
+  printf("%d passed, %d failed\n", passed, failed);
+  return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,943 @@
+/*
+ * pool transition history, append only file of compressed chunks
+ * chunk : header of HISTORY_HEADER_SIZE bytes, then HISTORY_SECTIONS sections of a 4 byte length and bytes
+ * integers of header are little endian, numbers of sections are LEB128 varints, signed ones zigzag encoded
+ * a chunk decodes by itself, reserves of a pool are stored for its first row of the chunk (base row)
+ * and are previous reserves plus deltas for its other rows
+ */
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "../../UDTswap_scripts/udtswap_common.h"
+#include "udtswap_history.h"
+
+#define HISTORY_MAGIC 0x48544455 //"UDTH"
+#define HISTORY_HEADER_SIZE 56
+#define HISTORY_SECTIONS 10
+#define HISTORY_VARINT_MAX 19
+#define HISTORY_BASE_FLAG 0x80
+#define HISTORY_KIND_MASK 0x7f
+#define HISTORY_FEE_BASE 1000
+
+#define HISTORY_NEW_POOLS 0
+#define HISTORY_POOLS 1
+#define HISTORY_BLOCKS 2
+#define HISTORY_TIMES 3
+#define HISTORY_POOL_INDEXES 4
+#define HISTORY_KINDS 5
+#define HISTORY_BASES 6
+#define HISTORY_UDT1_DELTAS 7
+#define HISTORY_UDT2_DELTAS 8
+#define HISTORY_LIQUIDITY_DELTAS 9
+
+#define HISTORY_EMPTY UINT32_MAX
+
+/*
+ * magic, version, chunk size, row count, count of pools first seen in the chunk, count of pools of the chunk,
+ * first and last block number, min and max timestamp
+ */
+typedef struct {
+  uint8_t *data;
+  size_t size;
+  uint32_t row_cnt;
+  uint64_t first_block;
+  uint64_t last_block;
+  uint64_t min_time;
+  uint64_t max_time;
+} history_chunk_t;
+
+typedef struct {
+  uint32_t *chunks;
+  size_t cnt;
+  size_t cap;
+} history_pool_t;
+
+typedef struct {
+  uint8_t *p;
+  size_t len;
+  size_t cap;
+} history_buf_t;
+
+typedef struct {
+  const uint8_t *p;
+  const uint8_t *end;
+} history_reader_t;
+
+struct udtswap_history {
+  int fd;
+  history_chunk_t *chunks;
+  size_t chunk_cnt;
+  size_t chunk_cap;
+  uint8_t (*pool_hashes)[UDTSWAP_ROUTE_HASH_SIZE];
+  history_pool_t *pools;
+  size_t pool_cnt;
+  size_t pool_cap;
+  size_t sealed_pool_cnt;
+  uint32_t *table;
+  size_t table_size;
+  udtswap_history_row_t *rows;
+  size_t row_cnt;
+  uint64_t sealed_row_cnt;
+  uint64_t size;
+  int has_rows;
+  uint64_t last_block;
+  int error;
+  udtswap_history_row_t *scan_rows;
+  uint32_t *scan_pools;
+  udtswap_quote_u128 (*scan_state)[3];
+  uint8_t *scan_seen;
+};
+//rows are the open chunk, pools after sealed_pool_cnt are first seen in it
+
+static void history_put(uint8_t *p, uint64_t v, int len) {
+  int i;
+  for (i = 0; i < len; i++) {
+    p[i] = (uint8_t)(v >> (8 * i));
+  }
+}
+
+static uint64_t history_get(const uint8_t *p, int len) {
+  uint64_t v = 0;
+  int i;
+  for (i = len - 1; i >= 0; i--) {
+    v = (v << 8) | p[i];
+  }
+  return v;
+}
+
+static udtswap_quote_u128 history_get_u128(const uint8_t *p) {
+  udtswap_quote_u128 v = 0;
+  int i;
+  for (i = 15; i >= 0; i--) {
+    v = (v << 8) | p[i];
+  }
+  return v;
+}
+
+static udtswap_quote_u128 history_zigzag(udtswap_history_i128 v) {
+  return ((udtswap_quote_u128)v << 1) ^ (udtswap_quote_u128)(v >> 127);
+}
+
+static udtswap_history_i128 history_unzigzag(udtswap_quote_u128 v) {
+  return (udtswap_history_i128)((v >> 1) ^ (0 - (v & 1)));
+}
+
+/*
+ * column buffers
+ */
+
+static int history_reserve(history_buf_t *buf, size_t len) {
+  if (buf->len + len > buf->cap) {
+    size_t cap = buf->cap == 0 ? 4096 : buf->cap;
+    while (cap < buf->len + len) {
+      cap *= 2;
+    }
+    uint8_t *p = realloc(buf->p, cap);
+    if (p == NULL) {
+      return UDTSWAP_HISTORY_ERROR_ALLOC;
+    }
+    buf->p = p;
+    buf->cap = cap;
+  }
+  return 0;
+}
+
+static int history_put_varint(history_buf_t *buf, udtswap_quote_u128 v) {
+  if (history_reserve(buf, HISTORY_VARINT_MAX) != 0) {
+    return UDTSWAP_HISTORY_ERROR_ALLOC;
+  }
+  while (v >= 0x80) {
+    buf->p[buf->len++] = (uint8_t)v | 0x80;
+    v >>= 7;
+  }
+  buf->p[buf->len++] = (uint8_t)v;
+  return 0;
+}
+
+static int history_put_bytes(history_buf_t *buf, const void *p, size_t len) {
+  if (len == 0) {
+    return 0;
+  }
+  if (history_reserve(buf, len) != 0) {
+    return UDTSWAP_HISTORY_ERROR_ALLOC;
+  }
+  memcpy(buf->p + buf->len, p, len);
+  buf->len += len;
+  return 0;
+}
+
+static int history_get_varint(history_reader_t *r, udtswap_quote_u128 *v) {
+  int shift = 0;
+  *v = 0;
+  while (r->p < r->end && shift < 7 * HISTORY_VARINT_MAX) {
+    uint8_t b = *r->p++;
+    *v |= (udtswap_quote_u128)(b & 0x7f) << shift;
+    if ((b & 0x80) == 0) {
+      return 0;
+    }
+    shift += 7;
+  }
+  return UDTSWAP_HISTORY_ERROR_FORMAT;
+}
+
+static int history_get_u64(history_reader_t *r, uint64_t *v) {
+  udtswap_quote_u128 w;
+  if (history_get_varint(r, &w) != 0 || w > UINT64_MAX) {
+    return UDTSWAP_HISTORY_ERROR_FORMAT;
+  }
+  *v = (uint64_t)w;
+  return 0;
+}
+
+/*
+ * pool dictionary, pool id of type hash in order of first row
+ */
+
+static size_t history_slot_of(const udtswap_history_t *history, const uint8_t type_hash[UDTSWAP_ROUTE_HASH_SIZE]) {
+  size_t mask = history->table_size - 1;
+  size_t i = (size_t)history_get(type_hash, 8) & mask;
+  while (history->table[i] != HISTORY_EMPTY) {
+    if (memcmp(history->pool_hashes[history->table[i]], type_hash, UDTSWAP_ROUTE_HASH_SIZE) == 0) {
+      break;
+    }
+    i = (i + 1) & mask;
+  }
+  return i;
+}
+
+static int history_grow(udtswap_history_t *history) {
+  size_t i, size = history->table_size == 0 ? 1024 : history->table_size * 2;
+  uint32_t *table = malloc(size * sizeof(uint32_t));
+  uint8_t (*hashes)[UDTSWAP_ROUTE_HASH_SIZE] = realloc(history->pool_hashes, size / 2 * UDTSWAP_ROUTE_HASH_SIZE);
+  if (hashes != NULL) {
+    history->pool_hashes = hashes;
+  }
+  history_pool_t *pools = realloc(history->pools, size / 2 * sizeof(history_pool_t));
+  if (pools != NULL) {
+    history->pools = pools;
+  }
+  if (table == NULL || hashes == NULL || pools == NULL) {
+    free(table);
+    return UDTSWAP_HISTORY_ERROR_ALLOC;
+  }
+  free(history->table);
+  history->table = table;
+  history->table_size = size;
+  history->pool_cap = size / 2;
+  for (i = 0; i < size; i++) {
+    table[i] = HISTORY_EMPTY;
+  }
+  for (i = 0; i < history->pool_cnt; i++) {
+    table[history_slot_of(history, hashes[i])] = (uint32_t)i;
+  }
+  return 0;
+}
+
+static int history_add_pool(udtswap_history_t *history, const uint8_t type_hash[UDTSWAP_ROUTE_HASH_SIZE], uint32_t *pool) {
+  size_t i;
+  if (history->pool_cnt == history->pool_cap) {
+    int ret = history_grow(history);
+    if (ret != 0) {
+      return ret;
+    }
+  }
+  i = history_slot_of(history, type_hash);
+  if (history->table[i] == HISTORY_EMPTY) {
+    history->table[i] = (uint32_t)history->pool_cnt;
+    memcpy(history->pool_hashes[history->pool_cnt], type_hash, UDTSWAP_ROUTE_HASH_SIZE);
+    memset(&history->pools[history->pool_cnt], 0, sizeof(history_pool_t));
+    history->pool_cnt += 1;
+  }
+  *pool = history->table[i];
+  return 0;
+}
+
+static int history_add_pool_chunk(history_pool_t *pool, uint32_t chunk) {
+  if (pool->cnt == pool->cap) {
+    size_t cap = pool->cap == 0 ? 4 : pool->cap * 2;
+    uint32_t *chunks = realloc(pool->chunks, cap * sizeof(uint32_t));
+    if (chunks == NULL) {
+      return UDTSWAP_HISTORY_ERROR_ALLOC;
+    }
+    pool->chunks = chunks;
+    pool->cap = cap;
+  }
+  pool->chunks[pool->cnt++] = chunk;
+  return 0;
+}
+
+int udtswap_history_pool(
+  const udtswap_history_t *history,
+  const uint8_t type_hash[UDTSWAP_ROUTE_HASH_SIZE],
+  uint32_t *pool
+) {
+  if (history->table_size == 0) {
+    return UDTSWAP_HISTORY_ERROR_POOL;
+  }
+  size_t i = history_slot_of(history, type_hash);
+  if (history->table[i] == HISTORY_EMPTY) {
+    return UDTSWAP_HISTORY_ERROR_POOL;
+  }
+  *pool = history->table[i];
+  return 0;
+}
+
+const uint8_t *udtswap_history_pool_hash(const udtswap_history_t *history, uint32_t pool) {
+  return pool < history->pool_cnt ? history->pool_hashes[pool] : NULL;
+}
+
+/*
+ * chunks
+ */
+
+static int history_parse(const uint8_t *data, size_t size, history_reader_t sections[HISTORY_SECTIONS]) {
+  size_t offset = HISTORY_HEADER_SIZE;
+  int s;
+  for (s = 0; s < HISTORY_SECTIONS; s++) {
+    if (size - offset < 4) {
+      return UDTSWAP_HISTORY_ERROR_FORMAT;
+    }
+    size_t len = (size_t)history_get(data + offset, 4);
+    offset += 4;
+    if (len > size - offset) {
+      return UDTSWAP_HISTORY_ERROR_FORMAT;
+    }
+    sections[s].p = data + offset;
+    sections[s].end = data + offset + len;
+    offset += len;
+  }
+  return offset == size ? 0 : UDTSWAP_HISTORY_ERROR_FORMAT;
+}
+
+static int history_add_chunk(udtswap_history_t *history, uint8_t *data, size_t size, int load) {
+  history_reader_t sections[HISTORY_SECTIONS];
+  history_chunk_t chunk;
+  uint32_t new_pool_cnt = (uint32_t)history_get(data + 16, 4), pool_cnt = (uint32_t)history_get(data + 20, 4);
+  uint64_t pool = 0;
+  uint32_t id, i;
+  int ret;
+
+  chunk.data = data;
+  chunk.size = size;
+  chunk.row_cnt = (uint32_t)history_get(data + 12, 4);
+  chunk.first_block = history_get(data + 24, 8);
+  chunk.last_block = history_get(data + 32, 8);
+  chunk.min_time = history_get(data + 40, 8);
+  chunk.max_time = history_get(data + 48, 8);
+  if (
+    history_parse(data, size, sections) != 0 ||
+    chunk.row_cnt == 0 || chunk.row_cnt > UDTSWAP_HISTORY_CHUNK_ROWS ||
+    pool_cnt == 0 || pool_cnt > chunk.row_cnt ||
+    (size_t)(sections[HISTORY_NEW_POOLS].end - sections[HISTORY_NEW_POOLS].p) != (size_t)new_pool_cnt * UDTSWAP_ROUTE_HASH_SIZE ||
+    chunk.first_block > chunk.last_block ||
+    (history->chunk_cnt > 0 && chunk.first_block < history->chunks[history->chunk_cnt - 1].last_block)
+  ) {
+    return UDTSWAP_HISTORY_ERROR_FORMAT;
+  }
+  for (i = 0; i < new_pool_cnt && load; i++) {
+    ret = history_add_pool(history, sections[HISTORY_NEW_POOLS].p + (size_t)i * UDTSWAP_ROUTE_HASH_SIZE, &id);
+    if (ret != 0) {
+      return ret;
+    }
+    if (id != history->pool_cnt - 1) {
+      return UDTSWAP_HISTORY_ERROR_FORMAT;
+    }
+  }
+  //new pools of a loaded chunk are not in previous chunks, of a sealed chunk they are in the dictionary already
+
+  if (history->chunk_cnt == history->chunk_cap) {
+    size_t cap = history->chunk_cap == 0 ? 64 : history->chunk_cap * 2;
+    history_chunk_t *chunks = realloc(history->chunks, cap * sizeof(history_chunk_t));
+    if (chunks == NULL) {
+      return UDTSWAP_HISTORY_ERROR_ALLOC;
+    }
+    history->chunks = chunks;
+    history->chunk_cap = cap;
+  }
+  for (i = 0; i < pool_cnt; i++) {
+    uint64_t delta;
+    if (history_get_u64(&sections[HISTORY_POOLS], &delta) != 0 || (i > 0 && delta == 0) || delta >= history->pool_cnt - pool) {
+      return UDTSWAP_HISTORY_ERROR_FORMAT;
+    }
+    pool += delta;
+    ret = history_add_pool_chunk(&history->pools[pool], (uint32_t)history->chunk_cnt);
+    if (ret != 0) {
+      return ret;
+    }
+  }
+  //pools of a chunk are ascending pool ids
+  history->chunks[history->chunk_cnt++] = chunk;
+  history->sealed_pool_cnt = history->pool_cnt;
+  history->sealed_row_cnt += chunk.row_cnt;
+  history->size += size;
+  history->has_rows = 1;
+  history->last_block = chunk.last_block;
+  return 0;
+}
+
+static int history_write_all(int fd, const uint8_t *p, size_t len) {
+  while (len > 0) {
+    ssize_t n = write(fd, p, len);
+    if (n <= 0) {
+      return UDTSWAP_HISTORY_ERROR_IO;
+    }
+    p += n;
+    len -= (size_t)n;
+  }
+  return 0;
+}
+
+static int history_cmp_u32(const void *a, const void *b) {
+  uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+  return x < y ? -1 : x > y;
+}
+
+static uint32_t history_local(const uint32_t *pools, uint32_t cnt, uint32_t pool) {
+  uint32_t lo = 0, hi = cnt;
+  while (lo < hi) {
+    uint32_t mid = lo + (hi - lo) / 2;
+    if (pools[mid] < pool) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+/*
+ * open rows to a chunk, appended to the file and to the chunk list
+ */
+static int history_seal(udtswap_history_t *history) {
+  history_buf_t columns[HISTORY_SECTIONS], chunk;
+  uint32_t *pools = history->scan_pools, pool_cnt = 0, i;
+  udtswap_quote_u128 (*state)[3] = history->scan_state;
+  uint8_t *seen = history->scan_seen;
+  uint64_t block = 0, time = 0, min_time = UINT64_MAX, max_time = 0;
+  size_t n = history->row_cnt;
+  int s, ret = 0;
+
+  if (n == 0) {
+    return 0;
+  }
+  for (i = 0; i < n; i++) {
+    pools[i] = history->rows[i].pool;
+    min_time = history->rows[i].timestamp < min_time ? history->rows[i].timestamp : min_time;
+    max_time = history->rows[i].timestamp > max_time ? history->rows[i].timestamp : max_time;
+  }
+  qsort(pools, n, sizeof(uint32_t), history_cmp_u32);
+  for (i = 0; i < n; i++) {
+    if (i == 0 || pools[i] != pools[pool_cnt - 1]) {
+      pools[pool_cnt++] = pools[i];
+    }
+  }
+  memset(seen, 0, pool_cnt);
+  memset(columns, 0, sizeof(columns));
+  memset(&chunk, 0, sizeof(chunk));
+
+  ret = history_put_bytes(
+    &columns[HISTORY_NEW_POOLS],
+    history->pool_hashes[history->sealed_pool_cnt],
+    (history->pool_cnt - history->sealed_pool_cnt) * UDTSWAP_ROUTE_HASH_SIZE
+  );
+  for (i = 0; i < pool_cnt && ret == 0; i++) {
+    ret = history_put_varint(&columns[HISTORY_POOLS], pools[i] - (i == 0 ? 0 : pools[i - 1]));
+  }
+  for (i = 0; i < n && ret == 0; i++) {
+    const udtswap_history_row_t *row = &history->rows[i];
+    uint32_t local = history_local(pools, pool_cnt, row->pool);
+    udtswap_quote_u128 before[3] = {
+      row->udt1_reserve - (udtswap_quote_u128)row->udt1_delta,
+      row->udt2_reserve - (udtswap_quote_u128)row->udt2_delta,
+      row->total_liquidity - (udtswap_quote_u128)row->liquidity_delta
+    };
+    int base = !seen[local] || memcmp(before, state[local], sizeof(before)) != 0;
+    //a transition not following previous row of the pool starts a new base
+    uint8_t kind = (uint8_t)row->kind | (base ? HISTORY_BASE_FLAG : 0);
+
+    ret = history_put_varint(&columns[HISTORY_BLOCKS], row->block_number - block);
+    if (ret == 0) ret = history_put_varint(&columns[HISTORY_TIMES], history_zigzag((udtswap_history_i128)row->timestamp - (udtswap_history_i128)time));
+    if (ret == 0) ret = history_put_varint(&columns[HISTORY_POOL_INDEXES], local);
+    if (ret == 0) ret = history_put_bytes(&columns[HISTORY_KINDS], &kind, 1);
+    if (ret == 0 && base) {
+      ret = history_put_varint(&columns[HISTORY_BASES], row->udt1_reserve);
+      if (ret == 0) ret = history_put_varint(&columns[HISTORY_BASES], row->udt2_reserve);
+      if (ret == 0) ret = history_put_varint(&columns[HISTORY_BASES], row->total_liquidity);
+    }
+    if (ret == 0) ret = history_put_varint(&columns[HISTORY_UDT1_DELTAS], history_zigzag(row->udt1_delta));
+    if (ret == 0) ret = history_put_varint(&columns[HISTORY_UDT2_DELTAS], history_zigzag(row->udt2_delta));
+    if (ret == 0) ret = history_put_varint(&columns[HISTORY_LIQUIDITY_DELTAS], history_zigzag(row->liquidity_delta));
+    block = row->block_number;
+    time = row->timestamp;
+    state[local][0] = row->udt1_reserve;
+    state[local][1] = row->udt2_reserve;
+    state[local][2] = row->total_liquidity;
+    seen[local] = 1;
+  }
+
+  if (ret == 0) ret = history_reserve(&chunk, HISTORY_HEADER_SIZE);
+  if (ret == 0) {
+    uint8_t *h = chunk.p;
+    history_put(h, HISTORY_MAGIC, 4);
+    history_put(h + 4, UDTSWAP_HISTORY_VERSION, 4);
+    history_put(h + 12, n, 4);
+    history_put(h + 16, history->pool_cnt - history->sealed_pool_cnt, 4);
+    history_put(h + 20, pool_cnt, 4);
+    history_put(h + 24, history->rows[0].block_number, 8);
+    history_put(h + 32, history->rows[n - 1].block_number, 8);
+    history_put(h + 40, min_time, 8);
+    history_put(h + 48, max_time, 8);
+    chunk.len = HISTORY_HEADER_SIZE;
+  }
+  for (s = 0; s < HISTORY_SECTIONS && ret == 0; s++) {
+    uint8_t len[4];
+    history_put(len, columns[s].len, 4);
+    ret = history_put_bytes(&chunk, len, 4);
+    if (ret == 0) ret = history_put_bytes(&chunk, columns[s].p, columns[s].len);
+  }
+  for (s = 0; s < HISTORY_SECTIONS; s++) {
+    free(columns[s].p);
+  }
+  if (ret == 0) {
+    history_put(chunk.p + 8, chunk.len, 4);
+  }
+  //header : magic, version, size, rows, new pools, pools, blocks, times
+
+  if (ret == 0 && history->fd >= 0) {
+    ret = history_write_all(history->fd, chunk.p, chunk.len);
+    if (ret != 0 && ftruncate(history->fd, (off_t)history->size) != 0) {
+      ret = UDTSWAP_HISTORY_ERROR_IO;
+    }
+  }
+  //a failed write is cut off, rows stay open
+  if (ret == 0) {
+    history->row_cnt = 0;
+    ret = history_add_chunk(history, chunk.p, chunk.len, 0);
+  }
+  if (ret != 0) {
+    free(chunk.p);
+  }
+  return ret;
+}
+
+/*
+ * rows of a chunk in range, to scan_rows
+ */
+static int history_decode(udtswap_history_t *history, const history_chunk_t *chunk, const udtswap_history_range_t *range, size_t *cnt) {
+  history_reader_t sections[HISTORY_SECTIONS];
+  uint32_t pool_cnt = (uint32_t)history_get(chunk->data + 20, 4), i;
+  uint32_t *pools = history->scan_pools;
+  udtswap_quote_u128 (*state)[3] = history->scan_state;
+  uint8_t *seen = history->scan_seen;
+  uint64_t block = 0, time = 0, pool = 0;
+  udtswap_quote_u128 v;
+
+  *cnt = 0;
+  history_parse(chunk->data, chunk->size, sections);
+  for (i = 0; i < pool_cnt; i++) {
+    uint64_t delta = 0;
+    history_get_u64(&sections[HISTORY_POOLS], &delta);
+    pool += delta;
+    pools[i] = (uint32_t)pool;
+  }
+  //pool ids are checked by history_add_chunk
+  memset(seen, 0, pool_cnt);
+
+  for (i = 0; i < chunk->row_cnt; i++) {
+    udtswap_history_row_t *row = &history->scan_rows[*cnt];
+    uint64_t delta, local;
+    udtswap_quote_u128 deltas[3];
+    int k;
+    if (
+      history_get_u64(&sections[HISTORY_BLOCKS], &delta) != 0 ||
+      history_get_varint(&sections[HISTORY_TIMES], &v) != 0 ||
+      history_get_u64(&sections[HISTORY_POOL_INDEXES], &local) != 0 ||
+      local >= pool_cnt ||
+      sections[HISTORY_KINDS].p >= sections[HISTORY_KINDS].end
+    ) {
+      return UDTSWAP_HISTORY_ERROR_FORMAT;
+    }
+    block += delta;
+    time = (uint64_t)((udtswap_history_i128)time + history_unzigzag(v));
+    uint8_t kind = *sections[HISTORY_KINDS].p++;
+    if (kind & HISTORY_BASE_FLAG) {
+      for (k = 0; k < 3; k++) {
+        if (history_get_varint(&sections[HISTORY_BASES], &state[local][k]) != 0) {
+          return UDTSWAP_HISTORY_ERROR_FORMAT;
+        }
+      }
+    } else if (!seen[local]) {
+      return UDTSWAP_HISTORY_ERROR_FORMAT;
+    }
+    for (k = 0; k < 3; k++) {
+      if (history_get_varint(&sections[HISTORY_UDT1_DELTAS + k], &v) != 0) {
+        return UDTSWAP_HISTORY_ERROR_FORMAT;
+      }
+      deltas[k] = v;
+      if (!(kind & HISTORY_BASE_FLAG)) {
+        state[local][k] += (udtswap_quote_u128)history_unzigzag(v);
+      }
+    }
+    seen[local] = 1;
+    if (
+      (range->pool != UDTSWAP_HISTORY_ALL_POOLS && range->pool != pools[local]) ||
+      block < range->from_block || block > range->to_block || time < range->from_time || time > range->to_time
+    ) {
+      continue;
+    }
+    row->block_number = block;
+    row->timestamp = time;
+    row->pool = pools[local];
+    row->kind = kind & HISTORY_KIND_MASK;
+    row->udt1_reserve = state[local][0];
+    row->udt2_reserve = state[local][1];
+    row->total_liquidity = state[local][2];
+    row->udt1_delta = history_unzigzag(deltas[0]);
+    row->udt2_delta = history_unzigzag(deltas[1]);
+    row->liquidity_delta = history_unzigzag(deltas[2]);
+    *cnt += 1;
+  }
+  return 0;
+}
+
+/*
+ * history
+ */
+
+int udtswap_history_open(const char *path, udtswap_history_t **history) {
+  udtswap_history_t *h = calloc(1, sizeof(udtswap_history_t));
+  struct stat st;
+  uint8_t *file = NULL;
+  size_t size = 0, offset = 0;
+  int ret = 0;
+
+  *history = NULL;
+  if (h == NULL) {
+    return UDTSWAP_HISTORY_ERROR_ALLOC;
+  }
+  h->fd = -1;
+  h->rows = malloc(UDTSWAP_HISTORY_CHUNK_ROWS * sizeof(udtswap_history_row_t));
+  h->scan_rows = malloc(UDTSWAP_HISTORY_CHUNK_ROWS * sizeof(udtswap_history_row_t));
+  h->scan_pools = malloc(UDTSWAP_HISTORY_CHUNK_ROWS * sizeof(uint32_t));
+  h->scan_state = malloc(UDTSWAP_HISTORY_CHUNK_ROWS * sizeof(*h->scan_state));
+  h->scan_seen = malloc(UDTSWAP_HISTORY_CHUNK_ROWS);
+  if (h->rows == NULL || h->scan_rows == NULL || h->scan_pools == NULL || h->scan_state == NULL || h->scan_seen == NULL) {
+    udtswap_history_close(h);
+    return UDTSWAP_HISTORY_ERROR_ALLOC;
+  }
+  if (path == NULL) {
+    *history = h;
+    return 0;
+  }
+
+  h->fd = open(path, O_RDWR | O_CREAT | O_APPEND, 0644);
+  if (h->fd < 0 || fstat(h->fd, &st) != 0) {
+    udtswap_history_close(h);
+    return UDTSWAP_HISTORY_ERROR_IO;
+  }
+  size = (size_t)st.st_size;
+  file = malloc(size > 0 ? size : 1);
+  if (file == NULL) {
+    udtswap_history_close(h);
+    return UDTSWAP_HISTORY_ERROR_ALLOC;
+  }
+  while (offset < size) {
+    ssize_t n = pread(h->fd, file + offset, size - offset, (off_t)offset);
+    if (n <= 0) {
+      ret = UDTSWAP_HISTORY_ERROR_IO;
+      break;
+    }
+    offset += (size_t)n;
+  }
+
+  offset = 0;
+  while (ret == 0 && size - offset >= HISTORY_HEADER_SIZE) {
+    const uint8_t *header = file + offset;
+    size_t chunk_size = (size_t)history_get(header + 8, 4);
+    if (history_get(header, 4) != HISTORY_MAGIC || chunk_size < HISTORY_HEADER_SIZE) {
+      ret = UDTSWAP_HISTORY_ERROR_FORMAT;
+      break;
+    }
+    if (history_get(header + 4, 4) != UDTSWAP_HISTORY_VERSION) {
+      ret = UDTSWAP_HISTORY_ERROR_FORMAT;
+      break;
+    }
+    if (chunk_size > size - offset) {
+      break;
+    }
+    //torn chunk of an interrupted append
+    uint8_t *data = malloc(chunk_size);
+    if (data == NULL) {
+      ret = UDTSWAP_HISTORY_ERROR_ALLOC;
+      break;
+    }
+    memcpy(data, header, chunk_size);
+    ret = history_add_chunk(h, data, chunk_size, 1);
+    if (ret != 0) {
+      free(data);
+      break;
+    }
+    offset += chunk_size;
+  }
+  free(file);
+  if (ret == 0 && offset < size && ftruncate(h->fd, (off_t)offset) != 0) {
+    ret = UDTSWAP_HISTORY_ERROR_IO;
+  }
+  if (ret != 0) {
+    udtswap_history_close(h);
+    return ret;
+  }
+  *history = h;
+  return 0;
+}
+
+int udtswap_history_flush(udtswap_history_t *history) {
+  int ret = history_seal(history);
+  if (ret == 0 && history->fd >= 0 && fsync(history->fd) != 0) {
+    ret = UDTSWAP_HISTORY_ERROR_IO;
+  }
+  return ret;
+}
+
+int udtswap_history_close(udtswap_history_t *history) {
+  size_t i;
+  int ret = 0;
+  if (history == NULL) {
+    return 0;
+  }
+  if (history->rows != NULL && history->scan_pools != NULL) {
+    ret = udtswap_history_flush(history);
+  }
+  if (history->fd >= 0) {
+    close(history->fd);
+  }
+  for (i = 0; i < history->chunk_cnt; i++) {
+    free(history->chunks[i].data);
+  }
+  for (i = 0; i < history->pool_cnt; i++) {
+    free(history->pools[i].chunks);
+  }
+  free(history->chunks);
+  free(history->pools);
+  free(history->pool_hashes);
+  free(history->table);
+  free(history->rows);
+  free(history->scan_rows);
+  free(history->scan_pools);
+  free(history->scan_state);
+  free(history->scan_seen);
+  free(history);
+  return ret;
+}
+
+int udtswap_history_append(
+  udtswap_history_t *history,
+  uint64_t block_number,
+  uint64_t timestamp,
+  const uint8_t type_hash[UDTSWAP_ROUTE_HASH_SIZE],
+  const uint8_t *prev_data,
+  const uint8_t *data
+) {
+  udtswap_quote_u128 before[3] = {0, 0, 0};
+  udtswap_history_row_t *row;
+  uint32_t pool;
+  int ret;
+
+  if (history->has_rows && block_number < history->last_block) {
+    return UDTSWAP_HISTORY_ERROR_ORDER;
+  }
+  if (history->row_cnt == UDTSWAP_HISTORY_CHUNK_ROWS) {
+    ret = history_seal(history);
+    if (ret != 0) {
+      return ret;
+    }
+  }
+  ret = history_add_pool(history, type_hash, &pool);
+  if (ret != 0) {
+    return ret;
+  }
+  if (prev_data != NULL) {
+    before[0] = history_get_u128(prev_data + UDTSWAP_DATA_UDT1_RESERVE_START);
+    before[1] = history_get_u128(prev_data + UDTSWAP_DATA_UDT2_RESERVE_START);
+    before[2] = history_get_u128(prev_data + UDTSWAP_DATA_TOTAL_LIQUIDITY_START);
+  }
+  row = &history->rows[history->row_cnt];
+  row->block_number = block_number;
+  row->timestamp = timestamp;
+  row->pool = pool;
+  row->udt1_reserve = history_get_u128(data + UDTSWAP_DATA_UDT1_RESERVE_START);
+  row->udt2_reserve = history_get_u128(data + UDTSWAP_DATA_UDT2_RESERVE_START);
+  row->total_liquidity = history_get_u128(data + UDTSWAP_DATA_TOTAL_LIQUIDITY_START);
+  row->udt1_delta = (udtswap_history_i128)(row->udt1_reserve - before[0]);
+  row->udt2_delta = (udtswap_history_i128)(row->udt2_reserve - before[1]);
+  row->liquidity_delta = (udtswap_history_i128)(row->total_liquidity - before[2]);
+  if (prev_data == NULL) {
+    row->kind = UDTSWAP_HISTORY_CREATE;
+  } else if (row->liquidity_delta > 0) {
+    row->kind = UDTSWAP_HISTORY_ADD;
+  } else if (row->liquidity_delta < 0) {
+    row->kind = UDTSWAP_HISTORY_REMOVE;
+  } else if (row->udt1_delta > 0 && row->udt2_delta < 0) {
+    row->kind = UDTSWAP_HISTORY_SWAP_UDT1_INPUT;
+  } else if (row->udt1_delta < 0 && row->udt2_delta > 0) {
+    row->kind = UDTSWAP_HISTORY_SWAP_UDT2_INPUT;
+  } else {
+    row->kind = UDTSWAP_HISTORY_OTHER;
+  }
+  //swap keeps total liquidity, add and remove change it
+  history->row_cnt += 1;
+  history->has_rows = 1;
+  history->last_block = block_number;
+  return 0;
+}
+
+void udtswap_history_apply(void *ctx, const udtswap_ingest_delta_t *delta) {
+  udtswap_history_t *history = ctx;
+  if (history->error == 0) {
+    history->error = udtswap_history_append(
+      history, delta->block_number, delta->timestamp, delta->type_hash, delta->is_new ? NULL : delta->prev_data, delta->data
+    );
+  }
+}
+
+int udtswap_history_error(const udtswap_history_t *history) {
+  return history->error;
+}
+
+uint64_t udtswap_history_row_count(const udtswap_history_t *history) {
+  return history->sealed_row_cnt + history->row_cnt;
+}
+
+size_t udtswap_history_pool_count(const udtswap_history_t *history) {
+  return history->pool_cnt;
+}
+
+uint64_t udtswap_history_size(const udtswap_history_t *history) {
+  return history->size;
+}
+
+/*
+ * scans
+ */
+
+static int history_chunk_in(const history_chunk_t *chunk, const udtswap_history_range_t *range) {
+  return chunk->first_block <= range->to_block && chunk->last_block >= range->from_block &&
+    chunk->min_time <= range->to_time && chunk->max_time >= range->from_time;
+}
+
+int udtswap_history_scan(
+  udtswap_history_t *history,
+  const udtswap_history_range_t *range,
+  int (*visit)(void *ctx, const udtswap_history_row_t *rows, size_t cnt),
+  void *ctx
+) {
+  const uint32_t *ids = NULL;
+  size_t cnt, lo = 0, hi, i;
+  int ret;
+
+  if (range->pool != UDTSWAP_HISTORY_ALL_POOLS) {
+    if (range->pool >= history->pool_cnt) {
+      return UDTSWAP_HISTORY_ERROR_POOL;
+    }
+    ids = history->pools[range->pool].chunks;
+    cnt = history->pools[range->pool].cnt;
+  } else {
+    cnt = history->chunk_cnt;
+  }
+  hi = cnt;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (history->chunks[ids == NULL ? mid : ids[mid]].last_block < range->from_block) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  //chunks are in block order, first chunk of range by binary search
+  for (i = lo; i < cnt; i++) {
+    const history_chunk_t *chunk = &history->chunks[ids == NULL ? i : ids[i]];
+    size_t rows;
+    if (chunk->first_block > range->to_block) {
+      break;
+    }
+    if (!history_chunk_in(chunk, range)) {
+      continue;
+    }
+    ret = history_decode(history, chunk, range, &rows);
+    if (ret != 0) {
+      return ret;
+    }
+    if (rows > 0 && (ret = visit(ctx, history->scan_rows, rows)) != 0) {
+      return ret;
+    }
+  }
+
+  cnt = 0;
+  for (i = 0; i < history->row_cnt; i++) {
+    const udtswap_history_row_t *row = &history->rows[i];
+    if (
+      (range->pool == UDTSWAP_HISTORY_ALL_POOLS || range->pool == row->pool) &&
+      row->block_number >= range->from_block && row->block_number <= range->to_block &&
+      row->timestamp >= range->from_time && row->timestamp <= range->to_time
+    ) {
+      history->scan_rows[cnt++] = *row;
+    }
+  }
+  //open rows last, they follow every sealed chunk
+  return cnt > 0 ? visit(ctx, history->scan_rows, cnt) : 0;
+}
+
+static udtswap_quote_u128 history_fee(udtswap_quote_u128 input) {
+  udtswap_quote_u128 kept = input / HISTORY_FEE_BASE * LIQUIDITY_POOL_EXCEPT_FEE +
+    input % HISTORY_FEE_BASE * LIQUIDITY_POOL_EXCEPT_FEE / HISTORY_FEE_BASE;
+  return input - kept;
+}
+//input * 997 / 1000 of the swap formula without overflow
+
+static int history_stats_visit(void *ctx, const udtswap_history_row_t *rows, size_t cnt) {
+  udtswap_history_stats_t *stats = ctx;
+  size_t i;
+  for (i = 0; i < cnt; i++) {
+    const udtswap_history_row_t *row = &rows[i];
+    if (stats->row_cnt == 0) {
+      stats->first_block = row->block_number;
+    }
+    stats->row_cnt += 1;
+    stats->last_block = row->block_number;
+    stats->udt1_reserve = row->udt1_reserve;
+    stats->udt2_reserve = row->udt2_reserve;
+    stats->total_liquidity = row->total_liquidity;
+    switch (row->kind) {
+      case UDTSWAP_HISTORY_SWAP_UDT1_INPUT:
+        stats->swap_cnt += 1;
+        stats->udt1_volume += (udtswap_quote_u128)row->udt1_delta;
+        stats->udt1_fee += history_fee((udtswap_quote_u128)row->udt1_delta);
+        break;
+      case UDTSWAP_HISTORY_SWAP_UDT2_INPUT:
+        stats->swap_cnt += 1;
+        stats->udt2_volume += (udtswap_quote_u128)row->udt2_delta;
+        stats->udt2_fee += history_fee((udtswap_quote_u128)row->udt2_delta);
+        break;
+      case UDTSWAP_HISTORY_ADD:
+        stats->add_cnt += 1;
+        break;
+      case UDTSWAP_HISTORY_REMOVE:
+        stats->remove_cnt += 1;
+        break;
+    }
+  }
+  return 0;
+}
+
+int udtswap_history_stats(
+  udtswap_history_t *history,
+  const udtswap_history_range_t *range,
+  udtswap_history_stats_t *stats
+) {
+  memset(stats, 0, sizeof(udtswap_history_stats_t));
+  return udtswap_history_scan(history, range, history_stats_visit, stats);
+}
+//reserves of stats are of the last row, meaningful for a range of one pool
@@ -0,0 +1,147 @@
+#ifndef UDTSWAP_HISTORY_H_
+#define UDTSWAP_HISTORY_H_
+
+/*
+ * pool transition history, part of quote library
+ *
+ * a row is a transition of one pool, pool data before and after a UDTswap transaction:
+ * kind (create, swap of either direction, add or remove liquidity) is derived from the deltas of reserves and liquidity
+ * rows are appended in block order into chunks of UDTSWAP_HISTORY_CHUNK_ROWS rows,
+ * a full chunk is compressed column by column and appended to the history file, the file is never rewritten
+ *
+ * columns of a chunk : block number and timestamp (deltas), pool (index of pools of the chunk), kind,
+ * reserves and liquidity after the transition (only for first row of a pool in the chunk), deltas (zigzag varints)
+ * chunks keep block and time ranges and their pools, so range scans skip chunks out of range or without the pool
+ */
+#include <stddef.h>
+#include <stdint.h>
+#include "udtswap_quote.h"
+#include "udtswap_route.h"
+#include "udtswap_ingest.h"
+
+#define UDTSWAP_HISTORY_VERSION 1
+#define UDTSWAP_HISTORY_CHUNK_ROWS 4096
+#define UDTSWAP_HISTORY_ALL_POOLS UINT32_MAX
+
+#define UDTSWAP_HISTORY_CREATE 0
+#define UDTSWAP_HISTORY_SWAP_UDT1_INPUT 1
+#define UDTSWAP_HISTORY_SWAP_UDT2_INPUT 2
+#define UDTSWAP_HISTORY_ADD 3
+#define UDTSWAP_HISTORY_REMOVE 4
+#define UDTSWAP_HISTORY_OTHER 5
+
+#define UDTSWAP_HISTORY_ERROR_IO -1
+#define UDTSWAP_HISTORY_ERROR_FORMAT -2
+#define UDTSWAP_HISTORY_ERROR_ALLOC -3
+#define UDTSWAP_HISTORY_ERROR_ORDER -4
+#define UDTSWAP_HISTORY_ERROR_POOL -5
+
+typedef __int128 udtswap_history_i128;
+typedef struct udtswap_history udtswap_history_t;
+
+/*
+ * reserves and liquidity are values of pool data after the transition (stored reserve, actual reserve + default)
+ * deltas are after - before, pool is pool id of history
+ */
+typedef struct {
+  uint64_t block_number;
+  uint64_t timestamp;
+  uint32_t pool;
+  int kind;
+  udtswap_quote_u128 udt1_reserve;
+  udtswap_quote_u128 udt2_reserve;
+  udtswap_quote_u128 total_liquidity;
+  udtswap_history_i128 udt1_delta;
+  udtswap_history_i128 udt2_delta;
+  udtswap_history_i128 liquidity_delta;
+} udtswap_history_row_t;
+
+/* inclusive block and time range of pool, or of every pool */
+typedef struct {
+  uint32_t pool;
+  uint64_t from_block;
+  uint64_t to_block;
+  uint64_t from_time;
+  uint64_t to_time;
+} udtswap_history_range_t;
+
+/*
+ * swaps, adds and removes of a range
+ * volumes are swap inputs, fees are the shares of inputs left to liquidity providers (1 - 997 / 1000),
+ * reserves and liquidity are after last row of the range
+ */
+typedef struct {
+  uint64_t row_cnt;
+  uint64_t swap_cnt;
+  uint64_t add_cnt;
+  uint64_t remove_cnt;
+  udtswap_quote_u128 udt1_volume;
+  udtswap_quote_u128 udt2_volume;
+  udtswap_quote_u128 udt1_fee;
+  udtswap_quote_u128 udt2_fee;
+  uint64_t first_block;
+  uint64_t last_block;
+  udtswap_quote_u128 udt1_reserve;
+  udtswap_quote_u128 udt2_reserve;
+  udtswap_quote_u128 total_liquidity;
+} udtswap_history_stats_t;
+
+/*
+ * history of file path, chunks of an existing file are loaded and new chunks are appended to it
+ * NULL path is a history in memory, a torn chunk at the end of file is cut off
+ */
+UDTSWAP_QUOTE_API int udtswap_history_open(const char *path, udtswap_history_t **history);
+
+/* rows of the open chunk are written as a last chunk, close flushes too */
+UDTSWAP_QUOTE_API int udtswap_history_flush(udtswap_history_t *history);
+UDTSWAP_QUOTE_API int udtswap_history_close(udtswap_history_t *history);
+
+/*
+ * transition of pool of type hash, prev_data NULL for a new pool, data of 48 bytes or longer
+ * block numbers are not decreasing, UDTSWAP_HISTORY_ERROR_ORDER otherwise
+ */
+UDTSWAP_QUOTE_API int udtswap_history_append(
+  udtswap_history_t *history,
+  uint64_t block_number,
+  uint64_t timestamp,
+  const uint8_t type_hash[UDTSWAP_ROUTE_HASH_SIZE],
+  const uint8_t *prev_data,
+  const uint8_t *data
+);
+
+/* apply callback of udtswap_ingest_options_t, ctx is history, first error is kept by udtswap_history_error */
+UDTSWAP_QUOTE_API void udtswap_history_apply(void *ctx, const udtswap_ingest_delta_t *delta);
+UDTSWAP_QUOTE_API int udtswap_history_error(const udtswap_history_t *history);
+
+UDTSWAP_QUOTE_API uint64_t udtswap_history_row_count(const udtswap_history_t *history);
+UDTSWAP_QUOTE_API size_t udtswap_history_pool_count(const udtswap_history_t *history);
+
+/* pool id of type hash, UDTSWAP_HISTORY_ERROR_POOL when pool has no rows */
+UDTSWAP_QUOTE_API int udtswap_history_pool(
+  const udtswap_history_t *history,
+  const uint8_t type_hash[UDTSWAP_ROUTE_HASH_SIZE],
+  uint32_t *pool
+);
+UDTSWAP_QUOTE_API const uint8_t *udtswap_history_pool_hash(const udtswap_history_t *history, uint32_t pool);
+
+/*
+ * rows of range in append order, given to visit in batches, valid during the call
+ * scan stops when visit returns non zero and returns it
+ */
+UDTSWAP_QUOTE_API int udtswap_history_scan(
+  udtswap_history_t *history,
+  const udtswap_history_range_t *range,
+  int (*visit)(void *ctx, const udtswap_history_row_t *rows, size_t cnt),
+  void *ctx
+);
+
+UDTSWAP_QUOTE_API int udtswap_history_stats(
+  udtswap_history_t *history,
+  const udtswap_history_range_t *range,
+  udtswap_history_stats_t *stats
+);
+
+/* bytes of sealed chunks, of file or memory */
+UDTSWAP_QUOTE_API uint64_t udtswap_history_size(const udtswap_history_t *history);
+
+#endif /* UDTSWAP_HISTORY_H_ */
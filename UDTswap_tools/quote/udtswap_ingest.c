@@ -0,0 +1,548 @@
+/*
+ * block ingestion of UDTswap pools
+ * blocks are claimed by decode threads in block order, a block is decoded into the slot of its number
+ * modulo window, and the calling thread applies slots in block order as they become ready
+ * decode threads wait while they are window blocks ahead of the applied block, so memory of deltas is bounded
+ */
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "../../UDTswap_scripts/udtswap_common.h"
+#include "../../UDTswap_scripts/protocol.h"
+#include "../blake2b.h"
+#include "udtswap_ingest.h"
+
+#define INGEST_HASH_TYPE_TYPE 1
+#define INGEST_WINDOW_PER_THREAD 64
+#define INGEST_EMPTY UINT32_MAX
+
+struct udtswap_ingest {
+  uint8_t type_code_hash[UDTSWAP_ROUTE_HASH_SIZE];
+  uint8_t lock_code_hash[UDTSWAP_ROUTE_HASH_SIZE];
+  udtswap_snapshot_record_t *pools;
+  size_t pool_cnt;
+  size_t pool_cap;
+  uint32_t *table;
+  size_t table_size;
+  int has_tip;
+  uint64_t tip_number;
+  uint8_t tip_hash[UDTSWAP_ROUTE_HASH_SIZE];
+  uint64_t block_cnt;
+};
+//table is open addressing of pool index by type hash, size is a power of 2
+
+typedef struct {
+  udtswap_ingest_delta_t *deltas;
+  size_t delta_cnt;
+  size_t delta_cap;
+  uint64_t number;
+  uint64_t timestamp;
+  uint8_t hash[UDTSWAP_ROUTE_HASH_SIZE];
+  uint8_t parent_hash[UDTSWAP_ROUTE_HASH_SIZE];
+  int ret;
+  int ready;
+} ingest_slot_t;
+
+typedef struct {
+  const udtswap_ingest_t *ingest;
+  const uint8_t *const *blocks;
+  const size_t *lens;
+  size_t cnt;
+  ingest_slot_t *slots;
+  size_t window;
+  size_t next;
+  size_t applied;
+  int stop;
+  pthread_mutex_t lock;
+  pthread_cond_t ready_cond;
+  pthread_cond_t space_cond;
+} ingest_pipeline_t;
+
+static void ingest_put(uint8_t *p, uint64_t v, int len) {
+  int i;
+  for (i = 0; i < len; i++) {
+    p[i] = (uint8_t)(v >> (8 * i));
+  }
+}
+
+static uint64_t ingest_get(const uint8_t *p, int len) {
+  uint64_t v = 0;
+  int i;
+  for (i = len - 1; i >= 0; i--) {
+    v = (v << 8) | p[i];
+  }
+  return v;
+}
+
+udtswap_ingest_t *udtswap_ingest_new(void) {
+  udtswap_ingest_t *ingest = calloc(1, sizeof(udtswap_ingest_t));
+  if (ingest == NULL) {
+    return NULL;
+  }
+  memcpy(ingest->type_code_hash, udtswap_type_script_code_hash_buf, UDTSWAP_ROUTE_HASH_SIZE);
+  memcpy(ingest->lock_code_hash, udtswap_lock_code_hash_buf, UDTSWAP_ROUTE_HASH_SIZE);
+  return ingest;
+}
+
+void udtswap_ingest_free(udtswap_ingest_t *ingest) {
+  if (ingest == NULL) {
+    return;
+  }
+  free(ingest->pools);
+  free(ingest->table);
+  free(ingest);
+}
+
+void udtswap_ingest_set_code_hashes(
+  udtswap_ingest_t *ingest,
+  const uint8_t type_code_hash[UDTSWAP_ROUTE_HASH_SIZE],
+  const uint8_t lock_code_hash[UDTSWAP_ROUTE_HASH_SIZE]
+) {
+  memcpy(ingest->type_code_hash, type_code_hash, UDTSWAP_ROUTE_HASH_SIZE);
+  memcpy(ingest->lock_code_hash, lock_code_hash, UDTSWAP_ROUTE_HASH_SIZE);
+}
+
+/*
+ * pool table
+ */
+
+static size_t ingest_slot_of(const udtswap_ingest_t *ingest, const uint8_t type_hash[UDTSWAP_ROUTE_HASH_SIZE]) {
+  size_t mask = ingest->table_size - 1;
+  size_t i = (size_t)ingest_get(type_hash, 8) & mask;
+  while (ingest->table[i] != INGEST_EMPTY) {
+    if (memcmp(ingest->pools[ingest->table[i]].type_hash, type_hash, UDTSWAP_ROUTE_HASH_SIZE) == 0) {
+      break;
+    }
+    i = (i + 1) & mask;
+  }
+  return i;
+}
+//type hash is a blake2b hash, its first bytes are uniform
+
+static int ingest_grow(udtswap_ingest_t *ingest) {
+  size_t i, size = ingest->table_size == 0 ? 1024 : ingest->table_size * 2;
+  uint32_t *table = malloc(size * sizeof(uint32_t));
+  udtswap_snapshot_record_t *pools = realloc(ingest->pools, size / 2 * sizeof(udtswap_snapshot_record_t));
+  if (table == NULL || pools == NULL) {
+    free(table);
+    if (pools != NULL) {
+      ingest->pools = pools;
+    }
+    return UDTSWAP_INGEST_ERROR_ALLOC;
+  }
+  free(ingest->table);
+  ingest->pools = pools;
+  ingest->pool_cap = size / 2;
+  ingest->table = table;
+  ingest->table_size = size;
+  for (i = 0; i < size; i++) {
+    table[i] = INGEST_EMPTY;
+  }
+  for (i = 0; i < ingest->pool_cnt; i++) {
+    table[ingest_slot_of(ingest, pools[i].type_hash)] = (uint32_t)i;
+  }
+  return 0;
+}
+//load factor is at most 1/2
+
+static int ingest_pool(
+  udtswap_ingest_t *ingest,
+  const uint8_t type_hash[UDTSWAP_ROUTE_HASH_SIZE],
+  udtswap_snapshot_record_t **pool,
+  int *is_new
+) {
+  size_t i;
+  if (ingest->pool_cnt == ingest->pool_cap) {
+    int ret = ingest_grow(ingest);
+    if (ret != 0) {
+      return ret;
+    }
+  }
+  i = ingest_slot_of(ingest, type_hash);
+  *is_new = ingest->table[i] == INGEST_EMPTY;
+  if (*is_new) {
+    ingest->table[i] = (uint32_t)ingest->pool_cnt;
+    memset(&ingest->pools[ingest->pool_cnt], 0, sizeof(udtswap_snapshot_record_t));
+    memcpy(ingest->pools[ingest->pool_cnt].type_hash, type_hash, UDTSWAP_ROUTE_HASH_SIZE);
+    ingest->pool_cnt += 1;
+  }
+  *pool = &ingest->pools[ingest->table[i]];
+  return 0;
+}
+
+int udtswap_ingest_load_snapshot(udtswap_ingest_t *ingest, const udtswap_snapshot_t *snapshot) {
+  udtswap_snapshot_record_t *pool;
+  size_t i;
+  int is_new, ret;
+  for (i = 0; i < snapshot->pool_cnt; i++) {
+    const udtswap_snapshot_record_t *record = udtswap_snapshot_record(snapshot, i);
+    ret = ingest_pool(ingest, record->type_hash, &pool, &is_new);
+    if (ret != 0) {
+      return ret;
+    }
+    memcpy(pool, record, sizeof(udtswap_snapshot_record_t));
+  }
+  ingest->has_tip = 1;
+  ingest->tip_number = snapshot->tip_number;
+  memcpy(ingest->tip_hash, snapshot->tip_hash, UDTSWAP_ROUTE_HASH_SIZE);
+  return 0;
+}
+
+/*
+ * decode of a block, by decode threads
+ */
+
+static udtswap_ingest_delta_t *ingest_push(ingest_slot_t *slot) {
+  if (slot->delta_cnt == slot->delta_cap) {
+    size_t cap = slot->delta_cap == 0 ? 16 : slot->delta_cap * 2;
+    udtswap_ingest_delta_t *deltas = realloc(slot->deltas, cap * sizeof(udtswap_ingest_delta_t));
+    if (deltas == NULL) {
+      return NULL;
+    }
+    slot->deltas = deltas;
+    slot->delta_cap = cap;
+  }
+  return &slot->deltas[slot->delta_cnt++];
+}
+
+static int ingest_script_is(const mol_seg_t *script, const uint8_t code_hash[UDTSWAP_ROUTE_HASH_SIZE], mol_seg_t *args) {
+  mol_seg_t code_hash_seg = MolReader_Script_get_code_hash(script);
+  mol_seg_t hash_type_seg = MolReader_Script_get_hash_type(script);
+  mol_seg_t args_seg = MolReader_Script_get_args(script);
+  if (hash_type_seg.ptr[0] != INGEST_HASH_TYPE_TYPE || memcmp(code_hash_seg.ptr, code_hash, UDTSWAP_ROUTE_HASH_SIZE) != 0) {
+    return 0;
+  }
+  *args = MolReader_Bytes_raw_bytes(&args_seg);
+  return 1;
+}
+
+static int ingest_decode(const udtswap_ingest_t *ingest, const uint8_t *block, size_t len, ingest_slot_t *slot) {
+  mol_seg_t block_seg = {(uint8_t *)block, (mol_num_t)len};
+  mol_num_t t, o;
+
+  slot->delta_cnt = 0;
+  if (len < MOL_NUM_T_SIZE || len > UINT32_MAX || MolReader_Block_verify(&block_seg, true) != MOL_OK) {
+    return UDTSWAP_INGEST_ERROR_FORMAT;
+  }
+  mol_seg_t header = MolReader_Block_get_header(&block_seg);
+  mol_seg_t raw_header = MolReader_Header_get_raw(&header);
+  mol_seg_t number = MolReader_RawHeader_get_number(&raw_header);
+  mol_seg_t timestamp = MolReader_RawHeader_get_timestamp(&raw_header);
+  mol_seg_t parent_hash = MolReader_RawHeader_get_parent_hash(&raw_header);
+  slot->number = ingest_get(number.ptr, 8);
+  slot->timestamp = ingest_get(timestamp.ptr, 8);
+  memcpy(slot->parent_hash, parent_hash.ptr, UDTSWAP_ROUTE_HASH_SIZE);
+  blake2b_hash(header.ptr, header.size, slot->hash);
+
+  mol_seg_t txs = MolReader_Block_get_transactions(&block_seg);
+  mol_num_t tx_cnt = MolReader_TransactionVec_length(&txs);
+  for (t = 0; t < tx_cnt; t++) {
+    mol_seg_t tx = MolReader_TransactionVec_get(&txs, t).seg;
+    mol_seg_t raw_tx = MolReader_Transaction_get_raw(&tx);
+    mol_seg_t outputs = MolReader_RawTransaction_get_outputs(&raw_tx);
+    mol_seg_t outputs_data = MolReader_RawTransaction_get_outputs_data(&raw_tx);
+    mol_num_t output_cnt = MolReader_CellOutputVec_length(&outputs);
+    uint8_t tx_hash[UDTSWAP_ROUTE_HASH_SIZE];
+    int hashed = 0;
+    if (MolReader_BytesVec_length(&outputs_data) != output_cnt) {
+      return UDTSWAP_INGEST_ERROR_FORMAT;
+    }
+    for (o = 0; o < output_cnt; o++) {
+      mol_seg_t output = MolReader_CellOutputVec_get(&outputs, o).seg;
+      mol_seg_t type = MolReader_CellOutput_get_type_(&output);
+      mol_seg_t lock = MolReader_CellOutput_get_lock(&output);
+      mol_seg_t type_args, lock_args;
+      if (MolReader_ScriptOpt_is_none(&type) || !ingest_script_is(&type, ingest->type_code_hash, &type_args)) {
+        continue;
+      }
+      if (!ingest_script_is(&lock, ingest->lock_code_hash, &lock_args) || lock_args.size != UDTSWAP_ROUTE_LOCK_ARGS_SIZE) {
+        continue;
+      }
+      mol_seg_t data_seg = MolReader_BytesVec_get(&outputs_data, o).seg;
+      mol_seg_t data = MolReader_Bytes_raw_bytes(&data_seg);
+      if (data.size < UDTSWAP_DATA_SIZE) {
+        continue;
+      }
+      if (!hashed) {
+        blake2b_hash(raw_tx.ptr, raw_tx.size, tx_hash);
+        hashed = 1;
+      }
+      //transaction hash of UDTswap transactions only
+
+      udtswap_ingest_delta_t *delta = ingest_push(slot);
+      if (delta == NULL) {
+        return UDTSWAP_INGEST_ERROR_ALLOC;
+      }
+      delta->block_number = slot->number;
+      delta->timestamp = slot->timestamp;
+      delta->tx_index = t;
+      delta->output_index = o;
+      memcpy(delta->tx_hash, tx_hash, UDTSWAP_ROUTE_HASH_SIZE);
+      blake2b_hash(type.ptr, type.size, delta->type_hash);
+      memcpy(delta->lock_args, lock_args.ptr, UDTSWAP_ROUTE_LOCK_ARGS_SIZE);
+      memcpy(delta->data, data.ptr, UDTSWAP_SNAPSHOT_DATA_SIZE);
+    }
+  }
+  return 0;
+}
+//block is verified before any field is read, so slices of a malformed block are never out of it
+
+/*
+ * apply of a decoded block, by calling thread in block order
+ */
+
+static int ingest_apply(udtswap_ingest_t *ingest, ingest_slot_t *slot, const udtswap_ingest_options_t *options) {
+  size_t i;
+  if (ingest->has_tip && (
+    slot->number != ingest->tip_number + 1 ||
+    memcmp(slot->parent_hash, ingest->tip_hash, UDTSWAP_ROUTE_HASH_SIZE) != 0
+  )) {
+    return UDTSWAP_INGEST_ERROR_CHAIN;
+  }
+  for (i = 0; i < slot->delta_cnt; i++) {
+    udtswap_ingest_delta_t *delta = &slot->deltas[i];
+    udtswap_snapshot_record_t *pool;
+    int ret = ingest_pool(ingest, delta->type_hash, &pool, &delta->is_new);
+    if (ret != 0) {
+      return ret;
+    }
+    if (delta->is_new) {
+      memset(delta->prev_data, 0, UDTSWAP_SNAPSHOT_DATA_SIZE);
+    } else {
+      memcpy(delta->prev_data, pool->data, UDTSWAP_SNAPSHOT_DATA_SIZE);
+    }
+    memcpy(pool->lock_args, delta->lock_args, UDTSWAP_ROUTE_LOCK_ARGS_SIZE);
+    memcpy(pool->tx_hash, delta->tx_hash, UDTSWAP_ROUTE_HASH_SIZE);
+    ingest_put(pool->index, delta->output_index, sizeof(pool->index));
+    memcpy(pool->data, delta->data, UDTSWAP_SNAPSHOT_DATA_SIZE);
+    if (options->apply != NULL) {
+      options->apply(options->ctx, delta);
+    }
+  }
+  ingest->has_tip = 1;
+  ingest->tip_number = slot->number;
+  memcpy(ingest->tip_hash, slot->hash, UDTSWAP_ROUTE_HASH_SIZE);
+  ingest->block_cnt += 1;
+  return 0;
+}
+//pool cells are not destroyed by UDTswap transactions, output of latest transaction is the live pool cell
+
+static void *ingest_worker(void *arg) {
+  ingest_pipeline_t *pipeline = arg;
+  for (;;) {
+    pthread_mutex_lock(&pipeline->lock);
+    while (!pipeline->stop && pipeline->next < pipeline->cnt && pipeline->next >= pipeline->applied + pipeline->window) {
+      pthread_cond_wait(&pipeline->space_cond, &pipeline->lock);
+    }
+    if (pipeline->stop || pipeline->next >= pipeline->cnt) {
+      pthread_mutex_unlock(&pipeline->lock);
+      return NULL;
+    }
+    size_t i = pipeline->next++;
+    pthread_mutex_unlock(&pipeline->lock);
+
+    ingest_slot_t *slot = &pipeline->slots[i % pipeline->window];
+    slot->ret = ingest_decode(pipeline->ingest, pipeline->blocks[i], pipeline->lens[i], slot);
+
+    pthread_mutex_lock(&pipeline->lock);
+    slot->ready = 1;
+    pthread_cond_signal(&pipeline->ready_cond);
+    pthread_mutex_unlock(&pipeline->lock);
+  }
+}
+//slot of block i is free, block i - window is applied before block i is claimed
+
+int udtswap_ingest_blocks(
+  udtswap_ingest_t *ingest,
+  const uint8_t *const blocks[],
+  const size_t lens[],
+  size_t cnt,
+  const udtswap_ingest_options_t *options
+) {
+  udtswap_ingest_options_t defaults = {0, 0, NULL, NULL};
+  ingest_pipeline_t pipeline;
+  pthread_t *threads;
+  size_t i, thread_cnt, started = 0;
+  int ret = 0;
+
+  if (cnt == 0) {
+    return 0;
+  }
+  if (options == NULL) {
+    options = &defaults;
+  }
+  if (options->threads > 0) {
+    thread_cnt = (size_t)options->threads;
+  } else {
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    thread_cnt = cores > 0 ? (size_t)cores : 1;
+  }
+  memset(&pipeline, 0, sizeof(pipeline));
+  pipeline.ingest = ingest;
+  pipeline.blocks = blocks;
+  pipeline.lens = lens;
+  pipeline.cnt = cnt;
+  pipeline.window = options->window > 0 ? options->window : INGEST_WINDOW_PER_THREAD * thread_cnt;
+  if (pipeline.window > cnt) {
+    pipeline.window = cnt;
+  }
+  if (thread_cnt > pipeline.window) {
+    thread_cnt = pipeline.window;
+  }
+  pipeline.slots = calloc(pipeline.window, sizeof(ingest_slot_t));
+  threads = malloc(thread_cnt * sizeof(pthread_t));
+  if (pipeline.slots == NULL || threads == NULL) {
+    free(pipeline.slots);
+    free(threads);
+    return UDTSWAP_INGEST_ERROR_ALLOC;
+  }
+  pthread_mutex_init(&pipeline.lock, NULL);
+  pthread_cond_init(&pipeline.ready_cond, NULL);
+  pthread_cond_init(&pipeline.space_cond, NULL);
+
+  for (started = 0; started < thread_cnt; started++) {
+    if (pthread_create(&threads[started], NULL, ingest_worker, &pipeline) != 0) {
+      ret = UDTSWAP_INGEST_ERROR_THREAD;
+      break;
+    }
+  }
+
+  for (i = 0; i < cnt && ret == 0; i++) {
+    ingest_slot_t *slot = &pipeline.slots[i % pipeline.window];
+    pthread_mutex_lock(&pipeline.lock);
+    while (!slot->ready) {
+      pthread_cond_wait(&pipeline.ready_cond, &pipeline.lock);
+    }
+    pthread_mutex_unlock(&pipeline.lock);
+
+    ret = slot->ret != 0 ? slot->ret : ingest_apply(ingest, slot, options);
+
+    pthread_mutex_lock(&pipeline.lock);
+    slot->ready = 0;
+    pipeline.applied = i + 1;
+    pthread_cond_broadcast(&pipeline.space_cond);
+    pthread_mutex_unlock(&pipeline.lock);
+  }
+  //a block is applied after its slot is ready, slot is reused after the block is applied
+
+  pthread_mutex_lock(&pipeline.lock);
+  pipeline.stop = 1;
+  pthread_cond_broadcast(&pipeline.space_cond);
+  pthread_mutex_unlock(&pipeline.lock);
+  for (i = 0; i < started; i++) {
+    pthread_join(threads[i], NULL);
+  }
+  //workers of a failed ingestion stop after their current block
+
+  for (i = 0; i < pipeline.window; i++) {
+    free(pipeline.slots[i].deltas);
+  }
+  free(pipeline.slots);
+  free(threads);
+  pthread_cond_destroy(&pipeline.space_cond);
+  pthread_cond_destroy(&pipeline.ready_cond);
+  pthread_mutex_destroy(&pipeline.lock);
+  return ret;
+}
+
+int udtswap_ingest_file(udtswap_ingest_t *ingest, const char *path, const udtswap_ingest_options_t *options) {
+  struct stat st;
+  const uint8_t **blocks = NULL;
+  size_t *lens = NULL;
+  size_t cnt = 0, cap = 0, offset = 0;
+  int ret = 0;
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    return UDTSWAP_INGEST_ERROR_IO;
+  }
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    return UDTSWAP_INGEST_ERROR_IO;
+  }
+  if (st.st_size == 0) {
+    close(fd);
+    return 0;
+  }
+  size_t size = (size_t)st.st_size;
+  uint8_t *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) {
+    return UDTSWAP_INGEST_ERROR_IO;
+  }
+  madvise(map, size, MADV_SEQUENTIAL);
+
+  while (offset < size && ret == 0) {
+    size_t len = size - offset < MOL_NUM_T_SIZE ? 0 : (size_t)ingest_get(map + offset, MOL_NUM_T_SIZE);
+    if (len < MOL_NUM_T_SIZE || len > size - offset) {
+      ret = UDTSWAP_INGEST_ERROR_FORMAT;
+      break;
+    }
+    if (cnt == cap) {
+      size_t new_cap = cap == 0 ? 1024 : cap * 2;
+      const uint8_t **new_blocks = realloc(blocks, new_cap * sizeof(uint8_t *));
+      size_t *new_lens = new_blocks == NULL ? NULL : realloc(lens, new_cap * sizeof(size_t));
+      if (new_blocks != NULL) {
+        blocks = new_blocks;
+      }
+      if (new_lens == NULL) {
+        ret = UDTSWAP_INGEST_ERROR_ALLOC;
+        break;
+      }
+      lens = new_lens;
+      cap = new_cap;
+    }
+    blocks[cnt] = map + offset;
+    lens[cnt] = len;
+    cnt += 1;
+    offset += len;
+  }
+  //total size of a molecule table is its first number, blocks are split by it
+  if (ret == 0) {
+    ret = udtswap_ingest_blocks(ingest, blocks, lens, cnt, options);
+  }
+  free(blocks);
+  free(lens);
+  munmap(map, size);
+  return ret;
+}
+
+int udtswap_ingest_tip(const udtswap_ingest_t *ingest, uint64_t *number, uint8_t hash[UDTSWAP_ROUTE_HASH_SIZE]) {
+  if (!ingest->has_tip) {
+    return 0;
+  }
+  *number = ingest->tip_number;
+  memcpy(hash, ingest->tip_hash, UDTSWAP_ROUTE_HASH_SIZE);
+  return 1;
+}
+
+uint64_t udtswap_ingest_block_count(const udtswap_ingest_t *ingest) {
+  return ingest->block_cnt;
+}
+
+size_t udtswap_ingest_pool_count(const udtswap_ingest_t *ingest) {
+  return ingest->pool_cnt;
+}
+
+const udtswap_snapshot_record_t *udtswap_ingest_pools(const udtswap_ingest_t *ingest) {
+  return ingest->pools;
+}
+
+int udtswap_ingest_write_snapshot(const udtswap_ingest_t *ingest, const char *path) {
+  udtswap_snapshot_record_t *records = malloc((ingest->pool_cnt > 0 ? ingest->pool_cnt : 1) * sizeof(udtswap_snapshot_record_t));
+  int ret;
+  if (records == NULL) {
+    return UDTSWAP_SNAPSHOT_ERROR_ALLOC;
+  }
+  if (ingest->pool_cnt > 0) {
+    memcpy(records, ingest->pools, ingest->pool_cnt * sizeof(udtswap_snapshot_record_t));
+  }
+  ret = udtswap_snapshot_write(path, ingest->tip_number, ingest->tip_hash, records, ingest->pool_cnt);
+  free(records);
+  return ret;
+}
+//snapshot write sorts records, pool table keeps its order
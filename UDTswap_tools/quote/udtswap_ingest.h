@@ -0,0 +1,97 @@
+#ifndef UDTSWAP_INGEST_H_
+#define UDTSWAP_INGEST_H_
+
+/*
+ * block ingestion of UDTswap pools, part of quote library
+ *
+ * blocks are molecule Blocks of a node, read from memory or from a file of concatenated blocks
+ * decode threads verify blocks and find pool cells (UDTswap type and lock code hash, 64 bytes lock args,
+ * 48 bytes data or extended) in outputs of transactions, ahead of the applied block up to a window of blocks
+ * the calling thread applies pool deltas of blocks in block order, checks parent hash of every block,
+ * keeps the live pool table and calls apply callback of options
+ */
+#include <stddef.h>
+#include <stdint.h>
+#include "udtswap_quote.h"
+#include "udtswap_route.h"
+#include "udtswap_snapshot.h"
+
+#define UDTSWAP_INGEST_ERROR_ALLOC -1
+#define UDTSWAP_INGEST_ERROR_IO -2
+#define UDTSWAP_INGEST_ERROR_FORMAT -3
+#define UDTSWAP_INGEST_ERROR_CHAIN -4
+#define UDTSWAP_INGEST_ERROR_THREAD -5
+
+typedef struct udtswap_ingest udtswap_ingest_t;
+
+/*
+ * new state of a pool cell, output index of transaction tx index of block
+ * timestamp is of block header, prev_data is pool data before the transaction, zero for a new pool
+ */
+typedef struct {
+  uint64_t block_number;
+  uint64_t timestamp;
+  uint32_t tx_index;
+  uint32_t output_index;
+  uint8_t tx_hash[UDTSWAP_ROUTE_HASH_SIZE];
+  uint8_t type_hash[UDTSWAP_ROUTE_HASH_SIZE];
+  uint8_t lock_args[UDTSWAP_ROUTE_LOCK_ARGS_SIZE];
+  uint8_t data[UDTSWAP_SNAPSHOT_DATA_SIZE];
+  uint8_t prev_data[UDTSWAP_SNAPSHOT_DATA_SIZE];
+  int is_new;
+} udtswap_ingest_delta_t;
+
+/*
+ * threads : decode threads, 0 is count of online cores
+ * window : blocks decoded ahead of applied block, 0 is 64 blocks of each thread
+ * apply : called by calling thread for deltas in block order, NULL is none
+ */
+typedef struct {
+  int threads;
+  size_t window;
+  void (*apply)(void *ctx, const udtswap_ingest_delta_t *delta);
+  void *ctx;
+} udtswap_ingest_options_t;
+
+/* empty pool table, code hashes of udtswap_common.h */
+UDTSWAP_QUOTE_API udtswap_ingest_t *udtswap_ingest_new(void);
+UDTSWAP_QUOTE_API void udtswap_ingest_free(udtswap_ingest_t *ingest);
+
+/* code hashes of pool cells, of a chain with other script deployments */
+UDTSWAP_QUOTE_API void udtswap_ingest_set_code_hashes(
+  udtswap_ingest_t *ingest,
+  const uint8_t type_code_hash[UDTSWAP_ROUTE_HASH_SIZE],
+  const uint8_t lock_code_hash[UDTSWAP_ROUTE_HASH_SIZE]
+);
+
+/* pools and tip of snapshot, ingestion continues from its tip */
+UDTSWAP_QUOTE_API int udtswap_ingest_load_snapshot(udtswap_ingest_t *ingest, const udtswap_snapshot_t *snapshot);
+
+/*
+ * blocks[i] of lens[i] bytes in block order, first block is child of tip
+ * on error, blocks before the failed block are applied
+ */
+UDTSWAP_QUOTE_API int udtswap_ingest_blocks(
+  udtswap_ingest_t *ingest,
+  const uint8_t *const blocks[],
+  const size_t lens[],
+  size_t cnt,
+  const udtswap_ingest_options_t *options
+);
+
+/* file of concatenated blocks in block order, file is mapped and read by decode threads */
+UDTSWAP_QUOTE_API int udtswap_ingest_file(udtswap_ingest_t *ingest, const char *path, const udtswap_ingest_options_t *options);
+
+/* 0 before first block, tip number and hash otherwise */
+UDTSWAP_QUOTE_API int udtswap_ingest_tip(const udtswap_ingest_t *ingest, uint64_t *number, uint8_t hash[UDTSWAP_ROUTE_HASH_SIZE]);
+
+UDTSWAP_QUOTE_API uint64_t udtswap_ingest_block_count(const udtswap_ingest_t *ingest);
+UDTSWAP_QUOTE_API size_t udtswap_ingest_pool_count(const udtswap_ingest_t *ingest);
+
+/* live pools in order of first appearance, valid until next ingestion */
+UDTSWAP_QUOTE_API const udtswap_snapshot_record_t *udtswap_ingest_pools(const udtswap_ingest_t *ingest);
+
+/* snapshot of live pools at tip, errors are UDTSWAP_SNAPSHOT_ERROR_* */
+UDTSWAP_QUOTE_API int udtswap_ingest_write_snapshot(const udtswap_ingest_t *ingest, const char *path);
+
+#endif /* UDTSWAP_INGEST_H_ */
@@ -0,0 +1,574 @@
+/*
+ * quote library of UDTswap, built from udtswap_formula.h of UDTswap_scripts
+ * conditions are checked in the order of udtswap_reserve_check and the formulas of the type script
+ */
+#include <string.h>
+#include "../../UDTswap_scripts/ckb_consts.h"
+#include "../../UDTswap_scripts/bn.h"
+#include "../../UDTswap_scripts/udtswap_common.h"
+#include "../../UDTswap_scripts/udtswap_formula.h"
+#include "udtswap_quote.h"
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+#define QUOTE_U128_WORDS 4
+#define QUOTE_CAPACITY_MAX 0xffffffffffffffffULL
+
+/*
+ * quote of uint128_t arithmetic does not fit, bn formula computes it
+ */
+#define QUOTE_SLOW 1
+//products of formulas below 2^128 are computed in uint128_t, quotients are same as bn
+
+#if UDTSWAP_QUOTE_PAIR_UDT_UDT != UDTSWAP_PAIR_UDT_UDT || UDTSWAP_QUOTE_PAIR_CKB_UDT != UDTSWAP_PAIR_CKB_UDT || \
+  UDTSWAP_QUOTE_PAIR_UDT_CKB != UDTSWAP_PAIR_UDT_CKB || UDTSWAP_QUOTE_PAIR_CKB_CKB != UDTSWAP_PAIR_CKB_CKB
+#error "pair kinds of quote library should be same as udtswap_common.h"
+#endif
+
+/*
+ * bn result to uint128_t, results above 2^128 - 1 can not be an amount of pool
+ */
+static int quote_result(struct bn *n, udtswap_quote_u128 *ret) {
+  int i;
+  for (i = QUOTE_U128_WORDS; i < BN_ARRAY_SIZE; i++) {
+    if (n->array[i] != 0) {
+      return OVERFLOW_ERROR;
+    }
+  }
+  *ret = bignum_to_uint128_t(n);
+  return CKB_SUCCESS;
+}
+
+/*
+ * reserve or total liquidity after the amount is added
+ */
+static int quote_add_overflow(udtswap_quote_u128 a, udtswap_quote_u128 b) {
+  return a + b < a ? OVERFLOW_ERROR : CKB_SUCCESS;
+}
+
+static int quote_bits(udtswap_quote_u128 v) {
+  uint64_t high = (uint64_t)(v >> 64);
+  if (high != 0) {
+    return 128 - __builtin_clzll(high);
+  }
+  return v == 0 ? 0 : 64 - __builtin_clzll((uint64_t)v);
+}
+
+/*
+ * input amount * 997 * output reserve < 2^(bits + 10), input reserve * 1000 + input amount * 997 < 2^(bits + 11)
+ */
+static int quote_exact_input_fast(
+  udtswap_quote_u128 input_reserve,
+  udtswap_quote_u128 output_reserve,
+  udtswap_quote_u128 input_amount,
+  udtswap_quote_u128 *output_amount
+) {
+  if (input_reserve == 0 || output_reserve == 0) {
+    return RESERVE_BELOW_MINIMUM_ERROR;
+  }
+  if (input_amount == 0) {
+    return RESULT_NOT_CORRECT_ERROR;
+  }
+  if (
+    quote_bits(input_amount) + quote_bits(output_reserve) > 118 ||
+    quote_bits(input_reserve) > 117 ||
+    quote_bits(input_amount) > 117
+  ) {
+    return QUOTE_SLOW;
+  }
+  udtswap_quote_u128 amount_except_fee = input_amount * LIQUIDITY_POOL_EXCEPT_FEE;
+  *output_amount = amount_except_fee * output_reserve / (input_reserve * 1000 + amount_except_fee);
+  //input reserve + input amount does not overflow
+  return *output_amount == 0 ? RESULT_NOT_CORRECT_ERROR : CKB_SUCCESS;
+}
+
+/*
+ * input reserve * 1000 * output amount < 2^(bits + 10), (output reserve - output amount) * 997 < 2^(bits + 10)
+ */
+static int quote_exact_output_fast(
+  udtswap_quote_u128 input_reserve,
+  udtswap_quote_u128 output_reserve,
+  udtswap_quote_u128 output_amount,
+  udtswap_quote_u128 *input_amount
+) {
+  if (input_reserve == 0 || output_reserve == 0 || output_amount >= output_reserve) {
+    return RESERVE_BELOW_MINIMUM_ERROR;
+  }
+  if (output_amount == 0) {
+    return RESULT_NOT_CORRECT_ERROR;
+  }
+  if (quote_bits(input_reserve) + quote_bits(output_amount) > 118 || quote_bits(output_reserve) > 118) {
+    return QUOTE_SLOW;
+  }
+  *input_amount = input_reserve * 1000 * output_amount / ((output_reserve - output_amount) * LIQUIDITY_POOL_EXCEPT_FEE) + 1;
+  return quote_add_overflow(input_reserve, *input_amount);
+}
+
+int udtswap_quote_exact_input(
+  udtswap_quote_u128 input_reserve,
+  udtswap_quote_u128 output_reserve,
+  udtswap_quote_u128 input_amount,
+  udtswap_quote_u128 *output_amount
+) {
+  struct bn amount;
+  int ret = quote_exact_input_fast(input_reserve, output_reserve, input_amount, output_amount);
+  if (ret != QUOTE_SLOW) {
+    return ret;
+  }
+  ret = quote_add_overflow(input_reserve, input_amount);
+  if (ret != CKB_SUCCESS) {
+    return ret;
+  }
+  ret = udtswap_swap_output_amount(input_reserve, output_reserve, input_amount, &amount);
+  if (ret != CKB_SUCCESS) {
+    return ret;
+  }
+  ret = quote_result(&amount, output_amount);
+  if (ret != CKB_SUCCESS) {
+    return ret;
+  }
+  if (*output_amount == 0) {
+    return RESULT_NOT_CORRECT_ERROR;
+  }
+  //output amount is below output reserve by formula
+  return CKB_SUCCESS;
+}
+
+int udtswap_quote_exact_output(
+  udtswap_quote_u128 input_reserve,
+  udtswap_quote_u128 output_reserve,
+  udtswap_quote_u128 output_amount,
+  udtswap_quote_u128 *input_amount
+) {
+  struct bn amount;
+  int ret = quote_exact_output_fast(input_reserve, output_reserve, output_amount, input_amount);
+  if (ret != QUOTE_SLOW) {
+    return ret;
+  }
+  ret = udtswap_swap_input_amount(input_reserve, output_reserve, output_amount, &amount);
+  if (ret != CKB_SUCCESS) {
+    return ret;
+  }
+  ret = quote_result(&amount, input_amount);
+  if (ret != CKB_SUCCESS) {
+    return ret;
+  }
+  return quote_add_overflow(input_reserve, *input_amount);
+}
+
+int udtswap_quote_add_liquidity(
+  udtswap_quote_u128 udt1_reserve,
+  udtswap_quote_u128 udt2_reserve,
+  udtswap_quote_u128 total_liquidity,
+  udtswap_quote_u128 udt1_amount,
+  udtswap_quote_u128 *udt2_amount,
+  udtswap_quote_u128 *liquidity
+) {
+  struct bn amount, user_liquidity;
+  if (total_liquidity == 0) {
+    return LIQUIDITY_EMPTY_ERROR;
+  }
+  //initial liquidity is first udt amount, second udt amount is chosen by first provider
+  if (udt1_amount < ADD_LIQUIDITY_MINIMUM) {
+    return ADD_LIQUIDITY_TOO_LOW_ERROR;
+  }
+  int ret = quote_add_overflow(udt1_reserve, udt1_amount);
+  if (ret != CKB_SUCCESS) {
+    return ret;
+  }
+  ret = udtswap_add_liquidity_amounts(udt1_reserve, udt2_reserve, total_liquidity, udt1_amount, &amount, &user_liquidity);
+  if (ret != CKB_SUCCESS) {
+    return ret;
+  }
+  ret = quote_result(&amount, udt2_amount);
+  if (ret != CKB_SUCCESS) {
+    return ret;
+  }
+  ret = quote_result(&user_liquidity, liquidity);
+  if (ret != CKB_SUCCESS) {
+    return ret;
+  }
+  if (*liquidity == 0) {
+    return ADD_LIQUIDITY_TOO_LOW_ERROR;
+  }
+  //total liquidity should increase
+  ret = quote_add_overflow(udt2_reserve, *udt2_amount);
+  if (ret != CKB_SUCCESS) {
+    return ret;
+  }
+  return quote_add_overflow(total_liquidity, *liquidity);
+}
+
+int udtswap_quote_remove_liquidity(
+  udtswap_quote_u128 udt1_reserve,
+  udtswap_quote_u128 udt2_reserve,
+  udtswap_quote_u128 total_liquidity,
+  udtswap_quote_u128 liquidity,
+  udtswap_quote_u128 *udt1_amount,
+  udtswap_quote_u128 *udt2_amount
+) {
+  struct bn amount1, amount2;
+  if (udt1_reserve == 0 || udt2_reserve == 0) {
+    return RESERVE_BELOW_MINIMUM_ERROR;
+  }
+  if (total_liquidity == 0) {
+    return LIQUIDITY_EMPTY_ERROR;
+  }
+  if (liquidity == 0 || liquidity > total_liquidity) {
+    return LIQUIDITY_NOT_CORRECT_ERROR;
+  }
+  int ret = udtswap_remove_liquidity_amounts(udt1_reserve, udt2_reserve, total_liquidity, liquidity, &amount1, &amount2);
+  if (ret != CKB_SUCCESS) {
+    return ret;
+  }
+  quote_result(&amount1, udt1_amount);
+  quote_result(&amount2, udt2_amount);
+  //amounts are at most reserves
+  if (*udt1_amount >= udt1_reserve || *udt2_amount >= udt2_reserve) {
+    return RESERVE_BELOW_MINIMUM_ERROR;
+  }
+  if (*udt1_amount == 0 || *udt2_amount == 0) {
+    return RESULT_NOT_CORRECT_ERROR;
+  }
+  return CKB_SUCCESS;
+}
+
+/*
+ * checks of pool cell before formula, reserves are checked by formula
+ * input reserve after swap with empty pool reserve should fit in udt amount or capacity
+ */
+static int quote_pool(
+  const udtswap_quote_pools_t *pools,
+  size_t index,
+  int direction,
+  udtswap_quote_u128 *input_reserve,
+  udtswap_quote_u128 *output_reserve,
+  udtswap_quote_u128 *input_limit
+) {
+  int kind = pools->kind[index];
+  int is_ckb1 = kind == UDTSWAP_PAIR_CKB_UDT || kind == UDTSWAP_PAIR_CKB_CKB;
+  int is_ckb2 = kind == UDTSWAP_PAIR_UDT_CKB || kind == UDTSWAP_PAIR_CKB_CKB;
+  int is_ckb_input = direction == UDTSWAP_QUOTE_UDT1_INPUT ? is_ckb1 : is_ckb2;
+
+  *input_reserve = direction == UDTSWAP_QUOTE_UDT1_INPUT ? pools->udt1_reserve[index] : pools->udt2_reserve[index];
+  *output_reserve = direction == UDTSWAP_QUOTE_UDT1_INPUT ? pools->udt2_reserve[index] : pools->udt1_reserve[index];
+  *input_limit = is_ckb_input ? QUOTE_CAPACITY_MAX - CKB_RESERVE_DEFAULT : ~(udtswap_quote_u128)0 - UDT_RESERVE_DEFAULT;
+  if (*input_reserve == 0 || *output_reserve == 0) {
+    return RESERVE_BELOW_MINIMUM_ERROR;
+  }
+  if (pools->total_liquidity[index] == 0) {
+    return LIQUIDITY_EMPTY_ERROR;
+  }
+  return CKB_SUCCESS;
+}
+
+static int quote_pool_exact_input(
+  const udtswap_quote_pools_t *pools,
+  size_t index,
+  int direction,
+  udtswap_quote_u128 input_amount,
+  udtswap_quote_u128 *output_amount
+) {
+  udtswap_quote_u128 input_reserve, output_reserve, input_limit;
+  int ret = quote_pool(pools, index, direction, &input_reserve, &output_reserve, &input_limit);
+  if (ret == CKB_SUCCESS) {
+    ret = udtswap_quote_exact_input(input_reserve, output_reserve, input_amount, output_amount);
+  }
+  if (ret == CKB_SUCCESS && (input_reserve > input_limit || input_amount > input_limit - input_reserve)) {
+    ret = OVERFLOW_ERROR;
+  }
+  if (ret != CKB_SUCCESS) {
+    *output_amount = 0;
+  }
+  return ret;
+}
+
+static int quote_pool_exact_output(
+  const udtswap_quote_pools_t *pools,
+  size_t index,
+  int direction,
+  udtswap_quote_u128 output_amount,
+  udtswap_quote_u128 *input_amount
+) {
+  udtswap_quote_u128 input_reserve, output_reserve, input_limit;
+  int ret = quote_pool(pools, index, direction, &input_reserve, &output_reserve, &input_limit);
+  if (ret == CKB_SUCCESS) {
+    ret = udtswap_quote_exact_output(input_reserve, output_reserve, output_amount, input_amount);
+  }
+  if (ret == CKB_SUCCESS && (input_reserve > input_limit || *input_amount > input_limit - input_reserve)) {
+    ret = OVERFLOW_ERROR;
+  }
+  if (ret != CKB_SUCCESS) {
+    *input_amount = 0;
+  }
+  return ret;
+}
+
+/*
+ * widest level of the CPU, resolved at load, udtswap_quote_simd lowers it
+ */
+static int quote_simd_supported = UDTSWAP_QUOTE_SIMD_NONE;
+static int quote_simd_level = UDTSWAP_QUOTE_SIMD_NONE;
+
+__attribute__((constructor)) static void quote_simd_init(void) {
+#if defined(__x86_64__)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512dq")) {
+    quote_simd_supported = UDTSWAP_QUOTE_SIMD_AVX512;
+  } else if (__builtin_cpu_supports("avx2")) {
+    quote_simd_supported = UDTSWAP_QUOTE_SIMD_AVX2;
+  }
+#endif
+  quote_simd_level = quote_simd_supported;
+}
+
+int udtswap_quote_simd(int level) {
+  quote_simd_level = level < quote_simd_supported ? level : quote_simd_supported;
+  return quote_simd_level;
+}
+
+#if defined(__x86_64__)
+#define QUOTE_DOUBLE_2P52 0x4330000000000000ULL
+#define QUOTE_DOUBLE_1P5P52 0x4338000000000000ULL
+
+/*
+ * low and high 64 bits of 4 uint128_t from p, or of *p in every lane when step is 0
+ */
+__attribute__((target("avx2"))) static void quote_load_u128_avx2(const udtswap_quote_u128 *p, size_t step, __m256i *low, __m256i *high) {
+  if (step == 0) {
+    *low = _mm256_set1_epi64x((long long)(uint64_t)*p);
+    *high = _mm256_set1_epi64x((long long)(uint64_t)(*p >> 64));
+    return;
+  }
+  __m256i a = _mm256_loadu_si256((const __m256i *)p);
+  __m256i b = _mm256_loadu_si256((const __m256i *)(p + 2));
+  *low = _mm256_permute4x64_epi64(_mm256_unpacklo_epi64(a, b), 0xd8);
+  *high = _mm256_permute4x64_epi64(_mm256_unpackhi_epi64(a, b), 0xd8);
+}
+
+__attribute__((target("avx2"))) static __m256i quote_load_kind_avx2(const uint8_t *p, size_t step) {
+  int32_t kinds;
+  if (step == 0) {
+    return _mm256_set1_epi64x(*p);
+  }
+  memcpy(&kinds, p, sizeof(kinds));
+  return _mm256_cvtepu8_epi64(_mm_cvtsi32_si128(kinds));
+}
+
+#define QUOTE_LANES 4
+#define QUOTE_LANES_NAME(name) quote_##name##_avx2
+#define QUOTE_LANES_TARGET __attribute__((target("avx2")))
+#define QUOTE_V __m256i
+#define QUOTE_F __m256d
+#define QUOTE_V_SET1(a) _mm256_set1_epi64x((long long)(a))
+#define QUOTE_V_ADD _mm256_add_epi64
+#define QUOTE_V_SUB _mm256_sub_epi64
+#define QUOTE_V_AND _mm256_and_si256
+#define QUOTE_V_ANDNOT _mm256_andnot_si256
+#define QUOTE_V_OR _mm256_or_si256
+#define QUOTE_V_XOR _mm256_xor_si256
+#define QUOTE_V_SRL _mm256_srli_epi64
+#define QUOTE_V_SLL _mm256_slli_epi64
+#define QUOTE_V_MUL32 _mm256_mul_epu32
+#define QUOTE_V_EQ _mm256_cmpeq_epi64
+#define QUOTE_V_GT(a, b) _mm256_cmpgt_epi64(_mm256_xor_si256(a, QUOTE_V_SET1(1ULL << 63)), _mm256_xor_si256(b, QUOTE_V_SET1(1ULL << 63)))
+#define QUOTE_V_AS_F _mm256_castsi256_pd
+#define QUOTE_V_STORE(p, a) _mm256_storeu_si256((__m256i *)(p), a)
+#define QUOTE_V_BITS(a) _mm256_movemask_pd(_mm256_castsi256_pd(a))
+#define QUOTE_V_LOAD_U128(p, step, low, high) quote_load_u128_avx2(p, step, &(low), &(high))
+#define QUOTE_V_LOAD_KIND quote_load_kind_avx2
+#define QUOTE_F_AS_V _mm256_castpd_si256
+#define QUOTE_F_SET1 _mm256_set1_pd
+#define QUOTE_F_ADD _mm256_add_pd
+#define QUOTE_F_SUB _mm256_sub_pd
+#define QUOTE_F_MUL _mm256_mul_pd
+#define QUOTE_F_DIV _mm256_div_pd
+#define QUOTE_F_AND _mm256_and_pd
+#define QUOTE_F_GT(a, b) _mm256_cmp_pd(a, b, _CMP_GT_OQ)
+#define QUOTE_F_LT(a, b) _mm256_cmp_pd(a, b, _CMP_LT_OQ)
+#include "udtswap_quote_lanes.h"
+#undef QUOTE_LANES
+#undef QUOTE_LANES_NAME
+#undef QUOTE_LANES_TARGET
+#undef QUOTE_V
+#undef QUOTE_F
+#undef QUOTE_V_SET1
+#undef QUOTE_V_ADD
+#undef QUOTE_V_SUB
+#undef QUOTE_V_AND
+#undef QUOTE_V_ANDNOT
+#undef QUOTE_V_OR
+#undef QUOTE_V_XOR
+#undef QUOTE_V_SRL
+#undef QUOTE_V_SLL
+#undef QUOTE_V_MUL32
+#undef QUOTE_V_EQ
+#undef QUOTE_V_GT
+#undef QUOTE_V_AS_F
+#undef QUOTE_V_STORE
+#undef QUOTE_V_BITS
+#undef QUOTE_V_LOAD_U128
+#undef QUOTE_V_LOAD_KIND
+#undef QUOTE_F_AS_V
+#undef QUOTE_F_SET1
+#undef QUOTE_F_ADD
+#undef QUOTE_F_SUB
+#undef QUOTE_F_MUL
+#undef QUOTE_F_DIV
+#undef QUOTE_F_AND
+#undef QUOTE_F_GT
+#undef QUOTE_F_LT
+
+/*
+ * 8 uint128_t as quote_load_u128_avx2
+ */
+__attribute__((target("avx512f,avx512dq"))) static void quote_load_u128_avx512(const udtswap_quote_u128 *p, size_t step, __m512i *low, __m512i *high) {
+  if (step == 0) {
+    *low = _mm512_set1_epi64((long long)(uint64_t)*p);
+    *high = _mm512_set1_epi64((long long)(uint64_t)(*p >> 64));
+    return;
+  }
+  __m512i a = _mm512_loadu_si512(p);
+  __m512i b = _mm512_loadu_si512(p + 4);
+  *low = _mm512_permutex2var_epi64(a, _mm512_set_epi64(14, 12, 10, 8, 6, 4, 2, 0), b);
+  *high = _mm512_permutex2var_epi64(a, _mm512_set_epi64(15, 13, 11, 9, 7, 5, 3, 1), b);
+}
+
+__attribute__((target("avx512f,avx512dq"))) static __m512i quote_load_kind_avx512(const uint8_t *p, size_t step) {
+  if (step == 0) {
+    return _mm512_set1_epi64(*p);
+  }
+  return _mm512_cvtepu8_epi64(_mm_loadl_epi64((const __m128i *)p));
+}
+
+#define QUOTE_LANES 8
+#define QUOTE_LANES_NAME(name) quote_##name##_avx512
+#define QUOTE_LANES_TARGET __attribute__((target("avx512f,avx512dq")))
+#define QUOTE_V __m512i
+#define QUOTE_F __m512d
+#define QUOTE_V_SET1(a) _mm512_set1_epi64((long long)(a))
+#define QUOTE_V_ADD _mm512_add_epi64
+#define QUOTE_V_SUB _mm512_sub_epi64
+#define QUOTE_V_AND _mm512_and_si512
+#define QUOTE_V_ANDNOT _mm512_andnot_si512
+#define QUOTE_V_OR _mm512_or_si512
+#define QUOTE_V_XOR _mm512_xor_si512
+#define QUOTE_V_SRL _mm512_srli_epi64
+#define QUOTE_V_SLL _mm512_slli_epi64
+#define QUOTE_V_MUL32 _mm512_mul_epu32
+#define QUOTE_V_EQ(a, b) _mm512_movm_epi64(_mm512_cmpeq_epu64_mask(a, b))
+#define QUOTE_V_GT(a, b) _mm512_movm_epi64(_mm512_cmpgt_epu64_mask(a, b))
+#define QUOTE_V_AS_F _mm512_castsi512_pd
+#define QUOTE_V_STORE _mm512_storeu_si512
+#define QUOTE_V_BITS(a) (int)_mm512_movepi64_mask(a)
+#define QUOTE_V_LOAD_U128(p, step, low, high) quote_load_u128_avx512(p, step, &(low), &(high))
+#define QUOTE_V_LOAD_KIND quote_load_kind_avx512
+#define QUOTE_F_AS_V _mm512_castpd_si512
+#define QUOTE_F_SET1 _mm512_set1_pd
+#define QUOTE_F_ADD _mm512_add_pd
+#define QUOTE_F_SUB _mm512_sub_pd
+#define QUOTE_F_MUL _mm512_mul_pd
+#define QUOTE_F_DIV _mm512_div_pd
+#define QUOTE_F_AND _mm512_and_pd
+#define QUOTE_F_GT(a, b) _mm512_castsi512_pd(_mm512_movm_epi64(_mm512_cmp_pd_mask(a, b, _CMP_GT_OQ)))
+#define QUOTE_F_LT(a, b) _mm512_castsi512_pd(_mm512_movm_epi64(_mm512_cmp_pd_mask(a, b, _CMP_LT_OQ)))
+#include "udtswap_quote_lanes.h"
+#endif
+
+/*
+ * pool of quote i is index + i * pool_step, amount is amounts[i * amount_step], steps are 0 or 1
+ * quotes are taken by lanes of SIMD level, quotes rejected by lanes and the tail take the scalar path
+ */
+static void quote_batch(
+  const udtswap_quote_pools_t *pools,
+  size_t index,
+  size_t pool_step,
+  int direction,
+  int exact_output,
+  const udtswap_quote_u128 amounts[],
+  size_t amount_step,
+  size_t cnt,
+  udtswap_quote_u128 results[],
+  int rets[]
+) {
+  size_t i = 0, j, lanes = 1;
+  int bits;
+  while (i < cnt) {
+    bits = 0;
+#if defined(__x86_64__)
+    if (quote_simd_level == UDTSWAP_QUOTE_SIMD_AVX512 && cnt - i >= 8) {
+      lanes = 8;
+      bits = quote_lanes_avx512(
+        pools, index + i * pool_step, pool_step, direction, exact_output, amounts + i * amount_step, amount_step, results + i, rets + i
+      );
+    } else if (quote_simd_level == UDTSWAP_QUOTE_SIMD_AVX2 && cnt - i >= 4) {
+      lanes = 4;
+      bits = quote_lanes_avx2(
+        pools, index + i * pool_step, pool_step, direction, exact_output, amounts + i * amount_step, amount_step, results + i, rets + i
+      );
+    } else {
+      lanes = 1;
+    }
+#endif
+    for (j = i; j < i + lanes; j++) {
+      if ((bits >> (j - i) & 1) != 0) {
+        continue;
+      }
+      if (exact_output) {
+        rets[j] = quote_pool_exact_output(pools, index + j * pool_step, direction, amounts[j * amount_step], &results[j]);
+      } else {
+        rets[j] = quote_pool_exact_input(pools, index + j * pool_step, direction, amounts[j * amount_step], &results[j]);
+      }
+    }
+    i += lanes;
+  }
+}
+
+void udtswap_quote_exact_input_pools(
+  const udtswap_quote_pools_t *pools,
+  int direction,
+  udtswap_quote_u128 input_amount,
+  udtswap_quote_u128 output_amounts[],
+  int rets[]
+) {
+  quote_batch(pools, 0, 1, direction, 0, &input_amount, 0, pools->cnt, output_amounts, rets);
+}
+
+void udtswap_quote_exact_output_pools(
+  const udtswap_quote_pools_t *pools,
+  int direction,
+  udtswap_quote_u128 output_amount,
+  udtswap_quote_u128 input_amounts[],
+  int rets[]
+) {
+  quote_batch(pools, 0, 1, direction, 1, &output_amount, 0, pools->cnt, input_amounts, rets);
+}
+
+void udtswap_quote_exact_input_amounts(
+  const udtswap_quote_pools_t *pools,
+  size_t index,
+  int direction,
+  const udtswap_quote_u128 input_amounts[],
+  size_t cnt,
+  udtswap_quote_u128 output_amounts[],
+  int rets[]
+) {
+  quote_batch(pools, index, 0, direction, 0, input_amounts, 1, cnt, output_amounts, rets);
+}
+
+void udtswap_quote_exact_output_amounts(
+  const udtswap_quote_pools_t *pools,
+  size_t index,
+  int direction,
+  const udtswap_quote_u128 output_amounts[],
+  size_t cnt,
+  udtswap_quote_u128 input_amounts[],
+  int rets[]
+) {
+  quote_batch(pools, index, 0, direction, 1, output_amounts, 1, cnt, input_amounts, rets);
+}
+
+int udtswap_quote_version(void) {
+  return UDTSWAP_QUOTE_VERSION;
+}
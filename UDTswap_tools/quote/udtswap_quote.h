@@ -0,0 +1,130 @@
+#ifndef UDTSWAP_QUOTE_H_
+#define UDTSWAP_QUOTE_H_
+
+/*
+ * quote library of UDTswap, amounts accepted by the type script
+ *
+ * amounts are computed by udtswap_formula.h, same source as the checks of UDTswap_udt_based.c
+ * reserves are actual reserves of pool (except empty pool reserve of 300 CKB or 1 UDT)
+ * functions return 0 or the error code of the type script which rejects the amounts
+ * CKB amounts should fit in capacity (uint64_t), it is not checked
+ */
+#include <stddef.h>
+#include <stdint.h>
+
+#define UDTSWAP_QUOTE_VERSION 2
+
+#define UDTSWAP_QUOTE_API __attribute__((visibility("default")))
+
+typedef unsigned __int128 udtswap_quote_u128;
+
+/* output amount of exact input amount, output of swap_output_by_input */
+UDTSWAP_QUOTE_API int udtswap_quote_exact_input(
+  udtswap_quote_u128 input_reserve,
+  udtswap_quote_u128 output_reserve,
+  udtswap_quote_u128 input_amount,
+  udtswap_quote_u128 *output_amount
+);
+
+/* input amount of exact output amount, input of swap_input_by_output */
+UDTSWAP_QUOTE_API int udtswap_quote_exact_output(
+  udtswap_quote_u128 input_reserve,
+  udtswap_quote_u128 output_reserve,
+  udtswap_quote_u128 output_amount,
+  udtswap_quote_u128 *input_amount
+);
+
+/* second udt amount and liquidity of first udt amount, pool should have liquidity */
+UDTSWAP_QUOTE_API int udtswap_quote_add_liquidity(
+  udtswap_quote_u128 udt1_reserve,
+  udtswap_quote_u128 udt2_reserve,
+  udtswap_quote_u128 total_liquidity,
+  udtswap_quote_u128 udt1_amount,
+  udtswap_quote_u128 *udt2_amount,
+  udtswap_quote_u128 *liquidity
+);
+
+/* udt amounts of removing liquidity */
+UDTSWAP_QUOTE_API int udtswap_quote_remove_liquidity(
+  udtswap_quote_u128 udt1_reserve,
+  udtswap_quote_u128 udt2_reserve,
+  udtswap_quote_u128 total_liquidity,
+  udtswap_quote_u128 liquidity,
+  udtswap_quote_u128 *udt1_amount,
+  udtswap_quote_u128 *udt2_amount
+);
+
+/*
+ * pool table of batch quotes, structure of arrays, index i of every array is one pool
+ * kind is pair kind of lock args, CKB reserves should fit in capacity with empty pool reserve
+ * batch quotes check what the type script checks by pool cell, empty total liquidity and capacity,
+ * otherwise results are same as quote functions above
+ */
+#define UDTSWAP_QUOTE_PAIR_UDT_UDT 0
+#define UDTSWAP_QUOTE_PAIR_CKB_UDT 1
+#define UDTSWAP_QUOTE_PAIR_UDT_CKB 2
+#define UDTSWAP_QUOTE_PAIR_CKB_CKB 3
+
+#define UDTSWAP_QUOTE_UDT1_INPUT 0
+#define UDTSWAP_QUOTE_UDT2_INPUT 1
+
+typedef struct {
+  size_t cnt;
+  const udtswap_quote_u128 *udt1_reserve;
+  const udtswap_quote_u128 *udt2_reserve;
+  const udtswap_quote_u128 *total_liquidity;
+  const uint8_t *kind;
+} udtswap_quote_pools_t;
+
+/* one amount against every pool, rets[i] is 0 or error code and amounts[i] is 0 on error */
+UDTSWAP_QUOTE_API void udtswap_quote_exact_input_pools(
+  const udtswap_quote_pools_t *pools,
+  int direction,
+  udtswap_quote_u128 input_amount,
+  udtswap_quote_u128 output_amounts[],
+  int rets[]
+);
+
+UDTSWAP_QUOTE_API void udtswap_quote_exact_output_pools(
+  const udtswap_quote_pools_t *pools,
+  int direction,
+  udtswap_quote_u128 output_amount,
+  udtswap_quote_u128 input_amounts[],
+  int rets[]
+);
+
+/* many amounts against pool of index */
+UDTSWAP_QUOTE_API void udtswap_quote_exact_input_amounts(
+  const udtswap_quote_pools_t *pools,
+  size_t index,
+  int direction,
+  const udtswap_quote_u128 input_amounts[],
+  size_t cnt,
+  udtswap_quote_u128 output_amounts[],
+  int rets[]
+);
+
+UDTSWAP_QUOTE_API void udtswap_quote_exact_output_amounts(
+  const udtswap_quote_pools_t *pools,
+  size_t index,
+  int direction,
+  const udtswap_quote_u128 output_amounts[],
+  size_t cnt,
+  udtswap_quote_u128 input_amounts[],
+  int rets[]
+);
+
+/*
+ * batch quotes of reserves and amounts below 2^64 estimate quotients in double lanes and correct them exactly,
+ * lanes are AVX-512 or AVX2 by CPU support, results are same at every level
+ * level is lowered to CPU support, returns level used, NONE is the uint128_t formula of every quote
+ */
+#define UDTSWAP_QUOTE_SIMD_NONE 0
+#define UDTSWAP_QUOTE_SIMD_AVX2 1
+#define UDTSWAP_QUOTE_SIMD_AVX512 2
+
+UDTSWAP_QUOTE_API int udtswap_quote_simd(int level);
+
+UDTSWAP_QUOTE_API int udtswap_quote_version(void);
+
+#endif /* UDTSWAP_QUOTE_H_ */
@@ -0,0 +1,19 @@
+/**
+ * @dev quote library of UDTswap for node, amounts are BigInt
+ * amounts are computed by udtswap_formula.h of UDTswap_scripts, same formulas as the type script
+ * errors have code of the type script error which rejects the amounts
+ *
+ * `make quote` in UDTswap_tools builds the addon
+ **/
+const path = require('path');
+
+const addonPath = path.join(__dirname, '..', 'build', 'quote', 'udtswap_quote.node');
+
+let addon;
+try {
+  addon = require(addonPath);
+} catch (e) {
+  throw new Error(`UDTswap quote addon is not built, run \`make quote\` in UDTswap_tools (${e.message})`);
+}
+
+module.exports = addon;
@@ -0,0 +1,248 @@
+/*
+ * lanes of batch quotes, included by udtswap_quote.c once for each SIMD level
+ * level defines QUOTE_LANES_NAME, QUOTE_LANES_TARGET, QUOTE_LANES and operations QUOTE_V_* of uint64_t lanes
+ * and QUOTE_F_* of double lanes, masks of comparisons are all bits set lanes
+ *
+ * quote of pool and amount below 2^64 is floor(num / den), num = c1 * x * y, den = c2 * z + c3 * x
+ * exact input : x input amount, y output reserve, z input reserve, c1 997, c2 1000, c3 997
+ * exact output : x output amount, y input reserve, z output reserve - output amount, c1 1000, c2 997, c3 0
+ * q is estimated in double, then remainder num - q * den is computed exactly in 32 bit limbs modulo 2^96,
+ * |remainder| of estimate is below 2^91, so it is exact, q is moved by remainder / den and corrected by one
+ */
+
+typedef struct {
+  QUOTE_V l0;
+  QUOTE_V l1;
+  QUOTE_V l2;
+} QUOTE_LANES_NAME(limbs_t);
+
+QUOTE_LANES_TARGET static inline QUOTE_V QUOTE_LANES_NAME(mul32)(QUOTE_V a, QUOTE_V b) {
+  return QUOTE_V_MUL32(a, b);
+}
+
+/*
+ * a * b modulo 2^96, a of 3 limbs, b of 2 limbs
+ */
+QUOTE_LANES_TARGET static inline QUOTE_LANES_NAME(limbs_t) QUOTE_LANES_NAME(mul96)(QUOTE_LANES_NAME(limbs_t) a, QUOTE_V b0, QUOTE_V b1) {
+  QUOTE_V limb = QUOTE_V_SET1(0xffffffffULL);
+  QUOTE_V p00 = QUOTE_LANES_NAME(mul32)(a.l0, b0);
+  QUOTE_V p01 = QUOTE_LANES_NAME(mul32)(a.l0, b1);
+  QUOTE_V p10 = QUOTE_LANES_NAME(mul32)(a.l1, b0);
+  QUOTE_V s1 = QUOTE_V_ADD(QUOTE_V_SRL(p00, 32), QUOTE_V_ADD(QUOTE_V_AND(p01, limb), QUOTE_V_AND(p10, limb)));
+  QUOTE_V s2 = QUOTE_V_ADD(QUOTE_V_ADD(QUOTE_V_SRL(s1, 32), QUOTE_V_SRL(p01, 32)), QUOTE_V_SRL(p10, 32));
+  QUOTE_LANES_NAME(limbs_t) r;
+  s2 = QUOTE_V_ADD(s2, QUOTE_V_ADD(QUOTE_LANES_NAME(mul32)(a.l1, b1), QUOTE_LANES_NAME(mul32)(a.l2, b0)));
+  r.l0 = QUOTE_V_AND(p00, limb);
+  r.l1 = QUOTE_V_AND(s1, limb);
+  r.l2 = QUOTE_V_AND(s2, limb);
+  return r;
+}
+
+/*
+ * a - b modulo 2^96, limbs of a and b are below 2^32, borrows are taken from 2^32 added to each limb
+ */
+QUOTE_LANES_TARGET static inline QUOTE_LANES_NAME(limbs_t) QUOTE_LANES_NAME(sub96)(QUOTE_LANES_NAME(limbs_t) a, QUOTE_LANES_NAME(limbs_t) b) {
+  QUOTE_V limb = QUOTE_V_SET1(0xffffffffULL);
+  QUOTE_V base = QUOTE_V_SET1(0x100000000ULL);
+  QUOTE_V t0 = QUOTE_V_SUB(QUOTE_V_ADD(a.l0, base), b.l0);
+  QUOTE_V t1 = QUOTE_V_SUB(QUOTE_V_ADD(QUOTE_V_ADD(a.l1, limb), QUOTE_V_SRL(t0, 32)), b.l1);
+  QUOTE_V t2 = QUOTE_V_SUB(QUOTE_V_ADD(QUOTE_V_ADD(a.l2, limb), QUOTE_V_SRL(t1, 32)), b.l2);
+  QUOTE_LANES_NAME(limbs_t) r;
+  r.l0 = QUOTE_V_AND(t0, limb);
+  r.l1 = QUOTE_V_AND(t1, limb);
+  r.l2 = QUOTE_V_AND(t2, limb);
+  return r;
+}
+
+/*
+ * a + (b & mask) modulo 2^96
+ */
+QUOTE_LANES_TARGET static inline QUOTE_LANES_NAME(limbs_t) QUOTE_LANES_NAME(add96)(QUOTE_LANES_NAME(limbs_t) a, QUOTE_LANES_NAME(limbs_t) b, QUOTE_V mask) {
+  QUOTE_V limb = QUOTE_V_SET1(0xffffffffULL);
+  QUOTE_V t0 = QUOTE_V_ADD(a.l0, QUOTE_V_AND(b.l0, mask));
+  QUOTE_V t1 = QUOTE_V_ADD(QUOTE_V_ADD(a.l1, QUOTE_V_AND(b.l1, mask)), QUOTE_V_SRL(t0, 32));
+  QUOTE_V t2 = QUOTE_V_ADD(QUOTE_V_ADD(a.l2, QUOTE_V_AND(b.l2, mask)), QUOTE_V_SRL(t1, 32));
+  QUOTE_LANES_NAME(limbs_t) r;
+  r.l0 = QUOTE_V_AND(t0, limb);
+  r.l1 = QUOTE_V_AND(t1, limb);
+  r.l2 = QUOTE_V_AND(t2, limb);
+  return r;
+}
+
+/*
+ * a where mask is set, otherwise b
+ */
+QUOTE_LANES_TARGET static inline QUOTE_LANES_NAME(limbs_t) QUOTE_LANES_NAME(select96)(QUOTE_V mask, QUOTE_LANES_NAME(limbs_t) a, QUOTE_LANES_NAME(limbs_t) b) {
+  QUOTE_LANES_NAME(limbs_t) r;
+  r.l0 = QUOTE_V_OR(QUOTE_V_AND(mask, a.l0), QUOTE_V_ANDNOT(mask, b.l0));
+  r.l1 = QUOTE_V_OR(QUOTE_V_AND(mask, a.l1), QUOTE_V_ANDNOT(mask, b.l1));
+  r.l2 = QUOTE_V_OR(QUOTE_V_AND(mask, a.l2), QUOTE_V_ANDNOT(mask, b.l2));
+  return r;
+}
+
+/*
+ * all bits set lanes of limbs whose bit 95 is set, negative in two's complement
+ */
+QUOTE_LANES_TARGET static inline QUOTE_V QUOTE_LANES_NAME(negative)(QUOTE_LANES_NAME(limbs_t) a) {
+  return QUOTE_V_SUB(QUOTE_V_SET1(0), QUOTE_V_SRL(a.l2, 31));
+}
+
+/*
+ * limb below 2^52 to double by exponent bits of 2^52
+ */
+QUOTE_LANES_TARGET static inline QUOTE_F QUOTE_LANES_NAME(limb_double)(QUOTE_V a) {
+  return QUOTE_F_SUB(QUOTE_V_AS_F(QUOTE_V_OR(a, QUOTE_V_SET1(QUOTE_DOUBLE_2P52))), QUOTE_F_SET1(0x1p52));
+}
+
+QUOTE_LANES_TARGET static inline QUOTE_F QUOTE_LANES_NAME(u64_double)(QUOTE_V a) {
+  QUOTE_F high = QUOTE_LANES_NAME(limb_double)(QUOTE_V_SRL(a, 32));
+  QUOTE_F low = QUOTE_LANES_NAME(limb_double)(QUOTE_V_AND(a, QUOTE_V_SET1(0xffffffffULL)));
+  return QUOTE_F_ADD(QUOTE_F_MUL(high, QUOTE_F_SET1(0x1p32)), low);
+}
+
+/*
+ * floor of |a| below 2^51, as double, rounding to integer by 1.5 * 2^52
+ */
+QUOTE_LANES_TARGET static inline QUOTE_F QUOTE_LANES_NAME(floor)(QUOTE_F a) {
+  QUOTE_F round = QUOTE_F_SUB(QUOTE_F_ADD(a, QUOTE_F_SET1(0x1.8p52)), QUOTE_F_SET1(0x1.8p52));
+  return QUOTE_F_SUB(round, QUOTE_F_AND(QUOTE_F_GT(round, a), QUOTE_F_SET1(1)));
+}
+
+/*
+ * integer double of |a| below 2^51 to two's complement int64_t lanes
+ */
+QUOTE_LANES_TARGET static inline QUOTE_V QUOTE_LANES_NAME(double_int)(QUOTE_F a) {
+  return QUOTE_V_SUB(QUOTE_F_AS_V(QUOTE_F_ADD(a, QUOTE_F_SET1(0x1.8p52))), QUOTE_V_SET1(QUOTE_DOUBLE_1P5P52));
+}
+
+/*
+ * QUOTE_LANES quotes from quote i of pool index + i * pool_step and amounts[i * amount_step], steps are 0 or 1
+ * returns bits of quotes whose results[i] and rets[i] are set, others take the scalar path
+ */
+QUOTE_LANES_TARGET static int QUOTE_LANES_NAME(lanes)(
+  const udtswap_quote_pools_t *pools,
+  size_t index,
+  size_t pool_step,
+  int direction,
+  int exact_output,
+  const udtswap_quote_u128 amounts[],
+  size_t amount_step,
+  udtswap_quote_u128 results[],
+  int rets[]
+) {
+  const udtswap_quote_u128 *input_reserves = direction == UDTSWAP_QUOTE_UDT1_INPUT ? pools->udt1_reserve : pools->udt2_reserve;
+  const udtswap_quote_u128 *output_reserves = direction == UDTSWAP_QUOTE_UDT1_INPUT ? pools->udt2_reserve : pools->udt1_reserve;
+  QUOTE_V limb = QUOTE_V_SET1(0xffffffffULL);
+  QUOTE_V zero = QUOTE_V_SET1(0);
+  QUOTE_V in_low, in_high, out_low, out_high, liquidity_low, liquidity_high, x, x_high, y, z, kind, ok, ckb;
+  QUOTE_V q, negative, not_below, input_amount, limit, overflow;
+  QUOTE_F xd, inverse, qd, high, rem_quotient;
+  QUOTE_LANES_NAME(limbs_t) c1x, den, num, rem, over;
+  uint64_t c1 = exact_output ? 1000 : LIQUIDITY_POOL_EXCEPT_FEE;
+  uint64_t c2 = exact_output ? LIQUIDITY_POOL_EXCEPT_FEE : 1000;
+  uint64_t c3 = exact_output ? 0 : LIQUIDITY_POOL_EXCEPT_FEE;
+  uint64_t lanes_q[QUOTE_LANES], lanes_x[QUOTE_LANES], lanes_overflow[QUOTE_LANES];
+  int bits, i;
+
+  QUOTE_V_LOAD_U128(input_reserves + index, pool_step, in_low, in_high);
+  QUOTE_V_LOAD_U128(output_reserves + index, pool_step, out_low, out_high);
+  QUOTE_V_LOAD_U128(pools->total_liquidity + index, pool_step, liquidity_low, liquidity_high);
+  QUOTE_V_LOAD_U128(amounts, amount_step, x, x_high);
+  kind = QUOTE_V_LOAD_KIND(pools->kind + index, pool_step);
+
+  //checks of quote_pool and the formulas, failed lanes take the scalar path for their error codes
+  ok = QUOTE_V_EQ(QUOTE_V_OR(QUOTE_V_OR(in_high, out_high), x_high), zero);
+  ok = QUOTE_V_ANDNOT(QUOTE_V_EQ(in_low, zero), ok);
+  ok = QUOTE_V_ANDNOT(QUOTE_V_EQ(out_low, zero), ok);
+  ok = QUOTE_V_ANDNOT(QUOTE_V_EQ(QUOTE_V_OR(liquidity_low, liquidity_high), zero), ok);
+  ok = QUOTE_V_ANDNOT(QUOTE_V_EQ(x, zero), ok);
+  if (exact_output) {
+    ok = QUOTE_V_AND(ok, QUOTE_V_GT(out_low, x));
+    y = in_low;
+    z = QUOTE_V_SUB(out_low, x);
+  } else {
+    y = out_low;
+    z = in_low;
+  }
+  ckb = QUOTE_V_OR(
+    QUOTE_V_EQ(kind, QUOTE_V_SET1(direction == UDTSWAP_QUOTE_UDT1_INPUT ? UDTSWAP_PAIR_CKB_UDT : UDTSWAP_PAIR_UDT_CKB)),
+    QUOTE_V_EQ(kind, QUOTE_V_SET1(UDTSWAP_PAIR_CKB_CKB))
+  );
+
+  //estimate below 2^63, so quotient fits in uint64_t lanes
+  xd = QUOTE_LANES_NAME(u64_double)(x);
+  inverse = QUOTE_F_DIV(
+    QUOTE_F_SET1(1),
+    QUOTE_F_ADD(QUOTE_F_MUL(QUOTE_LANES_NAME(u64_double)(z), QUOTE_F_SET1((double)c2)), QUOTE_F_MUL(xd, QUOTE_F_SET1((double)c3)))
+  );
+  qd = QUOTE_F_MUL(QUOTE_F_MUL(QUOTE_F_MUL(xd, QUOTE_F_SET1((double)c1)), QUOTE_LANES_NAME(u64_double)(y)), inverse);
+  ok = QUOTE_V_AND(ok, QUOTE_F_AS_V(QUOTE_F_LT(qd, QUOTE_F_SET1(0x1p63))));
+  qd = QUOTE_F_AND(qd, QUOTE_V_AS_F(ok));
+  high = QUOTE_LANES_NAME(floor)(QUOTE_F_MUL(qd, QUOTE_F_SET1(0x1p-32)));
+  q = QUOTE_V_ADD(
+    QUOTE_V_SLL(QUOTE_LANES_NAME(double_int)(high), 32),
+    QUOTE_LANES_NAME(double_int)(QUOTE_LANES_NAME(floor)(QUOTE_F_SUB(qd, QUOTE_F_MUL(high, QUOTE_F_SET1(0x1p32)))))
+  );
+
+  c1x.l0 = QUOTE_LANES_NAME(mul32)(x, QUOTE_V_SET1(c1));
+  c1x.l1 = QUOTE_V_ADD(QUOTE_V_SRL(c1x.l0, 32), QUOTE_LANES_NAME(mul32)(QUOTE_V_SRL(x, 32), QUOTE_V_SET1(c1)));
+  c1x.l0 = QUOTE_V_AND(c1x.l0, limb);
+  c1x.l2 = QUOTE_V_SRL(c1x.l1, 32);
+  c1x.l1 = QUOTE_V_AND(c1x.l1, limb);
+  den.l0 = QUOTE_V_ADD(QUOTE_LANES_NAME(mul32)(z, QUOTE_V_SET1(c2)), QUOTE_LANES_NAME(mul32)(x, QUOTE_V_SET1(c3)));
+  den.l1 = QUOTE_V_ADD(
+    QUOTE_V_SRL(den.l0, 32),
+    QUOTE_V_ADD(QUOTE_LANES_NAME(mul32)(QUOTE_V_SRL(z, 32), QUOTE_V_SET1(c2)), QUOTE_LANES_NAME(mul32)(QUOTE_V_SRL(x, 32), QUOTE_V_SET1(c3)))
+  );
+  den.l0 = QUOTE_V_AND(den.l0, limb);
+  den.l2 = QUOTE_V_SRL(den.l1, 32);
+  den.l1 = QUOTE_V_AND(den.l1, limb);
+  num = QUOTE_LANES_NAME(mul96)(c1x, QUOTE_V_AND(y, limb), QUOTE_V_SRL(y, 32));
+
+  //remainder / den of far estimate, floor is within one of quotient of remainder
+  rem = QUOTE_LANES_NAME(sub96)(num, QUOTE_LANES_NAME(mul96)(den, QUOTE_V_AND(q, limb), QUOTE_V_SRL(q, 32)));
+  rem_quotient = QUOTE_F_ADD(
+    QUOTE_F_MUL(
+      QUOTE_F_SUB(QUOTE_LANES_NAME(limb_double)(QUOTE_V_XOR(rem.l2, QUOTE_V_SET1(0x80000000ULL))), QUOTE_F_SET1(0x1p31)),
+      QUOTE_F_SET1(0x1p64)
+    ),
+    QUOTE_F_ADD(QUOTE_F_MUL(QUOTE_LANES_NAME(limb_double)(rem.l1), QUOTE_F_SET1(0x1p32)), QUOTE_LANES_NAME(limb_double)(rem.l0))
+  );
+  rem_quotient = QUOTE_F_AND(QUOTE_F_MUL(rem_quotient, inverse), QUOTE_V_AS_F(ok));
+  q = QUOTE_V_ADD(q, QUOTE_LANES_NAME(double_int)(QUOTE_LANES_NAME(floor)(rem_quotient)));
+  rem = QUOTE_LANES_NAME(sub96)(num, QUOTE_LANES_NAME(mul96)(den, QUOTE_V_AND(q, limb), QUOTE_V_SRL(q, 32)));
+
+  //remainder in [-den, 2 * den), one step each way, then remainder should be in [0, den)
+  negative = QUOTE_LANES_NAME(negative)(rem);
+  q = QUOTE_V_ADD(q, negative);
+  rem = QUOTE_LANES_NAME(add96)(rem, den, negative);
+  over = QUOTE_LANES_NAME(sub96)(rem, den);
+  not_below = QUOTE_V_ANDNOT(QUOTE_LANES_NAME(negative)(over), QUOTE_V_SET1(~0ULL));
+  q = QUOTE_V_SUB(q, not_below);
+  rem = QUOTE_LANES_NAME(select96)(not_below, over, rem);
+  ok = QUOTE_V_ANDNOT(QUOTE_LANES_NAME(negative)(rem), ok);
+  ok = QUOTE_V_AND(ok, QUOTE_LANES_NAME(negative)(QUOTE_LANES_NAME(sub96)(rem, den)));
+
+  //input amount over capacity of CKB input reserve, udt amounts below 2^65 fit in udt limit
+  input_amount = exact_output ? QUOTE_V_ADD(q, QUOTE_V_SET1(1)) : x;
+  limit = QUOTE_V_SET1(QUOTE_CAPACITY_MAX - CKB_RESERVE_DEFAULT);
+  overflow = QUOTE_V_AND(ckb, QUOTE_V_OR(QUOTE_V_GT(in_low, limit), QUOTE_V_GT(input_amount, QUOTE_V_SUB(limit, in_low))));
+
+  QUOTE_V_STORE(lanes_q, q);
+  QUOTE_V_STORE(lanes_x, input_amount);
+  QUOTE_V_STORE(lanes_overflow, overflow);
+  bits = QUOTE_V_BITS(ok);
+  for (i = 0; i < QUOTE_LANES; i++) {
+    if ((bits >> i & 1) == 0) {
+      continue;
+    }
+    if (exact_output) {
+      rets[i] = lanes_overflow[i] != 0 ? OVERFLOW_ERROR : CKB_SUCCESS;
+      results[i] = rets[i] == CKB_SUCCESS ? lanes_x[i] : 0;
+    } else {
+      rets[i] = lanes_q[i] == 0 ? RESULT_NOT_CORRECT_ERROR : lanes_overflow[i] != 0 ? OVERFLOW_ERROR : CKB_SUCCESS;
+      results[i] = rets[i] == CKB_SUCCESS ? lanes_q[i] : 0;
+    }
+  }
+  return bits;
+}
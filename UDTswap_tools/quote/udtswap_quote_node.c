@@ -0,0 +1,1356 @@
+/*
+ * Node addon of quote library, amounts are BigInt
+ * error of quote is thrown with code of the type script error, e.g. err.code === '-76'
+ * pool table of batch quotes is created once and updated by setPool, batch quotes return
+ * { amounts, errors }, errors[i] is 0 or error code and amounts[i] is 0n on error
+ * route graph is created once, pools are added by lock args and pool data buffers and updated by pool data
+ * pool snapshot file is written from pool records and loaded into a route graph
+ * transaction builder is created once and reset for each transaction, hashes, args and data are buffers,
+ * capacities, since and fee rate are BigInt
+ * signer is created once, signTxs computes messages of lock groups of builders on signer threads,
+ * and signs lock witnesses in place when the addon is built with SECP256K1=1 (signing is true)
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <node_api.h>
+#include "udtswap_quote.h"
+#include "udtswap_route.h"
+#include "udtswap_snapshot.h"
+#include "udtswap_tx.h"
+#include "udtswap_sign.h"
+
+#define QUOTE_NODE_MAX_ARGS 6
+#define QUOTE_NODE_PATH_SIZE 4096
+#define QUOTE_NODE_TX_ARENA_SIZE (64 << 10)
+#define QUOTE_NODE_TX_MAGIC 0x55445458 //"UDTX"
+#define QUOTE_NODE_SIGNER_MAGIC 0x55445347 //"UDSG"
+
+typedef struct {
+  udtswap_quote_pools_t pools;
+  udtswap_quote_u128 *udt1_reserve;
+  udtswap_quote_u128 *udt2_reserve;
+  udtswap_quote_u128 *total_liquidity;
+  uint8_t *kind;
+} quote_node_pools_t;
+
+/* builder and its arena in one allocation, magic tells it from other externals */
+typedef struct {
+  uint32_t magic;
+  udtswap_tx_t tx;
+  uint8_t arena[];
+} quote_node_tx_t;
+
+/* signer threads and signing context of secp256k1 build */
+typedef struct {
+  uint32_t magic;
+  udtswap_signer_t *signer;
+  void *ctx;
+} quote_node_signer_t;
+
+static int get_u128(napi_env env, napi_value value, udtswap_quote_u128 *ret) {
+  uint64_t words[2] = {0, 0};
+  size_t word_cnt = 2;
+  int sign = 0;
+  if (napi_get_value_bigint_words(env, value, &sign, &word_cnt, words) != napi_ok) {
+    napi_throw_type_error(env, NULL, "amount should be a BigInt");
+    return 0;
+  }
+  if (sign != 0 || word_cnt > 2) {
+    napi_throw_range_error(env, NULL, "amount should be an unsigned 128 bit integer");
+    return 0;
+  }
+  *ret = ((udtswap_quote_u128)words[1] << 64) | words[0];
+  return 1;
+}
+
+static napi_value new_u128(napi_env env, udtswap_quote_u128 v) {
+  uint64_t words[2] = {(uint64_t)v, (uint64_t)(v >> 64)};
+  napi_value ret;
+  napi_create_bigint_words(env, 0, 2, words, &ret);
+  return ret;
+}
+
+/*
+ * arguments of a quote function, false when an exception is pending
+ */
+static int get_args(napi_env env, napi_callback_info info, size_t cnt, udtswap_quote_u128 args[]) {
+  napi_value values[QUOTE_NODE_MAX_ARGS];
+  size_t argc = QUOTE_NODE_MAX_ARGS;
+  size_t i;
+  napi_get_cb_info(env, info, &argc, values, NULL, NULL);
+  if (argc != cnt) {
+    napi_throw_type_error(env, NULL, "wrong number of arguments");
+    return 0;
+  }
+  for (i = 0; i < cnt; i++) {
+    if (!get_u128(env, values[i], &args[i])) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+static napi_value quote_error(napi_env env, int ret) {
+  char code[16], message[64];
+  snprintf(code, sizeof(code), "%d", ret);
+  snprintf(message, sizeof(message), "UDTswap quote rejected by type script error %d", ret);
+  napi_throw_error(env, code, message);
+  return NULL;
+}
+
+static napi_value new_pair(napi_env env, const char *name1, udtswap_quote_u128 v1, const char *name2, udtswap_quote_u128 v2) {
+  napi_value ret;
+  napi_create_object(env, &ret);
+  napi_set_named_property(env, ret, name1, new_u128(env, v1));
+  napi_set_named_property(env, ret, name2, new_u128(env, v2));
+  return ret;
+}
+
+static napi_value exact_input(napi_env env, napi_callback_info info) {
+  udtswap_quote_u128 args[3], output_amount;
+  if (!get_args(env, info, 3, args)) {
+    return NULL;
+  }
+  int ret = udtswap_quote_exact_input(args[0], args[1], args[2], &output_amount);
+  return ret == 0 ? new_u128(env, output_amount) : quote_error(env, ret);
+}
+
+static napi_value exact_output(napi_env env, napi_callback_info info) {
+  udtswap_quote_u128 args[3], input_amount;
+  if (!get_args(env, info, 3, args)) {
+    return NULL;
+  }
+  int ret = udtswap_quote_exact_output(args[0], args[1], args[2], &input_amount);
+  return ret == 0 ? new_u128(env, input_amount) : quote_error(env, ret);
+}
+
+static napi_value add_liquidity(napi_env env, napi_callback_info info) {
+  udtswap_quote_u128 args[4], udt2_amount, liquidity;
+  if (!get_args(env, info, 4, args)) {
+    return NULL;
+  }
+  int ret = udtswap_quote_add_liquidity(args[0], args[1], args[2], args[3], &udt2_amount, &liquidity);
+  return ret == 0 ? new_pair(env, "udt2Amount", udt2_amount, "userLiquidity", liquidity) : quote_error(env, ret);
+}
+
+static napi_value remove_liquidity(napi_env env, napi_callback_info info) {
+  udtswap_quote_u128 args[4], udt1_amount, udt2_amount;
+  if (!get_args(env, info, 4, args)) {
+    return NULL;
+  }
+  int ret = udtswap_quote_remove_liquidity(args[0], args[1], args[2], args[3], &udt1_amount, &udt2_amount);
+  return ret == 0 ? new_pair(env, "udt1Amount", udt1_amount, "udt2Amount", udt2_amount) : quote_error(env, ret);
+}
+
+static void free_pools(napi_env env, void *data, void *hint) {
+  quote_node_pools_t *table = data;
+  free(table->udt1_reserve);
+  free(table->udt2_reserve);
+  free(table->total_liquidity);
+  free(table->kind);
+  free(table);
+}
+
+static napi_value create_pools(napi_env env, napi_callback_info info) {
+  napi_value value, ret;
+  size_t argc = 1;
+  uint32_t cnt;
+  napi_get_cb_info(env, info, &argc, &value, NULL, NULL);
+  if (argc != 1 || napi_get_value_uint32(env, value, &cnt) != napi_ok) {
+    napi_throw_type_error(env, NULL, "pool count should be a number");
+    return NULL;
+  }
+  quote_node_pools_t *table = calloc(1, sizeof(quote_node_pools_t));
+  if (table != NULL) {
+    table->udt1_reserve = calloc(cnt + 1, sizeof(udtswap_quote_u128));
+    table->udt2_reserve = calloc(cnt + 1, sizeof(udtswap_quote_u128));
+    table->total_liquidity = calloc(cnt + 1, sizeof(udtswap_quote_u128));
+    table->kind = calloc(cnt + 1, 1);
+  }
+  if (table == NULL || !table->udt1_reserve || !table->udt2_reserve || !table->total_liquidity || !table->kind) {
+    if (table != NULL) {
+      free_pools(env, table, NULL);
+    }
+    napi_throw_error(env, NULL, "pool table allocation failed");
+    return NULL;
+  }
+  table->pools.cnt = cnt;
+  table->pools.udt1_reserve = table->udt1_reserve;
+  table->pools.udt2_reserve = table->udt2_reserve;
+  table->pools.total_liquidity = table->total_liquidity;
+  table->pools.kind = table->kind;
+  napi_create_external(env, table, free_pools, NULL, &ret);
+  return ret;
+}
+//empty pools are rejected by reserve check until they are set
+
+/*
+ * pool table, and numbers of arguments 1 ~ number_cnt, false when an exception is pending
+ */
+static int get_pools_args(
+  napi_env env,
+  napi_callback_info info,
+  size_t cnt,
+  size_t number_cnt,
+  napi_value values[],
+  quote_node_pools_t **table,
+  uint32_t numbers[]
+) {
+  size_t argc = QUOTE_NODE_MAX_ARGS;
+  size_t i;
+  napi_valuetype type;
+  napi_get_cb_info(env, info, &argc, values, NULL, NULL);
+  if (argc != cnt) {
+    napi_throw_type_error(env, NULL, "wrong number of arguments");
+    return 0;
+  }
+  if (napi_typeof(env, values[0], &type) != napi_ok || type != napi_external) {
+    napi_throw_type_error(env, NULL, "pools should be created by createPools");
+    return 0;
+  }
+  napi_get_value_external(env, values[0], (void **)table);
+  for (i = 0; i < number_cnt; i++) {
+    if (napi_get_value_uint32(env, values[1 + i], &numbers[i]) != napi_ok) {
+      napi_throw_type_error(env, NULL, "index, kind and direction should be numbers");
+      return 0;
+    }
+  }
+  return 1;
+}
+
+static napi_value set_pool(napi_env env, napi_callback_info info) {
+  napi_value values[QUOTE_NODE_MAX_ARGS];
+  quote_node_pools_t *table;
+  udtswap_quote_u128 udt1_reserve, udt2_reserve, total_liquidity;
+  uint32_t numbers[2];
+  if (!get_pools_args(env, info, 6, 2, values, &table, numbers)) {
+    return NULL;
+  }
+  if (numbers[0] >= table->pools.cnt || numbers[1] > UDTSWAP_QUOTE_PAIR_CKB_CKB) {
+    napi_throw_range_error(env, NULL, "pool index or pair kind out of range");
+    return NULL;
+  }
+  if (
+    !get_u128(env, values[3], &udt1_reserve) ||
+    !get_u128(env, values[4], &udt2_reserve) ||
+    !get_u128(env, values[5], &total_liquidity)
+  ) {
+    return NULL;
+  }
+  table->kind[numbers[0]] = (uint8_t)numbers[1];
+  table->udt1_reserve[numbers[0]] = udt1_reserve;
+  table->udt2_reserve[numbers[0]] = udt2_reserve;
+  table->total_liquidity[numbers[0]] = total_liquidity;
+  return NULL;
+}
+
+static napi_value new_batch_result(napi_env env, const udtswap_quote_u128 amounts[], const int rets[], size_t cnt) {
+  napi_value ret, array, buffer, errors;
+  int32_t *data;
+  size_t i;
+  napi_create_array_with_length(env, cnt, &array);
+  napi_create_arraybuffer(env, cnt * sizeof(int32_t), (void **)&data, &buffer);
+  for (i = 0; i < cnt; i++) {
+    napi_set_element(env, array, (uint32_t)i, new_u128(env, amounts[i]));
+    data[i] = rets[i];
+  }
+  napi_create_typedarray(env, napi_int32_array, cnt, buffer, 0, &errors);
+  napi_create_object(env, &ret);
+  napi_set_named_property(env, ret, "amounts", array);
+  napi_set_named_property(env, ret, "errors", errors);
+  return ret;
+}
+
+/*
+ * (pools, direction, amount), one amount against every pool
+ */
+static napi_value quote_pools(napi_env env, napi_callback_info info, int exact_output) {
+  napi_value values[QUOTE_NODE_MAX_ARGS], ret = NULL;
+  quote_node_pools_t *table;
+  udtswap_quote_u128 amount;
+  uint32_t direction;
+  if (!get_pools_args(env, info, 3, 1, values, &table, &direction) || !get_u128(env, values[2], &amount)) {
+    return NULL;
+  }
+  udtswap_quote_u128 *amounts = malloc((table->pools.cnt + 1) * sizeof(udtswap_quote_u128));
+  int *rets = malloc((table->pools.cnt + 1) * sizeof(int));
+  if (amounts == NULL || rets == NULL) {
+    napi_throw_error(env, NULL, "batch quote allocation failed");
+  } else {
+    if (exact_output) {
+      udtswap_quote_exact_output_pools(&table->pools, (int)direction, amount, amounts, rets);
+    } else {
+      udtswap_quote_exact_input_pools(&table->pools, (int)direction, amount, amounts, rets);
+    }
+    ret = new_batch_result(env, amounts, rets, table->pools.cnt);
+  }
+  free(amounts);
+  free(rets);
+  return ret;
+}
+
+/*
+ * (pools, index, direction, amounts), many amounts against pool of index
+ */
+static napi_value quote_amounts(napi_env env, napi_callback_info info, int exact_output) {
+  napi_value values[QUOTE_NODE_MAX_ARGS], element, ret = NULL;
+  quote_node_pools_t *table;
+  uint32_t numbers[2], cnt = 0, i;
+  bool is_array = false;
+  if (!get_pools_args(env, info, 4, 2, values, &table, numbers)) {
+    return NULL;
+  }
+  napi_is_array(env, values[3], &is_array);
+  if (!is_array) {
+    napi_throw_type_error(env, NULL, "amounts should be an array of BigInt");
+    return NULL;
+  }
+  if (numbers[0] >= table->pools.cnt) {
+    napi_throw_range_error(env, NULL, "pool index out of range");
+    return NULL;
+  }
+  napi_get_array_length(env, values[3], &cnt);
+  udtswap_quote_u128 *amounts = malloc(((size_t)cnt + 1) * sizeof(udtswap_quote_u128));
+  udtswap_quote_u128 *results = malloc(((size_t)cnt + 1) * sizeof(udtswap_quote_u128));
+  int *rets = malloc(((size_t)cnt + 1) * sizeof(int));
+  if (amounts == NULL || results == NULL || rets == NULL) {
+    napi_throw_error(env, NULL, "batch quote allocation failed");
+  } else {
+    for (i = 0; i < cnt; i++) {
+      napi_get_element(env, values[3], i, &element);
+      if (!get_u128(env, element, &amounts[i])) {
+        break;
+      }
+    }
+    if (i == cnt) {
+      if (exact_output) {
+        udtswap_quote_exact_output_amounts(&table->pools, numbers[0], (int)numbers[1], amounts, cnt, results, rets);
+      } else {
+        udtswap_quote_exact_input_amounts(&table->pools, numbers[0], (int)numbers[1], amounts, cnt, results, rets);
+      }
+      ret = new_batch_result(env, results, rets, cnt);
+    }
+  }
+  free(amounts);
+  free(results);
+  free(rets);
+  return ret;
+}
+
+static napi_value exact_input_pools(napi_env env, napi_callback_info info) {
+  return quote_pools(env, info, 0);
+}
+
+static napi_value exact_output_pools(napi_env env, napi_callback_info info) {
+  return quote_pools(env, info, 1);
+}
+
+static napi_value exact_input_amounts(napi_env env, napi_callback_info info) {
+  return quote_amounts(env, info, 0);
+}
+
+static napi_value exact_output_amounts(napi_env env, napi_callback_info info) {
+  return quote_amounts(env, info, 1);
+}
+
+static void free_graph(napi_env env, void *data, void *hint) {
+  udtswap_route_graph_free(data);
+}
+
+static napi_value create_graph(napi_env env, napi_callback_info info) {
+  napi_value ret;
+  udtswap_route_graph_t *graph = udtswap_route_graph_new();
+  if (graph == NULL) {
+    napi_throw_error(env, NULL, "route graph allocation failed");
+    return NULL;
+  }
+  napi_create_external(env, graph, free_graph, NULL, &ret);
+  return ret;
+}
+
+/*
+ * route graph and buffers of arguments, buffers of size 0 are not checked
+ */
+static int get_graph_args(
+  napi_env env,
+  napi_callback_info info,
+  size_t cnt,
+  napi_value values[],
+  udtswap_route_graph_t **graph,
+  const uint8_t *buffers[],
+  size_t sizes[],
+  const size_t buffer_args[],
+  size_t buffer_cnt
+) {
+  size_t argc = QUOTE_NODE_MAX_ARGS;
+  size_t i;
+  napi_valuetype type;
+  bool is_buffer;
+  napi_get_cb_info(env, info, &argc, values, NULL, NULL);
+  if (argc < cnt) {
+    napi_throw_type_error(env, NULL, "wrong number of arguments");
+    return 0;
+  }
+  if (napi_typeof(env, values[0], &type) != napi_ok || type != napi_external) {
+    napi_throw_type_error(env, NULL, "graph should be created by createGraph");
+    return 0;
+  }
+  napi_get_value_external(env, values[0], (void **)graph);
+  for (i = 0; i < buffer_cnt; i++) {
+    napi_value value = values[buffer_args[i]];
+    if (napi_is_buffer(env, value, &is_buffer) != napi_ok || !is_buffer) {
+      napi_throw_type_error(env, NULL, "lock args, pool data, udt type hashes and key should be buffers");
+      return 0;
+    }
+    napi_get_buffer_info(env, value, (void **)&buffers[i], &sizes[i]);
+  }
+  return 1;
+}
+
+static napi_value route_error(napi_env env, int ret) {
+  char code[16];
+  snprintf(code, sizeof(code), "%d", ret);
+  napi_throw_error(env, code, ret == UDTSWAP_ROUTE_ERROR_NO_ROUTE ? "UDTswap route not found" : "UDTswap route graph error");
+  return NULL;
+}
+
+/*
+ * (graph, lockArgs, data), pool id
+ */
+static napi_value add_pool(napi_env env, napi_callback_info info) {
+  static const size_t buffer_args[] = {1, 2};
+  napi_value values[QUOTE_NODE_MAX_ARGS], ret;
+  udtswap_route_graph_t *graph;
+  const uint8_t *buffers[2];
+  size_t sizes[2];
+  uint32_t pool;
+  if (!get_graph_args(env, info, 3, values, &graph, buffers, sizes, buffer_args, 2)) {
+    return NULL;
+  }
+  if (sizes[0] != UDTSWAP_ROUTE_LOCK_ARGS_SIZE) {
+    napi_throw_range_error(env, NULL, "lock args should be 64 bytes");
+    return NULL;
+  }
+  int err = udtswap_route_graph_add_pool(graph, buffers[0], buffers[1], sizes[1], &pool);
+  if (err != 0) {
+    return route_error(env, err);
+  }
+  napi_create_uint32(env, pool, &ret);
+  return ret;
+}
+
+/*
+ * (graph, pool, data)
+ */
+static napi_value update_pool(napi_env env, napi_callback_info info) {
+  static const size_t buffer_args[] = {2};
+  napi_value values[QUOTE_NODE_MAX_ARGS];
+  udtswap_route_graph_t *graph;
+  const uint8_t *buffers[1];
+  size_t sizes[1];
+  uint32_t pool;
+  if (!get_graph_args(env, info, 3, values, &graph, buffers, sizes, buffer_args, 1)) {
+    return NULL;
+  }
+  if (napi_get_value_uint32(env, values[1], &pool) != napi_ok) {
+    napi_throw_type_error(env, NULL, "pool should be a number");
+    return NULL;
+  }
+  int err = udtswap_route_graph_update_pool(graph, pool, buffers[0], sizes[0]);
+  return err == 0 ? NULL : route_error(env, err);
+}
+
+static int get_option(napi_env env, napi_value options, const char *name, int64_t *value) {
+  napi_value property;
+  napi_valuetype type;
+  bool has = false;
+  if (napi_has_named_property(env, options, name, &has) != napi_ok || !has) {
+    return 1;
+  }
+  napi_get_named_property(env, options, name, &property);
+  napi_typeof(env, property, &type);
+  if (type == napi_undefined) {
+    return 1;
+  }
+  if (napi_get_value_int64(env, property, value) != napi_ok) {
+    napi_throw_type_error(env, NULL, "route options should be numbers");
+    return 0;
+  }
+  return 1;
+}
+
+static napi_value new_route(napi_env env, const udtswap_route_t *route) {
+  napi_value ret, hops, legs, leg, value;
+  int hop, i;
+  napi_create_object(env, &ret);
+  napi_set_named_property(env, ret, "inputAmount", new_u128(env, route->input_amount));
+  napi_set_named_property(env, ret, "outputAmount", new_u128(env, route->output_amount));
+  napi_create_array_with_length(env, route->hop_cnt, &hops);
+  for (hop = 0; hop < route->hop_cnt; hop++) {
+    napi_create_array_with_length(env, route->leg_cnt[hop], &legs);
+    for (i = 0; i < route->leg_cnt[hop]; i++) {
+      const udtswap_route_leg_t *l = &route->legs[hop][i];
+      napi_create_object(env, &leg);
+      napi_create_uint32(env, l->pool, &value);
+      napi_set_named_property(env, leg, "pool", value);
+      napi_create_int32(env, l->direction, &value);
+      napi_set_named_property(env, leg, "direction", value);
+      napi_set_named_property(env, leg, "inputAmount", new_u128(env, l->input_amount));
+      napi_set_named_property(env, leg, "outputAmount", new_u128(env, l->output_amount));
+      napi_set_element(env, legs, (uint32_t)i, leg);
+    }
+    napi_set_element(env, hops, (uint32_t)hop, legs);
+  }
+  napi_set_named_property(env, ret, "hops", hops);
+  napi_create_double(env, (double)route->paths, &value);
+  napi_set_named_property(env, ret, "paths", value);
+  napi_get_boolean(env, route->timed_out != 0, &value);
+  napi_set_named_property(env, ret, "timedOut", value);
+  return ret;
+}
+
+/*
+ * (graph, inputUdt, outputUdt, amount, { maxHops, maxSplit, budgetNs })
+ */
+static napi_value best_route(napi_env env, napi_callback_info info) {
+  static const size_t buffer_args[] = {1, 2};
+  napi_value values[QUOTE_NODE_MAX_ARGS];
+  udtswap_route_graph_t *graph;
+  udtswap_route_options_t options = {UDTSWAP_ROUTE_MAX_HOPS, 1, 0};
+  udtswap_route_t route;
+  const uint8_t *buffers[2];
+  size_t sizes[2];
+  udtswap_quote_u128 amount;
+  int64_t max_hops = options.max_hops, max_split = options.max_split, budget_ns = 0;
+  napi_valuetype type;
+  if (!get_graph_args(env, info, 4, values, &graph, buffers, sizes, buffer_args, 2) || !get_u128(env, values[3], &amount)) {
+    return NULL;
+  }
+  if (sizes[0] != UDTSWAP_ROUTE_HASH_SIZE || sizes[1] != UDTSWAP_ROUTE_HASH_SIZE) {
+    napi_throw_range_error(env, NULL, "udt type hashes should be 32 bytes");
+    return NULL;
+  }
+  //options of values[4] is undefined when it is not passed
+  if (napi_typeof(env, values[4], &type) == napi_ok && type == napi_object) {
+    if (
+      !get_option(env, values[4], "maxHops", &max_hops) ||
+      !get_option(env, values[4], "maxSplit", &max_split) ||
+      !get_option(env, values[4], "budgetNs", &budget_ns)
+    ) {
+      return NULL;
+    }
+  }
+  options.max_hops = (int)max_hops;
+  options.max_split = (int)max_split;
+  options.budget_ns = budget_ns < 0 ? 0 : (uint64_t)budget_ns;
+  int err = udtswap_route_best(graph, buffers[0], buffers[1], amount, &options, &route);
+  return err == 0 ? new_route(env, &route) : route_error(env, err);
+}
+
+/*
+ * (graph, inputUdt, outputUdt, amount, key, { maxSplit, toleranceBps })
+ */
+static napi_value shard_route(napi_env env, napi_callback_info info) {
+  static const size_t buffer_args[] = {1, 2, 4};
+  napi_value values[QUOTE_NODE_MAX_ARGS];
+  udtswap_route_graph_t *graph;
+  udtswap_route_shard_options_t options = {UDTSWAP_ROUTE_MAX_SPLIT, 0};
+  udtswap_route_t route;
+  const uint8_t *buffers[3];
+  size_t sizes[3];
+  udtswap_quote_u128 amount;
+  int64_t max_split = options.max_split, tolerance_bps = 0;
+  napi_valuetype type;
+  if (!get_graph_args(env, info, 5, values, &graph, buffers, sizes, buffer_args, 3) || !get_u128(env, values[3], &amount)) {
+    return NULL;
+  }
+  if (sizes[0] != UDTSWAP_ROUTE_HASH_SIZE || sizes[1] != UDTSWAP_ROUTE_HASH_SIZE || sizes[2] != UDTSWAP_ROUTE_HASH_SIZE) {
+    napi_throw_range_error(env, NULL, "udt type hashes and key should be 32 bytes");
+    return NULL;
+  }
+  if (napi_typeof(env, values[5], &type) == napi_ok && type == napi_object) {
+    if (!get_option(env, values[5], "maxSplit", &max_split) || !get_option(env, values[5], "toleranceBps", &tolerance_bps)) {
+      return NULL;
+    }
+  }
+  options.max_split = (int)max_split;
+  options.tolerance_bps = tolerance_bps < 0 ? 0 : tolerance_bps > UINT32_MAX ? UINT32_MAX : (uint32_t)tolerance_bps;
+  int err = udtswap_route_shard(graph, buffers[0], buffers[1], amount, buffers[2], &options, &route);
+  return err == 0 ? new_route(env, &route) : route_error(env, err);
+}
+
+static int get_path(napi_env env, napi_value value, char path[QUOTE_NODE_PATH_SIZE]) {
+  size_t len;
+  if (napi_get_value_string_utf8(env, value, path, QUOTE_NODE_PATH_SIZE, &len) != napi_ok || len + 1 >= QUOTE_NODE_PATH_SIZE) {
+    napi_throw_type_error(env, NULL, "path should be a string");
+    return 0;
+  }
+  return 1;
+}
+
+static napi_value snapshot_error(napi_env env, int ret) {
+  char code[16];
+  snprintf(code, sizeof(code), "%d", ret);
+  napi_throw_error(
+    env,
+    code,
+    ret == UDTSWAP_SNAPSHOT_ERROR_IO ? "UDTswap snapshot file error" :
+    ret == UDTSWAP_SNAPSHOT_ERROR_VERSION ? "UDTswap snapshot version is not supported" : "UDTswap snapshot is broken"
+  );
+  return NULL;
+}
+
+/*
+ * buffer property of a pool record, size bytes
+ */
+static int get_record_field(napi_env env, napi_value pool, const char *name, uint8_t *field, size_t size) {
+  napi_value value;
+  bool is_buffer = false;
+  void *data;
+  size_t len;
+  if (
+    napi_get_named_property(env, pool, name, &value) != napi_ok ||
+    napi_is_buffer(env, value, &is_buffer) != napi_ok || !is_buffer ||
+    napi_get_buffer_info(env, value, &data, &len) != napi_ok || len < size
+  ) {
+    char message[64];
+    snprintf(message, sizeof(message), "pool %s should be a buffer of %zu bytes", name, size);
+    napi_throw_type_error(env, NULL, message);
+    return 0;
+  }
+  memcpy(field, data, size);
+  return 1;
+}
+
+/*
+ * (path, tipNumber, tipHash, [{ lockArgs, typeHash, txHash, index, data }])
+ */
+static napi_value write_snapshot(napi_env env, napi_callback_info info) {
+  size_t argc = 4;
+  napi_value values[4], pool, value;
+  char path[QUOTE_NODE_PATH_SIZE];
+  udtswap_quote_u128 tip_number;
+  bool is_array = false;
+  void *tip_hash;
+  size_t tip_hash_len;
+  uint32_t cnt, i, index;
+  napi_get_cb_info(env, info, &argc, values, NULL, NULL);
+  if (argc < 4) {
+    napi_throw_type_error(env, NULL, "wrong number of arguments");
+    return NULL;
+  }
+  if (!get_path(env, values[0], path) || !get_u128(env, values[1], &tip_number)) {
+    return NULL;
+  }
+  if (napi_get_buffer_info(env, values[2], &tip_hash, &tip_hash_len) != napi_ok || tip_hash_len != UDTSWAP_ROUTE_HASH_SIZE) {
+    napi_throw_type_error(env, NULL, "tip hash should be a buffer of 32 bytes");
+    return NULL;
+  }
+  if (napi_is_array(env, values[3], &is_array) != napi_ok || !is_array) {
+    napi_throw_type_error(env, NULL, "pools should be an array");
+    return NULL;
+  }
+  napi_get_array_length(env, values[3], &cnt);
+  udtswap_snapshot_record_t *records = calloc(cnt == 0 ? 1 : cnt, sizeof(udtswap_snapshot_record_t));
+  if (records == NULL) {
+    napi_throw_error(env, NULL, "snapshot allocation failed");
+    return NULL;
+  }
+  for (i = 0; i < cnt; i++) {
+    napi_get_element(env, values[3], i, &pool);
+    if (
+      !get_record_field(env, pool, "lockArgs", records[i].lock_args, sizeof(records[i].lock_args)) ||
+      !get_record_field(env, pool, "typeHash", records[i].type_hash, sizeof(records[i].type_hash)) ||
+      !get_record_field(env, pool, "txHash", records[i].tx_hash, sizeof(records[i].tx_hash)) ||
+      !get_record_field(env, pool, "data", records[i].data, sizeof(records[i].data))
+    ) {
+      free(records);
+      return NULL;
+    }
+    if (napi_get_named_property(env, pool, "index", &value) != napi_ok || napi_get_value_uint32(env, value, &index) != napi_ok) {
+      free(records);
+      napi_throw_type_error(env, NULL, "pool index should be a number");
+      return NULL;
+    }
+    records[i].index[0] = (uint8_t)index;
+    records[i].index[1] = (uint8_t)(index >> 8);
+    records[i].index[2] = (uint8_t)(index >> 16);
+    records[i].index[3] = (uint8_t)(index >> 24);
+  }
+  int err = udtswap_snapshot_write(path, (uint64_t)tip_number, tip_hash, records, cnt);
+  free(records);
+  return err == 0 ? NULL : snapshot_error(env, err);
+}
+
+/*
+ * (graph, path), pools of snapshot are added to graph, { tipNumber, tipHash, firstPool, poolCount }
+ */
+static napi_value load_snapshot(napi_env env, napi_callback_info info) {
+  napi_value values[QUOTE_NODE_MAX_ARGS], ret, value;
+  udtswap_route_graph_t *graph;
+  udtswap_snapshot_t snapshot;
+  char path[QUOTE_NODE_PATH_SIZE];
+  uint32_t first;
+  void *tip_hash;
+  if (!get_graph_args(env, info, 2, values, &graph, NULL, NULL, NULL, 0) || !get_path(env, values[1], path)) {
+    return NULL;
+  }
+  int err = udtswap_snapshot_open(path, &snapshot);
+  if (err != 0) {
+    return snapshot_error(env, err);
+  }
+  err = udtswap_snapshot_add_pools(&snapshot, graph, &first);
+  if (err != 0) {
+    udtswap_snapshot_close(&snapshot);
+    return route_error(env, err);
+  }
+  napi_create_object(env, &ret);
+  napi_set_named_property(env, ret, "tipNumber", new_u128(env, snapshot.tip_number));
+  napi_create_buffer_copy(env, UDTSWAP_ROUTE_HASH_SIZE, snapshot.tip_hash, &tip_hash, &value);
+  napi_set_named_property(env, ret, "tipHash", value);
+  napi_create_uint32(env, first, &value);
+  napi_set_named_property(env, ret, "firstPool", value);
+  napi_create_uint32(env, (uint32_t)snapshot.pool_cnt, &value);
+  napi_set_named_property(env, ret, "poolCount", value);
+  udtswap_snapshot_close(&snapshot);
+  return ret;
+}
+
+static void free_tx(napi_env env, void *data, void *hint) {
+  free(data);
+}
+
+/*
+ * (arenaSize), builder of outputs and witnesses of at most arenaSize bytes, 64 KB when omitted
+ */
+static napi_value create_tx(napi_env env, napi_callback_info info) {
+  napi_value value, ret;
+  size_t argc = 1;
+  uint32_t arena_cap = QUOTE_NODE_TX_ARENA_SIZE;
+  napi_valuetype type = napi_undefined;
+  napi_get_cb_info(env, info, &argc, &value, NULL, NULL);
+  if (argc > 0 && napi_typeof(env, value, &type) == napi_ok && type != napi_undefined) {
+    if (napi_get_value_uint32(env, value, &arena_cap) != napi_ok) {
+      napi_throw_type_error(env, NULL, "arena size should be a number");
+      return NULL;
+    }
+  }
+  quote_node_tx_t *tx = malloc(sizeof(quote_node_tx_t) + arena_cap);
+  if (tx == NULL) {
+    napi_throw_error(env, NULL, "transaction builder allocation failed");
+    return NULL;
+  }
+  tx->magic = QUOTE_NODE_TX_MAGIC;
+  udtswap_tx_init(&tx->tx, tx->arena, arena_cap);
+  napi_create_external(env, tx, free_tx, NULL, &ret);
+  return ret;
+}
+
+/*
+ * builder of first argument and the other arguments, false when an exception is pending
+ */
+static int get_tx(napi_env env, napi_value value, udtswap_tx_t **tx) {
+  napi_valuetype type;
+  quote_node_tx_t *node_tx = NULL;
+  if (
+    napi_typeof(env, value, &type) != napi_ok || type != napi_external ||
+    napi_get_value_external(env, value, (void **)&node_tx) != napi_ok || node_tx->magic != QUOTE_NODE_TX_MAGIC
+  ) {
+    napi_throw_type_error(env, NULL, "transaction should be created by createTx");
+    return 0;
+  }
+  *tx = &node_tx->tx;
+  return 1;
+}
+
+static int get_tx_args(napi_env env, napi_callback_info info, size_t cnt, napi_value values[], udtswap_tx_t **tx) {
+  size_t argc = QUOTE_NODE_MAX_ARGS;
+  napi_get_cb_info(env, info, &argc, values, NULL, NULL);
+  if (argc < cnt) {
+    napi_throw_type_error(env, NULL, "wrong number of arguments");
+    return 0;
+  }
+  return get_tx(env, values[0], tx);
+}
+
+/*
+ * buffer of size bytes, any size when size is 0
+ */
+static int get_tx_buffer(napi_env env, napi_value value, const char *name, size_t size, const uint8_t **data, uint32_t *len) {
+  bool is_buffer = false;
+  size_t buffer_len;
+  if (
+    napi_is_buffer(env, value, &is_buffer) != napi_ok || !is_buffer ||
+    napi_get_buffer_info(env, value, (void **)data, &buffer_len) != napi_ok ||
+    (size != 0 && buffer_len != size) || buffer_len > UINT32_MAX
+  ) {
+    char message[64];
+    if (size != 0) {
+      snprintf(message, sizeof(message), "%s should be a buffer of %zu bytes", name, size);
+    } else {
+      snprintf(message, sizeof(message), "%s should be a buffer", name);
+    }
+    napi_throw_type_error(env, NULL, message);
+    return 0;
+  }
+  if (len != NULL) {
+    *len = (uint32_t)buffer_len;
+  }
+  return 1;
+}
+
+static int get_u64(napi_env env, napi_value value, uint64_t *ret) {
+  udtswap_quote_u128 v;
+  if (!get_u128(env, value, &v)) {
+    return 0;
+  }
+  if (v > UINT64_MAX) {
+    napi_throw_range_error(env, NULL, "capacity, since and fee rate should be unsigned 64 bit integers");
+    return 0;
+  }
+  *ret = (uint64_t)v;
+  return 1;
+}
+
+static int get_property(napi_env env, napi_value object, const char *name, napi_value *value) {
+  napi_valuetype type = napi_undefined;
+  if (napi_get_named_property(env, object, name, value) == napi_ok) {
+    napi_typeof(env, *value, &type);
+  }
+  return type != napi_undefined && type != napi_null;
+}
+//false for a missing, undefined or null property
+
+/*
+ * { codeHash, hashType, args } of buffers and hash type number, buffers are read during the call
+ */
+static int get_script(napi_env env, napi_value value, udtswap_tx_script_t *script) {
+  napi_value field;
+  uint32_t hash_type, len;
+  if (!get_property(env, value, "codeHash", &field)) {
+    napi_throw_type_error(env, NULL, "script should have codeHash, hashType and args");
+    return 0;
+  }
+  if (!get_tx_buffer(env, field, "script codeHash", UDTSWAP_ROUTE_HASH_SIZE, &script->code_hash, NULL)) {
+    return 0;
+  }
+  if (!get_property(env, value, "hashType", &field) || napi_get_value_uint32(env, field, &hash_type) != napi_ok) {
+    napi_throw_type_error(env, NULL, "script hashType should be a number");
+    return 0;
+  }
+  script->hash_type = (uint8_t)hash_type;
+  if (!get_property(env, value, "args", &field)) {
+    script->args = NULL;
+    script->args_len = 0;
+    return 1;
+  }
+  if (!get_tx_buffer(env, field, "script args", 0, &script->args, &len)) {
+    return 0;
+  }
+  script->args_len = len;
+  return 1;
+}
+
+static napi_value tx_error(napi_env env, int ret) {
+  char code[16];
+  snprintf(code, sizeof(code), "%d", ret);
+  napi_throw_error(
+    env,
+    code,
+    ret == UDTSWAP_TX_ERROR_SPACE ? "transaction arena is full" :
+    ret == UDTSWAP_TX_ERROR_LIMIT ? "too many items of transaction" :
+    ret == UDTSWAP_TX_ERROR_INDEX ? "output index out of transaction" : "input capacity is not enough"
+  );
+  return NULL;
+}
+
+static napi_value tx_index(napi_env env, int ret) {
+  napi_value value;
+  if (ret < 0) {
+    return tx_error(env, ret);
+  }
+  napi_create_uint32(env, (uint32_t)ret, &value);
+  return value;
+}
+
+/* (tx), empty transaction in same arena */
+static napi_value tx_reset(napi_env env, napi_callback_info info) {
+  napi_value values[QUOTE_NODE_MAX_ARGS];
+  udtswap_tx_t *tx;
+  if (get_tx_args(env, info, 1, values, &tx)) {
+    udtswap_tx_init(tx, tx->arena, tx->arena_cap);
+  }
+  return NULL;
+}
+
+/* (tx, txHash, index, depType) */
+static napi_value tx_add_cell_dep(napi_env env, napi_callback_info info) {
+  napi_value values[QUOTE_NODE_MAX_ARGS];
+  udtswap_tx_t *tx;
+  const uint8_t *tx_hash;
+  uint32_t index, dep_type;
+  if (!get_tx_args(env, info, 4, values, &tx) || !get_tx_buffer(env, values[1], "txHash", UDTSWAP_ROUTE_HASH_SIZE, &tx_hash, NULL)) {
+    return NULL;
+  }
+  if (napi_get_value_uint32(env, values[2], &index) != napi_ok || napi_get_value_uint32(env, values[3], &dep_type) != napi_ok) {
+    napi_throw_type_error(env, NULL, "index and depType should be numbers");
+    return NULL;
+  }
+  return tx_index(env, udtswap_tx_add_cell_dep(tx, tx_hash, index, (uint8_t)dep_type));
+}
+
+/* (tx, blockHash) */
+static napi_value tx_add_header_dep(napi_env env, napi_callback_info info) {
+  napi_value values[QUOTE_NODE_MAX_ARGS];
+  udtswap_tx_t *tx;
+  const uint8_t *hash;
+  if (!get_tx_args(env, info, 2, values, &tx) || !get_tx_buffer(env, values[1], "block hash", UDTSWAP_ROUTE_HASH_SIZE, &hash, NULL)) {
+    return NULL;
+  }
+  return tx_index(env, udtswap_tx_add_header_dep(tx, hash));
+}
+
+/* (tx, txHash, index, since) */
+static napi_value tx_add_input(napi_env env, napi_callback_info info) {
+  napi_value values[QUOTE_NODE_MAX_ARGS];
+  udtswap_tx_t *tx;
+  const uint8_t *tx_hash;
+  uint32_t index;
+  uint64_t since;
+  if (!get_tx_args(env, info, 4, values, &tx) || !get_tx_buffer(env, values[1], "txHash", UDTSWAP_ROUTE_HASH_SIZE, &tx_hash, NULL)) {
+    return NULL;
+  }
+  if (napi_get_value_uint32(env, values[2], &index) != napi_ok) {
+    napi_throw_type_error(env, NULL, "index should be a number");
+    return NULL;
+  }
+  if (!get_u64(env, values[3], &since)) {
+    return NULL;
+  }
+  return tx_index(env, udtswap_tx_add_input(tx, tx_hash, index, since));
+}
+
+/* (tx, capacity, lock, type or null, data), output index */
+static napi_value tx_add_output(napi_env env, napi_callback_info info) {
+  napi_value values[QUOTE_NODE_MAX_ARGS];
+  udtswap_tx_t *tx;
+  udtswap_tx_script_t lock, type;
+  napi_valuetype type_type;
+  const uint8_t *data;
+  uint64_t capacity;
+  uint32_t data_len;
+  if (!get_tx_args(env, info, 5, values, &tx) || !get_u64(env, values[1], &capacity) || !get_script(env, values[2], &lock)) {
+    return NULL;
+  }
+  napi_typeof(env, values[3], &type_type);
+  int has_type = type_type != napi_null && type_type != napi_undefined;
+  if ((has_type && !get_script(env, values[3], &type)) || !get_tx_buffer(env, values[4], "data", 0, &data, &data_len)) {
+    return NULL;
+  }
+  return tx_index(env, udtswap_tx_add_output(tx, capacity, &lock, has_type ? &type : NULL, data, data_len));
+}
+
+/* (tx, output, capacity) */
+static napi_value tx_set_capacity(napi_env env, napi_callback_info info) {
+  napi_value values[QUOTE_NODE_MAX_ARGS];
+  udtswap_tx_t *tx;
+  uint32_t output;
+  uint64_t capacity;
+  if (!get_tx_args(env, info, 3, values, &tx)) {
+    return NULL;
+  }
+  if (napi_get_value_uint32(env, values[1], &output) != napi_ok) {
+    napi_throw_type_error(env, NULL, "output should be a number");
+    return NULL;
+  }
+  if (!get_u64(env, values[2], &capacity)) {
+    return NULL;
+  }
+  int err = udtswap_tx_set_capacity(tx, output, capacity);
+  return err == 0 ? NULL : tx_error(env, err);
+}
+
+/*
+ * { capacity, type or null, data } of a udt lock cell of pool
+ */
+static int get_pool_udt(napi_env env, napi_value pool, const char *name, udtswap_tx_pool_t *tx_pool, int i, udtswap_tx_script_t *type) {
+  napi_value udt, field;
+  if (!get_property(env, pool, name, &udt) || !get_property(env, udt, "capacity", &field)) {
+    napi_throw_type_error(env, NULL, "pool udt1 and udt2 should have capacity, type and data");
+    return 0;
+  }
+  if (!get_u64(env, field, &tx_pool->udt_capacity[i])) {
+    return 0;
+  }
+  tx_pool->udt_type[i] = NULL;
+  tx_pool->udt_data[i] = NULL;
+  tx_pool->udt_data_len[i] = 0;
+  if (get_property(env, udt, "type", &field)) {
+    if (!get_script(env, field, type)) {
+      return 0;
+    }
+    tx_pool->udt_type[i] = type;
+    if (get_property(env, udt, "data", &field) && !get_tx_buffer(env, field, "pool udt data", 0, &tx_pool->udt_data[i], &tx_pool->udt_data_len[i])) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+/*
+ * (tx, { liveTxHash or null, liveIndex, typeCodeHash, lockCodeHash, lockArgs, typeArgs, capacity, data, udt1, udt2 })
+ * udt1 and udt2 are { capacity, type, data }, type null for a CKB reserve
+ */
+static napi_value tx_add_pool(napi_env env, napi_callback_info info) {
+  napi_value values[QUOTE_NODE_MAX_ARGS], field;
+  udtswap_tx_t *tx;
+  udtswap_tx_pool_t pool;
+  udtswap_tx_script_t udt_types[2];
+  if (!get_tx_args(env, info, 2, values, &tx)) {
+    return NULL;
+  }
+  memset(&pool, 0, sizeof(pool));
+  if (get_property(env, values[1], "liveTxHash", &field)) {
+    if (!get_tx_buffer(env, field, "pool liveTxHash", UDTSWAP_ROUTE_HASH_SIZE, &pool.live_tx_hash, NULL)) {
+      return NULL;
+    }
+    if (!get_property(env, values[1], "liveIndex", &field) || napi_get_value_uint32(env, field, &pool.live_index) != napi_ok) {
+      napi_throw_type_error(env, NULL, "pool liveIndex should be a number");
+      return NULL;
+    }
+  }
+  if (
+    !get_property(env, values[1], "typeCodeHash", &field) ||
+    !get_tx_buffer(env, field, "pool typeCodeHash", UDTSWAP_ROUTE_HASH_SIZE, &pool.type_code_hash, NULL) ||
+    !get_property(env, values[1], "lockCodeHash", &field) ||
+    !get_tx_buffer(env, field, "pool lockCodeHash", UDTSWAP_ROUTE_HASH_SIZE, &pool.lock_code_hash, NULL) ||
+    !get_property(env, values[1], "lockArgs", &field) ||
+    !get_tx_buffer(env, field, "pool lockArgs", UDTSWAP_ROUTE_LOCK_ARGS_SIZE, &pool.lock_args, NULL) ||
+    !get_property(env, values[1], "typeArgs", &field) ||
+    !get_tx_buffer(env, field, "pool typeArgs", 0, &pool.type_args, &pool.type_args_len) ||
+    !get_property(env, values[1], "data", &field) ||
+    !get_tx_buffer(env, field, "pool data", 0, &pool.data, &pool.data_len)
+  ) {
+    bool pending = false;
+    napi_is_exception_pending(env, &pending);
+    if (!pending) {
+      napi_throw_type_error(env, NULL, "pool should have typeCodeHash, lockCodeHash, lockArgs, typeArgs and data buffers");
+    }
+    return NULL;
+  }
+  if (!get_property(env, values[1], "capacity", &field) || !get_u64(env, field, &pool.capacity)) {
+    bool pending = false;
+    napi_is_exception_pending(env, &pending);
+    if (!pending) {
+      napi_throw_type_error(env, NULL, "pool capacity should be a BigInt");
+    }
+    return NULL;
+  }
+  if (!get_pool_udt(env, values[1], "udt1", &pool, 0, &udt_types[0]) || !get_pool_udt(env, values[1], "udt2", &pool, 1, &udt_types[1])) {
+    return NULL;
+  }
+  int err = udtswap_tx_add_pool(tx, &pool);
+  return err == 0 ? NULL : tx_error(env, err);
+}
+
+/* (tx, witness), witness index */
+static napi_value tx_add_witness(napi_env env, napi_callback_info info) {
+  napi_value values[QUOTE_NODE_MAX_ARGS];
+  udtswap_tx_t *tx;
+  const uint8_t *witness;
+  uint32_t len;
+  if (!get_tx_args(env, info, 2, values, &tx) || !get_tx_buffer(env, values[1], "witness", 0, &witness, &len)) {
+    return NULL;
+  }
+  return tx_index(env, udtswap_tx_add_witness(tx, witness, len));
+}
+
+/* (tx), index of WitnessArgs witness of a zero signature */
+static napi_value tx_add_lock_witness(napi_env env, napi_callback_info info) {
+  napi_value values[QUOTE_NODE_MAX_ARGS];
+  udtswap_tx_t *tx;
+  if (!get_tx_args(env, info, 1, values, &tx)) {
+    return NULL;
+  }
+  return tx_index(env, udtswap_tx_add_lock_witness(tx));
+}
+
+/* (tx), serialized size */
+static napi_value tx_size(napi_env env, napi_callback_info info) {
+  napi_value values[QUOTE_NODE_MAX_ARGS], ret;
+  udtswap_tx_t *tx;
+  if (!get_tx_args(env, info, 1, values, &tx)) {
+    return NULL;
+  }
+  napi_create_uint32(env, udtswap_tx_size(tx), &ret);
+  return ret;
+}
+
+/* (tx, feeRate), fee of shannons per 1000 bytes */
+static napi_value tx_fee(napi_env env, napi_callback_info info) {
+  napi_value values[QUOTE_NODE_MAX_ARGS];
+  udtswap_tx_t *tx;
+  uint64_t fee_rate;
+  if (!get_tx_args(env, info, 2, values, &tx) || !get_u64(env, values[1], &fee_rate)) {
+    return NULL;
+  }
+  return new_u128(env, udtswap_tx_fee(tx, fee_rate));
+}
+
+/* (tx, changeOutput, inputCapacity, feeRate), fee, capacity of change output is set */
+static napi_value tx_balance(napi_env env, napi_callback_info info) {
+  napi_value values[QUOTE_NODE_MAX_ARGS];
+  udtswap_tx_t *tx;
+  uint32_t change;
+  uint64_t input_capacity, fee_rate, fee;
+  if (!get_tx_args(env, info, 4, values, &tx)) {
+    return NULL;
+  }
+  if (napi_get_value_uint32(env, values[1], &change) != napi_ok) {
+    napi_throw_type_error(env, NULL, "change output should be a number");
+    return NULL;
+  }
+  if (!get_u64(env, values[2], &input_capacity) || !get_u64(env, values[3], &fee_rate)) {
+    return NULL;
+  }
+  int err = udtswap_tx_balance(tx, change, input_capacity, fee_rate, &fee);
+  return err == 0 ? new_u128(env, fee) : tx_error(env, err);
+}
+
+/* (tx), transaction hash buffer */
+static napi_value tx_hash(napi_env env, napi_callback_info info) {
+  napi_value values[QUOTE_NODE_MAX_ARGS], ret;
+  udtswap_tx_t *tx;
+  void *hash;
+  if (!get_tx_args(env, info, 1, values, &tx)) {
+    return NULL;
+  }
+  napi_create_buffer(env, UDTSWAP_ROUTE_HASH_SIZE, &hash, &ret);
+  udtswap_tx_hash(tx, hash);
+  return ret;
+}
+
+/* (tx), serialized Transaction buffer, written in place */
+static napi_value tx_serialize(napi_env env, napi_callback_info info) {
+  napi_value values[QUOTE_NODE_MAX_ARGS], ret;
+  udtswap_tx_t *tx;
+  void *out;
+  if (!get_tx_args(env, info, 1, values, &tx)) {
+    return NULL;
+  }
+  napi_create_buffer(env, udtswap_tx_size(tx), &out, &ret);
+  udtswap_tx_serialize(tx, out, udtswap_tx_size(tx));
+  return ret;
+}
+
+static void free_signer(napi_env env, void *data, void *hint) {
+  quote_node_signer_t *signer = data;
+  udtswap_signer_free(signer->signer);
+#ifdef UDTSWAP_SIGN_SECP256K1
+  udtswap_secp256k1_free(signer->ctx);
+#endif
+  free(signer);
+}
+
+/*
+ * (threads), signer of threads with calling thread, count of online cores when omitted
+ */
+static napi_value create_signer(napi_env env, napi_callback_info info) {
+  napi_value value, ret;
+  size_t argc = 1;
+  int32_t threads = 0;
+  napi_valuetype type = napi_undefined;
+  udtswap_sign_fn sign = NULL;
+  napi_get_cb_info(env, info, &argc, &value, NULL, NULL);
+  if (argc > 0 && napi_typeof(env, value, &type) == napi_ok && type != napi_undefined) {
+    if (napi_get_value_int32(env, value, &threads) != napi_ok) {
+      napi_throw_type_error(env, NULL, "threads should be a number");
+      return NULL;
+    }
+  }
+  quote_node_signer_t *signer = calloc(1, sizeof(quote_node_signer_t));
+  if (signer == NULL) {
+    napi_throw_error(env, NULL, "signer allocation failed");
+    return NULL;
+  }
+  signer->magic = QUOTE_NODE_SIGNER_MAGIC;
+#ifdef UDTSWAP_SIGN_SECP256K1
+  signer->ctx = udtswap_secp256k1_new();
+  sign = udtswap_secp256k1_sign;
+  if (signer->ctx == NULL) {
+    free(signer);
+    napi_throw_error(env, NULL, "secp256k1 context creation failed");
+    return NULL;
+  }
+#endif
+  signer->signer = udtswap_signer_new(threads, sign, signer->ctx);
+  if (signer->signer == NULL) {
+    free_signer(env, signer, NULL);
+    napi_throw_error(env, NULL, "signer threads creation failed");
+    return NULL;
+  }
+  napi_create_external(env, signer, free_signer, NULL, &ret);
+  return ret;
+}
+
+static int get_sign_job(napi_env env, napi_value value, udtswap_sign_job_t *job) {
+  napi_value field;
+  uint32_t v;
+  if (!get_property(env, value, "tx", &field)) {
+    napi_throw_type_error(env, NULL, "job should have tx, groupStart, groupCount and key");
+    return 0;
+  }
+  if (!get_tx(env, field, &job->tx)) {
+    return 0;
+  }
+  if (!get_property(env, value, "groupStart", &field) || napi_get_value_uint32(env, field, &v) != napi_ok) {
+    napi_throw_type_error(env, NULL, "job groupStart should be a number");
+    return 0;
+  }
+  job->group_start = v;
+  job->group_cnt = 1;
+  if (get_property(env, value, "groupCount", &field)) {
+    if (napi_get_value_uint32(env, field, &v) != napi_ok) {
+      napi_throw_type_error(env, NULL, "job groupCount should be a number");
+      return 0;
+    }
+    job->group_cnt = v;
+  }
+  job->key = NULL;
+  if (get_property(env, value, "key", &field)) {
+    return get_tx_buffer(env, field, "job key", UDTSWAP_SIGN_KEY_SIZE, &job->key, NULL);
+  }
+#ifdef UDTSWAP_SIGN_SECP256K1
+  napi_throw_type_error(env, NULL, "job key should be a buffer of 32 bytes");
+  return 0;
+#else
+  return 1;
+#endif
+}
+//groupCount is 1 when omitted, key is read only by a signing build
+
+/*
+ * (signer, [{ tx, groupStart, groupCount, key }]), message buffers of jobs,
+ * lock witnesses are signed in place when signing is true, keys are buffers of 32 bytes
+ * error of a job is thrown with its code and job index
+ */
+static napi_value sign_txs(napi_env env, napi_callback_info info) {
+  napi_value values[2], value, ret;
+  size_t argc = 2;
+  uint32_t cnt, i;
+  bool is_array = false;
+  napi_valuetype type;
+  quote_node_signer_t *signer = NULL;
+  udtswap_sign_job_t *jobs;
+  int err;
+  napi_get_cb_info(env, info, &argc, values, NULL, NULL);
+  if (argc < 2) {
+    napi_throw_type_error(env, NULL, "wrong number of arguments");
+    return NULL;
+  }
+  if (
+    napi_typeof(env, values[0], &type) != napi_ok || type != napi_external ||
+    napi_get_value_external(env, values[0], (void **)&signer) != napi_ok || signer->magic != QUOTE_NODE_SIGNER_MAGIC
+  ) {
+    napi_throw_type_error(env, NULL, "signer should be created by createSigner");
+    return NULL;
+  }
+  if (napi_is_array(env, values[1], &is_array) != napi_ok || !is_array) {
+    napi_throw_type_error(env, NULL, "jobs should be an array");
+    return NULL;
+  }
+  napi_get_array_length(env, values[1], &cnt);
+  jobs = calloc(cnt > 0 ? cnt : 1, sizeof(udtswap_sign_job_t));
+  if (jobs == NULL) {
+    napi_throw_error(env, NULL, "jobs allocation failed");
+    return NULL;
+  }
+  for (i = 0; i < cnt; i++) {
+    napi_get_element(env, values[1], i, &value);
+    if (!get_sign_job(env, value, &jobs[i])) {
+      free(jobs);
+      return NULL;
+    }
+  }
+  //buffers of keys are held by the jobs array during the call
+
+  err = udtswap_signer_run(signer->signer, jobs, cnt);
+  if (err != 0) {
+    char code[16], message[64];
+    i = 0;
+    while (jobs[i].ret == 0) {
+      i++;
+    }
+    snprintf(code, sizeof(code), "%d", err);
+    snprintf(
+      message, sizeof(message), "%s of job %u",
+      err == UDTSWAP_SIGN_ERROR_WITNESS ? "lock group without lock witness" : "signature failed", i
+    );
+    free(jobs);
+    napi_throw_error(env, code, message);
+    return NULL;
+  }
+  napi_create_array_with_length(env, cnt, &ret);
+  for (i = 0; i < cnt; i++) {
+    void *message;
+    napi_create_buffer_copy(env, UDTSWAP_ROUTE_HASH_SIZE, jobs[i].message, &message, &value);
+    napi_set_element(env, ret, i, value);
+  }
+  free(jobs);
+  return ret;
+}
+
+static napi_value init(napi_env env, napi_value exports) {
+  napi_property_descriptor properties[] = {
+    {"exactInput", NULL, exact_input, NULL, NULL, NULL, napi_enumerable, NULL},
+    {"exactOutput", NULL, exact_output, NULL, NULL, NULL, napi_enumerable, NULL},
+    {"addLiquidity", NULL, add_liquidity, NULL, NULL, NULL, napi_enumerable, NULL},
+    {"removeLiquidity", NULL, remove_liquidity, NULL, NULL, NULL, napi_enumerable, NULL},
+    {"createPools", NULL, create_pools, NULL, NULL, NULL, napi_enumerable, NULL},
+    {"setPool", NULL, set_pool, NULL, NULL, NULL, napi_enumerable, NULL},
+    {"exactInputPools", NULL, exact_input_pools, NULL, NULL, NULL, napi_enumerable, NULL},
+    {"exactOutputPools", NULL, exact_output_pools, NULL, NULL, NULL, napi_enumerable, NULL},
+    {"exactInputAmounts", NULL, exact_input_amounts, NULL, NULL, NULL, napi_enumerable, NULL},
+    {"exactOutputAmounts", NULL, exact_output_amounts, NULL, NULL, NULL, napi_enumerable, NULL},
+    {"createGraph", NULL, create_graph, NULL, NULL, NULL, napi_enumerable, NULL},
+    {"addPool", NULL, add_pool, NULL, NULL, NULL, napi_enumerable, NULL},
+    {"updatePool", NULL, update_pool, NULL, NULL, NULL, napi_enumerable, NULL},
+    {"bestRoute", NULL, best_route, NULL, NULL, NULL, napi_enumerable, NULL},
+    {"shardRoute", NULL, shard_route, NULL, NULL, NULL, napi_enumerable, NULL},
+    {"writeSnapshot", NULL, write_snapshot, NULL, NULL, NULL, napi_enumerable, NULL},
+    {"loadSnapshot", NULL, load_snapshot, NULL, NULL, NULL, napi_enumerable, NULL},
+    {"createTx", NULL, create_tx, NULL, NULL, NULL, napi_enumerable, NULL},
+    {"txReset", NULL, tx_reset, NULL, NULL, NULL, napi_enumerable, NULL},
+    {"txAddCellDep", NULL, tx_add_cell_dep, NULL, NULL, NULL, napi_enumerable, NULL},
+    {"txAddHeaderDep", NULL, tx_add_header_dep, NULL, NULL, NULL, napi_enumerable, NULL},
+    {"txAddInput", NULL, tx_add_input, NULL, NULL, NULL, napi_enumerable, NULL},
+    {"txAddOutput", NULL, tx_add_output, NULL, NULL, NULL, napi_enumerable, NULL},
+    {"txSetCapacity", NULL, tx_set_capacity, NULL, NULL, NULL, napi_enumerable, NULL},
+    {"txAddPool", NULL, tx_add_pool, NULL, NULL, NULL, napi_enumerable, NULL},
+    {"txAddWitness", NULL, tx_add_witness, NULL, NULL, NULL, napi_enumerable, NULL},
+    {"txAddLockWitness", NULL, tx_add_lock_witness, NULL, NULL, NULL, napi_enumerable, NULL},
+    {"txSize", NULL, tx_size, NULL, NULL, NULL, napi_enumerable, NULL},
+    {"txFee", NULL, tx_fee, NULL, NULL, NULL, napi_enumerable, NULL},
+    {"txBalance", NULL, tx_balance, NULL, NULL, NULL, napi_enumerable, NULL},
+    {"txHash", NULL, tx_hash, NULL, NULL, NULL, napi_enumerable, NULL},
+    {"txSerialize", NULL, tx_serialize, NULL, NULL, NULL, napi_enumerable, NULL},
+    {"createSigner", NULL, create_signer, NULL, NULL, NULL, napi_enumerable, NULL},
+    {"signTxs", NULL, sign_txs, NULL, NULL, NULL, napi_enumerable, NULL},
+  };
+  napi_value version, simd, signing;
+  napi_define_properties(env, exports, sizeof(properties) / sizeof(properties[0]), properties);
+  napi_create_int32(env, udtswap_quote_version(), &version);
+  napi_set_named_property(env, exports, "version", version);
+  napi_create_int32(env, udtswap_quote_simd(UDTSWAP_QUOTE_SIMD_AVX512), &simd);
+  napi_set_named_property(env, exports, "simd", simd);
+#ifdef UDTSWAP_SIGN_SECP256K1
+  napi_get_boolean(env, true, &signing);
+#else
+  napi_get_boolean(env, false, &signing);
+#endif
+  napi_set_named_property(env, exports, "signing", signing);
+  return exports;
+}
+
+NAPI_MODULE(NODE_GYP_MODULE_NAME, init)
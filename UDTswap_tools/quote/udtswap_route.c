@@ -0,0 +1,646 @@
+/*
+ * route search of UDTswap pools
+ * pools are kept as a quote pool table, every swap of a route is a batch quote of one amount,
+ * so routes have the pool cell checks of batch quotes
+ * paths are searched depth first over udts, a udt is searched again only when it is reached by a larger amount
+ * than by paths of same or fewer hops before, so a path blocked by udts of the larger path may be missed
+ * shard routes are 1 hop over pools of one pair, best split or a shard of the key
+ */
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../../UDTswap_scripts/ckb_consts.h"
+#include "../../UDTswap_scripts/udtswap_common.h"
+#include "udtswap_route.h"
+
+#define ROUTE_NO_UDT 0xffffffff
+#define ROUTE_CLOCK_PATHS 64
+#define ROUTE_BPS 10000
+
+typedef struct {
+  uint32_t from;
+  uint32_t to;
+  uint32_t pool;
+  int direction;
+} route_entry_t;
+
+/*
+ * pools of pair from -> to, pool ids are entries[first] ~ entries[first + cnt - 1]
+ */
+typedef struct {
+  uint32_t to;
+  uint32_t first;
+  uint32_t cnt;
+} route_edge_t;
+
+struct udtswap_route_graph {
+  uint8_t (*udts)[UDTSWAP_ROUTE_HASH_SIZE];
+  uint32_t udt_cnt;
+  uint32_t udt_cap;
+  uint32_t *slots;
+  uint32_t slot_cap;
+  udtswap_quote_pools_t table;
+  udtswap_quote_u128 *udt1_reserve;
+  udtswap_quote_u128 *udt2_reserve;
+  udtswap_quote_u128 *total_liquidity;
+  uint8_t *kind;
+  uint32_t (*pool_udts)[2];
+  uint32_t pool_cap;
+  int dirty;
+  route_entry_t *entries;
+  route_edge_t *edges;
+  uint32_t edge_cnt;
+  uint32_t *edge_start;
+};
+
+/*
+ * search state, path of udts and best amounts reaching udts
+ */
+typedef struct {
+  udtswap_route_graph_t *graph;
+  uint32_t target;
+  int max_hops;
+  int max_split;
+  uint64_t deadline;
+  udtswap_route_t *best;
+  udtswap_route_t current;
+  uint8_t *on_path;
+  udtswap_quote_u128 *reached;
+} route_search_t;
+
+static uint64_t route_now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static udtswap_quote_u128 route_u128(const uint8_t *p) {
+  udtswap_quote_u128 v = 0;
+  int i;
+  for (i = 15; i >= 0; i--) {
+    v = (v << 8) | p[i];
+  }
+  return v;
+}
+
+static uint32_t route_slot(const uint8_t hash[UDTSWAP_ROUTE_HASH_SIZE], uint32_t slot_cap) {
+  uint32_t h;
+  memcpy(&h, hash + UDTSWAP_ROUTE_HASH_SIZE - sizeof(h), sizeof(h));
+  return (h ^ hash[0]) & (slot_cap - 1);
+}
+//type hashes are blake2b, any 4 bytes are uniform, CKB zero hash is slot 0
+
+static uint32_t route_find_udt(const udtswap_route_graph_t *graph, const uint8_t hash[UDTSWAP_ROUTE_HASH_SIZE]) {
+  uint32_t slot;
+  if (graph->slot_cap == 0) {
+    return ROUTE_NO_UDT;
+  }
+  for (slot = route_slot(hash, graph->slot_cap); graph->slots[slot] != ROUTE_NO_UDT; slot = (slot + 1) & (graph->slot_cap - 1)) {
+    if (memcmp(graph->udts[graph->slots[slot]], hash, UDTSWAP_ROUTE_HASH_SIZE) == 0) {
+      return graph->slots[slot];
+    }
+  }
+  return ROUTE_NO_UDT;
+}
+
+static int route_grow_slots(udtswap_route_graph_t *graph) {
+  uint32_t slot_cap = graph->slot_cap == 0 ? 64 : graph->slot_cap * 2;
+  uint32_t *slots = malloc(slot_cap * sizeof(uint32_t));
+  uint32_t i, slot;
+  if (slots == NULL) {
+    return UDTSWAP_ROUTE_ERROR_ALLOC;
+  }
+  memset(slots, 0xff, slot_cap * sizeof(uint32_t));
+  for (i = 0; i < graph->udt_cnt; i++) {
+    for (slot = route_slot(graph->udts[i], slot_cap); slots[slot] != ROUTE_NO_UDT; slot = (slot + 1) & (slot_cap - 1)) {
+    }
+    slots[slot] = i;
+  }
+  free(graph->slots);
+  graph->slots = slots;
+  graph->slot_cap = slot_cap;
+  return CKB_SUCCESS;
+}
+
+static int route_add_udt(udtswap_route_graph_t *graph, const uint8_t hash[UDTSWAP_ROUTE_HASH_SIZE], uint32_t *udt) {
+  uint32_t slot;
+  *udt = route_find_udt(graph, hash);
+  if (*udt != ROUTE_NO_UDT) {
+    return CKB_SUCCESS;
+  }
+  if (graph->udt_cnt == graph->udt_cap) {
+    uint32_t udt_cap = graph->udt_cap == 0 ? 32 : graph->udt_cap * 2;
+    void *udts = realloc(graph->udts, (size_t)udt_cap * UDTSWAP_ROUTE_HASH_SIZE);
+    if (udts == NULL) {
+      return UDTSWAP_ROUTE_ERROR_ALLOC;
+    }
+    graph->udts = udts;
+    graph->udt_cap = udt_cap;
+  }
+  if ((graph->udt_cnt + 1) * 2 > graph->slot_cap && route_grow_slots(graph) != CKB_SUCCESS) {
+    return UDTSWAP_ROUTE_ERROR_ALLOC;
+  }
+  memcpy(graph->udts[graph->udt_cnt], hash, UDTSWAP_ROUTE_HASH_SIZE);
+  for (slot = route_slot(hash, graph->slot_cap); graph->slots[slot] != ROUTE_NO_UDT; slot = (slot + 1) & (graph->slot_cap - 1)) {
+  }
+  graph->slots[slot] = graph->udt_cnt;
+  *udt = graph->udt_cnt++;
+  return CKB_SUCCESS;
+}
+//slots are at most half full
+
+static int route_grow_pools(udtswap_route_graph_t *graph) {
+  uint32_t pool_cap = graph->pool_cap == 0 ? 64 : graph->pool_cap * 2;
+  void *udt1_reserve = realloc(graph->udt1_reserve, pool_cap * sizeof(udtswap_quote_u128));
+  if (udt1_reserve != NULL) graph->udt1_reserve = udt1_reserve;
+  void *udt2_reserve = realloc(graph->udt2_reserve, pool_cap * sizeof(udtswap_quote_u128));
+  if (udt2_reserve != NULL) graph->udt2_reserve = udt2_reserve;
+  void *total_liquidity = realloc(graph->total_liquidity, pool_cap * sizeof(udtswap_quote_u128));
+  if (total_liquidity != NULL) graph->total_liquidity = total_liquidity;
+  void *kind = realloc(graph->kind, pool_cap);
+  if (kind != NULL) graph->kind = kind;
+  void *pool_udts = realloc(graph->pool_udts, pool_cap * sizeof(graph->pool_udts[0]));
+  if (pool_udts != NULL) graph->pool_udts = pool_udts;
+  if (udt1_reserve == NULL || udt2_reserve == NULL || total_liquidity == NULL || kind == NULL || pool_udts == NULL) {
+    return UDTSWAP_ROUTE_ERROR_ALLOC;
+  }
+  graph->pool_cap = pool_cap;
+  graph->table.udt1_reserve = graph->udt1_reserve;
+  graph->table.udt2_reserve = graph->udt2_reserve;
+  graph->table.total_liquidity = graph->total_liquidity;
+  graph->table.kind = graph->kind;
+  return CKB_SUCCESS;
+}
+
+udtswap_route_graph_t *udtswap_route_graph_new(void) {
+  return calloc(1, sizeof(udtswap_route_graph_t));
+}
+
+void udtswap_route_graph_free(udtswap_route_graph_t *graph) {
+  if (graph == NULL) {
+    return;
+  }
+  free(graph->udts);
+  free(graph->slots);
+  free(graph->udt1_reserve);
+  free(graph->udt2_reserve);
+  free(graph->total_liquidity);
+  free(graph->kind);
+  free(graph->pool_udts);
+  free(graph->entries);
+  free(graph->edges);
+  free(graph->edge_start);
+  free(graph);
+}
+
+/*
+ * actual reserves of pool data, reserves below empty pool reserve are 0 and rejected by quotes
+ */
+static int route_set_data(udtswap_route_graph_t *graph, uint32_t pool, const uint8_t *data, size_t data_len) {
+  int kind = graph->kind[pool];
+  udtswap_quote_u128 udt1_default = kind == UDTSWAP_PAIR_CKB_UDT || kind == UDTSWAP_PAIR_CKB_CKB ? CKB_RESERVE_DEFAULT : UDT_RESERVE_DEFAULT;
+  udtswap_quote_u128 udt2_default = kind == UDTSWAP_PAIR_UDT_CKB || kind == UDTSWAP_PAIR_CKB_CKB ? CKB_RESERVE_DEFAULT : UDT_RESERVE_DEFAULT;
+  if (data_len < UDTSWAP_DATA_SIZE) {
+    return UDTSWAP_ROUTE_ERROR_DATA;
+  }
+  udtswap_quote_u128 udt1_reserve = route_u128(data + UDTSWAP_DATA_UDT1_RESERVE_START);
+  udtswap_quote_u128 udt2_reserve = route_u128(data + UDTSWAP_DATA_UDT2_RESERVE_START);
+  graph->udt1_reserve[pool] = udt1_reserve > udt1_default ? udt1_reserve - udt1_default : 0;
+  graph->udt2_reserve[pool] = udt2_reserve > udt2_default ? udt2_reserve - udt2_default : 0;
+  graph->total_liquidity[pool] = route_u128(data + UDTSWAP_DATA_TOTAL_LIQUIDITY_START);
+  return CKB_SUCCESS;
+}
+
+int udtswap_route_graph_add_pool(
+  udtswap_route_graph_t *graph,
+  const uint8_t lock_args[UDTSWAP_ROUTE_LOCK_ARGS_SIZE],
+  const uint8_t *data,
+  size_t data_len,
+  uint32_t *pool
+) {
+  static const uint8_t ckb[UDTSWAP_ROUTE_HASH_SIZE] = {0};
+  uint32_t udt1, udt2, id = (uint32_t)graph->table.cnt;
+  if (data_len < UDTSWAP_DATA_SIZE) {
+    return UDTSWAP_ROUTE_ERROR_DATA;
+  }
+  if (id == graph->pool_cap && route_grow_pools(graph) != CKB_SUCCESS) {
+    return UDTSWAP_ROUTE_ERROR_ALLOC;
+  }
+  if (
+    route_add_udt(graph, lock_args, &udt1) != CKB_SUCCESS ||
+    route_add_udt(graph, lock_args + UDTSWAP_ROUTE_HASH_SIZE, &udt2) != CKB_SUCCESS
+  ) {
+    return UDTSWAP_ROUTE_ERROR_ALLOC;
+  }
+  int is_ckb1 = memcmp(lock_args, ckb, UDTSWAP_ROUTE_HASH_SIZE) == 0;
+  int is_ckb2 = memcmp(lock_args + UDTSWAP_ROUTE_HASH_SIZE, ckb, UDTSWAP_ROUTE_HASH_SIZE) == 0;
+  graph->kind[id] = is_ckb1 && is_ckb2 ? UDTSWAP_PAIR_CKB_CKB : is_ckb1 ? UDTSWAP_PAIR_CKB_UDT : is_ckb2 ? UDTSWAP_PAIR_UDT_CKB : UDTSWAP_PAIR_UDT_UDT;
+  graph->pool_udts[id][0] = udt1;
+  graph->pool_udts[id][1] = udt2;
+  route_set_data(graph, id, data, data_len);
+  graph->table.cnt = id + 1;
+  graph->dirty = 1;
+  *pool = id;
+  return CKB_SUCCESS;
+}
+//pair kind as udtswap_pair_kind of type script
+
+int udtswap_route_graph_update_pool(udtswap_route_graph_t *graph, uint32_t pool, const uint8_t *data, size_t data_len) {
+  if (pool >= graph->table.cnt) {
+    return UDTSWAP_ROUTE_ERROR_POOL;
+  }
+  return route_set_data(graph, pool, data, data_len);
+}
+
+size_t udtswap_route_graph_pool_count(const udtswap_route_graph_t *graph) {
+  return graph->table.cnt;
+}
+
+static int route_entry_cmp(const void *a, const void *b) {
+  const route_entry_t *x = a, *y = b;
+  if (x->from != y->from) {
+    return x->from < y->from ? -1 : 1;
+  }
+  if (x->to != y->to) {
+    return x->to < y->to ? -1 : 1;
+  }
+  return x->pool < y->pool ? -1 : x->pool > y->pool;
+}
+
+/*
+ * edges of pairs from every udt, pools of a pair with same udts (CKB/CKB) are not edges
+ */
+static int route_build(udtswap_route_graph_t *graph) {
+  size_t entry_cnt = 0, i;
+  uint32_t u;
+  free(graph->entries);
+  free(graph->edges);
+  free(graph->edge_start);
+  graph->entries = malloc((graph->table.cnt * 2 + 1) * sizeof(route_entry_t));
+  graph->edges = malloc((graph->table.cnt * 2 + 1) * sizeof(route_edge_t));
+  graph->edge_start = malloc((graph->udt_cnt + 1) * sizeof(uint32_t));
+  graph->edge_cnt = 0;
+  if (graph->entries == NULL || graph->edges == NULL || graph->edge_start == NULL) {
+    return UDTSWAP_ROUTE_ERROR_ALLOC;
+  }
+  for (i = 0; i < graph->table.cnt; i++) {
+    uint32_t udt1 = graph->pool_udts[i][0], udt2 = graph->pool_udts[i][1];
+    if (udt1 == udt2) {
+      continue;
+    }
+    route_entry_t forward = {udt1, udt2, (uint32_t)i, UDTSWAP_QUOTE_UDT1_INPUT};
+    route_entry_t backward = {udt2, udt1, (uint32_t)i, UDTSWAP_QUOTE_UDT2_INPUT};
+    graph->entries[entry_cnt++] = forward;
+    graph->entries[entry_cnt++] = backward;
+  }
+  qsort(graph->entries, entry_cnt, sizeof(route_entry_t), route_entry_cmp);
+  for (u = 0, i = 0; u <= graph->udt_cnt; u++) {
+    graph->edge_start[u] = graph->edge_cnt;
+    while (u < graph->udt_cnt && i < entry_cnt && graph->entries[i].from == u) {
+      route_edge_t *edge = &graph->edges[graph->edge_cnt++];
+      edge->to = graph->entries[i].to;
+      edge->first = (uint32_t)i;
+      edge->cnt = 0;
+      while (i < entry_cnt && graph->entries[i].from == u && graph->entries[i].to == edge->to) {
+        edge->cnt += 1;
+        i++;
+      }
+    }
+  }
+  graph->dirty = 0;
+  return CKB_SUCCESS;
+}
+
+static udtswap_quote_u128 route_quote(route_search_t *search, const route_entry_t *entry, udtswap_quote_u128 amount) {
+  udtswap_quote_u128 output;
+  int ret;
+  udtswap_quote_exact_input_amounts(&search->graph->table, entry->pool, entry->direction, &amount, 1, &output, &ret);
+  return ret == CKB_SUCCESS ? output : 0;
+}
+
+/*
+ * split of amount across pools of a pair
+ * marginal outputs of constant product pools are same at the split,
+ * a = (sqrt(r * 997 * x * y) - x * 1000) / 997 of input reserve x and output reserve y,
+ * pools of larger y / x are taken first while their share is positive
+ */
+static int route_split(
+  route_search_t *search,
+  const route_edge_t *edge,
+  udtswap_quote_u128 amount,
+  udtswap_route_leg_t legs[],
+  int max_legs
+) {
+  const udtswap_quote_pools_t *table = &search->graph->table;
+  const route_entry_t *entries = &search->graph->entries[edge->first];
+  long double x[UDTSWAP_ROUTE_MAX_SPLIT], y[UDTSWAP_ROUTE_MAX_SPLIT], root[UDTSWAP_ROUTE_MAX_SPLIT];
+  uint32_t order[UDTSWAP_ROUTE_MAX_SPLIT];
+  int cnt = 0, active, i;
+  uint32_t e;
+
+  for (e = 0; e < edge->cnt; e++) {
+    const route_entry_t *entry = &entries[e];
+    int rev = entry->direction == UDTSWAP_QUOTE_UDT2_INPUT;
+    long double in_r = (long double)(rev ? table->udt2_reserve[entry->pool] : table->udt1_reserve[entry->pool]);
+    long double out_r = (long double)(rev ? table->udt1_reserve[entry->pool] : table->udt2_reserve[entry->pool]);
+    if (in_r <= 0 || out_r <= 0 || table->total_liquidity[entry->pool] == 0) {
+      continue;
+    }
+    if (cnt == max_legs && out_r * x[cnt - 1] <= y[cnt - 1] * in_r) {
+      continue;
+    }
+    i = cnt < max_legs ? cnt++ : max_legs - 1;
+    for (; i > 0 && out_r * x[i - 1] > y[i - 1] * in_r; i--) {
+      x[i] = x[i - 1];
+      y[i] = y[i - 1];
+      order[i] = order[i - 1];
+    }
+    x[i] = in_r;
+    y[i] = out_r;
+    order[i] = e;
+  }
+  //pools of largest y / x, sorted
+
+  long double total = (long double)amount * LIQUIDITY_POOL_EXCEPT_FEE, sum_x = 0, sum_root = 0, r = 0;
+  for (active = 0; active < cnt; active++) {
+    root[active] = sqrtl(x[active] * y[active] * LIQUIDITY_POOL_EXCEPT_FEE * 1000);
+    long double next_r = (total + (sum_x + x[active]) * 1000) / (sum_root + root[active]);
+    if (active > 0 && next_r * root[active] <= x[active] * 1000) {
+      break;
+    }
+    sum_x += x[active];
+    sum_root += root[active];
+    r = next_r;
+  }
+
+  udtswap_quote_u128 rest = amount;
+  int leg_cnt = 0;
+  for (i = 0; i < active; i++) {
+    long double share = (r * root[i] - x[i] * 1000) / LIQUIDITY_POOL_EXCEPT_FEE;
+    udtswap_quote_u128 a = share <= 0 ? 0 : share >= (long double)rest ? rest : (udtswap_quote_u128)share;
+    if (i == active - 1) {
+      a = rest;
+    }
+    if (a == 0) {
+      continue;
+    }
+    legs[leg_cnt].pool = entries[order[i]].pool;
+    legs[leg_cnt].direction = entries[order[i]].direction;
+    legs[leg_cnt].input_amount = a;
+    rest -= a;
+    leg_cnt++;
+  }
+  //rounding rest goes to last pool of split
+  return leg_cnt;
+}
+
+/*
+ * output of a hop, best pool or split, legs of hop are in current route
+ */
+static udtswap_quote_u128 route_hop(route_search_t *search, const route_edge_t *edge, udtswap_quote_u128 amount, int hop) {
+  const route_entry_t *entries = &search->graph->entries[edge->first];
+  udtswap_route_leg_t *legs = search->current.legs[hop];
+  udtswap_route_leg_t split[UDTSWAP_ROUTE_MAX_SPLIT];
+  udtswap_quote_u128 best = 0, output;
+  uint32_t e;
+  int i, leg_cnt;
+
+  search->current.leg_cnt[hop] = 0;
+  for (e = 0; e < edge->cnt; e++) {
+    output = route_quote(search, &entries[e], amount);
+    if (output > best) {
+      best = output;
+      legs[0].pool = entries[e].pool;
+      legs[0].direction = entries[e].direction;
+      legs[0].input_amount = amount;
+      legs[0].output_amount = output;
+      search->current.leg_cnt[hop] = 1;
+    }
+  }
+  if (search->max_split < 2 || edge->cnt < 2 || best == 0) {
+    return best;
+  }
+  leg_cnt = route_split(search, edge, amount, split, search->max_split);
+  if (leg_cnt < 2) {
+    return best;
+  }
+  output = 0;
+  for (i = 0; i < leg_cnt; i++) {
+    route_entry_t entry = {0, 0, split[i].pool, split[i].direction};
+    split[i].output_amount = route_quote(search, &entry, split[i].input_amount);
+    if (split[i].output_amount == 0) {
+      return best;
+    }
+    output += split[i].output_amount;
+  }
+  if (output > best) {
+    memcpy(legs, split, leg_cnt * sizeof(udtswap_route_leg_t));
+    search->current.leg_cnt[hop] = leg_cnt;
+    best = output;
+  }
+  return best;
+}
+//split is taken only when its exact quotes are more than best pool
+
+static int route_expired(route_search_t *search) {
+  if (search->best->timed_out) {
+    return 1;
+  }
+  if (search->deadline != 0 && search->current.paths % ROUTE_CLOCK_PATHS == 0 && route_now_ns() >= search->deadline) {
+    search->best->timed_out = 1;
+  }
+  return search->best->timed_out;
+}
+
+/*
+ * udt reached by same or larger amount at same or fewer hops is not searched again
+ */
+static int route_dominated(route_search_t *search, uint32_t udt, udtswap_quote_u128 amount, int hops) {
+  udtswap_quote_u128 *reached = &search->reached[(size_t)udt * (UDTSWAP_ROUTE_MAX_HOPS + 1)];
+  int h;
+  for (h = 1; h <= hops; h++) {
+    if (reached[h] >= amount) {
+      return 1;
+    }
+  }
+  reached[hops] = amount;
+  return 0;
+}
+
+static void route_search(route_search_t *search, uint32_t udt, udtswap_quote_u128 amount, int hop) {
+  const udtswap_route_graph_t *graph = search->graph;
+  uint32_t e;
+
+  search->on_path[udt] = 1;
+  for (e = graph->edge_start[udt]; e < graph->edge_start[udt + 1]; e++) {
+    const route_edge_t *edge = &graph->edges[e];
+    if (search->on_path[edge->to]) {
+      continue;
+    }
+    search->current.paths += 1;
+    if (route_expired(search)) {
+      break;
+    }
+    udtswap_quote_u128 output = route_hop(search, edge, amount, hop);
+    if (output == 0) {
+      continue;
+    }
+    if (edge->to == search->target) {
+      if (output > search->best->output_amount) {
+        search->current.hop_cnt = hop + 1;
+        search->current.output_amount = output;
+        *search->best = search->current;
+      }
+      continue;
+    }
+    if (hop + 1 >= search->max_hops || route_dominated(search, edge->to, output, hop + 1)) {
+      continue;
+    }
+    route_search(search, edge->to, output, hop + 1);
+  }
+  search->on_path[udt] = 0;
+}
+
+int udtswap_route_best(
+  udtswap_route_graph_t *graph,
+  const uint8_t input_udt[UDTSWAP_ROUTE_HASH_SIZE],
+  const uint8_t output_udt[UDTSWAP_ROUTE_HASH_SIZE],
+  udtswap_quote_u128 input_amount,
+  const udtswap_route_options_t *options,
+  udtswap_route_t *route
+) {
+  route_search_t search;
+  uint32_t from = route_find_udt(graph, input_udt);
+
+  memset(route, 0, sizeof(udtswap_route_t));
+  route->input_amount = input_amount;
+  memset(&search, 0, sizeof(search));
+  search.target = route_find_udt(graph, output_udt);
+  if (from == ROUTE_NO_UDT || search.target == ROUTE_NO_UDT || from == search.target || input_amount == 0) {
+    return UDTSWAP_ROUTE_ERROR_NO_ROUTE;
+  }
+  if (graph->dirty && route_build(graph) != CKB_SUCCESS) {
+    return UDTSWAP_ROUTE_ERROR_ALLOC;
+  }
+  search.graph = graph;
+  search.max_hops = options->max_hops < 1 ? 1 : options->max_hops > UDTSWAP_ROUTE_MAX_HOPS ? UDTSWAP_ROUTE_MAX_HOPS : options->max_hops;
+  search.max_split = options->max_split < 1 ? 1 : options->max_split > UDTSWAP_ROUTE_MAX_SPLIT ? UDTSWAP_ROUTE_MAX_SPLIT : options->max_split;
+  search.deadline = options->budget_ns == 0 ? 0 : route_now_ns() + options->budget_ns;
+  search.best = route;
+  search.current.input_amount = input_amount;
+  search.on_path = calloc(graph->udt_cnt, 1);
+  search.reached = calloc((size_t)graph->udt_cnt * (UDTSWAP_ROUTE_MAX_HOPS + 1), sizeof(udtswap_quote_u128));
+  if (search.on_path == NULL || search.reached == NULL) {
+    free(search.on_path);
+    free(search.reached);
+    return UDTSWAP_ROUTE_ERROR_ALLOC;
+  }
+  route_search(&search, from, input_amount, 0);
+  route->paths = search.current.paths;
+  free(search.on_path);
+  free(search.reached);
+  return route->output_amount == 0 ? UDTSWAP_ROUTE_ERROR_NO_ROUTE : CKB_SUCCESS;
+}
+
+static const route_edge_t *route_find_edge(const udtswap_route_graph_t *graph, uint32_t from, uint32_t to) {
+  uint32_t lo = graph->edge_start[from], hi = graph->edge_start[from + 1];
+  while (lo < hi) {
+    uint32_t mid = lo + (hi - lo) / 2;
+    if (graph->edges[mid].to < to) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo < graph->edge_start[from + 1] && graph->edges[lo].to == to ? &graph->edges[lo] : NULL;
+}
+//edges of a udt are sorted by output udt
+
+static uint64_t route_mix(uint64_t h) {
+  h ^= h >> 30;
+  h *= 0xbf58476d1ce4e5b9ULL;
+  h ^= h >> 27;
+  h *= 0x94d049bb133111ebULL;
+  return h ^ (h >> 31);
+}
+
+/*
+ * rendezvous hash of key and pool, shard of largest hash is taken
+ */
+static uint64_t route_shard_hash(const uint8_t key[UDTSWAP_ROUTE_HASH_SIZE], uint32_t pool) {
+  uint64_t h = 0, word;
+  int i;
+  for (i = 0; i < UDTSWAP_ROUTE_HASH_SIZE; i += (int)sizeof(word)) {
+    memcpy(&word, key + i, sizeof(word));
+    h = route_mix(h ^ word);
+  }
+  return route_mix(h ^ ((uint64_t)pool + 1) * 0x9e3779b97f4a7c15ULL);
+}
+
+int udtswap_route_shard(
+  udtswap_route_graph_t *graph,
+  const uint8_t input_udt[UDTSWAP_ROUTE_HASH_SIZE],
+  const uint8_t output_udt[UDTSWAP_ROUTE_HASH_SIZE],
+  udtswap_quote_u128 input_amount,
+  const uint8_t key[UDTSWAP_ROUTE_HASH_SIZE],
+  const udtswap_route_shard_options_t *options,
+  udtswap_route_t *route
+) {
+  route_search_t search;
+  const route_edge_t *edge;
+  uint32_t from = route_find_udt(graph, input_udt), target = route_find_udt(graph, output_udt), e;
+  uint32_t tolerance = options->tolerance_bps > ROUTE_BPS ? ROUTE_BPS : options->tolerance_bps;
+  uint64_t shard_hash = 0;
+  int shard = 0;
+
+  memset(route, 0, sizeof(udtswap_route_t));
+  route->input_amount = input_amount;
+  if (from == ROUTE_NO_UDT || target == ROUTE_NO_UDT || from == target || input_amount == 0) {
+    return UDTSWAP_ROUTE_ERROR_NO_ROUTE;
+  }
+  if (graph->dirty && route_build(graph) != CKB_SUCCESS) {
+    return UDTSWAP_ROUTE_ERROR_ALLOC;
+  }
+  if ((edge = route_find_edge(graph, from, target)) == NULL) {
+    return UDTSWAP_ROUTE_ERROR_NO_ROUTE;
+  }
+  memset(&search, 0, sizeof(search));
+  search.graph = graph;
+  search.target = target;
+  search.max_hops = 1;
+  search.max_split = options->max_split < 1 ? 1 : options->max_split > UDTSWAP_ROUTE_MAX_SPLIT ? UDTSWAP_ROUTE_MAX_SPLIT : options->max_split;
+  search.best = route;
+  search.current.input_amount = input_amount;
+  udtswap_quote_u128 output = route_hop(&search, edge, input_amount, 0);
+  if (output == 0) {
+    return UDTSWAP_ROUTE_ERROR_NO_ROUTE;
+  }
+  udtswap_quote_u128 floor = output - output / ROUTE_BPS * tolerance - output % ROUTE_BPS * tolerance / ROUTE_BPS;
+  //output of best split or pool less tolerance, without overflow of output * tolerance
+
+  for (e = 0; e < edge->cnt; e++) {
+    const route_entry_t *entry = &graph->entries[edge->first + e];
+    udtswap_quote_u128 shard_output = route_quote(&search, entry, input_amount);
+    uint64_t h = route_shard_hash(key, entry->pool);
+    if (shard_output == 0 || shard_output < floor || (shard && h <= shard_hash)) {
+      continue;
+    }
+    shard = 1;
+    shard_hash = h;
+    search.current.leg_cnt[0] = 1;
+    search.current.legs[0][0].pool = entry->pool;
+    search.current.legs[0][0].direction = entry->direction;
+    search.current.legs[0][0].input_amount = input_amount;
+    search.current.legs[0][0].output_amount = shard_output;
+    output = shard_output;
+  }
+  //no shard within tolerance keeps the split
+
+  search.current.hop_cnt = 1;
+  search.current.output_amount = output;
+  search.current.paths = 1;
+  *route = search.current;
+  return CKB_SUCCESS;
+}
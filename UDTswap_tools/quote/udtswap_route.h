@@ -0,0 +1,113 @@
+#ifndef UDTSWAP_ROUTE_H_
+#define UDTSWAP_ROUTE_H_
+
+/*
+ * route search of UDTswap pools, part of quote library
+ *
+ * graph is built from pool cells, udt type hashes of lock args and reserves of pool data
+ * CKB is zero type hash, as lock args
+ * route is a path of hops from input udt to output udt, every hop swaps in one pool,
+ * or splits its input across pools of same pair
+ * amounts of route are quotes of udtswap_quote_exact_input, each pool is in a route at most once
+ */
+#include "udtswap_quote.h"
+
+#define UDTSWAP_ROUTE_HASH_SIZE 32
+#define UDTSWAP_ROUTE_LOCK_ARGS_SIZE 64
+#define UDTSWAP_ROUTE_MAX_HOPS 4
+#define UDTSWAP_ROUTE_MAX_SPLIT 16
+
+#define UDTSWAP_ROUTE_ERROR_ALLOC -1
+#define UDTSWAP_ROUTE_ERROR_POOL -2
+#define UDTSWAP_ROUTE_ERROR_DATA -3
+#define UDTSWAP_ROUTE_ERROR_NO_ROUTE -4
+
+typedef struct udtswap_route_graph udtswap_route_graph_t;
+
+/*
+ * max_hops : 1 ~ UDTSWAP_ROUTE_MAX_HOPS
+ * max_split : pools of one hop, 1 is no split, up to UDTSWAP_ROUTE_MAX_SPLIT
+ * budget_ns : search stops after it and returns best route found, 0 is no limit
+ */
+typedef struct {
+  int max_hops;
+  int max_split;
+  uint64_t budget_ns;
+} udtswap_route_options_t;
+
+/* swap of one pool, direction is UDTSWAP_QUOTE_UDT1_INPUT or UDTSWAP_QUOTE_UDT2_INPUT */
+typedef struct {
+  uint32_t pool;
+  int direction;
+  udtswap_quote_u128 input_amount;
+  udtswap_quote_u128 output_amount;
+} udtswap_route_leg_t;
+
+typedef struct {
+  int hop_cnt;
+  int leg_cnt[UDTSWAP_ROUTE_MAX_HOPS];
+  udtswap_route_leg_t legs[UDTSWAP_ROUTE_MAX_HOPS][UDTSWAP_ROUTE_MAX_SPLIT];
+  udtswap_quote_u128 input_amount;
+  udtswap_quote_u128 output_amount;
+  uint64_t paths;
+  int timed_out;
+} udtswap_route_t;
+
+UDTSWAP_QUOTE_API udtswap_route_graph_t *udtswap_route_graph_new(void);
+UDTSWAP_QUOTE_API void udtswap_route_graph_free(udtswap_route_graph_t *graph);
+
+/* pool of lock args and pool data (48 bytes or extended), pool id is index of added pools */
+UDTSWAP_QUOTE_API int udtswap_route_graph_add_pool(
+  udtswap_route_graph_t *graph,
+  const uint8_t lock_args[UDTSWAP_ROUTE_LOCK_ARGS_SIZE],
+  const uint8_t *data,
+  size_t data_len,
+  uint32_t *pool
+);
+
+/* new pool data of a pool, graph is not rebuilt */
+UDTSWAP_QUOTE_API int udtswap_route_graph_update_pool(
+  udtswap_route_graph_t *graph,
+  uint32_t pool,
+  const uint8_t *data,
+  size_t data_len
+);
+
+UDTSWAP_QUOTE_API size_t udtswap_route_graph_pool_count(const udtswap_route_graph_t *graph);
+
+/* output maximizing route of input amount, UDTSWAP_ROUTE_ERROR_NO_ROUTE when no route has output */
+UDTSWAP_QUOTE_API int udtswap_route_best(
+  udtswap_route_graph_t *graph,
+  const uint8_t input_udt[UDTSWAP_ROUTE_HASH_SIZE],
+  const uint8_t output_udt[UDTSWAP_ROUTE_HASH_SIZE],
+  udtswap_quote_u128 input_amount,
+  const udtswap_route_options_t *options,
+  udtswap_route_t *route
+);
+
+/*
+ * max_split : shard pools of a split order, as udtswap_route_options_t
+ * tolerance_bps : output below best split in basis points, a single shard within it takes the order
+ */
+typedef struct {
+  int max_split;
+  uint32_t tolerance_bps;
+} udtswap_route_shard_options_t;
+
+/*
+ * route of 1 hop over shard pools of input udt and output udt
+ * large orders are split across shards, small orders take one shard of output within tolerance of the split,
+ * shard of a key (lock hash of user) is chosen by rendezvous hash, so keys spread over shards
+ * and a key keeps its shard while the shard stays within tolerance
+ */
+UDTSWAP_QUOTE_API int udtswap_route_shard(
+  udtswap_route_graph_t *graph,
+  const uint8_t input_udt[UDTSWAP_ROUTE_HASH_SIZE],
+  const uint8_t output_udt[UDTSWAP_ROUTE_HASH_SIZE],
+  udtswap_quote_u128 input_amount,
+  const uint8_t key[UDTSWAP_ROUTE_HASH_SIZE],
+  const udtswap_route_shard_options_t *options,
+  udtswap_route_t *route
+);
+
+#endif /* UDTSWAP_ROUTE_H_ */
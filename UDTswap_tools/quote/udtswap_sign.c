@@ -0,0 +1,297 @@
+/*
+ * batch signing, sighash of secp256k1 blake160 sighash all lock and signer threads
+ * jobs of a batch are claimed by an atomic index, so signer threads and the calling thread take jobs
+ * until the batch is empty, signer threads wait for the next batch between batches
+ */
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "../blake2b.h"
+#include "udtswap_sign.h"
+
+#ifdef UDTSWAP_SIGN_SECP256K1
+#include <stdio.h>
+#include <secp256k1.h>
+#include <secp256k1_recovery.h>
+#endif
+
+#define WITNESS_ARGS_HEADER_SIZE (4 * 4)
+
+struct udtswap_signer {
+  udtswap_sign_fn sign;
+  void *ctx;
+  pthread_t *threads;
+  size_t thread_cnt;
+  pthread_mutex_t lock;
+  pthread_cond_t start_cond;
+  pthread_cond_t done_cond;
+  udtswap_sign_job_t *jobs;
+  size_t job_cnt;
+  size_t next;
+  size_t active;
+  uint64_t batch;
+  int stop;
+};
+
+static uint32_t get_u32(const uint8_t *p) {
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void hash_witness(blake2b_state *state, const udtswap_tx_t *tx, size_t index) {
+  uint8_t len[8];
+  uint32_t witness_len = tx->witness_lens[index] - 4;
+  memset(len, 0, sizeof(len));
+  memcpy(len, tx->arena + tx->witnesses[index], 4);
+  blake2b_update(state, len, sizeof(len));
+  blake2b_update(state, tx->arena + tx->witnesses[index] + 4, witness_len);
+}
+//witness length is hashed as u64 little endian, low 4 bytes are Bytes header of the witness
+
+/* offset of signature in WitnessArgs witness, 0 when lock is not a signature */
+static uint32_t signature_offset(const uint8_t *witness, uint32_t len) {
+  uint32_t lock, input_type;
+  if (len < WITNESS_ARGS_HEADER_SIZE || get_u32(witness) != len || get_u32(witness + 4) != WITNESS_ARGS_HEADER_SIZE) {
+    return 0;
+  }
+  lock = get_u32(witness + 4);
+  input_type = get_u32(witness + 8);
+  if (input_type != lock + 4 + UDTSWAP_TX_SIGNATURE_SIZE || input_type > len ||
+      get_u32(witness + lock) != UDTSWAP_TX_SIGNATURE_SIZE) {
+    return 0;
+  }
+  return lock + 4;
+}
+
+int udtswap_sighash(
+  const udtswap_tx_t *tx,
+  size_t group_start,
+  size_t group_cnt,
+  uint8_t message[UDTSWAP_ROUTE_HASH_SIZE]
+) {
+  static const uint8_t zero[UDTSWAP_TX_SIGNATURE_SIZE];
+  blake2b_state state;
+  uint8_t hash[UDTSWAP_ROUTE_HASH_SIZE];
+  uint8_t len[8];
+  const uint8_t *witness;
+  uint32_t witness_len, offset;
+  size_t i;
+
+  if (group_cnt == 0 || group_start >= tx->witness_cnt || group_cnt > tx->witness_cnt - group_start) {
+    return UDTSWAP_SIGN_ERROR_WITNESS;
+  }
+  witness = tx->arena + tx->witnesses[group_start] + 4;
+  witness_len = tx->witness_lens[group_start] - 4;
+  offset = signature_offset(witness, witness_len);
+  if (offset == 0) {
+    return UDTSWAP_SIGN_ERROR_WITNESS;
+  }
+
+  udtswap_tx_hash(tx, hash);
+  blake2b_init(&state);
+  blake2b_update(&state, hash, sizeof(hash));
+  memset(len, 0, sizeof(len));
+  memcpy(len, tx->arena + tx->witnesses[group_start], 4);
+  blake2b_update(&state, len, sizeof(len));
+  blake2b_update(&state, witness, offset);
+  blake2b_update(&state, zero, sizeof(zero));
+  blake2b_update(&state, witness + offset + UDTSWAP_TX_SIGNATURE_SIZE, witness_len - offset - UDTSWAP_TX_SIGNATURE_SIZE);
+  //first witness is hashed with a zero signature, witness is not changed so a signed transaction is hashed the same
+
+  for (i = group_start + 1; i < group_start + group_cnt; i++) {
+    hash_witness(&state, tx, i);
+  }
+  for (i = tx->input_cnt; i < tx->witness_cnt; i++) {
+    if (i < group_start || i >= group_start + group_cnt) {
+      hash_witness(&state, tx, i);
+    }
+  }
+  //witnesses without inputs are hashed by every group
+  blake2b_final(&state, message);
+  return 0;
+}
+
+static void sign_job(udtswap_signer_t *signer, udtswap_sign_job_t *job) {
+  uint8_t signature[UDTSWAP_TX_SIGNATURE_SIZE];
+  uint8_t *witness;
+  uint32_t len;
+
+  job->ret = udtswap_sighash(job->tx, job->group_start, job->group_cnt, job->message);
+  if (job->ret != 0 || signer->sign == NULL) {
+    return;
+  }
+  if (signer->sign(signer->ctx, job->message, job->key, signature) != 0) {
+    job->ret = UDTSWAP_SIGN_ERROR_SIGNER;
+    return;
+  }
+  witness = udtswap_tx_witness(job->tx, job->group_start, &len);
+  memcpy(witness + signature_offset(witness, len), signature, sizeof(signature));
+}
+
+static void signer_work(udtswap_signer_t *signer) {
+  size_t i;
+  while ((i = __atomic_fetch_add(&signer->next, 1, __ATOMIC_RELAXED)) < signer->job_cnt) {
+    sign_job(signer, &signer->jobs[i]);
+  }
+}
+
+static void *signer_thread(void *arg) {
+  udtswap_signer_t *signer = arg;
+  uint64_t batch = 0;
+
+  for (;;) {
+    pthread_mutex_lock(&signer->lock);
+    while (!signer->stop && signer->batch == batch) {
+      pthread_cond_wait(&signer->start_cond, &signer->lock);
+    }
+    if (signer->stop) {
+      pthread_mutex_unlock(&signer->lock);
+      return NULL;
+    }
+    batch = signer->batch;
+    pthread_mutex_unlock(&signer->lock);
+
+    signer_work(signer);
+
+    pthread_mutex_lock(&signer->lock);
+    if (--signer->active == 0) {
+      pthread_cond_signal(&signer->done_cond);
+    }
+    pthread_mutex_unlock(&signer->lock);
+  }
+}
+
+udtswap_signer_t *udtswap_signer_new(int threads, udtswap_sign_fn sign, void *ctx) {
+  udtswap_signer_t *signer;
+  size_t thread_cnt;
+
+  if (threads > 0) {
+    thread_cnt = (size_t)threads;
+  } else {
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    thread_cnt = cores > 0 ? (size_t)cores : 1;
+  }
+  signer = calloc(1, sizeof(udtswap_signer_t));
+  if (signer == NULL) {
+    return NULL;
+  }
+  signer->sign = sign;
+  signer->ctx = ctx;
+  signer->threads = malloc(thread_cnt * sizeof(pthread_t));
+  if (signer->threads == NULL) {
+    free(signer);
+    return NULL;
+  }
+  pthread_mutex_init(&signer->lock, NULL);
+  pthread_cond_init(&signer->start_cond, NULL);
+  pthread_cond_init(&signer->done_cond, NULL);
+
+  for (signer->thread_cnt = 0; signer->thread_cnt + 1 < thread_cnt; signer->thread_cnt++) {
+    if (pthread_create(&signer->threads[signer->thread_cnt], NULL, signer_thread, signer) != 0) {
+      udtswap_signer_free(signer);
+      return NULL;
+    }
+  }
+  //calling thread is one of the threads of a batch
+  return signer;
+}
+
+void udtswap_signer_free(udtswap_signer_t *signer) {
+  size_t i;
+  if (signer == NULL) {
+    return;
+  }
+  pthread_mutex_lock(&signer->lock);
+  signer->stop = 1;
+  pthread_cond_broadcast(&signer->start_cond);
+  pthread_mutex_unlock(&signer->lock);
+  for (i = 0; i < signer->thread_cnt; i++) {
+    pthread_join(signer->threads[i], NULL);
+  }
+  pthread_cond_destroy(&signer->done_cond);
+  pthread_cond_destroy(&signer->start_cond);
+  pthread_mutex_destroy(&signer->lock);
+  free(signer->threads);
+  free(signer);
+}
+
+int udtswap_signer_run(udtswap_signer_t *signer, udtswap_sign_job_t jobs[], size_t cnt) {
+  size_t i;
+
+  if (cnt == 0) {
+    return 0;
+  }
+  pthread_mutex_lock(&signer->lock);
+  signer->jobs = jobs;
+  signer->job_cnt = cnt;
+  signer->next = 0;
+  signer->active = signer->thread_cnt;
+  signer->batch++;
+  pthread_cond_broadcast(&signer->start_cond);
+  pthread_mutex_unlock(&signer->lock);
+
+  signer_work(signer);
+
+  pthread_mutex_lock(&signer->lock);
+  while (signer->active > 0) {
+    pthread_cond_wait(&signer->done_cond, &signer->lock);
+  }
+  signer->jobs = NULL;
+  signer->job_cnt = 0;
+  pthread_mutex_unlock(&signer->lock);
+  //jobs of a batch are done when every signer thread has left the batch, so jobs can be freed after return
+
+  for (i = 0; i < cnt; i++) {
+    if (jobs[i].ret != 0) {
+      return jobs[i].ret;
+    }
+  }
+  return 0;
+}
+
+#ifdef UDTSWAP_SIGN_SECP256K1
+void *udtswap_secp256k1_new(void) {
+  uint8_t seed[32];
+  secp256k1_context *ctx;
+  FILE *random = fopen("/dev/urandom", "rb");
+  if (random == NULL) {
+    return NULL;
+  }
+  if (fread(seed, 1, sizeof(seed), random) != sizeof(seed)) {
+    fclose(random);
+    return NULL;
+  }
+  fclose(random);
+  ctx = secp256k1_context_create(SECP256K1_CONTEXT_SIGN);
+  if (ctx != NULL && !secp256k1_context_randomize(ctx, seed)) {
+    secp256k1_context_destroy(ctx);
+    ctx = NULL;
+  }
+  memset(seed, 0, sizeof(seed));
+  return ctx;
+}
+//randomized context blinds signing against side channels, precomputed tables are built once by create
+
+void udtswap_secp256k1_free(void *ctx) {
+  if (ctx != NULL) {
+    secp256k1_context_destroy(ctx);
+  }
+}
+
+int udtswap_secp256k1_sign(
+  void *ctx,
+  const uint8_t message[UDTSWAP_ROUTE_HASH_SIZE],
+  const uint8_t key[UDTSWAP_SIGN_KEY_SIZE],
+  uint8_t signature[UDTSWAP_TX_SIGNATURE_SIZE]
+) {
+  secp256k1_ecdsa_recoverable_signature sig;
+  int recid;
+  if (!secp256k1_ecdsa_sign_recoverable(ctx, &sig, message, key, NULL, NULL)) {
+    return -1;
+  }
+  secp256k1_ecdsa_recoverable_signature_serialize_compact(ctx, signature, &recid, &sig);
+  signature[64] = (uint8_t)recid;
+  return 0;
+}
+#endif
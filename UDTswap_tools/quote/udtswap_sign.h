@@ -0,0 +1,85 @@
+#ifndef UDTSWAP_SIGN_H_
+#define UDTSWAP_SIGN_H_
+
+/*
+ * batch signing of transaction builders, part of quote library
+ *
+ * message of a lock group is the sighash of secp256k1 blake160 sighash all lock:
+ * blake2b of transaction hash, first witness of the group with a zero signature, other witnesses of the group
+ * and witnesses after inputs, each witness after its length of 8 bytes
+ * first witness of a group is WitnessArgs of a lock of UDTSWAP_TX_SIGNATURE_SIZE bytes (udtswap_tx_add_lock_witness),
+ * the signature is written into it, so size of the transaction does not change
+ *
+ * signer threads are created once, jobs of a batch are shared by the signer threads and the calling thread
+ * signature function is called with the context given to udtswap_signer_new from every thread
+ */
+#include <stddef.h>
+#include <stdint.h>
+#include "udtswap_quote.h"
+#include "udtswap_route.h"
+#include "udtswap_tx.h"
+
+#define UDTSWAP_SIGN_KEY_SIZE 32
+
+#define UDTSWAP_SIGN_ERROR_WITNESS -1
+#define UDTSWAP_SIGN_ERROR_SIGNER -2
+#define UDTSWAP_SIGN_ERROR_THREAD -3
+#define UDTSWAP_SIGN_ERROR_ALLOC -4
+
+typedef struct udtswap_signer udtswap_signer_t;
+
+/* recoverable signature of message by secret key, 64 bytes compact signature and recovery id, 0 on success */
+typedef int (*udtswap_sign_fn)(
+  void *ctx,
+  const uint8_t message[UDTSWAP_ROUTE_HASH_SIZE],
+  const uint8_t key[UDTSWAP_SIGN_KEY_SIZE],
+  uint8_t signature[UDTSWAP_TX_SIGNATURE_SIZE]
+);
+
+/*
+ * lock group of witnesses group_start ... group_start + group_cnt - 1 of tx, key of the group
+ * message and ret are set by udtswap_signer_run, jobs of one transaction have different groups
+ */
+typedef struct {
+  udtswap_tx_t *tx;
+  size_t group_start;
+  size_t group_cnt;
+  const uint8_t *key;
+  uint8_t message[UDTSWAP_ROUTE_HASH_SIZE];
+  int ret;
+} udtswap_sign_job_t;
+
+/* message of a lock group, witnesses are not changed */
+UDTSWAP_QUOTE_API int udtswap_sighash(
+  const udtswap_tx_t *tx,
+  size_t group_start,
+  size_t group_cnt,
+  uint8_t message[UDTSWAP_ROUTE_HASH_SIZE]
+);
+
+/*
+ * threads : threads of a batch with calling thread, 0 is count of online cores
+ * sign NULL computes messages only
+ */
+UDTSWAP_QUOTE_API udtswap_signer_t *udtswap_signer_new(int threads, udtswap_sign_fn sign, void *ctx);
+UDTSWAP_QUOTE_API void udtswap_signer_free(udtswap_signer_t *signer);
+
+/* jobs of a batch, returns when every job is done, first error of jobs or 0 */
+UDTSWAP_QUOTE_API int udtswap_signer_run(udtswap_signer_t *signer, udtswap_sign_job_t jobs[], size_t cnt);
+
+#ifdef UDTSWAP_SIGN_SECP256K1
+/*
+ * libsecp256k1 signing context, created and randomized once, read only while signing so shared by signer threads
+ * udtswap_secp256k1_sign is a udtswap_sign_fn of this context
+ */
+UDTSWAP_QUOTE_API void *udtswap_secp256k1_new(void);
+UDTSWAP_QUOTE_API void udtswap_secp256k1_free(void *ctx);
+UDTSWAP_QUOTE_API int udtswap_secp256k1_sign(
+  void *ctx,
+  const uint8_t message[UDTSWAP_ROUTE_HASH_SIZE],
+  const uint8_t key[UDTSWAP_SIGN_KEY_SIZE],
+  uint8_t signature[UDTSWAP_TX_SIGNATURE_SIZE]
+);
+#endif
+
+#endif /* UDTSWAP_SIGN_H_ */
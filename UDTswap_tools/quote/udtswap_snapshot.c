@@ -0,0 +1,253 @@
+/*
+ * pool state snapshot file
+ * written by write, fsync and rename of a unique temporary file, so readers see a whole old or new snapshot
+ * opened by read only shared mapping, processes of same snapshot share its pages
+ */
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "udtswap_snapshot.h"
+
+static const uint8_t snapshot_magic[8] = {'U', 'D', 'T', 'S', 'W', 'A', 'P', 'S'};
+
+_Static_assert(sizeof(udtswap_snapshot_header_t) == UDTSWAP_SNAPSHOT_HEADER_SIZE, "snapshot header size");
+_Static_assert(sizeof(udtswap_snapshot_record_t) == UDTSWAP_SNAPSHOT_RECORD_SIZE, "snapshot record size");
+
+static void snapshot_put(uint8_t *p, uint64_t v, int len) {
+  int i;
+  for (i = 0; i < len; i++) {
+    p[i] = (uint8_t)(v >> (8 * i));
+  }
+}
+
+static uint64_t snapshot_get(const uint8_t *p, int len) {
+  uint64_t v = 0;
+  int i;
+  for (i = len - 1; i >= 0; i--) {
+    v = (v << 8) | p[i];
+  }
+  return v;
+}
+
+static int snapshot_record_cmp(const void *a, const void *b) {
+  const udtswap_snapshot_record_t *x = a, *y = b;
+  int ret = memcmp(x->lock_args, y->lock_args, UDTSWAP_ROUTE_LOCK_ARGS_SIZE);
+  return ret != 0 ? ret : memcmp(x->type_hash, y->type_hash, UDTSWAP_ROUTE_HASH_SIZE);
+}
+//pools of a pair are adjacent
+
+static int snapshot_write_all(int fd, const void *buf, size_t len) {
+  const uint8_t *p = buf;
+  while (len > 0) {
+    ssize_t n = write(fd, p, len);
+    if (n <= 0) {
+      return UDTSWAP_SNAPSHOT_ERROR_IO;
+    }
+    p += n;
+    len -= (size_t)n;
+  }
+  return 0;
+}
+
+/*
+ * directory of path is synced, so rename to path is durable
+ */
+static int snapshot_sync_dir(const char *path) {
+  const char *slash = strrchr(path, '/');
+  size_t len = slash == NULL || slash == path ? 1 : (size_t)(slash - path);
+  char *dir = malloc(len + 1);
+  int fd, ret = 0;
+  if (dir == NULL) {
+    return UDTSWAP_SNAPSHOT_ERROR_ALLOC;
+  }
+  memcpy(dir, slash == NULL ? "." : path, len);
+  dir[len] = 0;
+  fd = open(dir, O_RDONLY | O_DIRECTORY);
+  free(dir);
+  if (fd < 0) {
+    return UDTSWAP_SNAPSHOT_ERROR_IO;
+  }
+  if (fsync(fd) != 0) {
+    ret = UDTSWAP_SNAPSHOT_ERROR_IO;
+  }
+  close(fd);
+  return ret;
+}
+
+int udtswap_snapshot_write(
+  const char *path,
+  uint64_t tip_number,
+  const uint8_t tip_hash[UDTSWAP_ROUTE_HASH_SIZE],
+  udtswap_snapshot_record_t *records,
+  size_t cnt
+) {
+  udtswap_snapshot_header_t header;
+  size_t path_len = strlen(path);
+  char *tmp = malloc(path_len + 8);
+  int fd, ret;
+  if (tmp == NULL) {
+    return UDTSWAP_SNAPSHOT_ERROR_ALLOC;
+  }
+  memcpy(tmp, path, path_len);
+  memcpy(tmp + path_len, ".XXXXXX", 8);
+  //temporary file of unique name in directory of path, writers of same path do not share it
+
+  qsort(records, cnt, sizeof(udtswap_snapshot_record_t), snapshot_record_cmp);
+  memcpy(header.magic, snapshot_magic, sizeof(header.magic));
+  snapshot_put(header.version, UDTSWAP_SNAPSHOT_VERSION, sizeof(header.version));
+  snapshot_put(header.record_size, UDTSWAP_SNAPSHOT_RECORD_SIZE, sizeof(header.record_size));
+  snapshot_put(header.pool_cnt, cnt, sizeof(header.pool_cnt));
+  snapshot_put(header.tip_number, tip_number, sizeof(header.tip_number));
+  memcpy(header.tip_hash, tip_hash, UDTSWAP_ROUTE_HASH_SIZE);
+
+  fd = mkstemp(tmp);
+  if (fd < 0) {
+    free(tmp);
+    return UDTSWAP_SNAPSHOT_ERROR_IO;
+  }
+  ret = fchmod(fd, 0644) == 0 ? 0 : UDTSWAP_SNAPSHOT_ERROR_IO;
+  if (ret == 0) {
+    ret = snapshot_write_all(fd, &header, sizeof(header));
+  }
+  if (ret == 0) {
+    ret = snapshot_write_all(fd, records, cnt * sizeof(udtswap_snapshot_record_t));
+  }
+  if (ret == 0 && fsync(fd) != 0) {
+    ret = UDTSWAP_SNAPSHOT_ERROR_IO;
+  }
+  if (close(fd) != 0 && ret == 0) {
+    ret = UDTSWAP_SNAPSHOT_ERROR_IO;
+  }
+  if (ret == 0 && rename(tmp, path) != 0) {
+    ret = UDTSWAP_SNAPSHOT_ERROR_IO;
+  }
+  if (ret != 0) {
+    unlink(tmp);
+  }
+  free(tmp);
+  if (ret == 0) {
+    ret = snapshot_sync_dir(path);
+  }
+  return ret;
+}
+//data is synced before rename and directory after it, a crash leaves the old snapshot or the new one
+
+int udtswap_snapshot_open(const char *path, udtswap_snapshot_t *snapshot) {
+  const udtswap_snapshot_header_t *header;
+  struct stat st;
+  void *map;
+  int fd = open(path, O_RDONLY);
+  memset(snapshot, 0, sizeof(udtswap_snapshot_t));
+  if (fd < 0) {
+    return UDTSWAP_SNAPSHOT_ERROR_IO;
+  }
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    return UDTSWAP_SNAPSHOT_ERROR_IO;
+  }
+  if ((size_t)st.st_size < UDTSWAP_SNAPSHOT_HEADER_SIZE) {
+    close(fd);
+    return UDTSWAP_SNAPSHOT_ERROR_FORMAT;
+  }
+  map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) {
+    return UDTSWAP_SNAPSHOT_ERROR_IO;
+  }
+  snapshot->map = map;
+  snapshot->map_size = (size_t)st.st_size;
+  snapshot->dev = (uint64_t)st.st_dev;
+  snapshot->ino = (uint64_t)st.st_ino;
+
+  header = map;
+  if (memcmp(header->magic, snapshot_magic, sizeof(snapshot_magic)) != 0) {
+    udtswap_snapshot_close(snapshot);
+    return UDTSWAP_SNAPSHOT_ERROR_FORMAT;
+  }
+  if (snapshot_get(header->version, sizeof(header->version)) != UDTSWAP_SNAPSHOT_VERSION) {
+    udtswap_snapshot_close(snapshot);
+    return UDTSWAP_SNAPSHOT_ERROR_VERSION;
+  }
+  uint64_t record_size = snapshot_get(header->record_size, sizeof(header->record_size));
+  uint64_t pool_cnt = snapshot_get(header->pool_cnt, sizeof(header->pool_cnt));
+  if (
+    record_size < UDTSWAP_SNAPSHOT_RECORD_SIZE ||
+    pool_cnt > (snapshot->map_size - UDTSWAP_SNAPSHOT_HEADER_SIZE) / record_size ||
+    snapshot->map_size != UDTSWAP_SNAPSHOT_HEADER_SIZE + pool_cnt * record_size
+  ) {
+    udtswap_snapshot_close(snapshot);
+    return UDTSWAP_SNAPSHOT_ERROR_FORMAT;
+  }
+  snapshot->record_size = (uint32_t)record_size;
+  snapshot->pool_cnt = (size_t)pool_cnt;
+  snapshot->tip_number = snapshot_get(header->tip_number, sizeof(header->tip_number));
+  snapshot->tip_hash = header->tip_hash;
+  return 0;
+}
+//records of larger size are appended fields of same version
+
+void udtswap_snapshot_close(udtswap_snapshot_t *snapshot) {
+  if (snapshot->map != NULL) {
+    munmap((void *)snapshot->map, snapshot->map_size);
+  }
+  memset(snapshot, 0, sizeof(udtswap_snapshot_t));
+}
+
+int udtswap_snapshot_stale(const udtswap_snapshot_t *snapshot, const char *path) {
+  struct stat st;
+  if (stat(path, &st) != 0) {
+    return 0;
+  }
+  return (uint64_t)st.st_dev != snapshot->dev || (uint64_t)st.st_ino != snapshot->ino;
+}
+//rename of a new snapshot replaces the inode of path
+
+const udtswap_snapshot_record_t *udtswap_snapshot_record(const udtswap_snapshot_t *snapshot, size_t i) {
+  return (const udtswap_snapshot_record_t *)(snapshot->map + UDTSWAP_SNAPSHOT_HEADER_SIZE + i * snapshot->record_size);
+}
+
+size_t udtswap_snapshot_find_pair(
+  const udtswap_snapshot_t *snapshot,
+  const uint8_t lock_args[UDTSWAP_ROUTE_LOCK_ARGS_SIZE],
+  size_t *first
+) {
+  size_t lo = 0, hi = snapshot->pool_cnt, end;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (memcmp(udtswap_snapshot_record(snapshot, mid)->lock_args, lock_args, UDTSWAP_ROUTE_LOCK_ARGS_SIZE) < 0) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  for (end = lo; end < snapshot->pool_cnt; end++) {
+    if (memcmp(udtswap_snapshot_record(snapshot, end)->lock_args, lock_args, UDTSWAP_ROUTE_LOCK_ARGS_SIZE) != 0) {
+      break;
+    }
+  }
+  *first = lo;
+  return end - lo;
+}
+
+uint32_t udtswap_snapshot_index(const udtswap_snapshot_record_t *record) {
+  return (uint32_t)snapshot_get(record->index, sizeof(record->index));
+}
+
+int udtswap_snapshot_add_pools(const udtswap_snapshot_t *snapshot, udtswap_route_graph_t *graph, uint32_t *first) {
+  size_t i;
+  uint32_t pool;
+  *first = (uint32_t)udtswap_route_graph_pool_count(graph);
+  for (i = 0; i < snapshot->pool_cnt; i++) {
+    const udtswap_snapshot_record_t *record = udtswap_snapshot_record(snapshot, i);
+    int ret = udtswap_route_graph_add_pool(graph, record->lock_args, record->data, sizeof(record->data), &pool);
+    if (ret != 0) {
+      return ret;
+    }
+  }
+  return 0;
+}
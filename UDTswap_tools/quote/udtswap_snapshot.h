@@ -0,0 +1,99 @@
+#ifndef UDTSWAP_SNAPSHOT_H_
+#define UDTSWAP_SNAPSHOT_H_
+
+/*
+ * pool state snapshot file, part of quote library
+ *
+ * header of UDTSWAP_SNAPSHOT_HEADER_SIZE bytes, then fixed size records of all pools sorted by pair and pool type hash
+ * integers are little endian, records are byte arrays, so a mapped file is read in place by any process
+ * a new snapshot is written to a temporary file and renamed, readers keep the mapping of the file they opened
+ *
+ * version is changed when fields of header or record are changed,
+ * fields are appended to a record by a larger record size of same version, readers skip the rest of records
+ */
+#include <stddef.h>
+#include <stdint.h>
+#include "udtswap_quote.h"
+#include "udtswap_route.h"
+
+#define UDTSWAP_SNAPSHOT_VERSION 1
+#define UDTSWAP_SNAPSHOT_HEADER_SIZE 64
+#define UDTSWAP_SNAPSHOT_RECORD_SIZE 192
+#define UDTSWAP_SNAPSHOT_DATA_SIZE 48
+
+#define UDTSWAP_SNAPSHOT_ERROR_IO -1
+#define UDTSWAP_SNAPSHOT_ERROR_FORMAT -2
+#define UDTSWAP_SNAPSHOT_ERROR_VERSION -3
+#define UDTSWAP_SNAPSHOT_ERROR_ALLOC -4
+
+/*
+ * magic "UDTSWAPS", version, record size, pool count, tip block number and hash of the snapshot
+ */
+typedef struct {
+  uint8_t magic[8];
+  uint8_t version[4];
+  uint8_t record_size[4];
+  uint8_t pool_cnt[8];
+  uint8_t tip_number[8];
+  uint8_t tip_hash[UDTSWAP_ROUTE_HASH_SIZE];
+} udtswap_snapshot_header_t;
+
+/*
+ * lock args of pool cell (udt1 and udt2 type hash), type hash of pool cell,
+ * out point of pool cell and pool cell data (udt1 reserve, udt2 reserve, total liquidity)
+ */
+typedef struct {
+  uint8_t lock_args[UDTSWAP_ROUTE_LOCK_ARGS_SIZE];
+  uint8_t type_hash[UDTSWAP_ROUTE_HASH_SIZE];
+  uint8_t tx_hash[UDTSWAP_ROUTE_HASH_SIZE];
+  uint8_t index[4];
+  uint8_t reserved[12];
+  uint8_t data[UDTSWAP_SNAPSHOT_DATA_SIZE];
+} udtswap_snapshot_record_t;
+
+/* mapped snapshot, records are read only */
+typedef struct {
+  const uint8_t *map;
+  size_t map_size;
+  uint64_t dev;
+  uint64_t ino;
+  uint32_t record_size;
+  size_t pool_cnt;
+  uint64_t tip_number;
+  const uint8_t *tip_hash;
+} udtswap_snapshot_t;
+
+/* records are sorted in place, file of path is replaced by rename */
+UDTSWAP_QUOTE_API int udtswap_snapshot_write(
+  const char *path,
+  uint64_t tip_number,
+  const uint8_t tip_hash[UDTSWAP_ROUTE_HASH_SIZE],
+  udtswap_snapshot_record_t *records,
+  size_t cnt
+);
+
+UDTSWAP_QUOTE_API int udtswap_snapshot_open(const char *path, udtswap_snapshot_t *snapshot);
+UDTSWAP_QUOTE_API void udtswap_snapshot_close(udtswap_snapshot_t *snapshot);
+
+/* 1 when path is a newer snapshot than the mapped one */
+UDTSWAP_QUOTE_API int udtswap_snapshot_stale(const udtswap_snapshot_t *snapshot, const char *path);
+
+UDTSWAP_QUOTE_API const udtswap_snapshot_record_t *udtswap_snapshot_record(const udtswap_snapshot_t *snapshot, size_t i);
+
+/* pools of a pair are records first ~ first + cnt - 1 */
+UDTSWAP_QUOTE_API size_t udtswap_snapshot_find_pair(
+  const udtswap_snapshot_t *snapshot,
+  const uint8_t lock_args[UDTSWAP_ROUTE_LOCK_ARGS_SIZE],
+  size_t *first
+);
+
+UDTSWAP_QUOTE_API uint32_t udtswap_snapshot_index(const udtswap_snapshot_record_t *record);
+
+/* pools of snapshot in record order, pool id of record i is first + i */
+UDTSWAP_QUOTE_API int udtswap_snapshot_add_pools(
+  const udtswap_snapshot_t *snapshot,
+  udtswap_route_graph_t *graph,
+  uint32_t *first
+);
+
+#endif /* UDTSWAP_SNAPSHOT_H_ */
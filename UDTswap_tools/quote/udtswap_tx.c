@@ -0,0 +1,356 @@
+/*
+ * transaction builder, molecule layout of CKB Transaction
+ * Transaction : table of raw (RawTransaction) and witnesses (dynvec of Bytes)
+ * RawTransaction : table of version, cell deps, header deps, inputs (fixvecs), outputs and outputs data (dynvecs)
+ */
+#include <stdint.h>
+#include <string.h>
+#include "../blake2b.h"
+#include "udtswap_tx.h"
+
+#define TX_HEADER_SIZE (4 * 3)
+#define RAW_TX_HEADER_SIZE (4 * 7)
+#define TABLE_HEADER_SIZE(cnt) (4 * (1 + (cnt)))
+#define CELL_OUTPUT_HEADER_SIZE TABLE_HEADER_SIZE(3)
+#define SCRIPT_HEADER_SIZE TABLE_HEADER_SIZE(3)
+#define WITNESS_ARGS_HEADER_SIZE TABLE_HEADER_SIZE(3)
+
+#define TX_EMPTY_RAW_SIZE (RAW_TX_HEADER_SIZE + 4 + 4 + 4 + 4 + 4 + 4)
+#define TX_EMPTY_SIZE (TX_HEADER_SIZE + TX_EMPTY_RAW_SIZE + 4)
+
+/* bytes of serialized transaction, copied to out or hashed */
+typedef struct {
+  uint8_t *out;
+  blake2b_state *state;
+} tx_sink_t;
+
+static void put_u32(uint8_t *p, uint32_t v) {
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)(v >> 8);
+  p[2] = (uint8_t)(v >> 16);
+  p[3] = (uint8_t)(v >> 24);
+}
+
+static void put_u64(uint8_t *p, uint64_t v) {
+  put_u32(p, (uint32_t)v);
+  put_u32(p + 4, (uint32_t)(v >> 32));
+}
+
+static uint64_t get_u64(const uint8_t *p) {
+  uint64_t v = 0;
+  int i;
+  for (i = 7; i >= 0; i--) {
+    v = (v << 8) | p[i];
+  }
+  return v;
+}
+
+void udtswap_tx_init(udtswap_tx_t *tx, uint8_t *arena, size_t arena_cap) {
+  tx->arena = arena;
+  tx->arena_cap = arena_cap;
+  tx->arena_len = 0;
+  tx->cell_dep_cnt = 0;
+  tx->header_dep_cnt = 0;
+  tx->input_cnt = 0;
+  tx->output_cnt = 0;
+  tx->witness_cnt = 0;
+  tx->size = TX_EMPTY_SIZE;
+  tx->raw_size = TX_EMPTY_RAW_SIZE;
+  tx->capacity = 0;
+}
+
+int udtswap_tx_add_cell_dep(udtswap_tx_t *tx, const uint8_t tx_hash[UDTSWAP_ROUTE_HASH_SIZE], uint32_t index, uint8_t dep_type) {
+  if (tx->cell_dep_cnt == UDTSWAP_TX_MAX_CELL_DEPS) {
+    return UDTSWAP_TX_ERROR_LIMIT;
+  }
+  uint8_t *dep = tx->cell_deps[tx->cell_dep_cnt++];
+  memcpy(dep, tx_hash, UDTSWAP_ROUTE_HASH_SIZE);
+  put_u32(dep + UDTSWAP_ROUTE_HASH_SIZE, index);
+  dep[UDTSWAP_ROUTE_HASH_SIZE + 4] = dep_type;
+  tx->size += UDTSWAP_TX_CELL_DEP_SIZE;
+  tx->raw_size += UDTSWAP_TX_CELL_DEP_SIZE;
+  return 0;
+}
+
+int udtswap_tx_add_header_dep(udtswap_tx_t *tx, const uint8_t hash[UDTSWAP_ROUTE_HASH_SIZE]) {
+  if (tx->header_dep_cnt == UDTSWAP_TX_MAX_HEADER_DEPS) {
+    return UDTSWAP_TX_ERROR_LIMIT;
+  }
+  memcpy(tx->header_deps[tx->header_dep_cnt++], hash, UDTSWAP_ROUTE_HASH_SIZE);
+  tx->size += UDTSWAP_ROUTE_HASH_SIZE;
+  tx->raw_size += UDTSWAP_ROUTE_HASH_SIZE;
+  return 0;
+}
+
+int udtswap_tx_add_input(udtswap_tx_t *tx, const uint8_t tx_hash[UDTSWAP_ROUTE_HASH_SIZE], uint32_t index, uint64_t since) {
+  if (tx->input_cnt == UDTSWAP_TX_MAX_INPUTS) {
+    return UDTSWAP_TX_ERROR_LIMIT;
+  }
+  uint8_t *input = tx->inputs[tx->input_cnt++];
+  put_u64(input, since);
+  memcpy(input + 8, tx_hash, UDTSWAP_ROUTE_HASH_SIZE);
+  put_u32(input + 8 + UDTSWAP_ROUTE_HASH_SIZE, index);
+  tx->size += UDTSWAP_TX_INPUT_SIZE;
+  tx->raw_size += UDTSWAP_TX_INPUT_SIZE;
+  return 0;
+}
+
+static uint32_t script_size(const udtswap_tx_script_t *script) {
+  return script == NULL ? 0 : SCRIPT_HEADER_SIZE + UDTSWAP_ROUTE_HASH_SIZE + 1 + 4 + script->args_len;
+}
+
+static uint32_t script_serialize(const udtswap_tx_script_t *script, uint8_t *out) {
+  uint32_t size = script_size(script);
+  put_u32(out, size);
+  put_u32(out + 4, SCRIPT_HEADER_SIZE);
+  put_u32(out + 8, SCRIPT_HEADER_SIZE + UDTSWAP_ROUTE_HASH_SIZE);
+  put_u32(out + 12, SCRIPT_HEADER_SIZE + UDTSWAP_ROUTE_HASH_SIZE + 1);
+  memcpy(out + SCRIPT_HEADER_SIZE, script->code_hash, UDTSWAP_ROUTE_HASH_SIZE);
+  out[SCRIPT_HEADER_SIZE + UDTSWAP_ROUTE_HASH_SIZE] = script->hash_type;
+  put_u32(out + SCRIPT_HEADER_SIZE + UDTSWAP_ROUTE_HASH_SIZE + 1, script->args_len);
+  if (script->args_len > 0) {
+    memcpy(out + SCRIPT_HEADER_SIZE + UDTSWAP_ROUTE_HASH_SIZE + 1 + 4, script->args, script->args_len);
+  }
+  return size;
+}
+
+int udtswap_tx_add_output(
+  udtswap_tx_t *tx,
+  uint64_t capacity,
+  const udtswap_tx_script_t *lock,
+  const udtswap_tx_script_t *type,
+  const uint8_t *data,
+  uint32_t data_len
+) {
+  uint32_t lock_len = script_size(lock), type_len = script_size(type);
+  uint32_t output_len = CELL_OUTPUT_HEADER_SIZE + 8 + lock_len + type_len;
+  uint8_t *p;
+  if (tx->output_cnt == UDTSWAP_TX_MAX_OUTPUTS) {
+    return UDTSWAP_TX_ERROR_LIMIT;
+  }
+  if (tx->arena_cap - tx->arena_len < (size_t)output_len + 4 + data_len) {
+    return UDTSWAP_TX_ERROR_SPACE;
+  }
+  p = tx->arena + tx->arena_len;
+  put_u32(p, output_len);
+  put_u32(p + 4, CELL_OUTPUT_HEADER_SIZE);
+  put_u32(p + 8, CELL_OUTPUT_HEADER_SIZE + 8);
+  put_u32(p + 12, CELL_OUTPUT_HEADER_SIZE + 8 + lock_len);
+  put_u64(p + CELL_OUTPUT_HEADER_SIZE, capacity);
+  script_serialize(lock, p + CELL_OUTPUT_HEADER_SIZE + 8);
+  if (type != NULL) {
+    script_serialize(type, p + CELL_OUTPUT_HEADER_SIZE + 8 + lock_len);
+  }
+  //type of ScriptOpt None is empty
+  put_u32(p + output_len, data_len);
+  if (data_len > 0) {
+    memcpy(p + output_len + 4, data, data_len);
+  }
+
+  tx->outputs[tx->output_cnt] = (uint32_t)tx->arena_len;
+  tx->output_lens[tx->output_cnt] = output_len;
+  tx->outputs_data[tx->output_cnt] = (uint32_t)tx->arena_len + output_len;
+  tx->output_data_lens[tx->output_cnt] = 4 + data_len;
+  tx->arena_len += output_len + 4 + data_len;
+  tx->size += 4 + output_len + 4 + 4 + data_len;
+  tx->raw_size += 4 + output_len + 4 + 4 + data_len;
+  tx->capacity += capacity;
+  return (int)tx->output_cnt++;
+}
+//an output and its data are adjacent in arena, each is copied to its own dynvec
+
+int udtswap_tx_set_capacity(udtswap_tx_t *tx, size_t output, uint64_t capacity) {
+  if (output >= tx->output_cnt) {
+    return UDTSWAP_TX_ERROR_INDEX;
+  }
+  uint8_t *p = tx->arena + tx->outputs[output] + CELL_OUTPUT_HEADER_SIZE;
+  tx->capacity = tx->capacity - get_u64(p) + capacity;
+  put_u64(p, capacity);
+  return 0;
+}
+
+int udtswap_tx_add_pool(udtswap_tx_t *tx, const udtswap_tx_pool_t *pool) {
+  udtswap_tx_script_t lock = {pool->lock_code_hash, UDTSWAP_TX_HASH_TYPE_TYPE, pool->lock_args, UDTSWAP_ROUTE_LOCK_ARGS_SIZE};
+  udtswap_tx_script_t type = {pool->type_code_hash, UDTSWAP_TX_HASH_TYPE_TYPE, pool->type_args, pool->type_args_len};
+  int i, ret;
+  if (
+    tx->output_cnt + 3 > UDTSWAP_TX_MAX_OUTPUTS ||
+    (pool->live_tx_hash != NULL && tx->input_cnt + 3 > UDTSWAP_TX_MAX_INPUTS)
+  ) {
+    return UDTSWAP_TX_ERROR_LIMIT;
+  }
+  for (i = 0; i < 3 && pool->live_tx_hash != NULL; i++) {
+    udtswap_tx_add_input(tx, pool->live_tx_hash, pool->live_index + (uint32_t)i, 0);
+  }
+  ret = udtswap_tx_add_output(tx, pool->capacity, &lock, &type, pool->data, pool->data_len);
+  for (i = 0; i < 2 && ret >= 0; i++) {
+    ret = udtswap_tx_add_output(
+      tx, pool->udt_capacity[i], &lock, pool->udt_type[i],
+      pool->udt_type[i] == NULL ? NULL : pool->udt_data[i], pool->udt_type[i] == NULL ? 0 : pool->udt_data_len[i]
+    );
+  }
+  return ret < 0 ? ret : 0;
+}
+//on UDTSWAP_TX_ERROR_SPACE some cells of the pool are added, transaction is built again in a larger arena
+
+int udtswap_tx_add_witness(udtswap_tx_t *tx, const uint8_t *witness, uint32_t len) {
+  if (tx->witness_cnt == UDTSWAP_TX_MAX_WITNESSES) {
+    return UDTSWAP_TX_ERROR_LIMIT;
+  }
+  if (tx->arena_cap - tx->arena_len < (size_t)len + 4) {
+    return UDTSWAP_TX_ERROR_SPACE;
+  }
+  uint8_t *p = tx->arena + tx->arena_len;
+  put_u32(p, len);
+  if (len > 0) {
+    memcpy(p + 4, witness, len);
+  }
+  tx->witnesses[tx->witness_cnt] = (uint32_t)tx->arena_len;
+  tx->witness_lens[tx->witness_cnt] = 4 + len;
+  tx->arena_len += 4 + len;
+  tx->size += 4 + 4 + len;
+  return (int)tx->witness_cnt++;
+}
+
+int udtswap_tx_add_lock_witness(udtswap_tx_t *tx) {
+  uint8_t witness[UDTSWAP_TX_LOCK_WITNESS_SIZE];
+  memset(witness, 0, sizeof(witness));
+  put_u32(witness, UDTSWAP_TX_LOCK_WITNESS_SIZE);
+  put_u32(witness + 4, WITNESS_ARGS_HEADER_SIZE);
+  put_u32(witness + 8, UDTSWAP_TX_LOCK_WITNESS_SIZE);
+  put_u32(witness + 12, UDTSWAP_TX_LOCK_WITNESS_SIZE);
+  put_u32(witness + WITNESS_ARGS_HEADER_SIZE, UDTSWAP_TX_SIGNATURE_SIZE);
+  return udtswap_tx_add_witness(tx, witness, sizeof(witness));
+}
+//WitnessArgs of lock Bytes of 65 bytes, input type and output type are None
+
+uint8_t *udtswap_tx_witness(udtswap_tx_t *tx, size_t index, uint32_t *len) {
+  if (index >= tx->witness_cnt) {
+    return NULL;
+  }
+  *len = tx->witness_lens[index] - 4;
+  return tx->arena + tx->witnesses[index] + 4;
+}
+
+uint32_t udtswap_tx_size(const udtswap_tx_t *tx) {
+  return tx->size;
+}
+
+uint64_t udtswap_tx_fee(const udtswap_tx_t *tx, uint64_t fee_rate) {
+  udtswap_quote_u128 fee = ((udtswap_quote_u128)tx->size + 4) * fee_rate;
+  return (uint64_t)((fee + 999) / 1000);
+}
+
+int udtswap_tx_balance(
+  udtswap_tx_t *tx,
+  size_t change_output,
+  uint64_t input_capacity,
+  uint64_t fee_rate,
+  uint64_t *fee
+) {
+  if (change_output >= tx->output_cnt) {
+    return UDTSWAP_TX_ERROR_INDEX;
+  }
+  uint64_t tx_fee = udtswap_tx_fee(tx, fee_rate);
+  udtswap_quote_u128 other = tx->capacity - get_u64(tx->arena + tx->outputs[change_output] + CELL_OUTPUT_HEADER_SIZE);
+  if ((udtswap_quote_u128)input_capacity < other + tx_fee) {
+    return UDTSWAP_TX_ERROR_CAPACITY;
+  }
+  if (fee != NULL) {
+    *fee = tx_fee;
+  }
+  return udtswap_tx_set_capacity(tx, change_output, (uint64_t)(input_capacity - other - tx_fee));
+}
+//capacity is not part of size, fee is computed once
+
+/*
+ * serialization
+ */
+
+static void sink_put(tx_sink_t *sink, const void *p, size_t len) {
+  if (sink->out != NULL) {
+    memcpy(sink->out, p, len);
+    sink->out += len;
+  } else {
+    blake2b_update(sink->state, p, len);
+  }
+}
+
+static void sink_u32(tx_sink_t *sink, uint32_t v) {
+  uint8_t p[4];
+  put_u32(p, v);
+  sink_put(sink, p, 4);
+}
+
+static uint32_t dynvec_size(const uint32_t lens[], size_t cnt) {
+  uint32_t size = TABLE_HEADER_SIZE((uint32_t)cnt);
+  size_t i;
+  for (i = 0; i < cnt; i++) {
+    size += lens[i];
+  }
+  return size;
+}
+
+static void sink_dynvec(tx_sink_t *sink, const uint8_t *arena, const uint32_t offsets[], const uint32_t lens[], size_t cnt) {
+  uint8_t header[TABLE_HEADER_SIZE(UDTSWAP_TX_MAX_OUTPUTS > UDTSWAP_TX_MAX_WITNESSES ? UDTSWAP_TX_MAX_OUTPUTS : UDTSWAP_TX_MAX_WITNESSES)];
+  uint32_t offset = TABLE_HEADER_SIZE((uint32_t)cnt);
+  size_t i;
+  for (i = 0; i < cnt; i++) {
+    put_u32(header + 4 * (i + 1), offset);
+    offset += lens[i];
+  }
+  put_u32(header, offset);
+  sink_put(sink, header, TABLE_HEADER_SIZE(cnt));
+  for (i = 0; i < cnt; i++) {
+    sink_put(sink, arena + offsets[i], lens[i]);
+  }
+}
+
+static void sink_raw_tx(tx_sink_t *sink, const udtswap_tx_t *tx) {
+  uint32_t lens[6] = {
+    4,
+    4 + UDTSWAP_TX_CELL_DEP_SIZE * (uint32_t)tx->cell_dep_cnt,
+    4 + UDTSWAP_ROUTE_HASH_SIZE * (uint32_t)tx->header_dep_cnt,
+    4 + UDTSWAP_TX_INPUT_SIZE * (uint32_t)tx->input_cnt,
+    dynvec_size(tx->output_lens, tx->output_cnt),
+    dynvec_size(tx->output_data_lens, tx->output_cnt),
+  };
+  uint32_t offset = RAW_TX_HEADER_SIZE;
+  int i;
+  sink_u32(sink, tx->raw_size);
+  for (i = 0; i < 6; i++) {
+    sink_u32(sink, offset);
+    offset += lens[i];
+  }
+  sink_u32(sink, 0);
+  sink_u32(sink, (uint32_t)tx->cell_dep_cnt);
+  sink_put(sink, tx->cell_deps, UDTSWAP_TX_CELL_DEP_SIZE * tx->cell_dep_cnt);
+  sink_u32(sink, (uint32_t)tx->header_dep_cnt);
+  sink_put(sink, tx->header_deps, UDTSWAP_ROUTE_HASH_SIZE * tx->header_dep_cnt);
+  sink_u32(sink, (uint32_t)tx->input_cnt);
+  sink_put(sink, tx->inputs, UDTSWAP_TX_INPUT_SIZE * tx->input_cnt);
+  sink_dynvec(sink, tx->arena, tx->outputs, tx->output_lens, tx->output_cnt);
+  sink_dynvec(sink, tx->arena, tx->outputs_data, tx->output_data_lens, tx->output_cnt);
+}
+//version 0, fixvecs of count and items
+
+int udtswap_tx_serialize(const udtswap_tx_t *tx, uint8_t *out, size_t cap) {
+  tx_sink_t sink = {out, NULL};
+  if (cap < tx->size) {
+    return UDTSWAP_TX_ERROR_SPACE;
+  }
+  sink_u32(&sink, tx->size);
+  sink_u32(&sink, TX_HEADER_SIZE);
+  sink_u32(&sink, TX_HEADER_SIZE + tx->raw_size);
+  sink_raw_tx(&sink, tx);
+  sink_dynvec(&sink, tx->arena, tx->witnesses, tx->witness_lens, tx->witness_cnt);
+  return 0;
+}
+
+void udtswap_tx_hash(const udtswap_tx_t *tx, uint8_t hash[UDTSWAP_ROUTE_HASH_SIZE]) {
+  blake2b_state state;
+  tx_sink_t sink = {NULL, &state};
+  blake2b_init(&state);
+  sink_raw_tx(&sink, tx);
+  blake2b_final(&state, hash);
+}
@@ -0,0 +1,156 @@
+#ifndef UDTSWAP_TX_H_
+#define UDTSWAP_TX_H_
+
+/*
+ * transaction builder, part of quote library
+ *
+ * cell deps, header deps and inputs are kept serialized in the builder, outputs, outputs data and witnesses
+ * are serialized when added into an arena of the caller, so a transaction is assembled by copies of serialized items
+ * molecule layout of Transaction is the same as molecule_builder.h builders of protocol.h,
+ * size of the serialized transaction is updated by every added item, fee of a transaction is known before serializing it
+ *
+ * pool cells of UDTswap transactions are first 3 inputs and outputs of each pool (pool cell, udt1 and udt2 lock cells),
+ * so pools are added before other inputs and outputs
+ */
+#include <stddef.h>
+#include <stdint.h>
+#include "udtswap_quote.h"
+#include "udtswap_route.h"
+
+#define UDTSWAP_TX_MAX_CELL_DEPS 16
+#define UDTSWAP_TX_MAX_HEADER_DEPS 4
+#define UDTSWAP_TX_MAX_INPUTS 64
+#define UDTSWAP_TX_MAX_OUTPUTS 64
+#define UDTSWAP_TX_MAX_WITNESSES 64
+
+#define UDTSWAP_TX_CELL_DEP_SIZE 37
+#define UDTSWAP_TX_INPUT_SIZE 44
+#define UDTSWAP_TX_SIGNATURE_SIZE 65
+#define UDTSWAP_TX_LOCK_WITNESS_SIZE 85
+
+#define UDTSWAP_TX_DEP_CODE 0
+#define UDTSWAP_TX_DEP_GROUP 1
+#define UDTSWAP_TX_HASH_TYPE_DATA 0
+#define UDTSWAP_TX_HASH_TYPE_TYPE 1
+
+#define UDTSWAP_TX_ERROR_SPACE -1
+#define UDTSWAP_TX_ERROR_LIMIT -2
+#define UDTSWAP_TX_ERROR_INDEX -3
+#define UDTSWAP_TX_ERROR_CAPACITY -4
+
+/* script of an output, code hash of 32 bytes, args are copied when the output is added */
+typedef struct {
+  const uint8_t *code_hash;
+  uint8_t hash_type;
+  const uint8_t *args;
+  uint32_t args_len;
+} udtswap_tx_script_t;
+
+/*
+ * items of outputs, outputs data and witnesses are offsets of arena, output data and witnesses are molecule Bytes
+ * size and raw_size are sizes of serialized Transaction and RawTransaction, capacity is sum of output capacities
+ */
+typedef struct {
+  uint8_t *arena;
+  size_t arena_cap;
+  size_t arena_len;
+  uint8_t cell_deps[UDTSWAP_TX_MAX_CELL_DEPS][UDTSWAP_TX_CELL_DEP_SIZE];
+  size_t cell_dep_cnt;
+  uint8_t header_deps[UDTSWAP_TX_MAX_HEADER_DEPS][UDTSWAP_ROUTE_HASH_SIZE];
+  size_t header_dep_cnt;
+  uint8_t inputs[UDTSWAP_TX_MAX_INPUTS][UDTSWAP_TX_INPUT_SIZE];
+  size_t input_cnt;
+  uint32_t outputs[UDTSWAP_TX_MAX_OUTPUTS];
+  uint32_t output_lens[UDTSWAP_TX_MAX_OUTPUTS];
+  uint32_t outputs_data[UDTSWAP_TX_MAX_OUTPUTS];
+  uint32_t output_data_lens[UDTSWAP_TX_MAX_OUTPUTS];
+  size_t output_cnt;
+  uint32_t witnesses[UDTSWAP_TX_MAX_WITNESSES];
+  uint32_t witness_lens[UDTSWAP_TX_MAX_WITNESSES];
+  size_t witness_cnt;
+  uint32_t size;
+  uint32_t raw_size;
+  udtswap_quote_u128 capacity;
+} udtswap_tx_t;
+
+/*
+ * pool of a UDTswap transaction, live_tx_hash NULL when the pool is created (no pool inputs)
+ * pool inputs are out points live_index, live_index + 1 and live_index + 2 of live_tx_hash
+ * lock args are udt1 and udt2 type hash, type args are pool identifier or serialized first input on creation
+ * udt_type[i] NULL for a CKB reserve, whose lock cell has no type and no data
+ */
+typedef struct {
+  const uint8_t *live_tx_hash;
+  uint32_t live_index;
+  const uint8_t *type_code_hash;
+  const uint8_t *lock_code_hash;
+  const uint8_t *lock_args;
+  const uint8_t *type_args;
+  uint32_t type_args_len;
+  uint64_t capacity;
+  const uint8_t *data;
+  uint32_t data_len;
+  uint64_t udt_capacity[2];
+  const udtswap_tx_script_t *udt_type[2];
+  const uint8_t *udt_data[2];
+  uint32_t udt_data_len[2];
+} udtswap_tx_pool_t;
+
+/* empty transaction of version 0, outputs and witnesses are written to arena of arena_cap bytes */
+UDTSWAP_QUOTE_API void udtswap_tx_init(udtswap_tx_t *tx, uint8_t *arena, size_t arena_cap);
+
+UDTSWAP_QUOTE_API int udtswap_tx_add_cell_dep(udtswap_tx_t *tx, const uint8_t tx_hash[UDTSWAP_ROUTE_HASH_SIZE], uint32_t index, uint8_t dep_type);
+UDTSWAP_QUOTE_API int udtswap_tx_add_header_dep(udtswap_tx_t *tx, const uint8_t hash[UDTSWAP_ROUTE_HASH_SIZE]);
+UDTSWAP_QUOTE_API int udtswap_tx_add_input(udtswap_tx_t *tx, const uint8_t tx_hash[UDTSWAP_ROUTE_HASH_SIZE], uint32_t index, uint64_t since);
+
+/* output index, or error, type NULL for an output without type script */
+UDTSWAP_QUOTE_API int udtswap_tx_add_output(
+  udtswap_tx_t *tx,
+  uint64_t capacity,
+  const udtswap_tx_script_t *lock,
+  const udtswap_tx_script_t *type,
+  const uint8_t *data,
+  uint32_t data_len
+);
+
+/* capacity of added output, in place, size of transaction is not changed */
+UDTSWAP_QUOTE_API int udtswap_tx_set_capacity(udtswap_tx_t *tx, size_t output, uint64_t capacity);
+
+/* pool cells of a UDTswap transaction, 3 inputs (none on creation) and 3 outputs */
+UDTSWAP_QUOTE_API int udtswap_tx_add_pool(udtswap_tx_t *tx, const udtswap_tx_pool_t *pool);
+
+/*
+ * witness index, or error
+ * lock witness is WitnessArgs of a zero signature of UDTSWAP_TX_SIGNATURE_SIZE bytes in lock,
+ * so size and fee do not change when the transaction is signed
+ */
+UDTSWAP_QUOTE_API int udtswap_tx_add_witness(udtswap_tx_t *tx, const uint8_t *witness, uint32_t len);
+UDTSWAP_QUOTE_API int udtswap_tx_add_lock_witness(udtswap_tx_t *tx);
+
+/* witness bytes in arena, without Bytes header, NULL for unknown index */
+UDTSWAP_QUOTE_API uint8_t *udtswap_tx_witness(udtswap_tx_t *tx, size_t index, uint32_t *len);
+
+UDTSWAP_QUOTE_API uint32_t udtswap_tx_size(const udtswap_tx_t *tx);
+
+/* fee of fee rate shannons per 1000 bytes, size in block is serialized size and 4 bytes of its offset */
+UDTSWAP_QUOTE_API uint64_t udtswap_tx_fee(const udtswap_tx_t *tx, uint64_t fee_rate);
+
+/*
+ * capacity of change output is input capacity - other outputs - fee, fee is stored if not NULL
+ * UDTSWAP_TX_ERROR_CAPACITY when input capacity is not enough
+ */
+UDTSWAP_QUOTE_API int udtswap_tx_balance(
+  udtswap_tx_t *tx,
+  size_t change_output,
+  uint64_t input_capacity,
+  uint64_t fee_rate,
+  uint64_t *fee
+);
+
+/* serialized Transaction to out of cap bytes, udtswap_tx_size bytes are written */
+UDTSWAP_QUOTE_API int udtswap_tx_serialize(const udtswap_tx_t *tx, uint8_t *out, size_t cap);
+
+/* transaction hash, blake2b of serialized RawTransaction, hashed without serializing it to a buffer */
+UDTSWAP_QUOTE_API void udtswap_tx_hash(const udtswap_tx_t *tx, uint8_t hash[UDTSWAP_ROUTE_HASH_SIZE]);
+
+#endif /* UDTSWAP_TX_H_ */
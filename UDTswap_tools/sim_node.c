@@ -0,0 +1,403 @@
+/*
+ * Node addon of simulated chain verification, UDTswap scripts of host native build (or ckb-debugger)
+ * context gives the code cell dep type scripts and code hashes the scripts are built with,
+ * verify runs a resolved transaction, cells are
+ * { txHash, index, since, capacity, lock, type, data } of buffers, numbers and BigInt
+ * scripts are { codeHash, hashType, args } of buffers and hash type number
+ * rejected transaction throws with code of sim_verify.h, exitCode and group of rejected script group
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <node_api.h>
+#include "sim_verify.h"
+
+#define SIM_NODE_PATH_SIZE 4096
+
+static fixture_context_t contexts[2];
+
+static int get_property(napi_env env, napi_value object, const char *name, napi_value *value) {
+  napi_valuetype type = napi_undefined;
+  if (napi_get_named_property(env, object, name, value) == napi_ok) {
+    napi_typeof(env, *value, &type);
+  }
+  return type != napi_undefined && type != napi_null;
+}
+//false for a missing, undefined or null property
+
+static int get_buffer(napi_env env, napi_value value, const char *name, size_t max, const uint8_t **data, size_t *len) {
+  bool is_buffer = false;
+  if (
+    napi_is_buffer(env, value, &is_buffer) != napi_ok || !is_buffer ||
+    napi_get_buffer_info(env, value, (void **)data, len) != napi_ok || *len > max
+  ) {
+    char message[64];
+    snprintf(message, sizeof(message), "%s should be a buffer of at most %zu bytes", name, max);
+    napi_throw_type_error(env, NULL, message);
+    return 0;
+  }
+  return 1;
+}
+
+static int get_u64(napi_env env, napi_value value, const char *name, uint64_t *ret) {
+  bool lossless = false;
+  if (napi_get_value_bigint_uint64(env, value, ret, &lossless) != napi_ok || !lossless) {
+    char message[64];
+    snprintf(message, sizeof(message), "%s should be an unsigned 64 bit BigInt", name);
+    napi_throw_type_error(env, NULL, message);
+    return 0;
+  }
+  return 1;
+}
+
+static int get_script(napi_env env, napi_value value, fixture_script_t *script) {
+  napi_value field;
+  const uint8_t *data;
+  size_t len;
+  uint32_t hash_type;
+  memset(script, 0, sizeof(*script));
+  if (!get_property(env, value, "codeHash", &field)) {
+    napi_throw_type_error(env, NULL, "script should have codeHash, hashType and args");
+    return 0;
+  }
+  if (!get_buffer(env, field, "script codeHash", FIXTURE_HASH_SIZE, &data, &len)) {
+    return 0;
+  }
+  if (len != FIXTURE_HASH_SIZE) {
+    napi_throw_type_error(env, NULL, "script codeHash should be 32 bytes");
+    return 0;
+  }
+  memcpy(script->code_hash, data, FIXTURE_HASH_SIZE);
+  if (!get_property(env, value, "hashType", &field) || napi_get_value_uint32(env, field, &hash_type) != napi_ok) {
+    napi_throw_type_error(env, NULL, "script hashType should be a number");
+    return 0;
+  }
+  script->hash_type = (uint8_t)hash_type;
+  if (get_property(env, value, "args", &field)) {
+    if (!get_buffer(env, field, "script args", FIXTURE_MAX_ARGS, &data, &len)) {
+      return 0;
+    }
+    memcpy(script->args, data, len);
+    script->args_len = (uint32_t)len;
+  }
+  return 1;
+}
+
+static int get_cell(napi_env env, napi_value value, fixture_cell_t *cell) {
+  napi_value field;
+  const uint8_t *data;
+  size_t len;
+  uint32_t index;
+  if (!get_property(env, value, "txHash", &field)) {
+    napi_throw_type_error(env, NULL, "cell should have txHash, index, capacity, lock and data");
+    return 0;
+  }
+  if (!get_buffer(env, field, "cell txHash", FIXTURE_HASH_SIZE, &data, &len)) {
+    return 0;
+  }
+  memcpy(cell->tx_hash, data, len);
+  if (!get_property(env, value, "index", &field) || napi_get_value_uint32(env, field, &index) != napi_ok) {
+    napi_throw_type_error(env, NULL, "cell index should be a number");
+    return 0;
+  }
+  cell->index = index;
+  cell->since = 0;
+  if (get_property(env, value, "since", &field) && !get_u64(env, field, "cell since", &cell->since)) {
+    return 0;
+  }
+  if (!get_property(env, value, "capacity", &field) || !get_u64(env, field, "cell capacity", &cell->capacity)) {
+    return 0;
+  }
+  if (!get_property(env, value, "lock", &field) || !get_script(env, field, &cell->lock)) {
+    return 0;
+  }
+  cell->has_type = get_property(env, value, "type", &field);
+  if (cell->has_type && !get_script(env, field, &cell->type)) {
+    return 0;
+  }
+  data = NULL;
+  len = 0;
+  if (get_property(env, value, "data", &field) && !get_buffer(env, field, "cell data", UINT32_MAX, &data, &len)) {
+    return 0;
+  }
+  fixture_cell_set_data(cell, data, (uint32_t)len);
+  cell->has_header = get_property(env, value, "header", &field);
+  if (cell->has_header && napi_get_value_uint32(env, field, &cell->header_index) != napi_ok) {
+    napi_throw_type_error(env, NULL, "cell header should be index of a header dep");
+    return 0;
+  }
+  return 1;
+}
+
+/*
+ * array property of tx, length is checked against max
+ */
+static int get_array(napi_env env, napi_value tx, const char *name, size_t max, napi_value *array, uint32_t *len) {
+  bool is_array = false;
+  *len = 0;
+  if (!get_property(env, tx, name, array)) {
+    return 1;
+  }
+  if (napi_is_array(env, *array, &is_array) != napi_ok || !is_array || napi_get_array_length(env, *array, len) != napi_ok || *len > max) {
+    char message[64];
+    snprintf(message, sizeof(message), "transaction %s should be an array of at most %zu items", name, max);
+    napi_throw_type_error(env, NULL, message);
+    return 0;
+  }
+  return 1;
+}
+
+static int get_cells(napi_env env, napi_value tx, const char *name, fixture_tx_t *fixture, fixture_cell_t *(*add)(fixture_tx_t *)) {
+  napi_value array, item;
+  uint32_t i, len;
+  if (!get_array(env, tx, name, FIXTURE_MAX_CELLS, &array, &len)) {
+    return 0;
+  }
+  for (i = 0; i < len; i++) {
+    napi_get_element(env, array, i, &item);
+    if (!get_cell(env, item, add(fixture))) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+/*
+ * { inputs, outputs, deps, headers, witnesses } of resolved cells, header block numbers and witness buffers
+ * header of a cell is index of header dep of its block
+ */
+static int get_tx(napi_env env, napi_value value, fixture_tx_t *tx) {
+  napi_value array, item;
+  const uint8_t *data;
+  size_t len;
+  uint32_t i, cnt;
+  uint64_t number;
+
+  if (
+    !get_cells(env, value, "inputs", tx, fixture_tx_add_input) ||
+    !get_cells(env, value, "outputs", tx, fixture_tx_add_output) ||
+    !get_cells(env, value, "deps", tx, fixture_tx_add_dep)
+  ) {
+    return 0;
+  }
+  if (!get_array(env, value, "headers", FIXTURE_MAX_HEADERS, &array, &cnt)) {
+    return 0;
+  }
+  for (i = 0; i < cnt; i++) {
+    napi_get_element(env, array, i, &item);
+    if (!get_u64(env, item, "header number", &number)) {
+      return 0;
+    }
+    fixture_tx_add_header(tx, number);
+  }
+  for (i = 0; i < tx->input_cnt + tx->dep_cnt; i++) {
+    const fixture_cell_t *cell = i < tx->input_cnt ? &tx->inputs[i] : &tx->deps[i - tx->input_cnt];
+    if (cell->has_header && cell->header_index >= tx->header_cnt) {
+      napi_throw_range_error(env, NULL, "cell header should be index of a header dep");
+      return 0;
+    }
+  }
+  if (!get_array(env, value, "witnesses", FIXTURE_MAX_CELLS, &array, &cnt)) {
+    return 0;
+  }
+  for (i = 0; i < cnt; i++) {
+    napi_get_element(env, array, i, &item);
+    if (!get_buffer(env, item, "witness", UINT32_MAX, &data, &len)) {
+      return 0;
+    }
+    fixture_tx_set_witness(tx, i, data, (uint32_t)len);
+  }
+  return 1;
+}
+
+static int get_string(napi_env env, napi_value options, const char *name, char value[SIM_NODE_PATH_SIZE]) {
+  napi_value field;
+  size_t len;
+  if (
+    !get_property(env, options, name, &field) ||
+    napi_get_value_string_utf8(env, field, value, SIM_NODE_PATH_SIZE, &len) != napi_ok || len + 1 >= SIM_NODE_PATH_SIZE
+  ) {
+    char message[64];
+    snprintf(message, sizeof(message), "vm %s should be a string", name);
+    napi_throw_type_error(env, NULL, message);
+    return 0;
+  }
+  return 1;
+}
+
+static int get_bool(napi_env env, napi_value options, const char *name) {
+  napi_value field;
+  bool value = false;
+  if (get_property(env, options, name, &field)) {
+    napi_get_value_bool(env, field, &value);
+  }
+  return value;
+}
+
+static napi_value new_buffer(napi_env env, const uint8_t *data, size_t len) {
+  napi_value ret;
+  napi_create_buffer_copy(env, len, data, NULL, &ret);
+  return ret;
+}
+
+static napi_value new_script(napi_env env, const fixture_script_t *script) {
+  napi_value ret, hash_type;
+  napi_create_object(env, &ret);
+  napi_create_uint32(env, script->hash_type, &hash_type);
+  napi_set_named_property(env, ret, "codeHash", new_buffer(env, script->code_hash, FIXTURE_HASH_SIZE));
+  napi_set_named_property(env, ret, "hashType", hash_type);
+  napi_set_named_property(env, ret, "args", new_buffer(env, script->args, script->args_len));
+  return ret;
+}
+
+static napi_value new_code(napi_env env, const fixture_script_t *dep_type, const uint8_t code_hash[FIXTURE_HASH_SIZE]) {
+  napi_value ret;
+  napi_create_object(env, &ret);
+  napi_set_named_property(env, ret, "depType", new_script(env, dep_type));
+  napi_set_named_property(env, ret, "codeHash", new_buffer(env, code_hash, FIXTURE_HASH_SIZE));
+  return ret;
+}
+
+/*
+ * (unified) -> { type, lock, liquidity } of { depType, codeHash }, and feeLock
+ * code cell dep of a script has depType as its type script, so codeHash is the type hash of the dep
+ */
+static napi_value context(napi_env env, napi_callback_info info) {
+  size_t argc = 1;
+  napi_value argv[1], ret;
+  bool unified = false;
+  napi_get_cb_info(env, info, &argc, argv, NULL, NULL);
+  if (argc > 0) {
+    napi_get_value_bool(env, argv[0], &unified);
+  }
+  const fixture_context_t *ctx = &contexts[unified ? 1 : 0];
+  napi_create_object(env, &ret);
+  napi_set_named_property(env, ret, "type", new_code(env, &ctx->type_code_dep, ctx->type_code_hash));
+  napi_set_named_property(env, ret, "lock", new_code(env, &ctx->lock_code_dep, ctx->lock_code_hash));
+  napi_set_named_property(env, ret, "liquidity", new_code(env, &ctx->liquidity_code_dep, ctx->liquidity_code_hash));
+  napi_set_named_property(env, ret, "bnLib", new_code(env, &ctx->bn_lib_code_dep, ctx->bn_lib_code_hash));
+  napi_set_named_property(env, ret, "feeLock", new_script(env, &ctx->fee_lock));
+  return ret;
+}
+
+/*
+ * (number) -> hash of header of block number, header of a header dep of that block
+ */
+static napi_value header_hash(napi_env env, napi_callback_info info) {
+  size_t argc = 1;
+  napi_value argv[1];
+  uint64_t number;
+  fixture_tx_t *tx;
+  napi_value ret;
+  napi_get_cb_info(env, info, &argc, argv, NULL, NULL);
+  if (argc != 1 || !get_u64(env, argv[0], "block number", &number)) {
+    return NULL;
+  }
+  tx = calloc(1, sizeof(fixture_tx_t));
+  if (tx == NULL) {
+    napi_throw_error(env, NULL, "out of memory");
+    return NULL;
+  }
+  fixture_tx_init(tx);
+  ret = new_buffer(env, fixture_tx_add_header(tx, number)->hash, FIXTURE_HASH_SIZE);
+  fixture_tx_free(tx);
+  free(tx);
+  return ret;
+}
+
+static napi_value verify_error(napi_env env, int ret, const sim_reject_t *reject) {
+  char code[16], message[128];
+  napi_value error, error_code, error_message, group, value;
+  snprintf(code, sizeof(code), "%d", ret);
+  switch (ret) {
+    case SIM_VERIFY_ERROR_CAPACITY:
+      snprintf(message, sizeof(message), "capacity of outputs is more than capacity of inputs");
+      break;
+    case SIM_VERIFY_ERROR_OCCUPIED:
+      snprintf(message, sizeof(message), "capacity of an output is less than its occupied capacity");
+      break;
+    case SIM_VERIFY_ERROR_CODE_DEP:
+      snprintf(message, sizeof(message), "code cell dep of %s script is missing", fixture_script_name(reject->group.script));
+      break;
+    case SIM_VERIFY_ERROR_SCRIPT:
+      snprintf(message, sizeof(message), "%s script rejected transaction with error %d", fixture_script_name(reject->group.script), reject->code);
+      break;
+    default:
+      snprintf(message, sizeof(message), "ckb-debugger did not give a run result");
+  }
+  napi_create_string_utf8(env, code, NAPI_AUTO_LENGTH, &error_code);
+  napi_create_string_utf8(env, message, NAPI_AUTO_LENGTH, &error_message);
+  napi_create_error(env, error_code, error_message, &error);
+  if (ret == SIM_VERIFY_ERROR_CODE_DEP || ret == SIM_VERIFY_ERROR_SCRIPT) {
+    napi_create_object(env, &group);
+    napi_create_string_utf8(env, fixture_script_name(reject->group.script), NAPI_AUTO_LENGTH, &value);
+    napi_set_named_property(env, group, "script", value);
+    napi_create_string_utf8(env, reject->group.group_type == FIXTURE_GROUP_LOCK ? "lock" : "type", NAPI_AUTO_LENGTH, &value);
+    napi_set_named_property(env, group, "groupType", value);
+    napi_create_string_utf8(env, reject->group.is_output ? "output" : "input", NAPI_AUTO_LENGTH, &value);
+    napi_set_named_property(env, group, "cellType", value);
+    napi_create_uint32(env, (uint32_t)reject->group.index, &value);
+    napi_set_named_property(env, group, "cellIndex", value);
+    napi_set_named_property(env, error, "group", group);
+    napi_create_int32(env, reject->code, &value);
+    napi_set_named_property(env, error, "exitCode", value);
+  }
+  napi_throw(env, error);
+  return NULL;
+}
+
+/*
+ * (tx, { unified, vm: { debugger, txFile } }) -> undefined, throws when tx is rejected
+ */
+static napi_value verify(napi_env env, napi_callback_info info) {
+  size_t argc = 2;
+  napi_value argv[2], vm_options;
+  char debugger[SIM_NODE_PATH_SIZE], tx_file[SIM_NODE_PATH_SIZE];
+  sim_vm_t vm = {debugger, tx_file};
+  sim_reject_t reject;
+  int unified = 0, use_vm = 0, ret;
+  fixture_tx_t *tx;
+
+  napi_get_cb_info(env, info, &argc, argv, NULL, NULL);
+  if (argc < 1) {
+    napi_throw_type_error(env, NULL, "transaction is missing");
+    return NULL;
+  }
+  if (argc > 1) {
+    unified = get_bool(env, argv[1], "unified");
+    use_vm = get_property(env, argv[1], "vm", &vm_options);
+    if (use_vm && (!get_string(env, vm_options, "debugger", debugger) || !get_string(env, vm_options, "txFile", tx_file))) {
+      return NULL;
+    }
+  }
+  tx = calloc(1, sizeof(fixture_tx_t));
+  if (tx == NULL) {
+    napi_throw_error(env, NULL, "out of memory");
+    return NULL;
+  }
+  fixture_tx_init(tx);
+  if (!get_tx(env, argv[0], tx)) {
+    fixture_tx_free(tx);
+    free(tx);
+    return NULL;
+  }
+  ret = sim_verify(&contexts[unified], tx, use_vm ? &vm : NULL, &reject);
+  fixture_tx_free(tx);
+  free(tx);
+  return ret == 0 ? NULL : verify_error(env, ret, &reject);
+}
+
+static napi_value init(napi_env env, napi_value exports) {
+  napi_property_descriptor properties[] = {
+    {"context", NULL, context, NULL, NULL, NULL, napi_enumerable, NULL},
+    {"headerHash", NULL, header_hash, NULL, NULL, NULL, napi_enumerable, NULL},
+    {"verify", NULL, verify, NULL, NULL, NULL, napi_enumerable, NULL},
+  };
+  fixture_context_init(&contexts[0]);
+  fixture_context_init(&contexts[1]);
+  fixture_context_unify(&contexts[1]);
+  napi_define_properties(env, exports, sizeof(properties) / sizeof(properties[0]), properties);
+  return exports;
+}
+
+NAPI_MODULE(NODE_GYP_MODULE_NAME, init)
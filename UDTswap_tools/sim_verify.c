@@ -0,0 +1,172 @@
+#include <stdio.h>
+#include <string.h>
+#include "../UDTswap_scripts/ckb_consts.h"
+#include "native.h"
+#include "sim_verify.h"
+
+#define SIM_VERIFY_SHANNONS 100000000ULL
+#define SIM_VERIFY_COMMAND_SIZE 8192
+
+static const fixture_script_t *group_script(const fixture_tx_t *tx, const fixture_group_t *group) {
+  const fixture_cell_t *cell = group->is_output ? &tx->outputs[group->index] : &tx->inputs[group->index];
+  return group->group_type == FIXTURE_GROUP_LOCK ? &cell->lock : &cell->type;
+}
+
+static int same_script(const fixture_script_t *a, const fixture_script_t *b) {
+  return a->hash_type == b->hash_type && a->args_len == b->args_len &&
+    memcmp(a->code_hash, b->code_hash, FIXTURE_HASH_SIZE) == 0 && memcmp(a->args, b->args, a->args_len) == 0;
+}
+
+static size_t add_group(
+  const fixture_context_t *ctx,
+  const fixture_tx_t *tx,
+  fixture_group_t groups[],
+  size_t cnt,
+  int group_type,
+  int is_output,
+  size_t index
+) {
+  fixture_group_t group = {0, group_type, is_output, index};
+  const fixture_script_t *script = group_script(tx, &group);
+  size_t i;
+  for (i = 0; i < cnt; i++) {
+    if (groups[i].group_type == group_type && same_script(group_script(tx, &groups[i]), script)) {
+      return cnt;
+    }
+  }
+  group.script = fixture_script_of(ctx, script);
+  groups[cnt] = group;
+  return cnt + 1;
+}
+
+size_t sim_verify_groups(const fixture_context_t *ctx, const fixture_tx_t *tx, fixture_group_t groups[SIM_VERIFY_MAX_GROUPS]) {
+  size_t i, cnt = 0;
+  for (i = 0; i < tx->input_cnt; i++) {
+    cnt = add_group(ctx, tx, groups, cnt, FIXTURE_GROUP_LOCK, 0, i);
+  }
+  for (i = 0; i < tx->input_cnt; i++) {
+    if (tx->inputs[i].has_type) {
+      cnt = add_group(ctx, tx, groups, cnt, FIXTURE_GROUP_TYPE, 0, i);
+    }
+  }
+  for (i = 0; i < tx->output_cnt; i++) {
+    if (tx->outputs[i].has_type) {
+      cnt = add_group(ctx, tx, groups, cnt, FIXTURE_GROUP_TYPE, 1, i);
+    }
+  }
+  return cnt;
+}
+//type script of inputs and outputs is one group, first cell of inputs is its index as ckb-debugger
+
+static fixture_u128 occupied(const fixture_cell_t *cell) {
+  fixture_u128 bytes = 8 + FIXTURE_HASH_SIZE + 1 + cell->lock.args_len + cell->data_len;
+  if (cell->has_type) {
+    bytes += FIXTURE_HASH_SIZE + 1 + cell->type.args_len;
+  }
+  return bytes * SIM_VERIFY_SHANNONS;
+}
+//capacity, lock, type and data bytes of a cell, as CKB occupied capacity
+
+static int check_capacity(const fixture_tx_t *tx) {
+  fixture_u128 inputs = 0, outputs = 0;
+  size_t i;
+  for (i = 0; i < tx->input_cnt; i++) {
+    inputs += tx->inputs[i].capacity;
+  }
+  for (i = 0; i < tx->output_cnt; i++) {
+    if (tx->outputs[i].capacity < occupied(&tx->outputs[i])) {
+      return SIM_VERIFY_ERROR_OCCUPIED;
+    }
+    outputs += tx->outputs[i].capacity;
+  }
+  return outputs <= inputs ? 0 : SIM_VERIFY_ERROR_CAPACITY;
+}
+
+static int has_code_dep(const fixture_tx_t *tx, const fixture_script_t *script) {
+  uint8_t hash[FIXTURE_HASH_SIZE];
+  size_t i;
+  for (i = 0; i < tx->dep_cnt; i++) {
+    if (tx->deps[i].has_type) {
+      fixture_script_hash(&tx->deps[i].type, hash);
+      if (memcmp(hash, script->code_hash, FIXTURE_HASH_SIZE) == 0) {
+        return 1;
+      }
+    }
+  }
+  return 0;
+}
+
+/*
+ * run result of ckb-debugger on mock transaction of vm tx file
+ */
+static int run_vm(const sim_vm_t *vm, const fixture_group_t *group, int *code) {
+  char command[SIM_VERIFY_COMMAND_SIZE], line[256];
+  int found = 0;
+  snprintf(
+    command, sizeof(command), "%s --tx-file '%s' --script-group-type %s --cell-type %s --cell-index %zu 2>&1",
+    vm->debugger, vm->tx_file, group->group_type == FIXTURE_GROUP_LOCK ? "lock" : "type",
+    group->is_output ? "output" : "input", group->index
+  );
+  FILE *fp = popen(command, "r");
+  if (fp == NULL) {
+    return SIM_VERIFY_ERROR_VM;
+  }
+  while (fgets(line, sizeof(line), fp) != NULL) {
+    if (!found && sscanf(line, "Run result: %d", code) == 1) {
+      found = 1;
+    }
+  }
+  pclose(fp);
+  return found ? 0 : SIM_VERIFY_ERROR_VM;
+}
+
+static int write_vm_tx(const sim_vm_t *vm, const fixture_tx_t *tx) {
+  FILE *fp = fopen(vm->tx_file, "w");
+  if (fp == NULL) {
+    return SIM_VERIFY_ERROR_VM;
+  }
+  int ret = fixture_write_json(tx, fp);
+  if (fclose(fp) != 0 || ret != 0) {
+    return SIM_VERIFY_ERROR_VM;
+  }
+  return 0;
+}
+
+int sim_verify(const fixture_context_t *ctx, const fixture_tx_t *tx, const sim_vm_t *vm, sim_reject_t *reject) {
+  fixture_group_t groups[SIM_VERIFY_MAX_GROUPS];
+  size_t i, cnt;
+  int ret = check_capacity(tx);
+  if (ret != 0) {
+    return ret;
+  }
+  if (vm != NULL && (ret = write_vm_tx(vm, tx)) != 0) {
+    return ret;
+  }
+
+  cnt = sim_verify_groups(ctx, tx, groups);
+  for (i = 0; i < cnt; i++) {
+    int code = 0;
+    if (groups[i].script < 0) {
+      continue;
+    }
+    reject->group = groups[i];
+    reject->code = 0;
+    if (!has_code_dep(tx, group_script(tx, &groups[i]))) {
+      return SIM_VERIFY_ERROR_CODE_DEP;
+    }
+    if (vm != NULL) {
+      ret = run_vm(vm, &groups[i], &code);
+      if (ret != 0) {
+        return ret;
+      }
+    } else {
+      ret = ckb_mock_init(tx, groups[i].group_type, groups[i].is_output ? CKB_SOURCE_OUTPUT : CKB_SOURCE_INPUT, groups[i].index);
+      code = ret != 0 ? ret : ckb_mock_run(native_context_entry(ctx, groups[i].script));
+    }
+    if (code != 0) {
+      reject->code = code;
+      return SIM_VERIFY_ERROR_SCRIPT;
+    }
+  }
+  return 0;
+}
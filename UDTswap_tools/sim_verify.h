@@ -0,0 +1,43 @@
+#ifndef UDTSWAP_SIM_VERIFY_H_
+#define UDTSWAP_SIM_VERIFY_H_
+
+#include "fixture.h"
+
+#define SIM_VERIFY_MAX_GROUPS (3 * FIXTURE_MAX_CELLS)
+
+#define SIM_VERIFY_ERROR_CAPACITY -1
+#define SIM_VERIFY_ERROR_OCCUPIED -2
+#define SIM_VERIFY_ERROR_CODE_DEP -3
+#define SIM_VERIFY_ERROR_SCRIPT -4
+#define SIM_VERIFY_ERROR_VM -5
+
+/*
+ * ckb-debugger of VM runs, mock transaction json of every verified transaction is written to tx_file
+ * code cell deps of UDTswap scripts have the RISC-V binaries as data
+ */
+typedef struct {
+  const char *debugger;
+  const char *tx_file;
+} sim_vm_t;
+
+/* group of a rejected transaction and exit code of its script */
+typedef struct {
+  fixture_group_t group;
+  int code;
+} sim_reject_t;
+
+/*
+ * script groups of resolved transaction, lock groups of inputs then type groups of inputs and outputs,
+ * index is the first cell of the group, script is -1 for scripts which are not UDTswap scripts of ctx
+ */
+size_t sim_verify_groups(const fixture_context_t *ctx, const fixture_tx_t *tx, fixture_group_t groups[SIM_VERIFY_MAX_GROUPS]);
+
+/*
+ * capacity rules and UDTswap script groups of resolved transaction, natively when vm is NULL
+ * UDTswap scripts need their code cell dep (dep of type script hash of the code hash)
+ * other scripts (secp256k1 lock, test UDT) are not run, signatures are not checked
+ * reject is set for SIM_VERIFY_ERROR_SCRIPT, and group of SIM_VERIFY_ERROR_CODE_DEP
+ */
+int sim_verify(const fixture_context_t *ctx, const fixture_tx_t *tx, const sim_vm_t *vm, sim_reject_t *reject);
+
+#endif /* UDTSWAP_SIM_VERIFY_H_ */
@@ -0,0 +1,286 @@
+#include <stdlib.h>
+#include <string.h>
+#include "../UDTswap_scripts/ckb_consts.h"
+#include "fixture.h"
+#include "trace.h"
+
+#define TRACE_LINE_SIZE 65536
+#define TRACE_FIELD_CNT 13
+
+static const struct {
+  long number;
+  const char *name;
+} syscall_names[] = {
+  {SYS_exit, "exit"},
+  {SYS_ckb_current_cycles, "current_cycles"},
+  {SYS_ckb_load_script, "load_script"},
+  {SYS_ckb_load_tx_hash, "load_tx_hash"},
+  {SYS_ckb_load_script_hash, "load_script_hash"},
+  {SYS_ckb_load_cell, "load_cell"},
+  {SYS_ckb_load_header, "load_header"},
+  {SYS_ckb_load_input, "load_input"},
+  {SYS_ckb_load_witness, "load_witness"},
+  {SYS_ckb_load_cell_by_field, "load_cell_by_field"},
+  {SYS_ckb_load_header_by_field, "load_header_by_field"},
+  {SYS_ckb_load_input_by_field, "load_input_by_field"},
+  {SYS_ckb_load_cell_data_as_code, "load_cell_data_as_code"},
+  {SYS_ckb_load_cell_data, "load_cell_data"},
+  {SYS_ckb_debug, "debug"},
+};
+
+static const struct {
+  long source;
+  const char *name;
+} source_names[] = {
+  {CKB_SOURCE_INPUT, "input"},
+  {CKB_SOURCE_OUTPUT, "output"},
+  {CKB_SOURCE_CELL_DEP, "cell_dep"},
+  {CKB_SOURCE_HEADER_DEP, "header_dep"},
+  {CKB_SOURCE_GROUP_INPUT, "group_input"},
+  {CKB_SOURCE_GROUP_OUTPUT, "group_output"},
+};
+
+const char *trace_syscall_name(long number) {
+  size_t i;
+  for (i = 0; i < sizeof(syscall_names) / sizeof(syscall_names[0]); i++) {
+    if (syscall_names[i].number == number) {
+      return syscall_names[i].name;
+    }
+  }
+  return "unknown";
+}
+
+uint64_t trace_syscall_cycles(uint32_t data_len) {
+  return TRACE_SYSCALL_CYCLES + (data_len + TRACE_BYTES_PER_CYCLE - 1) / TRACE_BYTES_PER_CYCLE;
+}
+
+static void write_long(FILE *fp, long v) {
+  if (v == TRACE_NONE) {
+    fprintf(fp, "\t-");
+  } else {
+    fprintf(fp, "\t%ld", v);
+  }
+}
+
+static void write_source(FILE *fp, long source) {
+  size_t i;
+  for (i = 0; i < sizeof(source_names) / sizeof(source_names[0]); i++) {
+    if (source_names[i].source == source) {
+      fprintf(fp, "\t%s", source_names[i].name);
+      return;
+    }
+  }
+  write_long(fp, source);
+}
+
+int trace_write_header(FILE *fp, const char *script, int group_type, size_t source, size_t index) {
+  fprintf(
+    fp, "# udtswap-trace %s %s %s %zu\n",
+    script,
+    group_type == FIXTURE_GROUP_LOCK ? "lock" : "type",
+    source == CKB_SOURCE_OUTPUT ? "output" : "input",
+    index
+  );
+  return ferror(fp) ? TRACE_ERROR_IO : 0;
+}
+
+int trace_write_record(FILE *fp, const trace_record_t *record) {
+  uint32_t i;
+  fprintf(fp, "%s\t%ld", trace_syscall_name(record->number), record->number);
+  write_long(fp, record->index);
+  write_source(fp, record->source);
+  write_long(fp, record->field);
+  write_long(fp, record->offset);
+  write_long(fp, record->requested_len);
+  write_long(fp, record->returned_len);
+  fprintf(fp, "\t%ld\t%llu\t%llu\t", record->ret, (unsigned long long)record->cycles, (unsigned long long)record->ns);
+  if (record->sites[0] == 0) {
+    fprintf(fp, "-");
+  }
+  for (i = 0; i < TRACE_MAX_SITES && record->sites[i] != 0; i++) {
+    fprintf(fp, i == 0 ? "%lx" : ",%lx", (unsigned long)record->sites[i]);
+  }
+  fprintf(fp, "\t");
+  if (record->data_len == 0) {
+    fprintf(fp, "-");
+  }
+  for (i = 0; i < record->data_len; i++) {
+    fprintf(fp, "%02x", record->data[i]);
+  }
+  fprintf(fp, "\n");
+  return ferror(fp) ? TRACE_ERROR_IO : 0;
+}
+
+static int hex_value(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+
+static int read_long(const char *text, long *out) {
+  char *end;
+  if (strcmp(text, "-") == 0) {
+    *out = TRACE_NONE;
+    return 0;
+  }
+  *out = strtol(text, &end, 10);
+  return *end == '\0' ? 0 : TRACE_ERROR_FORMAT;
+}
+
+static int read_source(const char *text, long *out) {
+  size_t i;
+  for (i = 0; i < sizeof(source_names) / sizeof(source_names[0]); i++) {
+    if (strcmp(source_names[i].name, text) == 0) {
+      *out = source_names[i].source;
+      return 0;
+    }
+  }
+  return read_long(text, out);
+}
+
+static int read_sites(char *text, uintptr_t sites[TRACE_MAX_SITES]) {
+  char *save = NULL, *site;
+  size_t i = 0;
+  memset(sites, 0, sizeof(uintptr_t) * TRACE_MAX_SITES);
+  if (strcmp(text, "-") == 0) {
+    return 0;
+  }
+  for (site = strtok_r(text, ",", &save); site != NULL; site = strtok_r(NULL, ",", &save)) {
+    if (i == TRACE_MAX_SITES) {
+      return TRACE_ERROR_FORMAT;
+    }
+    sites[i++] = (uintptr_t)strtoul(site, NULL, 16);
+  }
+  return 0;
+}
+
+static int read_data(const char *text, trace_record_t *record) {
+  size_t i, len;
+  record->data = NULL;
+  record->data_len = 0;
+  if (strcmp(text, "-") == 0) {
+    return 0;
+  }
+  len = strlen(text);
+  if (len % 2 != 0) {
+    return TRACE_ERROR_FORMAT;
+  }
+  record->data = malloc(len / 2);
+  if (record->data == NULL) {
+    return TRACE_ERROR_IO;
+  }
+  record->data_len = (uint32_t)(len / 2);
+  for (i = 0; i < len / 2; i++) {
+    int hi = hex_value(text[2 * i]), lo = hex_value(text[2 * i + 1]);
+    if (hi < 0 || lo < 0) {
+      return TRACE_ERROR_FORMAT;
+    }
+    record->data[i] = (uint8_t)(hi * 16 + lo);
+  }
+  return 0;
+}
+
+static int read_header(const char *line, trace_t *trace) {
+  char script[TRACE_SCRIPT_NAME_SIZE], group[8], cell[8];
+  if (sscanf(line, "# udtswap-trace %15s %7s %7s %zu", script, group, cell, &trace->index) != 4) {
+    return TRACE_ERROR_FORMAT;
+  }
+  strcpy(trace->script, script);
+  trace->group_type = strcmp(group, "lock") == 0 ? FIXTURE_GROUP_LOCK : FIXTURE_GROUP_TYPE;
+  trace->source = strcmp(cell, "output") == 0 ? CKB_SOURCE_OUTPUT : CKB_SOURCE_INPUT;
+  return 0;
+}
+
+static int read_record(char *line, trace_record_t *record) {
+  char *fields[TRACE_FIELD_CNT];
+  char *save = NULL, *field;
+  unsigned long long cycles, ns;
+  size_t cnt = 0;
+  int ret = 0;
+
+  memset(record, 0, sizeof(trace_record_t));
+  if (strchr(line, '\n') == NULL) {
+    return TRACE_ERROR_FORMAT;
+  }
+  //line longer than TRACE_LINE_SIZE
+  for (field = strtok_r(line, "\t\n", &save); field != NULL; field = strtok_r(NULL, "\t\n", &save)) {
+    if (cnt == TRACE_FIELD_CNT) {
+      return TRACE_ERROR_FORMAT;
+    }
+    fields[cnt++] = field;
+  }
+  if (cnt != TRACE_FIELD_CNT) {
+    return TRACE_ERROR_FORMAT;
+  }
+  ret |= read_long(fields[1], &record->number);
+  ret |= read_long(fields[2], &record->index);
+  ret |= read_source(fields[3], &record->source);
+  ret |= read_long(fields[4], &record->field);
+  ret |= read_long(fields[5], &record->offset);
+  ret |= read_long(fields[6], &record->requested_len);
+  ret |= read_long(fields[7], &record->returned_len);
+  ret |= read_long(fields[8], &record->ret);
+  if (ret != 0 || sscanf(fields[9], "%llu", &cycles) != 1 || sscanf(fields[10], "%llu", &ns) != 1) {
+    return TRACE_ERROR_FORMAT;
+  }
+  record->cycles = cycles;
+  record->ns = ns;
+  ret = read_sites(fields[11], record->sites);
+  if (ret != 0) {
+    return ret;
+  }
+  return read_data(fields[12], record);
+}
+
+int trace_load(const char *path, trace_t *trace) {
+  char *line;
+  int ret = 0;
+  FILE *fp = fopen(path, "r");
+  memset(trace, 0, sizeof(trace_t));
+  if (fp == NULL) {
+    return TRACE_ERROR_IO;
+  }
+  line = malloc(TRACE_LINE_SIZE);
+  if (line == NULL) {
+    fclose(fp);
+    return TRACE_ERROR_IO;
+  }
+  if (fgets(line, TRACE_LINE_SIZE, fp) == NULL || read_header(line, trace) != 0) {
+    ret = TRACE_ERROR_FORMAT;
+  }
+  while (ret == 0 && fgets(line, TRACE_LINE_SIZE, fp) != NULL) {
+    if (line[0] == '#' || line[0] == '\n') {
+      continue;
+    }
+    if (trace->record_cnt == trace->record_cap) {
+      size_t cap = trace->record_cap == 0 ? 64 : trace->record_cap * 2;
+      trace_record_t *records = realloc(trace->records, cap * sizeof(trace_record_t));
+      if (records == NULL) {
+        ret = TRACE_ERROR_IO;
+        break;
+      }
+      trace->records = records;
+      trace->record_cap = cap;
+    }
+    ret = read_record(line, &trace->records[trace->record_cnt]);
+    trace->record_cnt += 1;
+  }
+  free(line);
+  fclose(fp);
+  if (ret != 0) {
+    trace_free(trace);
+  }
+  return ret;
+}
+
+void trace_free(trace_t *trace) {
+  size_t i;
+  for (i = 0; i < trace->record_cnt; i++) {
+    free(trace->records[i].data);
+  }
+  free(trace->records);
+  trace->records = NULL;
+  trace->record_cnt = 0;
+  trace->record_cap = 0;
+}
@@ -0,0 +1,67 @@
+#ifndef UDTSWAP_TRACE_H_
+#define UDTSWAP_TRACE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define TRACE_NONE -1
+#define TRACE_MAX_SITES 3
+#define TRACE_SCRIPT_NAME_SIZE 16
+
+#define TRACE_ERROR_FORMAT -4
+#define TRACE_ERROR_IO -3
+
+/* syscall cost of CKB-VM, ecall instruction and 1 cycle per 4 bytes stored to script memory */
+#define TRACE_SYSCALL_CYCLES 500
+#define TRACE_BYTES_PER_CYCLE 4
+
+/*
+ * one syscall of script
+ * index, source, field, offset and lens are TRACE_NONE when syscall has no such argument
+ * requested_len and returned_len are len before and after syscall, data is bytes stored to script memory
+ * cycles is estimated by syscall cost, ns is measured in native build
+ * sites are call addresses of syscall in executable, offset from load address
+ */
+typedef struct {
+  long number;
+  long index;
+  long source;
+  long field;
+  long offset;
+  long requested_len;
+  long returned_len;
+  long ret;
+  uint64_t cycles;
+  uint64_t ns;
+  uintptr_t sites[TRACE_MAX_SITES];
+  uint8_t *data;
+  uint32_t data_len;
+} trace_record_t;
+
+/*
+ * syscalls of one script group run
+ * text file, header line and one tab separated line per syscall
+ * # udtswap-trace <script> <lock|type> <input|output> <index>
+ * <name> <number> <index> <source> <field> <offset> <requested> <returned> <ret> <cycles> <ns> <sites> <data>
+ */
+typedef struct {
+  char script[TRACE_SCRIPT_NAME_SIZE];
+  int group_type;
+  size_t source;
+  size_t index;
+  trace_record_t *records;
+  size_t record_cnt;
+  size_t record_cap;
+} trace_t;
+
+const char *trace_syscall_name(long number);
+uint64_t trace_syscall_cycles(uint32_t data_len);
+
+int trace_write_header(FILE *fp, const char *script, int group_type, size_t source, size_t index);
+int trace_write_record(FILE *fp, const trace_record_t *record);
+
+int trace_load(const char *path, trace_t *trace);
+void trace_free(trace_t *trace);
+
+#endif /* UDTSWAP_TRACE_H_ */
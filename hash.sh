@@ -1,8 +1,24 @@
 #!/bin/sh
 
-arr=(`cat ./hash.txt`)
+hash_file=${1:-./hash.txt}
+header_file=${2:-./UDTswap_scripts/udtswap_common.h}
 
-echo '#define SCRIPT_SIZE 32768
+arr=(`cat $hash_file`)
+
+# 4th line is type hash of test udt, 5th line is type hash of bn library cell of BN=dynamic build
+bn_lib_hash=0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0
+if [ "$BN" = "dynamic" ]; then
+  if [ -z "${arr[4]}" ] || ! echo "${arr[4]}" | grep -q '[1-9]'; then
+    echo "$hash_file has no bn_lib type hash on 5th line, deploy bn_lib with type id and add it for BN=dynamic" >&2
+    exit 1
+  fi
+  bn_lib_hash=${arr[4]}
+fi
+
+echo '#ifndef UDTSWAP_COMMON_H_
+#define UDTSWAP_COMMON_H_
+
+#define SCRIPT_SIZE 32768
 #define INPUT_SIZE 128
 
 #define ADD_LIQUIDITY_MINIMUM 1000
@@ -25,6 +41,16 @@ echo '#define SCRIPT_SIZE 32768
 #define UDTSWAP_DATA_UDT1_RESERVE_START 0
 #define UDTSWAP_DATA_UDT2_RESERVE_START 16
 #define UDTSWAP_DATA_TOTAL_LIQUIDITY_START 32
+#define UDTSWAP_EXTENDED_DATA_SIZE 120
+#define UDTSWAP_DATA_EXTENSION_SIZE 72
+#define UDTSWAP_DATA_PRICE1_CUMULATIVE_START 48
+#define UDTSWAP_DATA_PRICE2_CUMULATIVE_START 80
+#define UDTSWAP_DATA_LAST_UPDATE_START 112
+#define PRICE_CUMULATIVE_SIZE 32
+#define PRICE_RESOLUTION_WORDS 2
+#define BLOCK_NUMBER_SIZE 8
+#define HEADER_SIZE 208
+#define UDTSWAP_HEADER_DEP_INDEX 0
 #define CODE_HASH_START 16
 #define ARGS_START 53
 #define UDTSWAP_LOCK_ARGS_UDT1_SCRIPT_HASH_START 53
@@ -32,6 +58,14 @@ echo '#define SCRIPT_SIZE 32768
 #define ADD_LIQUIDITY_CELL_INDEX 4
 #define REMOVE_LIQUIDITY_CELL_START_INDEX 3
 #define TX_INPUT_SIZE 44
+#define SWAP_MODE_AUTO 0
+#define SWAP_MODE_EXACT_INPUT 1
+#define SWAP_MODE_EXACT_OUTPUT 2
+#define SWAP_MODE_WITNESS_SIZE 64
+#define UDTSWAP_PAIR_UDT_UDT 0
+#define UDTSWAP_PAIR_CKB_UDT 1
+#define UDTSWAP_PAIR_UDT_CKB 2
+#define UDTSWAP_PAIR_CKB_CKB 3
 
 #define UDTSWAP_NOT_MATCH_ERROR -70
 #define LIQUIDITY_TRANSFER_NOT_CORRECT_ERROR -71
@@ -66,11 +100,17 @@ echo '#define SCRIPT_SIZE 32768
 #define TX_INPUT_NOT_MATCH_ERROR -100
 #define ADD_LIQUIDITY_TOO_LOW_ERROR -101
 #define SAME_UDT_OR_ORDER_ERROR -102
+#define PRICE_CUMULATIVE_NOT_CORRECT_ERROR -103
+#define LAST_UPDATE_NOT_CORRECT_ERROR -104
 #define CANNOT_UNLOCK_ERROR -105
 #define UDTSWAP_LIQUIDITY_UDT_ZERO_AMOUNT_ERROR -106
 #define OVERFLOW_ERROR -107
 #define UDTSWAP_LIQUIDITY_UDT_INPUT_OUTPUT_NOT_MATCH_ERROR -108
 #define UDTSWAP_SYSCALL_ERROR -109
+#define UDTSWAP_ROLE_NOT_MATCH_ERROR -110
+#define BN_LIB_NOT_FOUND_ERROR -111
+#define BN_LIB_FORMAT_ERROR -112
+#define BN_LIB_VERSION_ERROR -113
 
 #define UDTSWAP_LIQUIDITY_UDT_ERROR_IDX 50
 #define UDTSWAP_LOCK_ERROR_IDX 100
@@ -81,17 +121,20 @@ echo '#define SCRIPT_SIZE 32768
 
 typedef unsigned __int128 uint128_t;
 
-const uint8_t udtswap_type_script_code_hash_buf[CODE_HASH_SIZE] = {'${arr[0]}'}; 
-const uint8_t udtswap_lock_code_hash_buf[CODE_HASH_SIZE] = {'${arr[1]}'};
-const uint8_t udtswap_liquidity_udt_code_hash_buf[CODE_HASH_SIZE] = {'${arr[2]}'};
-const uint8_t fee_lock_hash[SCRIPT_HASH_SIZE] = {226, 95, 206, 237, 187, 115, 204, 92, 253, 92, 45, 123, 9, 230, 209, 27, 63, 57, 251, 188, 95, 116, 36, 162, 221, 246, 233, 126, 185, 23, 95, 137};
-const uint8_t udt_type_ckb_script_hash_buf[SCRIPT_HASH_SIZE] = {0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0};
+static const uint8_t udtswap_type_script_code_hash_buf[CODE_HASH_SIZE] = {'${arr[0]}'}; 
+static const uint8_t udtswap_lock_code_hash_buf[CODE_HASH_SIZE] = {'${arr[1]}'};
+static const uint8_t udtswap_liquidity_udt_code_hash_buf[CODE_HASH_SIZE] = {'${arr[2]}'};
+static const uint8_t udtswap_bn_lib_code_hash_buf[SCRIPT_HASH_SIZE] = {'$bn_lib_hash'};
+static const uint8_t fee_lock_hash[SCRIPT_HASH_SIZE] = {226, 95, 206, 237, 187, 115, 204, 92, 253, 92, 45, 123, 9, 230, 209, 27, 63, 57, 251, 188, 95, 116, 36, 162, 221, 246, 233, 126, 185, 23, 95, 137};
+static const uint8_t udt_type_ckb_script_hash_buf[SCRIPT_HASH_SIZE] = {0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0};
 
-uint128_t get_uint128_t(int from, uint8_t arr[]) {
+static inline uint128_t get_uint128_t(int from, uint8_t arr[]) {
   uint128_t ret=0;
   int i=0;
   for (i=0; i<UDT_AMOUNT_SIZE; i++) {
     ret += (uint128_t)arr[from+i] << (8*i);
   }
   return ret;
-}' > ./UDTswap_scripts/udtswap_common.h
+}
+
+#endif /* UDTSWAP_COMMON_H_ */' > $header_file
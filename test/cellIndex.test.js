@@ -0,0 +1,126 @@
+const assert = require('assert');
+
+const cellIndex = require('./tx/cellIndex.js');
+const consts = require('./consts.js');
+
+describe('#cell index test', function() {
+    const hash = (tag, n) => '0x' + tag + n.toString(16).padStart(62, '0');
+    const lock = {
+        hashType: 'type',
+        codeHash: consts.nervosDefaultLockCodeHash,
+        args: '0x' + '11'.repeat(20),
+    };
+    const lockHash = () => consts.ckb.utils.scriptToHash(lock);
+    const outPoint = (txHash, index) => ({ txHash: txHash, index: '0x' + index.toString(16) });
+
+    before(function() {
+        if(consts.ckb === null) {
+            consts.ckb = new consts.CKB(consts.nodeUrl);
+        }
+        //only utils of sdk are used, blocks are given to the index without a node
+    });
+
+    /*
+     * transaction of rpc block, spends out points and creates cells of lock with capacities
+     */
+    const transaction = (txHash, spent, capacities) => ({
+        hash: txHash,
+        inputs: spent.map((previousOutput) => ({ previousOutput: previousOutput, since: '0x0' })),
+        outputs: capacities.map((capacity) => ({ capacity: '0x' + capacity.toString(16), lock: lock })),
+        outputsData: capacities.map(() => '0x'),
+    });
+
+    const block = (tag, number, parentHash, transactions) => ({
+        header: {
+            number: '0x' + number.toString(16),
+            hash: hash(tag, number),
+            parentHash: parentHash,
+        },
+        transactions: transactions,
+    });
+
+    const liveKeys = (index) => cellIndex.liveCells(index, lockHash()).map((cell) => cellIndex.outPointKey(cell.outPoint)).sort();
+    const keys = (outPoints) => outPoints.map(cellIndex.outPointKey).sort();
+
+    /*
+     * block 0 creates 2 cells, block 1 spends first one, creates a cell and spends it in a later transaction
+     */
+    const chain = (tag) => {
+        const tx0 = hash('a0', 0);
+        const tx1 = hash(tag, 0x11);
+        const tx2 = hash(tag, 0x12);
+        const block0 = block('b0', 0, hash('00', 0), [transaction(tx0, [], [100, 200])]);
+        const block1 = block(tag, 1, block0.header.hash, [
+            transaction(tx1, [outPoint(tx0, 0)], [300]),
+            transaction(tx2, [outPoint(tx1, 0)], [400]),
+        ]);
+        return { blocks: [block0, block1], tx0: tx0, tx1: tx1, tx2: tx2 };
+    };
+
+    it('ingest', function() {
+        const index = cellIndex.create(10);
+        const { blocks, tx0, tx2 } = chain('c1');
+        assert.strictEqual(cellIndex.ingestBlock(index, blocks[0]), true);
+        assert.deepStrictEqual(liveKeys(index), keys([outPoint(tx0, 0), outPoint(tx0, 1)]));
+        assert.strictEqual(cellIndex.ingestBlock(index, blocks[1]), true);
+        assert.deepStrictEqual(liveKeys(index), keys([outPoint(tx0, 1), outPoint(tx2, 0)]));
+        assert.strictEqual(index.tipNumber, 1);
+        assert.strictEqual(index.tipHash, blocks[1].header.hash);
+        assert.strictEqual(cellIndex.ingestBlock(index, blocks[1]), false);
+        assert.strictEqual(cellIndex.ingestBlock(index, block('d0', 2, hash('d0', 1), [])), false);
+        assert.strictEqual(index.tipNumber, 1);
+    });
+
+    it('rollback', function() {
+        const index = cellIndex.create(10);
+        const { blocks, tx0, tx1 } = chain('c1');
+        blocks.forEach((b) => cellIndex.ingestBlock(index, b));
+        assert.strictEqual(cellIndex.rollback(index), true);
+        assert.deepStrictEqual(liveKeys(index), keys([outPoint(tx0, 0), outPoint(tx0, 1)]));
+        assert.strictEqual(index.cells.has(cellIndex.outPointKey(outPoint(tx1, 0))), false);
+        assert.strictEqual(index.tipNumber, 0);
+        assert.strictEqual(index.tipHash, blocks[0].header.hash);
+        assert.strictEqual(cellIndex.rollback(index), true);
+        assert.deepStrictEqual(liveKeys(index), []);
+        assert.strictEqual(cellIndex.rollback(index), false);
+    });
+
+    it('sync reorganization', async function() {
+        const index = cellIndex.create(10);
+        const main = chain('c1');
+        const fork = chain('f1');
+        fork.blocks.push(block('f2', 2, fork.blocks[1].header.hash, [transaction(hash('f3', 2), [outPoint(fork.tx0, 1)], [500])]));
+        let blocks = main.blocks;
+        const ckb = {
+            rpc: {
+                getTipBlockNumber: async () => '0x' + (blocks.length - 1).toString(16),
+                getBlockByNumber: async (number) => blocks[Number(BigInt(number))],
+            },
+        };
+        assert.strictEqual(await cellIndex.sync(index, ckb), 1);
+        blocks = fork.blocks;
+        assert.strictEqual(await cellIndex.sync(index, ckb), 2);
+        assert.strictEqual(index.tipHash, fork.blocks[2].header.hash);
+        assert.deepStrictEqual(liveKeys(index), keys([outPoint(fork.tx2, 0), outPoint(hash('f3', 2), 0)]));
+        assert.strictEqual(index.cells.has(cellIndex.outPointKey(outPoint(main.tx2, 0))), false);
+    });
+
+    it('reorganization deeper than max rollback', async function() {
+        const index = cellIndex.create(1);
+        const main = chain('c1');
+        const fork = chain('f1');
+        fork.blocks[0] = block('e0', 0, hash('00', 0), fork.blocks[0].transactions);
+        fork.blocks[1].header.parentHash = fork.blocks[0].header.hash;
+        fork.blocks.push(block('f2', 2, fork.blocks[1].header.hash, []));
+        let blocks = main.blocks;
+        const ckb = {
+            rpc: {
+                getTipBlockNumber: async () => '0x' + (blocks.length - 1).toString(16),
+                getBlockByNumber: async (number) => blocks[Number(BigInt(number))],
+            },
+        };
+        await cellIndex.sync(index, ckb);
+        blocks = fork.blocks;
+        await assert.rejects(cellIndex.sync(index, ckb), /reorganization deeper than 1 blocks/);
+    });
+});
@@ -39,10 +39,16 @@ const consts = {
     ckbMinimum : BigInt(6100000000),
     udtMinimum : BigInt(1),
     feeAmount : BigInt(6100000000),
+    //WitnessArgs with input type 0x01, UDTswap type script checks swap as exact input
+    swapExactInputWitness : "0x150000001000000010000000150000000100000001",
     txFeeMax : BigInt(10000),
     poolCellCKB : BigInt(30000000000),
     ckbLockCellMinimum : BigInt(30000000000),
     nodeUrl: 'http://localhost:8114',
+    //file of local cell index (tx/cellIndex.js), null to search live cells by loadCells
+    indexPath: null,
+    //options of in process chain (tx/simChain.js) to test without a node, e.g. {}, null to test on node of nodeUrl
+    sim: null,
     sk: null,
     fs: require('fs'),
     ckb: null,
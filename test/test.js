@@ -165,8 +165,18 @@ describe('#UDTSwap test', function() {
     before(function() {
         consts.ckb = new consts.CKB(consts.nodeUrl);
 
-        let obj = consts.fs.readFileSync(__dirname + '/../consts.json', 'utf8');
-        obj = JSON.parse(obj);
+        let obj;
+        if(consts.sim !== null) {
+            //scripts are deployed on in process chain, rpc of consts.ckb is served by the chain
+            const simChain = require('./tx/simChain.js');
+            const chain = simChain.create(consts.sim);
+            simChain.attach(consts.ckb, chain);
+            obj = simChain.deploy(chain);
+            secretKey = consts.skTesting;
+        } else {
+            obj = consts.fs.readFileSync(__dirname + '/../consts.json', 'utf8');
+            obj = JSON.parse(obj);
+        }
         consts.UDTSwapTypeCodeHash = consts.ckb.utils.scriptToHash(obj.scripts[0]);
         consts.UDTSwapLockCodeHash = consts.ckb.utils.scriptToHash(obj.scripts[1]);
         consts.UDTSwapLiquidityUDTCodeHash = consts.ckb.utils.scriptToHash(obj.scripts[2]);
@@ -1,8 +1,35 @@
 var consts = require('../consts.js');
 var utils = require('../utils.js');
+var cellIndex = require('./cellIndex.js');
 
 const cellBuilder = {
+  //local cell index of consts.indexPath
+  index: null,
+
+  /**
+   * @dev get live cells of lock script hash
+   *
+   * with consts.indexPath, cells are from local cell index synced to node tip,
+   * index is saved when new blocks are ingested, fromBlock is first block of a new index
+   *
+   * @param fromBlock start block to search for live cells
+   * @param lockHash lock script hash
+   * @return live cells
+   **/
   getLiveCellsOnly: async function(fromBlock, lockHash) {
+    if(consts.indexPath !== null) {
+      if(cellBuilder.index === null) {
+        cellBuilder.index = cellIndex.load(consts.indexPath);
+      }
+      const tipHash = cellBuilder.index.tipHash;
+      await cellIndex.sync(cellBuilder.index, consts.ckb, fromBlock);
+      if(cellBuilder.index.tipHash !== tipHash) {
+        cellIndex.save(cellBuilder.index, consts.indexPath);
+      }
+      return {
+        unspentCells: cellIndex.liveCells(cellBuilder.index, lockHash)
+      };
+    }
     let unspentCells = await consts.ckb.loadCells({
       lockHash,
       start: BigInt(fromBlock),
@@ -136,12 +163,16 @@ const cellBuilder = {
         ret.push(unspentCells[i]);
         //for UDTs
       } else if(temp !== undefined || udtTypeHash === liquidityUDTTypeHash) {
-        const cellInfo = await consts.ckb.rpc.getLiveCell({
-            txHash: unspentCells[i].outPoint.txHash,
-            index: unspentCells[i].outPoint.index
-          }, true);
+        //cells of local cell index have data
+        const data =
+            unspentCells[i].data !== undefined
+                ? unspentCells[i].data
+                : (await consts.ckb.rpc.getLiveCell({
+                    txHash: unspentCells[i].outPoint.txHash,
+                    index: unspentCells[i].outPoint.index
+                  }, true)).cell.data.content;
         const udtCapacity = BigInt(utils.changeEndianness(
-            cellInfo.cell.data.content.substr(0, 34)
+            data.substr(0, 34)
         ));
 
         if (temp !== undefined) {
@@ -957,6 +988,10 @@ const cellBuilder = {
     i = 0;
     while(i<rawTransaction.witnesses.length) {
       rawTransaction.witnesses[i] = '0x10000000100000001000000010000000';
+      //when swapping, UDTswap cell witness hints output amount is calculated from input amount
+      if(txIdx===0 && i<poolCnt*3 && i%3===0) {
+        rawTransaction.witnesses[i] = consts.swapExactInputWitness;
+      }
       if(i===poolCnt*3) {
         rawTransaction.witnesses[i] = signedWitnesses;
       }
@@ -0,0 +1,361 @@
+var consts = require('../consts.js');
+
+const cellIndex = {
+    /**
+     * @dev create empty local cell index
+     *
+     * live cells are kept by out point, lock script hash, type script hash and both,
+     * cells created and spent by recent blocks are kept to roll back reorganized blocks
+     *
+     * @param maxRollback count of recent blocks that can be rolled back
+     * @return cell index
+     **/
+    create: function(maxRollback) {
+        return {
+            tipNumber: -1,
+            tipHash: null,
+            maxRollback: maxRollback === undefined ? 100 : maxRollback,
+            blocks: [],
+            cells: new Map(),
+            byLock: new Map(),
+            byType: new Map(),
+            byLockType: new Map(),
+        };
+    },
+
+    outPointKey: function(outPoint) {
+        return outPoint.txHash + ':' + BigInt(outPoint.index).toString();
+    },
+
+    addKey: function(map, key, cellKey, cell) {
+        let cells = map.get(key);
+        if(cells === undefined) {
+            cells = new Map();
+            map.set(key, cells);
+        }
+        cells.set(cellKey, cell);
+    },
+
+    removeKey: function(map, key, cellKey) {
+        const cells = map.get(key);
+        if(cells !== undefined) {
+            cells.delete(cellKey);
+            if(cells.size === 0) {
+                map.delete(key);
+            }
+        }
+    },
+
+    addCell: function(index, cell) {
+        const key = cellIndex.outPointKey(cell.outPoint);
+        index.cells.set(key, cell);
+        cellIndex.addKey(index.byLock, cell.lockHash, key, cell);
+        if(cell.typeHash !== null) {
+            cellIndex.addKey(index.byType, cell.typeHash, key, cell);
+            cellIndex.addKey(index.byLockType, cell.lockHash + cell.typeHash.substr(2), key, cell);
+        }
+    },
+
+    removeCell: function(index, key) {
+        const cell = index.cells.get(key);
+        if(cell === undefined) {
+            return null;
+        }
+        index.cells.delete(key);
+        cellIndex.removeKey(index.byLock, cell.lockHash, key);
+        if(cell.typeHash !== null) {
+            cellIndex.removeKey(index.byType, cell.typeHash, key);
+            cellIndex.removeKey(index.byLockType, cell.lockHash + cell.typeHash.substr(2), key);
+        }
+        return cell;
+    },
+
+    /**
+     * @dev apply block to index, block is result of rpc getBlockByNumber
+     *
+     * inputs spend live cells, outputs are new live cells,
+     * inputs of cells not in index (cellbase, cells before first block of index) are skipped,
+     * cells spent in the block that created them are not restored by rollback
+     *
+     * @param index cell index
+     * @param block block of sdk rpc
+     * @return false when block is not child of tip, index is not changed
+     **/
+    ingestBlock: function(index, block) {
+        const number = Number(BigInt(block.header.number));
+        if(index.tipHash !== null && (block.header.parentHash !== index.tipHash || number !== index.tipNumber + 1)) {
+            return false;
+        }
+        const undo = {
+            number: number,
+            hash: block.header.hash,
+            parentHash: block.header.parentHash,
+            created: [],
+            spent: [],
+        };
+        block.transactions.forEach((transaction) => {
+            transaction.inputs.forEach((input) => {
+                const key = cellIndex.outPointKey(input.previousOutput);
+                const cell = cellIndex.removeCell(index, key);
+                if(cell !== null && cell.blockHash !== block.header.hash) {
+                    undo.spent.push(cell);
+                }
+                //cell created and spent by this block is not live after rollback
+            });
+            transaction.outputs.forEach((output, i) => {
+                const outPoint = {
+                    txHash: transaction.hash,
+                    index: '0x' + i.toString(16),
+                };
+                const cell = {
+                    blockHash: block.header.hash,
+                    blockNumber: number,
+                    outPoint: outPoint,
+                    capacity: output.capacity,
+                    lock: output.lock,
+                    type: output.type === undefined ? null : output.type,
+                    outputDataLen: '0x' + ((transaction.outputsData[i].length - 2) / 2).toString(16),
+                    data: transaction.outputsData[i],
+                    lockHash: consts.ckb.utils.scriptToHash(output.lock),
+                    typeHash: output.type ? consts.ckb.utils.scriptToHash(output.type) : null,
+                };
+                cellIndex.addCell(index, cell);
+                undo.created.push(cellIndex.outPointKey(outPoint));
+            });
+        });
+        index.blocks.push(undo);
+        if(index.blocks.length > index.maxRollback) {
+            index.blocks.shift();
+        }
+        index.tipNumber = number;
+        index.tipHash = block.header.hash;
+        return true;
+    },
+
+    /**
+     * @dev roll back tip block, cells created by it are removed and cells spent by it are live again
+     *
+     * @param index cell index
+     * @return false when no recent block is left to roll back
+     **/
+    rollback: function(index) {
+        const undo = index.blocks.pop();
+        if(undo === undefined) {
+            return false;
+        }
+        undo.created.forEach((key) => cellIndex.removeCell(index, key));
+        undo.spent.forEach((cell) => cellIndex.addCell(index, cell));
+        index.tipNumber = undo.number - 1;
+        index.tipHash = undo.parentHash;
+        return true;
+    },
+
+    /**
+     * @dev ingest blocks of node from tip of index to tip of node
+     *
+     * block whose parent is not tip of index is a reorganization,
+     * tip is rolled back until the parent is found in node
+     *
+     * @param index cell index
+     * @param ckb sdk of node, consts.ckb by default
+     * @param fromBlock first block of empty index
+     * @return tip block number of index
+     **/
+    sync: async function(index, ckb, fromBlock) {
+        ckb = ckb || consts.ckb;
+        const tip = Number(BigInt(await ckb.rpc.getTipBlockNumber()));
+        let number = index.tipHash === null ? Number(fromBlock || 0) : index.tipNumber + 1;
+        while(number <= tip) {
+            const block = await ckb.rpc.getBlockByNumber('0x' + number.toString(16));
+            if(cellIndex.ingestBlock(index, block)) {
+                number += 1;
+                continue;
+            }
+            if(!cellIndex.rollback(index)) {
+                throw new Error(`reorganization deeper than ${index.maxRollback} blocks at block ${number}`);
+            }
+            number = index.tipNumber + 1;
+        }
+        return index.tipNumber;
+    },
+
+    /**
+     * @dev ingest blocks of fixture file, json array of blocks or a block of each line, as rpc getBlockByNumber
+     *
+     * blocks of same number as index blocks are reorganizations, index is rolled back to their parent
+     *
+     * @param index cell index
+     * @param path fixture file
+     * @return tip block number of index
+     **/
+    loadFixture: function(index, path) {
+        const text = consts.fs.readFileSync(path, 'utf8').trim();
+        const blocks =
+            text.startsWith('[')
+                ? JSON.parse(text)
+                : text.split('\n').filter((line) => line.trim() !== '').map((line) => JSON.parse(line));
+        blocks.forEach((block) => {
+            const number = Number(BigInt(block.header.number));
+            while(index.tipHash !== null && number <= index.tipNumber) {
+                if(!cellIndex.rollback(index)) {
+                    throw new Error(`reorganization deeper than ${index.maxRollback} blocks at block ${number}`);
+                }
+            }
+            if(!cellIndex.ingestBlock(index, block)) {
+                throw new Error(`block ${number} is not child of index tip ${index.tipNumber}`);
+            }
+        });
+        return index.tipNumber;
+    },
+
+    /**
+     * @dev write index to file, written to temporary file and renamed, so file is always a whole index
+     *
+     * @param index cell index
+     * @param path index file
+     **/
+    save: function(index, path) {
+        const json = JSON.stringify({
+            version: 1,
+            tipNumber: index.tipNumber,
+            tipHash: index.tipHash,
+            maxRollback: index.maxRollback,
+            blocks: index.blocks,
+            cells: Array.from(index.cells.values()),
+        });
+        consts.fs.writeFileSync(path + '.tmp', json);
+        consts.fs.renameSync(path + '.tmp', path);
+    },
+
+    /**
+     * @dev read index written by save, empty index when file does not exist
+     *
+     * @param path index file
+     * @param maxRollback count of recent blocks that can be rolled back, for empty index
+     * @return cell index
+     **/
+    load: function(path, maxRollback) {
+        if(!consts.fs.existsSync(path)) {
+            return cellIndex.create(maxRollback);
+        }
+        const obj = JSON.parse(consts.fs.readFileSync(path, 'utf8'));
+        if(obj.version !== 1) {
+            throw new Error(`cell index version ${obj.version} of ${path} is not supported`);
+        }
+        const index = cellIndex.create(obj.maxRollback);
+        index.tipNumber = obj.tipNumber;
+        index.tipHash = obj.tipHash;
+        index.blocks = obj.blocks;
+        obj.cells.forEach((cell) => cellIndex.addCell(index, cell));
+        return index;
+    },
+
+    /**
+     * @dev live cells of lock script hash, of type script hash too when it is given
+     *
+     * cells have fields of sdk loadCells and data, lockHash, typeHash, blockNumber
+     *
+     * @param index cell index
+     * @param lockHash lock script hash
+     * @param typeHash type script hash, null for any type
+     * @return array of live cells
+     **/
+    liveCells: function(index, lockHash, typeHash) {
+        const cells =
+            typeHash === undefined || typeHash === null
+                ? index.byLock.get(lockHash)
+                : index.byLockType.get(lockHash + typeHash.substr(2));
+        return cells === undefined ? [] : Array.from(cells.values());
+    },
+
+    /**
+     * @dev live cells of type script hash
+     *
+     * @param index cell index
+     * @param typeHash type script hash
+     * @return array of live cells
+     **/
+    liveCellsByType: function(index, typeHash) {
+        const cells = index.byType.get(typeHash);
+        return cells === undefined ? [] : Array.from(cells.values());
+    },
+
+    /**
+     * @dev live UDTswap pools of a pair, every pool (shard) of the pair
+     *
+     * pool cell has UDTswap lock of the pair and UDTswap type script,
+     * pools are in the form of pool info of test.js
+     *
+     * @param index cell index
+     * @param udt1TypeHash first UDT type script hash
+     * @param udt2TypeHash second UDT type script hash
+     * @return array of pool info
+     **/
+    pools: function(index, udt1TypeHash, udt2TypeHash) {
+        const lockHash = consts.ckb.utils.scriptToHash({
+            hashType: 'type',
+            codeHash: consts.UDTSwapLockCodeHash,
+            args: udt1TypeHash + udt2TypeHash.substr(2),
+        });
+        const udt1Default = BigInt(udt1TypeHash) === 0n ? consts.ckbLockCellMinimum : consts.udtMinimum;
+        const udt2Default = BigInt(udt2TypeHash) === 0n ? consts.ckbLockCellMinimum : consts.udtMinimum;
+        const u128 = (data, start) => BigInt('0x' + Buffer.from(data.substr(2 + start * 2, 32), 'hex').reverse().toString('hex'));
+        return cellIndex.liveCells(index, lockHash).filter((cell) =>
+            cell.type !== null
+            && cell.type.codeHash === consts.UDTSwapTypeCodeHash
+            && cell.data.length >= 2 + 48 * 2
+        ).map((cell) => {
+            const udt1Reserve = u128(cell.data, 0);
+            const udt2Reserve = u128(cell.data, 16);
+            return {
+                liveTxHash: cell.outPoint.txHash,
+                liveTxIndex: Number(BigInt(cell.outPoint.index)),
+                totalLiquidity: u128(cell.data, 32),
+                poolIdentifier: cell.type.args,
+                udt1ActualReserve: udt1Reserve - udt1Default,
+                udt1Reserve: udt1Reserve,
+                udt1TypeHash: udt1TypeHash,
+                udt2ActualReserve: udt2Reserve - udt2Default,
+                udt2Reserve: udt2Reserve,
+                udt2TypeHash: udt2TypeHash,
+            };
+        });
+    },
+
+    /**
+     * @dev publish every live UDTswap pool of index as pool snapshot file of quote library
+     *
+     * snapshot has tip of index, quote and route services map it or load it by quote.loadSnapshot,
+     * file is replaced by rename, so readers see a whole snapshot
+     *
+     * @param index cell index
+     * @param path snapshot file
+     * @return count of pools
+     **/
+    writeSnapshot: function(index, path) {
+        //only snapshots need the quote addon of `make quote`, the index works without it
+        const quote = require('../../UDTswap_tools/quote/udtswap_quote.js');
+        const hex = (str) => Buffer.from(str.substr(2), 'hex');
+        const pools = [];
+        index.cells.forEach((cell) => {
+            if(
+                cell.lock.codeHash === consts.UDTSwapLockCodeHash
+                && cell.type !== null
+                && cell.type.codeHash === consts.UDTSwapTypeCodeHash
+                && cell.data.length >= 2 + 48 * 2
+            ) {
+                pools.push({
+                    lockArgs: hex(cell.lock.args),
+                    typeHash: hex(cell.typeHash),
+                    txHash: hex(cell.outPoint.txHash),
+                    index: Number(BigInt(cell.outPoint.index)),
+                    data: hex(cell.data),
+                });
+            }
+        });
+        quote.writeSnapshot(path, BigInt(index.tipNumber), hex(index.tipHash), pools);
+        return pools.length;
+    },
+};
+
+module.exports = cellIndex;
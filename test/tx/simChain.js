@@ -0,0 +1,443 @@
+var consts = require('../consts.js');
+var cellIndex = require('./cellIndex.js');
+const path = require('path');
+
+const addonPath = path.join(__dirname, '..', '..', 'UDTswap_tools', 'build', 'native', 'udtswap_sim.node');
+const zeroHash = '0x' + '00'.repeat(32);
+const hashTypes = { data: 0, type: 1, data1: 2 };
+
+let addon = null;
+
+function loadAddon() {
+    if(addon === null) {
+        try {
+            addon = require(addonPath);
+        } catch (e) {
+            throw new Error(`UDTswap sim addon is not built, run \`make sim\` in UDTswap_tools (${e.message})`);
+        }
+    }
+    return addon;
+}
+
+function hex(buffer) {
+    return '0x' + buffer.toString('hex');
+}
+
+function bytes(str) {
+    return Buffer.from(str.substr(2), 'hex');
+}
+
+function toHex(n) {
+    return '0x' + BigInt(n).toString(16);
+}
+
+function u128Data(amount) {
+    const data = Buffer.alloc(16);
+    data.writeBigUInt64LE(BigInt(amount) & BigInt('0xffffffffffffffff'), 0);
+    data.writeBigUInt64LE(BigInt(amount) >> BigInt(64), 8);
+    return hex(data);
+}
+
+function chainError(code, message) {
+    const error = new Error(message);
+    error.code = code;
+    return error;
+}
+
+/**
+ * @dev script of addon from script of sdk, hex strings to buffers
+ **/
+function addonScript(script) {
+    return {
+        codeHash: bytes(script.codeHash),
+        hashType: hashTypes[script.hashType],
+        args: bytes(script.args || '0x'),
+    };
+}
+
+function sdkScript(script) {
+    return {
+        codeHash: hex(script.codeHash),
+        hashType: 'type',
+        args: hex(script.args),
+    };
+}
+
+function addonCell(cell, headerDeps) {
+    const result = {
+        txHash: bytes(cell.outPoint.txHash),
+        index: Number(BigInt(cell.outPoint.index)),
+        since: BigInt(cell.since || '0x0'),
+        capacity: BigInt(cell.capacity),
+        lock: addonScript(cell.lock),
+        type: cell.type ? addonScript(cell.type) : null,
+        data: bytes(cell.data),
+    };
+    const header = headerDeps && cell.blockHash ? headerDeps.indexOf(cell.blockHash) : -1;
+    if(header >= 0) {
+        result.header = header;
+    }
+    //scripts load header of a committed cell when its block is a header dep
+    return result;
+}
+
+const simChain = {
+    /**
+     * @dev create in process chain, UTXO set is a cell index (tx/cellIndex.js) of committed blocks
+     *
+     * transactions are verified by UDTswap scripts of host native build (`make sim` in UDTswap_tools),
+     * or by ckb-debugger with options.vm, and committed in a block at once with autoCommit
+     * only capacity and UDTswap scripts are verified, other locks and types (secp256k1, test UDT) are not run
+     *
+     * @param options { unified, vm: { debugger, txFile }, binDir, autoCommit }
+     *        unified: scripts of UDTswap_unified_udt_based
+     *        vm: ckb-debugger and mock transaction file of each verification, code cells have binaries of binDir
+     *        autoCommit: commit every accepted transaction in its own block, true by default
+     * @return chain
+     **/
+    create: function(options) {
+        options = options || {};
+        const chain = {
+            sim: loadAddon(),
+            unified: !!options.unified,
+            vm: options.vm || null,
+            binDir: options.binDir || path.join(__dirname, '..', '..', 'UDTswap_scripts'),
+            autoCommit: options.autoCommit === undefined ? true : options.autoCommit,
+            index: cellIndex.create(0),
+            blocks: [],
+            headers: new Map(),
+            transactions: new Map(),
+            pool: [],
+            pending: new Map(),
+            spent: new Set(),
+            mintCount: 0,
+            secp256k1Dep: null,
+        };
+        simChain.commit(chain);
+        return chain;
+    },
+
+    /**
+     * @dev live cell of out point, cells of pending transactions too
+     **/
+    liveCell: function(chain, outPoint) {
+        const key = cellIndex.outPointKey(outPoint);
+        if(chain.spent.has(key)) {
+            return null;
+        }
+        const cell = chain.pending.get(key);
+        return cell !== undefined ? cell : chain.index.cells.get(key) || null;
+    },
+
+    /**
+     * @dev cells of cell deps, out points of dep group data (OutPointVec) are cells of a dep group
+     **/
+    resolveDeps: function(chain, transaction) {
+        const deps = [];
+        transaction.cellDeps.forEach((cellDep) => {
+            const cell = simChain.liveCell(chain, cellDep.outPoint);
+            if(cell === null) {
+                throw chainError('Unknown', `cell dep ${cellIndex.outPointKey(cellDep.outPoint)} is not live`);
+            }
+            if(cellDep.depType !== 'depGroup') {
+                deps.push(cell);
+                return;
+            }
+            const data = bytes(cell.data);
+            const count = data.length >= 4 ? data.readUInt32LE(0) : 0;
+            if(data.length !== 4 + count * 36) {
+                throw chainError('InvalidDepGroup', `dep group ${cellIndex.outPointKey(cellDep.outPoint)} is not an OutPointVec`);
+            }
+            for(let i = 0; i < count; i++) {
+                const outPoint = {
+                    txHash: hex(data.slice(4 + i * 36, 4 + i * 36 + 32)),
+                    index: toHex(data.readUInt32LE(4 + i * 36 + 32)),
+                };
+                const member = simChain.liveCell(chain, outPoint);
+                if(member === null) {
+                    throw chainError('Unknown', `cell ${cellIndex.outPointKey(outPoint)} of dep group is not live`);
+                }
+                deps.push(member);
+            }
+        });
+        return deps;
+    },
+
+    /**
+     * @dev add transaction to pending pool, cells of its outputs are live for next transactions of the pool
+     **/
+    accept: function(chain, transaction, hash) {
+        transaction = Object.assign({}, transaction, { hash: hash });
+        transaction.inputs.forEach((input) => {
+            if(BigInt(input.previousOutput.index) !== BigInt(0xffffffff)) {
+                const key = cellIndex.outPointKey(input.previousOutput);
+                chain.pending.delete(key);
+                chain.spent.add(key);
+            }
+        });
+        transaction.outputs.forEach((output, i) => {
+            const outPoint = { txHash: hash, index: toHex(i) };
+            chain.pending.set(cellIndex.outPointKey(outPoint), {
+                outPoint: outPoint,
+                capacity: output.capacity,
+                lock: output.lock,
+                type: output.type ? output.type : null,
+                data: transaction.outputsData[i],
+            });
+        });
+        chain.pool.push(transaction);
+        chain.transactions.set(hash, { transaction: transaction, blockHash: null });
+        if(chain.autoCommit) {
+            simChain.commit(chain);
+        }
+        return hash;
+    },
+
+    /**
+     * @dev verify and accept transaction of sdk, as rpc sendTransaction
+     *
+     * inputs and cell deps are resolved from live cells, header deps from committed blocks,
+     * rejected transaction throws error of sim addon, code of sim_verify.h, group and exitCode of script
+     *
+     * @param chain chain
+     * @param transaction signed transaction of sdk
+     * @return transaction hash
+     **/
+    sendTransaction: function(chain, transaction) {
+        const hash = consts.ckb.utils.rawTransactionToHash(transaction);
+        if(chain.transactions.has(hash)) {
+            throw chainError('Duplicated', `transaction ${hash} is already sent`);
+        }
+        const inputs = transaction.inputs.map((input) => {
+            const cell = simChain.liveCell(chain, input.previousOutput);
+            if(cell === null) {
+                throw chainError('Unknown', `input ${cellIndex.outPointKey(input.previousOutput)} is not live`);
+            }
+            return Object.assign({}, cell, { since: input.since });
+        });
+        const headers = transaction.headerDeps.map((headerHash) => {
+            const number = chain.headers.get(headerHash);
+            if(number === undefined) {
+                throw chainError('Unknown', `header dep ${headerHash} is not a committed block`);
+            }
+            return BigInt(number);
+        });
+        const outputs = transaction.outputs.map((output, i) => ({
+            outPoint: { txHash: hash, index: toHex(i) },
+            capacity: output.capacity,
+            lock: output.lock,
+            type: output.type,
+            data: transaction.outputsData[i],
+        }));
+
+        const options = { unified: chain.unified };
+        if(chain.vm !== null) {
+            options.vm = chain.vm;
+        }
+        chain.sim.verify({
+            inputs: inputs.map((cell) => addonCell(cell, transaction.headerDeps)),
+            outputs: outputs.map((cell) => addonCell(cell)),
+            deps: simChain.resolveDeps(chain, transaction).map((cell) => addonCell(cell, transaction.headerDeps)),
+            headers: headers,
+            witnesses: transaction.witnesses.map((witness) => bytes(typeof witness === 'string' ? witness : '0x')),
+        }, options);
+        return simChain.accept(chain, transaction, hash);
+    },
+
+    /**
+     * @dev transaction of new cells without inputs, as a cellbase, it is not verified
+     *
+     * @param chain chain
+     * @param outputs outputs of sdk
+     * @param outputsData data of outputs
+     * @return transaction hash, cells are outputs of the hash
+     **/
+    mint: function(chain, outputs, outputsData) {
+        const transaction = {
+            version: '0x0',
+            cellDeps: [],
+            headerDeps: [],
+            inputs: [{
+                previousOutput: { txHash: zeroHash, index: '0xffffffff' },
+                since: toHex(chain.mintCount),
+            }],
+            outputs: outputs,
+            outputsData: outputsData || outputs.map(() => '0x'),
+            witnesses: [],
+        };
+        chain.mintCount += 1;
+        //since of the input makes every mint transaction a different hash
+        return simChain.accept(chain, transaction, consts.ckb.utils.rawTransactionToHash(transaction));
+    },
+
+    /**
+     * @dev commit pending transactions in next block, block of rpc getBlockByNumber is ingested to cell index
+     *
+     * block hash is header hash of sim addon, so header deps of the block are the headers scripts load
+     *
+     * @param chain chain
+     * @return block
+     **/
+    commit: function(chain) {
+        const number = chain.blocks.length;
+        const hash = hex(chain.sim.headerHash(BigInt(number)));
+        const block = {
+            header: {
+                version: '0x0',
+                number: toHex(number),
+                parentHash: number === 0 ? zeroHash : chain.blocks[number - 1].header.hash,
+                timestamp: toHex(number * 8000),
+                hash: hash,
+            },
+            transactions: chain.pool,
+            uncles: [],
+            proposals: [],
+        };
+        if(!cellIndex.ingestBlock(chain.index, block)) {
+            throw new Error(`block ${number} is not child of chain tip`);
+        }
+        block.transactions.forEach((transaction) => {
+            chain.transactions.get(transaction.hash).blockHash = hash;
+        });
+        chain.blocks.push(block);
+        chain.headers.set(hash, number);
+        chain.pool = [];
+        chain.pending.clear();
+        chain.spent.clear();
+        return block;
+    },
+
+    dataHash: function(data) {
+        const hash = consts.ckb.utils.blake2b(32, null, null, consts.ckb.utils.PERSONAL);
+        hash.update(bytes(data));
+        return `0x${hash.digest('hex')}`;
+    },
+
+    /**
+     * @dev serve rpc and cell loading of sdk by chain, consts.ckb is not connected to a node
+     *
+     * @param ckb sdk, consts.ckb by default
+     * @param chain chain
+     **/
+    attach: function(ckb, chain) {
+        ckb = ckb || consts.ckb;
+        ckb.rpc.sendTransaction = async (transaction) => simChain.sendTransaction(chain, transaction);
+        ckb.rpc.getTipBlockNumber = async () => toHex(chain.blocks.length - 1);
+        ckb.rpc.getBlockByNumber = async (number) => chain.blocks[Number(BigInt(number))] || null;
+        ckb.rpc.getLiveCell = async (outPoint, withData) => {
+            const cell = chain.index.cells.get(cellIndex.outPointKey(outPoint));
+            if(cell === undefined) {
+                return { cell: null, status: 'unknown' };
+            }
+            return {
+                cell: {
+                    output: { capacity: cell.capacity, lock: cell.lock, type: cell.type },
+                    data: withData ? { content: cell.data, hash: simChain.dataHash(cell.data) } : null,
+                },
+                status: 'live',
+            };
+        };
+        ckb.rpc.getTransaction = async (hash) => {
+            const entry = chain.transactions.get(hash);
+            if(entry === undefined) {
+                return null;
+            }
+            return {
+                transaction: entry.transaction,
+                txStatus: {
+                    blockHash: entry.blockHash,
+                    status: entry.blockHash === null ? 'pending' : 'committed',
+                },
+            };
+        };
+        ckb.loadCells = async (params) => cellIndex.liveCells(chain.index, params.lockHash);
+        ckb.loadSecp256k1Dep = async () => chain.secp256k1Dep;
+        ckb.config.secp256k1Dep = chain.secp256k1Dep;
+    },
+
+    /**
+     * @dev deploy UDTswap code cells, test UDT, secp256k1 dep group and fund testing account, as deploy/exec.js
+     *
+     * keys of consts.js which are null are set to fixed keys, code cells are at index 0 of their transactions,
+     * code cell of a UDTswap script has the type script its code hash is the type hash of (sim addon context)
+     * testing account has CKB cells and UDT cells of both test UDTs
+     *
+     * @param chain chain
+     * @return object of consts.json, { scripts, deps }
+     **/
+    deploy: function(chain) {
+        const ctx = chain.sim.context(chain.unified);
+        const ckbUtils = consts.ckb.utils;
+        ['sk', 'UDT1Owner', 'UDT2Owner', 'skTesting'].forEach((name, i) => {
+            if(consts[name] === null) {
+                consts[name] = '0x' + (i + 1).toString(16).padStart(2, '0').repeat(32);
+            }
+        });
+        const lockOf = (sk) => ({
+            hashType: 'type',
+            codeHash: consts.nervosDefaultLockCodeHash,
+            args: `0x${ckbUtils.blake160(ckbUtils.privateKeyToPublicKey(sk), 'hex')}`,
+        });
+        const deployLock = lockOf(consts.sk);
+        const codeData = (name) => {
+            const file = path.join(chain.binDir, name);
+            return chain.vm !== null && consts.fs.existsSync(file) ? hex(consts.fs.readFileSync(file)) : '0x';
+        };
+        const deployCode = (type, data) => simChain.mint(chain, [{
+            capacity: toHex((BigInt((data.length - 2) / 2) + BigInt(200)) * BigInt(100000000)),
+            lock: deployLock,
+            type: type,
+        }], [data]);
+
+        const names = chain.unified
+            ? ['UDTswap_unified_udt_based']
+            : ['UDTswap_udt_based', 'UDTswap_lock_udt_based', 'UDTswap_liquidity_UDT_udt_based'];
+        const scripts = [sdkScript(ctx.type.depType), sdkScript(ctx.lock.depType), sdkScript(ctx.liquidity.depType)];
+        const deps = names.map((name, i) => deployCode(scripts[i], codeData(name)));
+        while(deps.length < 3) {
+            deps.push(deps[0]);
+        }
+        //unified script is one code cell of all 3 code hashes
+
+        const testUDTType = Object.assign({}, consts.testUDTType, {
+            args: consts.testUDTType.args || ckbUtils.scriptToHash(deployLock),
+        });
+        scripts.push(testUDTType);
+        deps.push(deployCode(testUDTType, '0x'));
+
+        const secp256k1Code = simChain.mint(chain, [{ capacity: toHex(BigInt(200) * BigInt(100000000)), lock: deployLock }]);
+        const depGroupData = Buffer.alloc(4 + 36);
+        depGroupData.writeUInt32LE(1, 0);
+        bytes(secp256k1Code).copy(depGroupData, 4);
+        const depGroup = simChain.mint(chain, [{ capacity: toHex(BigInt(200) * BigInt(100000000)), lock: deployLock }], [hex(depGroupData)]);
+        chain.secp256k1Dep = {
+            hashType: 'type',
+            codeHash: consts.nervosDefaultLockCodeHash,
+            outPoint: { txHash: depGroup, index: '0x0' },
+        };
+        //secp256k1 lock is not run, dep group resolves to a cell as the genesis dep group
+
+        const testingLock = lockOf(consts.skTesting);
+        const udtCodeHash = ckbUtils.scriptToHash(testUDTType);
+        const outputs = [];
+        const outputsData = [];
+        for(let i = 0; i < 20; i++) {
+            outputs.push({ capacity: toHex(BigInt(1000000) * BigInt(100000000)), lock: testingLock });
+            outputsData.push('0x');
+        }
+        [consts.UDT1Owner, consts.UDT2Owner].forEach((owner) => {
+            const type = { hashType: 'type', codeHash: udtCodeHash, args: ckbUtils.scriptToHash(lockOf(owner)) };
+            for(let i = 0; i < 5; i++) {
+                outputs.push({ capacity: toHex(BigInt(200) * BigInt(100000000)), lock: testingLock, type: type });
+                outputsData.push(u128Data(BigInt(10) ** BigInt(24)));
+            }
+        });
+        simChain.mint(chain, outputs, outputsData);
+        if(!chain.autoCommit) {
+            simChain.commit(chain);
+        }
+        return { scripts: scripts, deps: deps };
+    },
+};
+
+module.exports = simChain;
@@ -376,6 +376,40 @@ const txBuilder = {
             inputSerialized: inputSerialized
         };
     },
+
+    /**
+     * @dev build and send one swapping transaction of shard pools of one pair,
+     * every pool of the order is a pool cell input, pool cell output and result cell
+     *
+     * @param sk secret key of testing account
+     * @param legs result of utils.shardSwap
+     * @param inputUDT input UDT data
+     * @param outputUDT output UDT data
+     * @param isRev first UDT is used as input or not in swapping
+     * @param toAddr address to send if receiver is not testing account
+     * @return transaction hash of UDTswap, serialized first input
+     **/
+    sendShardSwap: async function(
+        sk,
+        legs,
+        inputUDT,
+        outputUDT,
+        isRev,
+        toAddr
+    ) {
+        return await txBuilder.sendTransaction(
+            0,
+            sk,
+            legs.map((leg) => leg.inputAmount),
+            legs.map((leg) => leg.outputAmount),
+            legs.map(() => BigInt(0)),
+            legs.map(() => inputUDT),
+            legs.map(() => outputUDT),
+            legs.map((leg) => leg.pool),
+            legs.map(() => isRev),
+            toAddr
+        );
+    },
 }
 
 module.exports = txBuilder;
@@ -1,4 +1,21 @@
 var consts = require('./consts.js');
+const quotePath = '../UDTswap_tools/quote/udtswap_quote.js';
+
+/**
+ * @dev quote addon of UDTswap_tools, loaded on first quote
+ * null when `make quote` was not run, quotes are computed by BigInt formulas then
+ **/
+let quoteAddon;
+const quote = function () {
+  if(quoteAddon === undefined) {
+    try {
+      quoteAddon = require(quotePath);
+    } catch (e) {
+      quoteAddon = null;
+    }
+  }
+  return quoteAddon;
+};
 
 const utils = {
   writeConsts: function (idx, data) {
@@ -103,6 +120,9 @@ const utils = {
    * @return output amount to receive
    **/
   calculateSwapOutputFromInput(inputReserve, outputReserve, inputAmount) {
+    if(quote() !== null) {
+      return quote().exactInput(inputReserve, outputReserve, inputAmount);
+    }
     const inputAmountWithFee = inputAmount * BigInt(997);
     const numerator = inputAmountWithFee * outputReserve;
     const denominator = inputReserve * BigInt(1000) + inputAmountWithFee;
@@ -118,12 +138,16 @@ const utils = {
    * @return second UDT amount to add, liquidity token amount user will receive
    **/
   calculateAddLiquidityUDT2Amount(pool, udt1Amount) {
-    let udt1Reserve = pool.udt1ActualReserve;
-    let udt2Reserve = pool.udt2ActualReserve;
-    const totalLiquidity = pool.totalLiquidity;
-
-    const udt2Amount = udt2Reserve * udt1Amount / udt1Reserve + BigInt(1);
-    const userLiquidity = totalLiquidity * udt1Amount / udt1Reserve;
+    if(quote() !== null) {
+      return quote().addLiquidity(
+          pool.udt1ActualReserve,
+          pool.udt2ActualReserve,
+          pool.totalLiquidity,
+          udt1Amount
+      );
+    }
+    const udt2Amount = pool.udt2ActualReserve * udt1Amount / pool.udt1ActualReserve + BigInt(1);
+    const userLiquidity = pool.totalLiquidity * udt1Amount / pool.udt1ActualReserve;
     return {
       udt2Amount,
       userLiquidity
@@ -139,17 +163,72 @@ const utils = {
    * @return first, second UDT amount to receive
    **/
   calculateRemoveLiquidityAmount(pool, userLiquidity) {
-    const udt1Reserve = pool.udt1ActualReserve;
-    const udt2Reserve = pool.udt2ActualReserve;
-    const totalLiquidity = pool.totalLiquidity;
-
-    const udt1Amount = userLiquidity * udt1Reserve / totalLiquidity;
-    const udt2Amount = userLiquidity * udt2Reserve / totalLiquidity;
+    if(quote() !== null) {
+      return quote().removeLiquidity(
+          pool.udt1ActualReserve,
+          pool.udt2ActualReserve,
+          pool.totalLiquidity,
+          userLiquidity
+      );
+    }
+    const udt1Amount = userLiquidity * pool.udt1ActualReserve / pool.totalLiquidity;
+    const udt2Amount = userLiquidity * pool.udt2ActualReserve / pool.totalLiquidity;
     return {
       udt1Amount,
       udt2Amount
     }
   },
+
+  /**
+   * @dev pool cell data of UDTswap pair's pool info for the route graph
+   *
+   * @param pool UDTswap pair's pool info
+   * @return buffer of reserves and total liquidity
+   **/
+  poolData(pool) {
+    const data = Buffer.alloc(48);
+    [pool.udt1Reserve, pool.udt2Reserve, pool.totalLiquidity].forEach((value, i) => {
+      data.writeBigUInt64LE(BigInt.asUintN(64, value), i * 16);
+      data.writeBigUInt64LE(BigInt.asUintN(64, value >> 64n), i * 16 + 8);
+    });
+    return data;
+  },
+
+  /**
+   * @dev route of an order over shard pools of one pair,
+   * large orders are split across pools, small orders take one pool chosen by key
+   *
+   * @param pools UDTswap pools info of same pair
+   * @param inputAmount input amount
+   * @param rev input UDT is second UDT or not
+   * @param key lock hash of user, same key takes same pool
+   * @param options maxSplit, toleranceBps of quote.shardRoute
+   * @return array of pool info, input amount and output amount of each pool
+   **/
+  shardSwap(pools, inputAmount, rev, key, options) {
+    //route graph has no BigInt fallback, throws when the addon is not built
+    const quote = require(quotePath);
+    const hex = (str) => Buffer.from(str.substr(2), 'hex');
+    const graph = quote.createGraph();
+    pools.forEach((pool) => quote.addPool(
+        graph,
+        hex(pool.udt1TypeHash + pool.udt2TypeHash.substr(2)),
+        utils.poolData(pool)
+    ));
+    const route = quote.shardRoute(
+        graph,
+        hex(rev ? pools[0].udt2TypeHash : pools[0].udt1TypeHash),
+        hex(rev ? pools[0].udt1TypeHash : pools[0].udt2TypeHash),
+        inputAmount,
+        hex(key),
+        options
+    );
+    return route.hops[0].map((leg) => ({
+      pool: pools[leg.pool],
+      inputAmount: leg.inputAmount,
+      outputAmount: leg.outputAmount
+    }));
+  },
 };
 
 module.exports = utils;